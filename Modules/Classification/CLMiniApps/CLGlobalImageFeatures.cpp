@@ -23,9 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIOUtil.h>
 #include "mitkCommandLineParser.h"
 
-#include <mitkGIFCooccurenceMatrix.h>
-#include <mitkGIFGrayLevelRunLength.h>
-#include <mitkGIFFirstOrderStatistics.h>
+#include <mitkGIFMultiLabelFeatures.h>
 
 typedef itk::Image< double, 3 >                 FloatImageType;
 typedef itk::Image< unsigned char, 3 >          MaskImageType;
@@ -57,6 +55,7 @@ int main(int argc, char* argv[])
   parser.addArgument("run-length","rl",mitkCommandLineParser::String, "Use Co-occurence matrix", "calculates Co-occurence based features",us::Any());
   parser.addArgument("first-order","fo",mitkCommandLineParser::String, "Use First Order Features", "calculates First order based features",us::Any());
   parser.addArgument("header","head",mitkCommandLineParser::String,"Add Header (Labels) to output","",us::Any());
+  parser.addArgument("multi-label","ml",mitkCommandLineParser::String,"Use all labels of the mask","Writes one line per label (non zero value) of the mask, starting with the label. Otherwise only the voxels with value 1 are used.",us::Any());
 
   // Miniapp Infos
   parser.setCategory("Classification Tools");
@@ -79,67 +78,55 @@ int main(int argc, char* argv[])
   mitk::Image::Pointer image = mitk::IOUtil::LoadImage(parsedArgs["image"].ToString());
   mitk::Image::Pointer mask = mitk::IOUtil::LoadImage(parsedArgs["mask"].ToString());
 
-  mitk::AbstractGlobalImageFeature::FeatureListType stats;
   ////////////////////////////////////////////////////////////////
-  // CAlculate First Order Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("first-order"))
-  {
-    mitk::GIFFirstOrderStatistics firstOrderCalculator;
-    auto localResults = firstOrderCalculator.CalculateFeatures(image, mask);
-    stats.insert(stats.end(), localResults.begin(), localResults.end());
-  }
-
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Co-occurence Features
+  // Calculate all requested features in one run
   ////////////////////////////////////////////////////////////////
+  mitk::GIFMultiLabelFeatures::Pointer calculator = mitk::GIFMultiLabelFeatures::New();
+  calculator->SetFirstOrder(parsedArgs.count("first-order") > 0);
   if (parsedArgs.count("cooccurence"))
-  {
-    auto ranges = splitDouble(parsedArgs["cooccurence"].ToString(),';');
+    calculator->SetCooccurenceRanges(splitDouble(parsedArgs["cooccurence"].ToString(),';'));
+  if (parsedArgs.count("run-length"))
+    calculator->SetRunLengthRanges(splitDouble(parsedArgs["run-length"].ToString(),';'));
 
-    for (int i = 0; i < ranges.size(); ++i)
-    {
-      mitk::GIFCooccurenceMatrix coocCalculator;
-      coocCalculator.SetRange(ranges[i]);
-      auto localResults = coocCalculator.CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
-    }
-  }
+  bool multiLabel = parsedArgs.count("multi-label");
+  mitk::GIFMultiLabelFeatures::FeatureTableType table;
+  if (multiLabel)
+    table = calculator->CalculateFeatureTable(image, mask);
+  else
+    table[1] = calculator->CalculateFeatures(image, mask);
 
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Run-Length Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("run-length"))
+  for (auto row = table.begin(); row != table.end(); ++row)
   {
-    auto ranges = splitDouble(parsedArgs["run-length"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
+    auto & stats = row->second;
+    for (int i = 0; i < stats.size(); ++i)
     {
-      mitk::GIFGrayLevelRunLength calculator;
-      calculator.SetRange(ranges[i]);
-      auto localResults = calculator.CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
+      std::cout << stats[i].first << " - " << stats[i].second <<std::endl;
     }
   }
-  for (int i = 0; i < stats.size(); ++i)
-  {
-    std::cout << stats[i].first << " - " << stats[i].second <<std::endl;
-  }
 
   std::ofstream output(parsedArgs["output"].ToString(),std::ios::app);
   if ( parsedArgs.count("header") )
   {
-    for (int i = 0; i < stats.size(); ++i)
+    auto names = calculator->GetFeatureNames();
+    if (multiLabel)
+      output << "Label;";
+    for (int i = 0; i < names.size(); ++i)
     {
-      output << stats[i].first << ";";
+      output << names[i] << ";";
     }
     output << std::endl;
   }
-  for (int i = 0; i < stats.size(); ++i)
+  for (auto row = table.begin(); row != table.end(); ++row)
   {
-    output << stats[i].second << ";";
+    auto & stats = row->second;
+    if (multiLabel)
+      output << row->first << ";";
+    for (int i = 0; i < stats.size(); ++i)
+    {
+      output << stats[i].second << ";";
+    }
+    output << std::endl;
   }
-  output << std::endl;
   output.close();
 
   return 0;
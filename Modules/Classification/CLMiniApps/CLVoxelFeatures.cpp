@@ -19,21 +19,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "time.h"
 #include <sstream>
 #include <fstream>
+#include <cmath>
 
 #include <mitkIOUtil.h>
 #include <mitkImageAccessByItk.h>
 #include <mitkImageCast.h>
 #include "mitkCommandLineParser.h"
 
-#include <mitkGIFCooccurenceMatrix.h>
-#include <mitkGIFGrayLevelRunLength.h>
-
-#include "itkDiscreteGaussianImageFilter.h"
-#include <itkLaplacianRecursiveGaussianImageFilter.h>
-#include "itkHessianRecursiveGaussianImageFilter.h"
-#include "itkUnaryFunctorImageFilter.h"
-#include "vnl/algo/vnl_symmetric_eigensystem.h"
-#include <itkSubtractImageFilter.h>
+#include <itkMultiScaleVoxelFeatureImageFilter.h>
+#include <itkVectorIndexSelectionCastImageFilter.h>
 
 static vector<double> splitDouble(string str, char delimiter) {
   vector<double> internal;
@@ -49,119 +43,13 @@ static vector<double> splitDouble(string str, char delimiter) {
   return internal;
 }
 
-namespace Functor
-{
-  template <class TInput, class TOutput>
-  class MatrixFirstEigenvalue
-  {
-  public:
-    MatrixFirstEigenvalue() {}
-    virtual ~MatrixFirstEigenvalue() {}
-
-    int order;
-
-    inline TOutput operator ()(const TInput& input)
-    {
-      double a,b,c;
-      if (input[0] < 0.01 && input[1] < 0.01 &&input[2] < 0.01 &&input[3] < 0.01 &&input[4] < 0.01 &&input[5] < 0.01)
-        return 0;
-      vnl_symmetric_eigensystem_compute_eigenvals(input[0], input[1],input[2],input[3],input[4],input[5],a,b,c);
-      switch (order)
-      {
-      case 0: return a;
-      case 1: return b;
-      case 2: return c;
-      default: return a;
-      }
-    }
-    bool operator !=(const MatrixFirstEigenvalue) const
-    {
-      return false;
-    }
-    bool operator ==(const MatrixFirstEigenvalue& other) const
-    {
-      return !(*this != other);
-    }
-  };
-}
-
-template<typename TPixel, unsigned int VImageDimension>
-void
-  GaussianFilter(itk::Image<TPixel, VImageDimension>* itkImage, double variance, mitk::Image::Pointer &output)
-{
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType >  GaussFilterType;
-
-  typename GaussFilterType::Pointer gaussianFilter = GaussFilterType::New();
-  gaussianFilter->SetInput( itkImage );
-  gaussianFilter->SetVariance(variance);
-  gaussianFilter->Update();
-  mitk::CastToMitkImage(gaussianFilter->GetOutput(), output);
-}
-
-template<typename TPixel, unsigned int VImageDimension>
-void
-  DifferenceOfGaussFilter(itk::Image<TPixel, VImageDimension>* itkImage, double variance, mitk::Image::Pointer &output)
-{
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType >  GaussFilterType;
-  typedef itk::SubtractImageFilter<ImageType, ImageType, ImageType> SubFilterType;
-
-  typename GaussFilterType::Pointer gaussianFilter1 = GaussFilterType::New();
-  gaussianFilter1->SetInput( itkImage );
-  gaussianFilter1->SetVariance(variance);
-  gaussianFilter1->Update();
-  typename GaussFilterType::Pointer gaussianFilter2 = GaussFilterType::New();
-  gaussianFilter2->SetInput( itkImage );
-  gaussianFilter2->SetVariance(variance*0.66*0.66);
-  gaussianFilter2->Update();
-  typename SubFilterType::Pointer subFilter = SubFilterType::New();
-  subFilter->SetInput1(gaussianFilter1->GetOutput());
-  subFilter->SetInput2(gaussianFilter2->GetOutput());
-  subFilter->Update();
-  mitk::CastToMitkImage(subFilter->GetOutput(), output);
-}
-
-template<typename TPixel, unsigned int VImageDimension>
-void
-  LaplacianOfGaussianFilter(itk::Image<TPixel, VImageDimension>* itkImage, double variance, mitk::Image::Pointer &output)
-{
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType >  GaussFilterType;
-  typedef itk::LaplacianRecursiveGaussianImageFilter<ImageType, ImageType>    LaplacianFilter;
-
-  typename GaussFilterType::Pointer gaussianFilter = GaussFilterType::New();
-  gaussianFilter->SetInput( itkImage );
-  gaussianFilter->SetVariance(variance);
-  gaussianFilter->Update();
-  typename LaplacianFilter::Pointer laplaceFilter = LaplacianFilter::New();
-  laplaceFilter->SetInput(gaussianFilter->GetOutput());
-  laplaceFilter->Update();
-  mitk::CastToMitkImage(laplaceFilter->GetOutput(), output);
-}
-
-template<typename TPixel, unsigned int VImageDimension>
-void
-  HessianOfGaussianFilter(itk::Image<TPixel, VImageDimension>* itkImage, double variance, std::vector<mitk::Image::Pointer> &out)
+// The command line takes variances, the filter standard deviations
+static vector<double> toSigmas(const vector<double>& variances)
 {
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typedef itk::Image<double, VImageDimension> FloatImageType;
-  typedef itk::HessianRecursiveGaussianImageFilter <ImageType> HessianFilterType;
-  typedef typename HessianFilterType::OutputImageType VectorImageType;
-  typedef Functor::MatrixFirstEigenvalue<typename VectorImageType::PixelType, double> DeterminantFunctorType;
-  typedef itk::UnaryFunctorImageFilter<VectorImageType, FloatImageType, DeterminantFunctorType> DetFilterType;
-
-  typename HessianFilterType::Pointer hessianFilter = HessianFilterType::New();
-  hessianFilter->SetInput(itkImage);
-  hessianFilter->SetSigma(std::sqrt(variance));
-  for (int i = 0; i < VImageDimension; ++i)
-  {
-    typename DetFilterType::Pointer detFilter = DetFilterType::New();
-    detFilter->SetInput(hessianFilter->GetOutput());
-    detFilter->GetFunctor().order = i;
-    detFilter->Update();
-    mitk::CastToMitkImage(detFilter->GetOutput(), out[i]);
-  }
+  vector<double> sigmas;
+  for (double variance : variances)
+    sigmas.push_back(std::sqrt(variance));
+  return sigmas;
 }
 
 int main(int argc, char* argv[])
@@ -176,6 +64,7 @@ int main(int argc, char* argv[])
   parser.addArgument("difference-of-gaussian","dog",mitkCommandLineParser::String, "Difference of Gaussian Filtering of the input images", "Difference of Gaussian Filter. Followed by the used variances seperated by ';' ",us::Any());
   parser.addArgument("laplace-of-gauss","log",mitkCommandLineParser::String, "Laplacian of Gaussian Filtering", "Laplacian of Gaussian Filter. Followed by the used variances seperated by ';' ",us::Any());
   parser.addArgument("hessian-of-gauss","hog",mitkCommandLineParser::String, "Hessian of Gaussian Filtering", "Hessian of Gaussian Filter. Followed by the used variances seperated by ';' ",us::Any());
+  parser.addArgument("structure-tensor","st",mitkCommandLineParser::String, "Structure Tensor", "Eigenvalues of the structure tensor. Followed by the used variances seperated by ';' ",us::Any());
   // Miniapp Infos
   parser.setCategory("Classification Tools");
   parser.setTitle("Global Image Feature calculator");
@@ -198,81 +87,59 @@ int main(int argc, char* argv[])
   std::string filename=parsedArgs["output"].ToString();
 
   ////////////////////////////////////////////////////////////////
-  // CAlculate Gaussian Features
-  ////////////////////////////////////////////////////////////////
-  MITK_INFO << "Check for Gaussian...";
-  if (parsedArgs.count("gaussian"))
-  {
-    MITK_INFO << "Calculate Gaussian... " << parsedArgs["gaussian"].ToString();
-    auto ranges = splitDouble(parsedArgs["gaussian"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
-    {
-      mitk::Image::Pointer output;
-      AccessByItk_2(image, GaussianFilter, ranges[i], output);
-      std::string name = filename + "-gaussian-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(output, name);
-    }
-  }
-
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Difference of Gaussian Features
+  // Collect the requested features, they are computed in one pass
   ////////////////////////////////////////////////////////////////
-  MITK_INFO << "Check for DoG...";
-  if (parsedArgs.count("difference-of-gaussian"))
+  typedef itk::Image<float, 3> FloatImageType;
+  typedef itk::MultiScaleVoxelFeatureImageFilter<FloatImageType> FeatureFilterType;
+  FeatureFilterType::Pointer featureFilter = FeatureFilterType::New();
+
+  // option, file name prefix per component, variances
+  const std::string options[5] = { "gaussian", "difference-of-gaussian", "laplace-of-gauss", "hessian-of-gauss", "structure-tensor" };
+  const std::vector<std::string> prefixes[5] = { { "-gaussian-" }, { "-dog-" }, { "-log-" }, { "-hog0-", "-hog1-", "-hog2-" }, { "-st0-", "-st1-", "-st2-" } };
+  std::vector<double> variances[5];
+  for (int i = 0; i < 5; ++i)
   {
-    MITK_INFO << "Calculate Difference of Gaussian... " << parsedArgs["difference-of-gaussian"].ToString();
-    auto ranges = splitDouble(parsedArgs["difference-of-gaussian"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
+    if (parsedArgs.count(options[i]))
     {
-      mitk::Image::Pointer output;
-      AccessByItk_2(image, DifferenceOfGaussFilter, ranges[i], output);
-      std::string name = filename + "-dog-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(output, name);
+      MITK_INFO << "Calculate " << options[i] << "... " << parsedArgs[options[i]].ToString();
+      variances[i] = splitDouble(parsedArgs[options[i]].ToString(),';');
     }
   }
+  featureFilter->SetGaussianSigmas(toSigmas(variances[0]));
+  featureFilter->SetDifferenceOfGaussianSigmas(toSigmas(variances[1]));
+  featureFilter->SetLaplacianOfGaussianSigmas(toSigmas(variances[2]));
+  featureFilter->SetHessianSigmas(toSigmas(variances[3]));
+  featureFilter->SetStructureTensorSigmas(toSigmas(variances[4]));
 
-  MITK_INFO << "Check for LoG...";
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Laplacian Of Gauss Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("laplace-of-gauss"))
-  {
-    MITK_INFO << "Calculate LoG... " << parsedArgs["laplace-of-gauss"].ToString();
-    auto ranges = splitDouble(parsedArgs["laplace-of-gauss"].ToString(),';');
+  if (featureFilter->GetNumberOfFeatures() == 0)
+    return 0;
 
-    for (int i = 0; i < ranges.size(); ++i)
-    {
-      mitk::Image::Pointer output;
-      AccessByItk_2(image, LaplacianOfGaussianFilter, ranges[i], output);
-      std::string name = filename + "-log-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(output, name);
-    }
-  }
+  FloatImageType::Pointer itkImage;
+  mitk::CastToItkImage(image, itkImage);
+  featureFilter->SetInput(itkImage);
+  featureFilter->Update();
 
-  MITK_INFO << "Check for HoG...";
   ////////////////////////////////////////////////////////////////
-  // CAlculate Hessian Of Gauss Features
+  // Save every component, in the order of the filter
   ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("hessian-of-gauss"))
+  typedef itk::VectorIndexSelectionCastImageFilter<FeatureFilterType::OutputImageType, FloatImageType> SelectionFilterType;
+  unsigned int component = 0;
+  for (int i = 0; i < 5; ++i)
   {
-    MITK_INFO << "Calculate HoG... " << parsedArgs["hessian-of-gauss"].ToString();
-    auto ranges = splitDouble(parsedArgs["hessian-of-gauss"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
+    for (std::size_t j = 0; j < variances[i].size(); ++j)
     {
-      std::vector<mitk::Image::Pointer> outs;
-      outs.push_back(mitk::Image::New());
-      outs.push_back(mitk::Image::New());
-      outs.push_back(mitk::Image::New());
-      AccessByItk_2(image, HessianOfGaussianFilter, ranges[i], outs);
-      std::string name = filename + "-hog0-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(outs[0], name);
-      name = filename + "-hog1-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(outs[1], name);
-      name = filename + "-hog2-" + us::any_value_to_string(ranges[i])+".nrrd";
-      mitk::IOUtil::SaveImage(outs[2], name);
+      for (const std::string& prefix : prefixes[i])
+      {
+        SelectionFilterType::Pointer selectionFilter = SelectionFilterType::New();
+        selectionFilter->SetInput(featureFilter->GetOutput());
+        selectionFilter->SetIndex(component++);
+        selectionFilter->Update();
+
+        mitk::Image::Pointer output;
+        mitk::CastToMitkImage(selectionFilter->GetOutput(), output);
+        std::string name = filename + prefix + us::any_value_to_string(variances[i][j])+".nrrd";
+        mitk::IOUtil::SaveImage(output, name);
+      }
     }
   }
 
@@ -145,14 +145,13 @@ int main(int argc, char* argv[])
     mitk::CLUtil::DilateGrayscale(csf_prob,3,mitk::CLUtil::Axial,csf_prob);
     mitk::CLUtil::FillHoleGrayscale(csf_prob,csf_prob);
 
-    uint count = 0;
-    mitk::CLUtil::CountVoxel(brain_mask,count);
+    // classify slab by slab, the features are read directly from the images
+    std::vector<mitk::Image::Pointer> features;
+    features.push_back(raw_image);
+    features.push_back(csf_prob);
 
-    Eigen::MatrixXd feature_matrix(count,n_features);
-    feature_matrix.block(0, 0, count, 1) = mitk::CLUtil::Transform<double>(raw_image,brain_mask);
-    feature_matrix.block(0, 1, count, 1) = mitk::CLUtil::Transform<double>(csf_prob,brain_mask);
-
-    mitk::Image::Pointer result_mask = mitk::CLUtil::Transform<int>(classifier->Predict(feature_matrix),brain_mask);
+    mitk::Image::Pointer result_mask, result_probabilities;
+    classifier->PredictSlabs(brain_mask, [&features](unsigned int, unsigned int) { return features; }, result_mask, result_probabilities);
 
     std::string name = itksys::SystemTools::GetFilenameWithoutExtension(entry.toStdString());
     mitk::IOUtil::Save(result_mask,outputdir + name + ".nrrd");
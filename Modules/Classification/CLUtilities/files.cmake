@@ -6,10 +6,12 @@ set(CPP_FILES
 
   Features/itkNeighborhoodFunctorImageFilter.cpp
   Features/itkLineHistogramBasedMassImageFilter.cpp
+  Features/itkMultiScaleVoxelFeatureImageFilter.cpp
 
   GlobalImageFeatures/mitkGIFCooccurenceMatrix.cpp
   GlobalImageFeatures/mitkGIFGrayLevelRunLength.cpp
   GlobalImageFeatures/mitkGIFFirstOrderStatistics.cpp
+  GlobalImageFeatures/mitkGIFMultiLabelFeatures.cpp
   mitkCLUtil.cpp
 
 )
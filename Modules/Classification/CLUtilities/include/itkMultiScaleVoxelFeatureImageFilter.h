@@ -0,0 +1,150 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef itkMultiScaleVoxelFeatureImageFilter_h
+#define itkMultiScaleVoxelFeatureImageFilter_h
+
+#include <itkImageToImageFilter.h>
+#include <itkVectorImage.h>
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/**
+* \brief Computes a bank of multi-scale voxel features of a 3D image: Gaussian, difference of Gaussian (DoG),
+* Laplacian of Gaussian (LoG), Hessian eigenvalues and structure tensor eigenvalues.
+*
+* All features share one Gaussian scale space. The scales are visited in ascending order and each one is derived
+* from the previous one by smoothing with the difference of the variances, so the input is smoothed only once per
+* scale and not once per feature. At each scale the derivatives, the Laplacian and the (closed form) eigenvalues
+* are computed in a single pass over the voxels.
+*
+* The volume is processed in tiles of SlicesPerTile slices plus a halo, so the temporary memory is bounded by
+* the tile size. ComputeFeatureBlock() returns the features of some slices only, as a row-major block
+* (GetNumberOfFeatures() values per voxel) that can be handed to a classifier; GenerateData() writes the same
+* layout into a vector image with one float component per feature.
+*
+* The scales are standard deviations in physical units. The features are ordered by type (in the order above)
+* and then by the scales as they were set, see GetFeatureNames(). Eigenvalues are in ascending order.
+*/
+template< class TInputImage >
+class MultiScaleVoxelFeatureImageFilter : public ImageToImageFilter< TInputImage, VectorImage<float, 3> >
+{
+public:
+  typedef MultiScaleVoxelFeatureImageFilter                       Self;
+  typedef VectorImage<float, 3>                                    OutputImageType;
+  typedef ImageToImageFilter< TInputImage, OutputImageType >       Superclass;
+  typedef SmartPointer< Self >                                     Pointer;
+  typedef SmartPointer< const Self >                               ConstPointer;
+
+  typedef TInputImage                                              InputImageType;
+  typedef std::vector<double>                                      SigmaListType;
+
+  itkNewMacro(Self);
+
+  itkTypeMacro(MultiScaleVoxelFeatureImageFilter, ImageToImageFilter);
+
+  /** Scales of the features. An empty list (default) disables the feature. */
+  void SetGaussianSigmas(const SigmaListType & sigmas) { m_GaussianSigmas = sigmas; this->Modified(); }
+  void SetDifferenceOfGaussianSigmas(const SigmaListType & sigmas) { m_DifferenceOfGaussianSigmas = sigmas; this->Modified(); }
+  void SetLaplacianOfGaussianSigmas(const SigmaListType & sigmas) { m_LaplacianOfGaussianSigmas = sigmas; this->Modified(); }
+  void SetHessianSigmas(const SigmaListType & sigmas) { m_HessianSigmas = sigmas; this->Modified(); }
+  void SetStructureTensorSigmas(const SigmaListType & sigmas) { m_StructureTensorSigmas = sigmas; this->Modified(); }
+
+  /** DoG(sigma) = G(sigma) - G(ratio * sigma), 0 < ratio < 1. Default 0.66. */
+  itkSetMacro(DifferenceOfGaussianRatio, double)
+  itkGetConstMacro(DifferenceOfGaussianRatio, double)
+
+  /** The structure tensor is smoothed with factor * sigma after the gradient was computed at sigma. Default 2. */
+  itkSetMacro(StructureTensorOuterScaleFactor, double)
+  itkGetConstMacro(StructureTensorOuterScaleFactor, double)
+
+  /** Number of slices that are computed at once. Default 16. */
+  itkSetMacro(SlicesPerTile, unsigned int)
+  itkGetConstMacro(SlicesPerTile, unsigned int)
+
+  unsigned int GetNumberOfFeatures() const;
+
+  std::vector<std::string> GetFeatureNames() const;
+
+  /** Number of slices read on each side of a tile. Requires the input to be set. */
+  unsigned int GetHaloSize() const;
+
+  /**
+  * \brief Features of the slices [firstSlice, firstSlice + numberOfSlices) of the input.
+  * The input has to be up to date. block has one row of GetNumberOfFeatures() values per voxel afterwards.
+  */
+  void ComputeFeatureBlock(unsigned int firstSlice, unsigned int numberOfSlices, std::vector<float> & block);
+
+protected:
+
+  MultiScaleVoxelFeatureImageFilter();
+  ~MultiScaleVoxelFeatureImageFilter() {}
+
+  virtual void GenerateOutputInformation() override;
+
+  virtual void GenerateInputRequestedRegion() override;
+
+  virtual void GenerateData() override;
+
+private:
+  MultiScaleVoxelFeatureImageFilter(const Self &); // purposely not implemented
+  void operator=(const Self &); // purposely not implemented
+
+  enum FeatureKind
+  {
+    Gaussian, DifferenceOfGaussianUpper, DifferenceOfGaussianLower, LaplacianOfGaussian, Hessian, StructureTensor
+  };
+
+  /** Feature written into column (columns for eigenvalues) when the scale space reaches sigma */
+  struct FeatureTask
+  {
+    double Sigma;
+    FeatureKind Kind;
+    unsigned int Column;
+  };
+
+  std::vector<FeatureTask> GetFeatureTasks() const;
+
+  /** Number of slices needed on each side of a tile, so that the tiling does not change the result */
+  unsigned int GetHaloSize(const std::vector<FeatureTask> & tasks) const;
+
+  /** Computes the features of the slices into features (row-major, relative to firstSlice) */
+  void ComputeTile(unsigned int firstSlice, unsigned int numberOfSlices, float * features);
+
+  static void SmoothAlongAxis(float * data, const unsigned int dimensions[3], unsigned int axis, double sigmaInVoxels);
+
+  SigmaListType m_GaussianSigmas;
+  SigmaListType m_DifferenceOfGaussianSigmas;
+  SigmaListType m_LaplacianOfGaussianSigmas;
+  SigmaListType m_HessianSigmas;
+  SigmaListType m_StructureTensorSigmas;
+
+  double m_DifferenceOfGaussianRatio;
+  double m_StructureTensorOuterScaleFactor;
+  unsigned int m_SlicesPerTile;
+};
+
+}
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "../src/Features/itkMultiScaleVoxelFeatureImageFilter.cpp"
+#endif
+
+#endif // itkMultiScaleVoxelFeatureImageFilter_h
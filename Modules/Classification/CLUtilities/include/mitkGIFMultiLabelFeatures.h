@@ -0,0 +1,95 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkGIFMultiLabelFeatures_h
+#define mitkGIFMultiLabelFeatures_h
+
+#include <mitkAbstractGlobalImageFeature.h>
+#include <mitkBaseData.h>
+#include <MitkCLUtilitiesExports.h>
+
+#include <map>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * \brief Calculates first order, co-occurence and run-length features for all labels of a label image in one run.
+  *
+  * The image is cropped to the bounding box of each label and quantized once. The co-occurence and run-length
+  * matrices of all directions and ranges are filled in a single traversal of the box. The labels are distributed
+  * over the OpenMP threads; if there is only one label, its traversal is distributed instead, every thread with
+  * its own matrices. The matrices only cover the grey levels that occur inside of the label, so small lesions
+  * need small matrices.
+  *
+  * The features have the names and definitions of GIFFirstOrderStatistics, GIFCooccurenceMatrix and
+  * GIFGrayLevelRunLength (means and standard deviations over the 13 directions, 4 for 2D images). The grey
+  * levels are NumberOfBins bins between the minimum and maximum of the whole image. Run lengths are counted
+  * in voxels along the direction.
+  */
+  class MITKCLUTILITIES_EXPORT GIFMultiLabelFeatures : public AbstractGlobalImageFeature
+  {
+    public:
+      mitkClassMacro(GIFMultiLabelFeatures,AbstractGlobalImageFeature)
+      itkFactorylessNewMacro(Self)
+      itkCloneMacro(Self)
+
+      /** Features per label */
+      typedef std::map<int, FeatureListType> FeatureTableType;
+
+      GIFMultiLabelFeatures();
+
+      /**
+      * \brief Calculates the features of the voxels with the value 1 of the mask.
+      */
+      virtual FeatureListType CalculateFeatures(const Image::Pointer & image, const Image::Pointer &feature);
+
+      /**
+      * \brief Calculates the features of every label (non zero value) of labelImage, which has to have the size of image.
+      */
+      FeatureTableType CalculateFeatureTable(const Image::Pointer & image, const Image::Pointer & labelImage);
+
+      /**
+      * \brief Returns a list of the names of all features that are calculated from this class
+      */
+      virtual FeatureNameListType GetFeatureNames();
+
+      itkGetConstMacro(FirstOrder, bool);
+      itkSetMacro(FirstOrder, bool);
+
+      itkGetConstMacro(NumberOfBins, unsigned int);
+      itkSetMacro(NumberOfBins, unsigned int);
+
+      /** Ranges (offset lengths in voxels) of the co-occurence features, empty for none */
+      void SetCooccurenceRanges(const std::vector<double> & ranges) { m_CooccurenceRanges = ranges; }
+      const std::vector<double> & GetCooccurenceRanges() const { return m_CooccurenceRanges; }
+
+      /** Ranges (step lengths in voxels) of the run-length features, empty for none */
+      void SetRunLengthRanges(const std::vector<double> & ranges) { m_RunLengthRanges = ranges; }
+      const std::vector<double> & GetRunLengthRanges() const { return m_RunLengthRanges; }
+
+    private:
+      /** Features of the given label, or of all labels if label is 0 */
+      FeatureTableType CalculateFeatureTable(const Image::Pointer & image, const Image::Pointer & labelImage, int label);
+
+      bool m_FirstOrder;
+      unsigned int m_NumberOfBins;
+      std::vector<double> m_CooccurenceRanges;
+      std::vector<double> m_RunLengthRanges;
+  };
+
+}
+#endif //mitkGIFMultiLabelFeatures_h
@@ -0,0 +1,417 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef itkMultiScaleVoxelFeatureImageFilter_cpp
+#define itkMultiScaleVoxelFeatureImageFilter_cpp
+
+#include "itkMultiScaleVoxelFeatureImageFilter.h"
+
+#include <itkTensorEigenValues.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace itk
+{
+
+template< class TInputImage >
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::MultiScaleVoxelFeatureImageFilter()
+  : m_DifferenceOfGaussianRatio(0.66),
+    m_StructureTensorOuterScaleFactor(2.0),
+    m_SlicesPerTile(16)
+{
+  static_assert(TInputImage::ImageDimension == 3, "MultiScaleVoxelFeatureImageFilter needs a 3D input image.");
+}
+
+template< class TInputImage >
+unsigned int
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GetNumberOfFeatures() const
+{
+  return m_GaussianSigmas.size() + m_DifferenceOfGaussianSigmas.size() + m_LaplacianOfGaussianSigmas.size()
+      + 3 * m_HessianSigmas.size() + 3 * m_StructureTensorSigmas.size();
+}
+
+template< class TInputImage >
+std::vector<std::string>
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GetFeatureNames() const
+{
+  std::vector<std::string> names;
+  const SigmaListType * lists[5] = { &m_GaussianSigmas, &m_DifferenceOfGaussianSigmas, &m_LaplacianOfGaussianSigmas,
+                                     &m_HessianSigmas, &m_StructureTensorSigmas };
+  const char * prefixes[5] = { "gaussian", "dog", "log", "hessian", "structuretensor" };
+  for (unsigned int kind = 0; kind < 5; ++kind)
+  {
+    for (const double sigma : *lists[kind])
+    {
+      const unsigned int components = kind < 3 ? 1 : 3;
+      for (unsigned int i = 0; i < components; ++i)
+      {
+        std::ostringstream name;
+        name << prefixes[kind];
+        if (components > 1)
+          name << i;
+        name << "-" << sigma;
+        names.push_back(name.str());
+      }
+    }
+  }
+  return names;
+}
+
+template< class TInputImage >
+std::vector<typename MultiScaleVoxelFeatureImageFilter< TInputImage >::FeatureTask>
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GetFeatureTasks() const
+{
+  std::vector<FeatureTask> tasks;
+  unsigned int column = 0;
+  for (const double sigma : m_GaussianSigmas)
+    tasks.push_back({ sigma, Gaussian, column++ });
+  for (const double sigma : m_DifferenceOfGaussianSigmas)
+  {
+    tasks.push_back({ m_DifferenceOfGaussianRatio * sigma, DifferenceOfGaussianLower, column });
+    tasks.push_back({ sigma, DifferenceOfGaussianUpper, column++ });
+  }
+  for (const double sigma : m_LaplacianOfGaussianSigmas)
+    tasks.push_back({ sigma, LaplacianOfGaussian, column++ });
+  for (const double sigma : m_HessianSigmas)
+  {
+    tasks.push_back({ sigma, Hessian, column });
+    column += 3;
+  }
+  for (const double sigma : m_StructureTensorSigmas)
+  {
+    tasks.push_back({ sigma, StructureTensor, column });
+    column += 3;
+  }
+
+  // order of the scale space; the lower DoG scale is always visited before the upper one
+  std::stable_sort(tasks.begin(), tasks.end(), [](const FeatureTask & a, const FeatureTask & b) { return a.Sigma < b.Sigma; });
+  return tasks;
+}
+
+template< class TInputImage >
+unsigned int
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GetHaloSize() const
+{
+  return this->GetHaloSize(this->GetFeatureTasks());
+}
+
+template< class TInputImage >
+unsigned int
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GetHaloSize(const std::vector<FeatureTask> & tasks) const
+{
+  const double spacing = this->GetInput()->GetSpacing()[2];
+
+  // every smoothing step spreads the tile border by its kernel radius, the derivatives by one slice
+  unsigned int halo = 1;
+  unsigned int structureTensorHalo = 0;
+  double currentSigma = 0;
+  for (const FeatureTask & task : tasks)
+  {
+    if (task.Sigma > currentSigma)
+    {
+      halo += std::ceil(3.0 * std::sqrt(task.Sigma * task.Sigma - currentSigma * currentSigma) / spacing);
+      currentSigma = task.Sigma;
+    }
+    if (task.Kind == StructureTensor)
+      structureTensorHalo = std::max<unsigned int>(structureTensorHalo, std::ceil(3.0 * m_StructureTensorOuterScaleFactor * task.Sigma / spacing));
+  }
+  return halo + structureTensorHalo;
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::SmoothAlongAxis(float * data, const unsigned int dimensions[3], unsigned int axis, double sigmaInVoxels)
+{
+  if (sigmaInVoxels < 0.01)
+    return;
+
+  const int radius = std::ceil(3.0 * sigmaInVoxels);
+  std::vector<float> kernel(2 * radius + 1);
+  double sum = 0;
+  for (int i = -radius; i <= radius; ++i)
+    sum += kernel[i + radius] = std::exp(-0.5 * i * i / (sigmaInVoxels * sigmaInVoxels));
+  for (float & weight : kernel)
+    weight /= sum;
+
+  const std::size_t sliceSize = static_cast<std::size_t>(dimensions[0]) * dimensions[1];
+  const std::size_t stride = axis == 0 ? 1 : (axis == 1 ? dimensions[0] : sliceSize);
+  const int length = dimensions[axis];
+  const long numberOfLines = sliceSize * dimensions[2] / length;
+
+#pragma omp parallel
+  {
+    std::vector<float> line(length + 2 * radius);
+
+#pragma omp for
+    for (long l = 0; l < numberOfLines; ++l)
+    {
+      std::size_t start;
+      if (axis == 0)
+        start = l * dimensions[0];
+      else if (axis == 1)
+        start = (l / dimensions[0]) * sliceSize + l % dimensions[0];
+      else
+        start = l;
+
+      // replicate the border values
+      for (int i = -radius; i < length + radius; ++i)
+        line[i + radius] = data[start + std::min(std::max(i, 0), length - 1) * stride];
+
+      for (int i = 0; i < length; ++i)
+      {
+        float value = 0;
+        for (int k = 0; k <= 2 * radius; ++k)
+          value += kernel[k] * line[i + k];
+        data[start + i * stride] = value;
+      }
+    }
+  }
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::ComputeTile(unsigned int firstSlice, unsigned int numberOfSlices, float * features)
+{
+  const InputImageType * input = this->GetInput();
+  const typename InputImageType::SizeType size = input->GetBufferedRegion().GetSize();
+  const typename InputImageType::SpacingType spacing = input->GetSpacing();
+  const std::vector<FeatureTask> tasks = this->GetFeatureTasks();
+  const unsigned int numberOfFeatures = this->GetNumberOfFeatures();
+  const unsigned int halo = this->GetHaloSize(tasks);
+
+  const unsigned int tileBegin = firstSlice > halo ? firstSlice - halo : 0;
+  const unsigned int tileEnd = std::min<unsigned int>(size[2], firstSlice + numberOfSlices + halo);
+  const unsigned int dimensions[3] = { static_cast<unsigned int>(size[0]), static_cast<unsigned int>(size[1]), tileEnd - tileBegin };
+  const std::size_t sliceSize = static_cast<std::size_t>(dimensions[0]) * dimensions[1];
+  const long tileSize = sliceSize * dimensions[2];
+  const long numberOfOutputVoxels = sliceSize * numberOfSlices;
+  const std::size_t outputOffset = (firstSlice - tileBegin) * sliceSize;
+
+  // the smoothed tile walks up the scale space
+  std::vector<float> smoothed(tileSize);
+  const typename InputImageType::PixelType * inputBuffer = input->GetBufferPointer() + tileBegin * sliceSize;
+#pragma omp parallel for
+  for (long i = 0; i < tileSize; ++i)
+    smoothed[i] = static_cast<float>(inputBuffer[i]);
+
+  // smoothed gradient products xx, xy, xz, yy, yz, zz, one volume each
+  std::vector<float> structureTensor;
+
+  double currentSigma = 0;
+  std::size_t firstTask = 0;
+  while (firstTask < tasks.size())
+  {
+    const double sigma = tasks[firstTask].Sigma;
+    std::size_t lastTask = firstTask;
+    bool needsHessian = false;
+    bool needsStructureTensor = false;
+    while (lastTask < tasks.size() && tasks[lastTask].Sigma == sigma)
+    {
+      needsHessian |= tasks[lastTask].Kind == LaplacianOfGaussian || tasks[lastTask].Kind == Hessian;
+      needsStructureTensor |= tasks[lastTask].Kind == StructureTensor;
+      ++lastTask;
+    }
+
+    const double increment = std::sqrt(sigma * sigma - currentSigma * currentSigma);
+    for (unsigned int axis = 0; axis < 3; ++axis)
+      SmoothAlongAxis(smoothed.data(), dimensions, axis, increment / spacing[axis]);
+    currentSigma = sigma;
+
+    if (needsStructureTensor)
+    {
+      structureTensor.resize(6 * tileSize);
+#pragma omp parallel for
+      for (long p = 0; p < tileSize; ++p)
+      {
+        const unsigned int x = p % dimensions[0];
+        const unsigned int y = (p / dimensions[0]) % dimensions[1];
+        const unsigned int z = p / sliceSize;
+        const long right = x + 1 < dimensions[0] ? 1 : 0, left = x > 0 ? -1 : 0;
+        const long front = y + 1 < dimensions[1] ? static_cast<long>(dimensions[0]) : 0, back = y > 0 ? -static_cast<long>(dimensions[0]) : 0;
+        const long top = z + 1 < dimensions[2] ? static_cast<long>(sliceSize) : 0, bottom = z > 0 ? -static_cast<long>(sliceSize) : 0;
+
+        const double gx = right != left ? (smoothed[p + right] - smoothed[p + left]) / ((right - left) * spacing[0]) : 0;
+        const double gy = front != back ? (smoothed[p + front] - smoothed[p + back]) / ((front - back) / static_cast<long>(dimensions[0]) * spacing[1]) : 0;
+        const double gz = top != bottom ? (smoothed[p + top] - smoothed[p + bottom]) / ((top - bottom) / static_cast<long>(sliceSize) * spacing[2]) : 0;
+        structureTensor[p] = gx * gx;
+        structureTensor[tileSize + p] = gx * gy;
+        structureTensor[2 * tileSize + p] = gx * gz;
+        structureTensor[3 * tileSize + p] = gy * gy;
+        structureTensor[4 * tileSize + p] = gy * gz;
+        structureTensor[5 * tileSize + p] = gz * gz;
+      }
+      for (unsigned int component = 0; component < 6; ++component)
+        for (unsigned int axis = 0; axis < 3; ++axis)
+          SmoothAlongAxis(structureTensor.data() + component * tileSize, dimensions, axis, m_StructureTensorOuterScaleFactor * sigma / spacing[axis]);
+    }
+
+    // fused pass over the output voxels: all features of this scale at once
+#pragma omp parallel for
+    for (long v = 0; v < numberOfOutputVoxels; ++v)
+    {
+      const long p = outputOffset + v;
+      float * row = features + v * numberOfFeatures;
+
+      double hessian[6] = { 0, 0, 0, 0, 0, 0 };
+      if (needsHessian)
+      {
+        const unsigned int x = p % dimensions[0];
+        const unsigned int y = (p / dimensions[0]) % dimensions[1];
+        const unsigned int z = p / sliceSize;
+        const long offsets[3][2] = {
+          { x > 0 ? -1 : 0, x + 1 < dimensions[0] ? 1 : 0 },
+          { y > 0 ? -static_cast<long>(dimensions[0]) : 0, y + 1 < dimensions[1] ? static_cast<long>(dimensions[0]) : 0 },
+          { z > 0 ? -static_cast<long>(sliceSize) : 0, z + 1 < dimensions[2] ? static_cast<long>(sliceSize) : 0 } };
+        const double steps[3] = { static_cast<double>((offsets[0][0] != 0) + (offsets[0][1] != 0)),
+                                  static_cast<double>((offsets[1][0] != 0) + (offsets[1][1] != 0)),
+                                  static_cast<double>((offsets[2][0] != 0) + (offsets[2][1] != 0)) };
+        const double center = smoothed[p];
+
+        // second derivatives, xx, xy, xz, yy, yz, zz
+        unsigned int element = 0;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          for (unsigned int j = i; j < 3; ++j, ++element)
+          {
+            if (steps[i] == 0 || steps[j] == 0)
+              continue;
+            if (i == j)
+              hessian[element] = (smoothed[p + offsets[i][1]] - 2.0 * center + smoothed[p + offsets[i][0]]) / (spacing[i] * spacing[i]);
+            else
+              hessian[element] = (smoothed[p + offsets[i][1] + offsets[j][1]] - smoothed[p + offsets[i][1] + offsets[j][0]]
+                                  - smoothed[p + offsets[i][0] + offsets[j][1]] + smoothed[p + offsets[i][0] + offsets[j][0]])
+                  / (steps[i] * steps[j] * spacing[i] * spacing[j]);
+          }
+        }
+      }
+
+      for (std::size_t t = firstTask; t < lastTask; ++t)
+      {
+        const FeatureTask & task = tasks[t];
+        double eigenValues[3];
+        switch (task.Kind)
+        {
+        case Gaussian:
+          row[task.Column] = smoothed[p];
+          break;
+        case DifferenceOfGaussianLower:
+          row[task.Column] = -smoothed[p];
+          break;
+        case DifferenceOfGaussianUpper:
+          row[task.Column] += smoothed[p];
+          break;
+        case LaplacianOfGaussian:
+          row[task.Column] = hessian[0] + hessian[3] + hessian[5];
+          break;
+        case Hessian:
+          ComputeTensorEigenValues(hessian, eigenValues);
+          row[task.Column] = eigenValues[0];
+          row[task.Column + 1] = eigenValues[1];
+          row[task.Column + 2] = eigenValues[2];
+          break;
+        case StructureTensor:
+          {
+            double tensor[6];
+            for (unsigned int i = 0; i < 6; ++i)
+              tensor[i] = structureTensor[i * tileSize + p];
+            ComputeTensorEigenValues(tensor, eigenValues);
+            row[task.Column] = eigenValues[0];
+            row[task.Column + 1] = eigenValues[1];
+            row[task.Column + 2] = eigenValues[2];
+          }
+          break;
+        }
+      }
+    }
+
+    firstTask = lastTask;
+  }
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::ComputeFeatureBlock(unsigned int firstSlice, unsigned int numberOfSlices, std::vector<float> & block)
+{
+  const typename InputImageType::SizeType size = this->GetInput()->GetBufferedRegion().GetSize();
+  if (firstSlice + numberOfSlices > size[2])
+    itkExceptionMacro(<< "Slices " << firstSlice << " to " << firstSlice + numberOfSlices << " are outside of the input.");
+
+  block.resize(static_cast<std::size_t>(size[0]) * size[1] * numberOfSlices * this->GetNumberOfFeatures());
+  this->ComputeTile(firstSlice, numberOfSlices, block.data());
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  if (m_DifferenceOfGaussianRatio <= 0 || m_DifferenceOfGaussianRatio >= 1)
+    itkExceptionMacro(<< "DifferenceOfGaussianRatio has to be in (0, 1).");
+  this->GetOutput()->SetNumberOfComponentsPerPixel(this->GetNumberOfFeatures());
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  // the tiles read the whole buffer
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  if (input)
+    input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template< class TInputImage >
+void
+MultiScaleVoxelFeatureImageFilter< TInputImage >
+::GenerateData()
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  output->SetRegions(input->GetLargestPossibleRegion());
+  output->Allocate();
+
+  const typename InputImageType::SizeType size = input->GetLargestPossibleRegion().GetSize();
+  const std::size_t sliceSize = static_cast<std::size_t>(size[0]) * size[1];
+  const unsigned int numberOfSlices = size[2];
+  const unsigned int slicesPerTile = std::max(1u, m_SlicesPerTile);
+
+  for (unsigned int firstSlice = 0; firstSlice < numberOfSlices; firstSlice += slicesPerTile)
+  {
+    const unsigned int tileSlices = std::min(slicesPerTile, numberOfSlices - firstSlice);
+    this->ComputeTile(firstSlice, tileSlices, output->GetBufferPointer() + firstSlice * sliceSize * this->GetNumberOfFeatures());
+    this->UpdateProgress(static_cast<float>(firstSlice + tileSlices) / numberOfSlices);
+  }
+}
+
+}
+
+#endif // itkMultiScaleVoxelFeatureImageFilter_cpp
@@ -0,0 +1,573 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkGIFMultiLabelFeatures.h>
+
+// MITK
+#include <mitkExceptionMacro.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageStatisticsHolder.h>
+#include <mitkPixelTypeMultiplex.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+  // Bounding box of a label inside of the image
+  struct CropRegion
+  {
+    unsigned int ImageSize[3];
+    unsigned int Begin[3];
+    unsigned int Size[3];
+
+    std::size_t GetNumberOfVoxels() const
+    {
+      return static_cast<std::size_t>(Size[0]) * Size[1] * Size[2];
+    }
+
+    // Offset of the first voxel of row y, z of the box in the image buffer
+    std::size_t GetImageRowOffset(unsigned int y, unsigned int z) const
+    {
+      return ((static_cast<std::size_t>(Begin[2] + z) * ImageSize[1]) + Begin[1] + y) * ImageSize[0] + Begin[0];
+    }
+  };
+
+  template <typename TPixel>
+  void FindLabelBoxes(const mitk::PixelType &, const void * labels, const CropRegion * image, std::map<int, CropRegion> * boxes)
+  {
+    const TPixel * values = static_cast<const TPixel *>(labels);
+    CropRegion * box = nullptr;
+    int lastLabel = 0;
+    std::size_t i = 0;
+    for (unsigned int z = 0; z < image->ImageSize[2]; ++z)
+    {
+      for (unsigned int y = 0; y < image->ImageSize[1]; ++y)
+      {
+        for (unsigned int x = 0; x < image->ImageSize[0]; ++x, ++i)
+        {
+          const int label = static_cast<int>(values[i]);
+          if (label == 0)
+            continue;
+
+          const unsigned int position[3] = { x, y, z };
+          if (box == nullptr || label != lastLabel)
+          {
+            auto it = boxes->find(label);
+            if (it == boxes->end())
+            {
+              CropRegion region = *image;
+              for (unsigned int d = 0; d < 3; ++d)
+              {
+                region.Begin[d] = position[d];
+                region.Size[d] = 1;
+              }
+              it = boxes->insert(std::make_pair(label, region)).first;
+            }
+            box = &it->second;
+            lastLabel = label;
+          }
+
+          for (unsigned int d = 0; d < 3; ++d)
+          {
+            if (position[d] < box->Begin[d])
+            {
+              box->Size[d] += box->Begin[d] - position[d];
+              box->Begin[d] = position[d];
+            }
+            else if (position[d] >= box->Begin[d] + box->Size[d])
+            {
+              box->Size[d] = position[d] - box->Begin[d] + 1;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  template <typename TPixel>
+  void CropLabel(const mitk::PixelType &, const void * labels, const CropRegion * region, int label, unsigned char * mask)
+  {
+    const TPixel * values = static_cast<const TPixel *>(labels);
+    for (unsigned int z = 0; z < region->Size[2]; ++z)
+    {
+      for (unsigned int y = 0; y < region->Size[1]; ++y)
+      {
+        const TPixel * row = values + region->GetImageRowOffset(y, z);
+        for (unsigned int x = 0; x < region->Size[0]; ++x)
+          *mask++ = static_cast<int>(row[x]) == label;
+      }
+    }
+  }
+
+  template <typename TPixel>
+  void CropValues(const mitk::PixelType &, const void * image, const CropRegion * region, double * values)
+  {
+    const TPixel * pixels = static_cast<const TPixel *>(image);
+    for (unsigned int z = 0; z < region->Size[2]; ++z)
+    {
+      for (unsigned int y = 0; y < region->Size[1]; ++y)
+      {
+        const TPixel * row = pixels + region->GetImageRowOffset(y, z);
+        for (unsigned int x = 0; x < region->Size[0]; ++x)
+          *values++ = static_cast<double>(row[x]);
+      }
+    }
+  }
+
+  // Offset between the voxels of a co-occurence pair or the steps of a run
+  struct TextureDirection
+  {
+    int Step[3];
+  };
+
+  std::vector<TextureDirection> GetTextureDirections(const std::vector<double> & ranges, bool is3D)
+  {
+    // one of each pair of opposite neighbours, like the default offsets of the ITK texture filters
+    std::vector<TextureDirection> directions;
+    for (double range : ranges)
+    {
+      for (int dz = 0; dz <= (is3D ? 1 : 0); ++dz)
+      {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+          for (int dx = -1; dx <= 1; ++dx)
+          {
+            if (dz == 0 && (dy < 0 || (dy == 0 && dx <= 0)))
+              continue;
+            TextureDirection direction = { { static_cast<int>(dx * range), static_cast<int>(dy * range), static_cast<int>(dz * range) } };
+            directions.push_back(direction);
+          }
+        }
+      }
+    }
+    return directions;
+  }
+
+  // Mean and standard deviation over the directions of one range; directions without any entries are left out
+  void AddMeansAndStd(const std::vector< std::vector<double> > & values, const std::string & prefix,
+                      const char * const names[], std::size_t numberOfNames, mitk::AbstractGlobalImageFeature::FeatureListType & features)
+  {
+    for (std::size_t feature = 0; feature < numberOfNames; ++feature)
+    {
+      double mean = 0;
+      double deviation = 0;
+      if (!values.empty())
+      {
+        for (const std::vector<double> & direction : values)
+          mean += direction[feature];
+        mean /= values.size();
+        for (const std::vector<double> & direction : values)
+          deviation += (direction[feature] - mean) * (direction[feature] - mean);
+        deviation = std::sqrt(deviation / values.size());
+      }
+      features.push_back(std::make_pair(prefix + names[feature] + " Means", mean));
+      features.push_back(std::make_pair(prefix + names[feature] + " Std.", deviation));
+    }
+  }
+
+  const char * const CooccurenceFeatureNames[] = { "Energy", "Entropy", "Correlation", "InverseDifferenceMoment", "Inertia",
+                                                   "ClusterShade", "ClusterProminence", "HaralickCorrelation" };
+  const char * const RunLengthFeatureNames[] = { "ShortRunEmphasis", "LongRunEmphasis", "GreyLevelNonuniformity",
+                                                 "RunLengthNonuniformity", "LowGreyLevelRunEmphasis", "HighGreyLevelRunEmphasis",
+                                                 "ShortRunLowGreyLevelEmphasis", "ShortRunHighGreyLevelEmphasis",
+                                                 "LongRunLowGreyLevelEmphasis", "LongRunHighGreyLevelEmphasis" };
+
+  std::string GetRangePrefix(const std::string & name, double range)
+  {
+    std::ostringstream ss;
+    ss << name << " (" << range << ") ";
+    return ss.str();
+  }
+
+  // Definitions of itk::Statistics::HistogramToTextureFeaturesFilter, the matrix is restricted to the used grey levels
+  std::vector<double> CalculateCooccurenceFeatures(const unsigned int * matrix, const std::vector<unsigned int> & greyLevels, unsigned int numberOfBins)
+  {
+    const std::size_t numberOfLevels = greyLevels.size();
+    double total = 0;
+    for (std::size_t i = 0; i < numberOfLevels * numberOfLevels; ++i)
+      total += matrix[i];
+
+    std::vector<double> marginal(numberOfLevels, 0.0);
+    double pixelMean = 0;
+    for (std::size_t a = 0; a < numberOfLevels; ++a)
+    {
+      for (std::size_t b = 0; b < numberOfLevels; ++b)
+        marginal[a] += matrix[a * numberOfLevels + b] / total;
+      pixelMean += greyLevels[a] * marginal[a];
+    }
+
+    double pixelVariance = 0;
+    const double marginalMean = 1.0 / numberOfBins;
+    double marginalDevSquared = (numberOfBins - numberOfLevels) * marginalMean * marginalMean;
+    for (std::size_t a = 0; a < numberOfLevels; ++a)
+    {
+      pixelVariance += (greyLevels[a] - pixelMean) * (greyLevels[a] - pixelMean) * marginal[a];
+      marginalDevSquared += (marginal[a] - marginalMean) * (marginal[a] - marginalMean);
+    }
+    marginalDevSquared /= numberOfBins;
+    const double pixelVarianceSquared = pixelVariance * pixelVariance;
+
+    std::vector<double> features(8, 0.0);
+    for (std::size_t a = 0; a < numberOfLevels; ++a)
+    {
+      const double i = greyLevels[a];
+      for (std::size_t b = 0; b < numberOfLevels; ++b)
+      {
+        if (matrix[a * numberOfLevels + b] == 0)
+          continue;
+        const double frequency = matrix[a * numberOfLevels + b] / total;
+        const double j = greyLevels[b];
+        const double sum = (i - pixelMean) + (j - pixelMean);
+
+        features[0] += frequency * frequency;
+        features[1] -= frequency > 0.0001 ? frequency * std::log(frequency) / std::log(2.0) : 0;
+        features[2] += (i - pixelMean) * (j - pixelMean) * frequency / pixelVarianceSquared;
+        features[3] += frequency / (1.0 + (i - j) * (i - j));
+        features[4] += (i - j) * (i - j) * frequency;
+        features[5] += sum * sum * sum * frequency;
+        features[6] += sum * sum * sum * sum * frequency;
+        features[7] += i * j * frequency;
+      }
+    }
+    features[7] = (features[7] - marginalMean * marginalMean) / marginalDevSquared;
+    return features;
+  }
+
+  // Definitions of itk::Statistics::HistogramToRunLengthFeaturesFilter, with the run length in voxels
+  std::vector<double> CalculateRunLengthFeatures(const unsigned int * matrix, const std::vector<unsigned int> & greyLevels, unsigned int maximumRunLength)
+  {
+    const std::size_t numberOfLevels = greyLevels.size();
+    std::vector<double> features(10, 0.0);
+    std::vector<double> runLengthSums(maximumRunLength, 0.0);
+    double numberOfRuns = 0;
+
+    for (std::size_t a = 0; a < numberOfLevels; ++a)
+    {
+      const double i2 = (greyLevels[a] + 1.0) * (greyLevels[a] + 1.0);
+      double greyLevelSum = 0;
+      for (unsigned int length = 0; length < maximumRunLength; ++length)
+      {
+        const double frequency = matrix[a * maximumRunLength + length];
+        if (frequency == 0)
+          continue;
+        const double j2 = (length + 1.0) * (length + 1.0);
+        numberOfRuns += frequency;
+        greyLevelSum += frequency;
+        runLengthSums[length] += frequency;
+
+        features[0] += frequency / j2;
+        features[1] += frequency * j2;
+        features[4] += frequency / i2;
+        features[5] += frequency * i2;
+        features[6] += frequency / (i2 * j2);
+        features[7] += frequency * i2 / j2;
+        features[8] += frequency * j2 / i2;
+        features[9] += frequency * i2 * j2;
+      }
+      features[2] += greyLevelSum * greyLevelSum;
+    }
+    for (double sum : runLengthSums)
+      features[3] += sum * sum;
+
+    for (double & feature : features)
+      feature /= numberOfRuns;
+    return features;
+  }
+
+  void CalculateFirstOrderFeatures(const std::vector<unsigned char> & mask, const std::vector<double> & values,
+                                   mitk::AbstractGlobalImageFeature::FeatureListType & features)
+  {
+    std::vector<double> labelValues;
+    for (std::size_t i = 0; i < mask.size(); ++i)
+      if (mask[i])
+        labelValues.push_back(values[i]);
+
+    const double count = labelValues.size();
+    double sum = 0;
+    for (double value : labelValues)
+      sum += value;
+    const double mean = sum / count;
+    double squaredDeviations = 0;
+    for (double value : labelValues)
+      squaredDeviations += (value - mean) * (value - mean);
+    const double variance = count > 1 ? squaredDeviations / (count - 1) : 0;
+
+    const std::size_t middle = labelValues.size() / 2;
+    std::nth_element(labelValues.begin(), labelValues.begin() + middle, labelValues.end());
+    double median = labelValues[middle];
+    if (labelValues.size() % 2 == 0)
+      median = (median + *std::max_element(labelValues.begin(), labelValues.begin() + middle)) / 2;
+
+    features.push_back(std::make_pair("FirstOrder Minimum", *std::min_element(labelValues.begin(), labelValues.end())));
+    features.push_back(std::make_pair("FirstOrder Maximum", *std::max_element(labelValues.begin(), labelValues.end())));
+    features.push_back(std::make_pair("FirstOrder Mean", mean));
+    features.push_back(std::make_pair("FirstOrder Variance", variance));
+    features.push_back(std::make_pair("FirstOrder Sum", sum));
+    features.push_back(std::make_pair("FirstOrder Median", median));
+    features.push_back(std::make_pair("FirstOrder Sigma", std::sqrt(variance)));
+    features.push_back(std::make_pair("FirstOrder No. of Voxel", count));
+  }
+
+  // All features of one label, from the mask and the values cropped to its bounding box
+  void CalculateLabelFeatures(const mitk::GIFMultiLabelFeatures * settings, const CropRegion & region, const std::vector<unsigned char> & mask,
+                              const std::vector<double> & values, double minimum, double maximum, mitk::AbstractGlobalImageFeature::FeatureListType & features)
+  {
+    if (settings->GetFirstOrder())
+      CalculateFirstOrderFeatures(mask, values, features);
+
+    const bool is3D = region.ImageSize[2] > 1;
+    const std::vector<TextureDirection> cooccurenceDirections = GetTextureDirections(settings->GetCooccurenceRanges(), is3D);
+    const std::vector<TextureDirection> runLengthDirections = GetTextureDirections(settings->GetRunLengthRanges(), is3D);
+    if (cooccurenceDirections.empty() && runLengthDirections.empty())
+      return;
+
+    // quantize once; levels holds the index into greyLevels, -1 outside of the label
+    const unsigned int numberOfBins = std::max(1u, settings->GetNumberOfBins());
+    const double binWidth = (maximum - minimum) / numberOfBins;
+    std::vector<int> levels(mask.size(), -1);
+    std::vector<int> levelOfBin(numberOfBins, -1);
+    for (std::size_t i = 0; i < mask.size(); ++i)
+    {
+      if (!mask[i])
+        continue;
+      const unsigned int bin = binWidth > 0 ? std::min<unsigned int>(numberOfBins - 1, (values[i] - minimum) / binWidth) : 0;
+      levelOfBin[bin] = 0;
+      levels[i] = bin;
+    }
+    std::vector<unsigned int> greyLevels;
+    for (unsigned int bin = 0; bin < numberOfBins; ++bin)
+    {
+      if (levelOfBin[bin] == 0)
+      {
+        levelOfBin[bin] = greyLevels.size();
+        greyLevels.push_back(bin);
+      }
+    }
+    for (int & level : levels)
+      if (level >= 0)
+        level = levelOfBin[level];
+
+    const int numberOfLevels = greyLevels.size();
+    const unsigned int maximumRunLength = std::max(region.Size[0], std::max(region.Size[1], region.Size[2]));
+    const std::size_t cooccurenceMatrixSize = static_cast<std::size_t>(numberOfLevels) * numberOfLevels;
+    const std::size_t runLengthMatrixSize = static_cast<std::size_t>(numberOfLevels) * maximumRunLength;
+    std::vector<unsigned int> cooccurence(cooccurenceDirections.size() * cooccurenceMatrixSize, 0);
+    std::vector<unsigned int> runLength(runLengthDirections.size() * runLengthMatrixSize, 0);
+
+    const int size[3] = { static_cast<int>(region.Size[0]), static_cast<int>(region.Size[1]), static_cast<int>(region.Size[2]) };
+    const long numberOfRows = static_cast<long>(size[1]) * size[2];
+
+    // inside of the parallel loop over the labels this region is nested and runs on the calling thread only
+#pragma omp parallel if (mask.size() > 32768)
+    {
+      std::vector<unsigned int> threadCooccurence(cooccurence.size(), 0);
+      std::vector<unsigned int> threadRunLength(runLength.size(), 0);
+
+#pragma omp for
+      for (long row = 0; row < numberOfRows; ++row)
+      {
+        const int y = row % size[1];
+        const int z = row / size[1];
+        for (int x = 0; x < size[0]; ++x)
+        {
+          const int level = levels[row * size[0] + x];
+          if (level < 0)
+            continue;
+
+          for (std::size_t d = 0; d < cooccurenceDirections.size(); ++d)
+          {
+            const int * step = cooccurenceDirections[d].Step;
+            const int nx = x + step[0], ny = y + step[1], nz = z + step[2];
+            if (nx < 0 || nx >= size[0] || ny < 0 || ny >= size[1] || nz < 0 || nz >= size[2] || (step[0] == 0 && step[1] == 0 && step[2] == 0))
+              continue;
+            const int neighbour = levels[(static_cast<long>(nz) * size[1] + ny) * size[0] + nx];
+            if (neighbour < 0)
+              continue;
+            unsigned int * matrix = threadCooccurence.data() + d * cooccurenceMatrixSize;
+            ++matrix[level * numberOfLevels + neighbour];
+            ++matrix[neighbour * numberOfLevels + level];
+          }
+
+          for (std::size_t d = 0; d < runLengthDirections.size(); ++d)
+          {
+            const int * step = runLengthDirections[d].Step;
+            if (step[0] == 0 && step[1] == 0 && step[2] == 0)
+              continue;
+
+            // only the first voxel of a run counts it
+            int px = x - step[0], py = y - step[1], pz = z - step[2];
+            if (px >= 0 && px < size[0] && py >= 0 && py < size[1] && pz >= 0 && pz < size[2]
+                && levels[(static_cast<long>(pz) * size[1] + py) * size[0] + px] == level)
+              continue;
+
+            unsigned int length = 1;
+            px = x + step[0];
+            py = y + step[1];
+            pz = z + step[2];
+            while (px >= 0 && px < size[0] && py >= 0 && py < size[1] && pz >= 0 && pz < size[2]
+                   && levels[(static_cast<long>(pz) * size[1] + py) * size[0] + px] == level)
+            {
+              ++length;
+              px += step[0];
+              py += step[1];
+              pz += step[2];
+            }
+            ++threadRunLength[d * runLengthMatrixSize + level * maximumRunLength + length - 1];
+          }
+        }
+      }
+
+#pragma omp critical
+      {
+        for (std::size_t i = 0; i < cooccurence.size(); ++i)
+          cooccurence[i] += threadCooccurence[i];
+        for (std::size_t i = 0; i < runLength.size(); ++i)
+          runLength[i] += threadRunLength[i];
+      }
+    }
+
+    const std::size_t directionsPerRange = is3D ? 13 : 4;
+    const std::vector<double> & cooccurenceRanges = settings->GetCooccurenceRanges();
+    for (std::size_t r = 0; r < cooccurenceRanges.size(); ++r)
+    {
+      std::vector< std::vector<double> > directionFeatures;
+      for (std::size_t d = r * directionsPerRange; d < (r + 1) * directionsPerRange; ++d)
+      {
+        const unsigned int * matrix = cooccurence.data() + d * cooccurenceMatrixSize;
+        if (std::any_of(matrix, matrix + cooccurenceMatrixSize, [](unsigned int count) { return count > 0; }))
+          directionFeatures.push_back(CalculateCooccurenceFeatures(matrix, greyLevels, numberOfBins));
+      }
+      AddMeansAndStd(directionFeatures, GetRangePrefix("co-occ.", cooccurenceRanges[r]), CooccurenceFeatureNames, 8, features);
+    }
+
+    const std::vector<double> & runLengthRanges = settings->GetRunLengthRanges();
+    for (std::size_t r = 0; r < runLengthRanges.size(); ++r)
+    {
+      std::vector< std::vector<double> > directionFeatures;
+      for (std::size_t d = r * directionsPerRange; d < (r + 1) * directionsPerRange; ++d)
+      {
+        const unsigned int * matrix = runLength.data() + d * runLengthMatrixSize;
+        if (std::any_of(matrix, matrix + runLengthMatrixSize, [](unsigned int count) { return count > 0; }))
+          directionFeatures.push_back(CalculateRunLengthFeatures(matrix, greyLevels, maximumRunLength));
+      }
+      AddMeansAndStd(directionFeatures, GetRangePrefix("RunLength.", runLengthRanges[r]), RunLengthFeatureNames, 10, features);
+    }
+  }
+}
+
+mitk::GIFMultiLabelFeatures::GIFMultiLabelFeatures():
+  m_FirstOrder(true),
+  m_NumberOfBins(256)
+{
+}
+
+mitk::GIFMultiLabelFeatures::FeatureListType mitk::GIFMultiLabelFeatures::CalculateFeatures(const Image::Pointer & image, const Image::Pointer &mask)
+{
+  FeatureTableType table = this->CalculateFeatureTable(image, mask, 1);
+  return table.empty() ? FeatureListType() : table.begin()->second;
+}
+
+mitk::GIFMultiLabelFeatures::FeatureTableType mitk::GIFMultiLabelFeatures::CalculateFeatureTable(const Image::Pointer & image, const Image::Pointer & labelImage)
+{
+  return this->CalculateFeatureTable(image, labelImage, 0);
+}
+
+mitk::GIFMultiLabelFeatures::FeatureTableType mitk::GIFMultiLabelFeatures::CalculateFeatureTable(const Image::Pointer & image, const Image::Pointer & labelImage, int label)
+{
+  CropRegion imageRegion;
+  for (unsigned int d = 0; d < 3; ++d)
+  {
+    imageRegion.ImageSize[d] = image->GetDimension(d);
+    imageRegion.Begin[d] = 0;
+    imageRegion.Size[d] = imageRegion.ImageSize[d];
+    if (labelImage->GetDimension(d) != imageRegion.ImageSize[d])
+      mitkThrow() << "Label image and image need to have the same size.";
+  }
+
+  const double minimum = image->GetStatistics()->GetScalarValueMin();
+  const double maximum = image->GetStatistics()->GetScalarValueMax();
+
+  ImageReadAccessor imageAccessor(image, image->GetVolumeData(0));
+  ImageReadAccessor labelAccessor(labelImage, labelImage->GetVolumeData(0));
+  const mitk::PixelType imagePixelType = image->GetPixelType();
+  const mitk::PixelType labelPixelType = labelImage->GetPixelType();
+
+  std::map<int, CropRegion> boxes;
+  mitkPixelTypeMultiplex3(FindLabelBoxes, labelPixelType, labelAccessor.GetData(), &imageRegion, &boxes);
+
+  std::vector< std::pair<int, CropRegion> > labelBoxes;
+  for (const auto & box : boxes)
+  {
+    if (label == 0 || box.first == label)
+      labelBoxes.push_back(box);
+  }
+
+  // the labels are distributed over the threads; a single label parallelises the traversal of its box instead
+  const long numberOfLabels = labelBoxes.size();
+  std::vector<FeatureListType> labelFeatures(numberOfLabels);
+#pragma omp parallel for schedule(dynamic) if (numberOfLabels > 1)
+  for (long i = 0; i < numberOfLabels; ++i)
+  {
+    const CropRegion & region = labelBoxes[i].second;
+    std::vector<unsigned char> mask(region.GetNumberOfVoxels());
+    std::vector<double> values(region.GetNumberOfVoxels());
+    mitkPixelTypeMultiplex4(CropLabel, labelPixelType, labelAccessor.GetData(), &region, labelBoxes[i].first, mask.data());
+    mitkPixelTypeMultiplex3(CropValues, imagePixelType, imageAccessor.GetData(), &region, values.data());
+
+    CalculateLabelFeatures(this, region, mask, values, minimum, maximum, labelFeatures[i]);
+  }
+
+  FeatureTableType table;
+  for (long i = 0; i < numberOfLabels; ++i)
+    table[labelBoxes[i].first].swap(labelFeatures[i]);
+  return table;
+}
+
+mitk::GIFMultiLabelFeatures::FeatureNameListType mitk::GIFMultiLabelFeatures::GetFeatureNames()
+{
+  FeatureNameListType featureList;
+  if (m_FirstOrder)
+  {
+    featureList.push_back("FirstOrder Minimum");
+    featureList.push_back("FirstOrder Maximum");
+    featureList.push_back("FirstOrder Mean");
+    featureList.push_back("FirstOrder Variance");
+    featureList.push_back("FirstOrder Sum");
+    featureList.push_back("FirstOrder Median");
+    featureList.push_back("FirstOrder Sigma");
+    featureList.push_back("FirstOrder No. of Voxel");
+  }
+  for (double range : m_CooccurenceRanges)
+  {
+    for (const char * name : CooccurenceFeatureNames)
+    {
+      featureList.push_back(GetRangePrefix("co-occ.", range) + name + " Means");
+      featureList.push_back(GetRangePrefix("co-occ.", range) + name + " Std.");
+    }
+  }
+  for (double range : m_RunLengthRanges)
+  {
+    for (const char * name : RunLengthFeatureNames)
+    {
+      featureList.push_back(GetRangePrefix("RunLength.", range) + name + " Means");
+      featureList.push_back(GetRangePrefix("RunLength.", range) + name + " Std.");
+    }
+  }
+  return featureList;
+}
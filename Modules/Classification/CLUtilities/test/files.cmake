@@ -1,3 +1,6 @@
 set(MODULE_TESTS
-  mitkSmoothedClassProbabilitesTest.cpp
+  mitkGIFMultiLabelFeaturesTest.cpp
+  mitkMultiScaleVoxelFeatureImageFilterTest.cpp
+  # writes its result to a hard-coded path
+  # mitkSmoothedClassProbabilitesTest.cpp
 )
@@ -0,0 +1,201 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include <mitkGIFMultiLabelFeatures.h>
+#include <mitkGIFFirstOrderStatistics.h>
+#include <mitkGIFCooccurenceMatrix.h>
+#include <mitkGIFGrayLevelRunLength.h>
+#include <mitkImageCast.h>
+
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <set>
+
+class mitkGIFMultiLabelFeaturesTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkGIFMultiLabelFeaturesTestSuite);
+  MITK_TEST(CalculateFeatureTable_SameAsSingleLabelFeatures);
+  MITK_TEST(CalculateFeatureTable_SameAsCalculateFeatures);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<short, 3> ImageType;
+  typedef itk::Image<unsigned char, 3> LabelImageType;
+  typedef mitk::AbstractGlobalImageFeature::FeatureListType FeatureListType;
+
+  static const int NumberOfLabels = 3;
+
+  mitk::Image::Pointer m_Image;
+  mitk::Image::Pointer m_LabelImage;
+  mitk::Image::Pointer m_Masks[NumberOfLabels];
+
+  /** Features by name; the names of GIFFirstOrderStatistics may end with a blank */
+  static std::map<std::string, double> GetFeatureMap(const FeatureListType & features)
+  {
+    std::map<std::string, double> featureMap;
+    for (const auto & feature : features)
+    {
+      std::string name = feature.first;
+      name.erase(name.find_last_not_of(' ') + 1);
+      featureMap[name] = feature.second;
+    }
+    return featureMap;
+  }
+
+  static void CompareFeatures(const FeatureListType & expected, const FeatureListType & features, const std::set<std::string> & excluded)
+  {
+    const std::map<std::string, double> featureMap = GetFeatureMap(features);
+    for (const auto & feature : GetFeatureMap(expected))
+    {
+      if (excluded.count(feature.first))
+        continue;
+      auto it = featureMap.find(feature.first);
+      CPPUNIT_ASSERT_MESSAGE("Feature is calculated: " + feature.first, it != featureMap.end());
+      CPPUNIT_ASSERT_MESSAGE("Same value of " + feature.first, std::abs(feature.second - it->second) <= 1e-6 * std::max(1.0, std::abs(feature.second)));
+    }
+  }
+
+public:
+  void setUp() override
+  {
+    std::srand(42);
+
+    ImageType::SizeType size;
+    size[0] = 16;
+    size[1] = 14;
+    size[2] = 8;
+
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions(size);
+    image->Allocate();
+    LabelImageType::Pointer labelImage = LabelImageType::New();
+    labelImage->SetRegions(size);
+    labelImage->Allocate();
+    LabelImageType::Pointer masks[NumberOfLabels];
+    for (int label = 0; label < NumberOfLabels; ++label)
+    {
+      masks[label] = LabelImageType::New();
+      masks[label]->SetRegions(size);
+      masks[label]->Allocate();
+    }
+
+    // few distinct grey levels, so that the labels contain runs of equal values
+    const short values[] = { 0, 50, 100, 150, 200, 255 };
+    itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      it.Set(values[std::rand() % 6]);
+
+      // three boxes of different sizes, the first one not convex
+      int label = 0;
+      if (index[0] < 6 && index[1] < 6 && index[2] < 5 && !(index[0] < 2 && index[1] < 2))
+        label = 1;
+      else if (index[0] >= 8 && index[1] < 5 && index[2] >= 2)
+        label = 2;
+      else if (index[1] >= 8 && index[2] >= 1 && index[2] < 7)
+        label = 3;
+      labelImage->SetPixel(index, label);
+      for (int l = 0; l < NumberOfLabels; ++l)
+        masks[l]->SetPixel(index, label == l + 1);
+    }
+    // the grey levels are binned between the image minimum and maximum
+    ImageType::IndexType corner;
+    corner.Fill(0);
+    image->SetPixel(corner, 0);
+    corner[0] = size[0] - 1;
+    image->SetPixel(corner, 255);
+
+    mitk::CastToMitkImage(image, m_Image);
+    mitk::CastToMitkImage(labelImage, m_LabelImage);
+    for (int label = 0; label < NumberOfLabels; ++label)
+      mitk::CastToMitkImage(masks[label], m_Masks[label]);
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_LabelImage = nullptr;
+    for (int label = 0; label < NumberOfLabels; ++label)
+      m_Masks[label] = nullptr;
+  }
+
+  void CalculateFeatureTable_SameAsSingleLabelFeatures()
+  {
+    mitk::GIFMultiLabelFeatures::Pointer multiLabelFeatures = mitk::GIFMultiLabelFeatures::New();
+    multiLabelFeatures->SetCooccurenceRanges(std::vector<double>(1, 1.0));
+    multiLabelFeatures->SetRunLengthRanges(std::vector<double>(1, 1.0));
+    mitk::GIFMultiLabelFeatures::FeatureTableType table = multiLabelFeatures->CalculateFeatureTable(m_Image, m_LabelImage);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(NumberOfLabels), table.size());
+
+    // the median of itk::LabelStatisticsImageFilter is taken from a histogram, GIFMultiLabelFeatures computes it exactly
+    std::set<std::string> excludedFirstOrder;
+    excludedFirstOrder.insert("FirstOrder Median");
+
+    // GIFGrayLevelRunLength bins the physical length of the runs, GIFMultiLabelFeatures counts voxels.
+    // Only the features that depend on the grey levels and the number of runs are comparable.
+    std::set<std::string> excludedRunLength;
+    const char * const runLengthDependent[] = { "ShortRunEmphasis", "LongRunEmphasis", "RunLengthNonuniformity",
+                                                "ShortRunLowGreyLevelEmphasis", "ShortRunHighGreyLevelEmphasis",
+                                                "LongRunLowGreyLevelEmphasis", "LongRunHighGreyLevelEmphasis" };
+    for (const char * name : runLengthDependent)
+    {
+      excludedRunLength.insert(std::string("RunLength. (1) ") + name + " Means");
+      excludedRunLength.insert(std::string("RunLength. (1) ") + name + " Std.");
+    }
+
+    for (int label = 0; label < NumberOfLabels; ++label)
+    {
+      const FeatureListType & features = table[label + 1];
+
+      mitk::GIFFirstOrderStatistics::Pointer firstOrder = mitk::GIFFirstOrderStatistics::New();
+      CompareFeatures(firstOrder->CalculateFeatures(m_Image, m_Masks[label]), features, excludedFirstOrder);
+
+      mitk::GIFCooccurenceMatrix::Pointer cooccurence = mitk::GIFCooccurenceMatrix::New();
+      cooccurence->SetRange(1.0);
+      CompareFeatures(cooccurence->CalculateFeatures(m_Image, m_Masks[label]), features, std::set<std::string>());
+
+      mitk::GIFGrayLevelRunLength::Pointer runLength = mitk::GIFGrayLevelRunLength::New();
+      runLength->SetRange(1.0);
+      CompareFeatures(runLength->CalculateFeatures(m_Image, m_Masks[label]), features, excludedRunLength);
+    }
+  }
+
+  void CalculateFeatureTable_SameAsCalculateFeatures()
+  {
+    mitk::GIFMultiLabelFeatures::Pointer multiLabelFeatures = mitk::GIFMultiLabelFeatures::New();
+    multiLabelFeatures->SetCooccurenceRanges(std::vector<double>(1, 1.0));
+    multiLabelFeatures->SetRunLengthRanges(std::vector<double>(1, 1.0));
+    mitk::GIFMultiLabelFeatures::FeatureTableType table = multiLabelFeatures->CalculateFeatureTable(m_Image, m_LabelImage);
+
+    // the labels are calculated in parallel, a single mask on the calling threads
+    for (int label = 0; label < NumberOfLabels; ++label)
+    {
+      const FeatureListType features = multiLabelFeatures->CalculateFeatures(m_Image, m_Masks[label]);
+      CPPUNIT_ASSERT_EQUAL(features.size(), table[label + 1].size());
+      CompareFeatures(features, table[label + 1], std::set<std::string>());
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkGIFMultiLabelFeatures)
@@ -0,0 +1,153 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include <itkMultiScaleVoxelFeatureImageFilter.h>
+#include <itkTensorEigenValues.h>
+#include <itkImageRegionIterator.h>
+
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+#include <vnl/vnl_matrix.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+class mitkMultiScaleVoxelFeatureImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMultiScaleVoxelFeatureImageFilterTestSuite);
+  MITK_TEST(ComputeTensorEigenValues_SameAsVnl);
+  MITK_TEST(Update_OneSlicePerTile_SameAsWholeVolume);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<short, 3> ImageType;
+  typedef itk::MultiScaleVoxelFeatureImageFilter<ImageType> FilterType;
+
+  ImageType::Pointer m_Image;
+
+  /** Compares the closed form eigenvalues of the tensor (xx, xy, xz, yy, yz, zz) with those of vnl. */
+  void CheckEigenValues(const double tensor[6])
+  {
+    vnl_matrix<double> matrix(3, 3);
+    matrix(0, 0) = tensor[0];
+    matrix(0, 1) = matrix(1, 0) = tensor[1];
+    matrix(0, 2) = matrix(2, 0) = tensor[2];
+    matrix(1, 1) = tensor[3];
+    matrix(1, 2) = matrix(2, 1) = tensor[4];
+    matrix(2, 2) = tensor[5];
+    vnl_symmetric_eigensystem<double> eigenSystem(matrix);
+
+    double eigenValues[3];
+    itk::ComputeTensorEigenValues(tensor, eigenValues);
+
+    double scale = 1.0;
+    for (unsigned int i = 0; i < 6; ++i)
+      scale = std::max(scale, std::abs(tensor[i]));
+    // vnl returns the eigenvalues in ascending order, too
+    for (unsigned int i = 0; i < 3; ++i)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(eigenSystem.get_eigenvalue(i), eigenValues[i], 1e-6 * scale);
+  }
+
+public:
+  void setUp() override
+  {
+    std::srand(42);
+
+    ImageType::SizeType size;
+    size[0] = 17;
+    size[1] = 13;
+    size[2] = 40;
+    ImageType::SpacingType spacing;
+    spacing[0] = 1.0;
+    spacing[1] = 1.5;
+    spacing[2] = 2.0;
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions(size);
+    m_Image->SetSpacing(spacing);
+    m_Image->Allocate();
+    for (itk::ImageRegionIterator<ImageType> it(m_Image, m_Image->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it)
+      it.Set(static_cast<short>(std::rand() % 200));
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+  }
+
+  void ComputeTensorEigenValues_SameAsVnl()
+  {
+    const double zero[6] = { 0, 0, 0, 0, 0, 0 };
+    this->CheckEigenValues(zero);
+    const double diagonal[6] = { 3, 0, 0, -1, 0, 2 };
+    this->CheckEigenValues(diagonal);
+    // 2 * identity + v * v^T with v = (1, 1, 1), two equal eigenvalues
+    const double repeated[6] = { 3, 1, 1, 3, 1, 3 };
+    this->CheckEigenValues(repeated);
+
+    for (int n = 0; n < 1000; ++n)
+    {
+      double tensor[6];
+      for (unsigned int i = 0; i < 6; ++i)
+        tensor[i] = -100.0 + 200.0 * std::rand() / RAND_MAX;
+      this->CheckEigenValues(tensor);
+    }
+  }
+
+  void Update_OneSlicePerTile_SameAsWholeVolume()
+  {
+    FilterType::SigmaListType sigmas;
+    sigmas.push_back(0.5);
+    sigmas.push_back(1.0);
+
+    FilterType::Pointer filters[2];
+    for (unsigned int f = 0; f < 2; ++f)
+    {
+      filters[f] = FilterType::New();
+      filters[f]->SetInput(m_Image);
+      filters[f]->SetGaussianSigmas(sigmas);
+      filters[f]->SetDifferenceOfGaussianSigmas(sigmas);
+      filters[f]->SetLaplacianOfGaussianSigmas(sigmas);
+      filters[f]->SetHessianSigmas(sigmas);
+      filters[f]->SetStructureTensorSigmas(sigmas);
+    }
+    // tiles in the middle of the volume must neither touch the first nor the last slice
+    const unsigned int numberOfSlices = m_Image->GetLargestPossibleRegion().GetSize()[2];
+    CPPUNIT_ASSERT_MESSAGE("Halo has to be smaller than a third of the slices to test the tiling",
+                           3 * filters[1]->GetHaloSize() < numberOfSlices);
+    filters[0]->SetSlicesPerTile(numberOfSlices);
+    filters[1]->SetSlicesPerTile(1);
+    filters[0]->Update();
+    filters[1]->Update();
+
+    FilterType::OutputImageType* whole = filters[0]->GetOutput();
+    FilterType::OutputImageType* tiled = filters[1]->GetOutput();
+    const unsigned int numberOfFeatures = filters[0]->GetNumberOfFeatures();
+    CPPUNIT_ASSERT_EQUAL(numberOfFeatures, whole->GetNumberOfComponentsPerPixel());
+    CPPUNIT_ASSERT_EQUAL(numberOfFeatures, tiled->GetNumberOfComponentsPerPixel());
+
+    const std::size_t numberOfValues = m_Image->GetLargestPossibleRegion().GetNumberOfPixels() * numberOfFeatures;
+    const float* wholeBuffer = whole->GetBufferPointer();
+    const float* tiledBuffer = tiled->GetBufferPointer();
+    for (std::size_t i = 0; i < numberOfValues; ++i)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(wholeBuffer[i], tiledBuffer[i], 1e-3 * std::max(1.0f, std::abs(wholeBuffer[i])));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMultiScaleVoxelFeatureImageFilter)
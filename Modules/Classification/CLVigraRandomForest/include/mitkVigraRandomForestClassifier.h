@@ -24,6 +24,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vigra/random_forest.hxx>
 
 #include <mitkBaseData.h>
+#include <mitkImage.h>
+
+#include <functional>
+#include <vector>
 
 namespace mitk
 {
@@ -48,6 +52,27 @@ namespace mitk
     Eigen::MatrixXi Predict(const Eigen::MatrixXd &X);
     Eigen::MatrixXi WeightedPredict(const Eigen::MatrixXd &X);
 
+    ///
+    /// @brief Computes the feature images of the slices [firstSlice, firstSlice + numberOfSlices) of the volume.
+    /// Each returned image is a scalar image with the in-plane size of the volume and either numberOfSlices slices
+    /// (only the slab) or all slices of the volume (e.g. precomputed feature images, only the slab is read).
+    ///
+    typedef std::function< std::vector<mitk::Image::Pointer>(unsigned int firstSlice, unsigned int numberOfSlices) > SlabFeatureFunction;
+
+    ///
+    /// @brief Predict all voxels of a volume without building a feature matrix.
+    /// The features are requested slab by slab, converted to float blocks (one row per voxel) and the blocks are
+    /// classified in parallel. Labels and probabilities are written directly into the output images, so the memory
+    /// needed besides the outputs is bounded by the size of a slab.
+    /// @param mask, voxels with a value > 0 are classified. Defines the geometry of the outputs.
+    /// @param featureFunction, computes the features of a slab, see SlabFeatureFunction.
+    /// @param labels, output label image (int), 0 outside of the mask.
+    /// @param probabilities, output image with one float component per class, 0 outside of the mask.
+    /// @param slicesPerSlab, number of slices for which features are computed at once.
+    ///
+    void PredictSlabs(const mitk::Image* mask, const SlabFeatureFunction& featureFunction,
+                      mitk::Image::Pointer& labels, mitk::Image::Pointer& probabilities, unsigned int slicesPerSlab = 16);
+
     bool SupportsPointWiseWeight();
     bool SupportsPointWiseProbability();
     void ConvertParameter();
@@ -20,6 +20,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImpurityLoss.h>
 #include <mitkLinearSplitting.h>
 #include <mitkProperties.h>
+#include <mitkExceptionMacro.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkPixelTypeMultiplex.h>
 
 // Vigra includes
 #include <vigra/random_forest.hxx>
@@ -28,6 +32,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 // ITK include
 #include <itkFastMutexLock.h>
 #include <itkMultiThreader.h>
+#include <itkVectorImage.h>
+
+#include <algorithm>
+#include <memory>
 
 typedef mitk::ThresholdSplit<mitk::LinearSplitting< mitk::ImpurityLoss<> >,int,vigra::ClassificationTag> DefaultSplitType;
 
@@ -249,6 +257,145 @@ Eigen::MatrixXi mitk::VigraRandomForestClassifier::WeightedPredict(const Eigen::
   return m_OutLabel;
 }
 
+namespace
+{
+  // Rows of a feature block: slab offsets of the voxels and row length (number of features)
+  struct FeatureBlockLayout
+  {
+    const unsigned int * Offsets;
+    int NumberOfRows;
+    int NumberOfFeatures;
+  };
+
+  template <typename TPixel>
+  void CollectMaskedVoxels(const mitk::PixelType &, const void * mask, std::size_t numberOfVoxels, std::vector<unsigned int> * offsets)
+  {
+    const TPixel * values = static_cast<const TPixel *>(mask);
+    for (std::size_t i = 0; i < numberOfVoxels; ++i)
+      if (values[i] > 0)
+        offsets->push_back(static_cast<unsigned int>(i));
+  }
+
+  // Writes one feature of all voxels of a block into the column of the row-major float block
+  template <typename TPixel>
+  void CopyFeatureToBlock(const mitk::PixelType &, const void * feature, const FeatureBlockLayout * layout, float * column)
+  {
+    const TPixel * values = static_cast<const TPixel *>(feature);
+    for (int row = 0; row < layout->NumberOfRows; ++row)
+      column[row * layout->NumberOfFeatures] = static_cast<float>(values[layout->Offsets[row]]);
+  }
+}
+
+void mitk::VigraRandomForestClassifier::PredictSlabs(const mitk::Image* mask, const SlabFeatureFunction& featureFunction,
+                                                     mitk::Image::Pointer& labels, mitk::Image::Pointer& probabilities, unsigned int slicesPerSlab)
+{
+  if (mask == nullptr || !featureFunction)
+    mitkThrow() << "PredictSlabs needs a mask and a feature function.";
+
+  const int classCount = m_RandomForest.class_count();
+  const std::size_t sliceSize = static_cast<std::size_t>(mask->GetDimension(0)) * mask->GetDimension(1);
+  const unsigned int numberOfSlices = mask->GetDimension(2);
+  slicesPerSlab = std::max(1u, std::min(slicesPerSlab, numberOfSlices));
+
+  labels = mitk::Image::New();
+  labels->Initialize(mitk::MakeScalarPixelType<int>(), *mask->GetGeometry());
+  probabilities = mitk::Image::New();
+  probabilities->Initialize(mitk::MakePixelType< itk::VectorImage<float, 3> >(classCount), *mask->GetGeometry());
+
+  mitk::ImageReadAccessor maskAccessor(mask, mask->GetVolumeData(0));
+  mitk::ImageWriteAccessor labelAccessor(labels, labels->GetVolumeData(0));
+  mitk::ImageWriteAccessor probabilityAccessor(probabilities, probabilities->GetVolumeData(0));
+  const char * maskBuffer = static_cast<const char *>(maskAccessor.GetData());
+  int * labelBuffer = static_cast<int *>(labelAccessor.GetData());
+  float * probabilityBuffer = static_cast<float *>(probabilityAccessor.GetData());
+  std::fill(labelBuffer, labelBuffer + sliceSize * numberOfSlices, 0);
+  std::fill(probabilityBuffer, probabilityBuffer + sliceSize * numberOfSlices * classCount, 0.0f);
+
+  const mitk::PixelType maskPixelType = mask->GetPixelType();
+  const int rowsPerBlock = 4096;
+
+  for (unsigned int firstSlice = 0; firstSlice < numberOfSlices; firstSlice += slicesPerSlab)
+  {
+    const unsigned int slabSlices = std::min(slicesPerSlab, numberOfSlices - firstSlice);
+    const std::size_t slabOffset = firstSlice * sliceSize;
+    const std::size_t slabSize = slabSlices * sliceSize;
+
+    std::vector<unsigned int> offsets;
+    const void * slabMask = maskBuffer + slabOffset * maskPixelType.GetSize();
+    mitkPixelTypeMultiplex3(CollectMaskedVoxels, maskPixelType, slabMask, slabSize, &offsets);
+    if (offsets.empty())
+      continue;
+
+    // features of the slab; the accessors keep them locked until the slab is classified
+    std::vector<mitk::Image::Pointer> features = featureFunction(firstSlice, slabSlices);
+    const int numberOfFeatures = features.size();
+    std::vector< std::unique_ptr<mitk::ImageReadAccessor> > featureAccessors;
+    std::vector<const void *> featureBuffers;
+    std::vector<mitk::PixelType> featurePixelTypes;
+    for (const auto & feature : features)
+    {
+      if (feature.IsNull() || feature->GetPixelType().GetNumberOfComponents() != 1 ||
+          static_cast<std::size_t>(feature->GetDimension(0)) * feature->GetDimension(1) != sliceSize)
+        mitkThrow() << "Feature images have to be scalar images with the in-plane size of the mask.";
+
+      std::size_t featureOffset = 0;
+      if (feature->GetDimension(2) == numberOfSlices)
+        featureOffset = slabOffset;
+      else if (feature->GetDimension(2) != slabSlices)
+        mitkThrow() << "Feature images have to cover the slab or the whole volume.";
+
+      featureAccessors.emplace_back(new mitk::ImageReadAccessor(feature, feature->GetVolumeData(0)));
+      featurePixelTypes.push_back(feature->GetPixelType());
+      featureBuffers.push_back(static_cast<const char *>(featureAccessors.back()->GetData()) + featureOffset * featurePixelTypes.back().GetSize());
+    }
+
+    const int numberOfBlocks = (offsets.size() + rowsPerBlock - 1) / rowsPerBlock;
+#pragma omp parallel
+    {
+      // row-major block: all features of a voxel are contiguous, which is the access pattern of the trees
+      std::vector<float> block(rowsPerBlock * numberOfFeatures);
+      vigra::MultiArray<2, double> blockProbabilities(vigra::Shape2(rowsPerBlock, classCount));
+
+#pragma omp for schedule(dynamic, 1)
+      for (int blockIndex = 0; blockIndex < numberOfBlocks; ++blockIndex)
+      {
+        const int firstRow = blockIndex * rowsPerBlock;
+        FeatureBlockLayout layout;
+        layout.Offsets = &offsets[firstRow];
+        layout.NumberOfRows = std::min<int>(rowsPerBlock, offsets.size() - firstRow);
+        layout.NumberOfFeatures = numberOfFeatures;
+
+        for (int feature = 0; feature < numberOfFeatures; ++feature)
+        {
+          float * column = block.data() + feature;
+          mitkPixelTypeMultiplex3(CopyFeatureToBlock, featurePixelTypes[feature], featureBuffers[feature], &layout, column);
+        }
+
+        vigra::MultiArrayView<2, float, vigra::StridedArrayTag> X(vigra::Shape2(layout.NumberOfRows, numberOfFeatures),
+                                                                  vigra::Shape2(numberOfFeatures, 1), block.data());
+        vigra::MultiArrayView<2, double> P = blockProbabilities.subarray(vigra::Shape2(0, 0), vigra::Shape2(layout.NumberOfRows, classCount));
+        m_RandomForest.predictProbabilities(X, P);
+
+        for (int row = 0; row < layout.NumberOfRows; ++row)
+        {
+          const std::size_t voxel = slabOffset + layout.Offsets[row];
+          float * voxelProbabilities = probabilityBuffer + voxel * classCount;
+          int maxCol = 0;
+          for (int col = 0; col < classCount; ++col)
+          {
+            voxelProbabilities[col] = static_cast<float>(P(row, col));
+            if (P(row, col) > P(row, maxCol))
+              maxCol = col;
+          }
+          int label;
+          m_RandomForest.ext_param_.to_classlabel(maxCol, label);
+          labelBuffer[voxel] = label;
+        }
+      }
+    }
+  }
+}
+
 void mitk::VigraRandomForestClassifier::SetTreeWeights(Eigen::MatrixXd weights)
 {
   m_TreeWeights = weights;
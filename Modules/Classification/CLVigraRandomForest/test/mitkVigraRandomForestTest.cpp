@@ -26,12 +26,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkAddImageFilter.h>
 #include <mitkImageCast.h>
 #include <mitkStandaloneDataStorage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
 
 class mitkVigraRandomForestTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkVigraRandomForestTestSuite  );
   MITK_TEST(TrainThreadedDecisionForest_MatlabDataSet_shouldReturnTrue);
   MITK_TEST(TrainThreadedDecisionForest_BreastCancerDataSet_shouldReturnTrue);
+  MITK_TEST(PredictSlabs_BreastCancerDataSet_SameAsPredict);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -277,6 +280,60 @@ public:
     MITK_TEST_CONDITION(isIntervall<int>(m_TestYPredict,classes,97,99),"Testvalue is in range.");
   }
 
+  /*
+  Write the rows of the test matrix into the voxels of feature images (one image per column)
+  and classify them slab by slab. The result has to match the matrix based prediction.
+  */
+  void PredictSlabs_BreastCancerDataSet_SameAsPredict()
+  {
+    std::pair<MatrixDoubleType,MatrixDoubleType> matrixDouble;
+    matrixDouble = convertCSVToMatrix<double>(GetTestDataFilePath("Classification/FeaturematrixBreastcancer.csv"),';',0.5,true);
+    std::pair<MatrixIntType,MatrixIntType> matrixInt;
+    matrixInt = convertCSVToMatrix<int>(GetTestDataFilePath("Classification/LabelmatrixBreastcancer.csv"),';',0.5,false);
+
+    classifier = mitk::VigraRandomForestClassifier::New();
+    classifier->Train(matrixDouble.first, matrixInt.first);
+    Eigen::MatrixXi classes = classifier->Predict(matrixDouble.second);
+
+    const int rows = matrixDouble.second.rows();
+    unsigned int dimensions[3] = { 8, 4, static_cast<unsigned int>(rows / 32 + 2) };
+    const int numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+
+    mitk::Image::Pointer mask = mitk::Image::New();
+    mask->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 3, dimensions);
+    {
+      mitk::ImageWriteAccessor accessor(mask);
+      unsigned char* values = static_cast<unsigned char*>(accessor.GetData());
+      for (int i = 0; i < numberOfVoxels; ++i)
+        values[i] = i < rows ? 1 : 0;
+    }
+
+    std::vector<mitk::Image::Pointer> features;
+    for (int col = 0; col < matrixDouble.second.cols(); ++col)
+    {
+      mitk::Image::Pointer feature = mitk::Image::New();
+      feature->Initialize(mitk::MakeScalarPixelType<double>(), 3, dimensions);
+      mitk::ImageWriteAccessor accessor(feature);
+      double* values = static_cast<double*>(accessor.GetData());
+      for (int i = 0; i < numberOfVoxels; ++i)
+        values[i] = i < rows ? matrixDouble.second(i, col) : 0.0;
+      features.push_back(feature);
+    }
+
+    mitk::Image::Pointer labels, probabilities;
+    classifier->PredictSlabs(mask, [&features](unsigned int, unsigned int) { return features; }, labels, probabilities, 3);
+
+    mitk::ImageReadAccessor labelAccessor(labels);
+    const int* labelValues = static_cast<const int*>(labelAccessor.GetData());
+    int count = 0;
+    for (int i = 0; i < rows; ++i)
+      if (labelValues[i] == classes(i, 0))
+        count++;
+    MITK_TEST_CONDITION(count >= 0.99 * rows, "Slab-wise prediction matches the matrix based prediction.");
+    MITK_TEST_CONDITION(labelValues[numberOfVoxels - 1] == 0, "Voxels outside of the mask are not classified.");
+    MITK_TEST_CONDITION(static_cast<int>(probabilities->GetPixelType().GetNumberOfComponents()) == classifier->GetRandomForest().class_count(), "One probability per class.");
+  }
+
   void TestThreadedDecisionForest()
   {
   }
@@ -0,0 +1,75 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkTensorEigenValues_h__
+#define __itkTensorEigenValues_h__
+
+#include <cmath>
+
+namespace itk
+{
+
+/**
+  * \brief Closed form eigenvalues of a symmetric 3x3 matrix (trigonometric solution of the characteristic polynomial).
+  *
+  * The matrix is given by its upper triangle in the order of itk::DiffusionTensor3D: xx, xy, xz, yy, yz, zz.
+  * The eigenvalues are returned in ascending order, like itk::DiffusionTensor3D::ComputeEigenValues() does.
+  * No iterations and no allocations are needed, so this is meant to be called once per voxel.
+  */
+template< class TTensorValue, class TValue >
+void ComputeTensorEigenValues(const TTensorValue* tensor, TValue* eigenValues)
+{
+  const double xx = tensor[0], xy = tensor[1], xz = tensor[2];
+  const double yy = tensor[3], yz = tensor[4], zz = tensor[5];
+
+  const double offDiagonal = xy*xy + xz*xz + yz*yz;
+  const double q = (xx + yy + zz)/3.0;
+  const double a = xx-q, d = yy-q, f = zz-q;
+  const double p2 = a*a + d*d + f*f + 2.0*offDiagonal;
+
+  if (p2 <= 0 || offDiagonal <= 1e-30*p2)
+  {
+    // (numerically) diagonal matrix
+    double e0 = xx, e1 = yy, e2 = zz, t;
+    if (e0>e1) { t=e0; e0=e1; e1=t; }
+    if (e1>e2) { t=e1; e1=e2; e2=t; }
+    if (e0>e1) { t=e0; e0=e1; e1=t; }
+    eigenValues[0] = e0;
+    eigenValues[1] = e1;
+    eigenValues[2] = e2;
+    return;
+  }
+
+  const double p = std::sqrt(p2/6.0);
+  const double det = a*(d*f - yz*yz) - xy*(xy*f - yz*xz) + xz*(xy*yz - d*xz);
+  double r = det/(2.0*p*p*p);
+  if (r < -1)
+    r = -1;
+  else if (r > 1)
+    r = 1;
+
+  const double phi = std::acos(r)/3.0;
+  const double largest = q + 2.0*p*std::cos(phi);
+  const double smallest = q + 2.0*p*std::cos(phi + 2.0943951023931954923); // 2*pi/3
+
+  eigenValues[0] = smallest;
+  eigenValues[1] = 3.0*q - largest - smallest;
+  eigenValues[2] = largest;
+}
+
+}
+
+#endif //__itkTensorEigenValues_h__
@@ -49,6 +49,21 @@ public:
 
   typedef us::ServiceReference<IFileReader> ReaderReference;
 
+  /**
+   * @brief Counters for profiling the reader selection.
+   *
+   * @see GetLookupStatistics()
+   */
+  struct LookupStatistics
+  {
+    /** Calls of GetMimeTypeForFile() */
+    unsigned long mimeTypeLookups;
+    /** Calls of GetReferences(), including those from GetReaders() */
+    unsigned long referenceLookups;
+    /** Reference lookups answered from the cache */
+    unsigned long referenceCacheHits;
+  };
+
   FileReaderRegistry();
   ~FileReaderRegistry();
 
@@ -61,6 +76,12 @@ public:
    */
   static MimeType GetMimeTypeForFile(const std::string& path, us::ModuleContext* context = us::GetModuleContext());
 
+  /**
+   * @brief Get the references of all readers for the given mime-type.
+   *
+   * The references are cached per mime-type name. The cache is cleared
+   * whenever a reader service is registered, modified or unregistered.
+   */
   static std::vector<ReaderReference> GetReferences(const MimeType& mimeType, us::ModuleContext* context = us::GetModuleContext());
 
   mitk::IFileReader* GetReader(const ReaderReference& ref, us::ModuleContext* context = us::GetModuleContext());
@@ -70,6 +91,13 @@ public:
   void UngetReader(mitk::IFileReader* reader);
   void UngetReaders(const std::vector<mitk::IFileReader*>& readers);
 
+  /**
+   * @brief Get the lookup counters accumulated since the start of the
+   * application or the last call of ResetLookupStatistics().
+   */
+  static LookupStatistics GetLookupStatistics();
+  static void ResetLookupStatistics();
+
 private:
 
   // purposely not implemented
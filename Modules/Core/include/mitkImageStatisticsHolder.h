@@ -20,6 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImage.h"
 #include "mitkImageTimeSelector.h"
 
+#include <functional>
+#include <future>
+
 #ifndef __itkHistogram_h
 #include <itkHistogram.h>
 #endif
@@ -35,6 +38,11 @@ namespace mitk
 
   Each mitk::Image holds a normal pointer to its StatisticsHolder object. To get access to the methods, use the GetStatistics() method
   in mitk::Image class.
+
+  The extrema of scalar images are computed for all time steps at once, directly on the image buffer: blocks of voxels of all
+  time steps are distributed over the OpenMP threads. The results are cached per time step and recomputed only for time steps
+  that were computed before the last modification of the image. ComputeImageStatisticsAsynchronously() starts the computation
+  in a worker thread; the results are taken over by the next call of a getter or of IsComputingImageStatistics().
   */
 class MITKCORE_EXPORT ImageStatisticsHolder
 {
@@ -129,8 +137,34 @@ public:
 
     bool IsValidTimeStep( int t) const;
 
-    template < typename ItkImageType >
-      friend void _ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t);
+    //##Documentation
+    //## \brief Start computing the extrema of all time steps of a scalar image in a worker thread
+    //##
+    //## Returns immediately. The optional callback is called from the worker thread when the computation is finished,
+    //## the results are published to the getters in the thread that owns the image. Getters called in the meantime
+    //## wait for the computation.
+    void ComputeImageStatisticsAsynchronously( std::function<void()> finishedCallback = std::function<void()>() );
+
+    //##Documentation
+    //## \brief Whether an asynchronous computation is still running. Publishes its results if it has finished.
+    bool IsComputingImageStatistics();
+
+    //##Documentation
+    //## \brief Extrema of the values of one time step of a scalar image
+    struct Extrema
+    {
+      Extrema();
+
+      //## Combine with the extrema of another part of the same time step
+      void Merge( const Extrema& other );
+
+      ScalarType min;
+      ScalarType max;
+      ScalarType secondMin;
+      ScalarType secondMax;
+      unsigned int countOfMin;
+      unsigned int countOfMax;
+    };
 
     template < typename ItkImageType >
       friend void _ComputeExtremaInItkVectorImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t, unsigned int component);
@@ -145,6 +179,24 @@ protected:
 
       ImageTimeSelector::Pointer GetTimeSelector();
 
+      //##Documentation
+      //## \brief Whether the extrema of time step t were computed after the last modification of the image
+      bool HasValidExtrema( int t ) const;
+
+      //##Documentation
+      //## \brief Compute the extrema of all time steps of a scalar image in parallel (only the given volumes need to be set)
+      static std::vector<Extrema> ComputeExtrema( const mitk::Image* image, const std::vector<ImageDataItem::Pointer>& volumes );
+
+      //##Documentation
+      //## \brief Volume data of all time steps, empty if the image is no scalar image
+      std::vector<ImageDataItem::Pointer> GetScalarVolumes() const;
+
+      void SetExtrema( int t, const Extrema& extrema );
+
+      //##Documentation
+      //## \brief Wait for the running asynchronous computation (if any) and publish its results
+      void FinishAsynchronousComputation();
+
       mitk::Image* m_Image;
 
       mutable itk::Object::Pointer m_HistogramGeneratorObject;
@@ -159,6 +211,12 @@ protected:
 
       itk::TimeStamp m_LastRecomputeTimeStamp;
 
+      //## time of the computation of the extrema of each time step
+      std::vector<itk::TimeStamp> m_ExtremaTimeStamps;
+
+      std::future< std::vector<Extrema> > m_AsynchronousExtrema;
+      itk::ModifiedTimeType m_AsynchronousExtremaImageMTime;
+
 };
 
 } //end namespace
@@ -0,0 +1,123 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkPlaneDirectionCache_h
+#define mitkPlaneDirectionCache_h
+
+#include <cmath>
+#include <list>
+
+namespace mitk {
+
+/**
+  * @brief Keeps one index per plane normal for spatial indices that answer
+  * plane queries (see SurfaceCuttingIndex and PointSetSlabIndex).
+  *
+  * A plane with the opposite normal is the same plane, so both normals share
+  * one entry. Up to GetMaximumNumberOfDirections() normals are kept; the
+  * least recently used one is replaced when a new normal is requested.
+  *
+  * TIndex is the per-direction data of the spatial index. The cache only
+  * manages the entries, filling a new entry is left to the spatial index.
+  */
+template <typename TIndex>
+class PlaneDirectionCache
+{
+public:
+  struct Direction
+  {
+    /** the normal the index was built for, of unit length */
+    double Normal[3];
+    TIndex Index;
+  };
+
+  PlaneDirectionCache()
+    : m_MaximumNumberOfDirections(4)
+  {
+  }
+
+  void SetMaximumNumberOfDirections(unsigned int maximumNumberOfDirections)
+  {
+    m_MaximumNumberOfDirections = maximumNumberOfDirections;
+    while (m_Directions.size() > 1 && m_Directions.size() > m_MaximumNumberOfDirections)
+      m_Directions.pop_back();
+  }
+
+  unsigned int GetMaximumNumberOfDirections() const
+  {
+    return m_MaximumNumberOfDirections;
+  }
+
+  /** \brief Number of plane normals for which an index is currently held. */
+  unsigned int GetNumberOfDirections() const
+  {
+    return static_cast<unsigned int>(m_Directions.size());
+  }
+
+  void Clear()
+  {
+    m_Directions.clear();
+  }
+
+  /**
+    * \brief Returns the entry for the given normal (of unit length).
+    *
+    * If neither the normal nor its opposite is cached, an entry is added
+    * (or the least recently used one is reused) and isNew is set to true; the
+    * caller then has to (re)build Direction::Index. The entry stays valid
+    * until the next call of GetDirection() or Clear(). Projections have to use
+    * Direction::Normal, which may be the opposite of the requested normal.
+    */
+  Direction& GetDirection(const double normal[3], bool& isNew)
+  {
+    // the list is kept in the order of use, most recently used first
+    for (typename std::list<Direction>::iterator it = m_Directions.begin(); it != m_Directions.end(); ++it)
+    {
+      const double dot = it->Normal[0] * normal[0] + it->Normal[1] * normal[1] + it->Normal[2] * normal[2];
+      if (std::abs(dot) > 1.0 - 1e-9)
+      {
+        m_Directions.splice(m_Directions.begin(), m_Directions, it);
+        isNew = false;
+        return m_Directions.front();
+      }
+    }
+
+    if (!m_Directions.empty() && m_Directions.size() >= m_MaximumNumberOfDirections)
+    {
+      // reuse the storage of the least recently used entry
+      m_Directions.splice(m_Directions.begin(), m_Directions, --m_Directions.end());
+    }
+    else
+    {
+      m_Directions.push_front(Direction());
+    }
+
+    Direction& direction = m_Directions.front();
+    direction.Normal[0] = normal[0];
+    direction.Normal[1] = normal[1];
+    direction.Normal[2] = normal[2];
+    isNew = true;
+    return direction;
+  }
+
+private:
+  unsigned int m_MaximumNumberOfDirections;
+  std::list<Direction> m_Directions;
+};
+
+} // namespace mitk
+
+#endif /* mitkPlaneDirectionCache_h */
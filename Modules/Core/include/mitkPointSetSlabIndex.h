@@ -0,0 +1,108 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkPointSetSlabIndex_h
+#define mitkPointSetSlabIndex_h
+
+#include <MitkCoreExports.h>
+#include <mitkCommon.h>
+#include <mitkPlaneDirectionCache.h>
+#include <mitkPointSet.h>
+#include <itkObject.h>
+
+#include <vector>
+
+namespace mitk {
+
+class PlaneGeometry;
+
+/**
+  * @brief Spatial index to find the points of a PointSet close to a plane.
+  *
+  * The index keeps the points of one time step in world coordinates (i.e.
+  * with the transform of the point set's geometry applied), together with
+  * their ids and selection state. For every plane normal that is queried,
+  * the points are sorted by their projection onto the normal, so that a
+  * query for a plane position only visits the points of the slab
+  * [position - distance, position + distance].
+  *
+  * The index is meant to be shared by all renderers that show the same
+  * point set (e.g. the three 2D render windows). Everything is rebuilt as
+  * soon as the point set, the time step or the geometry transform changes.
+  * The sorted points of the normals in use are held by a PlaneDirectionCache.
+  *
+  * @ingroup Mapper
+  */
+class MITKCORE_EXPORT PointSetSlabIndex : public itk::Object
+{
+public:
+  mitkClassMacroItkParent(PointSetSlabIndex, itk::Object);
+  itkFactorylessNewMacro(Self)
+
+  /** \brief Set the point set and the time step to index. */
+  void SetInput(const PointSet* pointSet, int timeStep = 0);
+
+  void SetMaximumNumberOfDirections(unsigned int maximumNumberOfDirections);
+  unsigned int GetMaximumNumberOfDirections() const;
+
+  /** \brief Number of plane normals for which an index is currently held. */
+  unsigned int GetNumberOfDirections() const;
+
+  /** \brief Number of indexed points. Positions are counted in the order of the point set. */
+  std::size_t GetNumberOfPoints() const;
+
+  /** \brief World coordinates of the point at the given position. */
+  const Point3D& GetWorldPoint(std::size_t position) const;
+  PointSet::PointIdentifier GetPointId(std::size_t position) const;
+  bool IsPointSelected(std::size_t position) const;
+
+  /**
+    * \brief Collects the positions (in ascending order) of all points whose
+    * distance to the plane is less than maxDistance.
+    *
+    * For planes that are not flat (AbstractTransformGeometry) all points are
+    * tested.
+    */
+  void FindPointsNearPlane(const PlaneGeometry* plane, ScalarType maxDistance, std::vector<std::size_t>& positions);
+
+protected:
+  PointSetSlabIndex();
+  virtual ~PointSetSlabIndex();
+
+private:
+  struct DirectionIndex
+  {
+    /** projections onto Normal in ascending order and the positions they belong to */
+    std::vector<double> Projections;
+    std::vector<std::size_t> Positions;
+  };
+
+  void BuildDirectionIndex(DirectionIndex& index, const double normal[3]);
+  void BuildPoints();
+
+  PointSet::ConstPointer m_Input;
+  int m_TimeStep;
+  unsigned long m_InputMTime;
+
+  std::vector<Point3D> m_WorldPoints;
+  std::vector<PointSet::PointIdentifier> m_PointIds;
+  std::vector<bool> m_Selected;
+  PlaneDirectionCache<DirectionIndex> m_Indices;
+};
+
+} // namespace mitk
+
+#endif /* mitkPointSetSlabIndex_h */
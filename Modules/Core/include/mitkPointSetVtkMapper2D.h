@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkVtkMapper.h"
 #include "mitkBaseRenderer.h"
 #include "mitkLocalStorageHandler.h"
+#include "mitkPointSetSlabIndex.h"
 
 //VTK
 #include <vtkSmartPointer.h>
@@ -32,7 +33,7 @@ class vtkPropAssembly;
 class vtkPolyData;
 class vtkPolyDataMapper;
 class vtkGlyphSource2D;
-class vtkGlyph3D;
+class vtkGlyph3DMapper;
 class vtkFloatArray;
 class vtkCellArray;
 
@@ -60,6 +61,11 @@ namespace mitk {
   * Then the three Actors are combined inside a vtkPropAssembly and this
   * object is returned in GetProp() and so hooked up into the rendering
   * pipeline.
+  *
+  * The points are drawn as instanced glyphs (vtkGlyph3DMapper). Unless a
+  * contour is shown, only the points close to the current slice are visited:
+  * a PointSetSlabIndex, shared by all renderers, keeps the points sorted
+  * along the plane normals in use.
 
   * Properties that can be set for point sets and influence the PointSetVTKMapper2D are:
   *
@@ -141,9 +147,9 @@ namespace mitk {
       vtkSmartPointer<vtkGlyphSource2D> m_UnselectedGlyphSource2D;
       vtkSmartPointer<vtkGlyphSource2D> m_SelectedGlyphSource2D;
 
-      // glyph
-      vtkSmartPointer<vtkGlyph3D> m_UnselectedGlyph3D;
-      vtkSmartPointer<vtkGlyph3D> m_SelectedGlyph3D;
+      // glyph mappers (one instance of the glyph source per point)
+      vtkSmartPointer<vtkGlyph3DMapper> m_UnselectedGlyph3DMapper;
+      vtkSmartPointer<vtkGlyph3DMapper> m_SelectedGlyph3DMapper;
 
       // polydata
       vtkSmartPointer<vtkPolyData> m_VtkUnselectedPointListPolyData;
@@ -160,9 +166,14 @@ namespace mitk {
       std::vector < vtkSmartPointer<vtkTextActor> > m_VtkTextDistanceActors;
       std::vector < vtkSmartPointer<vtkTextActor> > m_VtkTextAngleActors;
 
+      // text actors are reused by subsequent calls of CreateVTKRenderObjects
+      std::vector < vtkSmartPointer<vtkTextActor> > m_VtkTextActorPool;
+      unsigned int m_NumberOfUsedTextActors;
+
+      // positions (in the point set) of the points rendered in the last call
+      std::vector<std::size_t> m_VisiblePositions;
+
       // mappers
-      vtkSmartPointer<vtkPolyDataMapper> m_VtkUnselectedPolyDataMapper;
-      vtkSmartPointer<vtkPolyDataMapper> m_VtkSelectedPolyDataMapper;
       vtkSmartPointer<vtkPolyDataMapper> m_VtkContourPolyDataMapper;
 
       // propassembly
@@ -201,6 +212,12 @@ namespace mitk {
     * PlaneGeometry is applied to the orienation of the glyphs. */
     virtual void CreateVTKRenderObjects(mitk::BaseRenderer* renderer);
 
+    /* \brief Returns an unused text actor from the pool of the local storage */
+    vtkTextActor* GetNextTextActor(LocalStorage* ls);
+
+    /* \brief Points of the input in world coordinates, sorted along the normals of the rendered planes */
+    PointSetSlabIndex::Pointer m_PointIndex;
+
     // member variables holding the current value of the properties used in this mapper
     bool m_ShowContour;             // "show contour" property
     bool m_CloseContour;            // "close contour" property
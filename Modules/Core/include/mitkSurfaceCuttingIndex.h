@@ -0,0 +1,104 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkSurfaceCuttingIndex_h
+#define mitkSurfaceCuttingIndex_h
+
+#include <MitkCoreExports.h>
+#include <mitkCommon.h>
+#include <mitkPlaneDirectionCache.h>
+#include <itkObject.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <vector>
+
+class vtkPolyData;
+
+namespace mitk {
+
+/**
+  * @brief Spatial index to speed up cutting a vtkPolyData with planes.
+  *
+  * For every plane normal that is queried, the index stores the extent of all
+  * cells along the normal and sorts the cells into equally sized slabs. A
+  * query for a plane position only visits the cells of one slab and returns
+  * a poly data that contains exactly those cells that intersect the plane.
+  * Feeding this subset instead of the complete poly data into a vtkCutter
+  * produces the same contour, but the cost of cutting becomes proportional
+  * to the number of cells actually cut.
+  *
+  * The index is meant to be shared by all renderers that show the same
+  * surface (e.g. the three 2D render windows). All slabs are dropped as soon
+  * as the input or its modification time changes. The slabs of the normals
+  * in use are held by a PlaneDirectionCache.
+  *
+  * @ingroup Mapper
+  */
+class MITKCORE_EXPORT SurfaceCuttingIndex : public itk::Object
+{
+public:
+  mitkClassMacroItkParent(SurfaceCuttingIndex, itk::Object);
+  itkFactorylessNewMacro(Self)
+
+  /** \brief Set the poly data that will be cut (already in world coordinates). */
+  void SetInput(vtkPolyData* polyData);
+  vtkPolyData* GetInput() const;
+
+  void SetMaximumNumberOfDirections(unsigned int maximumNumberOfDirections);
+  unsigned int GetMaximumNumberOfDirections() const;
+
+  /** \brief Number of plane normals for which an index is currently held. */
+  unsigned int GetNumberOfDirections() const;
+
+  /**
+    * \brief Returns all cells of the input that intersect the plane given by origin and normal.
+    *
+    * Point and cell data of the input are passed to the result. The index for
+    * the given normal is built on first use.
+    */
+  vtkSmartPointer<vtkPolyData> ExtractCellsIntersectingPlane(const double origin[3], const double normal[3]);
+
+protected:
+  SurfaceCuttingIndex();
+  virtual ~SurfaceCuttingIndex();
+
+private:
+  struct DirectionIndex
+  {
+    double RangeMin;
+    double SlabWidth;
+    std::vector<double> CellMin;
+    std::vector<double> CellMax;
+    /** offsets into SlabCells, one entry per slab plus one */
+    std::vector<vtkIdType> SlabOffsets;
+    std::vector<vtkIdType> SlabCells;
+  };
+
+  void BuildDirectionIndex(DirectionIndex& index, const double normal[3]);
+  void ClearIndices();
+
+  vtkSmartPointer<vtkPolyData> m_Input;
+  unsigned long m_InputMTime;
+  PlaneDirectionCache<DirectionIndex> m_Indices;
+  /** maps input point ids to output point ids during extraction, -1 if unused */
+  std::vector<vtkIdType> m_PointMap;
+};
+
+} // namespace mitk
+
+#endif /* mitkSurfaceCuttingIndex_h */
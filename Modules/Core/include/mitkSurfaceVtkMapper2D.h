@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkVtkMapper.h"
 #include "mitkBaseRenderer.h"
 #include "mitkLocalStorageHandler.h"
+#include "mitkSurfaceCuttingIndex.h"
 
 //VTK
 #include <vtkSmartPointer.h>
@@ -32,6 +33,7 @@ class vtkLookupTable;
 class vtkGlyph3D;
 class vtkArrowSource;
 class vtkReverseSense;
+class vtkTransformPolyDataFilter;
 
 namespace mitk {
 
@@ -43,7 +45,9 @@ class Surface;
   * The mapper uses a vtkCutter filter to cut out slices (contours) of the 3D
   * volume and render these slices as vtkPolyData. The data is transformed
   * according to its geometry before cutting, to support the geometry concept
-  * of MITK.
+  * of MITK. The transformed data is indexed by a SurfaceCuttingIndex that is
+  * shared by all render windows, so only the cells intersecting the current
+  * plane are passed to the cutter.
   *
   * Properties:
   * \b Surface.2D.Line Width: Thickness of the rendered lines in 2D.
@@ -204,6 +208,16 @@ protected:
      * @param renderer The respective renderer of the mitkRenderWindow.
      */
   void Update(BaseRenderer* renderer) override;
+
+  /**
+     * @brief m_TransformFilter Transforms the surface into world coordinates, shared by all renderers.
+     */
+  vtkSmartPointer<vtkTransformPolyDataFilter> m_TransformFilter;
+
+  /**
+     * @brief m_CuttingIndex Spatial index over the transformed surface, shared by all renderers.
+     */
+  SurfaceCuttingIndex::Pointer m_CuttingIndex;
 };
 } // namespace mitk
 #endif /* mitkSurfaceVtkMapper2D_h */
@@ -17,8 +17,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkHistogramGenerator.h"
 //#include "mitkImageTimeSelector.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkPixelTypeMultiplex.h"
 #include <mitkProperties.h>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
 mitk::ImageStatisticsHolder::ImageStatisticsHolder( mitk::Image* image)
   : m_Image(image)/*, m_TimeSelectorForExtremaObject(NULL)*/
 {
@@ -28,6 +35,8 @@ mitk::ImageStatisticsHolder::ImageStatisticsHolder( mitk::Image* image)
   m_ScalarMax.resize(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
   m_Scalar2ndMin.resize(1, itk::NumericTraits<ScalarType>::max());
   m_Scalar2ndMax.resize(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
+  m_ExtremaTimeStamps.resize(1);
+  m_AsynchronousExtremaImageMTime = 0;
 
   mitk::HistogramGenerator::Pointer generator = mitk::HistogramGenerator::New();
   m_HistogramGeneratorObject = generator;
@@ -40,6 +49,10 @@ mitk::ImageStatisticsHolder::ImageStatisticsHolder( mitk::Image* image)
 
 mitk::ImageStatisticsHolder::~ImageStatisticsHolder()
 {
+  // the worker keeps the image alive until its results are set, so this does not block if the
+  // worker released the last reference of the image
+  if (m_AsynchronousExtrema.valid())
+    m_AsynchronousExtrema.wait();
   m_HistogramGeneratorObject = nullptr;
   //m_TimeSelectorForExtremaObject = NULL;
   //m_Image = NULL;
@@ -94,6 +107,7 @@ void mitk::ImageStatisticsHolder::Expand( unsigned int timeSteps )
     m_Scalar2ndMax.resize(timeSteps, itk::NumericTraits<ScalarType>::NonpositiveMin());
     m_CountOfMinValuedVoxels.resize(timeSteps, 0);
     m_CountOfMaxValuedVoxels.resize(timeSteps, 0);
+    m_ExtremaTimeStamps.resize(timeSteps);
   }
 }
 
@@ -105,93 +119,245 @@ void mitk::ImageStatisticsHolder::ResetImageStatistics()
   m_Scalar2ndMax.assign(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
   m_CountOfMinValuedVoxels.assign(1, 0);
   m_CountOfMaxValuedVoxels.assign(1, 0);
+  m_ExtremaTimeStamps.assign(1, itk::TimeStamp());
 }
 
+bool mitk::ImageStatisticsHolder::HasValidExtrema( int t ) const
+{
+  return t >= 0 && static_cast<unsigned int>(t) < m_ExtremaTimeStamps.size() &&
+      m_ExtremaTimeStamps[t].GetMTime() > m_Image->GetMTime();
+}
 
-#include "mitkImageAccessByItk.h"
+void mitk::ImageStatisticsHolder::SetExtrema( int t, const Extrema& extrema )
+{
+  m_ScalarMin[t] = extrema.min;
+  m_ScalarMax[t] = extrema.max;
+  m_Scalar2ndMin[t] = extrema.secondMin;
+  m_Scalar2ndMax[t] = extrema.secondMax;
+  m_CountOfMinValuedVoxels[t] = extrema.countOfMin;
+  m_CountOfMaxValuedVoxels[t] = extrema.countOfMax;
+  m_ExtremaTimeStamps[t].Modified();
+}
 
-//#define BOUNDINGOBJECT_IGNORE
+mitk::ImageStatisticsHolder::Extrema::Extrema()
+  : min(itk::NumericTraits<ScalarType>::max())
+  , max(itk::NumericTraits<ScalarType>::NonpositiveMin())
+  , secondMin(itk::NumericTraits<ScalarType>::max())
+  , secondMax(itk::NumericTraits<ScalarType>::NonpositiveMin())
+  , countOfMin(0)
+  , countOfMax(0)
+{
+}
 
-template < typename ItkImageType >
-void mitk::_ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t)
+void mitk::ImageStatisticsHolder::Extrema::Merge( const Extrema& other )
 {
-  typename ItkImageType::RegionType region;
-  region = itkImage->GetBufferedRegion();
-  if(region.Crop(itkImage->GetRequestedRegion()) == false) return;
-  if(region != itkImage->GetRequestedRegion()) return;
+  const ScalarType mergedMin = std::min(min, other.min);
+  const ScalarType mergedMax = std::max(max, other.max);
+
+  // the second smallest value is the smallest of both minima and both second minima that is larger than the minimum.
+  // Parts without values contribute the initial values, which are never smaller (larger) than a real value.
+  const ScalarType minCandidates[4] = { min, secondMin, other.min, other.secondMin };
+  const ScalarType maxCandidates[4] = { max, secondMax, other.max, other.secondMax };
+  ScalarType mergedSecondMin = itk::NumericTraits<ScalarType>::max();
+  ScalarType mergedSecondMax = itk::NumericTraits<ScalarType>::NonpositiveMin();
+  for (int i = 0; i < 4; ++i)
+  {
+    if (minCandidates[i] > mergedMin && minCandidates[i] < mergedSecondMin)
+      mergedSecondMin = minCandidates[i];
+    if (maxCandidates[i] < mergedMax && maxCandidates[i] > mergedSecondMax)
+      mergedSecondMax = maxCandidates[i];
+  }
 
-  itk::ImageRegionConstIterator<ItkImageType> it(itkImage, region);
-  typedef typename ItkImageType::PixelType TPixel;
-  TPixel value = 0;
+  countOfMin = (min == mergedMin ? countOfMin : 0) + (other.min == mergedMin ? other.countOfMin : 0);
+  countOfMax = (max == mergedMax ? countOfMax : 0) + (other.max == mergedMax ? other.countOfMax : 0);
+  min = mergedMin;
+  max = mergedMax;
+  secondMin = mergedSecondMin;
+  secondMax = mergedSecondMax;
+}
 
-  if ( statisticsHolder == nullptr || !statisticsHolder->IsValidTimeStep( t ) ) return;
-  statisticsHolder->Expand(t+1); // make sure we have initialized all arrays
-  statisticsHolder->m_CountOfMinValuedVoxels[t] = 0;
-  statisticsHolder->m_CountOfMaxValuedVoxels[t] = 0;
 
-  statisticsHolder->m_Scalar2ndMin[t]=
-      statisticsHolder->m_ScalarMin[t] = itk::NumericTraits<ScalarType>::max();
-  statisticsHolder->m_Scalar2ndMax[t]=
-      statisticsHolder->m_ScalarMax[t] = itk::NumericTraits<ScalarType>::NonpositiveMin();
+#include "mitkImageAccessByItk.h"
 
-  while( !it.IsAtEnd() )
+//#define BOUNDINGOBJECT_IGNORE
+
+namespace
+{
+  // Extrema of count values of a scalar buffer. Two passes over a block that fits into the cache: the first one finds
+  // the extrema, the second one counts them and finds the second extrema. Both loops are free of branches, so the
+  // compiler can vectorize them. NaNs fail all comparisons and are ignored.
+  template < typename TPixel >
+  void _ComputeExtremaInBuffer( const mitk::PixelType&, const void* buffer, std::size_t count, mitk::ImageStatisticsHolder::Extrema* extrema )
   {
-    value = it.Get();
-    //  if ( (value > mitkImage->m_ScalarMin) && (value < mitkImage->m_Scalar2ndMin) )        mitkImage->m_Scalar2ndMin = value;
-    //  else if ( (value < mitkImage->m_ScalarMax) && (value > mitkImage->m_Scalar2ndMax) )   mitkImage->m_Scalar2ndMax = value;
-    //  else if (value > mitkImage->m_ScalarMax)                                              mitkImage->m_ScalarMax = value;
-    //  else if (value < mitkImage->m_ScalarMin)                                              mitkImage->m_ScalarMin = value;
+    const TPixel* values = static_cast<const TPixel*>(buffer);
 
-    // if numbers start with 2ndMin or 2ndMax and never have that value again, the previous above logic failed
-#ifdef BOUNDINGOBJECT_IGNORE
-    if( value > -32765)
+    TPixel min = itk::NumericTraits<TPixel>::max();
+    TPixel max = itk::NumericTraits<TPixel>::NonpositiveMin();
+    for (std::size_t i = 0; i < count; ++i)
     {
-#endif
-      // update min
-      if ( value < statisticsHolder->m_ScalarMin[t] )
-      {
-        statisticsHolder->m_Scalar2ndMin[t] =
-            statisticsHolder->m_ScalarMin[t];    statisticsHolder->m_ScalarMin[t] = value;
-        statisticsHolder->m_CountOfMinValuedVoxels[t] = 1;
-      }
-      else if ( value == statisticsHolder->m_ScalarMin[t] )
-      {
-        ++statisticsHolder->m_CountOfMinValuedVoxels[t];
-      }
-      else if ( value < statisticsHolder->m_Scalar2ndMin[t] )
-      {
-        statisticsHolder->m_Scalar2ndMin[t] = value;
-      }
+      const TPixel value = values[i];
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    if (min > max) return; // no (valid) values
 
-      // update max
-      if ( value > statisticsHolder->m_ScalarMax[t] )
-      {
-        statisticsHolder->m_Scalar2ndMax[t] =
-            statisticsHolder->m_ScalarMax[t];    statisticsHolder->m_ScalarMax[t] = value;
-        statisticsHolder->m_CountOfMaxValuedVoxels[t] = 1;
-      }
-      else if ( value == statisticsHolder->m_ScalarMax[t] )
-      {
-        ++statisticsHolder->m_CountOfMaxValuedVoxels[t];
-      }
-      else if ( value > statisticsHolder->m_Scalar2ndMax[t] )
-      {
-        statisticsHolder->m_Scalar2ndMax[t] = value;
-      }
-#ifdef BOUNDINGOBJECT_IGNORE
+    TPixel secondMin = itk::NumericTraits<TPixel>::max();
+    TPixel secondMax = itk::NumericTraits<TPixel>::NonpositiveMin();
+    unsigned int countOfMin = 0;
+    unsigned int countOfMax = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const TPixel value = values[i];
+      countOfMin += value == min;
+      countOfMax += value == max;
+      secondMin = (value > min && value < secondMin) ? value : secondMin;
+      secondMax = (value < max && value > secondMax) ? value : secondMax;
     }
-#endif
 
-    ++it;
+    extrema->min = min;
+    extrema->max = max;
+    extrema->secondMin = secondMin;
+    extrema->secondMax = secondMax;
+    extrema->countOfMin = countOfMin;
+    extrema->countOfMax = countOfMax;
   }
+}
 
-  //// guard for wrong 2dMin/Max on single constant value images
-  if (statisticsHolder->m_ScalarMax[t] == statisticsHolder->m_ScalarMin[t])
+std::vector<mitk::ImageStatisticsHolder::Extrema> mitk::ImageStatisticsHolder::ComputeExtrema( const mitk::Image* image,
+    const std::vector<ImageDataItem::Pointer>& volumes )
+{
+  std::vector<Extrema> extrema(volumes.size());
+  if (volumes.empty()) return extrema;
+
+  const mitk::PixelType pixelType = image->GetPixelType(0);
+  const std::size_t pixelSize = pixelType.GetSize();
+  const std::size_t numberOfValues = static_cast<std::size_t>(image->GetDimension(0)) * image->GetDimension(1) * image->GetDimension(2);
+
+  // lock all time steps for reading before the threads start
+  std::vector< std::unique_ptr<ImageReadAccessor> > accessors;
+  std::vector<const char*> buffers(volumes.size(), nullptr);
+  for (std::size_t t = 0; t < volumes.size(); ++t)
   {
-    statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMax[t];
+    if (volumes[t].IsNull()) continue;
+    accessors.emplace_back(new ImageReadAccessor(image, volumes[t].GetPointer()));
+    buffers[t] = static_cast<const char*>(accessors.back()->GetData());
   }
-  statisticsHolder->m_LastRecomputeTimeStamp.Modified();
-  //MITK_DEBUG <<"extrema "<<itk::NumericTraits<TPixel>::NonpositiveMin()<<" "<<mitkImage->m_ScalarMin<<" "<<mitkImage->m_Scalar2ndMin<<" "<<mitkImage->m_Scalar2ndMax<<" "<<mitkImage->m_ScalarMax<<" "<<itk::NumericTraits<TPixel>::max();
+
+  // blocks of all time steps are processed concurrently, a block fits into the cache for the second pass
+  const std::size_t valuesPerBlock = 32768;
+  const int blocksPerTimeStep = static_cast<int>((numberOfValues + valuesPerBlock - 1) / valuesPerBlock);
+  const int numberOfBlocks = blocksPerTimeStep * static_cast<int>(volumes.size());
+  std::vector<Extrema> blockExtrema(numberOfBlocks);
+
+#pragma omp parallel for schedule(dynamic, 4)
+  for (int block = 0; block < numberOfBlocks; ++block)
+  {
+    const char* buffer = buffers[block / blocksPerTimeStep];
+    if (buffer == nullptr) continue;
+
+    const std::size_t first = static_cast<std::size_t>(block % blocksPerTimeStep) * valuesPerBlock;
+    const std::size_t count = std::min(valuesPerBlock, numberOfValues - first);
+    const void* values = buffer + first * pixelSize;
+    Extrema* result = &blockExtrema[block];
+    mitkPixelTypeMultiplex3( _ComputeExtremaInBuffer, pixelType, values, count, result );
+  }
+
+  for (std::size_t t = 0; t < volumes.size(); ++t)
+  {
+    for (int block = 0; block < blocksPerTimeStep; ++block)
+      extrema[t].Merge(blockExtrema[t * blocksPerTimeStep + block]);
+
+    //// guard for wrong 2dMin/Max on single constant value images
+    if (extrema[t].max == extrema[t].min)
+      extrema[t].secondMax = extrema[t].secondMin = extrema[t].max;
+  }
+  return extrema;
+}
+
+std::vector<mitk::ImageDataItem::Pointer> mitk::ImageStatisticsHolder::GetScalarVolumes() const
+{
+  std::vector<ImageDataItem::Pointer> volumes;
+  const mitk::PixelType pType = m_Image->GetPixelType(0);
+  if (pType.GetNumberOfComponents() != 1 || pType.GetPixelType() == itk::ImageIOBase::UNKNOWNPIXELTYPE ||
+      pType.GetPixelType() == itk::ImageIOBase::VECTOR)
+    return volumes;
+
+  const int timeSteps = m_Image->GetTimeSteps();
+  for (int t = 0; t < timeSteps; ++t)
+    volumes.push_back(m_Image->GetVolumeData(t));
+  return volumes;
+}
+
+void mitk::ImageStatisticsHolder::ComputeImageStatisticsAsynchronously( std::function<void()> finishedCallback )
+{
+  this->FinishAsynchronousComputation();
+
+  std::vector<ImageDataItem::Pointer> volumes = this->GetScalarVolumes();
+  if (volumes.empty())
+  {
+    if (finishedCallback) finishedCallback();
+    return;
+  }
+  Expand(static_cast<unsigned int>(volumes.size()));
+
+  // The worker holds a reference to the image, so the image cannot be deleted while its buffer is read.
+  // The reference is released after the results are set, which is why the destructor never waits for
+  // a worker that holds the last reference.
+  auto promise = std::make_shared< std::promise< std::vector<Extrema> > >();
+  m_AsynchronousExtrema = promise->get_future();
+  m_AsynchronousExtremaImageMTime = m_Image->GetMTime();
+  mitk::Image::ConstPointer image = m_Image;
+
+  std::thread worker( [promise, image, volumes, finishedCallback]() mutable
+  {
+    try
+    {
+      promise->set_value(ComputeExtrema(image, volumes));
+    }
+    catch (...)
+    {
+      promise->set_exception(std::current_exception());
+    }
+    if (finishedCallback) finishedCallback();
+    volumes.clear();
+    image = nullptr;
+  });
+  worker.detach();
+}
+
+bool mitk::ImageStatisticsHolder::IsComputingImageStatistics()
+{
+  if (!m_AsynchronousExtrema.valid()) return false;
+  if (m_AsynchronousExtrema.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return true;
+
+  this->FinishAsynchronousComputation();
+  return false;
+}
+
+void mitk::ImageStatisticsHolder::FinishAsynchronousComputation()
+{
+  if (!m_AsynchronousExtrema.valid()) return;
+
+  std::vector<Extrema> extrema;
+  try
+  {
+    extrema = m_AsynchronousExtrema.get();
+  }
+  catch (const std::exception& e)
+  {
+    MITK_WARN << "Computing the image statistics failed: " << e.what();
+    return;
+  }
+
+  // results for a modified image are dropped, they are recomputed on demand
+  if (extrema.empty() || m_Image->GetMTime() > m_AsynchronousExtremaImageMTime) return;
+
+  if (m_Image->GetMTime() > m_LastRecomputeTimeStamp.GetMTime())
+    this->ResetImageStatistics();
+  Expand(static_cast<unsigned int>(extrema.size()));
+  for (std::size_t t = 0; t < extrema.size(); ++t)
+    SetExtrema(static_cast<int>(t), extrema[t]);
+  m_LastRecomputeTimeStamp.Modified();
 }
 
 template < typename ItkImageType >
@@ -280,6 +446,9 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int com
   // timestep valid?
   if (!m_Image->IsValidTimeStep(t)) return;
 
+  // publish or wait for a running asynchronous computation
+  this->FinishAsynchronousComputation();
+
   // image modified?
   if (this->m_Image->GetMTime() > m_LastRecomputeTimeStamp.GetMTime())
     this->ResetImageStatistics();
@@ -287,23 +456,18 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int com
   Expand(t+1);
 
   // do we have valid information already?
-  if( m_ScalarMin[t] != itk::NumericTraits<ScalarType>::max() ||
-      m_Scalar2ndMin[t] != itk::NumericTraits<ScalarType>::max() ) return; // Values already calculated before...
+  if (this->HasValidExtrema(t)) return; // Values already calculated before...
 
   // used to avoid statistics calculation on qball images. property will be replaced as soons as bug 17928 is merged and the diffusion image refactoring is complete.
   mitk::BoolProperty* isqball = dynamic_cast< mitk::BoolProperty* >( m_Image->GetProperty( "IsQballImage" ).GetPointer() );
   const mitk::PixelType pType = m_Image->GetPixelType(0);
   if(pType.GetNumberOfComponents() == 1 && (pType.GetPixelType() != itk::ImageIOBase::UNKNOWNPIXELTYPE) && (pType.GetPixelType() != itk::ImageIOBase::VECTOR) )
   {
-    // recompute
-    mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
-    if(timeSelector.IsNotNull())
-    {
-      timeSelector->SetTimeNr(t);
-      timeSelector->UpdateLargestPossibleRegion();
-      const mitk::Image* image = timeSelector->GetOutput();
-      AccessByItk_2( image, _ComputeExtremaInItkImage, this, t );
-    }
+    // recompute all time steps at once
+    std::vector<Extrema> extrema = ComputeExtrema(m_Image, this->GetScalarVolumes());
+    Expand(static_cast<unsigned int>(extrema.size()));
+    for (std::size_t i = 0; i < extrema.size(); ++i)
+      SetExtrema(static_cast<int>(i), extrema[i]);
   }
   else if (pType.GetPixelType() == itk::ImageIOBase::VECTOR && (!isqball || !isqball->GetValue()))  // we have a vector image
   {
@@ -316,6 +480,7 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int com
         const mitk::Image* image = timeSelector->GetOutput();
         AccessVectorPixelTypeByItk_n( image, _ComputeExtremaInItkVectorImage, (this, t, component) );
       }
+      m_ExtremaTimeStamps[t].Modified();
   }
   else
   {
@@ -323,7 +488,9 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int com
     m_ScalarMax[t] = 255;
     m_Scalar2ndMin[t] = 0;
     m_Scalar2ndMax[t] = 255;
+    m_ExtremaTimeStamps[t].Modified();
   }
+  m_LastRecomputeTimeStamp.Modified();
 }
 
 
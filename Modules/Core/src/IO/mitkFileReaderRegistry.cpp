@@ -21,12 +21,185 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // Microservices
 #include <usGetModuleContext.h>
+#include <usModule.h>
 #include <usModuleContext.h>
 #include <usServiceProperties.h>
 #include <usLDAPProp.h>
+#include <usServiceEvent.h>
+#include <usModuleEvent.h>
 
 #include "itksys/SystemTools.hxx"
 
+#include <itkSimpleFastMutexLock.h>
+#include <itkMutexLockHolder.h>
+
+#include <set>
+
+namespace {
+
+/**
+ * Caches the reader references per module context and mime-type name, since
+ * the services visible to a context may differ (e.g. due to service hooks).
+ * A service listener on every looked up context clears the cache whenever a
+ * reader visible to that context is registered, modified or unregistered, a
+ * module listener on the core module context clears it before a module (and
+ * its context) goes away. The listeners are removed when their module is
+ * unloaded or when the cache is destroyed, whichever happens first.
+ */
+class ReaderReferenceCache
+{
+public:
+
+  typedef mitk::FileReaderRegistry::ReaderReference ReaderReference;
+  typedef std::pair<us::ModuleContext*, std::string> KeyType;
+
+  ReaderReferenceCache()
+    : m_ModuleListenerContext(NULL)
+    , m_Generation(0)
+  {
+    this->ResetStatistics();
+  }
+
+  ~ReaderReferenceCache()
+  {
+    for (auto context : m_ServiceListenerContexts)
+    {
+      context->RemoveServiceListener(this, &ReaderReferenceCache::ServiceChanged);
+    }
+    if (m_ModuleListenerContext != NULL)
+    {
+      m_ModuleListenerContext->RemoveModuleListener(this, &ReaderReferenceCache::ModuleChanged);
+    }
+  }
+
+  std::vector<ReaderReference> GetReferences(const std::string& mimeTypeName, us::ModuleContext* context)
+  {
+    unsigned long generation = 0;
+    {
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+      ++m_Statistics.referenceLookups;
+      if (m_ModuleListenerContext == NULL)
+      {
+        m_ModuleListenerContext = us::GetModuleContext();
+        m_ModuleListenerContext->AddModuleListener(this, &ReaderReferenceCache::ModuleChanged);
+      }
+      // service hooks may hide events from the core context, listen on the looked up one
+      if (m_ServiceListenerContexts.insert(context).second)
+      {
+        std::string filter = us::LDAPProp(us::ServiceConstants::OBJECTCLASS()) == us_service_interface_iid<mitk::IFileReader>();
+        context->AddServiceListener(this, &ReaderReferenceCache::ServiceChanged, filter);
+      }
+
+      std::map<KeyType, std::vector<ReaderReference> >::const_iterator iter = m_References.find(KeyType(context, mimeTypeName));
+      if (iter != m_References.end() && AllValid(iter->second))
+      {
+        ++m_Statistics.referenceCacheHits;
+        return iter->second;
+      }
+      generation = m_Generation;
+    }
+
+    std::string filter = us::LDAPProp(us::ServiceConstants::OBJECTCLASS()) == us_service_interface_iid<mitk::IFileReader>() &&
+                         us::LDAPProp(mitk::IFileReader::PROP_MIMETYPE()) == mimeTypeName;
+    std::vector<ReaderReference> refs = context->GetServiceReferences<mitk::IFileReader>(filter);
+
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+    // do not store a result which may have missed a concurrent registration
+    if (generation == m_Generation)
+    {
+      m_References[KeyType(context, mimeTypeName)] = refs;
+    }
+    return refs;
+  }
+
+  void CountMimeTypeLookup()
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+    ++m_Statistics.mimeTypeLookups;
+  }
+
+  mitk::FileReaderRegistry::LookupStatistics GetStatistics()
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+    return m_Statistics;
+  }
+
+  void ResetStatistics()
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+    m_Statistics.mimeTypeLookups = 0;
+    m_Statistics.referenceLookups = 0;
+    m_Statistics.referenceCacheHits = 0;
+  }
+
+private:
+
+  void ServiceChanged(const us::ServiceEvent /*event*/)
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+    m_References.clear();
+    ++m_Generation;
+  }
+
+  void ModuleChanged(const us::ModuleEvent event)
+  {
+    // a later context may be allocated at the address of the unloaded one
+    if (event.GetType() != us::ModuleEvent::UNLOADING)
+      return;
+
+    us::ModuleContext* context = event.GetModule()->GetModuleContext();
+    bool removeServiceListener = false;
+    bool removeModuleListener = false;
+    {
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_Mutex);
+      m_References.clear();
+      ++m_Generation;
+      removeServiceListener = m_ServiceListenerContexts.erase(context) > 0;
+      if (context == m_ModuleListenerContext)
+      {
+        m_ModuleListenerContext = NULL;
+        removeModuleListener = true;
+      }
+    }
+
+    // the context is still valid while its module is unloading
+    if (removeServiceListener)
+    {
+      context->RemoveServiceListener(this, &ReaderReferenceCache::ServiceChanged);
+    }
+    if (removeModuleListener)
+    {
+      context->RemoveModuleListener(this, &ReaderReferenceCache::ModuleChanged);
+    }
+  }
+
+  // an unregistering reader is reported before it is gone, a lookup in
+  // between may have stored its (now invalid) reference
+  static bool AllValid(const std::vector<ReaderReference>& refs)
+  {
+    for (const auto & ref : refs)
+    {
+      if (!ref) return false;
+    }
+    return true;
+  }
+
+  itk::SimpleFastMutexLock m_Mutex;
+  us::ModuleContext* m_ModuleListenerContext;
+  std::set<us::ModuleContext*> m_ServiceListenerContexts;
+  unsigned long m_Generation;
+  std::map<KeyType, std::vector<ReaderReference> > m_References;
+  mitk::FileReaderRegistry::LookupStatistics m_Statistics;
+};
+
+ReaderReferenceCache& s_ReaderReferenceCache()
+{
+  static ReaderReferenceCache cache;
+  return cache;
+}
+
+}
+
 mitk::FileReaderRegistry::FileReaderRegistry()
 {
 }
@@ -45,6 +218,8 @@ mitk::MimeType mitk::FileReaderRegistry::GetMimeTypeForFile(const std::string& p
     mitkThrow() << "FileReaderRegistry::GetMimeTypeForFile was called with empty path. Returning empty MimeType, please report this error to the developers.";
   }
 
+  s_ReaderReferenceCache().CountMimeTypeLookup();
+
   mitk::CoreServicePointer<mitk::IMimeTypeProvider> mimeTypeProvider(mitk::CoreServices::GetMimeTypeProvider(context));
   std::vector<MimeType> mimeTypes = mimeTypeProvider->GetMimeTypesForFile(path);
   if (mimeTypes.empty())
@@ -61,9 +236,7 @@ std::vector<mitk::FileReaderRegistry::ReaderReference> mitk::FileReaderRegistry:
 {
   if (context == NULL) context = us::GetModuleContext();
 
-  std::string filter = us::LDAPProp(us::ServiceConstants::OBJECTCLASS()) == us_service_interface_iid<IFileReader>() &&
-                       us::LDAPProp(IFileReader::PROP_MIMETYPE()) == mimeType.GetName();
-  return context->GetServiceReferences<IFileReader>(filter);
+  return s_ReaderReferenceCache().GetReferences(mimeType.GetName(), context);
 }
 
 mitk::IFileReader* mitk::FileReaderRegistry::GetReader(const mitk::FileReaderRegistry::ReaderReference& ref, us::ModuleContext* context)
@@ -120,3 +293,13 @@ void mitk::FileReaderRegistry::UngetReaders(const std::vector<mitk::IFileReader*
     this->UngetReader(reader);
   }
 }
+
+mitk::FileReaderRegistry::LookupStatistics mitk::FileReaderRegistry::GetLookupStatistics()
+{
+  return s_ReaderReferenceCache().GetStatistics();
+}
+
+void mitk::FileReaderRegistry::ResetLookupStatistics()
+{
+  s_ReaderReferenceCache().ResetStatistics();
+}
@@ -22,6 +22,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <usModuleContext.h>
 
 #include <itksys/SystemTools.hxx>
+#include <itkMutexLockHolder.h>
+
+#include <algorithm>
+#include <cctype>
+#include <typeinfo>
 
 #ifdef _MSC_VER
 #pragma warning(disable:4503) // decorated name length exceeded, name was truncated
@@ -32,6 +37,7 @@ namespace mitk {
 
 MimeTypeProvider::MimeTypeProvider()
   : m_Tracker(NULL)
+  , m_IndexValid(false)
 {
 }
 
@@ -67,18 +73,78 @@ std::vector<MimeType> MimeTypeProvider::GetMimeTypes() const
 std::vector<MimeType> MimeTypeProvider::GetMimeTypesForFile(const std::string& filePath) const
 {
   std::vector<MimeType> result;
-  for (const auto & elem : m_NameToMimeType)
+  std::vector<MimeType> contentMimeTypes;
   {
-    if (elem.second.AppliesTo(filePath))
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_IndexMutex);
+    if (!m_IndexValid)
     {
-      result.push_back(elem.second);
+      this->BuildExtensionIndex();
+    }
+
+    std::set<std::string> names;
+    for (std::set<std::size_t>::const_iterator lengthIter = m_ExtensionLengths.begin(),
+         lengthIterEnd = m_ExtensionLengths.end(); lengthIter != lengthIterEnd && *lengthIter <= filePath.size(); ++lengthIter)
+    {
+      std::string suffix = filePath.substr(filePath.size() - *lengthIter);
+      std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+
+      std::map<std::string, std::vector<MimeType> >::const_iterator iter = m_ExtensionToMimeTypes.find(suffix);
+      if (iter == m_ExtensionToMimeTypes.end()) continue;
+
+      for (const auto & mimeType : iter->second)
+      {
+        // a mime-type may have several matching extensions, e.g. "gz" and "nii.gz"
+        if (names.insert(mimeType.GetName()).second)
+        {
+          result.push_back(mimeType);
+        }
+      }
+    }
+    contentMimeTypes = m_ContentMimeTypes;
+  }
+
+  // these may read the file, so they are asked without holding the lock
+  for (const auto & mimeType : contentMimeTypes)
+  {
+    if (mimeType.AppliesTo(filePath))
+    {
+      result.push_back(mimeType);
     }
   }
+
   std::sort(result.begin(), result.end());
   std::reverse(result.begin(), result.end());
   return result;
 }
 
+void MimeTypeProvider::BuildExtensionIndex() const
+{
+  m_ExtensionToMimeTypes.clear();
+  m_ExtensionLengths.clear();
+  m_ContentMimeTypes.clear();
+
+  for (const auto & elem : m_NameToMimeType)
+  {
+    const MimeType& mimeType = elem.second;
+    if (m_ExtensionOnlyMimeTypes.find(mimeType) == m_ExtensionOnlyMimeTypes.end())
+    {
+      m_ContentMimeTypes.push_back(mimeType);
+      continue;
+    }
+
+    std::vector<std::string> extensions = mimeType.GetExtensions();
+    for (std::vector<std::string>::iterator iter = extensions.begin(), iterEnd = extensions.end();
+         iter != iterEnd; ++iter)
+    {
+      if (iter->empty()) continue;
+      std::transform(iter->begin(), iter->end(), iter->begin(), ::tolower);
+      m_ExtensionToMimeTypes[*iter].push_back(mimeType);
+      m_ExtensionLengths.insert(iter->size());
+    }
+  }
+  m_IndexValid = true;
+}
+
 std::vector<MimeType> MimeTypeProvider::GetMimeTypesForCategory(const std::string& category) const
 {
   std::vector<MimeType> result;
@@ -117,14 +183,21 @@ std::vector<std::string> MimeTypeProvider::GetCategories() const
 
 MimeTypeProvider::TrackedType MimeTypeProvider::AddingService(const ServiceReferenceType& reference)
 {
-  MimeType result = this->GetMimeType(reference);
+  bool matchesExtensionOnly = false;
+  MimeType result = this->GetMimeType(reference, matchesExtensionOnly);
   if (result.IsValid())
   {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_IndexMutex);
     std::string name = result.GetName();
     m_NameToMimeTypes[name].insert(result);
+    if (matchesExtensionOnly)
+    {
+      m_ExtensionOnlyMimeTypes.insert(result);
+    }
 
     // get the highest ranked mime-type
     m_NameToMimeType[name] = *(m_NameToMimeTypes[name].rbegin());
+    m_IndexValid = false;
   }
   return result;
 }
@@ -136,6 +209,10 @@ void MimeTypeProvider::ModifiedService(const ServiceReferenceType& /*reference*/
 
 void MimeTypeProvider::RemovedService(const ServiceReferenceType& /*reference*/, TrackedType mimeType)
 {
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_IndexMutex);
+  m_IndexValid = false;
+  m_ExtensionOnlyMimeTypes.erase(mimeType);
+
   std::string name = mimeType.GetName();
   std::set<MimeType>& mimeTypes = m_NameToMimeTypes[name];
   mimeTypes.erase(mimeType);
@@ -151,7 +228,7 @@ void MimeTypeProvider::RemovedService(const ServiceReferenceType& /*reference*/,
   }
 }
 
-MimeType MimeTypeProvider::GetMimeType(const ServiceReferenceType& reference) const
+MimeType MimeTypeProvider::GetMimeType(const ServiceReferenceType& reference, bool& matchesExtensionOnly) const
 {
   MimeType result;
   if (!reference) return result;
@@ -169,6 +246,8 @@ MimeType MimeTypeProvider::GetMimeType(const ServiceReferenceType& reference) co
       }
       long id = us::any_cast<long>(reference.GetProperty(us::ServiceConstants::SERVICE_ID()));
       result = MimeType(*mimeType, rank, id);
+      // sub-classes may look into the file (e.g. DICOM), their matches cannot be indexed
+      matchesExtensionOnly = typeid(*mimeType) == typeid(CustomMimeType);
     }
     catch (const us::BadAnyCastException& e)
     {
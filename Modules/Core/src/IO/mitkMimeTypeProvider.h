@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "usServiceTracker.h"
 #include "usServiceTrackerCustomizer.h"
 
+#include <itkSimpleFastMutexLock.h>
+
 #include <set>
 
 namespace mitk {
@@ -70,7 +72,9 @@ private:
   virtual void ModifiedService(const ServiceReferenceType& reference, TrackedType service) override;
   virtual void RemovedService(const ServiceReferenceType& reference, TrackedType service) override;
 
-  MimeType GetMimeType(const ServiceReferenceType& reference) const;
+  MimeType GetMimeType(const ServiceReferenceType& reference, bool& matchesExtensionOnly) const;
+
+  void BuildExtensionIndex() const;
 
   us::ServiceTracker<CustomMimeType, MimeTypeTrackerTypeTraits>* m_Tracker;
 
@@ -78,6 +82,19 @@ private:
   MapType m_NameToMimeTypes;
 
   std::map<std::string, MimeType> m_NameToMimeType;
+
+  // The mime-types which do not override CustomMimeType::AppliesTo()
+  // and therefore only look at the extension of a path.
+  std::set<MimeType> m_ExtensionOnlyMimeTypes;
+
+  // Index used by GetMimeTypesForFile(), rebuilt after mime-types were
+  // added or removed. Extension-only mime-types are found by looking up
+  // the lower-case suffixes of a path, all others are asked for each path.
+  mutable itk::SimpleFastMutexLock m_IndexMutex;
+  mutable bool m_IndexValid;
+  mutable std::map<std::string, std::vector<MimeType> > m_ExtensionToMimeTypes;
+  mutable std::set<std::size_t> m_ExtensionLengths;
+  mutable std::vector<MimeType> m_ContentMimeTypes;
 };
 
 }
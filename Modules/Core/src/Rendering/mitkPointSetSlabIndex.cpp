@@ -0,0 +1,215 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkPointSetSlabIndex.h"
+
+#include <mitkAbstractTransformGeometry.h>
+#include <mitkPlaneGeometry.h>
+
+#include <vtkLinearTransform.h>
+#include <vtkMath.h>
+
+#include <algorithm>
+#include <cmath>
+
+mitk::PointSetSlabIndex::PointSetSlabIndex()
+  : m_TimeStep(0),
+    m_InputMTime(0)
+{
+}
+
+mitk::PointSetSlabIndex::~PointSetSlabIndex()
+{
+}
+
+void mitk::PointSetSlabIndex::SetInput(const PointSet* pointSet, int timeStep)
+{
+  unsigned long mtime = 0;
+  if (pointSet != NULL)
+  {
+    // the itk point set and the geometry transform can be modified without touching the point set itself
+    mtime = pointSet->GetMTime();
+    PointSet::DataType::Pointer itkPointSet = pointSet->GetPointSet(timeStep);
+    if (itkPointSet.IsNotNull())
+    {
+      mtime = std::max(mtime, itkPointSet->GetMTime());
+      mtime = std::max(mtime, itkPointSet->GetPoints()->GetMTime());
+      mtime = std::max(mtime, itkPointSet->GetPointData()->GetMTime());
+    }
+    mtime = std::max(mtime, pointSet->GetGeometry()->GetMTime());
+    mtime = std::max(mtime, pointSet->GetGeometry()->GetVtkTransform()->GetMTime());
+  }
+
+  if (m_Input.GetPointer() == pointSet && m_TimeStep == timeStep && m_InputMTime == mtime)
+    return;
+
+  m_Input = pointSet;
+  m_TimeStep = timeStep;
+  m_InputMTime = mtime;
+  m_Indices.Clear();
+  this->BuildPoints();
+  this->Modified();
+}
+
+void mitk::PointSetSlabIndex::BuildPoints()
+{
+  m_WorldPoints.clear();
+  m_PointIds.clear();
+  m_Selected.clear();
+
+  if (m_Input.IsNull())
+    return;
+
+  PointSet::DataType::Pointer itkPointSet = m_Input->GetPointSet(m_TimeStep);
+  if (itkPointSet.IsNull())
+    return;
+
+  const PointSet::PointsContainer* points = itkPointSet->GetPoints();
+  const PointSet::PointDataContainer* pointData = itkPointSet->GetPointData();
+  // the selection state is only known if there is one data entry per point
+  const bool hasPointData = pointData->Size() == points->Size();
+
+  m_WorldPoints.reserve(points->Size());
+  m_PointIds.reserve(points->Size());
+  m_Selected.reserve(points->Size());
+
+  vtkLinearTransform* transform = m_Input->GetGeometry()->GetVtkTransform();
+
+  PointSet::PointDataContainer::ConstIterator pointDataIter = pointData->Begin();
+  for (PointSet::PointsContainer::ConstIterator pointsIter = points->Begin(); pointsIter != points->End(); ++pointsIter)
+  {
+    Point3D point = pointsIter->Value();
+    float vtkp[3];
+    itk2vtk(point, vtkp);
+    transform->TransformPoint(vtkp, vtkp);
+    vtk2itk(vtkp, point);
+
+    m_WorldPoints.push_back(point);
+    m_PointIds.push_back(pointsIter->Index());
+
+    if (hasPointData)
+    {
+      m_Selected.push_back(pointDataIter->Value().selected);
+      ++pointDataIter;
+    }
+    else
+    {
+      m_Selected.push_back(false);
+    }
+  }
+}
+
+void mitk::PointSetSlabIndex::SetMaximumNumberOfDirections(unsigned int maximumNumberOfDirections)
+{
+  if (m_Indices.GetMaximumNumberOfDirections() == maximumNumberOfDirections)
+    return;
+
+  m_Indices.SetMaximumNumberOfDirections(maximumNumberOfDirections);
+  this->Modified();
+}
+
+unsigned int mitk::PointSetSlabIndex::GetMaximumNumberOfDirections() const
+{
+  return m_Indices.GetMaximumNumberOfDirections();
+}
+
+unsigned int mitk::PointSetSlabIndex::GetNumberOfDirections() const
+{
+  return m_Indices.GetNumberOfDirections();
+}
+
+std::size_t mitk::PointSetSlabIndex::GetNumberOfPoints() const
+{
+  return m_WorldPoints.size();
+}
+
+const mitk::Point3D& mitk::PointSetSlabIndex::GetWorldPoint(std::size_t position) const
+{
+  return m_WorldPoints[position];
+}
+
+mitk::PointSet::PointIdentifier mitk::PointSetSlabIndex::GetPointId(std::size_t position) const
+{
+  return m_PointIds[position];
+}
+
+bool mitk::PointSetSlabIndex::IsPointSelected(std::size_t position) const
+{
+  return m_Selected[position];
+}
+
+void mitk::PointSetSlabIndex::BuildDirectionIndex(DirectionIndex& index, const double normal[3])
+{
+  const std::size_t numberOfPoints = m_WorldPoints.size();
+  std::vector<std::pair<double, std::size_t> > sorted(numberOfPoints);
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    const Point3D& p = m_WorldPoints[i];
+    sorted[i].first = p[0] * normal[0] + p[1] * normal[1] + p[2] * normal[2];
+    sorted[i].second = i;
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  index.Projections.resize(numberOfPoints);
+  index.Positions.resize(numberOfPoints);
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    index.Projections[i] = sorted[i].first;
+    index.Positions[i] = sorted[i].second;
+  }
+}
+
+void mitk::PointSetSlabIndex::FindPointsNearPlane(const PlaneGeometry* plane, ScalarType maxDistance, std::vector<std::size_t>& positions)
+{
+  positions.clear();
+  if (plane == NULL || m_WorldPoints.empty())
+    return;
+
+  double normal[3] = { plane->GetNormal()[0], plane->GetNormal()[1], plane->GetNormal()[2] };
+  // the distance to a curved plane is not a projection onto its normal
+  if (dynamic_cast<const AbstractTransformGeometry*>(plane) != NULL || vtkMath::Normalize(normal) == 0.0)
+  {
+    for (std::size_t i = 0; i < m_WorldPoints.size(); ++i)
+    {
+      if (plane->Distance(m_WorldPoints[i]) < maxDistance)
+        positions.push_back(i);
+    }
+    return;
+  }
+
+  bool isNew = false;
+  PlaneDirectionCache<DirectionIndex>::Direction& direction = m_Indices.GetDirection(normal, isNew);
+  if (isNew)
+    this->BuildDirectionIndex(direction.Index, direction.Normal);
+  const DirectionIndex* index = &direction.Index;
+
+  const Point3D& origin = plane->GetOrigin();
+  const double distance = origin[0] * direction.Normal[0] + origin[1] * direction.Normal[1] + origin[2] * direction.Normal[2];
+  // widen the slab a little, the exact test below decides
+  const double tolerance = maxDistance + 1e-6 * (1.0 + std::abs(distance));
+
+  std::vector<double>::const_iterator first = std::lower_bound(index->Projections.cbegin(), index->Projections.cend(), distance - tolerance);
+  std::vector<double>::const_iterator last = std::upper_bound(first, index->Projections.cend(), distance + tolerance);
+  for (std::vector<double>::const_iterator it = first; it != last; ++it)
+  {
+    const std::size_t position = index->Positions[it - index->Projections.cbegin()];
+    if (plane->Distance(m_WorldPoints[position]) < maxDistance)
+      positions.push_back(position);
+  }
+
+  // keep the order of the point set, e.g. for labels
+  std::sort(positions.begin(), positions.end());
+}
@@ -28,7 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPropAssembly.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkTransform.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkTransformFilter.h>
 #include <vtkLine.h>
 #include <vtkGlyphSource2D.h>
@@ -63,8 +63,8 @@ mitk::PointSetVtkMapper2D::LocalStorage::LocalStorage()
   m_SelectedGlyphSource2D = vtkSmartPointer<vtkGlyphSource2D>::New();
 
   // glyphs
-  m_UnselectedGlyph3D = vtkSmartPointer<vtkGlyph3D>::New();
-  m_SelectedGlyph3D = vtkSmartPointer<vtkGlyph3D>::New();
+  m_UnselectedGlyph3DMapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
+  m_SelectedGlyph3DMapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
 
   // polydata
   m_VtkUnselectedPointListPolyData = vtkSmartPointer<vtkPolyData>::New();
@@ -76,13 +76,40 @@ mitk::PointSetVtkMapper2D::LocalStorage::LocalStorage()
   m_SelectedActor = vtkSmartPointer <vtkActor>::New();
   m_ContourActor = vtkSmartPointer <vtkActor>::New();
 
+  m_NumberOfUsedTextActors = 0;
+
   // mappers
-  m_VtkUnselectedPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  m_VtkSelectedPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
   m_VtkContourPolyDataMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
 
   // propassembly
   m_PropAssembly = vtkSmartPointer <vtkPropAssembly>::New();
+
+  // the pipeline is set up once, CreateVTKRenderObjects only refills the arrays
+  m_UnselectedScales->SetName("PointScales");
+  m_SelectedScales->SetName("PointScales");
+
+  m_VtkUnselectedPointListPolyData->SetPoints(m_UnselectedPoints);
+  m_VtkUnselectedPointListPolyData->GetPointData()->AddArray(m_UnselectedScales);
+  m_VtkSelectedPointListPolyData->SetPoints(m_SelectedPoints);
+  m_VtkSelectedPointListPolyData->GetPointData()->AddArray(m_SelectedScales);
+
+  m_VtkContourPolyData->SetPoints(m_ContourPoints);
+  m_VtkContourPolyData->SetLines(m_ContourLines);
+  m_VtkContourPolyDataMapper->SetInputData(m_VtkContourPolyData);
+  m_ContourActor->SetMapper(m_VtkContourPolyDataMapper);
+
+  // each glyph is scaled according to the distance of its point to the plane
+  m_UnselectedGlyph3DMapper->SetInputData(m_VtkUnselectedPointListPolyData);
+  m_UnselectedGlyph3DMapper->SetScaleArray("PointScales");
+  m_UnselectedGlyph3DMapper->SetScaleModeToScaleByMagnitude();
+  m_UnselectedGlyph3DMapper->OrientOff();
+  m_UnselectedActor->SetMapper(m_UnselectedGlyph3DMapper);
+
+  m_SelectedGlyph3DMapper->SetInputData(m_VtkSelectedPointListPolyData);
+  m_SelectedGlyph3DMapper->SetScaleArray("PointScales");
+  m_SelectedGlyph3DMapper->SetScaleModeToScaleByMagnitude();
+  m_SelectedGlyph3DMapper->OrientOff();
+  m_SelectedActor->SetMapper(m_SelectedGlyph3DMapper);
 }
 // destructor LocalStorage
 mitk::PointSetVtkMapper2D::LocalStorage::~LocalStorage()
@@ -109,7 +136,8 @@ m_PointLineWidth(1),
 m_Point2DSize(6),
 m_IDShapeProperty(mitk::PointSetShapeProperty::CROSS),
 m_FillShape(false),
-m_DistanceToPlane(4.0f)
+m_DistanceToPlane(4.0f),
+m_PointIndex(PointSetSlabIndex::New())
 {
 }
 
@@ -157,6 +185,18 @@ static bool makePerpendicularVector2D(const mitk::Vector2D& in, mitk::Vector2D&
       return false;
 }
 
+vtkTextActor* mitk::PointSetVtkMapper2D::GetNextTextActor(LocalStorage* ls)
+{
+  if (ls->m_NumberOfUsedTextActors == ls->m_VtkTextActorPool.size())
+  {
+    ls->m_VtkTextActorPool.push_back(vtkSmartPointer<vtkTextActor>::New());
+  }
+
+  vtkTextActor* textActor = ls->m_VtkTextActorPool[ls->m_NumberOfUsedTextActors++];
+  textActor->GetTextProperty()->SetOpacity(1.0);
+  return textActor;
+}
+
 void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* renderer)
 {
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
@@ -164,9 +204,9 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   unsigned i = 0;
 
   // The vtk text actors need to be removed manually from the propassembly
-  // since the same vtk text actors are not overwriten within this function,
-  // but new actors are added to the propassembly each time this function is executed.
+  // since the text actors are not the same for each execution of this function.
   // Thus, the actors from the last call must be removed in the beginning.
+  // They are given back to the pool and reused below.
   for(i=0; i< ls->m_VtkTextLabelActors.size(); i++)
   {
     if(ls->m_PropAssembly->GetParts()->IsItemPresent(ls->m_VtkTextLabelActors.at(i)))
@@ -185,11 +225,7 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
       ls->m_PropAssembly->RemovePart(ls->m_VtkTextAngleActors.at(i));
   }
 
-  // initialize polydata here, otherwise we have update problems when
-  // executing this function again
-  ls->m_VtkUnselectedPointListPolyData = vtkSmartPointer<vtkPolyData>::New();
-  ls->m_VtkSelectedPointListPolyData = vtkSmartPointer <vtkPolyData>::New();
-  ls->m_VtkContourPolyData = vtkSmartPointer<vtkPolyData>::New();
+  ls->m_NumberOfUsedTextActors = 0;
 
   // get input point set and update the PointSet
   mitk::PointSet::Pointer input  = const_cast<mitk::PointSet*>(this->GetInput());
@@ -209,14 +245,6 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
     return;
   }
 
-  //iterator for point set
-  mitk::PointSet::PointsContainer::Iterator pointsIter = itkPointSet->GetPoints()->Begin();
-
-  // PointDataContainer has additional information to each point, e.g. whether
-  // it is selected or not
-  mitk::PointSet::PointDataContainer::Iterator pointDataIter;
-  pointDataIter = itkPointSet->GetPointData()->Begin();
-
   //check if the list for the PointDataContainer is the same size as the PointsContainer.
   //If not, then the points were inserted manually and can not be visualized according to the PointData (selected/unselected)
   bool pointDataBroken = (itkPointSet->GetPointData()->Size() != itkPointSet->GetPoints()->Size());
@@ -230,6 +258,7 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   ls->m_PropAssembly->VisibilityOn();
 
   // empty point sets, cellarrays, scalars
+  // (the arrays keep their memory, they are refilled below)
   ls->m_UnselectedPoints->Reset();
   ls->m_SelectedPoints->Reset();
 
@@ -245,18 +274,49 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   ls->m_VtkTextDistanceActors.clear();
   ls->m_VtkTextAngleActors.clear();
 
-  ls->m_UnselectedScales->SetNumberOfComponents(3);
-  ls->m_SelectedScales->SetNumberOfComponents(3);
+  ls->m_UnselectedScales->SetNumberOfComponents(1);
+  ls->m_SelectedScales->SetNumberOfComponents(1);
+
+  // the world coordinates of the points are shared by all renderers
+  // and only recomputed if the point set or its geometry changed
+  m_PointIndex->SetInput(input, timestep);
+
+  mitk::DisplayGeometry::Pointer displayGeometry = renderer->GetDisplayGeometry();
+  const mitk::PlaneGeometry* geo2D = renderer->GetCurrentWorldPlaneGeometry();
+
+  // lines between the points need all points, otherwise only
+  // the points close to the current plane are visited
+  std::vector<std::size_t>& positions = ls->m_VisiblePositions;
+  if (m_ShowContour)
+  {
+    positions.resize(m_PointIndex->GetNumberOfPoints());
+    for (std::size_t position = 0; position < positions.size(); ++position)
+      positions[position] = position;
+  }
+  else
+  {
+    m_PointIndex->FindPointsNearPlane(geo2D, m_DistanceToPlane, positions);
+  }
+
+  // label and label color are the same for all points
+  mitk::StringProperty* labelProperty = dynamic_cast<mitk::StringProperty *>(this->GetDataNode()->GetProperty("label"));
+  float unselectedColor[4] = {1.0, 1.0, 0.0, 1.0};
+  if (labelProperty != NULL)
+  {
+    //check if there is a color property
+    GetDataNode()->GetColor(unselectedColor);
+  }
 
   int NumberContourPoints = 0;
   bool pointsOnSameSideOfPlane = false;
 
   const int text2dDistance = 10;
 
-  // initialize points with a random start value
-
-  // current point in point set
-  itk::Point<ScalarType> point = pointsIter->Value();
+  // initialize points with a start value
+  mitk::Point3D point;
+  point.Fill(0.0);
+  if (!positions.empty())
+    point = m_PointIndex->GetWorldPoint(positions.front());
 
   mitk::Point3D p = point;              // currently visited point
   mitk::Point3D lastP = point;          // last visited point (predecessor in point set of "point")
@@ -273,91 +333,73 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   mitk::Point2D lastPt2d = pt2d;         // last projected_p in display coordinates (predecessor in point set of "pt2d")
   mitk::Point2D preLastPt2d = pt2d ;     // projected_p in display coordinates before lastPt2
 
-  mitk::DisplayGeometry::Pointer displayGeometry = renderer->GetDisplayGeometry();
-  const mitk::PlaneGeometry* geo2D = renderer->GetCurrentWorldPlaneGeometry();
-
-  vtkLinearTransform* dataNodeTransform = input->GetGeometry()->GetVtkTransform();
-
-  int count = 0;
-
-  for (pointsIter=itkPointSet->GetPoints()->Begin();
-    pointsIter!=itkPointSet->GetPoints()->End();
-    pointsIter++)
+  for (std::size_t count = 0; count < positions.size(); ++count)
   {
+    const std::size_t position = positions[count];
+
     lastP = p; // valid for number of points count > 0
     preLastPt2d = lastPt2d; // valid only for count > 1
     lastPt2d = pt2d;  // valid for number of points count > 0
 
     lastVec = vec;    // valid only for counter > 1
 
-    // get current point in point set
-    point = pointsIter->Value();
-
-    // transform point
-    {
-      float vtkp[3];
-      itk2vtk(point, vtkp);
-      dataNodeTransform->TransformPoint(vtkp, vtkp);
-      vtk2itk(vtkp,point);
-    }
+    // get current point in point set (already transformed)
+    point = m_PointIndex->GetWorldPoint(position);
 
     p[0] = point[0];
     p[1] = point[1];
     p[2] = point[2];
 
-    displayGeometry->Project(p, projected_p);
-    displayGeometry->Map(projected_p, pt2d);
-    displayGeometry->WorldToDisplay(pt2d, pt2d);
-
-    vec = p-lastP;    // valid only for counter > 0
-
     // compute distance to current plane
     float diff = fabs(geo2D->Distance(point));
-//    diff = diff * diff;
+    bool nearPlane = diff < m_DistanceToPlane;
+
+    // the display position is only needed for text
+    if (m_ShowContour || (nearPlane && labelProperty != NULL))
+    {
+      displayGeometry->Project(p, projected_p);
+      displayGeometry->Map(projected_p, pt2d);
+      displayGeometry->WorldToDisplay(pt2d, pt2d);
+    }
+
+    vec = p-lastP;    // valid only for counter > 0
 
     //draw markers on slices a certain distance away from the points
     //location according to the tolerance threshold (m_DistanceToPlane)
-    if(diff < m_DistanceToPlane)
+    if(nearPlane)
     {
+      // point is scaled according to its distance to the plane
+      double scale = (double)m_Point2DSize*(1-diff/m_DistanceToPlane);
+
       // is point selected or not?
-      if (pointDataIter->Value().selected)
+      if (m_PointIndex->IsPointSelected(position))
       {
         ls->m_SelectedPoints->InsertNextPoint(point[0],point[1],point[2]);
-        // point is scaled according to its distance to the plane
-        ls->m_SelectedScales->InsertNextTuple3((double)m_Point2DSize*(1-diff/m_DistanceToPlane),0,0);
+        ls->m_SelectedScales->InsertNextValue(scale);
       }
       else
       {
         ls->m_UnselectedPoints->InsertNextPoint(point[0],point[1],point[2]);
-        // point is scaled according to its distance to the plane
-        ls->m_UnselectedScales->InsertNextTuple3((double)m_Point2DSize*(1-diff/m_DistanceToPlane),0,0);
+        ls->m_UnselectedScales->InsertNextValue(scale);
       }
 
       //---- LABEL -----//
       //paint label for each point if available
-      if (dynamic_cast<mitk::StringProperty *>(this->GetDataNode()->GetProperty("label")) != NULL)
+      if (labelProperty != NULL)
       {
-        const char * pointLabel = dynamic_cast<mitk::StringProperty *>(
-          this->GetDataNode()->GetProperty("label"))->GetValue();
-        std::string l = pointLabel;
+        std::string l = labelProperty->GetValue();
         if (input->GetSize()>1)
         {
           std::stringstream ss;
-          ss << pointsIter->Index();
+          ss << m_PointIndex->GetPointId(position);
           l.append(ss.str());
         }
 
-        ls->m_VtkTextActor = vtkSmartPointer<vtkTextActor>::New();
+        ls->m_VtkTextActor = this->GetNextTextActor(ls);
 
         ls->m_VtkTextActor->SetPosition(pt2d[0] + text2dDistance, pt2d[1] + text2dDistance);
         ls->m_VtkTextActor->SetInput(l.c_str());
         ls->m_VtkTextActor->GetTextProperty()->SetOpacity( 100 );
-
-        float unselectedColor[4] = {1.0, 1.0, 0.0, 1.0};
-
-        //check if there is a color property
-        GetDataNode()->GetColor(unselectedColor);
-
         ls->m_VtkTextActor->GetTextProperty()->SetColor(unselectedColor[0], unselectedColor[1], unselectedColor[2]);
 
         ls->m_VtkTextLabelActors.push_back(ls->m_VtkTextActor);
@@ -402,7 +444,7 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
           makePerpendicularVector2D(vec2d, vec2d); // text is rendered within text2dDistance perpendicular to current line
           Vector2D pos2d = (lastPt2d.GetVectorFromOrigin() + pt2d.GetVectorFromOrigin() ) * 0.5 + vec2d * text2dDistance;
 
-          ls->m_VtkTextActor = vtkSmartPointer<vtkTextActor>::New();
+          ls->m_VtkTextActor = this->GetNextTextActor(ls);
 
           ls->m_VtkTextActor->SetPosition(pos2d[0],pos2d[1]);
           ls->m_VtkTextActor->SetInput(buffer.str().c_str());
@@ -427,7 +469,7 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
           // middle between two vectors that enclose the angle
           Vector2D pos2d = lastPt2d.GetVectorFromOrigin() + vec2d * text2dDistance * text2dDistance;
 
-          ls->m_VtkTextActor = vtkSmartPointer<vtkTextActor>::New();
+          ls->m_VtkTextActor = this->GetNextTextActor(ls);
 
           ls->m_VtkTextActor->SetPosition(pos2d[0],pos2d[1]);
           ls->m_VtkTextActor->SetInput(buffer.str().c_str());
@@ -437,14 +479,16 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
         }
       }
     }
-
-    if(pointDataIter != itkPointSet->GetPointData()->End())
-    {
-      pointDataIter++;
-      count++;
-    }
   }
 
+  // the arrays were refilled in place, so the pipeline has to be told
+  ls->m_UnselectedPoints->Modified();
+  ls->m_SelectedPoints->Modified();
+  ls->m_UnselectedScales->Modified();
+  ls->m_SelectedScales->Modified();
+  ls->m_VtkUnselectedPointListPolyData->Modified();
+  ls->m_VtkSelectedPointListPolyData->Modified();
+
   // add each single text actor to the assembly
   for(i=0; i< ls->m_VtkTextLabelActors.size(); i++)
   {
@@ -474,11 +518,12 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
       ls->m_ContourLines->InsertNextCell(closingLine);
     }
 
-    ls->m_VtkContourPolyData->SetPoints(ls->m_ContourPoints);
-    ls->m_VtkContourPolyData->SetLines(ls->m_ContourLines);
+    ls->m_ContourPoints->Modified();
+    ls->m_ContourLines->Modified();
+    // drop the cell links built for the previous lines
+    ls->m_VtkContourPolyData->DeleteCells();
+    ls->m_VtkContourPolyData->Modified();
 
-    ls->m_VtkContourPolyDataMapper->SetInputData(ls->m_VtkContourPolyData);
-    ls->m_ContourActor->SetMapper(ls->m_VtkContourPolyDataMapper);
     ls->m_ContourActor->GetProperty()->SetLineWidth(m_LineWidth);
 
     ls->m_PropAssembly->AddPart(ls->m_ContourActor);
@@ -518,17 +563,8 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   transformFilterU->SetInputConnection(ls->m_UnselectedGlyphSource2D->GetOutputPort());
   transformFilterU->SetTransform(transform);
 
-  ls->m_VtkUnselectedPointListPolyData->SetPoints(ls->m_UnselectedPoints);
-  ls->m_VtkUnselectedPointListPolyData->GetPointData()->SetVectors(ls->m_UnselectedScales);
-
-  // apply transform of current plane to glyphs
-  ls->m_UnselectedGlyph3D->SetSourceConnection(transformFilterU->GetOutputPort());
-  ls->m_UnselectedGlyph3D->SetInputData(ls->m_VtkUnselectedPointListPolyData);
-  ls->m_UnselectedGlyph3D->SetScaleModeToScaleByVector();
-  ls->m_UnselectedGlyph3D->SetVectorModeToUseVector();
-
-  ls->m_VtkUnselectedPolyDataMapper->SetInputConnection(ls->m_UnselectedGlyph3D->GetOutputPort());
-  ls->m_UnselectedActor->SetMapper(ls->m_VtkUnselectedPolyDataMapper);
+  // apply transform of current plane to glyphs, the glyph mapper draws one instance per point
+  ls->m_UnselectedGlyph3DMapper->SetSourceConnection(transformFilterU->GetOutputPort());
   ls->m_UnselectedActor->GetProperty()->SetLineWidth(m_PointLineWidth);
 
   ls->m_PropAssembly->AddPart(ls->m_UnselectedActor);
@@ -544,17 +580,8 @@ void mitk::PointSetVtkMapper2D::CreateVTKRenderObjects(mitk::BaseRenderer* rende
   transformFilterS->SetInputConnection(ls->m_SelectedGlyphSource2D->GetOutputPort());
   transformFilterS->SetTransform(transform);
 
-  ls->m_VtkSelectedPointListPolyData->SetPoints(ls->m_SelectedPoints);
-  ls->m_VtkSelectedPointListPolyData->GetPointData()->SetVectors(ls->m_SelectedScales);
-
   // apply transform of current plane to glyphs
-  ls->m_SelectedGlyph3D->SetSourceConnection(transformFilterS->GetOutputPort());
-  ls->m_SelectedGlyph3D->SetInputData(ls->m_VtkSelectedPointListPolyData);
-  ls->m_SelectedGlyph3D->SetScaleModeToScaleByVector();
-  ls->m_SelectedGlyph3D->SetVectorModeToUseVector();
-
-  ls->m_VtkSelectedPolyDataMapper->SetInputConnection(ls->m_SelectedGlyph3D->GetOutputPort());
-  ls->m_SelectedActor->SetMapper(ls->m_VtkSelectedPolyDataMapper);
+  ls->m_SelectedGlyph3DMapper->SetSourceConnection(transformFilterS->GetOutputPort());
   ls->m_SelectedActor->GetProperty()->SetLineWidth(m_PointLineWidth);
 
   ls->m_PropAssembly->AddPart(ls->m_SelectedActor);
@@ -0,0 +1,247 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSurfaceCuttingIndex.h"
+
+#include <vtkCellData.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <algorithm>
+
+mitk::SurfaceCuttingIndex::SurfaceCuttingIndex()
+  : m_InputMTime(0)
+{
+}
+
+mitk::SurfaceCuttingIndex::~SurfaceCuttingIndex()
+{
+}
+
+void mitk::SurfaceCuttingIndex::SetInput(vtkPolyData* polyData)
+{
+  unsigned long mtime = polyData != NULL ? polyData->GetMTime() : 0;
+  if (m_Input == polyData && m_InputMTime == mtime)
+    return;
+
+  m_Input = polyData;
+  m_InputMTime = mtime;
+  this->ClearIndices();
+  this->Modified();
+}
+
+vtkPolyData* mitk::SurfaceCuttingIndex::GetInput() const
+{
+  return m_Input;
+}
+
+void mitk::SurfaceCuttingIndex::SetMaximumNumberOfDirections(unsigned int maximumNumberOfDirections)
+{
+  if (m_Indices.GetMaximumNumberOfDirections() == maximumNumberOfDirections)
+    return;
+
+  m_Indices.SetMaximumNumberOfDirections(maximumNumberOfDirections);
+  this->Modified();
+}
+
+unsigned int mitk::SurfaceCuttingIndex::GetMaximumNumberOfDirections() const
+{
+  return m_Indices.GetMaximumNumberOfDirections();
+}
+
+unsigned int mitk::SurfaceCuttingIndex::GetNumberOfDirections() const
+{
+  return m_Indices.GetNumberOfDirections();
+}
+
+void mitk::SurfaceCuttingIndex::ClearIndices()
+{
+  m_Indices.Clear();
+  m_PointMap.clear();
+}
+
+void mitk::SurfaceCuttingIndex::BuildDirectionIndex(DirectionIndex& index, const double normal[3])
+{
+  index.CellMin.clear();
+  index.CellMax.clear();
+  index.SlabOffsets.clear();
+  index.SlabCells.clear();
+
+  const vtkIdType numberOfCells = m_Input->GetNumberOfCells();
+  const vtkIdType numberOfPoints = m_Input->GetNumberOfPoints();
+
+  // project every point once, cells only look up their projections
+  std::vector<double> projection(numberOfPoints);
+  vtkPoints* points = m_Input->GetPoints();
+  double p[3];
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    points->GetPoint(i, p);
+    projection[i] = vtkMath::Dot(p, normal);
+  }
+
+  index.CellMin.resize(numberOfCells);
+  index.CellMax.resize(numberOfCells);
+
+  double rangeMin = vtkMath::Inf();
+  double rangeMax = -vtkMath::Inf();
+  double extentSum = 0.0;
+  vtkIdType npts = 0;
+  vtkIdType* pts = NULL;
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    m_Input->GetCellPoints(cellId, npts, pts);
+    double cellMin = vtkMath::Inf();
+    double cellMax = -vtkMath::Inf();
+    for (vtkIdType i = 0; i < npts; ++i)
+    {
+      cellMin = std::min(cellMin, projection[pts[i]]);
+      cellMax = std::max(cellMax, projection[pts[i]]);
+    }
+    index.CellMin[cellId] = cellMin;
+    index.CellMax[cellId] = cellMax;
+    if (npts > 0)
+    {
+      rangeMin = std::min(rangeMin, cellMin);
+      rangeMax = std::max(rangeMax, cellMax);
+      extentSum += cellMax - cellMin;
+    }
+  }
+
+  // choose the slab width such that an average cell spans about two slabs
+  vtkIdType numberOfSlabs = 1;
+  const double range = rangeMax - rangeMin;
+  if (numberOfCells > 0 && range > 0.0)
+  {
+    const double meanExtent = extentSum / numberOfCells;
+    double slabs = meanExtent > 0.0 ? 2.0 * range / meanExtent : static_cast<double>(numberOfCells);
+    slabs = std::min(slabs, static_cast<double>(numberOfCells));
+    numberOfSlabs = std::max<vtkIdType>(1, static_cast<vtkIdType>(slabs));
+  }
+  index.RangeMin = numberOfCells > 0 ? rangeMin : 0.0;
+  index.SlabWidth = range > 0.0 ? range / numberOfSlabs : 1.0;
+
+  // two passes (count, fill) to store all slabs in one contiguous array
+  index.SlabOffsets.assign(numberOfSlabs + 1, 0);
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    if (index.CellMin[cellId] > index.CellMax[cellId])
+      continue;
+    const vtkIdType first = std::min(numberOfSlabs - 1, static_cast<vtkIdType>((index.CellMin[cellId] - index.RangeMin) / index.SlabWidth));
+    const vtkIdType last = std::min(numberOfSlabs - 1, static_cast<vtkIdType>((index.CellMax[cellId] - index.RangeMin) / index.SlabWidth));
+    for (vtkIdType slab = first; slab <= last; ++slab)
+      ++index.SlabOffsets[slab + 1];
+  }
+  for (vtkIdType slab = 0; slab < numberOfSlabs; ++slab)
+    index.SlabOffsets[slab + 1] += index.SlabOffsets[slab];
+
+  index.SlabCells.resize(index.SlabOffsets[numberOfSlabs]);
+  std::vector<vtkIdType> fill(index.SlabOffsets.begin(), index.SlabOffsets.end() - 1);
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    if (index.CellMin[cellId] > index.CellMax[cellId])
+      continue;
+    const vtkIdType first = std::min(numberOfSlabs - 1, static_cast<vtkIdType>((index.CellMin[cellId] - index.RangeMin) / index.SlabWidth));
+    const vtkIdType last = std::min(numberOfSlabs - 1, static_cast<vtkIdType>((index.CellMax[cellId] - index.RangeMin) / index.SlabWidth));
+    for (vtkIdType slab = first; slab <= last; ++slab)
+      index.SlabCells[fill[slab]++] = cellId;
+  }
+}
+
+vtkSmartPointer<vtkPolyData> mitk::SurfaceCuttingIndex::ExtractCellsIntersectingPlane(const double origin[3], const double normal[3])
+{
+  vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+  if (m_Input == NULL || m_Input->GetNumberOfCells() == 0 || m_Input->GetPoints() == NULL)
+    return output;
+
+  double unitNormal[3] = { normal[0], normal[1], normal[2] };
+  if (vtkMath::Normalize(unitNormal) == 0.0)
+    return output;
+
+  // GetCellPoints() and GetCellType() require the cell structure of the input
+  if (m_Input->NeedToBuildCells())
+    m_Input->BuildCells();
+
+  bool isNew = false;
+  PlaneDirectionCache<DirectionIndex>::Direction& direction = m_Indices.GetDirection(unitNormal, isNew);
+  if (isNew)
+    this->BuildDirectionIndex(direction.Index, direction.Normal);
+  const DirectionIndex* index = &direction.Index;
+
+  const double distance = vtkMath::Dot(origin, direction.Normal);
+  const vtkIdType numberOfSlabs = static_cast<vtkIdType>(index->SlabOffsets.size()) - 1;
+  const double slabPosition = (distance - index->RangeMin) / index->SlabWidth;
+  if (slabPosition < 0.0 || slabPosition > numberOfSlabs)
+    return output;
+  const vtkIdType slab = std::min(numberOfSlabs - 1, static_cast<vtkIdType>(slabPosition));
+
+  std::vector<vtkIdType> cells;
+  for (vtkIdType i = index->SlabOffsets[slab]; i < index->SlabOffsets[slab + 1]; ++i)
+  {
+    const vtkIdType cellId = index->SlabCells[i];
+    if (index->CellMin[cellId] <= distance && distance <= index->CellMax[cellId])
+      cells.push_back(cellId);
+  }
+  // keep the input order (verts, lines, polys, strips) so that cell data stays aligned
+  std::sort(cells.begin(), cells.end());
+
+  if (m_PointMap.size() != static_cast<std::size_t>(m_Input->GetNumberOfPoints()))
+    m_PointMap.assign(m_Input->GetNumberOfPoints(), -1);
+
+  vtkPoints* inputPoints = m_Input->GetPoints();
+  vtkPointData* inputPointData = m_Input->GetPointData();
+  vtkCellData* inputCellData = m_Input->GetCellData();
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(inputPoints->GetDataType());
+  points->Allocate(3 * cells.size());
+  output->Allocate(static_cast<vtkIdType>(cells.size()));
+  output->GetPointData()->CopyAllocate(inputPointData, static_cast<vtkIdType>(3 * cells.size()));
+  output->GetCellData()->CopyAllocate(inputCellData, static_cast<vtkIdType>(cells.size()));
+
+  std::vector<vtkIdType> usedPoints;
+  std::vector<vtkIdType> cellPoints;
+  vtkIdType npts = 0;
+  vtkIdType* pts = NULL;
+  for (std::vector<vtkIdType>::const_iterator it = cells.begin(); it != cells.end(); ++it)
+  {
+    m_Input->GetCellPoints(*it, npts, pts);
+    cellPoints.resize(npts);
+    for (vtkIdType i = 0; i < npts; ++i)
+    {
+      vtkIdType& mapped = m_PointMap[pts[i]];
+      if (mapped < 0)
+      {
+        mapped = points->InsertNextPoint(inputPoints->GetPoint(pts[i]));
+        output->GetPointData()->CopyData(inputPointData, pts[i], mapped);
+        usedPoints.push_back(pts[i]);
+      }
+      cellPoints[i] = mapped;
+    }
+    const vtkIdType newCellId = output->InsertNextCell(m_Input->GetCellType(*it), npts, cellPoints.empty() ? NULL : &cellPoints[0]);
+    output->GetCellData()->CopyData(inputCellData, *it, newCellId);
+  }
+
+  // only reset the entries that were touched, the map is reused by the next query
+  for (std::vector<vtkIdType>::const_iterator it = usedPoints.begin(); it != usedPoints.end(); ++it)
+    m_PointMap[*it] = -1;
+
+  output->SetPoints(points);
+  output->Squeeze();
+  return output;
+}
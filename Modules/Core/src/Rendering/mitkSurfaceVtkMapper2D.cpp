@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCoreServices.h>
 #include <mitkIPropertyAliases.h>
 #include <mitkIPropertyDescriptions.h>
+#include <mitkSurfaceCuttingIndex.h>
 
 //vtk includes
 #include <vtkActor.h>
@@ -104,6 +105,8 @@ const mitk::Surface* mitk::SurfaceVtkMapper2D::GetInput() const
 // constructor PointSetVtkMapper2D
 mitk::SurfaceVtkMapper2D::SurfaceVtkMapper2D()
 {
+  m_TransformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  m_CuttingIndex = SurfaceCuttingIndex::New();
 }
 
 mitk::SurfaceVtkMapper2D::~SurfaceVtkMapper2D()
@@ -211,11 +214,18 @@ void mitk::SurfaceVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *rend
   localStorage->m_CuttingPlane->SetNormal(normal);
   //Transform the data according to its geometry.
   //See UpdateVtkTransform documentation for details.
+  //The transformed data and the cutting index are shared by all renderers,
+  //the filter only re-executes if the input or the transform was modified.
   vtkSmartPointer<vtkLinearTransform> vtktransform = GetDataNode()->GetVtkTransform(this->GetTimestep());
-  vtkSmartPointer<vtkTransformPolyDataFilter> filter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  filter->SetTransform(vtktransform);
-  filter->SetInputData(inputPolyData);
-  localStorage->m_Cutter->SetInputConnection(filter->GetOutputPort());
+  if (m_TransformFilter->GetTransform() != vtktransform.GetPointer())
+    m_TransformFilter->SetTransform(vtktransform);
+  if (m_TransformFilter->GetInput() != inputPolyData.GetPointer())
+    m_TransformFilter->SetInputData(inputPolyData);
+  m_TransformFilter->Update();
+  m_CuttingIndex->SetInput(m_TransformFilter->GetOutput());
+
+  //Only the cells intersecting the plane are passed to the cutter
+  localStorage->m_Cutter->SetInputData(m_CuttingIndex->ExtractCellsIntersectingPlane(origin, normal));
   localStorage->m_Cutter->Update();
 
   bool generateNormals = false;
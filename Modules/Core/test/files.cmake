@@ -40,6 +40,7 @@ set(MODULE_TESTS
   mitkImageEqualTest.cpp
   mitkImageDataItemTest.cpp
   mitkImageGeneratorTest.cpp
+  mitkImageStatisticsHolderTest.cpp
   mitkIOUtilTest.cpp
   mitkBaseDataTest.cpp
   mitkImportItkImageTest.cpp
@@ -58,6 +59,8 @@ set(MODULE_TESTS
   mitkPointSetReaderTest.cpp
   mitkPointSetInteractorTest.cpp
   mitkPointSetPointOperationsTest.cpp
+  mitkPlaneDirectionCacheTest.cpp
+  mitkPointSetSlabIndexTest.cpp
   mitkProgressBarTest.cpp
   mitkPropertyTest.cpp
   mitkPropertyListTest.cpp
@@ -67,6 +70,7 @@ set(MODULE_TESTS
   mitkStateTest.cpp
   mitkSurfaceTest.cpp
   mitkSurfaceEqualTest.cpp
+  mitkSurfaceCuttingIndexTest.cpp
   mitkSurfaceToSurfaceFilterTest.cpp
   mitkTimeGeometryTest.cpp
   mitkProportionalTimeGeometryTest.cpp
@@ -22,6 +22,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImage.h>
 #include <mitkCustomMimeType.h>
 
+#include <usModule.h>
+#include <usModuleContext.h>
+#include <usModuleRegistry.h>
+
 class DummyReader : public mitk::AbstractFileReader
 {
 public:
@@ -215,6 +219,47 @@ int mitkFileReaderRegistryTest(int /*argc*/ , char* /*argv*/[])
   // of the dummy readers.
   //delete readerRegistry;
 
+  // Reader references are cached per mime-type and the cache follows reader registrations
+  {
+    DummyReader cachedDR("application/dummy-cache", "cachetest", 10);
+
+    mitk::MimeType mimeType = mitk::FileReaderRegistry::GetMimeTypeForFile("/this/is/a/folder/file.CacheTest");
+    MITK_TEST_CONDITION_REQUIRED(mimeType.GetName() == "application/dummy-cache", "Testing case-insensitive mime-type lookup by extension");
+
+    mitk::FileReaderRegistry::ResetLookupStatistics();
+    MITK_TEST_CONDITION_REQUIRED(mitk::FileReaderRegistry::GetReferences(mimeType).size() == 1, "Testing reader lookup");
+    MITK_TEST_CONDITION_REQUIRED(mitk::FileReaderRegistry::GetReferences(mimeType).size() == 1, "Testing repeated reader lookup");
+    mitk::FileReaderRegistry::LookupStatistics statistics = mitk::FileReaderRegistry::GetLookupStatistics();
+    MITK_TEST_CONDITION(statistics.referenceLookups == 2 && statistics.referenceCacheHits == 1, "Testing repeated reader lookup hits the cache");
+
+    // the cache must not hand out references looked up through another module context
+    us::ModuleContext* coreContext = us::ModuleRegistry::GetModule("MitkCore")->GetModuleContext();
+    us::ModuleContext* otherContext = NULL;
+    std::vector<us::Module*> modules = us::ModuleRegistry::GetLoadedModules();
+    for (std::vector<us::Module*>::const_iterator iter = modules.begin(); iter != modules.end() && otherContext == NULL; ++iter)
+    {
+      if ((*iter)->GetModuleContext() != coreContext) otherContext = (*iter)->GetModuleContext();
+    }
+    if (otherContext != NULL)
+    {
+      MITK_TEST_CONDITION_REQUIRED(mitk::FileReaderRegistry::GetReferences(mimeType, otherContext).size() == 1, "Testing reader lookup with another module context");
+      MITK_TEST_CONDITION_REQUIRED(mitk::FileReaderRegistry::GetReferences(mimeType, otherContext).size() == 1, "Testing repeated reader lookup with another module context");
+      statistics = mitk::FileReaderRegistry::GetLookupStatistics();
+      MITK_TEST_CONDITION(statistics.referenceLookups == 4 && statistics.referenceCacheHits == 2, "Testing reader references are cached per module context");
+      {
+        DummyReader2 otherCachedDR("application/dummy-cache", "cachetest", 20);
+        MITK_TEST_CONDITION(mitk::FileReaderRegistry::GetReferences(mimeType, otherContext).size() == 2, "Testing registering a reader invalidates the cache of another module context");
+      }
+      MITK_TEST_CONDITION(mitk::FileReaderRegistry::GetReferences(mimeType, otherContext).size() == 1, "Testing unregistering a reader invalidates the cache of another module context");
+    }
+
+    {
+      DummyReader2 otherCachedDR("application/dummy-cache", "cachetest", 20);
+      MITK_TEST_CONDITION(mitk::FileReaderRegistry::GetReferences(mimeType).size() == 2, "Testing registering a reader invalidates the cache");
+    }
+    MITK_TEST_CONDITION(mitk::FileReaderRegistry::GetReferences(mimeType).size() == 1, "Testing unregistering a reader invalidates the cache");
+  }
+
   // always end with this!
   MITK_TEST_END();
 }
@@ -0,0 +1,115 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkImageStatisticsHolder.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+class mitkImageStatisticsHolderTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageStatisticsHolderTestSuite);
+  MITK_TEST(GetScalarValues_AllTimeSteps);
+  MITK_TEST(GetScalarValues_ModifiedImage_Recomputed);
+  MITK_TEST(ComputeImageStatisticsAsynchronously_SameResults);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::Image::Pointer m_Image;
+
+  // 100x80x6 voxels, so the volumes are split into several blocks
+  void FillTimeStep(int t, short offset)
+  {
+    mitk::ImageWriteAccessor accessor(m_Image, m_Image->GetVolumeData(t));
+    short* values = static_cast<short*>(accessor.GetData());
+    const int numberOfValues = 100 * 80 * 6;
+    for (int i = 0; i < numberOfValues; ++i)
+      values[i] = offset + static_cast<short>(i % 1000);
+    values[numberOfValues - 1] = offset - 5; // single minimum in the last block
+  }
+
+public:
+  void setUp() override
+  {
+    unsigned int dimensions[4] = { 100, 80, 6, 3 };
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<short>(), 4, dimensions);
+    this->FillTimeStep(0, 0);
+    this->FillTimeStep(1, 100);
+
+    mitk::ImageWriteAccessor accessor(m_Image, m_Image->GetVolumeData(2));
+    short* values = static_cast<short*>(accessor.GetData());
+    std::fill(values, values + 100 * 80 * 6, short(7));
+  }
+
+  void tearDown() override
+  {
+    m_Image = NULL;
+  }
+
+  void GetScalarValues_AllTimeSteps()
+  {
+    mitk::ImageStatisticsHolder* statistics = m_Image->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(-5.0, statistics->GetScalarValueMin(0));
+    CPPUNIT_ASSERT_EQUAL(0.0, statistics->GetScalarValue2ndMin(0));
+    CPPUNIT_ASSERT_EQUAL(999.0, statistics->GetScalarValueMax(0));
+    CPPUNIT_ASSERT_EQUAL(998.0, statistics->GetScalarValue2ndMax(0));
+    CPPUNIT_ASSERT_EQUAL(1.0, statistics->GetCountOfMinValuedVoxels(0));
+    CPPUNIT_ASSERT_EQUAL(47.0, statistics->GetCountOfMaxValuedVoxels(0));
+
+    CPPUNIT_ASSERT_MESSAGE("All time steps are computed at once", statistics->GetScalarValueMinNoRecompute(1) == 95.0);
+    CPPUNIT_ASSERT_EQUAL(1099.0, statistics->GetScalarValueMax(1));
+
+    CPPUNIT_ASSERT_EQUAL(7.0, statistics->GetScalarValueMin(2));
+    CPPUNIT_ASSERT_EQUAL(7.0, statistics->GetScalarValue2ndMin(2));
+    CPPUNIT_ASSERT_EQUAL(7.0, statistics->GetScalarValue2ndMax(2));
+    CPPUNIT_ASSERT_EQUAL(48000.0, statistics->GetCountOfMaxValuedVoxels(2));
+  }
+
+  void GetScalarValues_ModifiedImage_Recomputed()
+  {
+    mitk::ImageStatisticsHolder* statistics = m_Image->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(-5.0, statistics->GetScalarValueMin(0));
+
+    this->FillTimeStep(0, -20);
+    CPPUNIT_ASSERT_MESSAGE("Unmodified image keeps the cached values", statistics->GetScalarValueMin(0) == -5.0);
+
+    m_Image->Modified();
+    CPPUNIT_ASSERT_EQUAL(-25.0, statistics->GetScalarValueMin(0));
+    CPPUNIT_ASSERT_EQUAL(95.0, statistics->GetScalarValueMin(1));
+  }
+
+  void ComputeImageStatisticsAsynchronously_SameResults()
+  {
+    mitk::ImageStatisticsHolder* statistics = m_Image->GetStatistics();
+    std::atomic<bool> finished(false);
+    statistics->ComputeImageStatisticsAsynchronously([&finished]() { finished = true; });
+
+    CPPUNIT_ASSERT_EQUAL(-5.0, statistics->GetScalarValueMin(0));
+    while (!finished)
+      std::this_thread::yield();
+    CPPUNIT_ASSERT_MESSAGE("Results are published", !statistics->IsComputingImageStatistics());
+    CPPUNIT_ASSERT_EQUAL(998.0, statistics->GetScalarValue2ndMax(0));
+    CPPUNIT_ASSERT_EQUAL(95.0, statistics->GetScalarValueMin(1));
+    CPPUNIT_ASSERT_EQUAL(48000.0, statistics->GetCountOfMinValuedVoxels(2));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageStatisticsHolder)
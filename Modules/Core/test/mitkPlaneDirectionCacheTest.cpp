@@ -0,0 +1,106 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkPlaneDirectionCache.h>
+
+class mitkPlaneDirectionCacheTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkPlaneDirectionCacheTestSuite);
+  MITK_TEST(GetDirection_SameNormal_IsCached);
+  MITK_TEST(GetDirection_OppositeNormal_SharesEntry);
+  MITK_TEST(GetDirection_TooManyNormals_ReplacesLeastRecentlyUsed);
+  MITK_TEST(Clear_DropsAllEntries);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef mitk::PlaneDirectionCache<int> CacheType;
+
+  /** Returns the entry for the normal and marks new entries with the given value. */
+  int Get(CacheType& cache, double x, double y, double z, int newValue)
+  {
+    const double normal[3] = { x, y, z };
+    bool isNew = false;
+    CacheType::Direction& direction = cache.GetDirection(normal, isNew);
+    if (isNew)
+      direction.Index = newValue;
+    return direction.Index;
+  }
+
+public:
+  void GetDirection_SameNormal_IsCached()
+  {
+    CacheType cache;
+    CPPUNIT_ASSERT_EQUAL(0u, cache.GetNumberOfDirections());
+    CPPUNIT_ASSERT_EQUAL(1, this->Get(cache, 0, 0, 1, 1));
+    CPPUNIT_ASSERT_EQUAL(2, this->Get(cache, 1, 0, 0, 2));
+    CPPUNIT_ASSERT_EQUAL(1, this->Get(cache, 0, 0, 1, 3));
+    CPPUNIT_ASSERT_EQUAL(2u, cache.GetNumberOfDirections());
+  }
+
+  void GetDirection_OppositeNormal_SharesEntry()
+  {
+    CacheType cache;
+    this->Get(cache, 0.6, 0.8, 0, 1);
+
+    const double opposite[3] = { -0.6, -0.8, 0 };
+    bool isNew = true;
+    CacheType::Direction& direction = cache.GetDirection(opposite, isNew);
+    CPPUNIT_ASSERT_MESSAGE("Opposite normal is found", !isNew);
+    CPPUNIT_ASSERT_EQUAL(1, direction.Index);
+    CPPUNIT_ASSERT_MESSAGE("Entry keeps the normal it was built for", direction.Normal[0] == 0.6 && direction.Normal[1] == 0.8);
+    CPPUNIT_ASSERT_EQUAL(1u, cache.GetNumberOfDirections());
+  }
+
+  void GetDirection_TooManyNormals_ReplacesLeastRecentlyUsed()
+  {
+    CacheType cache;
+    cache.SetMaximumNumberOfDirections(2);
+    this->Get(cache, 1, 0, 0, 1);
+    this->Get(cache, 0, 1, 0, 2);
+    // use x again, so y is the least recently used normal
+    this->Get(cache, 1, 0, 0, 0);
+    this->Get(cache, 0, 0, 1, 3);
+
+    CPPUNIT_ASSERT_EQUAL(2u, cache.GetNumberOfDirections());
+    CPPUNIT_ASSERT_EQUAL(1, this->Get(cache, 1, 0, 0, 0));
+    CPPUNIT_ASSERT_EQUAL(3, this->Get(cache, 0, 0, 1, 0));
+    CPPUNIT_ASSERT_MESSAGE("Replaced normal is built again", this->Get(cache, 0, 1, 0, 4) == 4);
+
+    cache.SetMaximumNumberOfDirections(1);
+    CPPUNIT_ASSERT_EQUAL(1u, cache.GetNumberOfDirections());
+    CPPUNIT_ASSERT_EQUAL(4, this->Get(cache, 0, 1, 0, 0));
+
+    // at least one normal is always kept
+    cache.SetMaximumNumberOfDirections(0);
+    CPPUNIT_ASSERT_EQUAL(4, this->Get(cache, 0, 1, 0, 0));
+    CPPUNIT_ASSERT_EQUAL(5, this->Get(cache, 1, 0, 0, 5));
+    CPPUNIT_ASSERT_EQUAL(1u, cache.GetNumberOfDirections());
+  }
+
+  void Clear_DropsAllEntries()
+  {
+    CacheType cache;
+    this->Get(cache, 1, 0, 0, 1);
+    this->Get(cache, 0, 1, 0, 2);
+    cache.Clear();
+    CPPUNIT_ASSERT_EQUAL(0u, cache.GetNumberOfDirections());
+    CPPUNIT_ASSERT_EQUAL(3, this->Get(cache, 1, 0, 0, 3));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkPlaneDirectionCache)
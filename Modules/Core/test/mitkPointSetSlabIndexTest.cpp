@@ -0,0 +1,133 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkPointSetSlabIndex.h>
+#include <mitkPlaneGeometry.h>
+
+#include <cstdlib>
+
+class mitkPointSetSlabIndexTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkPointSetSlabIndexTestSuite);
+  MITK_TEST(SetInput_PointIdsAndSelection_AreIndexed);
+  MITK_TEST(FindPointsNearPlane_TransformedGeometry);
+  MITK_TEST(SetInput_TimeStep_IndexesThatTimeStep);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::PointSet::Pointer m_PointSet;
+  mitk::PointSetSlabIndex::Pointer m_Index;
+
+  mitk::PlaneGeometry::Pointer CreatePlane(double x, double y, double z, double nx, double ny, double nz)
+  {
+    mitk::Point3D origin;
+    origin[0] = x; origin[1] = y; origin[2] = z;
+    mitk::Vector3D normal;
+    normal[0] = nx; normal[1] = ny; normal[2] = nz;
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializePlane(origin, normal);
+    return plane;
+  }
+
+  std::vector<std::size_t> FindAllPointsNearPlane(const mitk::PlaneGeometry* plane, mitk::ScalarType maxDistance)
+  {
+    std::vector<std::size_t> positions;
+    for (std::size_t i = 0; i < m_Index->GetNumberOfPoints(); ++i)
+    {
+      if (plane->Distance(m_Index->GetWorldPoint(i)) < maxDistance)
+        positions.push_back(i);
+    }
+    return positions;
+  }
+
+public:
+  void setUp() override
+  {
+    std::srand(42);
+    m_PointSet = mitk::PointSet::New();
+    for (int i = 0; i < 2000; ++i)
+    {
+      mitk::Point3D point;
+      point[0] = -50.0 + 100.0 * std::rand() / RAND_MAX;
+      point[1] = -50.0 + 100.0 * std::rand() / RAND_MAX;
+      point[2] = -50.0 + 100.0 * std::rand() / RAND_MAX;
+      m_PointSet->InsertPoint(i, point);
+    }
+    m_PointSet->SetSelectInfo(7, true);
+
+    m_Index = mitk::PointSetSlabIndex::New();
+    m_Index->SetInput(m_PointSet);
+  }
+
+  void tearDown() override
+  {
+    m_Index = NULL;
+    m_PointSet = NULL;
+  }
+
+  void SetInput_PointIdsAndSelection_AreIndexed()
+  {
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2000), m_Index->GetNumberOfPoints());
+    CPPUNIT_ASSERT_MESSAGE("Selection state is indexed", m_Index->IsPointSelected(7) && !m_Index->IsPointSelected(8));
+
+    mitk::Point3D point;
+    point.Fill(0.0);
+    m_PointSet->InsertPoint(5000, point);
+    m_Index->SetInput(m_PointSet);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2001), m_Index->GetNumberOfPoints());
+    CPPUNIT_ASSERT_EQUAL(mitk::PointSet::PointIdentifier(5000), m_Index->GetPointId(2000));
+  }
+
+  void FindPointsNearPlane_TransformedGeometry()
+  {
+    mitk::Vector3D offset;
+    offset[0] = 0.0; offset[1] = 0.0; offset[2] = 1000.0;
+    m_PointSet->GetGeometry()->Translate(offset);
+    m_Index->SetInput(m_PointSet);
+
+    std::vector<std::size_t> positions;
+    mitk::PlaneGeometry::Pointer plane = this->CreatePlane(0, 0, 0, 0, 0, 1);
+    m_Index->FindPointsNearPlane(plane, 4.0, positions);
+    CPPUNIT_ASSERT_MESSAGE("All points moved away from the plane", positions.empty());
+
+    plane = this->CreatePlane(0, 0, 1000.0, 0, 0, 1);
+    m_Index->FindPointsNearPlane(plane, 4.0, positions);
+    CPPUNIT_ASSERT_MESSAGE("Points found at their transformed position", !positions.empty());
+    CPPUNIT_ASSERT_MESSAGE("Same points as testing all points", positions == this->FindAllPointsNearPlane(plane, 4.0));
+  }
+
+  void SetInput_TimeStep_IndexesThatTimeStep()
+  {
+    m_PointSet->Expand(2);
+    mitk::Point3D point;
+    point.Fill(10.0);
+    m_PointSet->InsertPoint(0, point, 1);
+
+    m_Index->SetInput(m_PointSet, 1);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), m_Index->GetNumberOfPoints());
+
+    std::vector<std::size_t> positions;
+    m_Index->FindPointsNearPlane(this->CreatePlane(0, 0, 10.0, 0, 0, 1), 1.0, positions);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), positions.size());
+
+    m_Index->SetInput(m_PointSet, 0);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2000), m_Index->GetNumberOfPoints());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkPointSetSlabIndex)
@@ -0,0 +1,127 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkSurfaceCuttingIndex.h>
+
+#include <vtkCutter.h>
+#include <vtkPlane.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+class mitkSurfaceCuttingIndexTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkSurfaceCuttingIndexTestSuite);
+  MITK_TEST(ExtractCells_SameContourAsFullCut);
+  MITK_TEST(ExtractCells_PlaneOutsideSurface_IsEmpty);
+  MITK_TEST(ExtractCells_OppositeNormal_SharesIndex);
+  MITK_TEST(SetInput_ModifiedInput_DropsIndices);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  vtkSmartPointer<vtkPolyData> m_Sphere;
+  mitk::SurfaceCuttingIndex::Pointer m_Index;
+
+  vtkSmartPointer<vtkPolyData> Cut(vtkPolyData* polyData, const double origin[3], const double normal[3])
+  {
+    vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
+    plane->SetOrigin(origin[0], origin[1], origin[2]);
+    plane->SetNormal(normal[0], normal[1], normal[2]);
+    vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
+    cutter->SetCutFunction(plane);
+    cutter->SetInputData(polyData);
+    cutter->Update();
+    vtkSmartPointer<vtkPolyData> result = cutter->GetOutput();
+    return result;
+  }
+
+public:
+  void setUp() override
+  {
+    vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
+    sphereSource->SetCenter(10.0, -5.0, 3.0);
+    sphereSource->SetRadius(20.0);
+    sphereSource->SetThetaResolution(64);
+    sphereSource->SetPhiResolution(64);
+    sphereSource->Update();
+    m_Sphere = sphereSource->GetOutput();
+
+    m_Index = mitk::SurfaceCuttingIndex::New();
+    m_Index->SetInput(m_Sphere);
+  }
+
+  void tearDown() override
+  {
+    m_Index = NULL;
+    m_Sphere = NULL;
+  }
+
+  void ExtractCells_SameContourAsFullCut()
+  {
+    double normals[3][3] = { { 0, 0, 1 }, { 0, 1, 0 }, { 0.3, 0.4, 0.866 } };
+    for (int n = 0; n < 3; ++n)
+    {
+      for (double z = -16.0; z <= 22.0; z += 1.7)
+      {
+        double origin[3] = { 10.0 + z * normals[n][0], -5.0 + z * normals[n][1], 3.0 + z * normals[n][2] };
+        vtkSmartPointer<vtkPolyData> candidates = m_Index->ExtractCellsIntersectingPlane(origin, normals[n]);
+        CPPUNIT_ASSERT_MESSAGE("Only a subset of the cells is extracted", candidates->GetNumberOfCells() < m_Sphere->GetNumberOfCells());
+
+        vtkSmartPointer<vtkPolyData> expected = this->Cut(m_Sphere, origin, normals[n]);
+        vtkSmartPointer<vtkPolyData> actual = this->Cut(candidates, origin, normals[n]);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Same number of contour lines", expected->GetNumberOfCells(), actual->GetNumberOfCells());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Same number of contour points", expected->GetNumberOfPoints(), actual->GetNumberOfPoints());
+      }
+    }
+    CPPUNIT_ASSERT_EQUAL(3u, m_Index->GetNumberOfDirections());
+  }
+
+  void ExtractCells_PlaneOutsideSurface_IsEmpty()
+  {
+    double origin[3] = { 0.0, 0.0, 100.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    CPPUNIT_ASSERT_EQUAL(vtkIdType(0), m_Index->ExtractCellsIntersectingPlane(origin, normal)->GetNumberOfCells());
+  }
+
+  void ExtractCells_OppositeNormal_SharesIndex()
+  {
+    double origin[3] = { 10.0, -5.0, 3.0 };
+    double normal[3] = { 1.0, 0.0, 0.0 };
+    double oppositeNormal[3] = { -1.0, 0.0, 0.0 };
+    vtkIdType numberOfCells = m_Index->ExtractCellsIntersectingPlane(origin, normal)->GetNumberOfCells();
+    CPPUNIT_ASSERT_EQUAL(numberOfCells, m_Index->ExtractCellsIntersectingPlane(origin, oppositeNormal)->GetNumberOfCells());
+    CPPUNIT_ASSERT_EQUAL(1u, m_Index->GetNumberOfDirections());
+  }
+
+  void SetInput_ModifiedInput_DropsIndices()
+  {
+    double origin[3] = { 10.0, -5.0, 3.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    m_Index->ExtractCellsIntersectingPlane(origin, normal);
+    CPPUNIT_ASSERT_EQUAL(1u, m_Index->GetNumberOfDirections());
+
+    m_Index->SetInput(m_Sphere);
+    CPPUNIT_ASSERT_MESSAGE("Unmodified input keeps the index", m_Index->GetNumberOfDirections() == 1);
+
+    m_Sphere->Modified();
+    m_Index->SetInput(m_Sphere);
+    CPPUNIT_ASSERT_MESSAGE("Modified input drops the index", m_Index->GetNumberOfDirections() == 0);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkSurfaceCuttingIndex)
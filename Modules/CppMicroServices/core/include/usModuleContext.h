@@ -30,6 +30,7 @@
 #include "usServiceRegistration.h"
 #include "usServiceException.h"
 #include "usModuleEvent.h"
+#include "usServiceRegistryStatistics.h"
 
 US_BEGIN_NAMESPACE
 
@@ -811,6 +812,30 @@ public:
                          static_cast<void*>(receiver));
   }
 
+  /**
+   * Returns the lookup counters of the framework service registry.
+   *
+   * The counters are shared by all modules of the framework and are
+   * meant for profiling service lookups.
+   *
+   * @return A snapshot of the service registry counters.
+   * @throws std::logic_error If this ModuleContext is no
+   *         longer valid.
+   *
+   * @see ResetServiceRegistryStatistics()
+   */
+  ServiceRegistryStatistics GetServiceRegistryStatistics() const;
+
+  /**
+   * Resets all counters of the framework service registry to zero.
+   *
+   * @throws std::logic_error If this ModuleContext is no
+   *         longer valid.
+   *
+   * @see GetServiceRegistryStatistics()
+   */
+  void ResetServiceRegistryStatistics();
+
   /**
    * Get the absolute path for a file or directory in the persistent
    * storage area provided for the module. The returned path
@@ -0,0 +1,65 @@
+/*=============================================================================
+
+  Library: CppMicroServices
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef USSERVICEREGISTRYSTATISTICS_H
+#define USSERVICEREGISTRYSTATISTICS_H
+
+#include <usCoreConfig.h>
+
+US_BEGIN_NAMESPACE
+
+/**
+ * \ingroup MicroServices
+ *
+ * Counters describing the service lookups of the framework service registry,
+ * intended for profiling.
+ *
+ * All counters start at zero when the framework is initialized and can be
+ * reset with ModuleContext::ResetServiceRegistryStatistics().
+ *
+ * @see ModuleContext::GetServiceRegistryStatistics()
+ */
+struct ServiceRegistryStatistics
+{
+  ServiceRegistryStatistics()
+    : lookupCount(0)
+    , indexedLookupCount(0)
+    , filterEvaluationCount(0)
+    , lockWaitTimeMicroseconds(0)
+  {}
+
+  /** Number of service reference lookups (with or without filter). */
+  long lookupCount;
+
+  /** Number of filtered lookups which used the property value index. */
+  long indexedLookupCount;
+
+  /** Number of LDAP filter evaluations against service properties. */
+  long filterEvaluationCount;
+
+  /** Accumulated time spent waiting for the registry lock. */
+  long lockWaitTimeMicroseconds;
+};
+
+US_END_NAMESPACE
+
+#endif // USSERVICEREGISTRYSTATISTICS_H
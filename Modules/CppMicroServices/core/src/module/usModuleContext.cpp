@@ -166,6 +166,16 @@ void ModuleContext::RemoveModuleListener(const ModuleListener& delegate, void* d
   d->module->coreCtx->listeners.RemoveModuleListener(this, delegate, data);
 }
 
+ServiceRegistryStatistics ModuleContext::GetServiceRegistryStatistics() const
+{
+  return d->module->coreCtx->services.GetStatistics();
+}
+
+void ModuleContext::ResetServiceRegistryStatistics()
+{
+  d->module->coreCtx->services.ResetStatistics();
+}
+
 std::string ModuleContext::GetDataFile(const std::string &filename) const
 {
   // compute the module storage path
@@ -324,6 +324,56 @@ bool LDAPExpr::IsSimple(const StringList& keywords, LocalCache& cache,
   return false;
 }
 
+bool LDAPExpr::GetEqualityTerm(std::string& attrName, StringList& values) const
+{
+  if (d->m_operator == EQ)
+  {
+    if (d->m_attrValue.find(LDAPExprConstants::WILDCARD()) != std::string::npos)
+    {
+      return false;
+    }
+    attrName = ToLower(d->m_attrName);
+    values.assign(1, d->m_attrValue);
+    return true;
+  }
+  else if (d->m_operator == OR)
+  {
+    // all operands must constrain the same attribute
+    StringList result;
+    std::string name;
+    for (std::size_t i = 0; i < d->m_args.size(); i++)
+    {
+      std::string argName;
+      StringList argValues;
+      if (!d->m_args[i].GetEqualityTerm(argName, argValues) ||
+          (i > 0 && argName != name))
+      {
+        return false;
+      }
+      name = argName;
+      result.insert(result.end(), argValues.begin(), argValues.end());
+    }
+    if (result.empty())
+    {
+      return false;
+    }
+    attrName = name;
+    values.swap(result);
+    return true;
+  }
+  else if (d->m_operator == AND)
+  {
+    for (std::size_t i = 0; i < d->m_args.size(); i++)
+    {
+      if (d->m_args[i].GetEqualityTerm(attrName, values))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 bool LDAPExpr::IsNull() const
 {
   return !d;
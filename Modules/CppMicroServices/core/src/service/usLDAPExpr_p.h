@@ -110,6 +110,20 @@ public:
     LocalCache& cache,
     bool matchCase) const;
 
+  /**
+   * Get an equality term which must be satisfied by every match of this
+   * LDAP expression. This is either the expression itself if it is of the
+   * form <code>(<it>name</it>=<it>value</it>)</code> without wildcards, a
+   * disjunction of such expressions on the same attribute, or the first
+   * such term of a conjunction. Expressions containing a negation at the
+   * top level never yield a term.
+   *
+   * \param attrName The lower case attribute name of the term.
+   * \param values The attribute values, one of which must match.
+   * \return <code>true</code> if an equality term was found, <code>false</code> otherwise.
+   */
+  bool GetEqualityTerm(std::string& attrName, StringList& values) const;
+
   /**
    * Returns <code>true</code> if this instance is invalid, i.e. it was
    * constructed using LDAPExpr().
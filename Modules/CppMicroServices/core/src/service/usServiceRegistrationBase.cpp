@@ -110,6 +110,7 @@ void ServiceRegistrationBase::SetProperties(const ServiceProperties& props)
       int new_rank = 0;
 
       std::vector<std::string> classes;
+      ServicePropertiesImpl newProperties = ServicePropertiesImpl(ServiceProperties());
       {
         MutexLock lock3(d->propsLock);
 
@@ -122,6 +123,7 @@ void ServiceRegistrationBase::SetProperties(const ServiceProperties& props)
         classes = ref_any_cast<std::vector<std::string> >(d->properties.Value(ServiceConstants::OBJECTCLASS()));
         long int sid = any_cast<long int>(d->properties.Value(ServiceConstants::SERVICE_ID()));
         d->properties = ServiceRegistry::CreateServiceProperties(props, classes, false, false, sid);
+        newProperties = d->properties;
 
         {
           const Any& any = d->properties.Value(ServiceConstants::SERVICE_RANKING());
@@ -129,6 +131,8 @@ void ServiceRegistrationBase::SetProperties(const ServiceProperties& props)
         }
       }
 
+      d->module->coreCtx->services.UpdateServiceRegistrationProperties(*this, newProperties);
+
       if (old_rank != new_rank)
       {
         d->module->coreCtx->services.UpdateServiceRegistrationOrder(*this, classes);
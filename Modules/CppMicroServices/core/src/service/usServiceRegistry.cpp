@@ -22,6 +22,7 @@
 #include <iterator>
 #include <stdexcept>
 #include <cassert>
+#include <list>
 
 #include "usServiceRegistry_p.h"
 #include "usServiceFactory.h"
@@ -31,9 +32,110 @@
 #include "usModulePrivate.h"
 #include "usCoreModuleContext_p.h"
 
+#ifdef US_ENABLE_THREADING_SUPPORT
+  #if defined(US_PLATFORM_APPLE)
+    #include <mach/mach_time.h>
+  #elif defined(US_PLATFORM_POSIX)
+    #include <time.h>
+  #endif
+#endif
+
 
 US_BEGIN_NAMESPACE
 
+namespace {
+
+// Upper bound for the number of parsed filters kept by the registry
+const std::size_t MaxCachedFilters = 1024;
+
+#ifdef US_ENABLE_THREADING_SUPPORT
+long long GetMonotonicMicroseconds()
+{
+#if defined(US_PLATFORM_WINDOWS)
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  ::QueryPerformanceFrequency(&frequency);
+  ::QueryPerformanceCounter(&counter);
+  return (counter.QuadPart / frequency.QuadPart) * 1000000 +
+      (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#elif defined(US_PLATFORM_APPLE)
+  static mach_timebase_info_data_t timeBase = { 0, 0 };
+  if (timeBase.denom == 0) mach_timebase_info(&timeBase);
+  return static_cast<long long>(mach_absolute_time() * timeBase.numer / timeBase.denom / 1000);
+#else
+  timespec current;
+  clock_gettime(CLOCK_MONOTONIC, &current);
+  return static_cast<long long>(current.tv_sec) * 1000000 + current.tv_nsec / 1000;
+#endif
+}
+#endif
+
+void AddUnique(std::vector<std::string>& values, const std::string& value)
+{
+  if (std::find(values.begin(), values.end(), value) == values.end())
+  {
+    values.push_back(value);
+  }
+}
+
+}
+
+/**
+ * Acquires the registry lock for reading. Only the time of
+ * contended acquisitions is measured.
+ */
+class ServiceRegistry::ReadLocker
+{
+public:
+  ReadLocker(const ServiceRegistry& registry) : m_Registry(registry)
+  {
+    if (!m_Registry.mutex.TryLockRead())
+    {
+#ifdef US_ENABLE_THREADING_SUPPORT
+      long long start = GetMonotonicMicroseconds();
+      m_Registry.mutex.LockRead();
+      m_Registry.lockWaitTime.AtomicAdd(static_cast<AtomicCounter::IntType>(GetMonotonicMicroseconds() - start));
+#endif
+    }
+  }
+  ~ReadLocker() { m_Registry.mutex.UnlockRead(); }
+
+private:
+  const ServiceRegistry& m_Registry;
+
+  // purposely not implemented
+  ReadLocker(const ReadLocker&);
+  ReadLocker& operator=(const ReadLocker&);
+};
+
+/**
+ * Acquires the registry lock for writing. Only the time of
+ * contended acquisitions is measured.
+ */
+class ServiceRegistry::WriteLocker
+{
+public:
+  WriteLocker(const ServiceRegistry& registry) : m_Registry(registry)
+  {
+    if (!m_Registry.mutex.TryLockWrite())
+    {
+#ifdef US_ENABLE_THREADING_SUPPORT
+      long long start = GetMonotonicMicroseconds();
+      m_Registry.mutex.LockWrite();
+      m_Registry.lockWaitTime.AtomicAdd(static_cast<AtomicCounter::IntType>(GetMonotonicMicroseconds() - start));
+#endif
+    }
+  }
+  ~WriteLocker() { m_Registry.mutex.UnlockWrite(); }
+
+private:
+  const ServiceRegistry& m_Registry;
+
+  // purposely not implemented
+  WriteLocker(const WriteLocker&);
+  WriteLocker& operator=(const WriteLocker&);
+};
+
 ServicePropertiesImpl ServiceRegistry::CreateServiceProperties(const ServiceProperties& in,
                                                                const std::vector<std::string>& classes,
                                                                bool isFactory, bool isPrototypeFactory,
@@ -81,9 +183,181 @@ void ServiceRegistry::Clear()
   services.clear();
   serviceRegistrations.clear();
   classServices.clear();
+  propertyIndex.clear();
+  serviceIndexEntries.clear();
+  {
+    MutexLock lock(filterCacheMutex);
+    filterCache.clear();
+  }
   core = 0;
 }
 
+ServiceRegistry::CachedFilter ServiceRegistry::GetCachedFilter(const std::string& filter) const
+{
+  {
+    MutexLock lock(filterCacheMutex);
+    MapFilterCache::const_iterator i = filterCache.find(filter);
+    if (i != filterCache.end())
+    {
+      return i->second;
+    }
+  }
+
+  // parse outside of the lock, invalid filters throw and are not cached
+  CachedFilter cached;
+  cached.ldap = LDAPExpr(filter);
+  cached.hasEqualityTerm = cached.ldap.GetEqualityTerm(cached.attrName, cached.values);
+
+  MutexLock lock(filterCacheMutex);
+  if (filterCache.size() >= MaxCachedFilters)
+  {
+    filterCache.clear();
+  }
+  filterCache.insert(std::make_pair(filter, cached));
+  return cached;
+}
+
+void ServiceRegistry::AddToPropertyIndex_unlocked(const ServiceRegistrationBase& sr,
+                                                  const ServicePropertiesImpl& properties)
+{
+  std::vector<PropertyIndexEntry>& entries = serviceIndexEntries[sr];
+  const std::vector<std::string>& keys = properties.Keys();
+  for (std::size_t k = 0; k < keys.size(); ++k)
+  {
+    std::string key = keys[k];
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    const Any& value = properties.Value(static_cast<int>(k));
+    std::vector<std::string> strings;
+    bool indexed = true;
+    if (value.Type() == typeid(std::string))
+    {
+      strings.push_back(ref_any_cast<std::string>(value));
+    }
+    else if (value.Type() == typeid(std::vector<std::string>))
+    {
+      const std::vector<std::string>& list = ref_any_cast<std::vector<std::string> >(value);
+      for (std::size_t i = 0; i < list.size(); ++i) AddUnique(strings, list[i]);
+    }
+    else if (value.Type() == typeid(std::list<std::string>))
+    {
+      const std::list<std::string>& list = ref_any_cast<std::list<std::string> >(value);
+      for (std::list<std::string>::const_iterator i = list.begin(); i != list.end(); ++i) AddUnique(strings, *i);
+    }
+    else
+    {
+      indexed = false;
+    }
+
+    PropertyIndex& index = propertyIndex[key];
+    if (!indexed)
+    {
+      index.unindexed.push_back(sr);
+      PropertyIndexEntry entry = { key, std::string(), false };
+      entries.push_back(entry);
+      continue;
+    }
+    for (std::size_t i = 0; i < strings.size(); ++i)
+    {
+      std::vector<ServiceRegistrationBase>& regs = index.values[strings[i]];
+      // keys differing only in case may map to the same bucket
+      if (std::find(regs.begin(), regs.end(), sr) != regs.end()) continue;
+      regs.push_back(sr);
+      PropertyIndexEntry entry = { key, strings[i], true };
+      entries.push_back(entry);
+    }
+  }
+}
+
+void ServiceRegistry::RemoveFromPropertyIndex_unlocked(const ServiceRegistrationBase& sr)
+{
+  MapServiceIndexEntries::iterator entries = serviceIndexEntries.find(sr);
+  if (entries == serviceIndexEntries.end()) return;
+
+  for (std::vector<PropertyIndexEntry>::const_iterator e = entries->second.begin();
+       e != entries->second.end(); ++e)
+  {
+    MapPropertyIndex::iterator index = propertyIndex.find(e->key);
+    if (index == propertyIndex.end()) continue;
+
+    if (e->indexed)
+    {
+      MapClassServices::iterator regs = index->second.values.find(e->value);
+      if (regs == index->second.values.end()) continue;
+      regs->second.erase(std::remove(regs->second.begin(), regs->second.end(), sr), regs->second.end());
+      if (regs->second.empty()) index->second.values.erase(regs);
+    }
+    else
+    {
+      std::vector<ServiceRegistrationBase>& regs = index->second.unindexed;
+      regs.erase(std::remove(regs.begin(), regs.end(), sr), regs.end());
+    }
+    if (index->second.values.empty() && index->second.unindexed.empty())
+    {
+      propertyIndex.erase(index);
+    }
+  }
+  serviceIndexEntries.erase(entries);
+}
+
+bool ServiceRegistry::GetIndexedCandidates_unlocked(const std::string& clazz, const CachedFilter& filter,
+                                                    const std::vector<ServiceRegistrationBase>& classRegs,
+                                                    std::vector<ServiceRegistrationBase>& candidates) const
+{
+  MapPropertyIndex::const_iterator index = propertyIndex.find(filter.attrName);
+  if (index == propertyIndex.end())
+  {
+    // no service has the property, the equality term can not match
+    return true;
+  }
+
+  std::vector<ServiceRegistrationBase> regs(index->second.unindexed);
+  for (LDAPExpr::StringList::const_iterator v = filter.values.begin(); v != filter.values.end(); ++v)
+  {
+    MapClassServices::const_iterator bucket = index->second.values.find(*v);
+    if (bucket != index->second.values.end())
+    {
+      regs.insert(regs.end(), bucket->second.begin(), bucket->second.end());
+    }
+  }
+  if (regs.size() >= classRegs.size())
+  {
+    return false;
+  }
+
+  for (std::vector<ServiceRegistrationBase>::const_iterator r = regs.begin(); r != regs.end(); ++r)
+  {
+    MapServiceClasses::const_iterator classes = services.find(*r);
+    if (classes != services.end() &&
+        std::find(classes->second.begin(), classes->second.end(), clazz) != classes->second.end())
+    {
+      candidates.push_back(*r);
+    }
+  }
+  // restore the ranking order of classServices
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  return true;
+}
+
+ServiceRegistryStatistics ServiceRegistry::GetStatistics() const
+{
+  ServiceRegistryStatistics statistics;
+  statistics.lookupCount = lookupCount.m_Counter;
+  statistics.indexedLookupCount = indexedLookupCount.m_Counter;
+  statistics.filterEvaluationCount = filterEvaluationCount.m_Counter;
+  statistics.lockWaitTimeMicroseconds = lockWaitTime.m_Counter;
+  return statistics;
+}
+
+void ServiceRegistry::ResetStatistics()
+{
+  lookupCount.AtomicAssign(lookupCount.m_Counter, 0);
+  indexedLookupCount.AtomicAssign(indexedLookupCount.m_Counter, 0);
+  filterEvaluationCount.AtomicAssign(filterEvaluationCount.m_Counter, 0);
+  lockWaitTime.AtomicAssign(lockWaitTime.m_Counter, 0);
+}
+
 ServiceRegistrationBase ServiceRegistry::RegisterService(ModulePrivate* module,
                                                      const InterfaceMap& service,
                                                      const ServiceProperties& properties)
@@ -112,9 +386,10 @@ ServiceRegistrationBase ServiceRegistry::RegisterService(ModulePrivate* module,
   ServiceRegistrationBase res(module, service,
                               CreateServiceProperties(properties, classes, isFactory, isPrototypeFactory));
   {
-    MutexLock lock(mutex);
+    WriteLocker lock(*this);
     services.insert(std::make_pair(res, classes));
     serviceRegistrations.push_back(res);
+    AddToPropertyIndex_unlocked(res, res.d->properties);
     for (std::vector<std::string>::const_iterator i = classes.begin();
          i != classes.end(); ++i)
     {
@@ -137,7 +412,7 @@ ServiceRegistrationBase ServiceRegistry::RegisterService(ModulePrivate* module,
 void ServiceRegistry::UpdateServiceRegistrationOrder(const ServiceRegistrationBase& sr,
                                                      const std::vector<std::string>& classes)
 {
-  MutexLock lock(mutex);
+  WriteLocker lock(*this);
   for (std::vector<std::string>::const_iterator i = classes.begin();
        i != classes.end(); ++i)
   {
@@ -147,10 +422,19 @@ void ServiceRegistry::UpdateServiceRegistrationOrder(const ServiceRegistrationBa
   }
 }
 
+void ServiceRegistry::UpdateServiceRegistrationProperties(const ServiceRegistrationBase& sr,
+                                                          const ServicePropertiesImpl& properties)
+{
+  WriteLocker lock(*this);
+  if (services.find(sr) == services.end()) return;
+  RemoveFromPropertyIndex_unlocked(sr);
+  AddToPropertyIndex_unlocked(sr, properties);
+}
+
 void ServiceRegistry::Get(const std::string& clazz,
                           std::vector<ServiceRegistrationBase>& serviceRegs) const
 {
-  MutexLock lock(mutex);
+  ReadLocker lock(*this);
   Get_unlocked(clazz, serviceRegs);
 }
 
@@ -166,7 +450,7 @@ void ServiceRegistry::Get_unlocked(const std::string& clazz,
 
 ServiceReferenceBase ServiceRegistry::Get(ModulePrivate* module, const std::string& clazz) const
 {
-  MutexLock lock(mutex);
+  ReadLocker lock(*this);
   try
   {
     std::vector<ServiceReferenceBase> srs;
@@ -188,13 +472,15 @@ ServiceReferenceBase ServiceRegistry::Get(ModulePrivate* module, const std::stri
 void ServiceRegistry::Get(const std::string& clazz, const std::string& filter,
                           ModulePrivate* module, std::vector<ServiceReferenceBase>& res) const
 {
-  MutexLock lock(mutex);
+  ReadLocker lock(*this);
   Get_unlocked(clazz, filter, module, res);
 }
 
 void ServiceRegistry::Get_unlocked(const std::string& clazz, const std::string& filter,
                           ModulePrivate* module, std::vector<ServiceReferenceBase>& res) const
 {
+  lookupCount.AtomicIncrement();
+
   std::vector<ServiceRegistrationBase>::const_iterator s;
   std::vector<ServiceRegistrationBase>::const_iterator send;
   std::vector<ServiceRegistrationBase> v;
@@ -203,7 +489,7 @@ void ServiceRegistry::Get_unlocked(const std::string& clazz, const std::string&
   {
     if (!filter.empty())
     {
-      ldap = LDAPExpr(filter);
+      ldap = GetCachedFilter(filter).ldap;
       LDAPExpr::ObjectClassSet matched;
       if (ldap.GetMatchedObjectClasses(matched))
       {
@@ -253,18 +539,38 @@ void ServiceRegistry::Get_unlocked(const std::string& clazz, const std::string&
     }
     if (!filter.empty())
     {
-      ldap = LDAPExpr(filter);
+      CachedFilter cached = GetCachedFilter(filter);
+      ldap = cached.ldap;
+      if (cached.hasEqualityTerm &&
+          GetIndexedCandidates_unlocked(clazz, cached, it->second, v))
+      {
+        indexedLookupCount.AtomicIncrement();
+        if (v.empty())
+        {
+          return;
+        }
+        s = v.begin();
+        send = v.end();
+      }
     }
   }
 
+  AtomicCounter::IntType evaluations = 0;
   for (; s != send; ++s)
   {
-    ServiceReferenceBase sri = s->GetReference(clazz);
-
-    if (filter.empty() || ldap.Evaluate(s->d->properties, false))
+    if (!filter.empty())
     {
-      res.push_back(sri);
+      ++evaluations;
+      if (!ldap.Evaluate(s->d->properties, false))
+      {
+        continue;
+      }
     }
+    res.push_back(s->GetReference(clazz));
+  }
+  if (evaluations > 0)
+  {
+    filterEvaluationCount.AtomicAdd(evaluations);
   }
 
   if (!res.empty())
@@ -282,11 +588,12 @@ void ServiceRegistry::Get_unlocked(const std::string& clazz, const std::string&
 
 void ServiceRegistry::RemoveServiceRegistration(const ServiceRegistrationBase& sr)
 {
-  MutexLock lock(mutex);
+  WriteLocker lock(*this);
 
   assert(sr.d->properties.Value(ServiceConstants::OBJECTCLASS()).Type() == typeid(std::vector<std::string>));
   const std::vector<std::string>& classes = ref_any_cast<std::vector<std::string> >(
         sr.d->properties.Value(ServiceConstants::OBJECTCLASS()));
+  RemoveFromPropertyIndex_unlocked(sr);
   services.erase(sr);
   serviceRegistrations.erase(std::remove(serviceRegistrations.begin(), serviceRegistrations.end(), sr),
                              serviceRegistrations.end());
@@ -308,7 +615,7 @@ void ServiceRegistry::RemoveServiceRegistration(const ServiceRegistrationBase& s
 void ServiceRegistry::GetRegisteredByModule(ModulePrivate* p,
                                             std::vector<ServiceRegistrationBase>& res) const
 {
-  MutexLock lock(mutex);
+  ReadLocker lock(*this);
 
   for (std::vector<ServiceRegistrationBase>::const_iterator i = serviceRegistrations.begin();
        i != serviceRegistrations.end(); ++i)
@@ -323,7 +630,7 @@ void ServiceRegistry::GetRegisteredByModule(ModulePrivate* p,
 void ServiceRegistry::GetUsedByModule(Module* p,
                                       std::vector<ServiceRegistrationBase>& res) const
 {
-  MutexLock lock(mutex);
+  ReadLocker lock(*this);
 
   for (std::vector<ServiceRegistrationBase>::const_iterator i = serviceRegistrations.begin();
        i != serviceRegistrations.end(); ++i)
@@ -25,7 +25,9 @@
 
 #include "usServiceInterface.h"
 #include "usServiceRegistration.h"
+#include "usServiceRegistryStatistics.h"
 
+#include "usLDAPExpr_p.h"
 #include "usThreads_p.h"
 
 US_BEGIN_NAMESPACE
@@ -43,7 +45,11 @@ class ServiceRegistry
 
 public:
 
-  typedef Mutex MutexType;
+  /**
+   * Lookups only need shared access, modifications of the
+   * registry are exclusive.
+   */
+  typedef ReadWriteMutex MutexType;
 
   mutable MutexType mutex;
 
@@ -63,6 +69,29 @@ public:
   typedef US_UNORDERED_MAP_TYPE<ServiceRegistrationBase, std::vector<std::string> > MapServiceClasses;
   typedef US_UNORDERED_MAP_TYPE<std::string, std::vector<ServiceRegistrationBase> > MapClassServices;
 
+  /**
+   * Registered services for one property key, bucketed by the
+   * string values of the property. Services whose value for the
+   * key is not a string (or list of strings) can not be bucketed
+   * and are always candidates.
+   */
+  struct PropertyIndex
+  {
+    MapClassServices values;
+    std::vector<ServiceRegistrationBase> unindexed;
+  };
+
+  typedef US_UNORDERED_MAP_TYPE<std::string, PropertyIndex> MapPropertyIndex;
+
+  struct PropertyIndexEntry
+  {
+    std::string key;
+    std::string value;
+    bool indexed;
+  };
+
+  typedef US_UNORDERED_MAP_TYPE<ServiceRegistrationBase, std::vector<PropertyIndexEntry> > MapServiceIndexEntries;
+
   /**
    * All registered services in the current framework.
    * Mapping of registered service to class names under which
@@ -79,6 +108,17 @@ public:
    */
   MapClassServices classServices;
 
+  /**
+   * Mapping of lower case property key to the services having
+   * this property, used to narrow down equality filters.
+   */
+  MapPropertyIndex propertyIndex;
+
+  /**
+   * The property index entries of each registered service.
+   */
+  MapServiceIndexEntries serviceIndexEntries;
+
   CoreModuleContext* core;
 
   ServiceRegistry(CoreModuleContext* coreCtx);
@@ -116,6 +156,15 @@ public:
   void UpdateServiceRegistrationOrder(const ServiceRegistrationBase& sr,
                                       const std::vector<std::string>& classes);
 
+  /**
+   * Service properties changed, update the property index.
+   *
+   * @param sr The ServiceRegistrationPrivate object.
+   * @param properties The new properties of the service.
+   */
+  void UpdateServiceRegistrationProperties(const ServiceRegistrationBase& sr,
+                                           const ServicePropertiesImpl& properties);
+
   /**
    * Get all services implementing a certain class.
    * Only used internally by the framework.
@@ -169,10 +218,66 @@ public:
    */
   void GetUsedByModule(Module* m, std::vector<ServiceRegistrationBase>& serviceRegs) const;
 
+  /**
+   * Get the lookup counters of this registry.
+   */
+  ServiceRegistryStatistics GetStatistics() const;
+
+  /**
+   * Reset all lookup counters to zero.
+   */
+  void ResetStatistics();
+
 private:
 
   friend class ServiceHooks;
 
+  class ReadLocker;
+  class WriteLocker;
+
+  /**
+   * A parsed filter together with its equality term, if any.
+   */
+  struct CachedFilter
+  {
+    LDAPExpr ldap;
+    bool hasEqualityTerm;
+    std::string attrName;
+    LDAPExpr::StringList values;
+  };
+
+  typedef US_UNORDERED_MAP_TYPE<std::string, CachedFilter> MapFilterCache;
+
+  /**
+   * Parsed filters by filter string. Guarded by its own mutex
+   * because it is filled during (shared) lookups.
+   */
+  mutable Mutex filterCacheMutex;
+  mutable MapFilterCache filterCache;
+
+  mutable AtomicCounter lookupCount;
+  mutable AtomicCounter indexedLookupCount;
+  mutable AtomicCounter filterEvaluationCount;
+  mutable AtomicCounter lockWaitTime;
+
+  CachedFilter GetCachedFilter(const std::string& filter) const;
+
+  void AddToPropertyIndex_unlocked(const ServiceRegistrationBase& sr,
+                                   const ServicePropertiesImpl& properties);
+
+  void RemoveFromPropertyIndex_unlocked(const ServiceRegistrationBase& sr);
+
+  /**
+   * Collect the services of class <code>clazz</code> which may satisfy the
+   * equality term of <code>filter</code>, in registration order.
+   *
+   * @return <code>false</code> if the index does not narrow down the
+   *         class services, <code>true</code> otherwise.
+   */
+  bool GetIndexedCandidates_unlocked(const std::string& clazz, const CachedFilter& filter,
+                                     const std::vector<ServiceRegistrationBase>& classRegs,
+                                     std::vector<ServiceRegistrationBase>& candidates) const;
+
   void Get_unlocked(const std::string& clazz, std::vector<ServiceRegistrationBase>& serviceRegs) const;
 
   void Get_unlocked(const std::string& clazz, const std::string& filter,
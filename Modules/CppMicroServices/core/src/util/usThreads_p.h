@@ -71,6 +71,7 @@
     #define US_ATOMIC_INCREMENT(x)        IntType n = InterlockedIncrement(x)
     #define US_ATOMIC_DECREMENT(x)        IntType n = InterlockedDecrement(x)
     #define US_ATOMIC_ASSIGN(l, r)        InterlockedExchange(l, r)
+    #define US_ATOMIC_ADD(x, v)           IntType n = InterlockedExchangeAdd(x, v) + v
 
   #elif defined(US_PLATFORM_POSIX)
 
@@ -90,17 +91,20 @@
         #define US_ATOMIC_INCREMENT(x)    IntType n = OSAtomicIncrement64Barrier(x)
         #define US_ATOMIC_DECREMENT(x)    IntType n = OSAtomicDecrement64Barrier(x)
         #define US_ATOMIC_ASSIGN(l, v)    OSAtomicCompareAndSwap64Barrier(*l, v, l)
+        #define US_ATOMIC_ADD(x, v)       IntType n = OSAtomicAdd64Barrier(v, x)
       #else
         #define US_THREADS_LONG           volatile int32_t
         #define US_ATOMIC_INCREMENT(x)    IntType n = OSAtomicIncrement32Barrier(x)
         #define US_ATOMIC_DECREMENT(x)    IntType n = OSAtomicDecrement32Barrier(x)
         #define US_ATOMIC_ASSIGN(l, v)    OSAtomicCompareAndSwap32Barrier(*l, v, l)
+        #define US_ATOMIC_ADD(x, v)       IntType n = OSAtomicAdd32Barrier(v, x)
       #endif
     #elif defined(US_ATOMIC_OPTIMIZATION_GNUC)
       #define US_THREADS_LONG             _Atomic_word
       #define US_ATOMIC_INCREMENT(x)      IntType n = __sync_add_and_fetch(x, 1)
       #define US_ATOMIC_DECREMENT(x)      IntType n = __sync_add_and_fetch(x, -1)
       #define US_ATOMIC_ASSIGN(l, v)      __sync_val_compare_and_swap(l, *l, v)
+      #define US_ATOMIC_ADD(x, v)         IntType n = __sync_add_and_fetch(x, v)
     #else
       #define US_THREADS_LONG             long
       #undef US_ATOMIC_OPTIMIZATION
@@ -113,6 +117,9 @@
       #define US_ATOMIC_ASSIGN(l, v)      m_AtomicMtx.Lock();  \
                                           *l = v;              \
                                           m_AtomicMtx.Unlock()
+      #define US_ATOMIC_ADD(x, v)         m_AtomicMtx.Lock();  \
+                                          IntType n = (*x += v); \
+                                          m_AtomicMtx.Unlock()
     #endif
 
   #endif
@@ -131,6 +138,7 @@
   #define US_ATOMIC_INCREMENT(x)        IntType n = ++(*x);
   #define US_ATOMIC_DECREMENT(x)        IntType n = --(*x);
   #define US_ATOMIC_ASSIGN(l, r)        *l = r;
+  #define US_ATOMIC_ADD(x, v)           IntType n = (*x += v);
 
 #endif
 
@@ -188,6 +196,69 @@ private:
   MutexLock& operator=(const MutexLock&);
 };
 
+/**
+ * A lock which allows concurrent read access but exclusive write access.
+ *
+ * Read locks must not be upgraded to write locks and are not recursive
+ * with respect to pending writers.
+ */
+class ReadWriteMutex
+{
+public:
+
+#ifdef US_ENABLE_THREADING_SUPPORT
+  #ifdef US_PLATFORM_WINDOWS
+  ReadWriteMutex() { ::InitializeSRWLock(&m_Lock); }
+  ~ReadWriteMutex() {}
+
+  void LockRead() { ::AcquireSRWLockShared(&m_Lock); }
+  bool TryLockRead() { return ::TryAcquireSRWLockShared(&m_Lock) != 0; }
+  void UnlockRead() { ::ReleaseSRWLockShared(&m_Lock); }
+
+  void LockWrite() { ::AcquireSRWLockExclusive(&m_Lock); }
+  bool TryLockWrite() { return ::TryAcquireSRWLockExclusive(&m_Lock) != 0; }
+  void UnlockWrite() { ::ReleaseSRWLockExclusive(&m_Lock); }
+  #else
+  ReadWriteMutex() { ::pthread_rwlock_init(&m_Lock, 0); }
+  ~ReadWriteMutex() { ::pthread_rwlock_destroy(&m_Lock); }
+
+  void LockRead() { ::pthread_rwlock_rdlock(&m_Lock); }
+  bool TryLockRead() { return ::pthread_rwlock_tryrdlock(&m_Lock) == 0; }
+  void UnlockRead() { ::pthread_rwlock_unlock(&m_Lock); }
+
+  void LockWrite() { ::pthread_rwlock_wrlock(&m_Lock); }
+  bool TryLockWrite() { return ::pthread_rwlock_trywrlock(&m_Lock) == 0; }
+  void UnlockWrite() { ::pthread_rwlock_unlock(&m_Lock); }
+  #endif
+#else
+  ReadWriteMutex() {}
+  ~ReadWriteMutex() {}
+
+  void LockRead() {}
+  bool TryLockRead() { return true; }
+  void UnlockRead() {}
+
+  void LockWrite() {}
+  bool TryLockWrite() { return true; }
+  void UnlockWrite() {}
+#endif
+
+private:
+
+  // Copy-constructor not implemented.
+  ReadWriteMutex(const ReadWriteMutex &);
+  // Copy-assignement operator not implemented.
+  ReadWriteMutex & operator = (const ReadWriteMutex &);
+
+#ifdef US_ENABLE_THREADING_SUPPORT
+  #ifdef US_PLATFORM_WINDOWS
+  SRWLOCK m_Lock;
+  #else
+  pthread_rwlock_t m_Lock;
+  #endif
+#endif
+};
+
 class AtomicCounter
 {
 public:
@@ -210,6 +281,12 @@ public:
     return n;
   }
 
+  IntType AtomicAdd(const IntType val) const
+  {
+    US_ATOMIC_ADD(&m_Counter, val);
+    return n;
+  }
+
   IntType AtomicDecrement() const
   {
     US_ATOMIC_DECREMENT(&m_Counter);
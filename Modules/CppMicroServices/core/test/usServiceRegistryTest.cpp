@@ -127,6 +127,86 @@ void TestServicePropertiesUpdate()
   US_TEST_CONDITION_REQUIRED(context->GetServiceReferences<ITestServiceA>().empty(), "Testing service count")
 }
 
+void TestIndexedFilterLookups()
+{
+  struct TestServiceA : public ITestServiceA
+  {
+  };
+
+  ModuleContext* context = GetModuleContext();
+
+  TestServiceA s1;
+  TestServiceA s2;
+  TestServiceA s3;
+  TestServiceA s4;
+
+  ServiceProperties props1;
+  props1["mime"] = std::string("application/dicom");
+  props1[ServiceConstants::SERVICE_RANKING()] = 10;
+  ServiceProperties props2;
+  std::vector<std::string> mimeTypes;
+  mimeTypes.push_back("application/nrrd");
+  mimeTypes.push_back("application/dicom");
+  props2["mime"] = mimeTypes;
+  props2[ServiceConstants::SERVICE_RANKING()] = 20;
+  ServiceProperties props3;
+  props3["mime"] = std::string("application/stl");
+  ServiceProperties props4;
+  props4["Mime"] = 5;
+
+  ServiceRegistration<ITestServiceA> reg1 = context->RegisterService<ITestServiceA>(&s1, props1);
+  ServiceRegistration<ITestServiceA> reg2 = context->RegisterService<ITestServiceA>(&s2, props2);
+  ServiceRegistration<ITestServiceA> reg3 = context->RegisterService<ITestServiceA>(&s3, props3);
+  ServiceRegistration<ITestServiceA> reg4 = context->RegisterService<ITestServiceA>(&s4, props4);
+
+  context->ResetServiceRegistryStatistics();
+
+  std::vector<ServiceReference<ITestServiceA> > refs =
+      context->GetServiceReferences<ITestServiceA>("(mime=application/dicom)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 2, "Testing equality filter on string and list properties")
+  US_TEST_CONDITION(context->GetService(refs.back()) == &s2, "Testing ranking order of indexed lookup")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(|(mime=application/stl)(mime=application/nrrd))");
+  US_TEST_CONDITION(refs.size() == 2, "Testing disjunction filter")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(&(MIME=application/dicom)(service.ranking>=15))");
+  US_TEST_CONDITION(refs.size() == 1, "Testing conjunction filter with case insensitive key")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(mime=5)");
+  US_TEST_CONDITION(refs.size() == 1 && context->GetService(refs.front()) == &s4, "Testing non-string property")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(unknown=value)");
+  US_TEST_CONDITION(refs.empty(), "Testing filter on unknown property")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(mime=application/*)");
+  US_TEST_CONDITION(refs.size() == 3, "Testing wildcard filter")
+
+  ServiceRegistryStatistics statistics = context->GetServiceRegistryStatistics();
+  US_TEST_CONDITION(statistics.lookupCount == 6, "Testing lookup count")
+  US_TEST_CONDITION(statistics.indexedLookupCount == 5, "Testing indexed lookup count")
+  US_TEST_CONDITION(statistics.filterEvaluationCount < 4 * 6, "Testing reduced filter evaluations")
+
+  // changed properties must be re-indexed
+  props3["mime"] = std::string("application/dicom");
+  reg3.SetProperties(props3);
+  refs = context->GetServiceReferences<ITestServiceA>("(mime=application/dicom)");
+  US_TEST_CONDITION(refs.size() == 3, "Testing equality filter after properties update")
+  refs = context->GetServiceReferences<ITestServiceA>("(mime=application/stl)");
+  US_TEST_CONDITION(refs.empty(), "Testing stale index entries after properties update")
+
+  reg2.Unregister();
+  refs = context->GetServiceReferences<ITestServiceA>("(mime=application/nrrd)");
+  US_TEST_CONDITION(refs.empty(), "Testing equality filter after unregistration")
+
+  reg1.Unregister();
+  reg3.Unregister();
+  reg4.Unregister();
+
+  context->ResetServiceRegistryStatistics();
+  statistics = context->GetServiceRegistryStatistics();
+  US_TEST_CONDITION(statistics.lookupCount == 0 && statistics.filterEvaluationCount == 0, "Testing statistics reset")
+}
+
 
 int usServiceRegistryTest(int /*argc*/, char* /*argv*/[])
 {
@@ -135,6 +215,7 @@ int usServiceRegistryTest(int /*argc*/, char* /*argv*/[])
   TestServiceInterfaceId();
   TestMultipleServiceRegistrations();
   TestServicePropertiesUpdate();
+  TestIndexedFilterLookups();
 
   US_TEST_END()
 }
@@ -18,6 +18,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDemonsRegistration.h"
 #include "mitkImageWriteAccessor.h"
 
+#include <cmath>
+#include <vector>
+
 
 int mitkDemonsRegistrationTest(int /*argc*/, char* /*argv*/[])
 {
@@ -124,7 +127,57 @@ int mitkDemonsRegistrationTest(int /*argc*/, char* /*argv*/[])
   std::cout<<"[PASSED]"<<std::endl;
 
   std::cout << "Get the deformation field: ";
-  itk::Image<class itk::Vector<float, 3>,3>::Pointer deformationField = demonsRegistration->GetDeformationField();
+  itk::Image<class itk::Vector<float, 3>,3>::ConstPointer deformationField = demonsRegistration->GetDeformationField();
+  std::cout<<"[PASSED]"<<std::endl;
+
+  std::cout << "Perform multi-resolution registration: ";
+  std::vector<unsigned int> iterations(2, 3);
+  demonsRegistration->SetNumberOfLevels(2);
+  demonsRegistration->SetNumberOfIterationsPerLevel(iterations);
+  demonsRegistration->SetMaximumRMSError(0.01);
+  demonsRegistration->Modified();
+  demonsRegistration->Update();
+  deformationField = demonsRegistration->GetDeformationField();
+  if (deformationField.IsNull() || deformationField->GetLargestPossibleRegion().GetNumberOfPixels() != dim[0]*dim[1]*dim[2])
+  {
+    std::cout<<"[FAILED]"<<std::endl;
+    return EXIT_FAILURE;
+  }
+  // the field image is replaced by the next registration
+  const float* fullPrecisionBegin = deformationField->GetBufferPointer()->GetDataPointer();
+  std::vector<float> fullPrecisionField(fullPrecisionBegin, fullPrecisionBegin + 3 * dim[0]*dim[1]*dim[2]);
+  std::cout<<"[PASSED]"<<std::endl;
+
+  std::cout << "Perform multi-resolution registration with half precision deformation field: ";
+  demonsRegistration->SetUseHalfPrecisionDeformationField(true);
+  demonsRegistration->Modified();
+  demonsRegistration->Update();
+  mitk::Image::Pointer halfField = demonsRegistration->GetDeformationFieldImage();
+  if (halfField.IsNull() || halfField->GetPixelType().GetNumberOfComponents() != 3 || halfField->GetDimension(0) != dim[0])
+  {
+    std::cout<<"[FAILED]"<<std::endl;
+    return EXIT_FAILURE;
+  }
+  deformationField = demonsRegistration->GetDeformationField();
+  if (deformationField.IsNull() || deformationField->GetLargestPossibleRegion().GetNumberOfPixels() != dim[0]*dim[1]*dim[2])
+  {
+    std::cout<<"[FAILED]"<<std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout<<"[PASSED]"<<std::endl;
+
+  std::cout << "Compare the decoded half precision field to the full precision field: ";
+  const float* decodedField = deformationField->GetBufferPointer()->GetDataPointer();
+  for (std::size_t i = 0; i < fullPrecisionField.size(); ++i)
+  {
+    // half precision keeps 11 significant bits, values below 2^-14 are stored denormalized
+    const float tolerance = std::abs(fullPrecisionField[i]) / 1024.0f + 1e-4f;
+    if (std::abs(decodedField[i] - fullPrecisionField[i]) > tolerance)
+    {
+      std::cout<<"[FAILED] value "<< i << ": " << decodedField[i] << " instead of " << fullPrecisionField[i] <<std::endl;
+      return EXIT_FAILURE;
+    }
+  }
   std::cout<<"[PASSED]"<<std::endl;
 
   return EXIT_SUCCESS;
@@ -128,7 +128,7 @@ int mitkSymmetricForcesDemonsRegistrationTest(int /*argc*/, char* /*argv*/[])
   std::cout<<"[PASSED]"<<std::endl;
 
   std::cout << "Get the deformation field: ";
-  itk::Image<class itk::Vector<float, 3>,3>::Pointer deformationField = symmetricForcesDemonsRegistration->GetDeformationField();
+  itk::Image<class itk::Vector<float, 3>,3>::ConstPointer deformationField = symmetricForcesDemonsRegistration->GetDeformationField();
   std::cout<<"[PASSED]"<<std::endl;
 
   return EXIT_SUCCESS;
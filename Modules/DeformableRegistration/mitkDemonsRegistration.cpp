@@ -14,13 +14,101 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 ===================================================================*/
 
-#include <mitkImageCast.h>
-
-#include "itkImageFileWriter.h"
-#include "itkWarpImageFilter.h"
-#include "itkImageRegionIterator.h"
+#include <mitkImageToItk.h>
+#include <mitkITKImageImport.h>
 
 #include "mitkDemonsRegistration.h"
+#include "mitkDemonsRegistration.txx"
+
+#include <cstring>
+
+namespace
+{
+  /** Converts a float into the bit pattern of an IEEE 754 half precision value (round to nearest even). */
+  unsigned short FloatToHalf(float value)
+  {
+    unsigned int bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const unsigned short sign = static_cast<unsigned short>((bits >> 16) & 0x8000u);
+    const unsigned int exponent = (bits >> 23) & 0xffu;
+    unsigned int mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu) // inf and nan
+    {
+      return sign | 0x7c00u | (mantissa ? 0x200u : 0u);
+    }
+
+    const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 0x1f) // too large, becomes inf
+    {
+      return sign | 0x7c00u;
+    }
+
+    unsigned int shift;
+    unsigned int half;
+    if (halfExponent <= 0) // denormal or zero
+    {
+      if (halfExponent < -10)
+      {
+        return sign;
+      }
+      mantissa |= 0x800000u;
+      shift = static_cast<unsigned int>(14 - halfExponent);
+      half = mantissa >> shift;
+    }
+    else
+    {
+      shift = 13;
+      half = (static_cast<unsigned int>(halfExponent) << 10) | (mantissa >> shift);
+    }
+
+    // round to nearest even, a carry into the exponent is the correct result
+    const unsigned int remainder = mantissa & ((1u << shift) - 1u);
+    const unsigned int halfway = 1u << (shift - 1u);
+    if (remainder > halfway || (remainder == halfway && (half & 1u)))
+    {
+      ++half;
+    }
+    return sign | static_cast<unsigned short>(half);
+  }
+
+  /** Converts the bit pattern of an IEEE 754 half precision value into a float. */
+  float HalfToFloat(unsigned short half)
+  {
+    const unsigned int sign = static_cast<unsigned int>(half & 0x8000u) << 16;
+    unsigned int exponent = (half >> 10) & 0x1fu;
+    unsigned int mantissa = half & 0x3ffu;
+
+    unsigned int bits;
+    if (exponent == 0x1fu) // inf and nan
+    {
+      bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+      bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+      bits = sign;
+    }
+    else // denormal, normalize it
+    {
+      exponent = 127 - 15 + 1;
+      while (!(mantissa & 0x400u))
+      {
+        mantissa <<= 1;
+        --exponent;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+}
 
 namespace mitk {
 
@@ -29,9 +117,12 @@ namespace mitk {
     m_StandardDeviation(1.0),
     m_FieldName("newField.mhd"),
     m_ResultName("deformedImage.mhd"),
-    m_SaveField(true),
-    m_SaveResult(true),
-    m_DeformationField(nullptr)
+    m_SaveField(false),
+    m_SaveResult(false),
+    m_NumberOfLevels(1),
+    m_MaximumRMSError(0.0),
+    m_UseHalfPrecisionDeformationField(false),
+    m_DeformationFieldImage(nullptr)
   {
 
   }
@@ -70,197 +161,100 @@ namespace mitk {
     m_ResultName = resultName;
   }
 
-  itk::Image<itk::Vector<float, 3>,3>::Pointer DemonsRegistration::GetDeformationField()
+  void DemonsRegistration::SetNumberOfLevels(unsigned int levels)
   {
-    return m_DeformationField;
+    m_NumberOfLevels = levels > 0 ? levels : 1;
   }
 
-  template < typename TPixel, unsigned int VImageDimension >
-  void DemonsRegistration::GenerateData2(const itk::Image<TPixel, VImageDimension>* itkImage1)
+  void DemonsRegistration::SetNumberOfIterationsPerLevel(const std::vector<unsigned int>& iterations)
   {
-    typedef typename itk::Image< TPixel, VImageDimension >  FixedImageType;
-    typedef typename itk::Image< TPixel, VImageDimension >  MovingImageType;
-
-    typedef float InternalPixelType;
-    typedef typename itk::Image< InternalPixelType, VImageDimension > InternalImageType;
-    typedef typename itk::CastImageFilter< FixedImageType,
-                                  InternalImageType > FixedImageCasterType;
-    typedef typename itk::CastImageFilter< MovingImageType,
-                                  InternalImageType > MovingImageCasterType;
-    typedef typename itk::Image< InternalPixelType, VImageDimension > InternalImageType;
-    typedef typename itk::Vector< float, VImageDimension >    VectorPixelType;
-    typedef typename itk::Image<  VectorPixelType, VImageDimension > DeformationFieldType;
-    typedef typename itk::DemonsRegistrationFilter<
-                                  InternalImageType,
-                                  InternalImageType,
-                                  DeformationFieldType>   RegistrationFilterType;
-    typedef typename itk::WarpImageFilter<
-                            MovingImageType,
-                            MovingImageType,
-                            DeformationFieldType  >     WarperType;
-    typedef typename itk::LinearInterpolateImageFunction<
-                                    MovingImageType,
-                                    double          >  InterpolatorType;
-
-    typedef  TPixel  OutputPixelType;
-    typedef typename itk::Image< OutputPixelType, VImageDimension > OutputImageType;
-    typedef typename itk::CastImageFilter<
-                          MovingImageType,
-                          OutputImageType > CastFilterType;
-    typedef typename itk::ImageFileWriter< OutputImageType >  WriterType;
-    typedef typename itk::ImageFileWriter< DeformationFieldType >  FieldWriterType;
-
-    typename FixedImageType::Pointer fixedImage = FixedImageType::New();
-    mitk::CastToItkImage(m_ReferenceImage, fixedImage);
-    typename MovingImageType::ConstPointer movingImage = itkImage1;
-
-    if (fixedImage.IsNotNull() && movingImage.IsNotNull())
-    {
-      typename RegistrationFilterType::Pointer filter = RegistrationFilterType::New();
-
-      this->AddStepsToDo(4);
-      typename itk::ReceptorMemberCommand<DemonsRegistration>::Pointer command = itk::ReceptorMemberCommand<DemonsRegistration>::New();
-      command->SetCallbackFunction(this, &DemonsRegistration::SetProgress);
-      filter->AddObserver( itk::IterationEvent(), command );
-
-      typename FixedImageCasterType::Pointer fixedImageCaster = FixedImageCasterType::New();
-      fixedImageCaster->SetInput(fixedImage);
-      filter->SetFixedImage( fixedImageCaster->GetOutput() );
-      typename MovingImageCasterType::Pointer movingImageCaster = MovingImageCasterType::New();
-      movingImageCaster->SetInput(movingImage);
-      filter->SetMovingImage(movingImageCaster->GetOutput());
-      filter->SetNumberOfIterations( m_Iterations );
-      filter->SetStandardDeviations( m_StandardDeviation );
-      filter->Update();
-
-      typename WarperType::Pointer warper = WarperType::New();
-      typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
-
-      warper->SetInput( movingImage );
-      warper->SetInterpolator( interpolator );
-      warper->SetOutputSpacing( fixedImage->GetSpacing() );
-      warper->SetOutputOrigin( fixedImage->GetOrigin() );
-      warper->SetOutputDirection( fixedImage->GetDirection());
-      warper->SetDisplacementField( filter->GetOutput() );
-      warper->Update();
-      Image::Pointer outputImage = this->GetOutput();
-      mitk::CastToMitkImage( warper->GetOutput(), outputImage );
-
-
-      typename WriterType::Pointer      writer =  WriterType::New();
-      typename CastFilterType::Pointer  caster =  CastFilterType::New();
-
-      writer->SetFileName( m_ResultName );
-
-      caster->SetInput( warper->GetOutput() );
-      writer->SetInput( caster->GetOutput()   );
-      if(m_SaveResult)
-      {
-        writer->Update();
-      }
-
-      if (VImageDimension == 2)
-      {
-        typedef DeformationFieldType  VectorImage2DType;
-        typedef typename DeformationFieldType::PixelType Vector2DType;
-
-        typename VectorImage2DType::ConstPointer vectorImage2D = filter->GetOutput();
-
-        typename VectorImage2DType::RegionType  region2D = vectorImage2D->GetBufferedRegion();
-        typename VectorImage2DType::IndexType   index2D  = region2D.GetIndex();
-        typename VectorImage2DType::SizeType    size2D   = region2D.GetSize();
-
-
-        typedef typename itk::Vector< float,       3 >  Vector3DType;
-        typedef typename itk::Image< Vector3DType, 3 >  VectorImage3DType;
-
-        typedef typename itk::ImageFileWriter< VectorImage3DType > WriterType;
-
-        typename WriterType::Pointer writer3D = WriterType::New();
-
-        typename VectorImage3DType::Pointer vectorImage3D = VectorImage3DType::New();
+    m_IterationsPerLevel = iterations;
+  }
 
-        typename VectorImage3DType::RegionType  region3D;
-        typename VectorImage3DType::IndexType   index3D;
-        typename VectorImage3DType::SizeType    size3D;
+  void DemonsRegistration::SetMaximumRMSError(double rmsError)
+  {
+    m_MaximumRMSError = rmsError;
+  }
 
-        index3D[0] = index2D[0];
-        index3D[1] = index2D[1];
-        index3D[2] = 0;
+  void DemonsRegistration::SetUseHalfPrecisionDeformationField(bool useHalfPrecision)
+  {
+    m_UseHalfPrecisionDeformationField = useHalfPrecision;
+  }
 
-        size3D[0]  = size2D[0];
-        size3D[1]  = size2D[1];
-        size3D[2]  = 1;
+  itk::Image<itk::Vector<float, 3>,3>::ConstPointer DemonsRegistration::GetDeformationField()
+  {
+    typedef itk::Image<itk::Vector<float, 3>,3> FieldType;
 
-        region3D.SetSize( size3D );
-        region3D.SetIndex( index3D );
+    if (m_DeformationFieldImage.IsNull())
+    {
+      return nullptr;
+    }
+    if (m_DeformationFieldImage->GetPixelType().GetComponentType() == itk::ImageIOBase::USHORT)
+    {
+      return DecodeHalfPrecisionDeformationField(m_DeformationFieldImage);
+    }
 
-        typename VectorImage2DType::SpacingType spacing2D   = vectorImage2D->GetSpacing();
-        typename VectorImage3DType::SpacingType spacing3D;
+    // read access only, so the field can still be read through GetDeformationFieldImage() meanwhile
+    const Image* fieldImage = m_DeformationFieldImage.GetPointer();
+    FieldType::ConstPointer field = mitk::ImageToItkImage<itk::Vector<float, 3>, 3>(fieldImage);
+    return field;
+  }
 
-        spacing3D[0] = spacing2D[0];
-        spacing3D[1] = spacing2D[1];
-        spacing3D[2] = 1.0;
+  Image::Pointer DemonsRegistration::GetDeformationFieldImage()
+  {
+    return m_DeformationFieldImage;
+  }
 
-        vectorImage3D->SetSpacing( spacing3D );
+  Image::Pointer DemonsRegistration::EncodeHalfPrecisionDeformationField(const itk::Image<itk::Vector<float, 3>,3>* field)
+  {
+    typedef itk::Image<itk::Vector<unsigned short, 3>,3> HalfFieldType;
 
-        vectorImage3D->SetRegions( region3D );
-        vectorImage3D->Allocate();
+    HalfFieldType::Pointer halfField = HalfFieldType::New();
+    halfField->CopyInformation(field);
+    halfField->SetRegions(field->GetBufferedRegion());
+    halfField->Allocate();
 
-        typedef typename itk::ImageRegionConstIterator< VectorImage2DType > Iterator2DType;
+    const float* source = field->GetBufferPointer()->GetDataPointer();
+    unsigned short* target = halfField->GetBufferPointer()->GetDataPointer();
+    const long numberOfValues = static_cast<long>(3 * field->GetBufferedRegion().GetNumberOfPixels());
 
-        typedef typename itk::ImageRegionIterator< VectorImage3DType > Iterator3DType;
+#pragma omp parallel for
+    for (long i = 0; i < numberOfValues; ++i)
+    {
+      target[i] = FloatToHalf(source[i]);
+    }
 
-        Iterator2DType  it2( vectorImage2D, region2D );
-        Iterator3DType  it3( vectorImage3D, region3D );
+    return mitk::GrabItkImageMemory(halfField);
+  }
 
-        it2.GoToBegin();
-        it3.GoToBegin();
+  itk::Image<itk::Vector<float, 3>,3>::Pointer DemonsRegistration::DecodeHalfPrecisionDeformationField(const Image* fieldImage)
+  {
+    typedef itk::Image<itk::Vector<unsigned short, 3>,3> HalfFieldType;
+    typedef itk::Image<itk::Vector<float, 3>,3> FieldType;
 
-        Vector2DType vector2D;
-        Vector3DType vector3D;
+    HalfFieldType::ConstPointer halfField = mitk::ImageToItkImage<itk::Vector<unsigned short, 3>, 3>(fieldImage);
 
-        vector3D[2] = 0; // set Z component to zero.
+    FieldType::Pointer field = FieldType::New();
+    field->CopyInformation(halfField);
+    field->SetRegions(halfField->GetBufferedRegion());
+    field->Allocate();
 
-        while( !it2.IsAtEnd() )
-        {
-          vector2D = it2.Get();
-          vector3D[0] = vector2D[0];
-          vector3D[1] = vector2D[1];
-          it3.Set( vector3D );
-          ++it2;
-          ++it3;
-        }
+    const unsigned short* source = halfField->GetBufferPointer()->GetDataPointer();
+    float* target = field->GetBufferPointer()->GetDataPointer();
+    const long numberOfValues = static_cast<long>(3 * halfField->GetBufferedRegion().GetNumberOfPixels());
 
-        writer3D->SetInput( vectorImage3D );
-        m_DeformationField = vectorImage3D;
+#pragma omp parallel for
+    for (long i = 0; i < numberOfValues; ++i)
+    {
+      target[i] = HalfToFloat(source[i]);
+    }
 
-        writer3D->SetFileName( m_FieldName );
+    return field;
+  }
 
-        try
-        {
-          if(m_SaveField)
-          {
-            writer3D->Update();
-          }
-        }
-        catch( itk::ExceptionObject & excp )
-        {
-          MITK_ERROR << excp << std::endl;
-        }
-      }
-      else
-      {
-        typename FieldWriterType::Pointer      fieldwriter =  FieldWriterType::New();
-        fieldwriter->SetFileName(m_FieldName);
-        fieldwriter->SetInput( filter->GetOutput() );
-        m_DeformationField = (itk::Image<itk::Vector<float, 3>,3> *)(filter->GetOutput());
-        if(m_SaveField)
-        {
-          fieldwriter->Update();
-        }
-      }
-      this->SetRemainingProgress(4);
-    }
+  template < typename TPixel, unsigned int VImageDimension >
+  void DemonsRegistration::GenerateData2(const itk::Image<TPixel, VImageDimension>* itkImage1)
+  {
+    this->template RunRegistration<itk::DemonsRegistrationFilter>(itkImage1);
   }
 } // end namespace
@@ -23,12 +23,19 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkRegistrationBase.h"
 #include "mitkImageAccessByItk.h"
 
+#include <vector>
+
 namespace mitk
 {
 
   /*!
   \brief This class performes a demons registration between two images with the same modality..
 
+  The registration runs on a multi-resolution pyramid if more than one level is set. Every level stops after its
+  number of iterations or as soon as the RMS change of the deformation field falls below the maximum RMS error.
+  The filters use GetNumberOfThreads() threads. The deformation field is kept in memory as vector image
+  (see GetDeformationFieldImage()), writing result and field to disk has to be switched on explicitly.
+
   \ingroup DeformableRegistration
 
   \author Daniel Stein
@@ -77,10 +84,44 @@ namespace mitk
     */
     void SetResultFileName(const char* resultName);
 
+    /*!
+    * \brief Sets the number of resolution levels, 1 (default) registers on the full resolution only.
+    */
+    void SetNumberOfLevels(unsigned int levels);
+
+    /*!
+    * \brief Sets the number of iterations for every level from coarse to fine. If not set, every level uses SetNumberOfIterations().
+    */
+    void SetNumberOfIterationsPerLevel(const std::vector<unsigned int>& iterations);
+
+    /*!
+    * \brief Sets the RMS change of the deformation field below which a level stops early, 0 (default) disables early stopping.
+    */
+    void SetMaximumRMSError(double rmsError);
+
+    /*!
+    * \brief Sets whether the deformation field is stored with 16 bit floating point components (IEEE 754 half precision) to halve its memory.
+    *
+    * The components are stored as unsigned short bit patterns, see DecodeHalfPrecisionDeformationField().
+    */
+    void SetUseHalfPrecisionDeformationField(bool useHalfPrecision);
+
     /*!
     * \brief Returns the deformation field, which results by the registration.
+    *
+    * The itk image is a read-only view of the memory of GetDeformationFieldImage(), a half precision field is decoded into a new image.
+    */
+    itk::Image<itk::Vector<float, 3>,3>::ConstPointer GetDeformationField();
+
+    /*!
+    * \brief Returns the deformation field, which results by the registration, as mitk::Image with three components per voxel.
+    */
+    Image::Pointer GetDeformationFieldImage();
+
+    /*!
+    * \brief Converts a deformation field stored with half precision components into a float field.
     */
-    itk::Image<itk::Vector<float, 3>,3>::Pointer GetDeformationField();
+    static itk::Image<itk::Vector<float, 3>,3>::Pointer DecodeHalfPrecisionDeformationField(const Image* fieldImage);
 
     /*!
     * \brief Starts the demons registration.
@@ -112,13 +153,28 @@ namespace mitk
     template < typename TPixel, unsigned int VImageDimension >
     void GenerateData2( const itk::Image<TPixel, VImageDimension>* itkImage1);
 
+    /*!
+    * \brief Performs the registration with the demons variant \a TRegistrationFilter (e.g. itk::DemonsRegistrationFilter).
+    */
+    template < template<class, class, class> class TRegistrationFilter, typename TPixel, unsigned int VImageDimension >
+    void RunRegistration( const itk::Image<TPixel, VImageDimension>* itkImage1);
+
+    /*!
+    * \brief Converts a float deformation field into an image with half precision components.
+    */
+    static Image::Pointer EncodeHalfPrecisionDeformationField(const itk::Image<itk::Vector<float, 3>,3>* field);
+
     int m_Iterations;
     float m_StandardDeviation;
     const char* m_FieldName;
     const char* m_ResultName;
     bool m_SaveField;
     bool m_SaveResult;
-    itk::Image<class itk::Vector<float, 3>,3>::Pointer m_DeformationField;
+    unsigned int m_NumberOfLevels;
+    std::vector<unsigned int> m_IterationsPerLevel;
+    double m_MaximumRMSError;
+    bool m_UseHalfPrecisionDeformationField;
+    Image::Pointer m_DeformationFieldImage;
   };
 }
 
@@ -0,0 +1,262 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKDEMONSREGISTRATION_TXX
+#define MITKDEMONSREGISTRATION_TXX
+
+#include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+
+#include "itkImageFileWriter.h"
+#include "itkWarpImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiResolutionPDEDeformableRegistration.h"
+
+#include "mitkDemonsRegistration.h"
+
+namespace mitk {
+
+  template < template<class, class, class> class TRegistrationFilter, typename TPixel, unsigned int VImageDimension >
+  void DemonsRegistration::RunRegistration(const itk::Image<TPixel, VImageDimension>* itkImage1)
+  {
+    typedef typename itk::Image< TPixel, VImageDimension >  FixedImageType;
+    typedef typename itk::Image< TPixel, VImageDimension >  MovingImageType;
+
+    typedef float InternalPixelType;
+    typedef typename itk::Image< InternalPixelType, VImageDimension > InternalImageType;
+    typedef typename itk::CastImageFilter< FixedImageType,
+                                  InternalImageType > FixedImageCasterType;
+    typedef typename itk::CastImageFilter< MovingImageType,
+                                  InternalImageType > MovingImageCasterType;
+    typedef typename itk::Vector< float, VImageDimension >    VectorPixelType;
+    typedef typename itk::Image<  VectorPixelType, VImageDimension > DeformationFieldType;
+    typedef TRegistrationFilter<
+                                  InternalImageType,
+                                  InternalImageType,
+                                  DeformationFieldType>   RegistrationFilterType;
+    typedef typename itk::MultiResolutionPDEDeformableRegistration<
+                                  InternalImageType,
+                                  InternalImageType,
+                                  DeformationFieldType>   MultiResolutionRegistrationType;
+    typedef typename itk::WarpImageFilter<
+                            MovingImageType,
+                            MovingImageType,
+                            DeformationFieldType  >     WarperType;
+    typedef typename itk::LinearInterpolateImageFunction<
+                                    MovingImageType,
+                                    double          >  InterpolatorType;
+
+    typedef  TPixel  OutputPixelType;
+    typedef typename itk::Image< OutputPixelType, VImageDimension > OutputImageType;
+    typedef typename itk::CastImageFilter<
+                          MovingImageType,
+                          OutputImageType > CastFilterType;
+    typedef typename itk::ImageFileWriter< OutputImageType >  WriterType;
+
+    typedef itk::Image< itk::Vector< float, 3 >, 3 >  VectorImage3DType;
+    typedef itk::ImageFileWriter< VectorImage3DType > FieldWriterType;
+
+    typename FixedImageType::Pointer fixedImage = FixedImageType::New();
+    mitk::CastToItkImage(m_ReferenceImage, fixedImage);
+    typename MovingImageType::ConstPointer movingImage = itkImage1;
+
+    if (fixedImage.IsNotNull() && movingImage.IsNotNull())
+    {
+      const itk::ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+      typename RegistrationFilterType::Pointer filter = RegistrationFilterType::New();
+
+      this->AddStepsToDo(4);
+      typename itk::ReceptorMemberCommand<DemonsRegistration>::Pointer command = itk::ReceptorMemberCommand<DemonsRegistration>::New();
+      command->SetCallbackFunction(this, &DemonsRegistration::SetProgress);
+      filter->AddObserver( itk::IterationEvent(), command );
+
+      typename FixedImageCasterType::Pointer fixedImageCaster = FixedImageCasterType::New();
+      fixedImageCaster->SetInput(fixedImage);
+      fixedImageCaster->SetNumberOfThreads(numberOfThreads);
+      typename MovingImageCasterType::Pointer movingImageCaster = MovingImageCasterType::New();
+      movingImageCaster->SetInput(movingImage);
+      movingImageCaster->SetNumberOfThreads(numberOfThreads);
+
+      filter->SetStandardDeviations( m_StandardDeviation );
+      filter->SetNumberOfThreads(numberOfThreads);
+      if (m_MaximumRMSError > 0.0)
+      {
+        // stops every level as soon as the field changes less than this
+        filter->SetMaximumRMSError( m_MaximumRMSError );
+      }
+
+      typename DeformationFieldType::Pointer field;
+      if (m_NumberOfLevels > 1)
+      {
+        std::vector<unsigned int> iterations(m_NumberOfLevels, m_Iterations);
+        for (unsigned int level = 0; level < m_NumberOfLevels && level < m_IterationsPerLevel.size(); ++level)
+        {
+          iterations[level] = m_IterationsPerLevel[level];
+        }
+
+        typename MultiResolutionRegistrationType::Pointer multiResolution = MultiResolutionRegistrationType::New();
+        multiResolution->SetRegistrationFilter( filter );
+        multiResolution->SetNumberOfThreads( numberOfThreads );
+        multiResolution->GetFixedImagePyramid()->SetNumberOfThreads( numberOfThreads );
+        multiResolution->GetMovingImagePyramid()->SetNumberOfThreads( numberOfThreads );
+        multiResolution->GetFieldExpander()->SetNumberOfThreads( numberOfThreads );
+        multiResolution->SetFixedImage( fixedImageCaster->GetOutput() );
+        multiResolution->SetMovingImage( movingImageCaster->GetOutput() );
+        multiResolution->SetNumberOfLevels( m_NumberOfLevels );
+        multiResolution->SetNumberOfIterations( &iterations[0] );
+        multiResolution->Update();
+        field = multiResolution->GetOutput();
+      }
+      else
+      {
+        filter->SetFixedImage( fixedImageCaster->GetOutput() );
+        filter->SetMovingImage( movingImageCaster->GetOutput() );
+        filter->SetNumberOfIterations( m_Iterations );
+        filter->Update();
+        field = filter->GetOutput();
+      }
+
+      typename WarperType::Pointer warper = WarperType::New();
+      typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+
+      warper->SetInput( movingImage );
+      warper->SetInterpolator( interpolator );
+      warper->SetOutputSpacing( fixedImage->GetSpacing() );
+      warper->SetOutputOrigin( fixedImage->GetOrigin() );
+      warper->SetOutputDirection( fixedImage->GetDirection());
+      warper->SetDisplacementField( field );
+      warper->SetNumberOfThreads(numberOfThreads);
+      warper->Update();
+
+      if(m_SaveResult)
+      {
+        typename WriterType::Pointer      writer =  WriterType::New();
+        typename CastFilterType::Pointer  caster =  CastFilterType::New();
+
+        writer->SetFileName( m_ResultName );
+
+        caster->SetInput( warper->GetOutput() );
+        writer->SetInput( caster->GetOutput()   );
+        writer->Update();
+      }
+
+      // the output takes over the memory of the warped image instead of copying it
+      Image::Pointer outputImage = this->GetOutput();
+      typename MovingImageType::Pointer warpedImage = warper->GetOutput();
+      mitk::GrabItkImageMemory( warpedImage, outputImage );
+
+      VectorImage3DType::Pointer vectorImage3D;
+      if (VImageDimension == 2)
+      {
+        typedef DeformationFieldType  VectorImage2DType;
+        typedef typename DeformationFieldType::PixelType Vector2DType;
+
+        typename VectorImage2DType::ConstPointer vectorImage2D = field.GetPointer();
+
+        typename VectorImage2DType::RegionType  region2D = vectorImage2D->GetBufferedRegion();
+        typename VectorImage2DType::IndexType   index2D  = region2D.GetIndex();
+        typename VectorImage2DType::SizeType    size2D   = region2D.GetSize();
+
+        typedef itk::Vector< float,       3 >  Vector3DType;
+
+        vectorImage3D = VectorImage3DType::New();
+
+        VectorImage3DType::RegionType  region3D;
+        VectorImage3DType::IndexType   index3D;
+        VectorImage3DType::SizeType    size3D;
+
+        index3D[0] = index2D[0];
+        index3D[1] = index2D[1];
+        index3D[2] = 0;
+
+        size3D[0]  = size2D[0];
+        size3D[1]  = size2D[1];
+        size3D[2]  = 1;
+
+        region3D.SetSize( size3D );
+        region3D.SetIndex( index3D );
+
+        typename VectorImage2DType::SpacingType spacing2D   = vectorImage2D->GetSpacing();
+        VectorImage3DType::SpacingType spacing3D;
+
+        spacing3D[0] = spacing2D[0];
+        spacing3D[1] = spacing2D[1];
+        spacing3D[2] = 1.0;
+
+        vectorImage3D->SetSpacing( spacing3D );
+
+        vectorImage3D->SetRegions( region3D );
+        vectorImage3D->Allocate();
+
+        typedef typename itk::ImageRegionConstIterator< VectorImage2DType > Iterator2DType;
+
+        typedef itk::ImageRegionIterator< VectorImage3DType > Iterator3DType;
+
+        Iterator2DType  it2( vectorImage2D, region2D );
+        Iterator3DType  it3( vectorImage3D, region3D );
+
+        it2.GoToBegin();
+        it3.GoToBegin();
+
+        Vector2DType vector2D;
+        Vector3DType vector3D;
+
+        vector3D[2] = 0; // set Z component to zero.
+
+        while( !it2.IsAtEnd() )
+        {
+          vector2D = it2.Get();
+          vector3D[0] = vector2D[0];
+          vector3D[1] = vector2D[1];
+          it3.Set( vector3D );
+          ++it2;
+          ++it3;
+        }
+      }
+      else
+      {
+        vectorImage3D = (VectorImage3DType *)(field.GetPointer()); //see BUG #3732
+      }
+
+      if(m_SaveField)
+      {
+        typename FieldWriterType::Pointer fieldWriter = FieldWriterType::New();
+        fieldWriter->SetFileName( m_FieldName );
+        fieldWriter->SetInput( vectorImage3D );
+        try
+        {
+          fieldWriter->Update();
+        }
+        catch( itk::ExceptionObject & excp )
+        {
+          MITK_ERROR << excp << std::endl;
+        }
+      }
+
+      if (m_UseHalfPrecisionDeformationField)
+      {
+        m_DeformationFieldImage = EncodeHalfPrecisionDeformationField(vectorImage3D);
+      }
+      else
+      {
+        m_DeformationFieldImage = mitk::GrabItkImageMemory( vectorImage3D );
+      }
+      this->SetRemainingProgress(4);
+    }
+  }
+} // end namespace
+
+#endif // MITKDEMONSREGISTRATION_TXX
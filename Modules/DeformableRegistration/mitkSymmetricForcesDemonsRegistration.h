@@ -20,7 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkSymmetricForcesDemonsRegistrationFilter.h"
 #include "MitkDeformableRegistrationExports.h"
 
-#include "mitkRegistrationBase.h"
+#include "mitkDemonsRegistration.h"
 #include "mitkImageAccessByItk.h"
 
 namespace mitk
@@ -29,17 +29,19 @@ namespace mitk
   /*!
   \brief This class performes a symmetric forces demons registration between two images with the same modality.
 
+  It shares all parameters with DemonsRegistration and only differs in the force computation.
+
   \ingroup DeformableRegistration
 
   \author Daniel Stein
   */
 
-  class MITKDEFORMABLEREGISTRATION_EXPORT SymmetricForcesDemonsRegistration : public RegistrationBase
+  class MITKDEFORMABLEREGISTRATION_EXPORT SymmetricForcesDemonsRegistration : public DemonsRegistration
   {
 
   public:
 
-    mitkClassMacro(SymmetricForcesDemonsRegistration, RegistrationBase);
+    mitkClassMacro(SymmetricForcesDemonsRegistration, DemonsRegistration);
 
     /*!
     * \brief Method for creation through the object factory.
@@ -47,41 +49,6 @@ namespace mitk
     itkFactorylessNewMacro(Self)
     itkCloneMacro(Self)
 
-    /*!
-    * \brief Sets the number of iterations which will be performed during the registration process.
-    */
-    void SetNumberOfIterations(int iterations);
-
-    /*!
-    * \brief Sets the standard deviation used by the symmetric forces demons registration.
-    */
-    void SetStandardDeviation(float deviation);
-
-    /*!
-    * \brief Sets whether the resulting deformation field should be saved or not.
-    */
-    void SetSaveDeformationField(bool saveField);
-
-    /*!
-    * \brief Sets the filename for the resulting deformation field.
-    */
-    void SetDeformationFieldFileName(const char* fieldName);
-
-    /*!
-    * \brief Sets whether the result should be saved or not.
-    */
-    void SetSaveResult(bool saveResult);
-
-    /*!
-    * \brief Sets the filename for the resulting deformed image.
-    */
-    void SetResultFileName(const char* resultName);
-
-    /*!
-    * \brief Returns the deformation field, which results by the registration.
-    */
-    itk::Image<class itk::Vector<float, 3>,3>::Pointer GetDeformationField();
-
     /*!
     * \brief Starts the symmetric forces demons registration.
     */
@@ -110,14 +77,6 @@ namespace mitk
     */
     template < typename TPixel, unsigned int VImageDimension >
       void GenerateData2( const itk::Image<TPixel, VImageDimension>* itkImage1);
-
-    int m_Iterations;
-    float m_StandardDeviation;
-    const char* m_FieldName;
-    const char* m_ResultName;
-    bool m_SaveField;
-    bool m_SaveResult;
-    itk::Image<class itk::Vector<float, 3>,3>::Pointer m_DeformationField;
   };
 }
 
@@ -128,9 +128,7 @@ void QmitkDemonsRegistrationView::CalculateTransformation()
         return;
       }
       m_ResultImage = registration->GetOutput();
-      typedef itk::Image<itk::Vector<float,3>, 3> VectorImageType;
-      VectorImageType::Pointer deformationField = registration->GetDeformationField();
-      m_ResultDeformationField = mitk::ImportItkImage(deformationField)->Clone();
+      m_ResultDeformationField = registration->GetDeformationFieldImage();
     }
     else if(m_Controls.m_RegistrationSelection->currentIndex() == 1)
     {
@@ -174,9 +172,7 @@ void QmitkDemonsRegistrationView::CalculateTransformation()
         return;
       }
       m_ResultImage = registration->GetOutput();
-      typedef itk::Image<itk::Vector<float,3>, 3> VectorImageType;
-      VectorImageType::Pointer deformationField = registration->GetDeformationField();
-      m_ResultDeformationField = mitk::ImportItkImage(deformationField)->Clone();
+      m_ResultDeformationField = registration->GetDeformationFieldImage();
     }
   }
 }
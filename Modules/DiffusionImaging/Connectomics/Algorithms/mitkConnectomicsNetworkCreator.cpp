@@ -31,6 +31,41 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolyLine.h>
 #include <vtkCellArray.h>
 
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+  // number of consecutive fibers labeled by one thread at a time
+  const int fibersPerBlock = 1024;
+
+  // first occurrence of a label, ordered by fiber and end (2 * fiber + end)
+  struct LabelOccurrence
+  {
+    long long order;
+    itk::Index<3> index;
+  };
+
+  // number of fibers connecting two labels and the first fiber doing so
+  struct ConnectionCount
+  {
+    int firstFiber;
+    mitk::ConnectomicsNetworkCreator::ImageLabelPairType labels;
+    int weight;
+  };
+
+  typedef std::unordered_map< mitk::ConnectomicsNetworkCreator::ImageLabelType, LabelOccurrence > LabelOccurrenceMap;
+  typedef std::unordered_map< unsigned long long, ConnectionCount > ConnectionCountMap;
+
+  // the network is undirected, so both orders of a label pair share a key
+  unsigned long long ConnectionKey( const mitk::ConnectomicsNetworkCreator::ImageLabelPairType& labels )
+  {
+    unsigned int low = static_cast< unsigned int >( std::min( labels.first, labels.second ) );
+    unsigned int high = static_cast< unsigned int >( std::max( labels.first, labels.second ) );
+    return ( static_cast< unsigned long long >( low ) << 32 ) | high;
+  }
+}
+
 mitk::ConnectomicsNetworkCreator::ConnectomicsNetworkCreator()
 : m_FiberBundle()
 , m_Segmentation()
@@ -80,6 +115,18 @@ void mitk::ConnectomicsNetworkCreator::SetSegmentation(mitk::Image::Pointer segm
   mitk::CastToItkImage( segmentation, m_SegmentationItk );
 }
 
+mitk::ConnectomicsNetworkCreator::PointType mitk::ConnectomicsNetworkCreator::FiberPoints::GetElement( unsigned int index ) const
+{
+  double point[3];
+  points->GetPoint( pointIds[ index ], point );
+
+  PointType itkPoint;
+  itkPoint[0] = point[0];
+  itkPoint[1] = point[1];
+  itkPoint[2] = point[2];
+  return itkPoint;
+}
+
 itk::Point<float, 3> mitk::ConnectomicsNetworkCreator::GetItkPoint(double point[3])
 {
   itk::Point<float, 3> itkPoint;
@@ -102,30 +149,129 @@ void mitk::ConnectomicsNetworkCreator::CreateNetworkFromFibersAndSegmentation()
   vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
   vLines->InitTraversal();
 
+  // the fibers reference the point ids of the polydata, no points are copied
   int numFibers = m_FiberBundle->GetNumFibers();
+  std::vector< FiberPoints > fibers( numFibers );
   for( int fiberID( 0 ); fiberID < numFibers; fiberID++ )
   {
     vtkIdType   numPointsInCell(0);
     vtkIdType*  pointsInCell(nullptr);
     vLines->GetNextCell ( numPointsInCell, pointsInCell );
 
-    TractType::Pointer singleTract = TractType::New();
-    for( int pointInCellID( 0 ); pointInCellID < numPointsInCell ; pointInCellID++)
+    fibers[ fiberID ].points = fiberPolyData->GetPoints();
+    fibers[ fiberID ].pointIds = pointsInCell;
+    fibers[ fiberID ].numberOfPoints = numPointsInCell;
+  }
+
+  // the geometries compute their inverse transform on first use, do this before the threads share them
+  mitk::Point3D worldPoint, indexPoint;
+  worldPoint.Fill( 0.0 );
+  m_FiberBundle->GetGeometry()->WorldToIndex( worldPoint, indexPoint );
+  m_Segmentation->GetGeometry()->WorldToIndex( worldPoint, indexPoint );
+
+  // Label the fibers in blocks. Every block remembers where it saw each label first and
+  // counts its connections by label pair.
+  const int numBlocks = ( numFibers + fibersPerBlock - 1 ) / fibersPerBlock;
+  std::vector< LabelOccurrenceMap > blockLabels( numBlocks );
+  std::vector< ConnectionCountMap > blockConnections( numBlocks );
+
+#pragma omp parallel for schedule(dynamic)
+  for( int block = 0; block < numBlocks; block++ )
+  {
+    LabelOccurrenceMap& labels = blockLabels[ block ];
+    ConnectionCountMap& connections = blockConnections[ block ];
+    const int lastFiber = std::min( numFibers, ( block + 1 ) * fibersPerBlock );
+
+    for( int fiberID = block * fibersPerBlock; fiberID < lastFiber; fiberID++ )
     {
-      // push back point
-      PointType point = GetItkPoint( fiberPolyData->GetPoint( pointsInCell[ pointInCellID ] ) );
-      singleTract->InsertElement( singleTract->Size(), point );
+      if( fibers[ fiberID ].Size() == 0 )
+      {
+        continue;
+      }
+
+      itk::Index<3> firstElementSegIndex, lastElementSegIndex;
+      ImageLabelPairType labelpair = ReturnLabelForFiberTract( fibers[ fiberID ], m_MappingStrategy, firstElementSegIndex, lastElementSegIndex );
+
+      // the fibers are visited in ascending order, so the first insertion is the first occurrence
+      LabelOccurrence first = { 2 * (long long)fiberID, firstElementSegIndex };
+      LabelOccurrence last = { 2 * (long long)fiberID + 1, lastElementSegIndex };
+      labels.insert( std::make_pair( labelpair.first, first ) );
+      labels.insert( std::make_pair( labelpair.second, last ) );
+
+      if( m_ZeroLabelInvalid && ( labelpair.first == 0 || labelpair.second == 0 ) )
+      {
+        continue;
+      }
+      if( !allowLoops && labelpair.first == labelpair.second )
+      {
+        continue;
+      }
+
+      ConnectionCountMap::iterator connection = connections.find( ConnectionKey( labelpair ) );
+      if( connection == connections.end() )
+      {
+        ConnectionCount newConnection = { fiberID, labelpair, 1 };
+        connections.insert( std::make_pair( ConnectionKey( labelpair ), newConnection ) );
+      }
+      else
+      {
+        connection->second.weight++;
+      }
     }
+  }
 
-    if ( singleTract && ( singleTract->Size() > 0 ) )
+  // merge the blocks in fiber order, so the earliest occurrence is kept
+  LabelOccurrenceMap labelOccurrences;
+  ConnectionCountMap connectionCounts;
+  for( int block = 0; block < numBlocks; block++ )
+  {
+    labelOccurrences.insert( blockLabels[ block ].begin(), blockLabels[ block ].end() );
+    for( ConnectionCountMap::const_iterator it = blockConnections[ block ].begin(); it != blockConnections[ block ].end(); ++it )
     {
-      AddConnectionToNetwork(
-        ReturnAssociatedVertexPairForLabelPair(
-        ReturnLabelForFiberTract( singleTract, m_MappingStrategy )
-        )
-        );
-      m_AbortConnection = false;
+      std::pair< ConnectionCountMap::iterator, bool > inserted = connectionCounts.insert( *it );
+      if( !inserted.second )
+      {
+        inserted.first->second.weight += it->second.weight;
+      }
     }
+    LabelOccurrenceMap().swap( blockLabels[ block ] );
+    ConnectionCountMap().swap( blockConnections[ block ] );
+  }
+
+  // create nodes and vertices in the order in which the labels were encountered
+  std::vector< std::pair< long long, ImageLabelType > > labelOrder;
+  labelOrder.reserve( labelOccurrences.size() );
+  for( LabelOccurrenceMap::const_iterator it = labelOccurrences.begin(); it != labelOccurrences.end(); ++it )
+  {
+    labelOrder.push_back( std::make_pair( it->second.order, it->first ) );
+  }
+  std::sort( labelOrder.begin(), labelOrder.end() );
+
+  for( unsigned int i = 0; i < labelOrder.size(); i++ )
+  {
+    ImageLabelType label = labelOrder[ i ].second;
+    CreateNewNode( label, labelOccurrences[ label ].index, m_UseCoMCoordinates );
+    if( !( m_ZeroLabelInvalid && ( label == 0 ) ) )
+    {
+      ReturnAssociatedVertexForLabel( label );
+    }
+  }
+
+  // add every edge once with its final weight, in the order of the first fiber supporting it
+  std::vector< std::pair< int, ImageLabelPairType > > edgeOrder;
+  edgeOrder.reserve( connectionCounts.size() );
+  for( ConnectionCountMap::const_iterator it = connectionCounts.begin(); it != connectionCounts.end(); ++it )
+  {
+    edgeOrder.push_back( std::make_pair( it->second.firstFiber, it->second.labels ) );
+  }
+  std::sort( edgeOrder.begin(), edgeOrder.end() );
+
+  for( unsigned int i = 0; i < edgeOrder.size(); i++ )
+  {
+    ConnectionType connection = ReturnAssociatedVertexPairForLabelPair( edgeOrder[ i ].second );
+    m_ConNetwork->AddEdge( connection.first, connection.second,
+      m_ConNetwork->GetNode( connection.first ).id, m_ConNetwork->GetNode( connection.second ).id,
+      connectionCounts[ ConnectionKey( edgeOrder[ i ].second ) ].weight );
   }
 
   // Prune unconnected nodes
@@ -195,21 +341,25 @@ mitk::ConnectomicsNetworkCreator::ConnectionType mitk::ConnectomicsNetworkCreato
   return connection;
 }
 
-mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::ReturnLabelForFiberTract( TractType::Pointer singleTract, mitk::ConnectomicsNetworkCreator::MappingStrategy strategy)
+mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::ReturnLabelForFiberTract( const FiberPoints& singleTract, mitk::ConnectomicsNetworkCreator::MappingStrategy strategy,
+  itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex )
 {
+  firstElementSegIndex.Fill( 0 );
+  lastElementSegIndex.Fill( 0 );
+
   switch( strategy )
   {
   case EndElementPosition:
     {
-      return EndElementPositionLabel( singleTract );
+      return EndElementPositionLabel( singleTract, firstElementSegIndex, lastElementSegIndex );
     }
   case JustEndPointVerticesNoLabel:
     {
-      return JustEndPointVerticesNoLabelTest( singleTract );
+      return JustEndPointVerticesNoLabelTest( singleTract, firstElementSegIndex, lastElementSegIndex );
     }
   case EndElementPositionAvoidingWhiteMatter:
     {
-      return EndElementPositionLabelAvoidingWhiteMatter( singleTract );
+      return EndElementPositionLabelAvoidingWhiteMatter( singleTract, firstElementSegIndex, lastElementSegIndex );
     }
   case PrecomputeAndDistance:
     {
@@ -223,23 +373,22 @@ mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCr
   return nullPair;
 }
 
-mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::EndElementPositionLabel( TractType::Pointer singleTract )
+mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::EndElementPositionLabel( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex )
 {
   ImageLabelPairType labelpair;
 
   {// Note: .fib image tracts are safed using index coordinates
     mitk::Point3D firstElementFiberCoord, lastElementFiberCoord;
     mitk::Point3D firstElementSegCoord, lastElementSegCoord;
-    itk::Index<3> firstElementSegIndex, lastElementSegIndex;
 
-    if( singleTract->front().Size() != 3 )
+    if( singleTract.front().Size() != 3 )
     {
       MBI_ERROR << mitk::ConnectomicsConstantsManager::CONNECTOMICS_ERROR_INVALID_DIMENSION_NEED_3;
     }
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
-      firstElementFiberCoord.SetElement( index, singleTract->front().GetElement( index ) );
-      lastElementFiberCoord.SetElement( index, singleTract->back().GetElement( index ) );
+      firstElementFiberCoord.SetElement( index, singleTract.front().GetElement( index ) );
+      lastElementFiberCoord.SetElement( index, singleTract.back().GetElement( index ) );
     }
 
     // convert from fiber index coordinates to segmentation index coordinates
@@ -257,39 +406,34 @@ mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCr
 
     labelpair.first = firstLabel;
     labelpair.second = lastLabel;
-
-    // Add property to property map
-    CreateNewNode( firstLabel, firstElementSegIndex, m_UseCoMCoordinates );
-    CreateNewNode( lastLabel, lastElementSegIndex, m_UseCoMCoordinates );
   }
 
   return labelpair;
 }
 
-mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::PrecomputeVertexLocationsBySegmentation( TractType::Pointer /*singleTract*/ )
+mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::PrecomputeVertexLocationsBySegmentation( const FiberPoints& /*singleTract*/ )
 {
   ImageLabelPairType labelpair;
 
   return labelpair;
 }
 
-mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::EndElementPositionLabelAvoidingWhiteMatter( TractType::Pointer singleTract )
+mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::EndElementPositionLabelAvoidingWhiteMatter( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex )
 {
   ImageLabelPairType labelpair;
 
   {// Note: .fib image tracts are safed using index coordinates
     mitk::Point3D firstElementFiberCoord, lastElementFiberCoord;
     mitk::Point3D firstElementSegCoord, lastElementSegCoord;
-    itk::Index<3> firstElementSegIndex, lastElementSegIndex;
 
-    if( singleTract->front().Size() != 3 )
+    if( singleTract.front().Size() != 3 )
     {
       MBI_ERROR << mitk::ConnectomicsConstantsManager::CONNECTOMICS_ERROR_INVALID_DIMENSION_NEED_3;
     }
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
-      firstElementFiberCoord.SetElement( index, singleTract->front().GetElement( index ) );
-      lastElementFiberCoord.SetElement( index, singleTract->back().GetElement( index ) );
+      firstElementFiberCoord.SetElement( index, singleTract.front().GetElement( index ) );
+      lastElementFiberCoord.SetElement( index, singleTract.back().GetElement( index ) );
     }
 
     // convert from fiber index coordinates to segmentation index coordinates
@@ -340,8 +484,8 @@ mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCr
       std::vector< int > indexVectorOfPointsToUse;
 
       //Use last two points for direction
-      indexVectorOfPointsToUse.push_back( singleTract->Size() - 2 );
-      indexVectorOfPointsToUse.push_back( singleTract->Size() - 1 );
+      indexVectorOfPointsToUse.push_back( singleTract.Size() - 2 );
+      indexVectorOfPointsToUse.push_back( singleTract.Size() - 1 );
 
       // label and coordinate temp storage
       int tempLabel( lastLabel );
@@ -383,32 +527,27 @@ mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCr
 
     labelpair.first = firstLabel;
     labelpair.second = lastLabel;
-
-    // Add property to property map
-    CreateNewNode( firstLabel, firstElementSegIndex, m_UseCoMCoordinates );
-    CreateNewNode( lastLabel, lastElementSegIndex, m_UseCoMCoordinates );
   }
 
   return labelpair;
 }
 
-mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::JustEndPointVerticesNoLabelTest( TractType::Pointer singleTract )
+mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCreator::JustEndPointVerticesNoLabelTest( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex )
 {
   ImageLabelPairType labelpair;
 
    {// Note: .fib image tracts are safed using index coordinates
     mitk::Point3D firstElementFiberCoord, lastElementFiberCoord;
     mitk::Point3D firstElementSegCoord, lastElementSegCoord;
-    itk::Index<3> firstElementSegIndex, lastElementSegIndex;
 
-    if( singleTract->front().Size() != 3 )
+    if( singleTract.front().Size() != 3 )
     {
       MBI_ERROR << mitk::ConnectomicsConstantsManager::CONNECTOMICS_ERROR_INVALID_DIMENSION_NEED_3;
     }
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
-      firstElementFiberCoord.SetElement( index, singleTract->front().GetElement( index ) );
-      lastElementFiberCoord.SetElement( index, singleTract->back().GetElement( index ) );
+      firstElementFiberCoord.SetElement( index, singleTract.front().GetElement( index ) );
+      lastElementFiberCoord.SetElement( index, singleTract.back().GetElement( index ) );
     }
 
     // convert from fiber index coordinates to segmentation index coordinates
@@ -426,10 +565,6 @@ mitk::ConnectomicsNetworkCreator::ImageLabelPairType mitk::ConnectomicsNetworkCr
 
     labelpair.first = firstLabel;
     labelpair.second = lastLabel;
-
-    // Add property to property map
-    CreateNewNode( firstLabel, firstElementSegIndex, m_UseCoMCoordinates );
-    CreateNewNode( lastLabel, lastElementSegIndex, m_UseCoMCoordinates );
   }
 
   return labelpair;
@@ -506,11 +641,11 @@ bool mitk::ConnectomicsNetworkCreator::IsBackgroundLabel( int labelInQuestion )
 
 void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
   std::vector<int> & indexVectorOfPointsToUse,
-  TractType::Pointer singleTract,
+  const FiberPoints& singleTract,
   int & label,
   itk::Index<3> & mitkIndex )
 {
-  if( indexVectorOfPointsToUse.size() > singleTract->Size() )
+  if( indexVectorOfPointsToUse.size() > singleTract.Size() )
   {
     MBI_WARN << mitk::ConnectomicsConstantsManager::CONNECTOMICS_WARNING_MORE_POINTS_THAN_PRESENT;
     return;
@@ -529,7 +664,7 @@ void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
       MBI_WARN << mitk::ConnectomicsConstantsManager::CONNECTOMICS_WARNING_ESTIMATING_BEYOND_START;
       return;
     }
-    if( (unsigned int)indexVectorOfPointsToUse[ index ] > singleTract->Size() )
+    if( (unsigned int)indexVectorOfPointsToUse[ index ] > singleTract.Size() )
     {
       MBI_WARN << mitk::ConnectomicsConstantsManager::CONNECTOMICS_WARNING_ESTIMATING_BEYOND_END;
       return;
@@ -538,7 +673,7 @@ void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
 
   mitk::Point3D startPoint, endPoint;
   std::vector< double > differenceVector;
-  differenceVector.resize( singleTract->front().Size() );
+  differenceVector.resize( singleTract.front().Size() );
 
   {
     // which points to use, currently only last two //TODO correct using all points
@@ -547,10 +682,10 @@ void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
 
     // convert to segmentation coords
     mitk::Point3D startFiber, endFiber;
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
-      endFiber.SetElement( index, singleTract->GetElement( indexVectorOfPointsToUse[ endPointIndex ] ).GetElement( index ) );
-      startFiber.SetElement( index, singleTract->GetElement( indexVectorOfPointsToUse[ startPointIndex ] ).GetElement( index ) );
+      endFiber.SetElement( index, singleTract.GetElement( indexVectorOfPointsToUse[ endPointIndex ] ).GetElement( index ) );
+      startFiber.SetElement( index, singleTract.GetElement( indexVectorOfPointsToUse[ startPointIndex ] ).GetElement( index ) );
     }
 
     FiberToSegmentationCoords( endFiber, endPoint );
@@ -558,7 +693,7 @@ void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
 
     // calculate straight line
 
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
       differenceVector[ index ] = endPoint.GetElement( index ) - startPoint.GetElement( index );
     }
@@ -629,10 +764,10 @@ void mitk::ConnectomicsNetworkCreator::LinearExtensionUntilGreyMatter(
   }
 }
 
-void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractFront, TractType::Pointer singleTract,
+void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractFront, const FiberPoints& singleTract,
                                                                   int & label, itk::Index<3> & mitkIndex )
 {
-  int retractionStartIndex( singleTract->Size() - 1 );
+  int retractionStartIndex( singleTract.Size() - 1 );
   int retractionStepIndexSize( -1 );
   int retractionTerminationIndex( 0 );
 
@@ -640,7 +775,7 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
   {
     retractionStartIndex = 0;
     retractionStepIndexSize = 1;
-    retractionTerminationIndex = singleTract->Size() - 1;
+    retractionTerminationIndex = singleTract.Size() - 1;
   }
 
   int currentRetractionIndex = retractionStartIndex;
@@ -649,16 +784,16 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
 
   mitk::Point3D currentPoint, nextPoint;
   std::vector< double > differenceVector;
-  differenceVector.resize( singleTract->front().Size() );
+  differenceVector.resize( singleTract.front().Size() );
 
   while( keepRetracting && ( currentRetractionIndex != retractionTerminationIndex ) )
   {
     // convert to segmentation coords
     mitk::Point3D currentPointFiberCoord, nextPointFiberCoord;
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
-      currentPointFiberCoord.SetElement( index, singleTract->GetElement( currentRetractionIndex ).GetElement( index ) );
-      nextPointFiberCoord.SetElement( index, singleTract->GetElement( currentRetractionIndex + retractionStepIndexSize ).GetElement( index ) );
+      currentPointFiberCoord.SetElement( index, singleTract.GetElement( currentRetractionIndex ).GetElement( index ) );
+      nextPointFiberCoord.SetElement( index, singleTract.GetElement( currentRetractionIndex + retractionStepIndexSize ).GetElement( index ) );
     }
 
     FiberToSegmentationCoords( currentPointFiberCoord, currentPoint );
@@ -666,7 +801,7 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
 
     // calculate straight line
 
-    for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+    for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
     {
       differenceVector[ index ] = nextPoint.GetElement( index ) - currentPoint.GetElement( index );
     }
@@ -703,10 +838,10 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
         // check whether result is within the search space
         {
           mitk::Point3D endPoint, foundPointSegmentation, foundPointFiber;
-          for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+          for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
           {
             // this is in fiber (world) coordinates
-            endPoint.SetElement( index, singleTract->GetElement( retractionStartIndex ).GetElement( index ) );
+            endPoint.SetElement( index, singleTract.GetElement( retractionStartIndex ).GetElement( index ) );
           }
 
           for( int index( 0 ); index < 3; index++ )
@@ -718,8 +853,8 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
           SegmentationToFiberCoords( foundPointSegmentation, foundPointFiber );
 
           std::vector< double > finalDistance;
-          finalDistance.resize( singleTract->front().Size() );
-          for( unsigned int index = 0; index < singleTract->front().Size(); index++ )
+          finalDistance.resize( singleTract.front().Size() );
+          for( unsigned int index = 0; index < singleTract.front().Size(); index++ )
           {
             finalDistance[ index ] = foundPointFiber.GetElement( index ) - endPoint.GetElement( index );
           }
@@ -748,7 +883,7 @@ void mitk::ConnectomicsNetworkCreator::RetractionUntilBrainMatter( bool retractF
       }
       // hit next point without finding brain matter
       currentRetractionIndex = currentRetractionIndex + retractionStepIndexSize;
-      if( ( currentRetractionIndex < 1 ) || ( (unsigned int)currentRetractionIndex > ( singleTract->Size() - 2 ) ) )
+      if( ( currentRetractionIndex < 1 ) || ( (unsigned int)currentRetractionIndex > ( singleTract.Size() - 2 ) ) )
       {
         keepRetracting = false;
       }
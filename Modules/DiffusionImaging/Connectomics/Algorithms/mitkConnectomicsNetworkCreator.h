@@ -29,6 +29,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkConnectomicsExports.h>
 
+#include <vtkPoints.h>
+
 namespace mitk
 {
 
@@ -37,6 +39,10 @@ namespace mitk
     *
     * This class needs a parcellation image and a fiber image to be set. Then you can create
     * a connectomics network from the two, using different strategies.
+    *
+    * The fibers are labeled in parallel, reading their points directly from the fiber polydata.
+    * Connections are counted per block of fibers and added to the network at the end, in the
+    * order in which they were first encountered.
     */
 
   class MITKCONNECTOMICS_EXPORT ConnectomicsNetworkCreator : public itk::Object
@@ -69,6 +75,19 @@ namespace mitk
     typedef itk::VectorContainer<unsigned int, PointType>                TractType;
     typedef itk::VectorContainer< unsigned int, TractType::Pointer >     TractContainerType; //init via smartpointer
 
+    /** A single fiber, referencing the points in the polydata of the fiber bundle */
+    struct FiberPoints
+    {
+      vtkPoints*        points;
+      const vtkIdType*  pointIds;
+      unsigned int      numberOfPoints;
+
+      unsigned int Size() const { return numberOfPoints; }
+      PointType GetElement( unsigned int index ) const;
+      PointType front() const { return GetElement( 0 ); }
+      PointType back() const { return GetElement( numberOfPoints - 1 ); }
+    };
+
 
     /** Types for Network **/
     typedef mitk::ConnectomicsNetwork::VertexDescriptorType VertexType;
@@ -115,8 +134,12 @@ namespace mitk
     /** Return the vertexes associated with a pair of labels */
     ConnectionType ReturnAssociatedVertexPairForLabelPair( ImageLabelPairType labelpair );
 
-    /** Return the pair of labels which identify the areas connected by a single fiber */
-    ImageLabelPairType ReturnLabelForFiberTract( TractType::Pointer singleTract, MappingStrategy strategy );
+    /** Return the pair of labels which identify the areas connected by a single fiber
+
+    The segmentation indices at which the labels were found are returned as well. This does not modify the
+    network or the label maps, so it can be called for several fibers in parallel. */
+    ImageLabelPairType ReturnLabelForFiberTract( const FiberPoints& singleTract, MappingStrategy strategy,
+      itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex );
 
     /** Assign the additional information which should be part of the vertex */
     void SupplyVertexWithInformation( ImageLabelType& label, VertexType& vertex );
@@ -134,13 +157,13 @@ namespace mitk
 
     It will try extend in the direction of the points in the vector so a vector {B,C} will result in
     extending from C in the direction C-B */
-    void LinearExtensionUntilGreyMatter( std::vector<int> & indexVectorOfPointsToUse, TractType::Pointer singleTract,
+    void LinearExtensionUntilGreyMatter( std::vector<int> & indexVectorOfPointsToUse, const FiberPoints& singleTract,
       int & label, itk::Index<3> & mitkIndex );
 
     /** Retract fiber until the first brain matter label is hit
 
     The bool parameter controls whether the front or the end is retracted */
-    void RetractionUntilBrainMatter( bool retractFront, TractType::Pointer singleTract,
+    void RetractionUntilBrainMatter( bool retractFront, const FiberPoints& singleTract,
       int & label, itk::Index<3> & mitkIndex );
 
     /** \brief Get the location of the center of mass for a specific label
@@ -164,25 +187,25 @@ namespace mitk
 
     Map a fiber to a vertex by taking the value of the parcellation image at the same world coordinates as the last
     and first element of the tract.*/
-    ImageLabelPairType EndElementPositionLabel( TractType::Pointer singleTract );
+    ImageLabelPairType EndElementPositionLabel( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex );
 
     /** Map by distance between elements and vertices depending on their volume
 
     First go through the parcellation and compute the coordinates of the future vertices. Assign a radius according on their volume.
     Then map an edge to a label by considering the nearest vertices and comparing the distance to them to their radii. */
-    ImageLabelPairType PrecomputeVertexLocationsBySegmentation( TractType::Pointer singleTract );
+    ImageLabelPairType PrecomputeVertexLocationsBySegmentation( const FiberPoints& singleTract );
 
         /** Use the position of the end and starting element only to map to labels
 
     Just take first and last position, no labelling, nothing */
-    ImageLabelPairType JustEndPointVerticesNoLabelTest( TractType::Pointer singleTract );
+    ImageLabelPairType JustEndPointVerticesNoLabelTest( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex );
 
     /** Use the position of the end and starting element unless it is in white matter, then search for nearby parcellation to map to labels
 
     Map a fiber to a vertex by taking the value of the parcellation image at the same world coordinates as the last
     and first element of the tract. If this happens to be white matter, then try to extend the fiber in a line and
     take the first non-white matter parcel, that is intersected. */
-    ImageLabelPairType EndElementPositionLabelAvoidingWhiteMatter( TractType::Pointer singleTract );
+    ImageLabelPairType EndElementPositionLabelAvoidingWhiteMatter( const FiberPoints& singleTract, itk::Index<3>& firstElementSegIndex, itk::Index<3>& lastElementSegIndex );
 
     ///////// Conversions //////////
     /** Convert fiber index to segmentation index coordinates */
@@ -16,6 +16,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkConnectomicsSimulatedAnnealingCostFunctionModularity.h"
 
+#include <algorithm>
+
 mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::ConnectomicsSimulatedAnnealingCostFunctionModularity()
 {
 }
@@ -105,6 +107,197 @@ double mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::CalculateModu
   return modularity;
 }
 
+void mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::BuildAdjacency(
+  mitk::ConnectomicsNetwork::Pointer network, AdjacencyType *adjacency )
+{
+  const std::vector< VertexDescriptorType > allNodesVector
+    = network->GetVectorOfAllVertexDescriptors();
+
+  std::map< VertexDescriptorType, int > vertexToIndexMap;
+  for( unsigned int nodeNumber( 0 ); nodeNumber < allNodesVector.size() ; nodeNumber++)
+  {
+    vertexToIndexMap.insert( std::pair< VertexDescriptorType, int >( allNodesVector[ nodeNumber ], nodeNumber ) );
+  }
+
+  adjacency->offsets.assign( 1, 0 );
+  adjacency->neighbours.clear();
+  for( unsigned int nodeNumber( 0 ); nodeNumber < allNodesVector.size() ; nodeNumber++)
+  {
+    const std::vector< VertexDescriptorType > adjacentNodexVector
+      = network->GetVectorOfAdjacentNodes( allNodesVector[ nodeNumber ] );
+    for( unsigned int adjacentNodeNumber( 0 ); adjacentNodeNumber < adjacentNodexVector.size() ; adjacentNodeNumber++)
+    {
+      adjacency->neighbours.push_back( vertexToIndexMap.find( adjacentNodexVector[ adjacentNodeNumber ] )->second );
+    }
+    adjacency->offsets.push_back( adjacency->neighbours.size() );
+  }
+}
+
+void mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::InitializeModuleStatistics(
+  const AdjacencyType &adjacency, const std::vector< int > &modules, ModuleStatisticsType *statistics ) const
+{
+  int numberOfModules( 0 );
+  for( unsigned int vertex( 0 ); vertex < modules.size(); vertex++ )
+  {
+    numberOfModules = std::max( numberOfModules, modules[ vertex ] + 1 );
+  }
+
+  statistics->adjacenciesInModule.assign( numberOfModules, 0 );
+  statistics->sumOfDegreesInModule.assign( numberOfModules, 0 );
+  statistics->verticesInModule.assign( numberOfModules, 0 );
+
+  for( unsigned int vertex( 0 ); vertex < modules.size(); vertex++ )
+  {
+    const int module = modules[ vertex ];
+    statistics->verticesInModule[ module ]++;
+    statistics->sumOfDegreesInModule[ module ] += adjacency.offsets[ vertex + 1 ] - adjacency.offsets[ vertex ];
+    for( int index( adjacency.offsets[ vertex ] ); index < adjacency.offsets[ vertex + 1 ]; index++ )
+    {
+      if( modules[ adjacency.neighbours[ index ] ] == module )
+      {
+        statistics->adjacenciesInModule[ module ]++;
+      }
+    }
+  }
+}
+
+double mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::Evaluate(
+  const AdjacencyType &adjacency, const ModuleStatisticsType &statistics ) const
+{
+  return 100.0 * ( 1.0 - CalculateModularity( adjacency, statistics ) );
+}
+
+double mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::CalculateModuleModularity(
+  int adjacenciesInModule, int sumOfDegreesInModule, int numberOfLinksInNetwork ) const
+{
+  // see CalculateModularity( network, vertexToModuleMap ), each link inside of the module was counted twice
+  const double degreeFraction = ((double) sumOfDegreesInModule) / ((double) 2 * numberOfLinksInNetwork);
+  return ((double) ( adjacenciesInModule / 2 )) / ((double) numberOfLinksInNetwork) - degreeFraction * degreeFraction;
+}
+
+double mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::CalculateModularity(
+  const AdjacencyType &adjacency, const ModuleStatisticsType &statistics ) const
+{
+  const int numberOfLinksInNetwork = adjacency.neighbours.size() / 2;
+
+  // if the network contains no links return 0
+  if( numberOfLinksInNetwork < 1)
+  {
+    return 0;
+  }
+
+  double modularity( 0.0 );
+  for( unsigned int moduleID( 0 ); moduleID < statistics.adjacenciesInModule.size(); moduleID++ )
+  {
+    modularity += CalculateModuleModularity( statistics.adjacenciesInModule[ moduleID ],
+      statistics.sumOfDegreesInModule[ moduleID ], numberOfLinksInNetwork );
+  }
+  return modularity;
+}
+
+double mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::EvaluateSingleNodeMove(
+  const AdjacencyType &adjacency, const std::vector< int > &modules,
+  const ModuleStatisticsType &statistics, int vertex, int module ) const
+{
+  const int numberOfLinksInNetwork = adjacency.neighbours.size() / 2;
+  const int previousModule = modules[ vertex ];
+  if( numberOfLinksInNetwork < 1 || previousModule == module )
+  {
+    return 0;
+  }
+
+  // links of the vertex into its previous and its new module, self loops move with the vertex
+  const int degree = adjacency.offsets[ vertex + 1 ] - adjacency.offsets[ vertex ];
+  int linksToPreviousModule( 0 ), linksToModule( 0 ), selfAdjacencies( 0 );
+  for( int index( adjacency.offsets[ vertex ] ); index < adjacency.offsets[ vertex + 1 ]; index++ )
+  {
+    const int neighbour = adjacency.neighbours[ index ];
+    if( neighbour == vertex )
+    {
+      selfAdjacencies++;
+    }
+    else if( modules[ neighbour ] == previousModule )
+    {
+      linksToPreviousModule++;
+    }
+    else if( modules[ neighbour ] == module )
+    {
+      linksToModule++;
+    }
+  }
+
+  // only the contributions of the two modules involved change
+  const int previousAdjacencies = statistics.adjacenciesInModule[ previousModule ];
+  const int previousDegrees = statistics.sumOfDegreesInModule[ previousModule ];
+  const int adjacencies = statistics.adjacenciesInModule[ module ];
+  const int degrees = statistics.sumOfDegreesInModule[ module ];
+
+  const double modularityChange =
+    CalculateModuleModularity( previousAdjacencies - 2 * linksToPreviousModule - selfAdjacencies, previousDegrees - degree, numberOfLinksInNetwork )
+    - CalculateModuleModularity( previousAdjacencies, previousDegrees, numberOfLinksInNetwork )
+    + CalculateModuleModularity( adjacencies + 2 * linksToModule + selfAdjacencies, degrees + degree, numberOfLinksInNetwork )
+    - CalculateModuleModularity( adjacencies, degrees, numberOfLinksInNetwork );
+
+  return -100.0 * modularityChange;
+}
+
+void mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::MoveSingleNode(
+  const AdjacencyType &adjacency, std::vector< int > *modules,
+  ModuleStatisticsType *statistics, int vertex, int module ) const
+{
+  const int previousModule = (*modules)[ vertex ];
+  if( previousModule == module )
+  {
+    return;
+  }
+
+  const int degree = adjacency.offsets[ vertex + 1 ] - adjacency.offsets[ vertex ];
+  for( int index( adjacency.offsets[ vertex ] ); index < adjacency.offsets[ vertex + 1 ]; index++ )
+  {
+    const int neighbour = adjacency.neighbours[ index ];
+    if( neighbour == vertex )
+    {
+      statistics->adjacenciesInModule[ previousModule ]--;
+      statistics->adjacenciesInModule[ module ]++;
+    }
+    else if( (*modules)[ neighbour ] == previousModule )
+    {
+      statistics->adjacenciesInModule[ previousModule ] -= 2;
+    }
+    else if( (*modules)[ neighbour ] == module )
+    {
+      statistics->adjacenciesInModule[ module ] += 2;
+    }
+  }
+  statistics->sumOfDegreesInModule[ previousModule ] -= degree;
+  statistics->sumOfDegreesInModule[ module ] += degree;
+  statistics->verticesInModule[ previousModule ]--;
+  statistics->verticesInModule[ module ]++;
+  (*modules)[ vertex ] = module;
+
+  // remove the now empty module by renumbering the last module to it
+  if( statistics->verticesInModule[ previousModule ] < 1 )
+  {
+    const int lastModule = statistics->verticesInModule.size() - 1;
+    if( previousModule != lastModule )
+    {
+      for( unsigned int index( 0 ); index < modules->size(); index++ )
+      {
+        if( (*modules)[ index ] == lastModule )
+        {
+          (*modules)[ index ] = previousModule;
+        }
+      }
+      statistics->adjacenciesInModule[ previousModule ] = statistics->adjacenciesInModule[ lastModule ];
+      statistics->sumOfDegreesInModule[ previousModule ] = statistics->sumOfDegreesInModule[ lastModule ];
+      statistics->verticesInModule[ previousModule ] = statistics->verticesInModule[ lastModule ];
+    }
+    statistics->adjacenciesInModule.pop_back();
+    statistics->sumOfDegreesInModule.pop_back();
+    statistics->verticesInModule.pop_back();
+  }
+}
+
 int mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::getNumberOfModules(
   ToModuleMapType *vertexToModuleMap ) const
 {
@@ -33,6 +33,24 @@ namespace mitk
     typedef std::map< VertexDescriptorType, int > ToModuleMapType;
     typedef std::map< VertexDescriptorType, VertexDescriptorType > VertexToVertexMapType;
 
+    // Adjacency of the network in compressed sparse row layout, vertices are numbered
+    // in the order of ConnectomicsNetwork::GetVectorOfAllVertexDescriptors()
+    struct AdjacencyType
+    {
+      // the neighbours of vertex i are neighbours[ offsets[ i ] ] to neighbours[ offsets[ i + 1 ] - 1 ]
+      std::vector< int > offsets;
+      std::vector< int > neighbours;
+    };
+
+    // Per module counts of a vertex to module assignment, allowing incremental updates of the modularity
+    struct ModuleStatisticsType
+    {
+      // number of adjacencies inside of the module, i.e. twice the number of links in the module
+      std::vector< int > adjacenciesInModule;
+      std::vector< int > sumOfDegreesInModule;
+      std::vector< int > verticesInModule;
+    };
+
     /** Standard class typedefs. */
     /** Method for creation through the object factory. */
 
@@ -46,12 +64,36 @@ namespace mitk
     // Will calculate and return the modularity of the network
     double CalculateModularity( mitk::ConnectomicsNetwork::Pointer network, ToModuleMapType *vertexToModuleMap  ) const;
 
+    // Build the compressed sparse row adjacency of the network
+    static void BuildAdjacency( mitk::ConnectomicsNetwork::Pointer network, AdjacencyType *adjacency );
+
+    // Calculate the module statistics of a vertex to module assignment, modules are indexed like the adjacency
+    void InitializeModuleStatistics( const AdjacencyType &adjacency, const std::vector< int > &modules, ModuleStatisticsType *statistics ) const;
+
+    // Evaluate a vertex to module assignment using its module statistics
+    double Evaluate( const AdjacencyType &adjacency, const ModuleStatisticsType &statistics ) const;
+
+    // Calculate the modularity from the module statistics
+    double CalculateModularity( const AdjacencyType &adjacency, const ModuleStatisticsType &statistics ) const;
+
+    // Return the change of the cost if vertex were moved to module, in O( degree of the vertex )
+    double EvaluateSingleNodeMove( const AdjacencyType &adjacency, const std::vector< int > &modules,
+      const ModuleStatisticsType &statistics, int vertex, int module ) const;
+
+    // Move vertex to module and update the statistics. If the previous module of the vertex becomes empty
+    // it is removed by renumbering the highest module to it
+    void MoveSingleNode( const AdjacencyType &adjacency, std::vector< int > *modules,
+      ModuleStatisticsType *statistics, int vertex, int module ) const;
+
 
   protected:
 
     // returns the number of modules
     int getNumberOfModules( ToModuleMapType *vertexToModuleMap ) const;
 
+    // contribution of a single module to the modularity
+    double CalculateModuleModularity( int adjacenciesInModule, int sumOfDegreesInModule, int numberOfLinksInNetwork ) const;
+
     //////////////////// Functions ///////////////////////
     ConnectomicsSimulatedAnnealingCostFunctionModularity();
     ~ConnectomicsSimulatedAnnealingCostFunctionModularity();
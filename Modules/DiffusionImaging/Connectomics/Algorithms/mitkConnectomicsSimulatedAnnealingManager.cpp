@@ -20,8 +20,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/vnl_random.h"
 #include "vnl/vnl_math.h"
 
+#include <cmath>
+#include <vector>
+
 mitk::ConnectomicsSimulatedAnnealingManager::ConnectomicsSimulatedAnnealingManager()
 : m_Permutation( nullptr )
+, m_NumberOfChains( 1 )
+, m_TemperatureRatio( 2.0 )
+, m_RandomSeed( -1 )
 {
 }
 
@@ -76,17 +82,72 @@ void mitk::ConnectomicsSimulatedAnnealingManager::RunSimulatedAnnealing(
     return;
   }
 
-  // Initialize the associated permutation
-  m_Permutation->Initialize();
+  // Set up the chains, the first one is the associated permutation
+  std::vector< mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer > chains;
+  chains.push_back( m_Permutation );
+  for( unsigned int chain( 1 ); chain < m_NumberOfChains; chain++ )
+  {
+    mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer newChain = m_Permutation->CreateChain();
+    if( newChain.IsNull() )
+    {
+      MBI_WARN << "Permutation does not support multiple chains, running a single chain.";
+      chains.resize( 1 );
+      break;
+    }
+    chains.push_back( newChain );
+  }
+  const int numberOfChains = chains.size();
+
+  // Initialize the chains
+  for( int chain( 0 ); chain < numberOfChains; chain++ )
+  {
+    if( m_RandomSeed > -1 )
+    {
+      chains[ chain ]->SetRandomSeed( m_RandomSeed + chain );
+    }
+    chains[ chain ]->Initialize();
+  }
 
+  // random generator for the exchanges between chains
+  vnl_random rng( m_RandomSeed > -1 ? (unsigned long) ( m_RandomSeed + numberOfChains ) : (unsigned long) rand() );
 
   for( double currentTemperature( temperature );
     currentTemperature > 0.00001;
     currentTemperature = currentTemperature / stepSize )
   {
     // Run Permutations at the current temperature
-    m_Permutation->Permutate( currentTemperature );
+#pragma omp parallel for schedule(dynamic, 1)
+    for( int chain = 0; chain < numberOfChains; chain++ )
+    {
+      chains[ chain ]->Permutate( currentTemperature * std::pow( m_TemperatureRatio, chain ) );
+    }
+
+    // Exchange solutions of neighbouring chains
+    for( int chain( 0 ); chain + 1 < numberOfChains; chain++ )
+    {
+      const double colderTemperature = currentTemperature * std::pow( m_TemperatureRatio, chain );
+      const double warmerTemperature = colderTemperature * m_TemperatureRatio;
+      const double exponent = ( 1.0 / colderTemperature - 1.0 / warmerTemperature )
+        * ( chains[ chain ]->GetCost() - chains[ chain + 1 ]->GetCost() );
+      if( exponent >= 0 || rng.drand64( 0.0, 1.0 ) < std::exp( exponent ) )
+      {
+        chains[ chain ]->SwapSolution( chains[ chain + 1 ] );
+      }
+    }
+  }
 
+  // Keep the best solution of all chains
+  int bestChain( 0 );
+  for( int chain( 1 ); chain < numberOfChains; chain++ )
+  {
+    if( chains[ chain ]->GetCost() < chains[ bestChain ]->GetCost() )
+    {
+      bestChain = chain;
+    }
+  }
+  if( bestChain != 0 )
+  {
+    m_Permutation->SwapSolution( chains[ bestChain ] );
   }
 
   // Clean up result
@@ -30,7 +30,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace mitk
 {
   /**
-  * \brief A class allow generic simulated annealing by using classes derived from ConnectomicsSimulatedAnnealingPermutationBase */
+  * \brief A class allow generic simulated annealing by using classes derived from ConnectomicsSimulatedAnnealingPermutationBase
+  *
+  * With more than one chain, parallel tempering is used: chain i runs in parallel to the others at the current
+  * temperature times TemperatureRatio^i, and after each temperature step the solutions of neighbouring chains are
+  * exchanged with the replica exchange acceptance probability. Chain i is seeded with RandomSeed + i, so a fixed seed
+  * and number of chains always gives the same result. The best solution of all chains is returned by the permutation
+  * that was set. */
   class MITKCONNECTOMICS_EXPORT ConnectomicsSimulatedAnnealingManager : public itk::Object
   {
   public:
@@ -51,6 +57,18 @@ namespace mitk
     // Set the permutation to be used
     void SetPermutation( mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer permutation );
 
+    // Number of chains for parallel tempering, 1 runs a single simulated annealing chain
+    itkSetMacro( NumberOfChains, unsigned int )
+    itkGetMacro( NumberOfChains, unsigned int )
+
+    // Ratio between the temperatures of neighbouring chains
+    itkSetMacro( TemperatureRatio, double )
+    itkGetMacro( TemperatureRatio, double )
+
+    // Seed for the random generators, -1 for random seeding
+    itkSetMacro( RandomSeed, int )
+    itkGetMacro( RandomSeed, int )
+
   protected:
 
     //////////////////// Functions ///////////////////////
@@ -61,6 +79,15 @@ namespace mitk
     // The permutation assigned to the simulated annealing manager
     mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer m_Permutation;
 
+    // The number of chains run in parallel
+    unsigned int m_NumberOfChains;
+
+    // The ratio between the temperatures of neighbouring chains
+    double m_TemperatureRatio;
+
+    // The seed for the random generators, -1 for random seeding
+    int m_RandomSeed;
+
   };
 
 }// end namespace mitk
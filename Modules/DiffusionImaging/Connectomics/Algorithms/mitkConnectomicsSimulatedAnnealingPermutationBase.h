@@ -58,6 +58,19 @@ namespace mitk
     // Do clean up necessary after a permutation
     virtual void CleanUp(){};
 
+    // Seed the random generator of the permutation
+    virtual void SetRandomSeed( unsigned int /*seed*/ ){};
+
+    // Create a permutation working on the same problem, to be run as another chain in parallel.
+    // Returns nullptr if the permutation does not support multiple chains
+    virtual Pointer CreateChain() const { return nullptr; };
+
+    // The cost of the current solution
+    virtual double GetCost() const { return 0; };
+
+    // Exchange the current solution with the one of another chain created by CreateChain()
+    virtual void SwapSolution( Self* /*otherChain*/ ){};
+
   protected:
 
     //////////////////// Functions ///////////////////////
@@ -19,10 +19,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkConnectomicsSimulatedAnnealingManager.h"
 
 //for random number generation
-#include "vnl/vnl_random.h"
 #include "vnl/vnl_math.h"
 
 mitk::ConnectomicsSimulatedAnnealingPermutationModularity::ConnectomicsSimulatedAnnealingPermutationModularity()
+: m_Depth( 0 )
+, m_StepSize( 0 )
+, m_RandomGenerator( (unsigned long) rand() )
 {
 }
 
@@ -39,12 +41,13 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SetNetwork(
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::Initialize()
 {
   // create entry for every vertex
-  std::vector< VertexDescriptorType > vertexVector = m_Network->GetVectorOfAllVertexDescriptors();
-  const int vectorSize = vertexVector.size();
+  m_Vertices = m_Network->GetVectorOfAllVertexDescriptors();
+  mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::BuildAdjacency( m_Network, &m_Adjacency );
+  const int vectorSize = m_Vertices.size();
 
   for( int index( 0 ); index < vectorSize; index++)
   {
-    m_BestSolution.insert( std::pair<VertexDescriptorType, int>( vertexVector[ index ], 0 ) );
+    m_BestSolution.insert( std::pair<VertexDescriptorType, int>( m_Vertices[ index ], 0 ) );
   }
 
   // initialize with random distribution of n modules
@@ -55,40 +58,80 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::Initialize()
 
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::Permutate( double temperature )
 {
+  const mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity* costFunction =
+    dynamic_cast<mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity*>( m_CostFunction.GetPointer() );
+  if( !costFunction )
+  {
+    MBI_ERROR << "Modularity permutation requires a modularity cost function.";
+    return;
+  }
+
+  typedef mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::ModuleStatisticsType ModuleStatisticsType;
+
+  // single node moves work on vectors of modules and update the cost incrementally
+  std::vector< int > currentSolution;
+  MappingToModuleVector( m_BestSolution, &currentSolution );
+  ModuleStatisticsType currentStatistics;
+  costFunction->InitializeModuleStatistics( m_Adjacency, currentSolution, &currentStatistics );
+  double currentCost = costFunction->Evaluate( m_Adjacency, currentStatistics );
 
-  ToModuleMapType currentSolution = m_BestSolution;
-  ToModuleMapType currentBestSolution = m_BestSolution;
+  std::vector< int > currentBestSolution = currentSolution;
+  ModuleStatisticsType currentBestStatistics = currentStatistics;
+  double currentBestCost = currentCost;
+
+  // moves of the current solution, that have not been accepted into the best solution yet
+  std::vector< std::pair< int, int > > pendingMoves;
 
   int factor = 1;
   int numberOfVertices = m_BestSolution.size();
   int singleNodeMaxNumber = factor * numberOfVertices * numberOfVertices;
   int moduleMaxNumber = factor  * numberOfVertices;
-  double currentBestCost = Evaluate( &currentBestSolution );
 
   // do singleNodeMaxNumber node permutations and evaluate
-  for(int loop( 0 ); loop < singleNodeMaxNumber; loop++)
+  for(int loop( 0 ); numberOfVertices > 1 && loop < singleNodeMaxNumber; loop++)
   {
-    permutateMappingSingleNodeShift( &currentSolution, m_Network );
-    if( AcceptChange( currentBestCost, Evaluate( &currentSolution ), temperature ) )
+    // move a random node to a random existing module
+    const int randomNode = m_RandomGenerator.lrand32( numberOfVertices - 1 );
+    const int randomModule = m_RandomGenerator.lrand32( currentStatistics.verticesInModule.size() - 1 );
+
+    if( currentSolution[ randomNode ] != randomModule )
     {
-      currentBestSolution = currentSolution;
-      currentBestCost = Evaluate( &currentBestSolution );
+      currentCost += costFunction->EvaluateSingleNodeMove( m_Adjacency, currentSolution, currentStatistics, randomNode, randomModule );
+      costFunction->MoveSingleNode( m_Adjacency, &currentSolution, &currentStatistics, randomNode, randomModule );
+      pendingMoves.push_back( std::pair< int, int >( randomNode, randomModule ) );
+    }
+
+    if( AcceptChange( currentBestCost, currentCost, temperature ) )
+    {
+      // replaying the moves yields the same module numbering as in the current solution
+      for( unsigned int move( 0 ); move < pendingMoves.size(); move++ )
+      {
+        costFunction->MoveSingleNode( m_Adjacency, &currentBestSolution, &currentBestStatistics, pendingMoves[ move ].first, pendingMoves[ move ].second );
+      }
+      pendingMoves.clear();
+      currentBestCost = currentCost;
     }
   }
 
   // do moduleMaxNumber module permutations
+  ToModuleMapType currentMapping;
+  ModuleVectorToMapping( currentSolution, &currentMapping );
+  ToModuleMapType currentBestMapping;
+  ModuleVectorToMapping( currentBestSolution, &currentBestMapping );
+
   for(int loop( 0 ); loop < moduleMaxNumber; loop++)
   {
-    permutateMappingModuleChange( &currentSolution, temperature, m_Network );
-    if( AcceptChange( currentBestCost, Evaluate( &currentSolution ), temperature ) )
+    permutateMappingModuleChange( &currentMapping, temperature, m_Network );
+    double cost = Evaluate( &currentMapping );
+    if( AcceptChange( currentBestCost, cost, temperature ) )
     {
-      currentBestSolution = currentSolution;
-      currentBestCost = Evaluate( &currentBestSolution );
+      currentBestMapping = currentMapping;
+      currentBestCost = cost;
     }
   }
 
   // store the best solution after the run
-  m_BestSolution = currentBestSolution;
+  m_BestSolution = currentBestMapping;
 }
 
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::CleanUp()
@@ -111,11 +154,10 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMapping
   const int moduleCount = getNumberOfModules( vertexToModuleMap );
 
   // the random number generators
-  vnl_random rng( (unsigned int) rand() );
-  unsigned long randomNode = rng.lrand32( nodeCount - 1 );
+  unsigned long randomNode = m_RandomGenerator.lrand32( nodeCount - 1 );
   // move the node either to any existing module, or to its own
-  //unsigned long randomModule = rng.lrand32( moduleCount );
-  unsigned long randomModule = rng.lrand32( moduleCount - 1 );
+  //unsigned long randomModule = m_RandomGenerator.lrand32( moduleCount );
+  unsigned long randomModule = m_RandomGenerator.lrand32( moduleCount - 1 );
 
   // do some sanity checks
 
@@ -148,11 +190,8 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMapping
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMappingModuleChange(
   ToModuleMapType *vertexToModuleMap, double currentTemperature, mitk::ConnectomicsNetwork::Pointer network )
 {
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
-
   //randomly generate threshold
-  const double threshold = rng.drand64( 0.0 , 1.0);
+  const double threshold = m_RandomGenerator.drand64( 0.0 , 1.0);
 
   //for deciding whether to join two modules or split one
   double splitThreshold = 0.5;
@@ -162,10 +201,10 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMapping
 
   //select random module
   int numberOfModules = getNumberOfModules( vertexToModuleMap );
-  unsigned long randomModuleA = rng.lrand32( numberOfModules - 1 );
+  unsigned long randomModuleA = m_RandomGenerator.lrand32( numberOfModules - 1 );
 
   //select the second module to join, if joining
-  unsigned long randomModuleB = rng.lrand32( numberOfModules - 1 );
+  unsigned long randomModuleB = m_RandomGenerator.lrand32( numberOfModules - 1 );
 
   if( ( threshold < splitThreshold ) && ( randomModuleA != randomModuleB )  )
   {
@@ -249,6 +288,7 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::splitModule(
     permutation->SetNetwork( subNetwork );
     permutation->SetDepth( m_Depth - 1 );
     permutation->SetStepSize( m_StepSize * 2 );
+    permutation->SetRandomSeed( m_RandomGenerator.lrand32() );
 
     manager->SetPermutation( permutation.GetPointer() );
 
@@ -433,9 +473,6 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::randomlyAssignNo
     numberOfIntendedModules = vertexToModuleMap->size();
   }
 
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
-
   std::vector< int > histogram;
   std::vector< int > nodeList;
 
@@ -448,7 +485,7 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::randomlyAssignNo
   for( unsigned int nodeIndex( 0 ); nodeIndex < nodeList.size(); nodeIndex++ )
   {
     //select random module
-    nodeList[ nodeIndex ] = rng.lrand32( numberOfIntendedModules - 1 );
+    nodeList[ nodeIndex ] = m_RandomGenerator.lrand32( numberOfIntendedModules - 1 );
 
     histogram[ nodeList[ nodeIndex ] ]++;
 
@@ -460,7 +497,7 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::randomlyAssignNo
   {
     while( histogram[ moduleIndex ] == 0 )
     {
-      int randomNodeIndex = rng.lrand32( numberOfVertices - 1 );
+      int randomNodeIndex = m_RandomGenerator.lrand32( numberOfVertices - 1 );
       if( histogram[ nodeList[ randomNodeIndex ] ] > 1 )
       {
         histogram[ moduleIndex ]++;
@@ -511,11 +548,8 @@ bool mitk::ConnectomicsSimulatedAnnealingPermutationModularity::AcceptChange( do
     return true;
   }
 
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
-
   //randomly generate threshold
-  const double threshold = rng.drand64( 0.0 , 1.0);
+  const double threshold = m_RandomGenerator.drand64( 0.0 , 1.0);
 
   //the likelihood of acceptance
   double likelihood = std::exp( - ( costAfter - costBefore ) / temperature );
@@ -538,3 +572,56 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SetStepSize( dou
 {
   m_StepSize = size;
 }
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SetRandomSeed( unsigned int seed )
+{
+  m_RandomGenerator.reseed( seed );
+}
+
+mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer
+mitk::ConnectomicsSimulatedAnnealingPermutationModularity::CreateChain() const
+{
+  mitk::ConnectomicsSimulatedAnnealingPermutationModularity::Pointer chain = mitk::ConnectomicsSimulatedAnnealingPermutationModularity::New();
+  chain->SetCostFunction( m_CostFunction );
+  chain->SetNetwork( m_Network );
+  chain->SetDepth( m_Depth );
+  chain->SetStepSize( m_StepSize );
+  return chain.GetPointer();
+}
+
+double mitk::ConnectomicsSimulatedAnnealingPermutationModularity::GetCost() const
+{
+  ToModuleMapType solution = m_BestSolution;
+  return Evaluate( &solution );
+}
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SwapSolution( ConnectomicsSimulatedAnnealingPermutationBase* otherChain )
+{
+  Self* other = dynamic_cast< Self* >( otherChain );
+  if( !other )
+  {
+    MBI_ERROR << "Can only swap solutions with another modularity permutation.";
+    return;
+  }
+  m_BestSolution.swap( other->m_BestSolution );
+}
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::MappingToModuleVector(
+  const ToModuleMapType &mapping, std::vector< int > *modules ) const
+{
+  modules->resize( m_Vertices.size() );
+  for( unsigned int index( 0 ); index < m_Vertices.size(); index++ )
+  {
+    (*modules)[ index ] = mapping.find( m_Vertices[ index ] )->second;
+  }
+}
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::ModuleVectorToMapping(
+  const std::vector< int > &modules, ToModuleMapType *mapping ) const
+{
+  mapping->clear();
+  for( unsigned int index( 0 ); index < m_Vertices.size(); index++ )
+  {
+    mapping->insert( std::pair<VertexDescriptorType, int>( m_Vertices[ index ], modules[ index ] ) );
+  }
+}
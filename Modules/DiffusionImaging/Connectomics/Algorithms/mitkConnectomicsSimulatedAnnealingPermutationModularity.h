@@ -20,6 +20,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkConnectomicsSimulatedAnnealingPermutationBase.h"
 
 #include "mitkConnectomicsNetwork.h"
+#include "mitkConnectomicsSimulatedAnnealingCostFunctionModularity.h"
+
+//for random number generation
+#include "vnl/vnl_random.h"
 
 namespace mitk
 {
@@ -49,6 +53,18 @@ namespace mitk
     // Do clean up necessary after a permutation
     virtual void CleanUp() override;
 
+    // Seed the random generator, by default it is seeded using rand()
+    virtual void SetRandomSeed( unsigned int seed ) override;
+
+    // Create a permutation on the same network with the same settings and cost function
+    virtual ConnectomicsSimulatedAnnealingPermutationBase::Pointer CreateChain() const override;
+
+    // The cost of the best solution
+    virtual double GetCost() const override;
+
+    // Exchange the best solution with the one of another modularity permutation
+    virtual void SwapSolution( ConnectomicsSimulatedAnnealingPermutationBase* otherChain ) override;
+
     // set the network permutation is to be run upon
     void SetNetwork( mitk::ConnectomicsNetwork::Pointer theNetwork );
 
@@ -122,6 +138,10 @@ namespace mitk
     // Whether to accept the permutation
     bool AcceptChange( double costBefore, double costAfter, double temperature ) const;
 
+    // Convert between the vertex to module map and a vector of modules indexed like m_Adjacency
+    void MappingToModuleVector( const ToModuleMapType &mapping, std::vector< int > *modules ) const;
+    void ModuleVectorToMapping( const std::vector< int > &modules, ToModuleMapType *mapping ) const;
+
     // the current best solution
     ToModuleMapType m_BestSolution;
 
@@ -133,6 +153,15 @@ namespace mitk
 
     // The step size for recursive configuring of simulated annealing manager
     double m_StepSize;
+
+    // The vertices of the network, in the order used by m_Adjacency
+    std::vector< VertexDescriptorType > m_Vertices;
+
+    // The adjacency of the network in compressed sparse row layout, for incremental evaluation of single node moves
+    mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity::AdjacencyType m_Adjacency;
+
+    // The random generator of this permutation, each chain has its own
+    mutable vnl_random m_RandomGenerator;
   };
 
 }// end namespace mitk
@@ -520,6 +520,64 @@ int mitkConnectomicsNetworkTest(int argc, char* argv[])
 
     bool noInternalThreeModuleModularity( std::abs(-0.3395 - costFunction->CalculateModularity( network, &noInternalLinksThreeModuleSolution )) < eps);
     MITK_TEST_CONDITION_REQUIRED( noInternalThreeModuleModularity, "Expected three module modularity containing no internal links")
+
+    // Test whether incremental evaluation of single node moves matches the full evaluation
+    typedef mitk::ConnectomicsSimulatedAnnealingCostFunctionModularity CostFunctionType;
+    CostFunctionType::AdjacencyType adjacency;
+    CostFunctionType::BuildAdjacency( network, &adjacency );
+
+    std::vector< int > modules;
+    for( unsigned int index( 0 ); index < vertexInVector.size(); index++ )
+    {
+      modules.push_back( badTwoModuleSolution.find( vertexInVector[ index ] )->second );
+    }
+    CostFunctionType::ModuleStatisticsType statistics;
+    costFunction->InitializeModuleStatistics( adjacency, modules, &statistics );
+
+    bool statisticsModularity( std::abs( costFunction->CalculateModularity( network, &badTwoModuleSolution )
+      - costFunction->CalculateModularity( adjacency, statistics ) ) < eps );
+    MITK_TEST_CONDITION_REQUIRED( statisticsModularity, "Expected modularity from module statistics")
+
+    double costBeforeMove = costFunction->Evaluate( adjacency, statistics );
+    double costChange = costFunction->EvaluateSingleNodeMove( adjacency, modules, statistics, 8, 1 );
+    costFunction->MoveSingleNode( adjacency, &modules, &statistics, 8, 1 );
+    badTwoModuleSolution.find( vertexInVector[ 8 ] )->second = 1;
+    bool incrementalCost( std::abs( costBeforeMove + costChange - costFunction->Evaluate( network, &badTwoModuleSolution ) ) < eps
+      && std::abs( costFunction->Evaluate( adjacency, statistics ) - costFunction->Evaluate( network, &badTwoModuleSolution ) ) < eps );
+    MITK_TEST_CONDITION_REQUIRED( incrementalCost, "Expected incremental cost of single node move")
+
+    // moving all vertices into one module removes the modules running empty
+    for( unsigned int index( 1 ); index < modules.size(); index++ )
+    {
+      costFunction->MoveSingleNode( adjacency, &modules, &statistics, index, modules[ 0 ] );
+    }
+    bool singleModuleLeft( statistics.verticesInModule.size() == 1 && modules[ 0 ] == 0 && modules[ 11 ] == 0
+      && std::abs( costFunction->CalculateModularity( adjacency, statistics ) ) < eps );
+    MITK_TEST_CONDITION_REQUIRED( singleModuleLeft, "Expected empty modules to be removed")
+
+    // Test whether parallel tempering is reproducible for a fixed seed
+    ToModuleMapType parallelTemperingSolutions[ 2 ];
+    for( int run( 0 ); run < 2; run++ )
+    {
+      mitk::ConnectomicsSimulatedAnnealingManager::Pointer temperingManager = mitk::ConnectomicsSimulatedAnnealingManager::New();
+      mitk::ConnectomicsSimulatedAnnealingPermutationModularity::Pointer temperingPermutation = mitk::ConnectomicsSimulatedAnnealingPermutationModularity::New();
+
+      temperingPermutation->SetCostFunction( costFunction.GetPointer() );
+      temperingPermutation->SetNetwork( network );
+      temperingPermutation->SetDepth( 1 );
+      temperingPermutation->SetStepSize( 4.0 );
+
+      temperingManager->SetPermutation( temperingPermutation.GetPointer() );
+      temperingManager->SetNumberOfChains( 3 );
+      temperingManager->SetRandomSeed( 42 );
+      temperingManager->RunSimulatedAnnealing( 2.0, 4.0 );
+
+      parallelTemperingSolutions[ run ] = temperingPermutation->GetMapping();
+    }
+    bool reproducibleTempering( parallelTemperingSolutions[ 0 ] == parallelTemperingSolutions[ 1 ]
+      && parallelTemperingSolutions[ 0 ].size() == vertexInVector.size()
+      && costFunction->CalculateModularity( network, &parallelTemperingSolutions[ 0 ] ) > 0 );
+    MITK_TEST_CONDITION_REQUIRED( reproducibleTempering, "Expected reproducible parallel tempering result")
   }
   catch (...)
   {
@@ -27,6 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <stdio.h>
 #include <locale>
 #include <fstream>
+#include <algorithm>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -34,6 +35,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/math/special_functions.hpp>
 
 #include "itkPointShell.h"
+#include "itkBatchedMatrixProduct.h"
 
 using namespace boost::math;
 
@@ -53,7 +55,8 @@ AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
     m_DirectionsDuplicated(false),
     m_Delta1(0.001),
     m_Delta2(0.001),
-    m_UseMrtrixBasis(false)
+    m_UseMrtrixBasis(false),
+    m_BatchSize(256)
 {
     // At least 1 inputs is necessary for a vector image.
     // For images added one at a time we need at least six
@@ -297,6 +300,74 @@ void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
         m_Lambda = 0.0;
 }
 
+template< class T, class TG, class TO, int L, int NODF>
+void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
+::NormalizeBatch( TO* odfs, const typename NumericTraits<ReferencePixelType>::AccumulateType* b0, unsigned int count, unsigned int stride )
+{
+    switch( m_NormalizationMethod )
+    {
+    case QBAR_STANDARD:
+    {
+        std::vector< TO > sum(count, 0);
+        for(int i=0; i<NODF; i++)
+        {
+            const TO* odf = odfs + i*stride;
+            for(unsigned int v=0; v<count; v++)
+                sum[v] += odf[v];
+        }
+        for(int i=0; i<NODF; i++)
+        {
+            TO* odf = odfs + i*stride;
+            for(unsigned int v=0; v<count; v++)
+                if(sum[v]>0)
+                    odf[v] /= sum[v];
+        }
+        break;
+    }
+    case QBAR_B_ZERO_B_VALUE:
+    case QBAR_ADC_ONLY:
+    {
+        std::vector< TO > logB0(count);
+        for(unsigned int v=0; v<count; v++)
+            logB0[v] = (TO)log((TO)b0[v]);
+        for(int i=0; i<NODF; i++)
+        {
+            TO* odf = odfs + i*stride;
+            for(unsigned int v=0; v<count; v++)
+                odf[v] = (logB0[v]-odf[v])/m_BValue;
+        }
+        break;
+    }
+    case QBAR_B_ZERO:
+    {
+        std::vector< TO > scale(count);
+        for(unsigned int v=0; v<count; v++)
+            scale[v] = 1.0/b0[v];
+        for(int i=0; i<NODF; i++)
+        {
+            TO* odf = odfs + i*stride;
+            for(unsigned int v=0; v<count; v++)
+                odf[v] *= scale[v];
+        }
+        break;
+    }
+    case QBAR_SOLID_ANGLE:
+    {
+        for(int i=0; i<NODF; i++)
+        {
+            TO* odf = odfs + i*stride;
+            for(unsigned int v=0; v<count; v++)
+                odf[v] *= QBALL_ANAL_RECON_PI*4/NODF;
+        }
+        break;
+    }
+    case QBAR_NONE:
+    case QBAR_RAW_SIGNAL:
+    case QBAR_NONNEG_SOLID_ANGLE:
+        break;
+    }
+}
+
 template< class T, class TG, class TO, int L, int NODF>
 void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
@@ -351,74 +422,115 @@ void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
             gradientind.push_back(gradientind[i]);
     }
 
-    while( !git.IsAtEnd() )
-    {
-        GradientVectorType b = git.Get();
+    typedef typename NumericTraits<ReferencePixelType>::AccumulateType B0Type;
 
-        typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
+    // The voxels are reconstructed in batches. The signals of the voxels above the threshold are
+    // gathered into one column each, so that the reconstruction matrices are applied to all of them at once.
+    const unsigned int batchSize = std::max(m_BatchSize, 1u);
+    std::vector< B0Type > b0s(batchSize);
+    std::vector< int > columns(batchSize);
+    std::vector< B0Type > columnB0s(batchSize);
+    std::vector< TO > signals(m_NumberOfGradientDirections*batchSize);
+    std::vector< TO > coeffs(m_NumberCoefficients*batchSize);
+    std::vector< TO > odfs(NODF*batchSize);
+    std::vector< float > sums(batchSize);
+    vnl_vector<TO> B(m_NumberOfGradientDirections);
 
-        // Average the baseline image pixels
-        for(unsigned int i = 0; i < baselineind.size(); ++i)
+    while( !git.IsAtEnd() )
+    {
+        unsigned int numVoxels = 0;
+        unsigned int numColumns = 0;
+        for( ; numVoxels<batchSize && !git.IsAtEnd(); ++numVoxels, ++git )
         {
-            b0 += b[baselineind[i]];
-        }
-        b0 /= this->m_NumberOfBaselineImages;
+            GradientVectorType b = git.Get();
 
-        OdfPixelType odf(0.0);
-        typename CoefficientImageType::PixelType coeffPixel(0.0);
-        vnl_vector<TO> B(m_NumberOfGradientDirections);
+            B0Type b0 = NumericTraits<ReferencePixelType>::Zero;
 
-        if( (b0 != 0) && (b0 >= m_Threshold) )
-        {
-            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+            // Average the baseline image pixels
+            for(unsigned int i = 0; i < baselineind.size(); ++i)
             {
-                B[i] = static_cast<TO>(b[gradientind[i]]);
+                b0 += b[baselineind[i]];
             }
+            b0 /= this->m_NumberOfBaselineImages;
 
-            B = PreNormalize(B, b0);
-            if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
+            b0s[numVoxels] = b0;
+            columns[numVoxels] = -1;
+
+            if( (b0 != 0) && (b0 >= m_Threshold) )
             {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                odf = ( (*m_SphericalHarmonicBasisMatrix) * coeffs ).data_block();
-                coeffPixel = coeffs.data_block();
+                if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE)
+                {
+                    /** this would be the place to implement a non-negative
+                  * solver for quadratic programming problem:
+                  * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
+                  * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
+                  * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
+                  */
+
+                    itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+                }
+
+                for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+                {
+                    B[i] = static_cast<TO>(b[gradientind[i]]);
+                }
+
+                B = PreNormalize(B, b0);
+                for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+                    signals[i*batchSize + numColumns] = B[i];
+
+                columnB0s[numColumns] = b0;
+                columns[numVoxels] = numColumns++;
             }
-            else if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE)
+        }
+
+        if( numColumns>0 )
+        {
+            BatchedMatrixProduct(*m_CoeffReconstructionMatrix, &signals[0], &coeffs[0], numColumns, batchSize);
+            for(unsigned int v=0; v<numColumns; v++)
+                coeffs[v] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
+
+            if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
+                BatchedMatrixProduct(*m_SphericalHarmonicBasisMatrix, &coeffs[0], &odfs[0], numColumns, batchSize);
+            else
+                BatchedMatrixProduct(*m_ReconstructionMatrix, &signals[0], &odfs[0], numColumns, batchSize);
+
+            NormalizeBatch(&odfs[0], &columnB0s[0], numColumns, batchSize);
+
+            std::fill(sums.begin(), sums.begin()+numColumns, 0.0f);
+            for(int i=0; i<NODF; i++)
             {
-                /** this would be the place to implement a non-negative
-              * solver for quadratic programming problem:
-              * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
-              * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
-              * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
-              */
-
-                itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+                const TO* odf = &odfs[i*batchSize];
+                for(unsigned int v=0; v<numColumns; v++)
+                    sums[v] += (float) odf[v];
             }
-            else
+        }
+
+        for(unsigned int v=0; v<numVoxels; v++)
+        {
+            OdfPixelType odf(0.0);
+            typename CoefficientImageType::PixelType coeffPixel(0.0);
+            float sum = 0;
+
+            const int c = columns[v];
+            if( c>=0 )
             {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                coeffPixel = coeffs.data_block();
-                odf = ( (*m_ReconstructionMatrix) * B ).data_block();
+                for(int i=0; i<NODF; i++)
+                    odf[i] = odfs[i*batchSize + c];
+                for(int i=0; i<m_NumberCoefficients; i++)
+                    coeffPixel[i] = coeffs[i*batchSize + c];
+                sum = sums[c];
             }
-            odf = Normalize(odf, b0);
 
+            oit.Set( odf );
+            oit2.Set( b0s[v] );
+            oit3.Set( sum-1 );
+            oit4.Set(coeffPixel);
+            ++oit;  // odf image iterator
+            ++oit3; // odf sum image iterator
+            ++oit2; // b0 image iterator
+            ++oit4; // coefficient image iterator
         }
-
-        oit.Set( odf );
-        oit2.Set( b0 );
-        float sum = 0;
-        for (unsigned int k=0; k<odf.Size(); k++)
-            sum += (float) odf[k];
-        oit3.Set( sum-1 );
-        oit4.Set(coeffPixel);
-        ++oit;  // odf image iterator
-        ++oit3; // odf sum image iterator
-        ++oit2; // b0 image iterator
-        ++oit4; // coefficient image iterator
-        ++git;  // Gradient  image iterator
     }
 
     std::cout << "One Thread finished reconstruction" << std::endl;
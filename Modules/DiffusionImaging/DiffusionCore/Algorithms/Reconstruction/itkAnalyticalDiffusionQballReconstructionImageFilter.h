@@ -192,6 +192,8 @@ public:
 
     OdfPixelType Normalize(OdfPixelType odf, typename NumericTraits<ReferencePixelType>::AccumulateType b0 );
     vnl_vector<TOdfPixelType> PreNormalize( vnl_vector<TOdfPixelType> vec, typename NumericTraits<ReferencePixelType>::AccumulateType b0  );
+    /** Same as Normalize() for a batch of ODFs that are stored direction by direction (odfs[direction*stride + voxel]). */
+    void NormalizeBatch( TOdfPixelType* odfs, const typename NumericTraits<ReferencePixelType>::AccumulateType* b0, unsigned int count, unsigned int stride );
 
     /** Threshold on the reference image data. The output ODF will be a null
    * pdf for pixels in the reference image that have a value less than this
@@ -217,6 +219,10 @@ public:
 
     itkSetMacro( UseMrtrixBasis, bool )
 
+    /** Number of voxels that are reconstructed together by one thread. */
+    itkSetMacro( BatchSize, unsigned int )
+    itkGetMacro( BatchSize, unsigned int )
+
 #ifdef ITK_USE_CONCEPT_CHECKING
     /** Begin concept checking */
     itkConceptMacro(ReferenceEqualityComparableCheck,
@@ -274,6 +280,7 @@ private:
     TOdfPixelType                                     m_Delta1;
     TOdfPixelType                                     m_Delta2;
     bool                                              m_UseMrtrixBasis;
+    unsigned int                                      m_BatchSize;
 };
 
 }
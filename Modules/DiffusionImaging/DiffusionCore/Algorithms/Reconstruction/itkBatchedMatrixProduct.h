@@ -0,0 +1,84 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkBatchedMatrixProduct_h__
+#define __itkBatchedMatrixProduct_h__
+
+#include <vnl/vnl_matrix.h>
+
+namespace itk
+{
+
+/**
+  * \brief Applies a matrix to a batch of voxel vectors: out = matrix * in.
+  *
+  * The vectors are stored element-major, i.e. element i of vector v is found at in[i*stride + v]
+  * and written to out[i*stride + v], for v < count. The innermost loop runs over the voxels of the
+  * batch and is contiguous, so the compiler vectorizes it; four output rows are computed per pass
+  * over the input.
+  * Each output element is summed in the same order as vnl's matrix-vector product.
+  */
+template< class TMatrixValue, class TValue >
+void BatchedMatrixProduct(const vnl_matrix< TMatrixValue >& matrix, const TValue* in, TValue* out, unsigned int count, unsigned int stride)
+{
+  const unsigned int rows = matrix.rows();
+  const unsigned int cols = matrix.cols();
+
+  unsigned int r = 0;
+  for (; r+4<=rows; r+=4)
+  {
+    TValue* out0 = out + r*stride;
+    TValue* out1 = out0 + stride;
+    TValue* out2 = out1 + stride;
+    TValue* out3 = out2 + stride;
+    for (unsigned int v=0; v<count; v++)
+      out0[v] = out1[v] = out2[v] = out3[v] = 0;
+
+    for (unsigned int c=0; c<cols; c++)
+    {
+      const TValue a0 = matrix(r, c);
+      const TValue a1 = matrix(r+1, c);
+      const TValue a2 = matrix(r+2, c);
+      const TValue a3 = matrix(r+3, c);
+      const TValue* x = in + c*stride;
+      for (unsigned int v=0; v<count; v++)
+      {
+        out0[v] += a0*x[v];
+        out1[v] += a1*x[v];
+        out2[v] += a2*x[v];
+        out3[v] += a3*x[v];
+      }
+    }
+  }
+  for (; r<rows; r++)
+  {
+    TValue* out0 = out + r*stride;
+    for (unsigned int v=0; v<count; v++)
+      out0[v] = 0;
+
+    for (unsigned int c=0; c<cols; c++)
+    {
+      const TValue a0 = matrix(r, c);
+      const TValue* x = in + c*stride;
+      for (unsigned int v=0; v<count; v++)
+        out0[v] += a0*x[v];
+    }
+  }
+}
+
+}
+
+#endif //__itkBatchedMatrixProduct_h__
@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkTimeProbe.h>
 #include <itkPointShell.h>
 #include <mitkDiffusionFunctionCollection.h>
+#include <itkBatchedMatrixProduct.h>
+
+#include <algorithm>
 
 namespace itk {
 
@@ -47,7 +50,8 @@ DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
   m_BValue(1.0),
   m_Lambda(0.0),
   m_IsHemisphericalArrangementOfGradientDirections(false),
-  m_IsArithmeticProgession(false)
+  m_IsArithmeticProgession(false),
+  m_BatchSize(256)
 {
   // At least 1 inputs is necessary for a vector image.
   // For images added one at a time we need at least six
@@ -601,6 +605,22 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
   MITK_INFO << "Reconstruction in : " << clock.GetTotal() << " s";
 }
 
+template< class T, class TG, class TO, int L, int NODF>
+void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
+::ReconstructBatch(const double* signals, double* coeffs, double* odfs, unsigned int count, unsigned int stride)
+{
+  if( count==0 )
+    return;
+
+  // approximate ODF coeffs
+  BatchedMatrixProduct(*m_CoeffReconstructionMatrix, signals, coeffs, count, stride);
+
+  // the first coeff is a fix value
+  std::fill(coeffs, coeffs+count, 1.0/(2.0*sqrt(M_PI)));
+
+  BatchedMatrixProduct(*m_ODFSphericalHarmonicBasisMatrix, coeffs, odfs, count, stride);
+}
+
 
 template< class T, class TG, class TO, int L, int NODF>
 void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
@@ -633,52 +653,72 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
 
   typedef typename GradientImagesType::PixelType         GradientVectorType;
 
+  // the voxels are reconstructed in batches, one column of the signal matrix per voxel above the threshold
+  const unsigned int batchSize = std::max(m_BatchSize, 1u);
+  std::vector<int> columns(batchSize);
+  std::vector<double> signals(NumbersOfGradientIndicies*batchSize);
+  std::vector<double> coeffs(m_CoeffReconstructionMatrix->rows()*batchSize);
+  std::vector<double> odfs(NODF*batchSize);
+  vnl_vector<double> SignalVector(NumbersOfGradientIndicies);
+
   // iterate overall voxels of the gradient image region
   while( ! git.IsAtEnd() )
   {
-    GradientVectorType b = git.Get();
-    // ODF Vector
-    OdfPixelType odf(0.0);
-
-    double b0average = 0;
-    const unsigned int b0size = BZeroIndicies.size();
-    for(unsigned int i = 0; i < b0size ; ++i)
-    {
-      b0average += b[BZeroIndicies[i]];
-    }
-    b0average /= b0size;
-    bzeroIterator.Set(b0average);
-    ++bzeroIterator;
-
-    // Create the Signal Vector
-    vnl_vector<double> SignalVector(NumbersOfGradientIndicies);
-    if( (b0average != 0) && (b0average >= m_Threshold) )
+    unsigned int numVoxels = 0;
+    unsigned int numColumns = 0;
+    for( ; numVoxels<batchSize && !git.IsAtEnd(); ++numVoxels, ++git )
     {
+      GradientVectorType b = git.Get();
 
-      for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+      double b0average = 0;
+      const unsigned int b0size = BZeroIndicies.size();
+      for(unsigned int i = 0; i < b0size ; ++i)
       {
-        SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        b0average += b[BZeroIndicies[i]];
       }
+      b0average /= b0size;
+      bzeroIterator.Set(b0average);
+      ++bzeroIterator;
 
-      // apply threashold an generate ln(-ln(E)) signal
-      // Replace SignalVector with PreNormalized SignalVector
-      S_S0Normalization(SignalVector, b0average);
-      Projection1(SignalVector);
+      columns[numVoxels] = -1;
+      if( (b0average != 0) && (b0average >= m_Threshold) )
+      {
+        // Create the Signal Vector
+        for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+        {
+          SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        }
 
-      DoubleLogarithm(SignalVector);
+        // apply threashold an generate ln(-ln(E)) signal
+        // Replace SignalVector with PreNormalized SignalVector
+        S_S0Normalization(SignalVector, b0average);
+        Projection1(SignalVector);
 
-      // approximate ODF coeffs
-      vnl_vector<double>  coeffs = ( (*m_CoeffReconstructionMatrix) * SignalVector );
-      coeffs[0] = 1.0/(2.0*sqrt(M_PI));
+        DoubleLogarithm(SignalVector);
 
-      odf = element_cast<double, TO>(( (*m_ODFSphericalHarmonicBasisMatrix) * coeffs )).data_block();
-      odf *= (M_PI*4/NODF);
+        for( unsigned int i = 0; i< NumbersOfGradientIndicies; i++ )
+          signals[i*batchSize + numColumns] = SignalVector[i];
+        columns[numVoxels] = numColumns++;
+      }
     }
-    // set ODF to ODF-Image
-    oit.Set( odf );
-    ++oit;
-    ++git;
 
+    ReconstructBatch(&signals[0], &coeffs[0], &odfs[0], numColumns, batchSize);
+
+    for(unsigned int v=0; v<numVoxels; v++)
+    {
+      // ODF Vector
+      OdfPixelType odf(0.0);
+      const int c = columns[v];
+      if( c>=0 )
+      {
+        for(int i=0; i<NODF; i++)
+          odf[i] = static_cast<TO>(odfs[i*batchSize + c]);
+        odf *= (M_PI*4/NODF);
+      }
+      // set ODF to ODF-Image
+      oit.Set( odf );
+      ++oit;
+    }
   }
 
   MITK_INFO << "One Thread finished reconstruction";
@@ -774,179 +814,197 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
     tempInterpolationMatrixShell3 = (*m_TARGET_SH_shell3) * (*m_Interpolation_SHT3_inv);
   }
 
-  OdfPixelType odf(0.0);
-  typename CoefficientImageType::PixelType coeffPixel(0.0);
-
   double P2,A,B2,B,P,alpha,beta,lambda, ER1, ER2;
 
-
+  // the voxels are reconstructed in batches, one column of the signal matrix per voxel above the threshold
+  const unsigned int batchSize = std::max(m_BatchSize, 1u);
+  const unsigned int numberOfCoefficients = m_CoeffReconstructionMatrix->rows();
+  std::vector<int> columns(batchSize);
+  std::vector<double> signals(m_MaxDirections*batchSize);
+  std::vector<double> coeffs(numberOfCoefficients*batchSize);
+  std::vector<double> odfs(NODF*batchSize);
 
   // iterate overall voxels of the gradient image region
   while( ! gradientInputImageIterator.IsAtEnd() )
   {
+    unsigned int numVoxels = 0;
+    unsigned int numColumns = 0;
+    for( ; numVoxels<batchSize && !gradientInputImageIterator.IsAtEnd(); ++numVoxels, ++gradientInputImageIterator )
+    {
+      columns[numVoxels] = -1;
 
-    odf = 0.0;
-    coeffPixel = 0.0;
-
-    GradientVectorType b = gradientInputImageIterator.Get();
+      GradientVectorType b = gradientInputImageIterator.Get();
 
-    // calculate for each shell the corresponding b0-averages
-    double shell1b0Norm =0;
-    double shell2b0Norm =0;
-    double shell3b0Norm =0;
-    double b0average = 0;
-    const unsigned int b0size = BZeroIndicies.size();
+      // calculate for each shell the corresponding b0-averages
+      double shell1b0Norm =0;
+      double shell2b0Norm =0;
+      double shell3b0Norm =0;
+      double b0average = 0;
+      const unsigned int b0size = BZeroIndicies.size();
 
-    if(b0size == 1)
-    {
-      shell1b0Norm = b[BZeroIndicies[0]];
-      shell2b0Norm = b[BZeroIndicies[0]];
-      shell3b0Norm = b[BZeroIndicies[0]];
-      b0average = b[BZeroIndicies[0]];
-    }else if(b0size % 3 ==0)
-    {
-      for(unsigned int i = 0; i < b0size ; ++i)
+      if(b0size == 1)
       {
-        if(i < b0size / 3)                          shell1b0Norm += b[BZeroIndicies[i]];
-        if(i >= b0size / 3 && i < (b0size / 3)*2)   shell2b0Norm += b[BZeroIndicies[i]];
-        if(i >= (b0size / 3) * 2)                   shell3b0Norm += b[BZeroIndicies[i]];
-      }
-      shell1b0Norm /= (b0size/3);
-      shell2b0Norm /= (b0size/3);
-      shell3b0Norm /= (b0size/3);
-      b0average = (shell1b0Norm + shell2b0Norm+ shell3b0Norm)/3;
-    }else
-    {
-      for(unsigned int i = 0; i <b0size ; ++i)
+        shell1b0Norm = b[BZeroIndicies[0]];
+        shell2b0Norm = b[BZeroIndicies[0]];
+        shell3b0Norm = b[BZeroIndicies[0]];
+        b0average = b[BZeroIndicies[0]];
+      }else if(b0size % 3 ==0)
+      {
+        for(unsigned int i = 0; i < b0size ; ++i)
+        {
+          if(i < b0size / 3)                          shell1b0Norm += b[BZeroIndicies[i]];
+          if(i >= b0size / 3 && i < (b0size / 3)*2)   shell2b0Norm += b[BZeroIndicies[i]];
+          if(i >= (b0size / 3) * 2)                   shell3b0Norm += b[BZeroIndicies[i]];
+        }
+        shell1b0Norm /= (b0size/3);
+        shell2b0Norm /= (b0size/3);
+        shell3b0Norm /= (b0size/3);
+        b0average = (shell1b0Norm + shell2b0Norm+ shell3b0Norm)/3;
+      }else
       {
-        shell1b0Norm += b[BZeroIndicies[i]];
+        for(unsigned int i = 0; i <b0size ; ++i)
+        {
+          shell1b0Norm += b[BZeroIndicies[i]];
+        }
+        shell1b0Norm /= b0size;
+        shell2b0Norm = shell1b0Norm;
+        shell3b0Norm = shell1b0Norm;
+        b0average = shell1b0Norm;
       }
-      shell1b0Norm /= b0size;
-      shell2b0Norm = shell1b0Norm;
-      shell3b0Norm = shell1b0Norm;
-      b0average = shell1b0Norm;
-    }
 
-    bzeroIterator.Set(b0average);
-    ++bzeroIterator;
+      bzeroIterator.Set(b0average);
+      ++bzeroIterator;
 
-    if( (b0average != 0) && ( b0average >= m_Threshold) )
-    {
-      // Get the Signal-Value for each Shell at each direction (specified in the ShellIndicies Vector .. this direction corresponse to this shell...)
+      if( (b0average != 0) && ( b0average >= m_Threshold) )
+      {
+        // Get the Signal-Value for each Shell at each direction (specified in the ShellIndicies Vector .. this direction corresponse to this shell...)
 
-      /*//fsl fix ---------------------------------------------------
-      for(int i = 0 ; i < Shell1Indiecies.size(); i++)
-        DataShell1[i] = static_cast<double>(b[Shell1Indiecies[i]]);
-      for(int i = 0 ; i < Shell2Indiecies.size(); i++)
-        DataShell2[i] = static_cast<double>(b[Shell2Indiecies[i]]);
-      for(int i = 0 ; i < Shell3Indiecies.size(); i++)
-        DataShell3[i] = static_cast<double>(b[Shell2Indiecies[i]]);
+        /*//fsl fix ---------------------------------------------------
+        for(int i = 0 ; i < Shell1Indiecies.size(); i++)
+          DataShell1[i] = static_cast<double>(b[Shell1Indiecies[i]]);
+        for(int i = 0 ; i < Shell2Indiecies.size(); i++)
+          DataShell2[i] = static_cast<double>(b[Shell2Indiecies[i]]);
+        for(int i = 0 ; i < Shell3Indiecies.size(); i++)
+          DataShell3[i] = static_cast<double>(b[Shell2Indiecies[i]]);
 
-      // Normalize the Signal: Si/S0
-      S_S0Normalization(DataShell1, shell1b0Norm);
-      S_S0Normalization(DataShell2, shell2b0Norm);
-      S_S0Normalization(DataShell3, shell2b0Norm);
-      *///fsl fix -------------------------------------------ende--
+        // Normalize the Signal: Si/S0
+        S_S0Normalization(DataShell1, shell1b0Norm);
+        S_S0Normalization(DataShell2, shell2b0Norm);
+        S_S0Normalization(DataShell3, shell2b0Norm);
+        *///fsl fix -------------------------------------------ende--
 
-      ///correct version
-      for(unsigned int i = 0 ; i < Shell1Indiecies.size(); i++)
-        DataShell1[i] = static_cast<double>(b[Shell1Indiecies[i]]);
-      for(unsigned int i = 0 ; i < Shell2Indiecies.size(); i++)
-        DataShell2[i] = static_cast<double>(b[Shell2Indiecies[i]]);
-      for(unsigned int i = 0 ; i < Shell3Indiecies.size(); i++)
-        DataShell3[i] = static_cast<double>(b[Shell3Indiecies[i]]);
+        ///correct version
+        for(unsigned int i = 0 ; i < Shell1Indiecies.size(); i++)
+          DataShell1[i] = static_cast<double>(b[Shell1Indiecies[i]]);
+        for(unsigned int i = 0 ; i < Shell2Indiecies.size(); i++)
+          DataShell2[i] = static_cast<double>(b[Shell2Indiecies[i]]);
+        for(unsigned int i = 0 ; i < Shell3Indiecies.size(); i++)
+          DataShell3[i] = static_cast<double>(b[Shell3Indiecies[i]]);
 
 
 
-      // Normalize the Signal: Si/S0
-      S_S0Normalization(DataShell1, shell1b0Norm);
-      S_S0Normalization(DataShell2, shell2b0Norm);
-      S_S0Normalization(DataShell3, shell3b0Norm);
+        // Normalize the Signal: Si/S0
+        S_S0Normalization(DataShell1, shell1b0Norm);
+        S_S0Normalization(DataShell2, shell2b0Norm);
+        S_S0Normalization(DataShell3, shell3b0Norm);
 
 
-      if(m_Interpolation_Flag)
-      {
-        E1 = tempInterpolationMatrixShell1 * DataShell1;
-        E2 = tempInterpolationMatrixShell2 * DataShell2;
-        E3 = tempInterpolationMatrixShell3 * DataShell3;
-      }else{
-        E1 = (DataShell1);
-        E2 = (DataShell2);
-        E3 = (DataShell3);
-      }
+        if(m_Interpolation_Flag)
+        {
+          E1 = tempInterpolationMatrixShell1 * DataShell1;
+          E2 = tempInterpolationMatrixShell2 * DataShell2;
+          E3 = tempInterpolationMatrixShell3 * DataShell3;
+        }else{
+          E1 = (DataShell1);
+          E2 = (DataShell2);
+          E3 = (DataShell3);
+        }
 
-      //Implements Eq. [19] and Fig. 4.
-      Projection1(E1);
-      Projection1(E2);
-      Projection1(E3);
-      //inqualities [31]. Taking the lograithm of th first tree inqualities
-      //convert the quadratic inqualities to linear ones.
-      Projection2(E1,E2,E3);
+        //Implements Eq. [19] and Fig. 4.
+        Projection1(E1);
+        Projection1(E2);
+        Projection1(E3);
+        //inqualities [31]. Taking the lograithm of th first tree inqualities
+        //convert the quadratic inqualities to linear ones.
+        Projection2(E1,E2,E3);
 
-      for( unsigned int i = 0; i< m_MaxDirections; i++ )
-      {
-        double e1 = E1.get(i);
-        double e2 = E2.get(i);
-        double e3 = E3.get(i);
+        for( unsigned int i = 0; i< m_MaxDirections; i++ )
+        {
+          double e1 = E1.get(i);
+          double e2 = E2.get(i);
+          double e3 = E3.get(i);
 
-        P2 = e2-e1*e1;
-        A = (e3 -e1*e2) / ( 2* P2);
-        B2 = A * A -(e1 * e3 - e2 * e2) /P2;
-        B = 0;
-        if(B2 > 0) B = sqrt(B2);
-        P = 0;
-        if(P2 > 0) P = sqrt(P2);
+          P2 = e2-e1*e1;
+          A = (e3 -e1*e2) / ( 2* P2);
+          B2 = A * A -(e1 * e3 - e2 * e2) /P2;
+          B = 0;
+          if(B2 > 0) B = sqrt(B2);
+          P = 0;
+          if(P2 > 0) P = sqrt(P2);
 
-        alpha = A + B;
-        beta = A - B;
+          alpha = A + B;
+          beta = A - B;
 
-        PValues.put(i, P);
-        AlphaValues.put(i, alpha);
-        BetaValues.put(i, beta);
+          PValues.put(i, P);
+          AlphaValues.put(i, alpha);
+          BetaValues.put(i, beta);
 
-      }
+        }
 
-      Projection3(PValues, AlphaValues, BetaValues);
+        Projection3(PValues, AlphaValues, BetaValues);
 
-      for(unsigned int i = 0 ; i < m_MaxDirections; i++)
-      {
-        const double fac = (PValues[i] * 2 ) / (AlphaValues[i] - BetaValues[i]);
-        lambda = 0.5 + 0.5 * std::sqrt(1 - fac * fac);;
-        ER1 = std::fabs(lambda * (AlphaValues[i] - BetaValues[i]) + (BetaValues[i] - E1.get(i) ))
-            + std::fabs(lambda * (AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] - E2.get(i) ))
-            + std::fabs(lambda * (AlphaValues[i] * AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] * BetaValues[i] - E3.get(i) ));
-        ER2 = std::fabs((1-lambda) * (AlphaValues[i] - BetaValues[i]) + (BetaValues[i] - E1.get(i) ))
-            + std::fabs((1-lambda) * (AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] - E2.get(i) ))
-            + std::fabs((1-lambda) * (AlphaValues[i] * AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] * BetaValues[i] - E3.get(i)));
-        if(ER1 < ER2)
-          LAValues.put(i, lambda);
-        else
-          LAValues.put(i, 1-lambda);
+        for(unsigned int i = 0 ; i < m_MaxDirections; i++)
+        {
+          const double fac = (PValues[i] * 2 ) / (AlphaValues[i] - BetaValues[i]);
+          lambda = 0.5 + 0.5 * std::sqrt(1 - fac * fac);;
+          ER1 = std::fabs(lambda * (AlphaValues[i] - BetaValues[i]) + (BetaValues[i] - E1.get(i) ))
+              + std::fabs(lambda * (AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] - E2.get(i) ))
+              + std::fabs(lambda * (AlphaValues[i] * AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] * BetaValues[i] - E3.get(i) ));
+          ER2 = std::fabs((1-lambda) * (AlphaValues[i] - BetaValues[i]) + (BetaValues[i] - E1.get(i) ))
+              + std::fabs((1-lambda) * (AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] - E2.get(i) ))
+              + std::fabs((1-lambda) * (AlphaValues[i] * AlphaValues[i] * AlphaValues[i] - BetaValues[i] * BetaValues[i] * BetaValues[i]) + (BetaValues[i] * BetaValues[i] * BetaValues[i] - E3.get(i)));
+          if(ER1 < ER2)
+            LAValues.put(i, lambda);
+          else
+            LAValues.put(i, 1-lambda);
 
-      }
+        }
 
-      DoubleLogarithm(AlphaValues);
-      DoubleLogarithm(BetaValues);
+        DoubleLogarithm(AlphaValues);
+        DoubleLogarithm(BetaValues);
 
-      vnl_vector<double> SignalVector(element_product((LAValues) , (AlphaValues)-(BetaValues)) + (BetaValues));
+        vnl_vector<double> SignalVector(element_product((LAValues) , (AlphaValues)-(BetaValues)) + (BetaValues));
 
-      vnl_vector<double> coeffs((*m_CoeffReconstructionMatrix) *SignalVector );
+        for( unsigned int i = 0; i< m_MaxDirections; i++ )
+          signals[i*batchSize + numColumns] = SignalVector[i];
+        columns[numVoxels] = numColumns++;
+      }
+    }
 
-      // the first coeff is a fix value
-      coeffs[0] = 1.0/(2.0*sqrt(M_PI));
-      coeffPixel = element_cast<double, TO>(coeffs).data_block();
+    ReconstructBatch(&signals[0], &coeffs[0], &odfs[0], numColumns, batchSize);
 
-      // Cast the Signal-Type from double to float for the ODF-Image
-      odf = element_cast<double, TO>( (*m_ODFSphericalHarmonicBasisMatrix) * coeffs ).data_block();
-      odf *= ((M_PI*4)/NODF);
-    }
+    for(unsigned int v=0; v<numVoxels; v++)
+    {
+      OdfPixelType odf(0.0);
+      typename CoefficientImageType::PixelType coeffPixel(0.0);
+      const int c = columns[v];
+      if( c>=0 )
+      {
+        for(unsigned int i=0; i<numberOfCoefficients; i++)
+          coeffPixel[i] = static_cast<TO>(coeffs[i*batchSize + c]);
 
-    // set ODF to ODF-Image
-    coefficientImageIterator.Set(coeffPixel);
-    odfOutputImageIterator.Set( odf );
-    ++odfOutputImageIterator;
-    ++coefficientImageIterator;
-    ++gradientInputImageIterator;
+        // Cast the Signal-Type from double to float for the ODF-Image
+        for(int i=0; i<NODF; i++)
+          odf[i] = static_cast<TO>(odfs[i*batchSize + c]);
+        odf *= ((M_PI*4)/NODF);
+      }
+
+      // set ODF to ODF-Image
+      coefficientImageIterator.Set(coeffPixel);
+      odfOutputImageIterator.Set( odf );
+      ++odfOutputImageIterator;
+      ++coefficientImageIterator;
+    }
   }
 
 }
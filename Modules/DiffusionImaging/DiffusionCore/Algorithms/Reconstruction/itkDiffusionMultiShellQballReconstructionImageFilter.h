@@ -107,6 +107,10 @@ public:
     itkSetMacro( Lambda, double )
     itkGetMacro( Lambda, double )
 
+    /** Number of voxels that are reconstructed together by one thread */
+    itkSetMacro( BatchSize, unsigned int )
+    itkGetMacro( BatchSize, unsigned int )
+
 protected:
     DiffusionMultiShellQballReconstructionImageFilter();
     ~DiffusionMultiShellQballReconstructionImageFilter() { }
@@ -165,6 +169,8 @@ private:
 
     bool m_IsArithmeticProgession;
 
+    unsigned int m_BatchSize;
+
     void ComputeReconstructionMatrix(IndiciesVector const & refVector);
     void ComputeODFSHBasis();
     bool CheckDuplicateDiffusionGradients();
@@ -178,6 +184,8 @@ private:
     void Projection1(vnl_vector<double> & vec, double delta = 0.01);
     void Projection2( vnl_vector<double> & E1, vnl_vector<double> & E2, vnl_vector<double> & E3, double delta = 0.01);
     void Projection3( vnl_vector<double> & A, vnl_vector<double> & alpha, vnl_vector<double> & beta, double delta = 0.01);
+    /** Computes the SH coefficients and the ODFs of a batch of signals that are stored element by element (signals[i*stride + voxel]) */
+    void ReconstructBatch(const double* signals, double* coeffs, double* odfs, unsigned int count, unsigned int stride);
     void StandardOneShellReconstruction(const OutputImageRegionType& outputRegionForThread);
     void AnalyticalThreeShellReconstruction(const OutputImageRegionType& outputRegionForThread);
     void NumericalNShellReconstruction(const OutputImageRegionType& outputRegionForThread);
@@ -27,6 +27,12 @@ namespace itk{
    *
    * This Filter needs as an input a diffusion weigthed image, which will be denoised unsing the non-local means principle.
    * An input mask is optional to denoise only inside the mask range. All other voxels will be set to 0.
+   *
+   * The patch distances are not computed voxel by voxel. The image is processed slice by slice. For every
+   * offset of the search window the squared differences between the image and the shifted image are summed
+   * directly over the 2 * comparisonradius + 1 slices along z, and then with running box sums along x and y,
+   * which yields the patch distances of a whole band of voxels at once. The cost per voxel and offset is
+   * therefore linear instead of cubic in the comparison radius.
   */
 
   template< class TPixelType >
@@ -124,6 +130,8 @@ namespace itk{
      */
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType);
 
+    /** @brief Number of voxel pairs along one axis that are compared for the given position and search offset. */
+    int GetOverlapCount(int position, int offset, int size) const;
 
 
   private:
@@ -25,8 +25,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <math.h>
 
 #include "itkImageRegionIterator.h"
-#include "itkNeighborhoodIterator.h"
-#include <itkImageRegionIteratorWithIndex.h>
+#include "itkImageRegionConstIterator.h"
+#include <algorithm>
 #include <vector>
 
 namespace itk {
@@ -122,251 +122,285 @@ NonLocalMeansDenoisingFilter< TPixelType >
   m_CurrentVoxelCount = 0;
 }
 
+template< class TPixelType >
+int
+NonLocalMeansDenoisingFilter< TPixelType >
+::GetOverlapCount(int position, int offset, int size) const
+{
+  // number of patch positions t in [-r, r] with position+t and position+offset+t inside [0, size)
+  int lower = std::max(-m_ComparisonRadius, std::max(-position, -position - offset));
+  int upper = std::min(m_ComparisonRadius, std::min(size - 1 - position, size - 1 - position - offset));
+  return upper >= lower ? upper - lower + 1 : 0;
+}
+
 template< class TPixelType >
 void
 NonLocalMeansDenoisingFilter< TPixelType >
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType )
 {
-
-
-  // initialize iterators
   typename OutputImageType::Pointer outputImage =
           static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
 
-  ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
-  oit.GoToBegin();
-
-  ImageRegionIterator< MaskImageType > mit(m_Mask, outputRegionForThread);
-  mit.GoToBegin();
-
-
-
-  typedef ImageRegionIteratorWithIndex <InputImageType> InputIteratorType;
   typename InputImageType::Pointer inputImagePointer = NULL;
   inputImagePointer = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
 
-  InputIteratorType git(inputImagePointer, outputRegionForThread );
-  git.GoToBegin();
-
-  // iterate over complete image region
-  while( !git.IsAtEnd() )
+  // all coordinates below are relative to the start of the largest possible region
+  const typename InputImageType::RegionType& largestRegion = inputImagePointer->GetLargestPossibleRegion();
+  const int imageSize[3] = { (int)largestRegion.GetSize(0), (int)largestRegion.GetSize(1), (int)largestRegion.GetSize(2) };
+  const int numChannels = inputImagePointer->GetVectorLength();
+  const int numWeights = m_UseJointInformation ? 1 : numChannels;
+  const int cr = m_ComparisonRadius;
+  const int sr = m_SearchRadius;
+
+  // the channels of a voxel are contiguous in the buffer of a vector image
+  const TPixelType* buffer = inputImagePointer->GetBufferPointer() + inputImagePointer->ComputeOffset(largestRegion.GetIndex()) * numChannels;
+  const long strides[3] = { numChannels, (long)imageSize[0] * numChannels, (long)imageSize[0] * imageSize[1] * numChannels };
+
+  const int regionStart[3] = { (int)(outputRegionForThread.GetIndex(0) - largestRegion.GetIndex(0)),
+                               (int)(outputRegionForThread.GetIndex(1) - largestRegion.GetIndex(1)),
+                               (int)(outputRegionForThread.GetIndex(2) - largestRegion.GetIndex(2)) };
+  const int regionSize[3] = { (int)outputRegionForThread.GetSize(0), (int)outputRegionForThread.GetSize(1), (int)outputRegionForThread.GetSize(2) };
+
+  // the region is processed in bands of rows to keep the per-thread buffers small
+  const int bandHeight = std::min(regionSize[1], 16);
+  const int width = regionSize[0];
+  const int paddedWidth = width + 2 * cr;
+  const int paddedHeight = bandHeight + 2 * cr;
+
+  std::vector<double> planeSums(paddedWidth * paddedHeight * numWeights);   // patch sums along z
+  std::vector<double> rowSums(width * paddedHeight * numWeights);           // ... and along x
+  std::vector<double> patchDistances(width * bandHeight * numWeights);      // ... and along y
+  std::vector<double> weightedValues(width * bandHeight * numChannels);
+  std::vector<double> weightSums(width * bandHeight * numWeights);
+  std::vector<char> inMask(width * bandHeight);
+
+  for (int z = regionStart[2]; z < regionStart[2] + regionSize[2]; ++z)
   {
-    typename OutputImageType::PixelType outpix;
-    outpix.SetSize (inputImagePointer->GetVectorLength());
-
-    if (mit.Get() != 0 && !this->GetAbortGenerateData())
+    for (int y0 = regionStart[1]; y0 < regionStart[1] + regionSize[1]; y0 += bandHeight)
     {
-      if(!m_UseJointInformation)
+      const int x0 = regionStart[0];
+      const int height = std::min(bandHeight, regionStart[1] + regionSize[1] - y0);
+
+      typename OutputImageType::IndexType bandIndex;
+      bandIndex[0] = largestRegion.GetIndex(0) + x0;
+      bandIndex[1] = largestRegion.GetIndex(1) + y0;
+      bandIndex[2] = largestRegion.GetIndex(2) + z;
+      typename OutputImageType::SizeType bandSize;
+      bandSize[0] = width;
+      bandSize[1] = height;
+      bandSize[2] = 1;
+      typename OutputImageType::RegionType bandRegion(bandIndex, bandSize);
+
+      bool anyInMask = false;
+      ImageRegionConstIterator< MaskImageType > mit(m_Mask, bandRegion);
+      for (int i = 0; !mit.IsAtEnd(); ++mit, ++i)
+      {
+        inMask[i] = mit.Get() != 0;
+        anyInMask = anyInMask || inMask[i];
+      }
+      anyInMask = anyInMask && !this->GetAbortGenerateData();
+
+      std::fill(weightedValues.begin(), weightedValues.end(), 0.0);
+      std::fill(weightSums.begin(), weightSums.end(), 0.0);
+
+      // visit the search window in the same order as the voxelwise formulation did, so that the
+      // weights of every voxel are accumulated in the same order
+      for (int dx = -sr; dx <= sr && anyInMask; ++dx)
       {
-        for (int i = 0; i < (int)inputImagePointer->GetVectorLength(); ++i)
+        for (int dy = -sr; dy <= sr; ++dy)
         {
-          double summw = 0;
-          double sumj = 0;
-          double w = 0;
-          std::vector<double> wj;
-          std::vector<double> p;
-          typename InputIteratorType::IndexType index;
-          index = git.GetIndex();
-
-          for (int x = index.GetElement(0) - m_SearchRadius; x <= index.GetElement(0) + m_SearchRadius; ++x)
+          for (int dz = -sr; dz <= sr; ++dz)
           {
-            for (int y = index.GetElement(1) - m_SearchRadius; y <= index.GetElement(1) + m_SearchRadius; ++y)
+            if (z + dz < 0 || z + dz >= imageSize[2])
+              continue;
+            const long offset = dx * strides[0] + dy * strides[1] + dz * strides[2];
+
+            // squared differences of all voxel pairs (p, p+d) inside the image, summed over the
+            // comparison radius along z. Pairs leaving the image do not contribute.
+            std::fill(planeSums.begin(), planeSums.end(), 0.0);
+            const int xBegin = std::max(x0 - cr, std::max(0, -dx));
+            const int xEnd = std::min(x0 + width + cr, std::min(imageSize[0], imageSize[0] - dx));
+            const int yBegin = std::max(y0 - cr, std::max(0, -dy));
+            const int yEnd = std::min(y0 + height + cr, std::min(imageSize[1], imageSize[1] - dy));
+            const int zBegin = std::max(z - cr, std::max(0, -dz));
+            const int zEnd = std::min(z + cr + 1, std::min(imageSize[2], imageSize[2] - dz));
+            for (int zi = zBegin; zi < zEnd; ++zi)
             {
-              for (int z = index.GetElement(2) - m_SearchRadius; z <= index.GetElement(2) + m_SearchRadius; ++z)
+              for (int yi = yBegin; yi < yEnd; ++yi)
               {
-                typename InputIteratorType::IndexType indexV;
-                indexV.SetElement(0, x);
-                indexV.SetElement(1, y);
-                indexV.SetElement(2, z);
-                if (inputImagePointer->GetLargestPossibleRegion().IsInside(indexV))
+                const TPixelType* pixelI = buffer + xBegin * strides[0] + yi * strides[1] + zi * strides[2];
+                double* planeSum = &planeSums[((yi - y0 + cr) * paddedWidth + xBegin - x0 + cr) * numWeights];
+                for (int xi = xBegin; xi < xEnd; ++xi, pixelI += numChannels, planeSum += numWeights)
                 {
-                  TPixelType pixelJ = inputImagePointer->GetPixel(indexV)[i];
-                  double sumk = 0;
-                  double size = 0;
-                  for (int xi = index.GetElement(0) - m_ComparisonRadius, xj = x - m_ComparisonRadius; xi <= index.GetElement(0) + m_ComparisonRadius; ++xi, ++xj)
+                  const TPixelType* pixelJ = pixelI + offset;
+                  if (m_UseJointInformation)
                   {
-                    for (int yi = index.GetElement(1) - m_ComparisonRadius, yj = y - m_ComparisonRadius; yi <= index.GetElement(1) + m_ComparisonRadius; ++yi, ++yj)
+                    double sum = 0;
+                    for (int c = 0; c < numChannels; ++c)
                     {
-                      for (int zi = index.GetElement(2) - m_ComparisonRadius, zj = z - m_ComparisonRadius; zi <= index.GetElement(2) + m_ComparisonRadius; ++zi, ++zj)
-                      {
-                        typename InputIteratorType::IndexType indexI, indexJ;
-                        indexI.SetElement(0, xi);
-                        indexI.SetElement(1, yi);
-                        indexI.SetElement(2, zi);
-                        indexJ.SetElement(0, xj);
-                        indexJ.SetElement(1, yj);
-                        indexJ.SetElement(2, zj);
-
-
-                        // Compare neighborhoods ni & nj
-                        if (inputImagePointer->GetLargestPossibleRegion().IsInside(indexI) && inputImagePointer->GetLargestPossibleRegion().IsInside(indexJ))
-                        {
-                          int diff = inputImagePointer->GetPixel(indexI)[i] - inputImagePointer->GetPixel(indexJ)[i];
-                          sumk += (double)(diff*diff);
-                          ++size;
-                        }
-                      }
+                      const double diff = (double)pixelI[c] - (double)pixelJ[c];
+                      sum += diff * diff;
                     }
-                  }
-                  // weight all neighborhoods
-                  w = std::exp( - sumk / size / m_Variance);
-                  wj.push_back(w);
-                  if (m_UseRicianAdaption)
-                  {
-                    p.push_back((double)(pixelJ*pixelJ));
+                    planeSum[0] += sum;
                   }
                   else
                   {
-                    p.push_back((double)(pixelJ));
+                    for (int c = 0; c < numChannels; ++c)
+                    {
+                      const double diff = (double)pixelI[c] - (double)pixelJ[c];
+                      planeSum[c] += diff * diff;
+                    }
                   }
-                  summw += w;
                 }
               }
             }
-          }
-          for (unsigned int n = 0; n < wj.size(); ++n)
-          {
-            sumj += (wj[n]/summw) * p[n];
-          }
-          if (m_UseRicianAdaption)
-          {
-            sumj -=2 * m_Variance;
-          }
-
-          if (sumj < 0)
-          {
-            sumj = 0;
-          }
 
-          TPixelType outval;
-          if (m_UseRicianAdaption)
-          {
-            outval = std::floor(std::sqrt(sumj) + 0.5);
-          }
-          else
-          {
-            outval = std::floor(sumj + 0.5);
-          }
-          outpix.SetElement(i, outval);
-        }
-      }
-
-      else
-      {
-        // same procedure for vektoranalysis
-
-        double Z = 0;
-        itk::VariableLengthVector<double> sumj;
-        sumj.SetSize(inputImagePointer->GetVectorLength());
-        sumj.Fill(0.0);
-        double w = 0;
-        std::vector<double> wj;
-        std::vector<itk::VariableLengthVector <double> > p;
-        typename InputIteratorType::IndexType index;
-        index = git.GetIndex();
-
-        for (int x = index.GetElement(0) - m_SearchRadius; x <= index.GetElement(0) + m_SearchRadius; ++x)
-        {
-          for (int y = index.GetElement(1) - m_SearchRadius; y <= index.GetElement(1) + m_SearchRadius; ++y)
-          {
-            for (int z = index.GetElement(2) - m_SearchRadius; z <= index.GetElement(2) + m_SearchRadius; ++z)
+            // box sums along x and y. All sums are sums of integers, the running sums are exact.
+            for (int yi = 0; yi < height + 2 * cr; ++yi)
             {
-              typename InputIteratorType::IndexType indexV;
-              indexV.SetElement(0, x);
-              indexV.SetElement(1, y);
-              indexV.SetElement(2, z);
-              if (inputImagePointer->GetLargestPossibleRegion().IsInside(indexV))
+              const double* planeRow = &planeSums[yi * paddedWidth * numWeights];
+              double* rowSum = &rowSums[yi * width * numWeights];
+              for (int c = 0; c < numWeights; ++c)
               {
-                typename InputImageType::PixelType pixelJ = inputImagePointer->GetPixel(indexV);
-                double sumk = 0;
-                double size = 0;
-                for (int xi = index.GetElement(0) - m_ComparisonRadius, xj = x - m_ComparisonRadius; xi <= index.GetElement(0) + m_ComparisonRadius; ++xi, ++xj)
+                double sum = 0;
+                for (int xi = 0; xi < 2 * cr; ++xi)
+                  sum += planeRow[xi * numWeights + c];
+                for (int xi = 0; xi < width; ++xi)
                 {
-                  for (int yi = index.GetElement(1) - m_ComparisonRadius, yj = y - m_ComparisonRadius; yi <= index.GetElement(1) + m_ComparisonRadius; ++yi, ++yj)
-                  {
-                    for (int zi = index.GetElement(2) - m_ComparisonRadius, zj = z - m_ComparisonRadius; zi <= index.GetElement(2) + m_ComparisonRadius; ++zi, ++zj)
-                    {
-                      typename InputIteratorType::IndexType indexI, indexJ;
-                      indexI.SetElement(0, xi);
-                      indexI.SetElement(1, yi);
-                      indexI.SetElement(2, zi);
-                      indexJ.SetElement(0, xj);
-                      indexJ.SetElement(1, yj);
-                      indexJ.SetElement(2, zj);
-                      // Compare neighborhoods ni & nj
-                      if (inputImagePointer->GetLargestPossibleRegion().IsInside(indexI) && inputImagePointer->GetLargestPossibleRegion().IsInside(indexJ))
-                      {
-                        typename InputImageType::PixelType diff = inputImagePointer->GetPixel(indexI) - inputImagePointer->GetPixel(indexJ);
-                        sumk += (double)(diff.GetSquaredNorm());
-                        ++size;
-                      }
-                    }
-                  }
+                  sum += planeRow[(xi + 2 * cr) * numWeights + c];
+                  rowSum[xi * numWeights + c] = sum;
+                  sum -= planeRow[xi * numWeights + c];
                 }
-                // weight all neighborhoods
-                size *= inputImagePointer->GetVectorLength() + 1;
-                w = std::exp( - (sumk / size) / m_Variance);
-                wj.push_back(w);
-                if (m_UseRicianAdaption)
+              }
+            }
+            for (int xi = 0; xi < width * numWeights; ++xi)
+            {
+              double sum = 0;
+              for (int yi = 0; yi < 2 * cr; ++yi)
+                sum += rowSums[yi * width * numWeights + xi];
+              for (int yi = 0; yi < height; ++yi)
+              {
+                sum += rowSums[(yi + 2 * cr) * width * numWeights + xi];
+                patchDistances[yi * width * numWeights + xi] = sum;
+                sum -= rowSums[yi * width * numWeights + xi];
+              }
+            }
+
+            // weight the neighbours
+            const int overlapZ = this->GetOverlapCount(z, dz, imageSize[2]);
+            for (int yi = 0; yi < height; ++yi)
+            {
+              const int y = y0 + yi;
+              if (y + dy < 0 || y + dy >= imageSize[1])
+                continue;
+              const int overlapYZ = this->GetOverlapCount(y, dy, imageSize[1]) * overlapZ;
+
+              for (int xi = 0; xi < width; ++xi)
+              {
+                const int x = x0 + xi;
+                const int voxel = yi * width + xi;
+                if (!inMask[voxel] || x + dx < 0 || x + dx >= imageSize[0])
+                  continue;
+
+                double size = this->GetOverlapCount(x, dx, imageSize[0]) * overlapYZ;
+                const double* sumk = &patchDistances[voxel * numWeights];
+                const TPixelType* pixelJ = buffer + (x + dx) * strides[0] + (y + dy) * strides[1] + (z + dz) * strides[2];
+                double* sumj = &weightedValues[voxel * numChannels];
+                double* summw = &weightSums[voxel * numWeights];
+
+                if (!m_UseJointInformation)
                 {
-                  itk::VariableLengthVector <double> m;
-                  m.SetSize(inputImagePointer->GetVectorLength());
-                  for (unsigned int i = 0; i < inputImagePointer->GetVectorLength(); ++i)
+                  for (int c = 0; c < numChannels; ++c)
                   {
-                    double sp = (double)(pixelJ.GetElement(i) * pixelJ.GetElement(i));
-                    m.SetElement(i,sp);
+                    const double w = std::exp( - sumk[c] / size / m_Variance);
+                    const double p = m_UseRicianAdaption ? (double)pixelJ[c] * pixelJ[c] : (double)pixelJ[c];
+                    sumj[c] += w * p;
+                    summw[c] += w;
                   }
-                  p.push_back(m);
                 }
                 else
-                  ++size;
                 {
-                  p.push_back(pixelJ);
+                  size *= numChannels + 1;
+                  const double w = std::exp( - (sumk[0] / size) / m_Variance);
+                  summw[0] += w;
+                  if (m_UseRicianAdaption)
+                  {
+                    // The voxelwise formulation paired the n-th weight with the n-th entry of a list
+                    // that holds the squared and the plain values of every neighbour alternately.
+                    // The reference results depend on it, so the pairing is kept.
+                    const int lower[3] = { std::max(-sr, -x), std::max(-sr, -y), std::max(-sr, -z) };
+                    const int count[3] = { std::min(sr, imageSize[0] - 1 - x) - lower[0] + 1,
+                                           std::min(sr, imageSize[1] - 1 - y) - lower[1] + 1,
+                                           std::min(sr, imageSize[2] - 1 - z) - lower[2] + 1 };
+                    const int n = ((dx - lower[0]) * count[1] + dy - lower[1]) * count[2] + dz - lower[2];
+                    const int k = n / 2;
+                    const TPixelType* pixelK = buffer + (x + lower[0] + k / (count[1] * count[2])) * strides[0]
+                                                      + (y + lower[1] + (k / count[2]) % count[1]) * strides[1]
+                                                      + (z + lower[2] + k % count[2]) * strides[2];
+                    if (n % 2 == 0)
+                    {
+                      for (int c = 0; c < numChannels; ++c)
+                        sumj[c] += w * ((double)pixelK[c] * pixelK[c]);
+                    }
+                    else
+                    {
+                      for (int c = 0; c < numChannels; ++c)
+                        sumj[c] += w * pixelK[c];
+                    }
+                  }
+                  else
+                  {
+                    for (int c = 0; c < numChannels; ++c)
+                      sumj[c] += w * pixelJ[c];
+                  }
                 }
-                Z += w;
               }
             }
           }
         }
-        for (unsigned int n = 0; n < wj.size(); ++n)
-        {
-          sumj = sumj + ((wj[n]/Z) * p[n]);
-        }
-        if (m_UseRicianAdaption)
-        {
-          sumj = sumj - (2 * m_Variance);
-        }
+      }
 
-        for (unsigned int i = 0; i < inputImagePointer->GetVectorLength(); ++i)
+      // normalize and write the band
+      ImageRegionIterator< OutputImageType > oit(outputImage, bandRegion);
+      typename OutputImageType::PixelType outpix;
+      outpix.SetSize(numChannels);
+      for (int voxel = 0; !oit.IsAtEnd(); ++oit, ++voxel)
+      {
+        if (inMask[voxel] && anyInMask)
         {
-          double a = sumj.GetElement(i);
-          if (a < 0)
-          {
-            a = 0;
-          }
-          TPixelType outval;
-          if (m_UseRicianAdaption)
-          {
-            outval = std::floor(std::sqrt(a) + 0.5);
-          }
-          else
+          for (int c = 0; c < numChannels; ++c)
           {
-            outval = std::floor(a + 0.5);
+            double sumj = weightedValues[voxel * numChannels + c] / weightSums[voxel * numWeights + (m_UseJointInformation ? 0 : c)];
+            if (m_UseRicianAdaption)
+            {
+              sumj -= 2 * m_Variance;
+            }
+
+            if (sumj < 0)
+            {
+              sumj = 0;
+            }
+
+            TPixelType outval;
+            if (m_UseRicianAdaption)
+            {
+              outval = std::floor(std::sqrt(sumj) + 0.5);
+            }
+            else
+            {
+              outval = std::floor(sumj + 0.5);
+            }
+            outpix.SetElement(c, outval);
           }
-          outpix.SetElement(i, outval);
         }
+        else
+        {
+          outpix.Fill(0);
+        }
+        oit.Set(outpix);
       }
+      m_CurrentVoxelCount += width * height;
     }
-    else
-    {
-      outpix.Fill(0);
-    }
-
-    oit.Set(outpix);
-    ++oit;
-    ++m_CurrentVoxelCount;
-    ++git;
-    ++mit;
   }
 
   MITK_INFO << "One Thread finished calculation";
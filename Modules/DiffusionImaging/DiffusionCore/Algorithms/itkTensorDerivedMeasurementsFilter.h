@@ -29,6 +29,10 @@ This file is based heavily on a corresponding ITK filter.
 
 namespace itk{
 /** \class TensorDerivedMeasurementsFilter
+ *
+ * Computes a scalar measure (m_Measure) of every tensor. With ComputeAllMeasures on, all measures are computed
+ * in a single pass over the tensor image from one closed form eigen-decomposition per voxel and
+ * GetMeasureOutput() returns the image of each measure.
  */
 
 template <class TPixel>
@@ -51,6 +55,8 @@ public:
     MD // mean diffusivity
   };
 
+  static const unsigned int NumberOfMeasures = MD+1;
+
   typedef itk::DiffusionTensor3D<TPixel>          TensorType;
   typedef itk::Image< TensorType, 3 >             TensorImageType;
   typedef itk::Image< TPixel, 3 >                 OutputImageType;
@@ -71,6 +77,14 @@ public:
 
   itkSetMacro(Measure, Measure);
 
+  /** Compute all measures in one pass, one output per measure. */
+  void SetComputeAllMeasures(bool computeAllMeasures);
+  itkGetMacro(ComputeAllMeasures, bool)
+  itkBooleanMacro(ComputeAllMeasures)
+
+  /** Output containing the given measure. Without ComputeAllMeasures, this is the primary output and measure has to be m_Measure. */
+  OutputImageType* GetMeasureOutput(Measure measure);
+
 
 protected:
   TensorDerivedMeasurementsFilter();
@@ -78,9 +92,13 @@ protected:
   //void PrintSelf(std::ostream& os, Indent indent) const;
 
   Measure m_Measure;
+  bool    m_ComputeAllMeasures;
 
   void GenerateData();
 
+  static TPixel GetMeasure(Measure measure, const TensorType& tensor, const double eigenValues[3]);
+  static bool NeedsEigenValues(Measure measure);
+
 }; // end class
 
 } // end namespace
@@ -19,124 +19,116 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 #include <itkImageRegionIterator.h>
+#include <itkTensorEigenValues.h>
+#include <vector>
 
 
 namespace itk {
 
   template <class TPixel>
-      TensorDerivedMeasurementsFilter<TPixel>::TensorDerivedMeasurementsFilter() : m_Measure(AD)
+      TensorDerivedMeasurementsFilter<TPixel>::TensorDerivedMeasurementsFilter() : m_Measure(AD), m_ComputeAllMeasures(false)
   {
   }
 
+  template <class TPixel>
+      void TensorDerivedMeasurementsFilter<TPixel>::SetComputeAllMeasures(bool computeAllMeasures)
+  {
+    if (m_ComputeAllMeasures == computeAllMeasures)
+      return;
+
+    m_ComputeAllMeasures = computeAllMeasures;
+    unsigned int numberOfOutputs = m_ComputeAllMeasures ? NumberOfMeasures : 1;
+    this->SetNumberOfRequiredOutputs(numberOfOutputs);
+    for (unsigned int i=1; i<numberOfOutputs; i++)
+      if (this->GetOutput(i) == NULL)
+        this->SetNthOutput(i, this->MakeOutput(i));
+    this->Modified();
+  }
+
+  template <class TPixel>
+      typename TensorDerivedMeasurementsFilter<TPixel>::OutputImageType* TensorDerivedMeasurementsFilter<TPixel>::GetMeasureOutput(Measure measure)
+  {
+    if (!m_ComputeAllMeasures)
+    {
+      if (measure != m_Measure)
+        itkExceptionMacro( << "Measure " << measure << " is not computed. Set it as measure or turn on ComputeAllMeasures.");
+      return this->GetOutput();
+    }
+    return this->GetOutput(measure);
+  }
+
+  template <class TPixel>
+      bool TensorDerivedMeasurementsFilter<TPixel>::NeedsEigenValues(Measure measure)
+  {
+    return measure != FA && measure != RA;
+  }
+
+  template <class TPixel>
+      TPixel TensorDerivedMeasurementsFilter<TPixel>::GetMeasure(Measure measure, const TensorType& tensor, const double eigenValues[3])
+  {
+    // eigenvalues are sorted in ascending order, like the itk::SymmetricEigenAnalysis defaults used by the tensor implementation
+    switch(measure)
+    {
+    case FA:
+      return tensor.GetFractionalAnisotropy();
+    case RA:
+      return tensor.GetRelativeAnisotropy();
+    case AD:
+      return eigenValues[2];
+    case RD:
+      return (eigenValues[0]+eigenValues[1])/2.0;
+    case CA:
+      if (eigenValues[2] == 0)
+        return 0;
+      return 1.0-(eigenValues[0]+eigenValues[1])/(2.0*eigenValues[2]);
+    case L2:
+      return eigenValues[1];
+    case L3:
+      return eigenValues[0];
+    case MD:
+      return (eigenValues[0]+eigenValues[1]+eigenValues[2])/3.0;
+    }
+    return 0;
+  }
+
   template <class TPixel>
       void TensorDerivedMeasurementsFilter<TPixel>::GenerateData()
   {
     typename TensorImageType::Pointer tensorImage = static_cast< TensorImageType * >( this->ProcessObject::GetInput(0) );
-    typedef ImageRegionConstIterator< TensorImageType > TensorImageIteratorType;
-    typedef ImageRegionIterator< OutputImageType > OutputImageIteratorType;
-
-
-    typename OutputImageType::Pointer outputImage =
-        static_cast< OutputImageType * >(this->ProcessObject::GetPrimaryOutput());
-
-    typename TensorImageType::RegionType region = tensorImage->GetLargestPossibleRegion();
-
-
-    outputImage->SetSpacing( tensorImage->GetSpacing() );   // Set the image spacing
-    outputImage->SetOrigin( tensorImage->GetOrigin() );     // Set the image origin
-    outputImage->SetDirection( tensorImage->GetDirection() );  // Set the image direction
-    outputImage->SetRegions( tensorImage->GetLargestPossibleRegion());
-    outputImage->Allocate();
-
-    TensorImageIteratorType tensorIt(tensorImage, tensorImage->GetLargestPossibleRegion());
-    OutputImageIteratorType outputIt(outputImage, outputImage->GetLargestPossibleRegion());
-
-    tensorIt.GoToBegin();
-    outputIt.GoToBegin();
-
-    while(!tensorIt.IsAtEnd() && !outputIt.IsAtEnd()){
-
-      TensorType tensor = tensorIt.Get();
-
-      switch(m_Measure)
-      {
-      case FA:
-        {
-          TPixel diffusionIndex = tensor.GetFractionalAnisotropy();
-          outputIt.Set(diffusionIndex);
-          break;
-        }
-      case RA:
-        {
-          TPixel diffusionIndex = tensor.GetRelativeAnisotropy();
-          outputIt.Set(diffusionIndex);
-          break;
-        }
-      case AD:
-        {
-          // eigenvalues are sorted in ascending order by default because the
-          // itk::SymmetricEigenAnalysis defaults are not touched in the tensor implementation
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          outputIt.Set(evs[2]);
-          break;
-        }
-      case RD:
-        {
-          // eigenvalues are sorted in ascending order by default because the
-          // itk::SymmetricEigenAnalysis defaults are not touched in the tensor implementation
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          outputIt.Set((evs[0]+evs[1])/2.0);
-
-          break;
-        }
-      case CA:
-        {
-          // eigenvalues are sorted in ascending order by default because the
-          // itk::SymmetricEigenAnalysis defaults are not touched in the tensor implementation
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          if (evs[2] == 0)
-          {
-            outputIt.Set(0);
-            break;
-          }
-          outputIt.Set(1.0-(evs[0]+evs[1])/(2.0*evs[2]));
-          break;
-        }
-      case L2:
-        {
-          // eigenvalues are sorted in ascending order by default because the
-          // itk::SymmetricEigenAnalysis defaults are not touched in the tensor implementation
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          outputIt.Set(evs[1]);
-          break;
-        }
-      case L3:
-        {
-          // eigenvalues are sorted in ascending order by default because the
-          // itk::SymmetricEigenAnalysis defaults are not touched in the tensor implementation
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          outputIt.Set(evs[0]);
-          break;
-        }
-      case MD:
-        {
-          typename TensorType::EigenValuesArrayType evs;
-          tensor.ComputeEigenValues(evs);
-          outputIt.Set((evs[0]+evs[1]+evs[2])/3.0);
-          break;
-        }
-      }
-
-      ++tensorIt;
-      ++outputIt;
+
+    // one output per measure, or only the primary output for m_Measure
+    std::vector< Measure > measures;
+    std::vector< TPixel* > outputBuffers;
+    bool needsEigenValues = false;
+    unsigned int numberOfOutputs = m_ComputeAllMeasures ? NumberOfMeasures : 1;
+    for (unsigned int i=0; i<numberOfOutputs; i++)
+    {
+      typename OutputImageType::Pointer outputImage = this->GetOutput(i);
+      outputImage->SetSpacing( tensorImage->GetSpacing() );   // Set the image spacing
+      outputImage->SetOrigin( tensorImage->GetOrigin() );     // Set the image origin
+      outputImage->SetDirection( tensorImage->GetDirection() );  // Set the image direction
+      outputImage->SetRegions( tensorImage->GetLargestPossibleRegion());
+      outputImage->Allocate();
+
+      measures.push_back( m_ComputeAllMeasures ? (Measure)i : m_Measure );
+      outputBuffers.push_back( outputImage->GetBufferPointer() );
+      needsEigenValues |= NeedsEigenValues(measures.back());
     }
 
+    const TensorType* tensorBuffer = tensorImage->GetBufferPointer();
+    const long numVoxels = tensorImage->GetLargestPossibleRegion().GetNumberOfPixels();
 
+#pragma omp parallel for
+    for (long i=0; i<numVoxels; i++)
+    {
+      const TensorType& tensor = tensorBuffer[i];
+      double eigenValues[3] = {0,0,0};
+      if (needsEigenValues)
+        ComputeTensorEigenValues(tensor.GetDataPointer(), eigenValues);
+
+      for (unsigned int m=0; m<numberOfOutputs; m++)
+        outputBuffers[m][i] = GetMeasure(measures[m], tensor, eigenValues);
+    }
   }
 
 
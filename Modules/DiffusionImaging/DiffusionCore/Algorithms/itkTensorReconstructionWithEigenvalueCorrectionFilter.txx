@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageFileWriter.h"
 #include "itkImage.h"
 #include "itkImageRegionIterator.h"
+#include <itkBatchedMatrixProduct.h>
+#include <itkTensorEigenValues.h>
+#include <vector>
 
 namespace itk
 {
@@ -173,34 +176,30 @@ TensorReconstructionWithEigenvalueCorrectionFilter<TDiffusionPixelType, TTensorP
   // treshold on the B0 image proviced by the userare excluded from the dataset with use of defined mask image.
   // 1 in mask voxel means that B0 > assumed treshold.
 
+  const long numVoxels = (long)size[0]*size[1]*size[2];
+  const TDiffusionPixelType* dwiBuffer = m_GradientImagePointer->GetBufferPointer();
+  short* maskBuffer = mask->GetBufferPointer();
   int mask_cnt=0;
-  for(unsigned int x=0;x<size[0];x++)
+#pragma omp parallel for reduction(+:mask_cnt)
+  for (long voxel=0; voxel<numVoxels; voxel++)
   {
-    for(unsigned int y=0;y<size[1];y++)
+    const TDiffusionPixelType* pixel = dwiBuffer + voxel*nof;
+    double mean_b=0.0;
+    for (int i=0;i<nof;i++)
     {
-      for(unsigned int z=0;z<size[2];z++)
+      if(m_B0Mask[i]==1)
       {
-        double mean_b=0.0;
-        itk::Index<3> ix = {{x,y,z}};
-
-        GradientVectorType pixel = m_GradientImagePointer->GetPixel(ix);
-        for (int i=0;i<nof;i++)
-        {
-          if(m_B0Mask[i]==1)
-          {
-            mean_b = mean_b + pixel[i];
-          }
-        }
-        mean_b=mean_b/numberb0;
-        if(mean_b > m_B0Threshold)
-        {
-          mask->SetPixel(ix, 1);
-          mask_cnt++;
-        }
-        else
-          mask->SetPixel(ix, 0);
+        mean_b = mean_b + pixel[i];
       }
     }
+    mean_b=mean_b/numberb0;
+    if(mean_b > m_B0Threshold)
+    {
+      maskBuffer[voxel] = 1;
+      mask_cnt++;
+    }
+    else
+      maskBuffer[voxel] = 0;
   }
 
   double mask_val=0.0;
@@ -520,71 +519,30 @@ TensorReconstructionWithEigenvalueCorrectionFilter<TDiffusionPixelType, TTensorP
   // of voxels (tensors) with negative eigenvalues. Then if the voxel was previously bad ( mask=2 ) but it is not bad anymore mask is
   //changed to 1.
 
-  // declaration of important structures and variables
-  double badvoxels=0;
-  double pixel=0;
-  itk::DiffusionTensor3D<double> ten;
-  vnl_matrix<double> temp_tensor(3,3);
-  vnl_vector<double> eigen_vals(3);
-  vnl_vector<double> tensor (6);
+  // the eigenvalues are computed in closed form, so the voxels can be checked in parallel without any allocations
+  const long numVoxels = (long)size[0]*size[1]*size[2];
+  short* maskBuffer = mask->GetBufferPointer();
+  const TensorPixelType* tensorBuffer = tensorImg->GetBufferPointer();
+  int badvoxels=0;
 
-  // for every pixel from the image
-  for (unsigned int x=0;x<size[0];x++)
+#pragma omp parallel for reduction(+:badvoxels)
+  for (long voxel=0; voxel<numVoxels; voxel++)
   {
-
-    for (unsigned int y=0;y<size[1];y++)
+    // but only if previously marked as bad one-negative eigen value
+    if(maskBuffer[voxel] > 1)
     {
+      double eigen_vals[3];
+      ComputeTensorEigenValues(tensorBuffer[voxel].GetDataPointer(), eigen_vals);
 
-      for (unsigned int z=0;z<size[2];z++)
-      {
-
-
-        itk::Index<3> ix = {{x,y,z}};
-        pixel = mask->GetPixel(ix);
-
-        // but only if previously marked as bad one-negative eigen value
-
-        if(pixel > 1)
-        {
-
-          ten = tensorImg->GetPixel(ix);
-
-          // changing order from tensor structure in MITK into vnl structure 3x3 symmetric tensor matrix
-
-          tensor[0] = ten(0,0);
-          tensor[3] = ten(0,1);
-          tensor[5] = ten(0,2);
-          tensor[1] = ten(1,1);
-          tensor[4] = ten(1,2);
-          tensor[2] = ten(2,2);
-
-          temp_tensor[0][0]= tensor[0]; temp_tensor[1][0]= tensor[3]; temp_tensor[2][0]= tensor[5];
-          temp_tensor[0][1]= tensor[3]; temp_tensor[1][1]= tensor[1]; temp_tensor[2][1]= tensor[4];
-          temp_tensor[0][2]= tensor[5]; temp_tensor[1][2]= tensor[4]; temp_tensor[2][2]= tensor[2];
-
-          //checking negativity of tensor eigenvalues
-
-          vnl_symmetric_eigensystem<double> eigen_tensor(temp_tensor);
-
-
-          eigen_vals[0]=eigen_tensor.get_eigenvalue(0);
-          eigen_vals[1]=eigen_tensor.get_eigenvalue(1);
-          eigen_vals[2]=eigen_tensor.get_eigenvalue(2);
-
-          //comparison to 0.01 instead of 0 was proposed by O.Pasternak
-
-          if( eigen_vals[0]>0.01 && eigen_vals[1]>0.01 && eigen_vals[2]>0.01)
-          {
-            mask->SetPixel(ix,1);
-
-          }
-          else
-          {
-            badvoxels++;
-          }
-
-        }
+      //comparison to 0.01 instead of 0 was proposed by O.Pasternak
 
+      if( eigen_vals[0]>0.01 && eigen_vals[1]>0.01 && eigen_vals[2]>0.01)
+      {
+        maskBuffer[voxel] = 1;
+      }
+      else
+      {
+        badvoxels++;
       }
     }
   }
@@ -827,125 +785,81 @@ TensorReconstructionWithEigenvalueCorrectionFilter<TDiffusionPixelType, TTensorP
 ::GenerateTensorImage(int nof,int numberb0,itk::Size<3> size,itk::VectorImage<short, 3>::Pointer corrected_diffusion,itk::Image<short, 3>::Pointer mask,double what_mask, typename itk::Image< itk::DiffusionTensor3D<TTensorPixelType>, 3 >::Pointer tensorImg)
 {
   // in this method the whole tensor image is updated with a tensors for defined voxels ( defined by a value of mask);
+  // The voxels of one image row are fitted together: the log attenuations of all masked voxels of the row are
+  // collected element-major and multiplied with the pseudoinverse of the design matrix in one batch.
 
+  const int numGradients = nof-numberb0;
+  const unsigned int rowLength = size[0];
+  const int numRows = size[1]*size[2];
+  const short* dwiBuffer = corrected_diffusion->GetBufferPointer();
+  const short* maskBuffer = mask->GetBufferPointer();
+  TensorPixelType* tensorBuffer = tensorImg->GetBufferPointer();
 
-  itk::Index<3> ix;
-
-  itk::Index<3> idx;
-  idx.Fill(5);
-
-  vnl_vector<double> org_data(nof);
-  vnl_vector<double> atten(nof-numberb0);
-  vnl_vector<double> tensor(6);
-  itk::DiffusionTensor3D<double> ten;
-  double mask_val=0;
-
-
-  for (unsigned int x=0;x<size[0];x++)
+#pragma omp parallel
   {
+    std::vector<double> atten(numGradients*rowLength);
+    std::vector<double> tensor(6*rowLength);
+    std::vector<long> voxels(rowLength);
 
-    for (unsigned int y=0;y<size[1];y++)
+#pragma omp for schedule(dynamic)
+    for (int row=0; row<numRows; row++)
     {
-
-      for (unsigned int z=0;z<size[2];z++)
+      unsigned int count = 0;
+      for (unsigned int x=0; x<rowLength; x++)
       {
-
-
-        ix[0] = x; ix[1] = y; ix[2] = z;
-
-        mask_val= mask->GetPixel(ix);
+        const long voxel = (long)row*rowLength + x;
 
         //Tensors are calculated only for voxels above theshold for B0 image.
-
-        if( mask_val > 0.0 )
+        if( maskBuffer[voxel] > 0 )
         {
-
           // calculation of attenuation with use of gradient image and  and mean B0 image
-          GradientVectorType pt = corrected_diffusion->GetPixel(ix);
-
-          for (int i=0;i<nof;i++)
-          {
-            org_data[i]=pt[i];
-          }
+          const short* org_data = dwiBuffer + voxel*nof;
 
           double mean_b=0.0;
-
           for (int i=0;i<nof;i++)
           {
             if(m_B0Mask[i]>0)
             {
               mean_b=mean_b+org_data[i];
             }
-
           }
           mean_b=mean_b/numberb0;
+
           int cnt=0;
           for (int i=0;i<nof;i++)
           {
-            if (org_data[i]<= 0)
-
-            {
-              org_data[i]=0.1;
-            }
             if(m_B0Mask[i]==0)
             {
-              atten[cnt]=org_data[i]/mean_b;
+              const double value = org_data[i]<=0 ? 0.1 : org_data[i];
+              atten[cnt*rowLength + count]=log(value/mean_b);
               cnt++;
             }
           }
-
-
-
-
-          for (int i=0;i<nof-numberb0;i++)
-          {
-
-            atten[i]=log((double)atten[i]);
-          }
-
-          // Calculation of tensor with use of previously calculated inverse of design matrix and attenuation
-          tensor = m_PseudoInverse*atten;
-
-          ten(0,0) = tensor[0];
-          ten(0,1) = tensor[3];
-          ten(0,2) = tensor[5];
-          ten(1,1) = tensor[1];
-          ten(1,2) = tensor[4];
-          ten(2,2) = tensor[2];
-
-          tensorImg->SetPixel(ix, ten);
-
-
-
+          voxels[count++] = voxel;
         }
         // for voxels with mask value 0 - tensor is simply 0 ( outside brain value)
-        else if (mask_val < 1.0)
-        {
-
-          ten(0,0) = 0;
-          ten(0,1) = 0;
-          ten(0,2) = 0;
-          ten(1,1) = 0;
-          ten(1,2) = 0;
-          ten(2,2) = 0;
-          tensorImg->SetPixel(ix, ten);
-        }
-
-        if (ix == idx)
+        else
         {
-          for (int ll = 0; ll < 6 ; ll++)
-          std::cout << tensor[ll] << "," << std::endl;
+          tensorBuffer[voxel].Fill(0);
         }
+      }
 
+      // Calculation of tensor with use of previously calculated inverse of design matrix and attenuation
+      BatchedMatrixProduct(m_PseudoInverse, &atten[0], &tensor[0], count, rowLength);
 
-
-
+      for (unsigned int v=0; v<count; v++)
+      {
+        TensorPixelType& ten = tensorBuffer[voxels[v]];
+        ten(0,0) = tensor[0*rowLength + v];
+        ten(0,1) = tensor[3*rowLength + v];
+        ten(0,2) = tensor[5*rowLength + v];
+        ten(1,1) = tensor[1*rowLength + v];
+        ten(1,2) = tensor[4*rowLength + v];
+        ten(2,2) = tensor[2*rowLength + v];
       }
     }
   }
 
-
-
 }// end of Generate Tensor
 
 
@@ -956,23 +870,15 @@ TensorReconstructionWithEigenvalueCorrectionFilter<TDiffusionPixelType, TTensorP
 {
   // The method changes voxels in the mask that poses a certain value with other value.
 
-  itk::Index<3> ix;
-  double temp_mask_value=0;
+  const long numVoxels = (long)size[0]*size[1]*size[2];
+  short* maskBuffer = mask->GetBufferPointer();
 
-  for(unsigned int x=0;x<size[0];x++)
+#pragma omp parallel for
+  for (long voxel=0; voxel<numVoxels; voxel++)
   {
-    for(unsigned int y=0;y<size[1];y++)
+    if(maskBuffer[voxel]>previous_mask)
     {
-      for(unsigned int z=0;z<size[2];z++)
-      {
-        ix[0] = x; ix[1] = y; ix[2] = z;
-        temp_mask_value=mask->GetPixel(ix);
-
-        if(temp_mask_value>previous_mask)
-        {
-          mask->SetPixel(ix,set_mask);
-        }
-      }
+      maskBuffer[voxel] = set_mask;
     }
   }
 }
@@ -20,23 +20,25 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkVtkMapper.h"
 #include "vtkPropAssembly.h"
-#include "vtkAppendPolyData.h"
+#include "vtkPolyData.h"
 #include "vtkActor.h"
 #include "vtkPolyDataMapper.h"
-#include "vtkPlane.h"
-#include "vtkCutter.h"
-#include "vtkClipPolyData.h"
-#include "vtkTransform.h"
 #include "vtkDataArrayTemplate.h"
 #include "vtkSmartPointer.h"
-#include "vtkOdfSource.h"
-#include "vtkThickPlane.h"
+#include "vtkImageData.h"
+
+#include <vector>
 
 namespace mitk {
 
 //##Documentation
 //## @brief Mapper for spherical object densitiy function representations
 //##
+//## All glyphs share the topology of the ODF base mesh, only the vertex radii differ. The radii and cell colors
+//## of the glyphs are cached per plane as long as the slice and the ODF data stay the same, so zooming and panning
+//## only move the cached glyphs. If more than "ShowMaxNumber" voxels are visible, only every n-th voxel in both
+//## in-plane directions gets a glyph.
+//##
 template<class TPixelType, int NrOdfDirections>
 class OdfVtkMapper2D : public VtkMapper
 {
@@ -64,6 +66,25 @@ class OdfVtkMapper2D : public VtkMapper
         }
     };
 
+    /** Radii and cell colors of the glyphs of one slice. Glyphs are computed when they first become visible. */
+    struct OdfGlyphCache {
+        vtkImageData*       image;
+        unsigned long       imageMTime;
+        int                 axis;
+        int                 slice;
+        int                 normalization;
+        int                 scaleBy;
+        float               indexParam1;
+        float               indexParam2;
+
+        std::vector< int >      slots;      ///< glyph slot of each voxel in the slice, -1 if not computed yet
+        std::vector< float >    radii;      ///< NrOdfDirections radii per slot
+        std::vector< float >    colors;     ///< one color value per base mesh cell and slot
+        int                     numberOfSlots;
+
+        OdfGlyphCache() : image(NULL), imageMTime(0), axis(-1), slice(-1), normalization(-1), scaleBy(-1), indexParam1(0), indexParam2(0), numberOfSlots(0) {}
+    };
+
 public:
 
     mitkClassMacro(OdfVtkMapper2D,VtkMapper)
@@ -92,10 +113,10 @@ public:
     public:
 
         std::vector< vtkSmartPointer<vtkPropAssembly> >       m_PropAssemblies;
-        std::vector< vtkSmartPointer<vtkAppendPolyData> >     m_OdfsPlanes;
+        std::vector< vtkSmartPointer<vtkPolyData> >           m_OdfsPlanes;
         std::vector< vtkSmartPointer<vtkActor> >              m_OdfsActors;
         std::vector< vtkSmartPointer<vtkPolyDataMapper> >     m_OdfsMappers;
-        vtkSmartPointer< vtkPolyData >                        m_TemplateOdf;
+        std::vector< OdfGlyphCache >                          m_GlyphCaches;
 
         itk::TimeStamp                      m_LastUpdateTime;
 
@@ -112,15 +133,20 @@ protected:
     OdfVtkMapper2D();
     virtual ~OdfVtkMapper2D();
 
-    static void GlyphMethod(void *arg);
     bool IsPlaneRotated(mitk::BaseRenderer* renderer);
 
+    /** Copy the directions and cells of the ODF base mesh, only done once. */
+    static void InitializeBaseMesh();
+    /** Compute radii and cell colors of the ODF at the given point of m_VtkImage and store them in the given cache slot. */
+    void ComputeGlyph(vtkIdType pointId, OdfGlyphCache& cache, int slot);
+
 private:
 
     mitk::Image* GetInput();
 
-    static vtkSmartPointer<vtkTransform> m_OdfTransform;
-    static vtkSmartPointer<vtkOdfSource> m_OdfSource;
+    static std::vector< double >    m_BaseMeshDirections;   ///< unit directions of the base mesh vertices (x,y,z)
+    static std::vector< vtkIdType > m_BaseMeshCells;        ///< base mesh cells as (n, id1, ..., idn)
+    static int                      m_BaseMeshNumberOfCells;
     static float    m_Scaling;
     static int      m_Normalization;
     static int      m_ScaleBy;
@@ -128,12 +154,6 @@ private:
     static float    m_IndexParam2;
     int             m_ShowMaxNumber;
 
-    std::vector< vtkSmartPointer<vtkPlane> >          m_Planes;
-    std::vector< vtkSmartPointer<vtkCutter> >         m_Cutters;
-    std::vector< vtkSmartPointer<vtkThickPlane> >     m_ThickPlanes1;
-    std::vector< vtkSmartPointer<vtkClipPolyData> >  m_Clippers1;
-    std::vector< vtkSmartPointer<vtkThickPlane> >     m_ThickPlanes2;
-    std::vector< vtkSmartPointer<vtkClipPolyData> >  m_Clippers2;
     vtkImageData*                   m_VtkImage ;
     OdfDisplayGeometry              m_LastDisplayGeometry;
     mitk::LocalStorageHandler<LocalStorage> m_LSH;
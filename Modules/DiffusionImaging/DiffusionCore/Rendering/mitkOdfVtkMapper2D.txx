@@ -31,18 +31,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "vtkSphereSource.h"
 #include "vtkPropCollection.h"
-#include "vtkMaskedGlyph3D.h"
-#include "vtkGlyph2D.h"
-#include "vtkGlyph3D.h"
-#include "vtkMaskedProgrammableGlyphFilter.h"
 #include "vtkImageData.h"
 #include "vtkLinearTransform.h"
 #include "vtkCamera.h"
 #include "vtkPointData.h"
-#include "vtkTransformPolyDataFilter.h"
 #include "vtkTransform.h"
-#include "vtkOdfSource.h"
 #include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkCellArray.h"
 #include "vtkLookupTable.h"
 #include "vtkProperty.h"
 #include "vtkPolyDataNormals.h"
@@ -50,7 +46,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkLightCollection.h"
 #include "vtkMath.h"
 #include "vtkFloatArray.h"
-#include "vtkDelaunay2D.h"
 #include "vtkMapper.h"
 
 #include "vtkRenderer.h"
@@ -66,10 +61,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <math.h>
 
 template<class T, int N>
-vtkSmartPointer<vtkTransform> mitk::OdfVtkMapper2D<T,N>::m_OdfTransform = vtkSmartPointer<vtkTransform>::New();
+std::vector< double > mitk::OdfVtkMapper2D<T,N>::m_BaseMeshDirections;
 
 template<class T, int N>
-vtkSmartPointer<vtkOdfSource> mitk::OdfVtkMapper2D<T,N>::m_OdfSource = vtkSmartPointer<vtkOdfSource>::New();
+std::vector< vtkIdType > mitk::OdfVtkMapper2D<T,N>::m_BaseMeshCells;
+
+template<class T, int N>
+int mitk::OdfVtkMapper2D<T,N>::m_BaseMeshNumberOfCells = 0;
 
 template<class T, int N>
 float mitk::OdfVtkMapper2D<T,N>::m_Scaling;
@@ -96,13 +94,11 @@ mitk::OdfVtkMapper2D<T,N>::LocalStorage::LocalStorage()
     m_PropAssemblies.push_back(vtkPropAssembly::New());
     m_PropAssemblies.push_back(vtkPropAssembly::New());
 
-    m_OdfsPlanes.push_back(vtkAppendPolyData::New());
-    m_OdfsPlanes.push_back(vtkAppendPolyData::New());
-    m_OdfsPlanes.push_back(vtkAppendPolyData::New());
+    m_OdfsPlanes.push_back(vtkSmartPointer<vtkPolyData>::New());
+    m_OdfsPlanes.push_back(vtkSmartPointer<vtkPolyData>::New());
+    m_OdfsPlanes.push_back(vtkSmartPointer<vtkPolyData>::New());
 
-    m_OdfsPlanes[0]->AddInputData(vtkPolyData::New());
-    m_OdfsPlanes[1]->AddInputData(vtkPolyData::New());
-    m_OdfsPlanes[2]->AddInputData(vtkPolyData::New());
+    m_GlyphCaches.resize(3);
 
     m_OdfsActors.push_back(vtkActor::New());
     m_OdfsActors.push_back(vtkActor::New());
@@ -130,51 +126,8 @@ mitk::OdfVtkMapper2D<T,N>::LocalStorage::LocalStorage()
 template<class T, int N>
 mitk::OdfVtkMapper2D<T,N>
 ::OdfVtkMapper2D()
+    : m_VtkImage(NULL)
 {
-
-    m_Planes.push_back(vtkPlane::New());
-    m_Planes.push_back(vtkPlane::New());
-    m_Planes.push_back(vtkPlane::New());
-
-    m_Cutters.push_back(vtkCutter::New());
-    m_Cutters.push_back(vtkCutter::New());
-    m_Cutters.push_back(vtkCutter::New());
-
-    m_Cutters[0]->SetCutFunction( m_Planes[0] );
-    m_Cutters[0]->GenerateValues( 1, 0, 1 );
-
-    m_Cutters[1]->SetCutFunction( m_Planes[1] );
-    m_Cutters[1]->GenerateValues( 1, 0, 1 );
-
-    m_Cutters[2]->SetCutFunction( m_Planes[2] );
-    m_Cutters[2]->GenerateValues( 1, 0, 1 );
-
-    // Windowing the cutted planes in direction 1
-    m_ThickPlanes1.push_back(vtkThickPlane::New());
-    m_ThickPlanes1.push_back(vtkThickPlane::New());
-    m_ThickPlanes1.push_back(vtkThickPlane::New());
-
-    m_Clippers1.push_back(vtkClipPolyData::New());
-    m_Clippers1.push_back(vtkClipPolyData::New());
-    m_Clippers1.push_back(vtkClipPolyData::New());
-
-    m_Clippers1[0]->SetClipFunction( m_ThickPlanes1[0] );
-    m_Clippers1[1]->SetClipFunction( m_ThickPlanes1[1] );
-    m_Clippers1[2]->SetClipFunction( m_ThickPlanes1[2] );
-
-    // Windowing the cutted planes in direction 2
-    m_ThickPlanes2.push_back(vtkThickPlane::New());
-    m_ThickPlanes2.push_back(vtkThickPlane::New());
-    m_ThickPlanes2.push_back(vtkThickPlane::New());
-
-    m_Clippers2.push_back(vtkClipPolyData::New());
-    m_Clippers2.push_back(vtkClipPolyData::New());
-    m_Clippers2.push_back(vtkClipPolyData::New());
-
-    m_Clippers2[0]->SetClipFunction( m_ThickPlanes2[0] );
-    m_Clippers2[1]->SetClipFunction( m_ThickPlanes2[1] );
-    m_Clippers2[2]->SetClipFunction( m_ThickPlanes2[2] );
-
     m_ShowMaxNumber = 500;
 }
 
@@ -216,75 +169,6 @@ int  mitk::OdfVtkMapper2D<T,N>
     return 0;
 }
 
-template<class T, int N>
-void  mitk::OdfVtkMapper2D<T,N>
-::GlyphMethod(void *arg)
-{
-    vtkMaskedProgrammableGlyphFilter* pfilter=(vtkMaskedProgrammableGlyphFilter*)arg;
-
-    double point[3];
-    double debugpoint[3];
-    pfilter->GetPoint(point);
-    pfilter->GetPoint(debugpoint);
-
-    itk::Point<double,3> p(point);
-    Vector3D spacing = pfilter->GetGeometry()->GetSpacing();
-    p[0] /= spacing[0];
-    p[1] /= spacing[1];
-    p[2] /= spacing[2];
-
-    mitk::Point3D p2;
-    pfilter->GetGeometry()->IndexToWorld( p, p2 );
-    point[0] = p2[0];
-    point[1] = p2[1];
-    point[2] = p2[2];
-
-    vtkPointData* data = pfilter->GetPointData();
-    vtkDataArray* odfvals = data->GetArray("vector");
-    vtkIdType id = pfilter->GetPointId();
-    m_OdfTransform->Identity();
-    m_OdfTransform->Translate(point[0],point[1],point[2]);
-
-    typedef itk::OrientationDistributionFunction<float,N> OdfType;
-    OdfType odf;
-
-    if(odfvals->GetNumberOfComponents()==6)
-    {
-        float tensorelems[6] = {
-            (float)odfvals->GetComponent(id,0),
-            (float)odfvals->GetComponent(id,1),
-            (float)odfvals->GetComponent(id,2),
-            (float)odfvals->GetComponent(id,3),
-            (float)odfvals->GetComponent(id,4),
-            (float)odfvals->GetComponent(id,5),
-        };
-        itk::DiffusionTensor3D<float> tensor(tensorelems);
-        odf.InitFromTensor(tensor);
-    }
-    else
-    {
-        for(int i=0; i<N; i++)
-            odf[i] = (double)odfvals->GetComponent(id,i);
-    }
-
-    switch(m_ScaleBy)
-    {
-    case ODFSB_NONE:
-        m_OdfSource->SetScale(m_Scaling);
-        break;
-    case ODFSB_GFA:
-        m_OdfSource->SetScale(m_Scaling*odf.GetGeneralizedGFA(m_IndexParam1, m_IndexParam2));
-        break;
-    case ODFSB_PC:
-        m_OdfSource->SetScale(m_Scaling*odf.GetPrincipleCurvature(m_IndexParam1, m_IndexParam2, 0));
-        break;
-    }
-
-    m_OdfSource->SetNormalization(m_Normalization);
-    m_OdfSource->SetOdf(odf);
-    m_OdfSource->Modified();
-}
-
 template<class T, int N>
 typename mitk::OdfVtkMapper2D<T,N>::OdfDisplayGeometry mitk::OdfVtkMapper2D<T,N>
 ::MeasureDisplayedGeometry(mitk::BaseRenderer* renderer)
@@ -383,6 +267,112 @@ typename mitk::OdfVtkMapper2D<T,N>::OdfDisplayGeometry mitk::OdfVtkMapper2D<T,N>
     return retval;
 }
 
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::InitializeBaseMesh()
+{
+    if (!m_BaseMeshDirections.empty())
+        return;
+
+    typedef itk::OrientationDistributionFunction<float,N> OdfType;
+    vtkPolyData* baseMesh = OdfType::GetBaseMesh();
+
+    m_BaseMeshDirections.resize(3*N);
+    for(int i=0; i<N; i++)
+        baseMesh->GetPoints()->GetPoint(i, &m_BaseMeshDirections[3*i]);
+
+    m_BaseMeshCells.clear();
+    m_BaseMeshNumberOfCells = 0;
+    vtkIdType npts; vtkIdType *pts;
+    vtkCellArray* polys = baseMesh->GetPolys();
+    polys->InitTraversal();
+    while(polys->GetNextCell(npts,pts))
+    {
+        m_BaseMeshCells.push_back(npts);
+        for(int i=0; i<npts; i++)
+            m_BaseMeshCells.push_back(pts[i]);
+        m_BaseMeshNumberOfCells++;
+    }
+}
+
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::ComputeGlyph(vtkIdType pointId, OdfGlyphCache& cache, int slot)
+{
+    vtkDataArray* odfvals = m_VtkImage->GetPointData()->GetArray("vector");
+
+    typedef itk::OrientationDistributionFunction<float,N> OdfType;
+    OdfType odf;
+
+    if(odfvals->GetNumberOfComponents()==6)
+    {
+        float tensorelems[6] = {
+            (float)odfvals->GetComponent(pointId,0),
+            (float)odfvals->GetComponent(pointId,1),
+            (float)odfvals->GetComponent(pointId,2),
+            (float)odfvals->GetComponent(pointId,3),
+            (float)odfvals->GetComponent(pointId,4),
+            (float)odfvals->GetComponent(pointId,5),
+        };
+        itk::DiffusionTensor3D<float> tensor(tensorelems);
+        odf.InitFromTensor(tensor);
+    }
+    else
+    {
+        for(int i=0; i<N; i++)
+            odf[i] = (double)odfvals->GetComponent(pointId,i);
+    }
+
+    double scale = 1;
+    switch(m_ScaleBy)
+    {
+    case ODFSB_NONE:
+        break;
+    case ODFSB_GFA:
+        scale = odf.GetGeneralizedGFA(m_IndexParam1, m_IndexParam2);
+        break;
+    case ODFSB_PC:
+        scale = odf.GetPrincipleCurvature(m_IndexParam1, m_IndexParam2, 0);
+        break;
+    }
+
+    OdfType colorOdf;
+    switch(m_Normalization)
+    {
+    case ODFN_MINMAX:
+        odf = odf.MinMaxNormalize();
+        colorOdf = odf;
+        break;
+    case ODFN_MAX:
+        odf = odf.MaxNormalize();
+        colorOdf = odf;
+        break;
+    case ODFN_NONE:
+        colorOdf = odf.MaxNormalize();
+        break;
+    default:
+        odf = odf.MinMaxNormalize();
+        colorOdf = odf;
+    }
+
+    float* radii = &cache.radii[slot*N];
+    for(int i=0; i<N; i++)
+        radii[i] = odf[i]*scale;
+
+    // cells are colored by the mean of their vertices
+    float* colors = &cache.colors[slot*m_BaseMeshNumberOfCells];
+    const vtkIdType* cell = &m_BaseMeshCells[0];
+    for(int c=0; c<m_BaseMeshNumberOfCells; c++)
+    {
+        vtkIdType npts = *cell++;
+        double val = 0;
+        for(int i=0; i<npts; i++)
+            val += colorOdf.GetElement(*cell++);
+        val /= npts;
+        colors[c] = 1-val;
+    }
+}
+
 template<class T, int N>
 void  mitk::OdfVtkMapper2D<T,N>
 ::Slice(mitk::BaseRenderer* renderer, OdfDisplayGeometry dispGeo)
@@ -407,223 +397,185 @@ void  mitk::OdfVtkMapper2D<T,N>
     // vtk works in axis align coords
     // thus the normal also must be axis align, since
     // we do not allow arbitrary cutting through volume
-    //
-    // vnormal should already be axis align, but in order
-    // to get rid of precision effects, we set the two smaller
-    // components to zero here
     int dims[3];
     m_VtkImage->GetDimensions(dims);
     double spac[3];
     m_VtkImage->GetSpacing(spac);
-    if(fabs(dispGeo.vnormal[0]) > fabs(dispGeo.vnormal[1])
-            && fabs(dispGeo.vnormal[0]) > fabs(dispGeo.vnormal[2]) )
-    {
-        if(fabs(dispGeo.vp[0]/spac[0]) < 0.4)
-            dispGeo.vp[0] = 0.4*spac[0];
-        if(fabs(dispGeo.vp[0]/spac[0]) > (dims[0]-1)-0.4)
-            dispGeo.vp[0] = ((dims[0]-1)-0.4)*spac[0];
-        dispGeo.vnormal[1] = 0;
-        dispGeo.vnormal[2] = 0;
-    }
 
-    if(fabs(dispGeo.vnormal[1]) > fabs(dispGeo.vnormal[0]) && fabs(dispGeo.vnormal[1]) > fabs(dispGeo.vnormal[2]) )
+    int axis = 0;
+    if(fabs(dispGeo.vnormal[1]) > fabs(dispGeo.vnormal[axis]))
+        axis = 1;
+    if(fabs(dispGeo.vnormal[2]) > fabs(dispGeo.vnormal[axis]))
+        axis = 2;
+    const int axis1 = (axis+1)%3;
+    const int axis2 = (axis+2)%3;
+
+    // the glyphs are placed on the plane, showing the ODFs of the closest voxels
+    double slicePosition = 0;
+    if(dims[axis]>1)
     {
-        if(fabs(dispGeo.vp[1]/spac[1]) < 0.4)
-            dispGeo.vp[1] = 0.4*spac[1];
-        if(fabs(dispGeo.vp[1]/spac[1]) > (dims[1]-1)-0.4)
-            dispGeo.vp[1] = ((dims[1]-1)-0.4)*spac[1];
-        dispGeo.vnormal[0] = 0;
-        dispGeo.vnormal[2] = 0;
+        slicePosition = dispGeo.vp[axis]/spac[axis];
+        if(fabs(slicePosition) < 0.4)
+            slicePosition = 0.4;
+        if(fabs(slicePosition) > (dims[axis]-1)-0.4)
+            slicePosition = (dims[axis]-1)-0.4;
     }
-
-    if(fabs(dispGeo.vnormal[2]) > fabs(dispGeo.vnormal[1]) && fabs(dispGeo.vnormal[2]) > fabs(dispGeo.vnormal[0]) )
+    int slice = (int)(slicePosition+0.5);
+    slice = std::max(0, std::min(dims[axis]-1, slice));
+
+    //  WINDOWING HERE
+    // only voxels inside of the displayed rectangle are shown
+    double center[3] = { dispGeo.M3D[0], dispGeo.M3D[1], dispGeo.M3D[2] };
+    double vertical[3] = { dispGeo.M3D[0]-dispGeo.O3D[0], dispGeo.M3D[1]-dispGeo.O3D[1], dispGeo.M3D[2]-dispGeo.O3D[2] };
+    double horizontal[3] = { dispGeo.M3D[0]-dispGeo.L3D[0], dispGeo.M3D[1]-dispGeo.L3D[1], dispGeo.M3D[2]-dispGeo.L3D[2] };
+    vtkMath::Normalize(vertical);
+    vtkMath::Normalize(horizontal);
+    inversetransform->TransformPoint( center, center );
+    inversetransform->TransformNormalAtPoint( center, vertical, vertical );
+    inversetransform->TransformNormalAtPoint( center, horizontal, horizontal );
+
+    std::vector< int > visibleVoxels;
+    double p[3];
+    p[axis] = slicePosition*spac[axis];
+    for(int v=0; v<dims[axis2]; v++)
     {
-        if(fabs(dispGeo.vp[2]/spac[2]) < 0.4)
-            dispGeo.vp[2] = 0.4*spac[2];
-        if(fabs(dispGeo.vp[2]/spac[2]) > (dims[2]-1)-0.4)
-            dispGeo.vp[2] = ((dims[2]-1)-0.4)*spac[2];
-        dispGeo.vnormal[0] = 0;
-        dispGeo.vnormal[1] = 0;
+        p[axis2] = v*spac[axis2];
+        for(int u=0; u<dims[axis1]; u++)
+        {
+            p[axis1] = u*spac[axis1];
+            double d[3] = { p[0]-center[0], p[1]-center[1], p[2]-center[2] };
+            if(fabs(vtkMath::Dot(d, vertical)) <= dispGeo.d2 && fabs(vtkMath::Dot(d, horizontal)) <= dispGeo.d1)
+                visibleVoxels.push_back(u + v*dims[axis1]);
+        }
     }
 
-
-    m_Planes[index]->SetTransform( (vtkAbstractTransform*)NULL );
-    m_Planes[index]->SetOrigin( dispGeo.vp );
-    m_Planes[index]->SetNormal( dispGeo.vnormal );
-
-    vtkSmartPointer<vtkPoints> points;
-    vtkSmartPointer<vtkPoints> tmppoints;
-    vtkSmartPointer<vtkPolyData> polydata;
-    vtkSmartPointer<vtkFloatArray> pointdata;
-    vtkSmartPointer<vtkDelaunay2D> delaunay;
-    vtkSmartPointer<vtkPolyData> cuttedPlane;
-
-    // the cutter only works if we do not have a 2D-image
-    // or if we have a 2D-image and want to see the whole image.
-    //
-    // for side views of 2D-images, we need some special treatment
-    if(!( (dims[0] == 1 && dispGeo.vnormal[0] != 0) ||
-          (dims[1] == 1 && dispGeo.vnormal[1] != 0) ||
-          (dims[2] == 1 && dispGeo.vnormal[2] != 0) ))
+    // level of detail: show every n-th voxel in both directions if too many voxels are visible
+    int stride = 1;
+    if(m_ShowMaxNumber>0)
+        while((double)visibleVoxels.size()/(stride*stride) > m_ShowMaxNumber)
+            stride++;
+
+    // drop the cached glyphs if the slice or the ODF data changed
+    InitializeBaseMesh();
+    OdfGlyphCache& cache = localStorage->m_GlyphCaches[index];
+    unsigned long imageMTime = this->GetInput()->GetMTime();
+    if( cache.image!=m_VtkImage || cache.imageMTime!=imageMTime || cache.axis!=axis || cache.slice!=slice
+            || cache.normalization!=m_Normalization || cache.scaleBy!=m_ScaleBy
+            || cache.indexParam1!=m_IndexParam1 || cache.indexParam2!=m_IndexParam2 )
     {
-        m_Cutters[index]->SetCutFunction( m_Planes[index] );
-        m_Cutters[index]->SetInputData( m_VtkImage );
-        m_Cutters[index]->Update();
-        cuttedPlane = m_Cutters[index]->GetOutput();
+        cache.image = m_VtkImage;
+        cache.imageMTime = imageMTime;
+        cache.axis = axis;
+        cache.slice = slice;
+        cache.normalization = m_Normalization;
+        cache.scaleBy = m_ScaleBy;
+        cache.indexParam1 = m_IndexParam1;
+        cache.indexParam2 = m_IndexParam2;
+        cache.slots.assign(dims[axis1]*dims[axis2], -1);
+        cache.radii.clear();
+        cache.colors.clear();
+        cache.numberOfSlots = 0;
     }
-    else
+
+    std::vector< int > glyphVoxels;
+    for(unsigned int i=0; i<visibleVoxels.size(); i++)
     {
-        // cutting of a 2D-Volume does not work,
-        // so we have to build up our own polydata object
-        cuttedPlane = vtkPolyData::New();
-        points = vtkPoints::New();
-        points->SetNumberOfPoints(m_VtkImage->GetNumberOfPoints());
-        for(int i=0; i<m_VtkImage->GetNumberOfPoints(); i++)
-        {
-            points->SetPoint(i, m_VtkImage->GetPoint(i));
-        }
-        cuttedPlane->SetPoints(points);
-
-        pointdata = vtkFloatArray::New();
-        int comps  = m_VtkImage->GetPointData()->GetScalars()->GetNumberOfComponents();
-        pointdata->SetNumberOfComponents(comps);
-        int tuples = m_VtkImage->GetPointData()->GetScalars()->GetNumberOfTuples();
-        pointdata->SetNumberOfTuples(tuples);
-        for(int i=0; i<tuples; i++)
-            pointdata->SetTuple(i,m_VtkImage->GetPointData()->GetScalars()->GetTuple(i));
-        pointdata->SetName( "vector" );
-        cuttedPlane->GetPointData()->AddArray(pointdata);
-
-        int nZero1, nZero2;
-        if(dims[0]==1)
-        {
-            nZero1 = 1; nZero2 = 2;
-        }
-        else if(dims[1]==1)
+        int u = visibleVoxels[i] % dims[axis1];
+        int v = visibleVoxels[i] / dims[axis1];
+        if(u%stride!=0 || v%stride!=0)
+            continue;
+        glyphVoxels.push_back(visibleVoxels[i]);
+
+        if(cache.slots[visibleVoxels[i]]<0)
         {
-            nZero1 = 0; nZero2 = 2;
+            int slot = cache.numberOfSlots++;
+            cache.slots[visibleVoxels[i]] = slot;
+            cache.radii.resize(cache.numberOfSlots*N);
+            cache.colors.resize(cache.numberOfSlots*m_BaseMeshNumberOfCells);
+
+            int voxel[3];
+            voxel[axis] = slice;
+            voxel[axis1] = u;
+            voxel[axis2] = v;
+            ComputeGlyph(voxel[0] + dims[0]*(voxel[1] + dims[1]*voxel[2]), cache, slot);
         }
-        else
+    }
+
+    // assemble the glyphs, all of them share the cells of the base mesh
+    const int numGlyphs = glyphVoxels.size();
+    const int cellSize = m_BaseMeshCells.size();
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(numGlyphs*N);
+    vtkSmartPointer<vtkIdTypeArray> cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellIds->SetNumberOfValues(numGlyphs*cellSize);
+    vtkSmartPointer<vtkDoubleArray> colors = vtkSmartPointer<vtkDoubleArray>::New();
+    colors->SetNumberOfValues(numGlyphs*m_BaseMeshNumberOfCells);
+
+    const double glyphScale = m_Scaling*GetMinImageSpacing(index)*0.5;
+    mitk::BaseGeometry* geometry = this->GetDataNode()->GetData()->GetGeometry();
+    for(int g=0; g<numGlyphs; g++)
+    {
+        int voxel = glyphVoxels[g];
+        int slot = cache.slots[voxel];
+
+        mitk::Point3D glyphIndex, glyphCenter;
+        glyphIndex[axis] = slicePosition;
+        glyphIndex[axis1] = voxel % dims[axis1];
+        glyphIndex[axis2] = voxel / dims[axis1];
+        geometry->IndexToWorld(glyphIndex, glyphCenter);
+
+        const float* radii = &cache.radii[slot*N];
+        for(int i=0; i<N; i++)
         {
-            nZero1 = 0; nZero2 = 1;
+            double r = radii[i]*glyphScale;
+            points->SetPoint(g*N+i,
+                             glyphCenter[0] + m_BaseMeshDirections[3*i]*r,
+                             glyphCenter[1] + m_BaseMeshDirections[3*i+1]*r,
+                             glyphCenter[2] + m_BaseMeshDirections[3*i+2]*r);
         }
 
-        tmppoints = vtkPoints::New();
-        for(int j=0; j<m_VtkImage->GetNumberOfPoints(); j++){
-            double pt[3];
-            m_VtkImage->GetPoint(j,pt);
-            tmppoints->InsertNextPoint(pt[nZero1],pt[nZero2],0);
+        vtkIdType* ids = cellIds->GetPointer(g*cellSize);
+        for(int c=0; c<cellSize; )
+        {
+            vtkIdType npts = m_BaseMeshCells[c];
+            ids[c] = npts;
+            c++;
+            for(int i=0; i<npts; i++, c++)
+                ids[c] = m_BaseMeshCells[c] + g*N;
         }
 
-        polydata = vtkPolyData::New();
-        polydata->SetPoints( tmppoints );
-        delaunay = vtkDelaunay2D::New();
-        delaunay->SetInputData( polydata );
-        delaunay->Update();
-        vtkCellArray* polys = delaunay->GetOutput()->GetPolys();
-        cuttedPlane->SetPolys(polys);
+        const float* glyphColors = &cache.colors[slot*m_BaseMeshNumberOfCells];
+        for(int c=0; c<m_BaseMeshNumberOfCells; c++)
+            colors->SetValue(g*m_BaseMeshNumberOfCells+c, glyphColors[c]);
     }
 
-    if(cuttedPlane->GetNumberOfPoints())
+    vtkSmartPointer<vtkPolyData> glyphs = vtkSmartPointer<vtkPolyData>::New();
+    if(numGlyphs>0)
     {
-        //  WINDOWING HERE
-        inversetransform = vtkTransform::New();
-        inversetransform->Identity();
-        inversetransform->Concatenate(vtktransform->GetLinearInverse());
-        double myscale[3];
-        ((vtkTransform*)vtktransform)->GetScale(myscale);
-        inversetransform->PostMultiply();
-        inversetransform->Scale(1*myscale[0],1*myscale[1],1*myscale[2]);
-
-        dispGeo.vnormal[0] = dispGeo.M3D[0]-dispGeo.O3D[0];
-        dispGeo.vnormal[1] = dispGeo.M3D[1]-dispGeo.O3D[1];
-        dispGeo.vnormal[2] = dispGeo.M3D[2]-dispGeo.O3D[2];
-        vtkMath::Normalize(dispGeo.vnormal);
-        dispGeo.vp[0] = dispGeo.M3D[0];
-        dispGeo.vp[1] = dispGeo.M3D[1];
-        dispGeo.vp[2] = dispGeo.M3D[2];
-
-        inversetransform->TransformPoint( dispGeo.vp, dispGeo.vp );
-        inversetransform->TransformNormalAtPoint( dispGeo.vp, dispGeo.vnormal, dispGeo.vnormal );
-
-        m_ThickPlanes1[index]->count = 0;
-        m_ThickPlanes1[index]->SetTransform((vtkAbstractTransform*)NULL );
-        m_ThickPlanes1[index]->SetPose( dispGeo.vnormal, dispGeo.vp );
-        m_ThickPlanes1[index]->SetThickness(dispGeo.d2);
-        m_Clippers1[index]->SetClipFunction( m_ThickPlanes1[index] );
-        m_Clippers1[index]->SetInputData( cuttedPlane );
-        m_Clippers1[index]->SetInsideOut(1);
-        m_Clippers1[index]->Update();
-
-        dispGeo.vnormal[0] = dispGeo.M3D[0]-dispGeo.L3D[0];
-        dispGeo.vnormal[1] = dispGeo.M3D[1]-dispGeo.L3D[1];
-        dispGeo.vnormal[2] = dispGeo.M3D[2]-dispGeo.L3D[2];
-        vtkMath::Normalize(dispGeo.vnormal);
-        dispGeo.vp[0] = dispGeo.M3D[0];
-        dispGeo.vp[1] = dispGeo.M3D[1];
-        dispGeo.vp[2] = dispGeo.M3D[2];
-
-        inversetransform->TransformPoint( dispGeo.vp, dispGeo.vp );
-        inversetransform->TransformNormalAtPoint( dispGeo.vp, dispGeo.vnormal, dispGeo.vnormal );
-
-        m_ThickPlanes2[index]->count = 0;
-        m_ThickPlanes2[index]->SetTransform((vtkAbstractTransform*)NULL );
-        m_ThickPlanes2[index]->SetPose( dispGeo.vnormal, dispGeo.vp );
-        m_ThickPlanes2[index]->SetThickness(dispGeo.d1);
-        m_Clippers2[index]->SetClipFunction( m_ThickPlanes2[index] );
-        m_Clippers2[index]->SetInputData( m_Clippers1[index]->GetOutput() );
-        m_Clippers2[index]->SetInsideOut(1);
-        m_Clippers2[index]->Update();
-
-        cuttedPlane = m_Clippers2[index]->GetOutput ();
-
-        if(cuttedPlane->GetNumberOfPoints())
-        {
-            localStorage->m_OdfsPlanes[index]->RemoveAllInputs();
-
-            vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-            normals->SetInputConnection( m_OdfSource->GetOutputPort() );
-            normals->SplittingOff();
-            normals->ConsistencyOff();
-            normals->AutoOrientNormalsOff();
-            normals->ComputePointNormalsOn();
-            normals->ComputeCellNormalsOff();
-            normals->FlipNormalsOff();
-            normals->NonManifoldTraversalOff();
-
-            vtkSmartPointer<vtkTransformPolyDataFilter> trans = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-            trans->SetInputConnection( normals->GetOutputPort() );
-            trans->SetTransform(m_OdfTransform);
-
-            vtkSmartPointer<vtkMaskedProgrammableGlyphFilter> glyphGenerator = vtkSmartPointer<vtkMaskedProgrammableGlyphFilter>::New();
-            glyphGenerator->SetMaximumNumberOfPoints(std::min(m_ShowMaxNumber,(int)cuttedPlane->GetNumberOfPoints()));
-            glyphGenerator->SetRandomMode(1);
-            glyphGenerator->SetUseMaskPoints(1);
-            glyphGenerator->SetSourceConnection(trans->GetOutputPort() );
-            glyphGenerator->SetInput(cuttedPlane);
-            glyphGenerator->SetColorModeToColorBySource();
-            glyphGenerator->SetInputArrayToProcess(0,0,0, vtkDataObject::FIELD_ASSOCIATION_POINTS , "vector");
-            glyphGenerator->SetGeometry(this->GetDataNode()->GetData()->GetGeometry());
-            glyphGenerator->SetGlyphMethod(&(GlyphMethod),(void *)glyphGenerator);
-
-            try
-            {
-                glyphGenerator->Update();
-            }
-            catch( itk::ExceptionObject& err )
-            {
-                std::cout << err << std::endl;
-            }
-
-            localStorage->m_OdfsPlanes[index]->AddInputConnection(glyphGenerator->GetOutputPort());
-
-            localStorage->m_OdfsPlanes[index]->Update();
-        }
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+        polys->SetCells(numGlyphs*m_BaseMeshNumberOfCells, cellIds);
+        glyphs->SetPoints(points);
+        glyphs->SetPolys(polys);
+        glyphs->GetCellData()->SetScalars(colors);
+
+        vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+        normals->SetInputData( glyphs );
+        normals->SplittingOff();
+        normals->ConsistencyOff();
+        normals->AutoOrientNormalsOff();
+        normals->ComputePointNormalsOn();
+        normals->ComputeCellNormalsOff();
+        normals->FlipNormalsOff();
+        normals->NonManifoldTraversalOff();
+        normals->Update();
+        glyphs = normals->GetOutput();
     }
+    localStorage->m_OdfsPlanes[index]->ShallowCopy(glyphs);
+
     localStorage->m_PropAssemblies[index]->VisibilityOn();
     if(localStorage->m_PropAssemblies[index]->GetParts()->IsItemPresent(localStorage->m_OdfsActors[index]))
         localStorage->m_PropAssemblies[index]->RemovePart(localStorage->m_OdfsActors[index]);
-    localStorage->m_OdfsMappers[index]->SetInputData(localStorage->m_OdfsPlanes[index]->GetOutput());
+    localStorage->m_OdfsMappers[index]->SetInputData(localStorage->m_OdfsPlanes[index]);
     localStorage->m_PropAssemblies[index]->AddPart(localStorage->m_OdfsActors[index]);
 }
 
@@ -776,7 +728,6 @@ void  mitk::OdfVtkMapper2D<T,N>
         localStorage->m_OdfsActors[1]->VisibilityOn();
         localStorage->m_OdfsActors[2]->VisibilityOn();
 
-        m_OdfSource->SetAdditionalScale(GetMinImageSpacing(GetIndex(renderer)));
         ApplyPropertySettings();
         Slice(renderer, dispGeo);
         m_LastDisplayGeometry = dispGeo;
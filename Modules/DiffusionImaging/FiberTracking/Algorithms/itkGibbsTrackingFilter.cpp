@@ -30,6 +30,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkResampleImageFilter.h>
 #include <itkTimeProbe.h>
 
+// VTK
+
 // MISC
 #include <fstream>
 // #include <QFile>
@@ -64,6 +66,8 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
     m_NumParticles(0),
     m_NumConnections(0),
     m_RandomSeed(-1),
+    m_NumberOfChains(1),
+    m_ProposalsPerSecond(0),
     m_LoadParameterFile(""),
     m_LutPath(""),
     m_IsInValidState(true)
@@ -83,13 +87,24 @@ typename GibbsTrackingFilter< ItkQBallImageType >::FiberPolyDataType GibbsTracki
 {
     if (!m_AbortTracking)
     {
+        // the first chain builds the fibers, the intermediate result is kept once it finished
         m_BuildFibers = true;
-        while (m_BuildFibers){}
+        while (m_BuildFibers && m_CurrentStep<=m_Steps){}
     }
 
     return m_FiberPolyData;
 }
 
+template< class ItkQBallImageType >
+typename GibbsTrackingFilter< ItkQBallImageType >::FiberPolyDataType GibbsTrackingFilter< ItkQBallImageType >::GetChainFiberBundle(unsigned int chain)
+{
+    if (chain==0)
+        return GetFiberBundle();
+    if (chain<m_ChainFiberPolyData.size())
+        return m_ChainFiberPolyData.at(chain);
+    return nullptr;
+}
+
 template< class ItkQBallImageType >
 void
 GibbsTrackingFilter< ItkQBallImageType >
@@ -168,6 +183,7 @@ template< class ItkQBallImageType >
 void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
 {
     TimeProbe preClock; preClock.Start();
+    m_ChainFiberPolyData.clear();
     // check if input is qball or tensor image and generate qball if necessary
     if (m_QBallImage.IsNull() && m_TensorImage.IsNotNull())
     {
@@ -234,12 +250,21 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
         m_CurvatureThreshold = 0;
     unsigned long singleIts = (unsigned long)((1.0*m_Iterations) / (1.0*m_Steps));
 
-    // seed random generators
-    Statistics::MersenneTwisterRandomVariateGenerator::Pointer randGen = Statistics::MersenneTwisterRandomVariateGenerator::New();
-    if (m_RandomSeed>-1)
-        randGen->SetSeed(m_RandomSeed);
-    else
-        randGen->SetSeed();
+    unsigned int numChains = m_NumberOfChains>0 ? m_NumberOfChains : 1;
+
+    // seed random generators, one per chain
+    std::vector< Statistics::MersenneTwisterRandomVariateGenerator::Pointer > randGens;
+    for (unsigned int c=0; c<numChains; c++)
+    {
+        Statistics::MersenneTwisterRandomVariateGenerator::Pointer randGen = Statistics::MersenneTwisterRandomVariateGenerator::New();
+        if (m_RandomSeed>-1)
+            randGen->SetSeed(m_RandomSeed+c);
+        else if (c==0)
+            randGen->SetSeed();
+        else
+            randGen->SetSeed(randGens.at(0)->GetIntegerVariate());  // chains created within the same clock tick would get the same seed otherwise
+        randGens.push_back(randGen);
+    }
 
     // load sphere interpolator to evaluate the ODFs
     SphereInterpolator* interpolator = new SphereInterpolator(m_LutPath);
@@ -252,19 +277,35 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
       m_BuildFibers = false;
       mitkThrow() << "Unable to load lookup tables.";
     }
-    // initialize the actual tracking components (ParticleGrid, Metropolis Hastings Sampler and Energy Computer)
-    ParticleGrid* particleGrid;
-    GibbsEnergyComputer* encomp;
-    MetropolisHastingsSampler* sampler;
+
+    // initialize the actual tracking components (ParticleGrid, Metropolis Hastings Sampler and Energy Computer) of each chain
+    // the interpolator stores the last interpolation, so every chain works on its own copy
+    std::vector< SphereInterpolator* > interpolators(numChains, nullptr);
+    std::vector< ParticleGrid* > particleGrids(numChains, nullptr);
+    std::vector< GibbsEnergyComputer* > encomps(numChains, nullptr);
+    std::vector< MetropolisHastingsSampler* > samplers(numChains, nullptr);
+    interpolators.at(0) = interpolator;
     try{
-        particleGrid = new ParticleGrid(m_MaskImage, m_ParticleLength, m_ParticleGridCellCapacity);
-        encomp = new GibbsEnergyComputer(m_QBallImage, m_MaskImage, particleGrid, interpolator, randGen);
-        encomp->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
-        sampler = new MetropolisHastingsSampler(particleGrid, encomp, randGen, m_CurvatureThreshold);
+        for (unsigned int c=0; c<numChains; c++)
+        {
+            if (c>0)
+                interpolators.at(c) = new SphereInterpolator(*interpolator);
+            particleGrids.at(c) = new ParticleGrid(m_MaskImage, m_ParticleLength, m_ParticleGridCellCapacity);
+            encomps.at(c) = new GibbsEnergyComputer(m_QBallImage, m_MaskImage, particleGrids.at(c), interpolators.at(c), randGens.at(c));
+            encomps.at(c)->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
+            samplers.at(c) = new MetropolisHastingsSampler(particleGrids.at(c), encomps.at(c), randGens.at(c), m_CurvatureThreshold);
+        }
     }
     catch(...)
     {
-        MITK_ERROR  << "Particle grid allocation failed. Not enough memory? Try to increase the particle length.";
+        MITK_ERROR  << "Particle grid allocation failed. Not enough memory? Try to increase the particle length or to decrease the number of chains.";
+        for (unsigned int c=0; c<numChains; c++)
+        {
+            delete samplers.at(c);
+            delete encomps.at(c);
+            delete particleGrids.at(c);
+            delete interpolators.at(c);
+        }
         m_IsInValidState = false;
         m_AbortTracking = true;
         m_BuildFibers = false;
@@ -283,66 +324,109 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     MITK_INFO << "Min. fiber length: " << m_MinFiberLength;
     MITK_INFO << "Curvature threshold: " << m_CurvatureThreshold;
     MITK_INFO << "Random seed: " << m_RandomSeed;
+    MITK_INFO << "Chains: " << numChains;
     MITK_INFO << "----------------------------------------";
 
     // main loop
     preClock.Stop();
     TimeProbe clock; clock.Start();
     m_NumAcceptedFibers = 0;
-    unsigned long counter = 1;
+    std::vector< unsigned long > counters(numChains, 1);
 
+    // the first chain drives the progress display, the intermediate fibers and the statistics
     boost::progress_display disp(m_Steps*singleIts);
     if (!m_AbortTracking)
-    for( m_CurrentStep = 1; m_CurrentStep <= m_Steps; m_CurrentStep++ )
     {
-        // update temperatur for simulated annealing process
-        float temperature = m_StartTemperature * exp(alpha*(((1.0)*m_CurrentStep)/((1.0)*m_Steps)));
-        sampler->SetTemperature(temperature);
-
-        for (unsigned long i=0; i<singleIts; i++)
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int c=0; c<(int)numChains; c++)
         {
-            ++disp;
-            if (m_AbortTracking)
-                break;
-
-            sampler->MakeProposal();
+            MetropolisHastingsSampler* sampler = samplers.at(c);
+            ParticleGrid* particleGrid = particleGrids.at(c);
+            unsigned long& counter = counters.at(c);
 
-            if (m_BuildFibers || (i==singleIts-1 && m_CurrentStep==m_Steps))
+            for( unsigned long step = 1; step <= m_Steps; step++ )
             {
-                m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
-                m_NumParticles = particleGrid->m_NumParticles;
-                m_NumConnections = particleGrid->m_NumConnections;
-
-                FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-                m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-                m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
-                m_BuildFibers = false;
+                if (c==0)
+                    m_CurrentStep = step;
+
+                // update temperatur for simulated annealing process
+                float temperature = m_StartTemperature * exp(alpha*(((1.0)*step)/((1.0)*m_Steps)));
+                sampler->SetTemperature(temperature);
+
+                for (unsigned long i=0; i<singleIts; i++)
+                {
+                    if (c==0)
+                        ++disp;
+                    if (m_AbortTracking)
+                        break;
+
+                    sampler->MakeProposal();
+
+                    if (c==0 && m_BuildFibers)
+                    {
+#pragma omp critical (GibbsTrackingFilterBuildFibers)
+                        if (m_BuildFibers)
+                        {
+                            m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
+                            m_NumParticles = particleGrid->m_NumParticles;
+                            m_NumConnections = particleGrid->m_NumConnections;
+
+                            FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+                            m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                            m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                            m_BuildFibers = false;
+                        }
+                    }
+                    counter++;
+                }
+
+                if (c==0)
+                {
+#pragma omp critical (GibbsTrackingFilterBuildFibers)
+                    {
+                        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
+                        m_NumParticles = particleGrid->m_NumParticles;
+                        m_NumConnections = particleGrid->m_NumConnections;
+                    }
+                }
+
+                if (m_AbortTracking)
+                    break;
             }
-            counter++;
+            if (c==0 && !m_AbortTracking)
+                m_CurrentStep = m_Steps+1;
         }
-
-        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
-        m_NumParticles = particleGrid->m_NumParticles;
-        m_NumConnections = particleGrid->m_NumConnections;
-
-        if (m_AbortTracking)
-            break;
     }
-    if (m_AbortTracking)
+
+    // every chain is a complete tracking, its fibers are kept separately
+    unsigned long numProposals = 0;
+    m_ChainFiberPolyData.resize(numChains);
+    for (unsigned int c=0; c<numChains; c++)
     {
-        FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-        m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-        m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+        FiberBuilder fiberBuilder(particleGrids.at(c), m_MaskImage);
+        m_ChainFiberPolyData.at(c) = fiberBuilder.iterate(m_MinFiberLength);
+        numProposals += counters.at(c)-1;
     }
+    m_FiberPolyData = m_ChainFiberPolyData.at(0);
+    m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+    m_ProposalAcceptance = (float)samplers.at(0)->GetNumAcceptedProposals()/counters.at(0);
+    m_NumParticles = particleGrids.at(0)->m_NumParticles;
+    m_NumConnections = particleGrids.at(0)->m_NumConnections;
     clock.Stop();
 
-    delete sampler;
-    delete encomp;
-    delete interpolator;
-    delete particleGrid;
+    for (unsigned int c=0; c<numChains; c++)
+    {
+        delete samplers.at(c);
+        delete encomps.at(c);
+        delete interpolators.at(c);
+        delete particleGrids.at(c);
+    }
     m_AbortTracking = true;
     m_BuildFibers = false;
 
+    m_ProposalsPerSecond = clock.GetTotal()>0 ? numProposals/clock.GetTotal() : 0;
+    MITK_INFO << "GibbsTrackingFilter: " << numProposals << " proposals (" << m_ProposalsPerSecond << " proposals/s)";
+
     int h = clock.GetTotal()/3600;
     int m = ((int)clock.GetTotal()%3600)/60;
     int s = (int)clock.GetTotal()%60;
@@ -31,11 +31,18 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkCellArray.h>
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
+#include <vector>
 
 namespace itk{
 
 /**
-* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).   */
+* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).
+*
+* Several independent Markov chains can be sampled in parallel (see SetNumberOfChains). Each chain runs the complete
+* annealing schedule on its own particle grid and with its own random generator, seeded with the random seed plus the
+* chain index, so the result is reproducible for a fixed seed. Every chain is a complete tracking result and is not
+* merged with the others: GetFiberBundle() and the statistics refer to the first chain, which is the result of a single
+* chain run with the same seed, the other chains are returned by GetChainFiberBundle(). */
 
 template< class ItkQBallImageType >
 class GibbsTrackingFilter : public ProcessObject
@@ -70,6 +77,7 @@ public:
     itkSetMacro( CurvatureThreshold, float)         ///< Absolute angular threshold between two particles (in radians).
     itkSetMacro( DuplicateImage, bool )             ///< Work on copy of input image.
     itkSetMacro( RandomSeed, int )                  ///< Seed for random generator.
+    itkSetMacro( NumberOfChains, unsigned int )     ///< Number of independent chains sampled in parallel, each yields its own tractogram. Memory consumption grows linearly with the number of chains.
     itkSetMacro( LoadParameterFile, std::string )   ///< Parameter file.
     itkSetMacro( SaveParameterFile, std::string )
     itkSetMacro( LutPath, std::string )             ///< Path to lookuptables. Default is binary directory.
@@ -85,7 +93,10 @@ public:
     itkGetMacro( ProposalAcceptance, float )
     itkGetMacro( Steps, unsigned int)
     itkGetMacro( IsInValidState, bool)
-    FiberPolyDataType GetFiberBundle();             ///< Output fibers
+    itkGetMacro( NumberOfChains, unsigned int )
+    itkGetMacro( ProposalsPerSecond, float )        ///< Proposals of all chains per second of the last run.
+    FiberPolyDataType GetFiberBundle();             ///< Output fibers (of the first chain)
+    FiberPolyDataType GetChainFiberBundle(unsigned int chain);  ///< Output fibers of the given chain, available after the tracking finished
 
     /** Input images. */
     itkSetMacro(QBallImage, typename ItkQBallImageType::Pointer)
@@ -134,12 +145,15 @@ protected:
     int             m_NumParticles;         ///< current number of particles in grid
     int             m_NumConnections;       ///< current number of connections between particles in grid
     int             m_RandomSeed;           ///< seed value for random generator (-1 for standard seeding)
+    unsigned int    m_NumberOfChains;       ///< number of independent chains, chain i is seeded with m_RandomSeed+i
+    float           m_ProposalsPerSecond;   ///< sampling throughput of all chains
     std::string     m_LoadParameterFile;    ///< filename of parameter file (reader)
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
+    std::vector< FiberPolyDataType > m_ChainFiberPolyData;  ///< reconstructed fibers of every chain
 
     //Constant values
     static const int m_ParticleGridCellCapacity = 1024;
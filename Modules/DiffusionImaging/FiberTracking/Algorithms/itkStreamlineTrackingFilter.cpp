@@ -25,6 +25,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
+#include <vtkIdTypeArray.h>
+#include <algorithm>
+#include <cstring>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -53,6 +56,9 @@ TPDPixelType>
     , m_ResampleFibers(false)
     , m_SeedImage(NULL)
     , m_MaskImage(NULL)
+    , m_SeedBatchSize(64)
+    , m_NextSeed(0)
+    , m_StreamlinesPerSecond(0)
 {
     // At least 1 inputs is necessary for a vector image.
     // For images added one at a time we need at least six
@@ -105,12 +111,10 @@ TPDPixelType>
     if (m_ResampleFibers)
         m_PointPistance = 0.5*minSpacing;
 
-    m_PolyDataContainer = itk::VectorContainer< int, FiberPolyDataType >::New();
-    for (unsigned int i=0; i<this->GetNumberOfThreads(); i++)
-    {
-        FiberPolyDataType poly = FiberPolyDataType::New();
-        m_PolyDataContainer->InsertElement(i, poly);
-    }
+    m_ThreadPoints.clear();
+    m_ThreadPoints.resize(this->GetNumberOfThreads());
+    m_ThreadFiberSizes.clear();
+    m_ThreadFiberSizes.resize(this->GetNumberOfThreads());
 
     if (m_SeedImage.IsNull())
     {
@@ -208,6 +212,35 @@ TPDPixelType>
                     m_FaImage->SetPixel(index, m_FaImage->GetPixel(index)/m_NumberOfInputs);
             }
 
+    // neighbours used for trilinear interpolation: index, +x, +y, +z, +xy, +yz, +zx, +xyz
+    const OffsetValueType strideY = m_ImageSize[0];
+    const OffsetValueType strideZ = m_ImageSize[0]*m_ImageSize[1];
+    m_InterpolationOffsets[0] = 0;
+    m_InterpolationOffsets[1] = 1;
+    m_InterpolationOffsets[2] = strideY;
+    m_InterpolationOffsets[3] = strideZ;
+    m_InterpolationOffsets[4] = 1 + strideY;
+    m_InterpolationOffsets[5] = strideY + strideZ;
+    m_InterpolationOffsets[6] = strideZ + 1;
+    m_InterpolationOffsets[7] = 1 + strideY + strideZ;
+
+    // collect seed voxels in image order, the threads fetch them in batches
+    m_Seeds.clear();
+    ImageRegionConstIteratorWithIndex< ItkUcharImgType > sit(m_SeedImage, m_SeedImage->GetLargestPossibleRegion());
+    ImageRegionConstIterator< ItkFloatImgType > fit(m_FaImage, m_FaImage->GetLargestPossibleRegion());
+    ImageRegionConstIterator< ItkUcharImgType > mit(m_MaskImage, m_MaskImage->GetLargestPossibleRegion());
+    while( !sit.IsAtEnd() )
+    {
+        if (sit.Value()!=0 && fit.Value()>=m_FaThreshold && mit.Value()!=0)
+            m_Seeds.push_back(sit.GetIndex());
+        ++sit;
+        ++mit;
+        ++fit;
+    }
+    m_NextSeed = 0;
+    if (m_SeedBatchSize<1)
+        m_SeedBatchSize = 1;
+
     if (m_Interpolate)
         std::cout << "StreamlineTrackingFilter: using trilinear interpolation" << std::endl;
     else
@@ -226,7 +259,11 @@ TPDPixelType>
     std::cout << "StreamlineTrackingFilter: stepsize: " << m_StepSize << " mm" << std::endl;
     std::cout << "StreamlineTrackingFilter: f: " << m_F << std::endl;
     std::cout << "StreamlineTrackingFilter: g: " << m_G << std::endl;
+    std::cout << "StreamlineTrackingFilter: seed voxels: " << m_Seeds.size() << std::endl;
     std::cout << "StreamlineTrackingFilter: starting streamline tracking using " << this->GetNumberOfThreads() << " threads." << std::endl;
+
+    m_TrackingClock.Reset();
+    m_TrackingClock.Start();
 }
 
 template< class TTensorPixelType, class TPDPixelType>
@@ -427,31 +464,24 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         if (index[2] < 0 || index[2] >= m_ImageSize[2]-1)
             return false;
 
-        interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[3] = (  frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[4] = (1-frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[5] = (  frac_x)*(1-frac_y)*(1-frac_z);
-        interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
-
-        typename InputImageType::IndexType tmpIdx;
-        double FA = m_FaImage->GetPixel(index) * interpWeights[0];
-        tmpIdx = index; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[1];
-        tmpIdx = index; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[2];
-        tmpIdx = index; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[3];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[4];
-        tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[5];
-        tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[6];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[7];
+        // the xy products are shared by both z layers
+        const double xy[4] = { (  frac_x)*(  frac_y),
+                               (1-frac_x)*(  frac_y),
+                               (  frac_x)*(1-frac_y),
+                               (1-frac_x)*(1-frac_y) };
+        interpWeights[0] = xy[0]*(  frac_z);
+        interpWeights[1] = xy[1]*(  frac_z);
+        interpWeights[2] = xy[2]*(  frac_z);
+        interpWeights[3] = xy[0]*(1-frac_z);
+        interpWeights[4] = xy[3]*(  frac_z);
+        interpWeights[5] = xy[2]*(1-frac_z);
+        interpWeights[6] = xy[1]*(1-frac_z);
+        interpWeights[7] = xy[3]*(1-frac_z);
+
+        const float* fa = m_FaImage->GetBufferPointer() + m_FaImage->ComputeOffset(index);
+        double FA = fa[m_InterpolationOffsets[0]] * interpWeights[0];
+        for (int i=1; i<8; i++)
+            FA += fa[m_InterpolationOffsets[i]] * interpWeights[i];
 
         if (FA<m_FaThreshold)
             return false;
@@ -464,7 +494,7 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 
 template< class TTensorPixelType, class TPDPixelType>
 double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
-::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx)
+::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< float >& points, int imageIdx)
 {
     double tractLength = 0;
     typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
@@ -507,7 +537,9 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
             tractLength +=  m_StepSize;
             distanceInVoxel += m_StepSize;
             m_SeedImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.push_back(worldPos[0]);
+            points.push_back(worldPos[1]);
+            points.push_back(worldPos[2]);
             distance = 0;
         }
 
@@ -675,21 +707,10 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
             }
             else
             {
-                tensor = m_InputImage.at(0)->GetPixel(index) * interpWeights[0];
-                typename InputImageType::IndexType tmpIdx = index; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[1];
-                tmpIdx = index; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[2];
-                tmpIdx = index; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[3];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[4];
-                tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[5];
-                tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[6];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[7];
+                const typename InputImageType::PixelType* tensors = m_InputImage.at(0)->GetBufferPointer() + m_InputImage.at(0)->ComputeOffset(index);
+                tensor = tensors[m_InterpolationOffsets[0]] * interpWeights[0];
+                for (int i=1; i<8; i++)
+                    tensor += tensors[m_InterpolationOffsets[i]] * interpWeights[i];
             }
 
             tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
@@ -733,46 +754,34 @@ template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+::ThreadedGenerateData(const OutputImageRegionType&,
                        ThreadIdType threadId)
 {
-    FiberPolyDataType poly = m_PolyDataContainer->GetElement(threadId);
-    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> Cells = vtkSmartPointer<vtkCellArray>::New();
-
-    typedef itk::DiffusionTensor3D<TTensorPixelType>        TensorType;
-    typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-    typedef ImageRegionConstIterator< ItkUcharImgType >     MaskIteratorType;
-    typedef ImageRegionConstIterator< ItkFloatImgType >     doubleIteratorType;
-    typedef typename InputImageType::PixelType              InputTensorType;
-
-    MaskIteratorType    sit(m_SeedImage, outputRegionForThread );
-    doubleIteratorType   fit(m_FaImage, outputRegionForThread );
-    MaskIteratorType    mit(m_MaskImage, outputRegionForThread );
+    // the output region is ignored, the seeds are distributed in batches instead
+    std::vector< float >& points = m_ThreadPoints.at(threadId);
+    std::vector< vtkIdType >& fiberSizes = m_ThreadFiberSizes.at(threadId);
+    const unsigned long numSeeds = m_Seeds.size()*m_NumberOfInputs;
+    itk::Point<double> worldPos;
 
-    for (int img=0; img<m_NumberOfInputs; img++)
+    while (true)
     {
-        sit.GoToBegin();
-        mit.GoToBegin();
-        fit.GoToBegin();
-        itk::Point<double> worldPos;
-        while( !sit.IsAtEnd() )
+        m_Mutex.Lock();
+        unsigned long firstSeed = m_NextSeed;
+        m_NextSeed += m_SeedBatchSize;
+        m_Mutex.Unlock();
+        if (firstSeed>=numSeeds)
+            break;
+        unsigned long lastSeed = std::min(firstSeed+m_SeedBatchSize, numSeeds);
+
+        for (unsigned long seed=firstSeed; seed<lastSeed; seed++)
         {
-            if (sit.Value()==0 || fit.Value()<m_FaThreshold || mit.Value()==0)
-            {
-                ++sit;
-                ++mit;
-                ++fit;
-                continue;
-            }
+            int img = seed/m_Seeds.size();
+            const typename InputImageType::IndexType& index = m_Seeds.at(seed%m_Seeds.size());
 
             for (int s=0; s<m_SeedsPerVoxel; s++)
             {
-                vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
-                std::vector< vtkIdType > pointIDs;
-                typename InputImageType::IndexType index = sit.GetIndex();
+                const std::size_t lineStart = points.size();
                 itk::ContinuousIndex<double, 3> start;
-                unsigned int counter = 0;
 
                 if (m_SeedsPerVoxel>1)
                 {
@@ -787,94 +796,83 @@ TPDPixelType>
                     start[2] = index[2];
                 }
 
-                // forward tracking
-                double tractLength = FollowStreamline(start, 1, points, pointIDs, img);
-
-                // add ids to line
-                counter += pointIDs.size();
-                while (!pointIDs.empty())
-                {
-                    line->GetPointIds()->InsertNextId(pointIDs.back());
-                    pointIDs.pop_back();
-                }
+                // forward tracking, the points are reversed so that the line starts at the forward end
+                double tractLength = FollowStreamline(start, 1, points, img);
+                const std::size_t numForward = (points.size()-lineStart)/3;
+                for (std::size_t i=0; i<numForward/2; i++)
+                    std::swap_ranges(points.begin()+lineStart+3*i, points.begin()+lineStart+3*i+3, points.begin()+lineStart+3*(numForward-1-i));
 
                 // insert start point
                 m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
-                line->GetPointIds()->InsertNextId(points->InsertNextPoint(worldPos.GetDataPointer()));
+                points.push_back(worldPos[0]);
+                points.push_back(worldPos[1]);
+                points.push_back(worldPos[2]);
 
                 // backward tracking
-                tractLength += FollowStreamline(start, -1, points, pointIDs, img);
-
-                counter += pointIDs.size();
+                tractLength += FollowStreamline(start, -1, points, img);
 
-                //MITK_INFO << "Tract length " << tractLength;
-
-                if (tractLength<m_MinTractLength || counter<2)
+                // at least two points besides the start point
+                const std::size_t numPoints = (points.size()-lineStart)/3;
+                if (tractLength<m_MinTractLength || numPoints<3)
+                {
+                    points.resize(lineStart);
                     continue;
-
-                // add ids to line
-                for (unsigned int i=0; i<pointIDs.size(); i++)
-                    line->GetPointIds()->InsertNextId(pointIDs.at(i));
-
-                Cells->InsertNextCell(line);
+                }
+                fiberSizes.push_back(numPoints);
             }
-            ++sit;
-            ++mit;
-            ++fit;
         }
     }
-    poly->SetPoints(points);
-    poly->SetLines(Cells);
 
     std::cout << "Thread " << threadId << " finished tracking" << std::endl;
 }
 
 template< class TTensorPixelType,
           class TPDPixelType>
-vtkSmartPointer< vtkPolyData > StreamlineTrackingFilter< TTensorPixelType,
+void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2)
+::AfterThreadedGenerateData()
 {
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = poly1->GetLines();
-    vtkSmartPointer<vtkPoints> vNewPoints = poly1->GetPoints();
+    m_TrackingClock.Stop();
+
+    MITK_INFO << "Generating polydata ";
+    vtkIdType numPoints = 0;
+    vtkIdType numFibers = 0;
+    for (unsigned int t=0; t<m_ThreadPoints.size(); t++)
+    {
+        numPoints += m_ThreadPoints.at(t).size()/3;
+        numFibers += m_ThreadFiberSizes.at(t).size();
+    }
 
-    for( int i=0; i<poly2->GetNumberOfLines(); i++ )
+    // the thread buffers are appended in thread order, each with a single copy
+    m_Points->SetNumberOfPoints(numPoints);
+    vtkSmartPointer<vtkIdTypeArray> cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellIds->SetNumberOfValues(numFibers+numPoints);
+    vtkIdType* cellBuffer = cellIds->GetPointer(0);
+    vtkIdType pointId = 0;
+    for (unsigned int t=0; t<m_ThreadPoints.size(); t++)
     {
-        vtkCell* cell = poly2->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        std::vector< float >& points = m_ThreadPoints.at(t);
+        if (!points.empty())
+            memcpy(static_cast<float*>(m_Points->GetVoidPointer(0))+3*pointId, &points[0], points.size()*sizeof(float));
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
+        std::vector< vtkIdType >& fiberSizes = m_ThreadFiberSizes.at(t);
+        for (unsigned int i=0; i<fiberSizes.size(); i++)
         {
-            double p[3];
-            points->GetPoint(j, p);
-
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
+            *cellBuffer++ = fiberSizes.at(i);
+            for (vtkIdType j=0; j<fiberSizes.at(i); j++)
+                *cellBuffer++ = pointId++;
         }
-        vNewLines->InsertNextCell(container);
-    }
-
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
 
-    return vNewPolyData;
-}
-template< class TTensorPixelType,
-          class TPDPixelType>
-void StreamlineTrackingFilter< TTensorPixelType,
-TPDPixelType>
-::AfterThreadedGenerateData()
-{
-    MITK_INFO << "Generating polydata ";
-    m_FiberPolyData = m_PolyDataContainer->GetElement(0);
-    for (unsigned int i=1; i<this->GetNumberOfThreads(); i++)
-    {
-        m_FiberPolyData = AddPolyData(m_FiberPolyData, m_PolyDataContainer->GetElement(i));
+        std::vector< float >().swap(points);
+        std::vector< vtkIdType >().swap(fiberSizes);
     }
+    m_Cells->SetCells(numFibers, cellIds);
+    m_FiberPolyData->SetPoints(m_Points);
+    m_FiberPolyData->SetLines(m_Cells);
+
+    double trackingTime = m_TrackingClock.GetTotal();
+    m_StreamlinesPerSecond = trackingTime>0 ? numFibers/trackingTime : 0;
+    MITK_INFO << "Tracked " << numFibers << " streamlines from " << m_Seeds.size()*m_NumberOfInputs*m_SeedsPerVoxel << " seeds in " << trackingTime << "s (" << m_StreamlinesPerSecond << " streamlines/s)";
     MITK_INFO << "done";
 }
 
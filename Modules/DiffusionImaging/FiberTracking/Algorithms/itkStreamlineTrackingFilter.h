@@ -32,11 +32,17 @@ This file is based heavily on a corresponding ITK filter.
 #include <vtkCellArray.h>
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
+#include <itkSimpleFastMutexLock.h>
+#include <itkTimeProbe.h>
 
 namespace itk{
 
 /**
-* \brief Performes deterministic streamline tracking on the input tensor image.   */
+* \brief Performes deterministic streamline tracking on the input tensor image.
+*
+* The seed voxels are collected into a list before tracking. The threads fetch batches of seeds from this list until it
+* is exhausted, so the load stays balanced even if the seeds are concentrated in a small part of the image. Each thread
+* writes its streamlines into its own contiguous point buffer, the buffers are copied into the output polydata at the end.   */
 
   template< class TTensorPixelType, class TPDPixelType=double>
   class StreamlineTrackingFilter :
@@ -84,6 +90,9 @@ namespace itk{
     itkSetMacro( MinCurvatureRadius, double )            ///< Tracking is stopped if curvature radius (in mm) is too small.
     itkGetMacro( MinCurvatureRadius, double )
     itkSetMacro( ResampleFibers, bool )                 ///< If enabled, the resulting fibers are resampled to feature point distances of 0.5*MinSpacing. This is recommendable for very short integration steps and many seeds. If disabled, the resulting fiber bundle might become very large.
+    itkSetMacro( SeedBatchSize, unsigned int )          ///< Number of seed voxels a thread fetches at once.
+    itkGetMacro( SeedBatchSize, unsigned int )
+    itkGetMacro( StreamlinesPerSecond, double )         ///< Tracking throughput of the last update (accepted streamlines per second).
 
   protected:
     StreamlineTrackingFilter();
@@ -91,7 +100,7 @@ namespace itk{
     void PrintSelf(std::ostream& os, Indent indent) const;
 
     void CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index);    ///< Calculate next integration step.
-    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx);       ///< Start streamline in one direction.
+    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< float >& points, int imageIdx);       ///< Start streamline in one direction. The world coordinates of the new points are appended to the point buffer.
     bool IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType& index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx);   ///< Are we outside of the mask image? Is the FA too low?
 
     double RoundToNearest(double num);
@@ -99,8 +108,6 @@ namespace itk{
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
     void AfterThreadedGenerateData();
 
-    FiberPolyDataType AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2);    ///< Combine tracking results generated by the individual threads.
-
     FiberPolyDataType               m_FiberPolyData;
     vtkSmartPointer<vtkPoints>      m_Points;
     vtkSmartPointer<vtkCellArray>   m_Cells;
@@ -127,7 +134,15 @@ namespace itk{
     ItkUcharImgType::Pointer    m_SeedImage;
     ItkUcharImgType::Pointer    m_MaskImage;
 
-    itk::VectorContainer< int, FiberPolyDataType >::Pointer m_PolyDataContainer;
+    std::vector< typename InputImageType::IndexType >   m_Seeds;            ///< Seed voxels in image order.
+    unsigned int                                        m_SeedBatchSize;
+    unsigned long                                       m_NextSeed;         ///< First seed of the next unprocessed batch (guarded by m_Mutex).
+    SimpleFastMutexLock                                 m_Mutex;
+    std::vector< std::vector< float > >                 m_ThreadPoints;     ///< Point coordinates (x,y,z) of the streamlines tracked by each thread.
+    std::vector< std::vector< vtkIdType > >             m_ThreadFiberSizes; ///< Number of points of each streamline in m_ThreadPoints.
+    OffsetValueType                                     m_InterpolationOffsets[8];  ///< Buffer offsets of the voxels used for trilinear interpolation.
+    TimeProbe                                           m_TrackingClock;
+    double                                              m_StreamlinesPerSecond;
 
   private:
 
@@ -23,7 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // misc
 #include <math.h>
-#include <boost/progress.hpp>
+#include <itkTractImageAccumulator.h>
 
 namespace itk{
 
@@ -127,120 +127,163 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     else
         minSpacing = newSpacing[2];
 
-    MITK_INFO << "TractDensityImageFilter: resampling fibers to ensure sufficient voxel coverage";
-    if (m_DoFiberResampling)
-    {
-        m_FiberBundle = m_FiberBundle->GetDeepCopy();
-        m_FiberBundle->ResampleSpline(minSpacing/10);
-    }
-
     MITK_INFO << "TractDensityImageFilter: starting image generation";
+    TractImageAccumulator accumulator(outImage.GetPointer());
+    const long numVoxels = accumulator.GetNumberOfVoxels();
+    std::vector< unsigned char > mask;
+    if (m_BinaryOutput)
+        mask.resize(numVoxels, 0);
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    if (m_UseTrilinearInterpolation)
     {
-        ++disp;
-        vtkIdType   numPoints(0);
-        vtkIdType*  points(NULL);
-        vLines->GetNextCell ( numPoints, points );
-        float weight = m_FiberBundle->GetFiberWeight(i);
-
-        // fill output image
-        for( int j=0; j<numPoints; j++)
+        // the fiber points are splatted, so the fibers are resampled to ensure sufficient voxel coverage
+        if (m_DoFiberResampling)
         {
-            itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-            itk::Index<3> index;
-            itk::ContinuousIndex<float, 3> contIndex;
-            outImage->TransformPhysicalPointToIndex(vertex, index);
-            outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+            MITK_INFO << "TractDensityImageFilter: resampling fibers to ensure sufficient voxel coverage";
+            m_FiberBundle = m_FiberBundle->GetDeepCopy();
+            m_FiberBundle->ResampleSpline(minSpacing/10);
+        }
 
-            if (!m_UseTrilinearInterpolation && outImage->GetLargestPossibleRegion().IsInside(index))
+        vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
+        vtkPoints* fiberPoints = fiberPolyData->GetPoints();
+        auto splatFiber = [&](int, vtkIdType numPoints, const vtkIdType* points)
+        {
+            for( int j=0; j<numPoints; j++)
             {
+                double vertex[3];
+                fiberPoints->GetPoint(points[j], vertex);
+                double contIndex[3];
+                accumulator.TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+                int index[3];
+                float frac[3];
+                for (int k=0; k<3; k++)
+                {
+                    index[k] = (int)std::floor(contIndex[k]);
+                    frac[k] = 1-(contIndex[k]-index[k]);
+                }
+                float frac_x = frac[0];
+                float frac_y = frac[1];
+                float frac_z = frac[2];
+
+                // int coordinates inside image?
+                if (index[0] < 0 || index[0] >= w-1)
+                    continue;
+                if (index[1] < 0 || index[1] >= h-1)
+                    continue;
+                if (index[2] < 0 || index[2] >= d-1)
+                    continue;
+
+                const long offsets[8] = {
+                    index[0]   + w*(index[1]  + (long)h*index[2]  ),
+                    index[0]   + w*(index[1]+1+ (long)h*index[2]  ),
+                    index[0]   + w*(index[1]  + (long)h*index[2]+h),
+                    index[0]   + w*(index[1]+1+ (long)h*index[2]+h),
+                    index[0]+1 + w*(index[1]  + (long)h*index[2]  ),
+                    index[0]+1 + w*(index[1]  + (long)h*index[2]+h),
+                    index[0]+1 + w*(index[1]+1+ (long)h*index[2]  ),
+                    index[0]+1 + w*(index[1]+1+ (long)h*index[2]+h)
+                };
+
                 if (m_BinaryOutput)
-                    outImage->SetPixel(index, 1);
+                {
+                    for (int k=0; k<8; k++)
+                        TractImageAccumulator::Mark(&mask[0], offsets[k]);
+                }
                 else
-                    outImage->SetPixel(index, outImage->GetPixel(index)+0.01*weight);
-                continue;
+                {
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[0], (  frac_x)*(  frac_y)*(  frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[1], (  frac_x)*(1-frac_y)*(  frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[2], (  frac_x)*(  frac_y)*(1-frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[3], (  frac_x)*(1-frac_y)*(1-frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[4], (1-frac_x)*(  frac_y)*(  frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[5], (1-frac_x)*(  frac_y)*(1-frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[6], (1-frac_x)*(1-frac_y)*(  frac_z));
+                    TractImageAccumulator::Add(outImageBufferPointer, offsets[7], (1-frac_x)*(1-frac_y)*(1-frac_z));
+                }
             }
+        };
+        TractImageAccumulator::ForEachFiber(fiberPolyData, splatFiber);
+    }
+    else
+    {
+        // with resampling, each voxel receives the fiber length inside of it, scaled like
+        // the sampling with 0.01 per fiber point at a point distance of minSpacing/10.
+        // Without resampling, only the given fiber points are counted.
+        const double lengthScale = 0.1/minSpacing;
+        const double pointLength = 0.1*minSpacing;
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
-
-            if (frac_x<0)
-            {
-                index[0] -= 1;
-                frac_x += 1;
-            }
-            if (frac_y<0)
+        vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
+        vtkPoints* fiberPoints = fiberPolyData->GetPoints();
+        auto traverseFiber = [&](int fiberIndex, vtkIdType numPoints, const vtkIdType* points)
+        {
+            const double weight = m_FiberBundle->GetFiberWeight(fiberIndex)*lengthScale;
+            auto addLength = [&](long offset, double length)
             {
-                index[1] -= 1;
-                frac_y += 1;
-            }
-            if (frac_z<0)
+                if (m_BinaryOutput)
+                    TractImageAccumulator::Mark(&mask[0], offset);
+                else
+                    TractImageAccumulator::Add(outImageBufferPointer, offset, weight*length);
+            };
+
+            double vertex[3];
+            double nextVertex[3];
+            if (!m_DoFiberResampling)
             {
-                index[2] -= 1;
-                frac_z += 1;
+                for( int j=0; j<numPoints; j++)
+                {
+                    fiberPoints->GetPoint(points[j], vertex);
+                    const long offset = accumulator.GetOffset(vertex);
+                    if (offset>=0)
+                        addLength(offset, pointLength);
+                }
+                return;
             }
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
-
-            // int coordinates inside image?
-            if (index[0] < 0 || index[0] >= w-1)
-                continue;
-            if (index[1] < 0 || index[1] >= h-1)
-                continue;
-            if (index[2] < 0 || index[2] >= d-1)
-                continue;
-
-            if (m_BinaryOutput)
+            if (numPoints>0)
+                fiberPoints->GetPoint(points[0], vertex);
+            if (numPoints==1)
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] = 1;
+                // a single point counts like one of the fiber samples
+                const long offset = accumulator.GetOffset(vertex);
+                if (offset>=0)
+                    addLength(offset, pointLength);
             }
-            else
+            for( int j=0; j<numPoints-1; j++)
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] += (  frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] += (  frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] += (  frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] += (  frac_x)*(1-frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] += (1-frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] += (1-frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] += (1-frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] += (1-frac_x)*(1-frac_y)*(1-frac_z);
+                fiberPoints->GetPoint(points[j+1], nextVertex);
+                accumulator.TraverseSegment(vertex, nextVertex, addLength);
+                vertex[0] = nextVertex[0];
+                vertex[1] = nextVertex[1];
+                vertex[2] = nextVertex[2];
             }
-        }
+        };
+        TractImageAccumulator::ForEachFiber(fiberPolyData, traverseFiber);
     }
 
-    if (!m_OutputAbsoluteValues && !m_BinaryOutput)
+    if (m_BinaryOutput)
+    {
+#pragma omp parallel for
+        for (long i=0; i<numVoxels; i++)
+            if (mask[i])
+                outImageBufferPointer[i] = 1;
+    }
+    else if (!m_OutputAbsoluteValues)
     {
         MITK_INFO << "TractDensityImageFilter: max-normalizing output image";
-        OutPixelType max = 0;
-        for (int i=0; i<w*h*d; i++)
-            if (max < outImageBufferPointer[i])
-                max = outImageBufferPointer[i];
+        OutPixelType max = TractImageAccumulator::GetMaximum(outImageBufferPointer, numVoxels);
         if (max>0)
-            for (int i=0; i<w*h*d; i++)
-            {
+        {
+#pragma omp parallel for
+            for (long i=0; i<numVoxels; i++)
                 outImageBufferPointer[i] /= max;
-            }
+        }
     }
     if (m_InvertImage)
     {
         MITK_INFO << "TractDensityImageFilter: inverting image";
-        for (int i=0; i<w*h*d; i++)
+#pragma omp parallel for
+        for (long i=0; i<numVoxels; i++)
             outImageBufferPointer[i] = 1-outImageBufferPointer[i];
     }
     MITK_INFO << "TractDensityImageFilter: finished processing";
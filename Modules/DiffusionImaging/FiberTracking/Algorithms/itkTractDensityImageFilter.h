@@ -56,7 +56,7 @@ public:
   itkSetMacro( FiberBundle, mitk::FiberBundle::Pointer)        ///< input fiber bundle
   itkSetMacro( InputImage, typename OutputImageType::Pointer)   ///< use input image geometry to initialize output image
   itkSetMacro( UseTrilinearInterpolation, bool )
-  itkSetMacro( DoFiberResampling, bool )
+  itkSetMacro( DoFiberResampling, bool )                      ///< if false, only the given fiber points are accumulated instead of the (resampled) fibers
 
   void GenerateData();
 
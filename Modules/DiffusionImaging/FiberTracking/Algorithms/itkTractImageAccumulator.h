@@ -0,0 +1,282 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef __itkTractImageAccumulator_h__
+#define __itkTractImageAccumulator_h__
+
+#include <itkImageBase.h>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace itk{
+
+/**
+* \brief Writes fibers into the buffer of an image. Shared by the TractDensityImageFilter, TractsToFiberEndingsImageFilter and TractsToRgbaImageFilter.
+*
+* ForEachFiber() distributes blocks of fibers over the OpenMP threads. All threads write into the same
+* buffer with atomic operations (Add(), Mark()), so no per-thread copies of the (possibly strongly
+* upsampled and mostly empty) output image are needed.
+*
+* TraverseSegment() visits all voxels crossed by a fiber segment (Amanatides & Woo) together with the
+* length of the segment inside of each voxel, so the fibers do not have to be resampled densely. Filters
+* that accumulate the given fiber points only (e.g. TractDensityImageFilter without fiber resampling) use
+* GetOffset() instead.
+*/
+class TractImageAccumulator
+{
+public:
+
+    /** Number of fibers that are handed to one thread at a time. */
+    static const int FibersPerBlock = 256;
+
+    template< class TImage >
+    explicit TractImageAccumulator(const TImage* image)
+    {
+        typename TImage::SizeType size = image->GetLargestPossibleRegion().GetSize();
+        typename TImage::DirectionType inverseDirection( image->GetDirection().GetInverse() );
+        for (int i=0; i<3; i++)
+        {
+            m_Size[i] = size[i];
+            m_Origin[i] = image->GetOrigin()[i];
+            for (int j=0; j<3; j++)
+                m_PhysicalToIndex[i][j] = inverseDirection[i][j]/image->GetSpacing()[i];
+        }
+    }
+
+    /** Number of voxels of the image. */
+    long GetNumberOfVoxels() const
+    {
+        return (long)m_Size[0]*m_Size[1]*m_Size[2];
+    }
+
+    /** Continuous index of a physical point. */
+    void TransformPhysicalPointToContinuousIndex(const double point[3], double index[3]) const
+    {
+        const double p[3] = { point[0]-m_Origin[0], point[1]-m_Origin[1], point[2]-m_Origin[2] };
+        for (int i=0; i<3; i++)
+            index[i] = m_PhysicalToIndex[i][0]*p[0] + m_PhysicalToIndex[i][1]*p[1] + m_PhysicalToIndex[i][2]*p[2];
+    }
+
+    /** Buffer offset of the voxel containing the physical point, -1 if the point is outside of the image. */
+    long GetOffset(const double point[3]) const
+    {
+        double index[3];
+        TransformPhysicalPointToContinuousIndex(point, index);
+        long voxel[3];
+        for (int i=0; i<3; i++)
+        {
+            voxel[i] = (long)std::floor(index[i]+0.5);
+            if (voxel[i]<0 || voxel[i]>=m_Size[i])
+                return -1;
+        }
+        return voxel[0] + m_Size[0]*(voxel[1] + m_Size[1]*voxel[2]);
+    }
+
+    /**
+    * Calls voxelFunction(offset, length) for every voxel inside of the image that is crossed by the segment
+    * from point0 to point1. length is the physical length of the part of the segment inside of the voxel.
+    */
+    template< class TFunction >
+    void TraverseSegment(const double point0[3], const double point1[3], TFunction& voxelFunction) const
+    {
+        const double dx = point1[0]-point0[0];
+        const double dy = point1[1]-point0[1];
+        const double dz = point1[2]-point0[2];
+        const double length = std::sqrt(dx*dx+dy*dy+dz*dz);
+        if (length<=0)
+            return;
+
+        // shift the index by half a voxel, so that voxel v covers [v, v+1)
+        double a[3], b[3];
+        TransformPhysicalPointToContinuousIndex(point0, a);
+        TransformPhysicalPointToContinuousIndex(point1, b);
+
+        long voxel[3];
+        int step[3];
+        double tMax[3], tDelta[3];
+        const double inf = std::numeric_limits<double>::infinity();
+        for (int i=0; i<3; i++)
+        {
+            a[i] += 0.5;
+            b[i] += 0.5;
+            voxel[i] = (long)std::floor(a[i]);
+            const double d = b[i]-a[i];
+            if (d>0)
+            {
+                step[i] = 1;
+                tDelta[i] = 1.0/d;
+                tMax[i] = (voxel[i]+1-a[i])*tDelta[i];
+            }
+            else if (d<0)
+            {
+                step[i] = -1;
+                tDelta[i] = -1.0/d;
+                tMax[i] = (a[i]-voxel[i])*tDelta[i];
+            }
+            else
+            {
+                step[i] = 0;
+                tDelta[i] = inf;
+                tMax[i] = inf;
+            }
+        }
+
+        double t = 0;
+        while (true)
+        {
+            int axis = 0;
+            if (tMax[1]<tMax[axis])
+                axis = 1;
+            if (tMax[2]<tMax[axis])
+                axis = 2;
+            const double tNext = tMax[axis]<1 ? tMax[axis] : 1;
+
+            if (voxel[0]>=0 && voxel[0]<m_Size[0] && voxel[1]>=0 && voxel[1]<m_Size[1] && voxel[2]>=0 && voxel[2]<m_Size[2] && tNext>t)
+                voxelFunction(voxel[0] + m_Size[0]*(voxel[1] + m_Size[1]*voxel[2]), (tNext-t)*length);
+
+            if (tNext>=1)
+                break;
+            t = tNext;
+            voxel[axis] += step[axis];
+            tMax[axis] += tDelta[axis];
+        }
+    }
+
+    /**
+    * Calls fiberFunction(fiberIndex, numPoints, pointIds) for all fibers of the polydata. Blocks of
+    * FibersPerBlock fibers are processed in parallel, so fiberFunction must only write via Add() or Mark().
+    * The points should be read with vtkPoints::GetPoint(id, double[3]), which is thread safe.
+    */
+    template< class TFunction >
+    static void ForEachFiber(vtkPolyData* fiberPolyData, TFunction& fiberFunction)
+    {
+        std::vector< vtkIdType > numPoints;
+        std::vector< vtkIdType* > pointIds;
+        vtkCellArray* lines = fiberPolyData->GetLines();
+        lines->InitTraversal();
+        vtkIdType n;
+        vtkIdType* ids;
+        while (lines->GetNextCell(n, ids))
+        {
+            numPoints.push_back(n);
+            pointIds.push_back(ids);
+        }
+
+        const int numFibers = numPoints.size();
+        const int numBlocks = (numFibers+FibersPerBlock-1)/FibersPerBlock;
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int block=0; block<numBlocks; block++)
+        {
+            const int last = std::min(numFibers, (block+1)*FibersPerBlock);
+            for (int i=block*FibersPerBlock; i<last; i++)
+                fiberFunction(i, numPoints[i], pointIds[i]);
+        }
+    }
+
+    /** Thread safe buffer[offset] += value. */
+    template< class TValue, class TAddend >
+    static void Add(TValue* buffer, long offset, TAddend value)
+    {
+#pragma omp atomic
+        buffer[offset] += value;
+    }
+
+    /** Thread safe mask[offset] = 1. */
+    static void Mark(unsigned char* mask, long offset)
+    {
+#pragma omp atomic
+        mask[offset] |= 1;
+    }
+
+    /** Maximum of the buffer, computed in parallel over blocks of voxels. */
+    template< class TValue >
+    static TValue GetMaximum(const TValue* buffer, long numValues)
+    {
+        if (numValues<=0)
+            return 0;
+
+        const long blockSize = 65536;
+        const int numBlocks = (numValues+blockSize-1)/blockSize;
+        std::vector< TValue > blockMax(numBlocks, buffer[0]);
+#pragma omp parallel for
+        for (int block=0; block<numBlocks; block++)
+        {
+            const long last = std::min(numValues, (block+1)*blockSize);
+            TValue max = buffer[block*blockSize];
+            for (long i=block*blockSize; i<last; i++)
+                if (max < buffer[i])
+                    max = buffer[i];
+            blockMax[block] = max;
+        }
+
+        TValue max = buffer[0];
+        for (int block=0; block<numBlocks; block++)
+            if (max < blockMax[block])
+                max = blockMax[block];
+        return max;
+    }
+
+    /** Maximum of each component of an interleaved buffer (numTuples x numComponents), computed in a single parallel pass. */
+    template< class TValue >
+    static void GetComponentMaxima(const TValue* buffer, long numTuples, int numComponents, TValue* maxima)
+    {
+        if (numTuples<=0)
+        {
+            for (int c=0; c<numComponents; c++)
+                maxima[c] = 0;
+            return;
+        }
+
+        const long blockSize = 65536;
+        const int numBlocks = (numTuples+blockSize-1)/blockSize;
+        std::vector< TValue > blockMax(numBlocks*numComponents);
+#pragma omp parallel for
+        for (int block=0; block<numBlocks; block++)
+        {
+            const long last = std::min(numTuples, (block+1)*blockSize);
+            TValue* max = &blockMax[block*numComponents];
+            for (int c=0; c<numComponents; c++)
+                max[c] = buffer[block*blockSize*numComponents+c];
+            for (long i=block*blockSize; i<last; i++)
+                for (int c=0; c<numComponents; c++)
+                    if (max[c] < buffer[i*numComponents+c])
+                        max[c] = buffer[i*numComponents+c];
+        }
+
+        for (int c=0; c<numComponents; c++)
+        {
+            maxima[c] = blockMax[c];
+            for (int block=1; block<numBlocks; block++)
+                if (maxima[c] < blockMax[block*numComponents+c])
+                    maxima[c] = blockMax[block*numComponents+c];
+        }
+    }
+
+private:
+
+    long    m_Size[3];
+    double  m_Origin[3];
+    double  m_PhysicalToIndex[3][3];
+};
+
+}
+
+#endif // __itkTractImageAccumulator_h__
@@ -19,7 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolyLine.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
-#include <boost/progress.hpp>
+#include <itkTractImageAccumulator.h>
 
 namespace itk{
 
@@ -116,45 +116,49 @@ namespace itk{
     else
         minSpacing = newSpacing[2];
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
+    TractImageAccumulator accumulator(outImage.GetPointer());
+    const long numVoxels = accumulator.GetNumberOfVoxels();
+    std::vector< unsigned char > mask;
+    if (m_BinaryOutput)
+      mask.resize(numVoxels, 0);
 
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
+    vtkPoints* fiberPoints = fiberPolyData->GetPoints();
+    auto addEnding = [&](vtkIdType pointId)
+    {
+      double vertex[3];
+      fiberPoints->GetPoint(pointId, vertex);
+      const long offset = accumulator.GetOffset(vertex);
+      if (offset<0)
+        return;
+      if (m_BinaryOutput)
+        TractImageAccumulator::Mark(&mask[0], offset);
+      else
+        TractImageAccumulator::Add(outImageBufferPointer, offset, 1);
+    };
+    auto addFiberEndings = [&](int, vtkIdType numPoints, const vtkIdType* points)
     {
-        ++disp;
-      vtkIdType   numPoints(0);
-      vtkIdType*  points(NULL);
-      vLines->GetNextCell ( numPoints, points );
-
       // fill output image
       if (numPoints>0)
-      {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[0]));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        if (m_BinaryOutput)
-            outImage->SetPixel(index, 1);
-        else
-            outImage->SetPixel(index, outImage->GetPixel(index)+1);
-      }
-
+        addEnding(points[0]);
       if (numPoints>2)
-      {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[numPoints-1]));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        if (m_BinaryOutput)
-            outImage->SetPixel(index, 1);
-        else
-            outImage->SetPixel(index, outImage->GetPixel(index)+1);
-      }
+        addEnding(points[numPoints-1]);
+    };
+    TractImageAccumulator::ForEachFiber(fiberPolyData, addFiberEndings);
+
+    if (m_BinaryOutput)
+    {
+#pragma omp parallel for
+      for (long i=0; i<numVoxels; i++)
+        if (mask[i])
+          outImageBufferPointer[i] = 1;
     }
 
     if (m_InvertImage)
-      for (int i=0; i<w*h*d; i++)
+    {
+#pragma omp parallel for
+      for (long i=0; i<numVoxels; i++)
         outImageBufferPointer[i] = 1-outImageBufferPointer[i];
+    }
   }
 }
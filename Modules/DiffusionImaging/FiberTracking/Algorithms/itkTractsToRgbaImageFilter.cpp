@@ -22,7 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // misc
 #include <math.h>
-#include <boost/progress.hpp>
+#include <itkTractImageAccumulator.h>
 
 namespace itk{
 
@@ -93,7 +93,6 @@ namespace itk{
       upsampledRegion.SetSize(1, geometry->GetExtent(1)*m_UpsamplingFactor);
       upsampledRegion.SetSize(2, geometry->GetExtent(2)*m_UpsamplingFactor);
     }
-    typename OutputImageType::RegionType::SizeType upsampledSize = upsampledRegion.GetSize();
 
     // apply new image parameters
     outImage->SetSpacing( newSpacing );
@@ -102,185 +101,68 @@ namespace itk{
     outImage->SetRegions( upsampledRegion );
     outImage->Allocate();
 
-    int w = upsampledSize[0];
-    int h = upsampledSize[1];
-    int d = upsampledSize[2];
-
     // set/initialize output
     unsigned char* outImageBufferPointer = (unsigned char*)outImage->GetBufferPointer();
-    float* buffer = new float[w*h*d*4];
-    for (int i=0; i<w*h*d*4; i++)
-      buffer[i] = 0;
-
-    // resample fiber bundle
-    float minSpacing = 1;
-    if(newSpacing[0]<newSpacing[1] && newSpacing[0]<newSpacing[2])
-        minSpacing = newSpacing[0];
-    else if (newSpacing[1] < newSpacing[2])
-        minSpacing = newSpacing[1];
-    else
-        minSpacing = newSpacing[2];
-
-    m_FiberBundle = m_FiberBundle->GetDeepCopy();
-    m_FiberBundle->ResampleSpline(minSpacing);
+    TractImageAccumulator accumulator(outImage.GetPointer());
+    const long numVoxels = accumulator.GetNumberOfVoxels();
+    std::vector< float > buffer(numVoxels*4, 0);
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
-
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    vtkPoints* fiberPoints = fiberPolyData->GetPoints();
+    const double spacing[3] = { newSpacing[0], newSpacing[1], newSpacing[2] };
+    auto addFiber = [&](int, vtkIdType numPoints, const vtkIdType* points)
     {
-      ++disp;
-      vtkIdType   numPoints(0);
-      vtkIdType*  points(NULL);
-      vLines->GetNextCell ( numPoints, points );
-
-      // calc directions (which are used as weights)
-      std::list< itk::Point<float, 3> > rgbweights;
-      std::list<float> intensities;
+      double vertex[3];
+      double vertexPost[3];
+      if (numPoints>0)
+        fiberPoints->GetPoint(points[0], vertexPost);
 
       for( int j=0; j<numPoints-1; j++)
       {
+        vertex[0] = vertexPost[0]; vertex[1] = vertexPost[1]; vertex[2] = vertexPost[2];
+        fiberPoints->GetPoint(points[j+1], vertexPost);
+
+        // directions are used as weights
+        float dir[3];
+        for (int k=0; k<3; k++)
+          dir[k] = fabs((vertexPost[k] - vertex[k]) * spacing[k]);
+        const float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
+        const double segmentLength = sqrt( (vertexPost[0]-vertex[0])*(vertexPost[0]-vertex[0]) + (vertexPost[1]-vertex[1])*(vertexPost[1]-vertex[1]) + (vertexPost[2]-vertex[2])*(vertexPost[2]-vertex[2]) );
+        if (segmentLength<=0)
+          continue;
 
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Point<float, 3> vertexPost = GetItkPoint(fiberPolyData->GetPoint(points[j+1]));
-
-        itk::Point<float, 3> dir;
-        dir[0] = fabs((vertexPost[0] - vertex[0]) * outImage->GetSpacing()[0]);
-        dir[1] = fabs((vertexPost[1] - vertex[1]) * outImage->GetSpacing()[1]);
-        dir[2] = fabs((vertexPost[2] - vertex[2]) * outImage->GetSpacing()[2]);
-
-        rgbweights.push_back(dir);
-
-        float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
-        intensities.push_back(intensity);
-
-        // last point gets same as previous one
-        if(j==numPoints-2)
+        // fill output image, weighted with the fraction of the segment inside of each voxel
+        auto addToVoxel = [&](long offset, double length)
         {
-          rgbweights.push_back(dir);
-          intensities.push_back(intensity);
-        }
+          const float fraction = length/segmentLength;
+          TractImageAccumulator::Add(&buffer[0], 4*offset,   fraction*dir[0]);
+          TractImageAccumulator::Add(&buffer[0], 4*offset+1, fraction*dir[1]);
+          TractImageAccumulator::Add(&buffer[0], 4*offset+2, fraction*dir[2]);
+          TractImageAccumulator::Add(&buffer[0], 4*offset+3, fraction*intensity);
+        };
+        accumulator.TraverseSegment(vertex, vertexPost, addToVoxel);
       }
+    };
+    TractImageAccumulator::ForEachFiber(fiberPolyData, addFiber);
 
-      // fill output image
-      for( int j=0; j<numPoints; j++)
-      {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Index<3> index;
-        itk::ContinuousIndex<float, 3> contIndex;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
-
-        float frac_x = contIndex[0] - index[0];
-        float frac_y = contIndex[1] - index[1];
-        float frac_z = contIndex[2] - index[2];
-
-        int px = index[0];
-        if (frac_x<0)
-        {
-          px -= 1;
-          frac_x += 1;
-        }
-
-        int py = index[1];
-        if (frac_y<0)
-        {
-          py -= 1;
-          frac_y += 1;
-        }
-
-        int pz = index[2];
-        if (frac_z<0)
-        {
-          pz -= 1;
-          frac_z += 1;
-        }
-
-        // int coordinates inside image?
-        if (px < 0 || px >= w-1)
-          continue;
-        if (py < 0 || py >= h-1)
-          continue;
-        if (pz < 0 || pz >= d-1)
-          continue;
-
-        float scale = 100 * pow((float)m_UpsamplingFactor,3);
-        itk::Point<float, 3> rgbweight = rgbweights.front();
-        rgbweights.pop_front();
-        float intweight = intensities.front();
-        intensities.pop_front();
-
-        // add to r-channel in output image
-        buffer[0+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-
-        // add to g-channel in output image
-        buffer[1+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-
-        // add to b-channel in output image
-        buffer[2+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-
-        // add to a-channel in output image
-        buffer[3+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-      }
-    }
+    // calc maxima of the directions and of the intensity in one pass
     float maxRgb = 0.000000001;
     float maxInt = 0.000000001;
-    int numPix;
-
-    numPix = w*h*d*4;
-    // calc maxima
-    for(int i=0; i<numPix; i++)
+    if (numVoxels>0)
     {
-      if((i-3)%4 != 0)
-      {
-        if(buffer[i] > maxRgb)
-          maxRgb = buffer[i];
-      }
-      else
-      {
-        if(buffer[i] > maxInt)
-          maxInt = buffer[i];
-      }
+      float maxima[4];
+      TractImageAccumulator::GetComponentMaxima(&buffer[0], numVoxels, 4, maxima);
+      maxRgb = std::max(maxRgb, std::max(maxima[0], std::max(maxima[1], maxima[2])));
+      maxInt = std::max(maxInt, maxima[3]);
     }
 
     // write output, normalized uchar 0..255
-    for(int i=0; i<numPix; i++)
+#pragma omp parallel for
+    for(long i=0; i<numVoxels; i++)
     {
-      if((i-3)%4 != 0)
-        outImageBufferPointer[i] = (unsigned char) (255.0 * buffer[i] / maxRgb);
-      else
-        outImageBufferPointer[i] = (unsigned char) (255.0 * buffer[i] / maxInt);
+      for (int c=0; c<3; c++)
+        outImageBufferPointer[4*i+c] = (unsigned char) (255.0 * buffer[4*i+c] / maxRgb);
+      outImageBufferPointer[4*i+3] = (unsigned char) (255.0 * buffer[4*i+3] / maxInt);
     }
   }
 }
@@ -42,7 +42,27 @@ template< class TPixelType >
 void DftImageFilter< TPixelType >
 ::BeforeThreadedGenerateData()
 {
+    typename OutputImageType::Pointer outputImage = static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
+    typename InputImageType::Pointer inputImage  = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
 
+    int szx = outputImage->GetLargestPossibleRegion().GetSize(0);
+    int szy = outputImage->GetLargestPossibleRegion().GetSize(1);
+    int inx = inputImage->GetLargestPossibleRegion().GetSize(0);
+    int iny = inputImage->GetLargestPossibleRegion().GetSize(1);
+
+    // shift indices for DFT: (0 -- N) --> (-N/2 -- N/2)
+    int shiftx = szx%2==1 ? (szx-1)/2 : szx/2;
+    int shifty = szy%2==1 ? (szy-1)/2 : szy/2;
+
+    m_PhaseTableX.resize(szx*inx);
+    for (int kx=0; kx<szx; kx++)
+        for (int x=0; x<inx; x++)
+            m_PhaseTableX[kx*inx+x] = exp( std::complex<double>(0, -2 * M_PI * (double)(kx-shiftx)*(double)(x-shiftx)/szx ) );
+
+    m_PhaseTableY.resize(szy*iny);
+    for (int ky=0; ky<szy; ky++)
+        for (int y=0; y<iny; y++)
+            m_PhaseTableY[ky*iny+y] = exp( std::complex<double>(0, -2 * M_PI * (double)(ky-shifty)*(double)(y-shifty)/szy ) );
 }
 
 template< class TPixelType >
@@ -53,63 +73,44 @@ void DftImageFilter< TPixelType >
 
     ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
 
-    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
     typename InputImageType::Pointer inputImage  = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
 
-    int szx = outputImage->GetLargestPossibleRegion().GetSize(0);
-    int szy = outputImage->GetLargestPossibleRegion().GetSize(1);
+    int inx = inputImage->GetLargestPossibleRegion().GetSize(0);
+    int iny = inputImage->GetLargestPossibleRegion().GetSize(1);
+
+    // input pixels, row major
+    ComplexVectorType f(inx*iny);
+    ImageRegionConstIterator< InputImageType > it(inputImage, inputImage->GetLargestPossibleRegion() );
+    for (int i=0; !it.IsAtEnd(); ++it, ++i)
+        f[i] = vcl_complex<double>(it.Get().real(), it.Get().imag());
+
+    // input columns transformed for the current ky (the separable part of the DFT)
+    ComplexVectorType column(inx);
+    int currentKy = -1;
 
     while( !oit.IsAtEnd() )
     {
-        double kx = oit.GetIndex()[0];
-        double ky = oit.GetIndex()[1];
-//        kx -= (double)szx/2;
-//        ky -= (double)szy/2;
-
-        if ((int)szx%2==1)
-            kx -= (szx-1)/2;
-        else
-            kx -= szx/2;
-        if ((int)szy%2==1)
-            ky -= (szy-1)/2;
-        else
-            ky -= szy/2;
-
-//        if( kx <  szx/2 )
-//            kx = kx + szx/2;
-//        else
-//            kx = kx - szx/2;
-
-//        if( ky <  szy/2 )
-//            ky = ky + szy/2;
-//        else
-//            ky = ky - szy/2;
+        int kx = oit.GetIndex()[0];
+        int ky = oit.GetIndex()[1];
 
-        vcl_complex<double> s(0,0);
-        InputIteratorType it(inputImage, inputImage->GetLargestPossibleRegion() );
-        while( !it.IsAtEnd() )
+        if (ky != currentKy)
         {
-            int x = it.GetIndex()[0];
-            int y = it.GetIndex()[1];
-//            x -= (double)szx/2;
-//            y -= (double)szy/2;
-
-            if ((int)szx%2==1)
-                x -= (szx-1)/2;
-            else
-                x -= szx/2;
-            if ((int)szy%2==1)
-                y -= (szy-1)/2;
-            else
-                y -= szy/2;
-
-            vcl_complex<double> f(it.Get().real(), it.Get().imag());
-
-            s += f * exp( std::complex<double>(0, -2 * M_PI * (kx*(double)x/szx + ky*(double)y/szy) ) );
-
-            ++it;
+            std::fill(column.begin(), column.end(), vcl_complex<double>(0,0));
+            const vcl_complex<double>* phaseY = &m_PhaseTableY[ky*iny];
+            for (int y=0; y<iny; y++)
+            {
+                const vcl_complex<double>* row = &f[y*inx];
+                for (int x=0; x<inx; x++)
+                    column[x] += row[x] * phaseY[y];
+            }
+            currentKy = ky;
         }
 
+        vcl_complex<double> s(0,0);
+        const vcl_complex<double>* phaseX = &m_PhaseTableX[kx*inx];
+        for (int x=0; x<inx; x++)
+            s += column[x] * phaseX[x];
+
         oit.Set(s);
         ++oit;
     }
@@ -26,12 +26,16 @@ This file is based heavily on a corresponding ITK filter.
 #include <itkImageToImageFilter.h>
 #include <itkDiffusionTensor3D.h>
 #include <vcl_complex.h>
+#include <vector>
 #include <mitkFiberfoxParameters.h>
 
 namespace itk{
 
 /**
-* \brief 2D Discrete Fourier Transform Filter (complex to real). Special issue for Fiberfox -> rearranges slice. */
+* \brief 2D Discrete Fourier Transform Filter (complex to real). Special issue for Fiberfox -> rearranges slice.
+*
+* The transform is computed separably: each thread first transforms the columns of the input for its own output rows
+* and then the rows, using phase tables precomputed in BeforeThreadedGenerateData(). */
 
 template< class TPixelType >
 class DftImageFilter :
@@ -68,7 +72,11 @@ protected:
 
 private:
 
+    typedef std::vector< vcl_complex< double > > ComplexVectorType;
+
     FiberfoxParameters<double>          m_Parameters;
+    ComplexVectorType                   m_PhaseTableX;  ///< exp(-2*pi*i*kx*x/szx), row major in kx
+    ComplexVectorType                   m_PhaseTableY;  ///< exp(-2*pi*i*ky*y/szy), row major in ky
 };
 
 }
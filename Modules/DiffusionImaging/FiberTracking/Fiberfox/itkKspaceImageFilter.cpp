@@ -31,6 +31,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
 
 namespace itk {
 
@@ -41,6 +42,8 @@ KspaceImageFilter< TPixelType >
     , m_UseConstantRandSeed(false)
     , m_SpikesPerSlice(0)
     , m_IsBaseline(true)
+    , m_SimulateEddyCurrents(false)
+    , m_HasOffResonance(false)
 {
     m_DiffusionGradientDirection.Fill(0.0);
 
@@ -120,6 +123,141 @@ void KspaceImageFilter< TPixelType >
     }
 
     m_ReadoutScheme->AdjustEchoTime();
+
+    PrecomputeSliceData();
+}
+
+template< class TPixelType >
+void KspaceImageFilter< TPixelType >
+::PrecomputeSliceData()
+{
+    double kxMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(0);
+    double kyMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(1);
+    int xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
+    int yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
+    double yMaxFov = yMax*m_Parameters->m_SignalGen.m_CroppingFactor;            // actual FOV in y-direction (in x-direction FOV=xMax)
+
+    m_SimulateEddyCurrents = m_Parameters->m_SignalGen.m_EddyStrength>0 && m_Parameters->m_Misc.m_CheckAddEddyCurrentsBox && !m_IsBaseline;
+    m_HasOffResonance = m_SimulateEddyCurrents || m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull();
+
+    unsigned int numCompartments = m_CompartmentImages.size();
+    m_WeightedCompartments.assign(numCompartments, vector< double >(xMax*yMax, 0.0));
+    m_SignalPixels.clear();
+    m_EddyPositionFactor.assign(m_SimulateEddyCurrents ? xMax*yMax : 0, 0.0);
+    m_FmapOmega.assign(m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull() ? xMax*yMax : 0, 0.0);
+
+    // wrapped, centered y coordinate per image row
+    // (if signal comes from outside FOV, it is mirrored back: wrap-around artifact - aliasing)
+    vector< double > wrappedY(yMax);
+
+    for (int yi=0; yi<yMax; yi++)
+    {
+        double y = yi;
+        if (yMax%2==1)
+            y -= (yMax-1)/2;
+        else
+            y -= yMax/2;
+
+        for (int xi=0; xi<xMax; xi++)
+        {
+            double x = xi;
+            if (xMax%2==1)
+                x -= (xMax-1)/2;
+            else
+                x -= xMax/2;
+
+            InputImageType::IndexType index; index[0] = xi; index[1] = yi;
+            unsigned int p = yi*xMax+xi;
+
+            DoubleVectorType pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
+            pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
+
+            double coilSensitivity = 1;
+            if (m_Parameters->m_SignalGen.m_CoilSensitivityProfile!=SignalGenerationParameters::COIL_CONSTANT)
+                coilSensitivity = CoilSensitivity(pos);
+
+            bool hasSignal = false;
+            for (unsigned int i=0; i<numCompartments; i++)
+            {
+                m_WeightedCompartments[i][p] = m_CompartmentImages.at(i)->GetPixel(index) * m_Parameters->m_SignalGen.m_SignalScale * coilSensitivity;
+                if (m_WeightedCompartments[i][p]!=0)
+                    hasSignal = true;
+            }
+            // pixels without signal do not contribute to any k-space sample
+            if (hasSignal)
+                m_SignalPixels.push_back(p);
+
+            // simulate eddy currents and other distortions
+            if (m_SimulateEddyCurrents)
+                m_EddyPositionFactor[p] = m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2];
+
+            if (m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull()) // simulate distortions
+            {
+                itk::Point<double, 3> point3D;
+                ItkDoubleImgType::IndexType index3D; index3D[0] = xi; index3D[1] = yi; index3D[2] = m_Zidx;
+                if (m_Parameters->m_SignalGen.m_DoAddMotion)    // we have to account for the head motion since this also moves our frequency map
+                {
+                    m_Parameters->m_SignalGen.m_FrequencyMap->TransformIndexToPhysicalPoint(index3D, point3D);
+                    point3D = m_FiberBundle->TransformPoint(point3D.GetVnlVector(), -m_Rotation[0],-m_Rotation[1],-m_Rotation[2],-m_Translation[0],-m_Translation[1],-m_Translation[2]);
+                    m_FmapOmega[p] = InterpolateFmapValue(point3D);
+                }
+                else
+                {
+                    m_FmapOmega[p] = m_Parameters->m_SignalGen.m_FrequencyMap->GetPixel(index3D);
+                }
+            }
+        }
+
+        if (y<-yMaxFov/2)
+            y += yMaxFov;
+        else if (y>=yMaxFov/2)
+            y -= yMaxFov;
+        wrappedY[yi] = y;
+    }
+
+    // phase factors of the DFT term, separated by axis
+    for (int line=0; line<2; line++)
+    {
+        m_PhaseTableX[line].resize((int)kxMax*xMax);
+        for (int kxi=0; kxi<(int)kxMax; kxi++)
+        {
+            // shift k for DFT: (0 -- N) --> (-N/2 -- N/2)
+            double kx = kxi;
+            if ((int)kxMax%2==1)
+                kx -= (kxMax-1)/2;
+            else
+                kx -= kxMax/2;
+
+            // add ghosting
+            if (line == 1)
+                kx -= m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
+            else
+                kx += m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
+
+            for (int xi=0; xi<xMax; xi++)
+            {
+                double x = xi;
+                if (xMax%2==1)
+                    x -= (xMax-1)/2;
+                else
+                    x -= xMax/2;
+                m_PhaseTableX[line][kxi*xMax+xi] = exp( std::complex<double>(0, 2 * M_PI * kx*x/xMax) );
+            }
+        }
+    }
+
+    m_PhaseTableY.resize((int)kyMax*yMax);
+    for (int kyi=0; kyi<(int)kyMax; kyi++)
+    {
+        double ky = kyi;
+        if ((int)kyMax%2==1)
+            ky -= (kyMax-1)/2;
+        else
+            ky -= kyMax/2;
+
+        for (int yi=0; yi<yMax; yi++)
+            m_PhaseTableY[kyi*yMax+yi] = exp( std::complex<double>(0, 2 * M_PI * ky*wrappedY[yi]/yMaxFov) );
+    }
 }
 
 template< class TPixelType >
@@ -168,17 +306,22 @@ void KspaceImageFilter< TPixelType >
 
     ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
 
-    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
-
     double kxMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(0);
     double kyMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(1);
-    double xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
-    double yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
-    double yMaxFov = yMax*m_Parameters->m_SignalGen.m_CroppingFactor;               // actual FOV in y-direction (in x-direction FOV=xMax)
+    int xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
+    int yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
 
     double numPix = kxMax*kyMax;
     double noiseVar = m_Parameters->m_SignalGen.m_PartialFourier*m_Parameters->m_SignalGen.m_NoiseVariance/(kyMax*kxMax); // adjust noise variance since it is the intended variance in physical space and not in k-space
 
+    unsigned int numCompartments = m_CompartmentImages.size();
+
+    // compartment images transformed along y for the current k-space line (only used without off-resonance effects)
+    vector< ComplexVectorType > columns(numCompartments, ComplexVectorType(xMax));
+    int currentKy = -1;
+
+    std::vector< double > relaxFactor(numCompartments, 1.0);
+
     while( !oit.IsAtEnd() )
     {
         // time from maximum echo
@@ -196,10 +339,9 @@ void KspaceImageFilter< TPixelType >
             eddyDecay = exp(-tRead/m_Parameters->m_SignalGen.m_Tau );
 
         // calcualte signal relaxation factors
-        std::vector< double > relaxFactor;
         if ( m_Parameters->m_SignalGen.m_DoSimulateRelaxation)
-            for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
-                relaxFactor.push_back( exp(-tRf/m_T2.at(i) -fabs(t)/ m_Parameters->m_SignalGen.m_tInhom)*(1.0-exp(-(m_Parameters->m_SignalGen.m_tRep + tRf)/m_T1.at(i))) );
+            for (unsigned int i=0; i<numCompartments; i++)
+                relaxFactor[i] = exp(-tRf/m_T2.at(i) -fabs(t)/ m_Parameters->m_SignalGen.m_tInhom)*(1.0-exp(-(m_Parameters->m_SignalGen.m_tRep + tRf)/m_T1.at(i)));
 
         // get current k-space index (depends on the schosen k-space readout scheme)
         itk::Index< 2 > kIdx = m_ReadoutScheme->GetActualKspaceIndex(oit.GetIndex());
@@ -211,86 +353,57 @@ void KspaceImageFilter< TPixelType >
 
         if (!pf)
         {
-            // shift k for DFT: (0 -- N) --> (-N/2 -- N/2)
-            double kx = kIdx[0];
-            double ky = kIdx[1];
-            if ((int)kxMax%2==1)
-                kx -= (kxMax-1)/2;
-            else
-                kx -= kxMax/2;
-            if ((int)kyMax%2==1)
-                ky -= (kyMax-1)/2;
-            else
-                ky -= kyMax/2;
-
-            // add ghosting
-            if (oit.GetIndex()[1]%2 == 1)
-                kx -= m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
-            else
-                kx += m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
+            // gradient delay induced offset (ghosting) alternates between k-space lines
+            const vcl_complex<double>* phaseX = &m_PhaseTableX[oit.GetIndex()[1]%2][kIdx[0]*xMax];
+            const vcl_complex<double>* phaseY = &m_PhaseTableY[kIdx[1]*yMax];
 
             vcl_complex<double> s(0,0);
-            InputIteratorType it(m_CompartmentImages.at(0), m_CompartmentImages.at(0)->GetLargestPossibleRegion() );
-            while( !it.IsAtEnd() )
+            if (!m_HasOffResonance)
             {
-                double x = it.GetIndex()[0];
-                double y = it.GetIndex()[1];
-                if ((int)xMax%2==1)
-                    x -= (xMax-1)/2;
-                else
-                    x -= xMax/2;
-                if ((int)yMax%2==1)
-                    y -= (yMax-1)/2;
-                else
-                    y -= yMax/2;
-
-                DoubleVectorType pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
-                pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
-
-                vcl_complex<double> f(0, 0);
-
-                // sum compartment signals and simulate relaxation
-                for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
-                    if ( m_Parameters->m_SignalGen.m_DoSimulateRelaxation)
-                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * relaxFactor.at(i) *  m_Parameters->m_SignalGen.m_SignalScale, 0);
-                    else
-                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) *  m_Parameters->m_SignalGen.m_SignalScale );
-
-                if (m_Parameters->m_SignalGen.m_CoilSensitivityProfile!=SignalGenerationParameters::COIL_CONSTANT)
-                    f *= CoilSensitivity(pos);
-
-                // simulate eddy currents and other distortions
-                double omega = 0;   // frequency offset
-                if (  m_Parameters->m_SignalGen.m_EddyStrength>0 && m_Parameters->m_Misc.m_CheckAddEddyCurrentsBox && !m_IsBaseline)
-                {
-                    omega += (m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2]) * eddyDecay;
-                }
-                if (m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull()) // simulate distortions
+                // the DFT term is separable: transform along y once per k-space line, then along x
+                if (kIdx[1] != currentKy)
                 {
-                    itk::Point<double, 3> point3D;
-                    ItkDoubleImgType::IndexType index; index[0] = it.GetIndex()[0]; index[1] = it.GetIndex()[1]; index[2] = m_Zidx;
-                    if (m_Parameters->m_SignalGen.m_DoAddMotion)    // we have to account for the head motion since this also moves our frequency map
-                    {
-                        m_Parameters->m_SignalGen.m_FrequencyMap->TransformIndexToPhysicalPoint(index, point3D);
-                        point3D = m_FiberBundle->TransformPoint(point3D.GetVnlVector(), -m_Rotation[0],-m_Rotation[1],-m_Rotation[2],-m_Translation[0],-m_Translation[1],-m_Translation[2]);
-                        omega += InterpolateFmapValue(point3D);
-                    }
-                    else
+                    for (unsigned int i=0; i<numCompartments; i++)
                     {
-                        omega += m_Parameters->m_SignalGen.m_FrequencyMap->GetPixel(index);
+                        std::fill(columns[i].begin(), columns[i].end(), vcl_complex<double>(0,0));
+                        const double* f = &m_WeightedCompartments[i][0];
+                        for (unsigned int p : m_SignalPixels)
+                            columns[i][p%xMax] += f[p] * phaseY[p/xMax];
                     }
+                    currentKy = kIdx[1];
                 }
 
-                // if signal comes from outside FOV, mirror it back (wrap-around artifact - aliasing)
-                if (y<-yMaxFov/2)
-                    y += yMaxFov;
-                else if (y>=yMaxFov/2)
-                    y -= yMaxFov;
-
-                // actual DFT term
-                s += f * exp( std::complex<double>(0, 2 * M_PI * (kx*x/xMax + ky*y/yMaxFov + omega*t/1000 )) );
-
-                ++it;
+                for (unsigned int i=0; i<numCompartments; i++)
+                {
+                    vcl_complex<double> si(0,0);
+                    const vcl_complex<double>* column = &columns[i][0];
+                    for (int x=0; x<xMax; x++)
+                        si += column[x] * phaseX[x];
+                    s += si * relaxFactor[i];
+                }
+            }
+            else
+            {
+                for (unsigned int p : m_SignalPixels)
+                {
+                    // sum compartment signals and simulate relaxation
+                    double f = 0;
+                    for (unsigned int i=0; i<numCompartments; i++)
+                        f += m_WeightedCompartments[i][p] * relaxFactor[i];
+
+                    // frequency offset
+                    double omega = 0;
+                    if (m_SimulateEddyCurrents)
+                        omega += m_EddyPositionFactor[p] * eddyDecay;
+                    if (!m_FmapOmega.empty())
+                        omega += m_FmapOmega[p];
+
+                    // actual DFT term
+                    vcl_complex<double> term = phaseX[p%xMax] * phaseY[p/xMax] * f;
+                    if (omega!=0)
+                        term *= exp( std::complex<double>(0, 2 * M_PI * omega*t/1000) );
+                    s += term;
+                }
             }
             s /= numPix;
 
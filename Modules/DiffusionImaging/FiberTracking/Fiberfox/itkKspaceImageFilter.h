@@ -44,7 +44,10 @@ namespace itk{
 * - Image distortions (off-frequency effects)
 * - Gibbs ringing
 * - Eddy current effects
-* Based on a discrete fourier transformation.
+* Based on a discrete fourier transformation. Everything that does not depend on the k-space position (weighted compartment
+* signals, wrapped coordinates, frequency offsets and the phase factors of the individual image axes) is precomputed once per
+* slice. Without off-resonance effects the transformation is separable and each thread transforms the image columns once per
+* k-space line. Eddy currents and field maps are simulated with the full sum over the (non-zero) image pixels.
 * See "Fiberfox: Facilitating the creation of realistic white matter software phantoms" (DOI: 10.1002/mrm.25045) for details.
 */
 
@@ -104,6 +107,9 @@ namespace itk{
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadID);
     void AfterThreadedGenerateData();
     double InterpolateFmapValue(itk::Point<float, 3> itkP);
+    void PrecomputeSliceData();
+
+    typedef std::vector< vcl_complex< double > >  ComplexVectorType;
 
     DoubleVectorType                        m_CoilPosition;
     FiberfoxParameters<double>*             m_Parameters;
@@ -131,6 +137,16 @@ namespace itk{
     typename InputImageType::Pointer        m_ReadoutTimeImage;
     AcquisitionType*                        m_ReadoutScheme;
 
+    // slice data that does not depend on the k-space position (see PrecomputeSliceData())
+    vector< vector< double > >              m_WeightedCompartments;     ///< compartment signal * signal scale * coil sensitivity, one row major image per compartment
+    vector< unsigned int >                  m_SignalPixels;             ///< row major indices of all pixels with signal in any compartment
+    vector< double >                        m_EddyPositionFactor;       ///< per pixel frequency offset of the eddy currents before decay
+    vector< double >                        m_FmapOmega;                ///< per pixel frequency offset of the field map
+    bool                                    m_SimulateEddyCurrents;
+    bool                                    m_HasOffResonance;
+    ComplexVectorType                       m_PhaseTableX[2];           ///< exp(2*pi*i*kx*x/xMax) for even and odd k-space lines (gradient delay ghosts), row major in kx
+    ComplexVectorType                       m_PhaseTableY;              ///< exp(2*pi*i*ky*y/yMaxFov) with wrapped y, row major in ky
+
   private:
 
   };
@@ -10,6 +10,7 @@ SET(MODULE_CUSTOM_TESTS
   mitkFiberfoxSignalGenerationTest.cpp
   mitkMachineLearningTrackingTest.cpp
   mitkFiberProcessingTest.cpp
+  mitkTractImageFilterTest.cpp
 )
 
 
@@ -0,0 +1,139 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkIOUtil.h>
+#include <itkTractDensityImageFilter.h>
+#include <itkTractsToRgbaImageFilter.h>
+
+#include "mitkTestFixture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * The tract density and RGBA images are accumulated by several threads with atomic adds. Their
+ * outputs have to match the serial (single thread) result up to the rounding of the float sums.
+ */
+class mitkTractImageFilterTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkTractImageFilterTestSuite);
+    MITK_TEST(TractDensity_Parallel_SameAsSerial);
+    MITK_TEST(TractsToRgba_Parallel_SameAsSerial);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef itk::Image<float, 3> FloatImageType;
+    typedef itk::Image<itk::RGBAPixel<unsigned char>, 3> RgbaImageType;
+
+private:
+
+    mitk::FiberBundle::Pointer  fib;
+    int                         numThreads;
+
+    FloatImageType::Pointer GetTractDensity(int threads)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        itk::TractDensityImageFilter< FloatImageType >::Pointer generator = itk::TractDensityImageFilter< FloatImageType >::New();
+        generator->SetFiberBundle(fib);
+        generator->SetUpsamplingFactor(2);
+        generator->Update();
+        return generator->GetOutput();
+    }
+
+    RgbaImageType::Pointer GetRgba(int threads)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        itk::TractsToRgbaImageFilter< RgbaImageType >::Pointer generator = itk::TractsToRgbaImageFilter< RgbaImageType >::New();
+        generator->SetFiberBundle(fib);
+        generator->SetUpsamplingFactor(2);
+        generator->Update();
+        return generator->GetOutput();
+    }
+
+public:
+
+    void setUp() override
+    {
+        fib = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::Load(GetTestDataFilePath("DiffusionImaging/FiberProcessing/original.fib")).front().GetPointer());
+        numThreads = 4;
+#ifdef _OPENMP
+        numThreads = std::max(numThreads, omp_get_num_procs());
+#endif
+    }
+
+    void tearDown() override
+    {
+        fib = NULL;
+#ifdef _OPENMP
+        omp_set_num_threads(omp_get_num_procs());
+#endif
+    }
+
+    void TractDensity_Parallel_SameAsSerial()
+    {
+        FloatImageType::Pointer serial = GetTractDensity(1);
+        FloatImageType::Pointer parallel = GetTractDensity(numThreads);
+
+        CPPUNIT_ASSERT_MESSAGE("Same output size", serial->GetLargestPossibleRegion() == parallel->GetLargestPossibleRegion());
+        const long numVoxels = serial->GetLargestPossibleRegion().GetNumberOfPixels();
+        CPPUNIT_ASSERT_MESSAGE("Density image is not empty", numVoxels>0);
+
+        const float* serialBuffer = serial->GetBufferPointer();
+        const float* parallelBuffer = parallel->GetBufferPointer();
+        bool hasFiber = false;
+        for (long i=0; i<numVoxels; i++)
+        {
+            hasFiber |= serialBuffer[i]>0;
+            CPPUNIT_ASSERT_MESSAGE("Parallel density equals serial density", std::fabs(serialBuffer[i]-parallelBuffer[i]) <= 1e-4*std::max(1.0f, std::fabs(serialBuffer[i])));
+        }
+        CPPUNIT_ASSERT_MESSAGE("Fibers are accumulated", hasFiber);
+    }
+
+    void TractsToRgba_Parallel_SameAsSerial()
+    {
+        RgbaImageType::Pointer serial = GetRgba(1);
+        RgbaImageType::Pointer parallel = GetRgba(numThreads);
+
+        CPPUNIT_ASSERT_MESSAGE("Same output size", serial->GetLargestPossibleRegion() == parallel->GetLargestPossibleRegion());
+        const long numVoxels = serial->GetLargestPossibleRegion().GetNumberOfPixels();
+        CPPUNIT_ASSERT_MESSAGE("RGBA image is not empty", numVoxels>0);
+
+        // the normalized values may be rounded differently if the sums differ in the last float bit
+        const RgbaImageType::PixelType* serialBuffer = serial->GetBufferPointer();
+        const RgbaImageType::PixelType* parallelBuffer = parallel->GetBufferPointer();
+        bool hasFiber = false;
+        for (long i=0; i<numVoxels; i++)
+            for (int c=0; c<4; c++)
+            {
+                hasFiber |= serialBuffer[i][c]>0;
+                CPPUNIT_ASSERT_MESSAGE("Parallel RGBA equals serial RGBA", std::abs(int(serialBuffer[i][c])-int(parallelBuffer[i][c])) <= 1);
+            }
+        CPPUNIT_ASSERT_MESSAGE("Fibers are accumulated", hasFiber);
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkTractImageFilter)
@@ -27,6 +27,7 @@ set(H_FILES
 
   # Algorithms
   Algorithms/itkTractDensityImageFilter.h
+  Algorithms/itkTractImageAccumulator.h
   Algorithms/itkTractsToFiberEndingsImageFilter.h
   Algorithms/itkTractsToRgbaImageFilter.h
   Algorithms/itkTractsToVectorImageFilter.h
@@ -27,6 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/algorithm/string.hpp>
 #include <itkFlipImageFilter.h>
 #include <mitkCoreObjectFactory.h>
+#include <itksys/SystemTools.hxx>
 
 template<int shOrder>
 typename itk::ShCoefficientImageImporter< float, shOrder >::QballImageType::Pointer TemplatedConvertShCoeffs(mitk::Image* mitkImg, int toolkit, bool noFlip = false)
@@ -100,6 +101,7 @@ int main(int argc, char* argv[])
     parser.addArgument("shConvention", "s", mitkCommandLineParser::String, "SH coefficient:", "sh coefficient convention (FSL, MRtrix)", string("FSL"), true);
     parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib)", us::Any(), false);
     parser.addArgument("noFlip", "f", mitkCommandLineParser::Bool, "No flip:", "do not flip input image to match MITK coordinate convention");
+    parser.addArgument("chains", "c", mitkCommandLineParser::Int, "Chains:", "number of independent chains sampled in parallel, chain c>0 is saved as <outFile>_chain<c>", 1);
 
     map<string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -113,6 +115,10 @@ int main(int argc, char* argv[])
     if (parsedArgs.count("noFlip"))
         noFlip = us::any_cast<bool>(parsedArgs["noFlip"]);
 
+    int numChains = 1;
+    if (parsedArgs.count("chains"))
+        numChains = us::any_cast<int>(parsedArgs["chains"]);
+
     try
     {
         // instantiate gibbs tracker
@@ -213,13 +219,28 @@ int main(int argc, char* argv[])
 
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
+        gibbsTracker->SetNumberOfChains( numChains );
 //        gibbsTracker->SetLutPath( "" );
         gibbsTracker->Update();
+        std::cout << "Proposals per second: " << gibbsTracker->GetProposalsPerSecond() << std::endl;
 
         mitk::FiberBundle::Pointer mitkFiberBundle = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
         mitkFiberBundle->SetReferenceGeometry(mitkImage->GetGeometry());
 
         mitk::IOUtil::SaveBaseData(mitkFiberBundle.GetPointer(), outFileName );
+
+        // every further chain is an independent tractogram
+        std::string outPath = itksys::SystemTools::GetFilenamePath(outFileName);
+        std::string outName = itksys::SystemTools::GetFilenameWithoutLastExtension(outFileName);
+        std::string outExt = itksys::SystemTools::GetFilenameLastExtension(outFileName);
+        if (!outPath.empty())
+            outPath += "/";
+        for (int c=1; c<numChains; c++)
+        {
+            mitk::FiberBundle::Pointer chainFiberBundle = mitk::FiberBundle::New(gibbsTracker->GetChainFiberBundle(c));
+            chainFiberBundle->SetReferenceGeometry(mitkImage->GetGeometry());
+            mitk::IOUtil::SaveBaseData(chainFiberBundle.GetPointer(), outPath + outName + "_chain" + std::to_string(c) + outExt );
+        }
     }
     catch (itk::ExceptionObject e)
     {
@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImageCast.h>
 #include <mitkProperties.h>
 #include <mitkIOUtil.h>
+#include <itkTimeProbe.h>
 
 using namespace mitk;
 
@@ -96,6 +97,9 @@ int main(int argc, char* argv[])
         std::cout << "SH order: " << shOrder;
         std::cout << "lambda: " << lambda;
         std::cout << "B0 threshold: " << threshold;
+
+        // measures the reconstruction only, without loading and casting the image
+        itk::TimeProbe clock;
         switch ( shOrder )
         {
         case 4:
@@ -114,7 +118,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -137,7 +143,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -160,7 +168,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -183,7 +193,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -205,7 +217,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -229,7 +243,9 @@ int main(int argc, char* argv[])
                 filter->SetNormalizationMethod(FilterType::QBAR_STANDARD);
             else
                 filter->SetNormalizationMethod(FilterType::QBAR_SOLID_ANGLE);
+            clock.Start();
             filter->Update();
+            clock.Stop();
             image->InitializeByItk( filter->GetOutput() );
             image->SetVolume( filter->GetOutput()->GetBufferPointer() );
             coeffsImage->InitializeByItk( filter->GetCoefficientImage().GetPointer() );
@@ -237,6 +253,11 @@ int main(int argc, char* argv[])
         }
         }
 
+        double numberOfVoxels = (double)dwi->GetDimension(0)*dwi->GetDimension(1)*dwi->GetDimension(2);
+        std::cout << "Reconstruction time: " << clock.GetTotal() << " s" << std::endl;
+        if (clock.GetTotal()>0)
+            std::cout << "Voxels per second: " << numberOfVoxels/clock.GetTotal() << std::endl;
+
         std::string coeffout = outfilename;
         coeffout += "_shcoeffs.nrrd";
 
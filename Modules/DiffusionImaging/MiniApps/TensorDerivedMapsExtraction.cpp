@@ -37,66 +37,32 @@
 typedef short DiffusionPixelType;
 typedef double TTensorPixelType;
 
-static void ExtractMapsAndSave(mitk::TensorImage::Pointer tensorImage, std::string filename, std::string postfix = "")
-{
-
-  mitk::Image* image = dynamic_cast<mitk::Image*> (tensorImage.GetPointer());
-
-  typedef itk::DiffusionTensor3D< TTensorPixelType >  TensorPixelType;
-  typedef itk::Image< TensorPixelType, 3 > TensorImageType;
+typedef itk::Image< itk::DiffusionTensor3D< TTensorPixelType >, 3 > TensorImageType;
 
-  TensorImageType::Pointer itkvol = TensorImageType::New();
-  mitk::CastToItkImage(image, itkvol);
+static void SaveMap(itk::Image< TTensorPixelType, 3 >* itkMap, std::string filename)
+{
+  mitk::Image::Pointer map = mitk::Image::New();
+  map->InitializeByItk( itkMap );
+  map->SetVolume( itkMap->GetBufferPointer() );
+  mitk::IOUtil::SaveImage(map, filename);
+}
 
+static void ExtractMapsAndSave(TensorImageType* tensorImage, std::string filename, std::string postfix = "")
+{
   typedef itk::TensorDerivedMeasurementsFilter<TTensorPixelType> MeasurementsType;
 
+  // all maps are computed in a single pass over the tensor image
   MeasurementsType::Pointer measurementsCalculator = MeasurementsType::New();
-  measurementsCalculator->SetInput(itkvol.GetPointer() );
-
-  mitk::Image::Pointer map = mitk::Image::New();
-  // FA
-  measurementsCalculator->SetMeasure(MeasurementsType::FA);
-  measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_FA" + postfix + ".nrrd");
-
-  // MD
-  measurementsCalculator->SetMeasure(MeasurementsType::MD);
+  measurementsCalculator->SetInput( tensorImage );
+  measurementsCalculator->ComputeAllMeasuresOn();
   measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_MD" + postfix + ".nrrd");
-
-  // AD
-  measurementsCalculator->SetMeasure(MeasurementsType::AD);
-  measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_AD" + postfix + ".nrrd");
-
-
-  // CA
-  measurementsCalculator->SetMeasure(MeasurementsType::CA);
-  measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_CA" + postfix + ".nrrd");
-
-  // RA
-  measurementsCalculator->SetMeasure(MeasurementsType::RA);
-  measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_RA" + postfix + ".nrrd");
-
-  // RD
-  measurementsCalculator->SetMeasure(MeasurementsType::RD);
-  measurementsCalculator->Update();
-  map->InitializeByItk( measurementsCalculator->GetOutput() );
-  map->SetVolume( measurementsCalculator->GetOutput()->GetBufferPointer() );
-  mitk::IOUtil::SaveImage(map, filename + "_dti_RD" + postfix + ".nrrd");
 
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::FA), filename + "_dti_FA" + postfix + ".nrrd");
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::MD), filename + "_dti_MD" + postfix + ".nrrd");
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::AD), filename + "_dti_AD" + postfix + ".nrrd");
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::CA), filename + "_dti_CA" + postfix + ".nrrd");
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::RA), filename + "_dti_RA" + postfix + ".nrrd");
+  SaveMap(measurementsCalculator->GetMeasureOutput(MeasurementsType::RD), filename + "_dti_RD" + postfix + ".nrrd");
 }
 
 
@@ -148,15 +114,9 @@ int main(int argc, char* argv[])
   tensorReconstructionFilter->SetThreshold(50);
   tensorReconstructionFilter->Update();
 
-  typedef itk::Image<itk::DiffusionTensor3D<TTensorPixelType>, 3> TensorImageType;
   TensorImageType::Pointer tensorImage = tensorReconstructionFilter->GetOutput();
   tensorImage->SetDirection( itkVectorImagePointer->GetDirection() );
 
-  mitk::TensorImage::Pointer tensorImageMitk = mitk::TensorImage::New();
-  tensorImageMitk->InitializeByItk(tensorImage.GetPointer());
-  tensorImageMitk->SetVolume( tensorImage->GetBufferPointer() );
-
-
 
   itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
   io->SetFileType( itk::ImageIOBase::Binary );
@@ -169,7 +129,7 @@ int main(int argc, char* argv[])
   writer->UseCompressionOn();
   writer->Update();
 
-  ExtractMapsAndSave(tensorImageMitk,baseFileName);
+  ExtractMapsAndSave(tensorImage,baseFileName);
 
   return EXIT_SUCCESS;
 
@@ -1,5 +1,6 @@
 set(MODULE_TESTS
   mitkPythonTest.cpp
+  mitkNumpyPythonTest.cpp
 )
 
 #TODO: temporarily disabled untill segfault is fixed (bug-19152)
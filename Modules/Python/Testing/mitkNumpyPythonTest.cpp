@@ -0,0 +1,173 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#include <mitkImageReadAccessor.h>
+#include <mitkImagePixelReadAccessor.h>
+#include <mitkCommonPythonTest.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+
+#include <sstream>
+
+class mitkNumpyPythonTestSuite : public mitk::CommonPythonTestSuite
+{
+  CPPUNIT_TEST_SUITE(mitkNumpyPythonTestSuite);
+  MITK_TEST(testImageAsNumpyArray);
+  MITK_TEST(testWritableImageAsNumpyArray);
+  MITK_TEST(testNumpyArrayAsImage);
+  MITK_TEST(testVectorNumpyArrayAsImage);
+  MITK_TEST(testSurfaceAsNumpyArrays);
+  MITK_TEST(testNumpyArraysAsSurface);
+  CPPUNIT_TEST_SUITE_END();
+
+  static std::string AddressToString(const void* address)
+  {
+    std::ostringstream ss;
+    ss << reinterpret_cast<std::size_t>(address);
+    return ss.str();
+  }
+
+public:
+
+  void testImageAsNumpyArray()
+  {
+    m_PythonService->Execute( "import numpy", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Is numpy available?", !m_PythonService->PythonErrorOccured() );
+
+    CPPUNIT_ASSERT_MESSAGE( "Valid image wrapped as numpy array should return true.",
+          m_PythonService->WrapImageAsNumpyArray( m_Image, "mitkImage_array" ) == true );
+
+    std::ostringstream shape;
+    shape << "(" << m_Image->GetDimension(2) << ", " << m_Image->GetDimension(1) << ", " << m_Image->GetDimension(0) << ")";
+    CPPUNIT_ASSERT_EQUAL( shape.str(), m_PythonService->Execute( "str(mitkImage_array.shape)", mitk::IPythonService::EVAL_COMMAND ) );
+
+    mitk::ImageReadAccessor accessor(m_Image);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The array uses the image memory.", AddressToString(accessor.GetData()),
+          m_PythonService->Execute( "str(mitkImage_array.ctypes.data)", mitk::IPythonService::EVAL_COMMAND ) );
+
+    m_PythonService->Execute( "mitkImage_array[0, 0, 0] = 1", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "The array is read only.", m_PythonService->PythonErrorOccured() );
+    m_PythonService->Execute( "del mitkImage_array", mitk::IPythonService::SINGLE_LINE_COMMAND );
+  }
+
+  void testWritableImageAsNumpyArray()
+  {
+    m_PythonService->Execute( "import numpy", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Valid image wrapped as writable numpy array should return true.",
+          m_PythonService->WrapImageAsNumpyArray( m_Image, "mitkImage_array", true ) == true );
+
+    const unsigned long mTime = m_Image->GetMTime();
+    m_PythonService->Execute( "mitkImage_array[0, 0, 0] = 7", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "The array is writable.", !m_PythonService->PythonErrorOccured() );
+
+    // releasing the array releases the write lock and marks the image as modified
+    m_PythonService->Execute( "del mitkImage_array", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "The image is modified after the array was released.", m_Image->GetMTime() > mTime );
+
+    CPPUNIT_ASSERT( m_PythonService->WrapImageAsNumpyArray( m_Image, "mitkImage_array" ) );
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The image holds the written value.", std::string("7"),
+          m_PythonService->Execute( "str(int(mitkImage_array[0, 0, 0]))", mitk::IPythonService::EVAL_COMMAND ) );
+    m_PythonService->Execute( "del mitkImage_array", mitk::IPythonService::SINGLE_LINE_COMMAND );
+  }
+
+  void testNumpyArrayAsImage()
+  {
+    m_PythonService->Execute( "import numpy\nnumpyImage = numpy.arange(24, dtype=numpy.int16).reshape(2, 3, 4)",
+          mitk::IPythonService::MULTI_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Python execute error occured.", !m_PythonService->PythonErrorOccured() );
+    const std::string address = m_PythonService->Execute( "str(numpyImage.ctypes.data)", mitk::IPythonService::EVAL_COMMAND );
+
+    mitk::Image::Pointer image = m_PythonService->WrapNumpyArrayAsImage( "numpyImage" );
+    CPPUNIT_ASSERT_MESSAGE( "Image was created.", image.IsNotNull() );
+    CPPUNIT_ASSERT_EQUAL( 4u, image->GetDimension(0) );
+    CPPUNIT_ASSERT_EQUAL( 3u, image->GetDimension(1) );
+    CPPUNIT_ASSERT_EQUAL( 2u, image->GetDimension(2) );
+
+    // the image keeps the array alive
+    m_PythonService->Execute( "del numpyImage", mitk::IPythonService::SINGLE_LINE_COMMAND );
+
+    mitk::ImageReadAccessor accessor(image);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The image uses the array memory.", address, AddressToString(accessor.GetData()) );
+
+    mitk::ImagePixelReadAccessor<short, 3> pixelAccessor(image);
+    itk::Index<3> index = {{ 1, 2, 1 }};
+    CPPUNIT_ASSERT_EQUAL( short(21), pixelAccessor.GetPixelByIndex(index) );
+  }
+
+  void testVectorNumpyArrayAsImage()
+  {
+    m_PythonService->Execute( "import numpy\nnumpyImage = numpy.arange(72, dtype=numpy.float32).reshape(2, 3, 4, 3)",
+          mitk::IPythonService::MULTI_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Python execute error occured.", !m_PythonService->PythonErrorOccured() );
+
+    mitk::Image::Pointer image = m_PythonService->WrapNumpyArrayAsImage( "numpyImage" );
+    CPPUNIT_ASSERT_MESSAGE( "Image was created.", image.IsNotNull() );
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The last axis holds the components.", 3u, image->GetDimension() );
+    CPPUNIT_ASSERT_EQUAL( std::size_t(3), image->GetPixelType().GetNumberOfComponents() );
+    CPPUNIT_ASSERT_EQUAL( 4u, image->GetDimension(0) );
+    CPPUNIT_ASSERT_EQUAL( 3u, image->GetDimension(1) );
+    CPPUNIT_ASSERT_EQUAL( 2u, image->GetDimension(2) );
+    m_PythonService->Execute( "del numpyImage", mitk::IPythonService::SINGLE_LINE_COMMAND );
+
+    // wrapping the image again yields the layout of the original array
+    CPPUNIT_ASSERT( m_PythonService->WrapImageAsNumpyArray( image, "mitkImage_array" ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("(2, 3, 4, 3)"), m_PythonService->Execute( "str(mitkImage_array.shape)", mitk::IPythonService::EVAL_COMMAND ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("71"), m_PythonService->Execute( "str(int(mitkImage_array[1, 2, 3, 2]))", mitk::IPythonService::EVAL_COMMAND ) );
+    m_PythonService->Execute( "del mitkImage_array", mitk::IPythonService::SINGLE_LINE_COMMAND );
+  }
+
+  void testSurfaceAsNumpyArrays()
+  {
+    m_PythonService->Execute( "import numpy", mitk::IPythonService::SINGLE_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Valid surface wrapped as numpy arrays should return true.",
+          m_PythonService->WrapSurfaceAsNumpyArrays( m_Surface, "mitkSurface" ) == true );
+
+    std::ostringstream numberOfPoints;
+    numberOfPoints << m_Surface->GetVtkPolyData()->GetNumberOfPoints();
+    CPPUNIT_ASSERT_EQUAL( numberOfPoints.str(), m_PythonService->Execute( "str(mitkSurface_points.shape[0])", mitk::IPythonService::EVAL_COMMAND ) );
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The array uses the point memory.",
+          AddressToString(m_Surface->GetVtkPolyData()->GetPoints()->GetVoidPointer(0)),
+          m_PythonService->Execute( "str(mitkSurface_points.ctypes.data)", mitk::IPythonService::EVAL_COMMAND ) );
+  }
+
+  void testNumpyArraysAsSurface()
+  {
+    m_PythonService->Execute( "import numpy\n"
+                              "numpySurface_points = numpy.array([[0, 0, 0], [1, 0, 0], [0, 1, 0], [0, 0, 1]], dtype=numpy.float32)\n"
+                              "numpySurface_polys = numpy.array([3, 0, 1, 2, 3, 0, 1, 3])",
+          mitk::IPythonService::MULTI_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Python execute error occured.", !m_PythonService->PythonErrorOccured() );
+    const std::string address = m_PythonService->Execute( "str(numpySurface_points.ctypes.data)", mitk::IPythonService::EVAL_COMMAND );
+
+    mitk::Surface::Pointer surface = m_PythonService->WrapNumpyArraysAsSurface( "numpySurface" );
+    CPPUNIT_ASSERT_MESSAGE( "Surface was created.", surface.IsNotNull() );
+
+    // the surface keeps the arrays alive
+    m_PythonService->Execute( "del numpySurface_points\ndel numpySurface_polys", mitk::IPythonService::MULTI_LINE_COMMAND );
+
+    vtkPolyData* polyData = surface->GetVtkPolyData();
+    CPPUNIT_ASSERT_EQUAL( vtkIdType(4), polyData->GetNumberOfPoints() );
+    CPPUNIT_ASSERT_EQUAL( vtkIdType(2), polyData->GetNumberOfPolys() );
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "The points use the array memory.", address,
+          AddressToString(polyData->GetPoints()->GetVoidPointer(0)) );
+    CPPUNIT_ASSERT_EQUAL( 1.0, polyData->GetPoint(3)[2] );
+
+    m_PythonService->Execute( "numpySurface_points = numpy.zeros((4, 2))\nnumpySurface_polys = numpy.array([3, 0, 1, 2])",
+          mitk::IPythonService::MULTI_LINE_COMMAND );
+    CPPUNIT_ASSERT_MESSAGE( "Points that are not n x 3 are rejected.", m_PythonService->WrapNumpyArraysAsSurface( "numpySurface" ).IsNull() );
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkNumpyPython)
@@ -102,11 +102,13 @@ namespace mitk
         virtual bool IsSimpleItkPythonWrappingAvailable() = 0;
         ///
         /// copies an mitk image as itk image into the python interpreter process
-        /// the image will be available as "varName" in python if everythin worked
+        /// the image will be available as "varName" in python if everythin worked.
+        /// SimpleITK owns its pixel buffer, so the pixels are copied once.
         /// \return true if image was copied, else false
         virtual bool CopyToPythonAsSimpleItkImage( mitk::Image* image, const std::string& varName ) = 0;
         ///
-        /// copies an itk image from the python process that is named "varName"
+        /// copies an itk image from the python process that is named "varName".
+        /// The pixels are copied once by sitk.GetArrayFromImage, the image uses that copy.
         /// \return the image or 0 if copying was not possible
         virtual mitk::Image::Pointer CopySimpleItkImageFromPython( const std::string& varName ) = 0;
 
@@ -130,6 +132,33 @@ namespace mitk
         /// \see CopyCvImageFromPython()
         virtual mitk::Surface::Pointer CopyVtkPolyDataFromPython( const std::string& varName ) = 0;
 
+        ///
+        /// makes the first volume of an image available as numpy array "varName" (dimensions in z, y, x order)
+        /// without copying it. The array views the image memory and keeps it alive. It holds a read lock
+        /// (a write lock if writable is true) on the image until it is released; the image is marked as
+        /// modified when a writable array is released.
+        /// \return true if the array was created, else false
+        virtual bool WrapImageAsNumpyArray( mitk::Image* image, const std::string& varName, bool writable = false ) = 0;
+        ///
+        /// creates an image that references the memory of the numpy array "varName" instead of copying it
+        /// (like mitk::Image::ReferenceMemory). The image keeps the array alive. Arrays that are not
+        /// contiguous are copied once. The last axis of a 4d array with 2 to 4 values is taken as
+        /// pixel components (z, y, x, component), as in the arrays of WrapImageAsNumpyArray().
+        /// \return the image or 0 if the array has an unsupported type or dimension
+        virtual mitk::Image::Pointer WrapNumpyArrayAsImage( const std::string& varName ) = 0;
+        ///
+        /// makes the points (n x 3) and the polygon connectivity (vtkCellArray layout) of a surface available
+        /// as numpy arrays "varName_points" and "varName_polys" without copying them.
+        /// \return true if the arrays were created, else false
+        virtual bool WrapSurfaceAsNumpyArrays( mitk::Surface* surface, const std::string& varName ) = 0;
+        ///
+        /// creates a surface from the numpy arrays "varName_points" (n x 3, float or double) and "varName_polys"
+        /// (polygon connectivity in vtkCellArray layout) that references their memory instead of copying it.
+        /// The surface keeps the arrays alive. Arrays that are not contiguous or whose connectivity type is not
+        /// vtkIdType are copied once.
+        /// \return the surface or 0 if the arrays are missing or have an unsupported type or shape
+        virtual mitk::Surface::Pointer WrapNumpyArraysAsSurface( const std::string& varName ) = 0;
+
         ///
         /// nothing to do here
         virtual ~IPythonService(); // leer in mitkIPythonService.cpp implementieren
@@ -26,11 +26,322 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImageReadAccessor.h>
 #include <mitkImageWriteAccessor.h>
 #include <numpy/arrayobject.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkIdTypeArray.h>
+#include <vtkFloatArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+#include <itkCommand.h>
+#include <itkVectorImage.h>
+#include <algorithm>
 
 #ifndef WIN32
   #include <dlfcn.h>
 #endif
 
+namespace
+{
+  // the numpy C API has to be imported in every translation unit that uses it
+  bool ImportNumpy()
+  {
+    import_array1(false);
+    return true;
+  }
+
+  // numpy type of the pixel components, -1 if there is none
+  int GetNumpyType(const mitk::PixelType& pixelType)
+  {
+    switch( pixelType.GetComponentType() )
+    {
+      case itk::ImageIOBase::DOUBLE: return NPY_DOUBLE;
+      case itk::ImageIOBase::FLOAT:  return NPY_FLOAT;
+      case itk::ImageIOBase::SHORT:  return NPY_SHORT;
+      case itk::ImageIOBase::CHAR:   return NPY_BYTE;
+      case itk::ImageIOBase::INT:    return NPY_INT;
+      case itk::ImageIOBase::LONG:   return NPY_LONG;
+      case itk::ImageIOBase::UCHAR:  return NPY_UBYTE;
+      case itk::ImageIOBase::UINT:   return NPY_UINT;
+      case itk::ImageIOBase::ULONG:  return NPY_ULONG;
+      case itk::ImageIOBase::USHORT: return NPY_USHORT;
+      default: return -1;
+    }
+  }
+
+  template <typename T>
+  mitk::PixelType MakeNumpyPixelType(unsigned int numberOfComponents)
+  {
+    if( numberOfComponents > 1 )
+      return mitk::MakePixelType< itk::VectorImage<T, 3> >(numberOfComponents);
+    return mitk::MakeScalarPixelType<T>();
+  }
+
+  bool GetPixelType(int numpyType, unsigned int numberOfComponents, mitk::PixelType& pixelType)
+  {
+    switch( numpyType )
+    {
+      case NPY_DOUBLE: pixelType = MakeNumpyPixelType<double>(numberOfComponents); return true;
+      case NPY_FLOAT:  pixelType = MakeNumpyPixelType<float>(numberOfComponents); return true;
+      case NPY_SHORT:  pixelType = MakeNumpyPixelType<short>(numberOfComponents); return true;
+      case NPY_BYTE:   pixelType = MakeNumpyPixelType<char>(numberOfComponents); return true;
+      case NPY_INT:    pixelType = MakeNumpyPixelType<int>(numberOfComponents); return true;
+      case NPY_LONG:   pixelType = MakeNumpyPixelType<long>(numberOfComponents); return true;
+      case NPY_UBYTE:  pixelType = MakeNumpyPixelType<unsigned char>(numberOfComponents); return true;
+      case NPY_UINT:   pixelType = MakeNumpyPixelType<unsigned int>(numberOfComponents); return true;
+      case NPY_ULONG:  pixelType = MakeNumpyPixelType<unsigned long>(numberOfComponents); return true;
+      case NPY_USHORT: pixelType = MakeNumpyPixelType<unsigned short>(numberOfComponents); return true;
+      default: return false;
+    }
+  }
+
+  // owner of the memory that a numpy array views, stored in a capsule that is the base object of the array.
+  // The accessor holds the image lock as long as the array exists.
+  struct ImageMemoryOwner
+  {
+    ImageMemoryOwner()
+      : WriteAccessor(NULL)
+      , ReadAccessor(NULL)
+    {
+    }
+
+    ~ImageMemoryOwner()
+    {
+      delete ReadAccessor;
+      if( WriteAccessor != NULL )
+      {
+        delete WriteAccessor;
+        // python may have changed the values
+        Image->Modified();
+      }
+    }
+
+    mitk::Image::Pointer Image;
+    mitk::ImageDataItem::Pointer Volume;
+    mitk::ImageWriteAccessor* WriteAccessor;
+    mitk::ImageReadAccessor* ReadAccessor;
+  };
+
+  void ReleaseImageMemoryOwner(PyObject* capsule)
+  {
+    delete static_cast<ImageMemoryOwner*>( PyCapsule_GetPointer(capsule, "mitk.Image") );
+  }
+
+  void ReleasePolyData(PyObject* capsule)
+  {
+    static_cast<vtkPolyData*>( PyCapsule_GetPointer(capsule, "vtkPolyData") )->UnRegister(NULL);
+  }
+
+  // drops the reference of an image on the numpy array whose memory it uses
+  void ReleaseNumpyArray(itk::Object*, const itk::EventObject&, void* array)
+  {
+    PyGILState_STATE state = PyGILState_Ensure();
+    Py_DECREF( static_cast<PyObject*>(array) );
+    PyGILState_Release(state);
+  }
+
+  // numpy array viewing data, owner is stolen and kept alive as long as the array
+  PyObject* CreateArrayView(int nd, npy_intp* dims, int type, void* data, bool writable, PyObject* owner)
+  {
+    if( owner == NULL )
+      return NULL;
+
+    PyObject* array = PyArray_SimpleNewFromData(nd, dims, type, data);
+    if( array == NULL )
+    {
+      Py_DECREF(owner);
+      return NULL;
+    }
+    if( PyArray_SetBaseObject((PyArrayObject*) array, owner) != 0 )
+    {
+      Py_DECREF(array);
+      return NULL;
+    }
+    if( !writable )
+      PyArray_CLEARFLAGS((PyArrayObject*) array, NPY_ARRAY_WRITEABLE);
+    return array;
+  }
+
+  // numpy array viewing the first volume of the image (z, y, x[, component])
+  PyObject* CreateImageArrayView(mitk::Image* image, bool writable)
+  {
+    const mitk::PixelType pixelType = image->GetPixelType();
+    const int type = GetNumpyType(pixelType);
+    if( type < 0 )
+    {
+      MITK_WARN << "Unsupported pixel type " << pixelType.GetComponentTypeAsString();
+      return NULL;
+    }
+
+    ImageMemoryOwner* owner = new ImageMemoryOwner;
+    owner->Image = image;
+    owner->Volume = image->GetVolumeData(0);
+    void* data = NULL;
+    if( writable )
+    {
+      owner->WriteAccessor = new mitk::ImageWriteAccessor(image, owner->Volume);
+      data = owner->WriteAccessor->GetData();
+    }
+    else
+    {
+      owner->ReadAccessor = new mitk::ImageReadAccessor(image, owner->Volume);
+      data = const_cast<void*>( owner->ReadAccessor->GetData() );
+    }
+
+    npy_intp dims[4];
+    int nd = 0;
+    for( int i = std::min(image->GetDimension(), 3u) - 1; i >= 0; --i )
+      dims[nd++] = image->GetDimension(i);
+    if( pixelType.GetNumberOfComponents() > 1 )
+      dims[nd++] = pixelType.GetNumberOfComponents();
+
+    return CreateArrayView(nd, dims, type, data, writable,
+                           PyCapsule_New(owner, "mitk.Image", &ReleaseImageMemoryOwner));
+  }
+
+  // image using the memory of a numpy array instead of a copy
+  mitk::Image::Pointer CreateImageOfArray(PyObject* object)
+  {
+    if( object == NULL || !PyArray_Check(object) )
+      return NULL;
+
+    // a new reference; only arrays that are not contiguous or not in native byte order are copied
+    PyArrayObject* array = (PyArrayObject*) PyArray_FROM_OF(object, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_NOTSWAPPED);
+    if( array == NULL )
+      return NULL;
+
+    // a trailing axis of 2 to 4 values of a 4d array holds the components, as in the arrays of
+    // CreateImageArrayView (z, y, x, component)
+    int nd = PyArray_NDIM(array);
+    unsigned int numberOfComponents = 1;
+    if( nd == 4 && PyArray_DIMS(array)[3] >= 2 && PyArray_DIMS(array)[3] <= 4 )
+      numberOfComponents = PyArray_DIMS(array)[--nd];
+
+    mitk::PixelType pixelType = mitk::MakeScalarPixelType<short>();
+    if( !GetPixelType(PyArray_TYPE(array), numberOfComponents, pixelType) || nd < 2 || nd > 4 )
+    {
+      MITK_WARN << "Unsupported numpy array of type " << PyArray_TYPE(array) << " and dimension " << PyArray_NDIM(array);
+      Py_DECREF(array);
+      return NULL;
+    }
+
+    // numpy stores the dimensions in opposite order
+    unsigned int dimensions[4];
+    for( int i = 0; i < nd; ++i )
+      dimensions[i] = PyArray_DIMS(array)[nd - 1 - i];
+
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(pixelType, nd, dimensions);
+    image->SetImportChannel(PyArray_DATA(array), 0, mitk::Image::ReferenceMemory);
+
+    itk::CStyleCommand::Pointer releaseCommand = itk::CStyleCommand::New();
+    releaseCommand->SetClientData(array);
+    releaseCommand->SetCallback(&ReleaseNumpyArray);
+    image->AddObserver(itk::DeleteEvent(), releaseCommand);
+
+    return image;
+  }
+
+  // drops the reference of a vtk array on the numpy array whose memory it uses
+  void ReleaseNumpyArrayOfVtkArray(vtkObject*, unsigned long, void* array, void*)
+  {
+    PyGILState_STATE state = PyGILState_Ensure();
+    Py_DECREF( static_cast<PyObject*>(array) );
+    PyGILState_Release(state);
+  }
+
+  // lets the vtk array use the memory of the numpy array, the reference of array is stolen
+  void ReferenceNumpyArray(vtkDataArray* vtkArray, PyArrayObject* array)
+  {
+    // save = 1: vtk does not free the memory
+    vtkArray->SetVoidArray(PyArray_DATA(array), PyArray_SIZE(array), 1);
+
+    vtkSmartPointer<vtkCallbackCommand> releaseCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+    releaseCommand->SetClientData(array);
+    releaseCommand->SetCallback(&ReleaseNumpyArrayOfVtkArray);
+    vtkArray->AddObserver(vtkCommand::DeleteEvent, releaseCommand);
+  }
+
+  // poly data using the memory of a points (n x 3) and a connectivity array instead of copies
+  vtkSmartPointer<vtkPolyData> CreatePolyDataOfArrays(PyObject* pointsObject, PyObject* polysObject)
+  {
+    if( pointsObject == NULL || polysObject == NULL || !PyArray_Check(pointsObject) || !PyArray_Check(polysObject) )
+      return NULL;
+
+    // new references; arrays are only copied if they are not contiguous, not in native byte order or of another type
+    const int pointType = PyArray_TYPE((PyArrayObject*) pointsObject) == NPY_FLOAT ? NPY_FLOAT : NPY_DOUBLE;
+    PyArrayObject* pointArray = (PyArrayObject*) PyArray_FROM_OTF(pointsObject, pointType, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_NOTSWAPPED);
+    if( pointArray == NULL )
+      return NULL;
+    if( PyArray_NDIM(pointArray) != 2 || PyArray_DIMS(pointArray)[1] != 3 )
+    {
+      MITK_WARN << "Points have to be given as n x 3 array";
+      Py_DECREF(pointArray);
+      return NULL;
+    }
+    PyArrayObject* polyArray = (PyArrayObject*) PyArray_FROM_OTF(polysObject, sizeof(vtkIdType) == 8 ? NPY_INT64 : NPY_INT32,
+                                                                 NPY_ARRAY_IN_ARRAY | NPY_ARRAY_NOTSWAPPED);
+    if( polyArray == NULL )
+    {
+      Py_DECREF(pointArray);
+      return NULL;
+    }
+    if( PyArray_NDIM(polyArray) != 1 )
+    {
+      MITK_WARN << "Polygon connectivity has to be given as one dimensional array";
+      Py_DECREF(pointArray);
+      Py_DECREF(polyArray);
+      return NULL;
+    }
+
+    vtkSmartPointer<vtkDataArray> pointData;
+    if( pointType == NPY_FLOAT )
+      pointData = vtkSmartPointer<vtkFloatArray>::New();
+    else
+      pointData = vtkSmartPointer<vtkDoubleArray>::New();
+    pointData->SetNumberOfComponents(3);
+    const npy_intp numberOfPolyEntries = PyArray_SIZE(polyArray);
+    ReferenceNumpyArray(pointData, pointArray);
+
+    vtkSmartPointer<vtkIdTypeArray> polyData = vtkSmartPointer<vtkIdTypeArray>::New();
+    ReferenceNumpyArray(polyData, polyArray);
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(pointData);
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    // the number of cells is counted in the connectivity
+    vtkIdType numberOfPolys = 0;
+    const vtkIdType* connectivity = polyData->GetPointer(0);
+    for( npy_intp i = 0; i < numberOfPolyEntries; i += connectivity[i] + 1 )
+    {
+      if( connectivity[i] < 0 || i + connectivity[i] >= numberOfPolyEntries )
+      {
+        MITK_WARN << "Invalid polygon connectivity";
+        return NULL;
+      }
+      ++numberOfPolys;
+    }
+    polys->SetCells(numberOfPolys, polyData);
+
+    vtkSmartPointer<vtkPolyData> result = vtkSmartPointer<vtkPolyData>::New();
+    result->SetPoints(points);
+    result->SetPolys(polys);
+    return result;
+  }
+
+  // adds the object to the python __main__ namespace, the reference of object is stolen
+  bool SetMainVariable(const std::string& name, PyObject* object)
+  {
+    if( object == NULL )
+      return false;
+
+    PyObject *pyDict = PyModule_GetDict( PyImport_AddModule((char*)"__main__") );
+    const int status = PyDict_SetItemString(pyDict, name.c_str(), object);
+    Py_DECREF(object);
+    return status == 0;
+  }
+}
+
 const QString mitk::PythonService::m_TmpDataFileName("temp_mitk_data_file");
 #ifdef USE_MITK_BUILTIN_PYTHON
   static char* pHome = NULL;
@@ -277,20 +588,10 @@ bool mitk::PythonService::CopyToPythonAsSimpleItkImage(mitk::Image *image, const
   QString varName = QString::fromStdString( stdvarName );
   QString command;
   unsigned int* imgDim = image->GetDimensions();
-  int npy_nd = 1;
-  npy_intp* npy_dims = new npy_intp[1];
-  npy_dims[0] = imgDim[0] * imgDim[1] * imgDim[2];
-  // access python module
-  PyObject *pyMod = PyImport_AddModule((char*)"__main__");
-  // global dictionarry
-  PyObject *pyDict = PyModule_GetDict(pyMod);
   const mitk::Vector3D spacing = image->GetGeometry()->GetSpacing();
   const mitk::Point3D origin = image->GetGeometry()->GetOrigin();
   mitk::PixelType pixelType = image->GetPixelType();
   itk::ImageIOBase::IOPixelType ioPixelType = image->GetPixelType().GetPixelType();
-  PyObject* npyArray = NULL;
-  mitk::ImageReadAccessor racc(image);
-  void* array = (void*) racc.GetData();
 
   mitk::Vector3D xDirection;
   mitk::Vector3D yDirection;
@@ -309,39 +610,28 @@ bool mitk::PythonService::CopyToPythonAsSimpleItkImage(mitk::Image *image, const
   zDirection.Normalize();
 
   // default pixeltype: unsigned short
-  NPY_TYPES npy_type  = NPY_USHORT;
   std::string sitk_type = "sitkUInt8";
   if( ioPixelType == itk::ImageIOBase::SCALAR )
   {
     if( pixelType.GetComponentType() == itk::ImageIOBase::DOUBLE ) {
-      npy_type = NPY_DOUBLE;
       sitk_type = "sitkFloat64";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::FLOAT ) {
-      npy_type = NPY_FLOAT;
       sitk_type = "sitkFloat32";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::SHORT) {
-      npy_type = NPY_SHORT;
       sitk_type = "sitkInt16";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::CHAR ) {
-      npy_type = NPY_BYTE;
       sitk_type = "sitkInt8";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::INT ) {
-      npy_type = NPY_INT;
       sitk_type = "sitkInt32";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::LONG ) {
-      npy_type = NPY_LONG;
       sitk_type = "sitkInt64";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::UCHAR ) {
-      npy_type = NPY_UBYTE;
       sitk_type = "sitkUInt8";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::UINT ) {
-      npy_type = NPY_UINT;
       sitk_type = "sitkUInt32";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::ULONG ) {
-      npy_type = NPY_LONG;
       sitk_type = "sitkUInt64";
     } else if( pixelType.GetComponentType() == itk::ImageIOBase::USHORT ) {
-      npy_type = NPY_USHORT;
       sitk_type = "sitkUInt16";
     }
   } else {
@@ -349,17 +639,8 @@ bool mitk::PythonService::CopyToPythonAsSimpleItkImage(mitk::Image *image, const
     return false;
   }
 
-  // creating numpy array
-  import_array1 (true);
-  npyArray = PyArray_SimpleNewFromData(npy_nd,npy_dims,npy_type,array);
-
-  // add temp array it to the python dictionary to access it in python code
-  const int status = PyDict_SetItemString( pyDict,QString("%1_numpy_array")
-                                           .arg(varName).toStdString().c_str(),
-                                           npyArray );
-
-  // sanity check
-  if ( status != 0 )
+  // the numpy array views the image memory, SimpleITK copies it into its own buffer
+  if( !ImportNumpy() || !SetMainVariable(QString("%1_numpy_array").arg(varName).toStdString(), CreateImageArrayView(image, false)) )
     return false;
 
   command.append( QString("%1 = sitk.Image(%2,%3,%4,sitk.%5)\n").arg(varName)
@@ -403,7 +684,6 @@ mitk::Image::Pointer mitk::PythonService::CopySimpleItkImageFromPython(const std
   PyObject *pyMod = PyImport_AddModule((char*)"__main__");
   // global dictionarry
   PyObject *pyDict = PyModule_GetDict(pyMod);
-  mitk::Image::Pointer mitkImage = mitk::Image::New();
   mitk::Vector3D spacing;
   mitk::Point3D origin;
   QString command;
@@ -412,65 +692,27 @@ mitk::Image::Pointer mitk::PythonService::CopySimpleItkImageFromPython(const std
   command.append( QString("%1_numpy_array = sitk.GetArrayFromImage(%1)\n").arg(varName) );
   command.append( QString("%1_spacing = numpy.asarray(%1.GetSpacing())\n").arg(varName) );
   command.append( QString("%1_origin = numpy.asarray(%1.GetOrigin())\n").arg(varName) );
-  command.append( QString("%1_dtype = %1_numpy_array.dtype.name\n").arg(varName) );
   command.append( QString("%1_direction = numpy.asarray(%1.GetDirection())").arg(varName) );
 
 
   MITK_DEBUG("PythonService") << "Issuing python command " << command.toStdString();
   this->Execute(command.toStdString(), IPythonService::MULTI_LINE_COMMAND );
 
-  PyObject* py_dtype = PyDict_GetItemString(pyDict,QString("%1_dtype").arg(varName).toStdString().c_str() );
-  std::string dtype = PyString_AsString(py_dtype);
-  PyArrayObject* py_data = (PyArrayObject*) PyDict_GetItemString(pyDict,QString("%1_numpy_array").arg(varName).toStdString().c_str() );
+  PyObject* py_data = PyDict_GetItemString(pyDict,QString("%1_numpy_array").arg(varName).toStdString().c_str() );
   PyArrayObject* py_spacing = (PyArrayObject*) PyDict_GetItemString(pyDict,QString("%1_spacing").arg(varName).toStdString().c_str() );
   PyArrayObject* py_origin = (PyArrayObject*) PyDict_GetItemString(pyDict,QString("%1_origin").arg(varName).toStdString().c_str() );
   PyArrayObject* py_direction = (PyArrayObject*) PyDict_GetItemString(pyDict,QString("%1_direction").arg(varName).toStdString().c_str() );
 
-  size_t sz = sizeof(short);
-  mitk::PixelType pixelType = MakeScalarPixelType<short>();
-  if( dtype.compare("float64") == 0   ) {
-    pixelType = MakeScalarPixelType<double>();
-    sz = sizeof(double);
-  } else if( dtype.compare("float32") == 0 ) {
-    pixelType = MakeScalarPixelType<float>();
-    sz = sizeof(float);
-  } else if( dtype.compare("int16") == 0) {
-    pixelType = MakeScalarPixelType<short>();
-    sz = sizeof(short);
-  } else if( dtype.compare("int8") == 0 ) {
-    pixelType = MakeScalarPixelType<char>();
-    sz = sizeof(char);
-  } else if( dtype.compare("int32") == 0 ) {
-    pixelType = MakeScalarPixelType<int>();
-    sz = sizeof(int);
-  } else if( dtype.compare("int64") == 0 ) {
-    pixelType = MakeScalarPixelType<long>();
-    sz = sizeof(long);
-  } else if( dtype.compare("uint8") == 0 ) {
-    pixelType = MakeScalarPixelType<unsigned char>();
-    sz = sizeof(unsigned char);
-  } else if( dtype.compare("uint32") == 0 ) {
-    pixelType = MakeScalarPixelType<unsigned int>();
-    sz = sizeof(unsigned int);
-  } else if( dtype.compare("uint64") == 0 ) {
-    pixelType = MakeScalarPixelType<unsigned long>();
-    sz = sizeof(unsigned long);
-  } else if( dtype.compare("uint16") == 0 ) {
-    pixelType = MakeScalarPixelType<unsigned short>();
-    sz = sizeof(unsigned short);
-  }
-
-  unsigned int* dimensions = new unsigned int[py_data->nd];
-  // fill backwards , nd data saves dimensions in opposite direction
-  for( int i = 0; i < py_data->nd; ++i )
+  // the image uses the memory of the array returned by sitk.GetArrayFromImage, no second copy
+  mitk::Image::Pointer mitkImage;
+  if( ImportNumpy() )
+    mitkImage = CreateImageOfArray(py_data);
+  if( mitkImage.IsNull() )
   {
-    dimensions[i] = py_data->dimensions[py_data->nd - 1 - i];
-    sz *= dimensions[i];
+    MITK_ERROR << "Could not convert " << stdvarName << " to an image";
+    return NULL;
   }
 
-  mitkImage->Initialize(pixelType, py_data->nd, dimensions);
-  mitkImage->SetChannel(py_data->data);
-
   ds = (double*)py_spacing->data;
   spacing[0] = ds[0];
   spacing[1] = ds[1];
@@ -513,15 +755,12 @@ mitk::Image::Pointer mitk::PythonService::CopySimpleItkImageFromPython(const std
   // cleanup
   command.clear();
   command.append( QString("del %1_numpy_array\n").arg(varName) );
-  command.append( QString("del %1_dtype\n").arg(varName) );
   command.append( QString("del %1_spacing\n").arg(varName) );
   command.append( QString("del %1_origin\n").arg(varName) );
   command.append( QString("del %1_direction").arg(varName) );
   MITK_DEBUG("PythonService") << "Issuing python command " << command.toStdString();
   this->Execute(command.toStdString(), IPythonService::MULTI_LINE_COMMAND );
 
-  delete[] dimensions;
-
   return mitkImage;
 }
 
@@ -668,6 +907,71 @@ bool mitk::PythonService::CopyToPythonAsVtkPolyData( mitk::Surface* surface, con
   return true;
 }
 
+bool mitk::PythonService::WrapImageAsNumpyArray( mitk::Image* image, const std::string& varName, bool writable )
+{
+  return ImportNumpy() && SetMainVariable( varName, CreateImageArrayView(image, writable) );
+}
+
+mitk::Image::Pointer mitk::PythonService::WrapNumpyArrayAsImage( const std::string& varName )
+{
+  if( !ImportNumpy() )
+    return NULL;
+
+  PyObject *pyDict = PyModule_GetDict( PyImport_AddModule((char*)"__main__") );
+  return CreateImageOfArray( PyDict_GetItemString(pyDict, varName.c_str()) );
+}
+
+bool mitk::PythonService::WrapSurfaceAsNumpyArrays( mitk::Surface* surface, const std::string& varName )
+{
+  vtkPolyData* polyData = surface->GetVtkPolyData();
+  if( polyData == NULL || polyData->GetPoints() == NULL || !ImportNumpy() )
+    return false;
+
+  vtkDataArray* points = polyData->GetPoints()->GetData();
+  int pointType = -1;
+  if( points->GetDataType() == VTK_FLOAT )
+    pointType = NPY_FLOAT;
+  else if( points->GetDataType() == VTK_DOUBLE )
+    pointType = NPY_DOUBLE;
+  else
+  {
+    MITK_WARN << "Unsupported point type " << points->GetDataTypeAsString();
+    return false;
+  }
+
+  // every array holds a reference on the poly data; the points may be changed in place (call Modified() on them afterwards)
+  npy_intp pointDims[2] = { points->GetNumberOfTuples(), 3 };
+  polyData->Register(NULL);
+  PyObject* pointArray = CreateArrayView(2, pointDims, pointType, points->GetVoidPointer(0), true,
+                                         PyCapsule_New(polyData, "vtkPolyData", &ReleasePolyData));
+
+  vtkIdTypeArray* polys = polyData->GetPolys()->GetData();
+  npy_intp polyDims[1] = { polys->GetNumberOfTuples() };
+  polyData->Register(NULL);
+  PyObject* polyArray = CreateArrayView(1, polyDims, sizeof(vtkIdType) == 8 ? NPY_INT64 : NPY_INT32, polys->GetVoidPointer(0), false,
+                                        PyCapsule_New(polyData, "vtkPolyData", &ReleasePolyData));
+
+  const bool pointsSet = SetMainVariable(varName + "_points", pointArray);
+  const bool polysSet = SetMainVariable(varName + "_polys", polyArray);
+  return pointsSet && polysSet;
+}
+
+mitk::Surface::Pointer mitk::PythonService::WrapNumpyArraysAsSurface( const std::string& varName )
+{
+  if( !ImportNumpy() )
+    return NULL;
+
+  PyObject *pyDict = PyModule_GetDict( PyImport_AddModule((char*)"__main__") );
+  vtkSmartPointer<vtkPolyData> polyData = CreatePolyDataOfArrays( PyDict_GetItemString(pyDict, (varName + "_points").c_str()),
+                                                                  PyDict_GetItemString(pyDict, (varName + "_polys").c_str()) );
+  if( polyData == NULL )
+    return NULL;
+
+  mitk::Surface::Pointer surface = mitk::Surface::New();
+  surface->SetVtkPolyData(polyData);
+  return surface;
+}
+
 bool mitk::PythonService::IsSimpleItkPythonWrappingAvailable()
 {
   this->Execute( "import SimpleITK as sitk\n", IPythonService::SINGLE_LINE_COMMAND );
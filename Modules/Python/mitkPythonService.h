@@ -88,6 +88,18 @@ namespace mitk
       /// \see IPythonService::CopyVtkPolyDataFromPython()
       mitk::Surface::Pointer CopyVtkPolyDataFromPython( const std::string& varName );
       ///
+      /// \see IPythonService::WrapImageAsNumpyArray()
+      bool WrapImageAsNumpyArray( mitk::Image* image, const std::string& varName, bool writable = false );
+      ///
+      /// \see IPythonService::WrapNumpyArrayAsImage()
+      mitk::Image::Pointer WrapNumpyArrayAsImage( const std::string& varName );
+      ///
+      /// \see IPythonService::WrapSurfaceAsNumpyArrays()
+      bool WrapSurfaceAsNumpyArrays( mitk::Surface* surface, const std::string& varName );
+
+      /// \see IPythonService::WrapNumpyArraysAsSurface()
+      mitk::Surface::Pointer WrapNumpyArraysAsSurface( const std::string& varName );
+      ///
       /// \return the ctk abstract python manager instance
       ctkAbstractPythonManager* GetPythonManager();
   protected:
@@ -82,8 +82,16 @@ static void Remesh_SurfaceHasNoPolygons_ThrowsException()
 static void Remesh_SurfaceIsValid_ReturnsRemeshedSurface(const std::string& filename, unsigned int t, int numVertices, double gradation, int subsampling, double edgeSplitting, int optimizationLevel, bool forceManifold, bool boundaryFixing)
 {
   mitk::Surface::ConstPointer surface = mitk::IOUtil::LoadSurface(filename).GetPointer();
-  mitk::Surface::Pointer remeshedSurface = mitk::ACVD::Remesh(surface, t, numVertices, gradation, subsampling, edgeSplitting, optimizationLevel, forceManifold, boundaryFixing);
+  mitk::ACVD::RemeshTimings timings;
+  mitk::Surface::Pointer remeshedSurface = mitk::ACVD::Remesh(surface, t, numVertices, gradation, subsampling, edgeSplitting, optimizationLevel, forceManifold, boundaryFixing, &timings);
   MITK_TEST_CONDITION(remeshedSurface.IsNotNull() && remeshedSurface->GetVtkPolyData() != NULL && remeshedSurface->GetVtkPolyData()->GetNumberOfPolys() != 0, "Remesh_SurfaceIsValid_ReturnsRemeshedSurface")
+
+  // Benchmark output, the stage times are reported for comparison between builds and thread counts
+  MITK_TEST_OUTPUT(<< "Remeshing: " << timings.Remeshing << " s")
+  MITK_TEST_OUTPUT(<< "Quadrics post-processing: " << timings.QuadricsPostProcessing << " s")
+  MITK_TEST_OUTPUT(<< "Normals: " << timings.Normals << " s")
+  MITK_TEST_OUTPUT(<< "Total: " << timings.Total << " s, " << timings.VerticesPerSecond << " vertices/s")
+  MITK_TEST_CONDITION(remeshedSurface.IsNotNull() && timings.NumberOfVertices == remeshedSurface->GetVtkPolyData()->GetNumberOfPoints(), "Remesh_SurfaceIsValid_ReportsNumberOfVertices")
 }
 
 int mitkACVDTest(int argc, char* argv[])
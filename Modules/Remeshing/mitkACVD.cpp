@@ -14,8 +14,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 ===================================================================*/
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include "mitkACVD.h"
 #include <mitkExceptionMacro.h>
+#include <itkTimeProbe.h>
 #include <vtkIdList.h>
 #include <vtkIntArray.h>
 #include <vtkIsotropicDiscreteRemeshing.h>
@@ -24,37 +29,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolyDataNormals.h>
 #include <vtkSmartPointer.h>
 #include <vtkSurface.h>
-
-struct ClustersQuadrics
-{
-  explicit ClustersQuadrics(int size)
-    : Elements(new double*[size]),
-      Size(size)
-  {
-    for (int i = 0; i < size; ++i)
-    {
-      Elements[i] = new double[9];
-
-      for (int j = 0; j < 9; ++j)
-        Elements[i][j] = 0.0;
-    }
-  }
-
-  ~ClustersQuadrics()
-  {
-    for (int i = 0; i < Size; ++i)
-      delete[] Elements[i];
-
-    delete Elements;
-  }
-
-  double** Elements;
-  int Size;
-
-private:
-  ClustersQuadrics(const ClustersQuadrics&);
-  ClustersQuadrics& operator=(const ClustersQuadrics&);
-};
+#include <algorithm>
+#include <vector>
 
 static void ValidateSurface(mitk::Surface::ConstPointer surface, unsigned int t)
 {
@@ -73,12 +49,29 @@ static void ValidateSurface(mitk::Surface::ConstPointer surface, unsigned int t)
     mitkThrow() << "Input surface has no polygons at time step " << t << "!";
 }
 
-mitk::Surface::Pointer mitk::ACVD::Remesh(mitk::Surface::ConstPointer surface, unsigned int t, int numVertices, double gradation, int subsampling, double edgeSplitting, int optimizationLevel, bool forceManifold, bool boundaryFixing)
+mitk::ACVD::RemeshTimings::RemeshTimings()
+  : Remeshing(0.0),
+    QuadricsPostProcessing(0.0),
+    Normals(0.0),
+    Total(0.0),
+    NumberOfVertices(0),
+    VerticesPerSecond(0.0)
+{
+}
+
+mitk::Surface::Pointer mitk::ACVD::Remesh(mitk::Surface::ConstPointer surface, unsigned int t, int numVertices, double gradation, int subsampling, double edgeSplitting, int optimizationLevel, bool forceManifold, bool boundaryFixing, RemeshTimings* timings)
 {
   ValidateSurface(surface, t);
 
   MITK_INFO << "Start remeshing...";
 
+  itk::TimeProbe totalClock;
+  itk::TimeProbe remeshingClock;
+  itk::TimeProbe quadricsClock;
+  itk::TimeProbe normalsClock;
+  totalClock.Start();
+  remeshingClock.Start();
+
   vtkSmartPointer<vtkPolyData> surfacePolyData = vtkSmartPointer<vtkPolyData>::New();
   surfacePolyData->DeepCopy(const_cast<Surface*>(surface.GetPointer())->GetVtkPolyData(t));
 
@@ -109,60 +102,104 @@ mitk::Surface::Pointer mitk::ACVD::Remesh(mitk::Surface::ConstPointer surface, u
 
   remesher->Remesh();
 
+  remeshingClock.Stop();
+
   // Optimization: Minimize distance between input surface and remeshed surface
   if (optimizationLevel != 0)
   {
-    ClustersQuadrics clustersQuadrics(numVertices);
+    quadricsClock.Start();
 
-    vtkSmartPointer<vtkIdList> faceList = vtkSmartPointer<vtkIdList>::New();
     vtkSmartPointer<vtkIntArray> clustering = remesher->GetClustering();
     vtkSmartPointer<vtkSurface> remesherInput = remesher->GetInput();
     int clusteringType = remesher->GetClusteringType();
     int numItems = remesher->GetNumberOfItems();
     int numMisclassifiedItems = 0;
+    const int numThreads = std::max(1, vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
 
-    for (int i = 0; i < numItems; ++i)
-    {
-      int cluster = clustering->GetValue(i);
+    // Every thread accumulates the quadrics of its items into its own copy of the cluster quadrics,
+    // the copies are summed up per cluster afterwards
+    const std::size_t quadricsSize = 9 * static_cast<std::size_t>(numVertices);
+    std::vector<double> clustersQuadrics(numThreads * quadricsSize, 0.0);
+    std::vector<vtkSmartPointer<vtkIdList> > faceLists(numThreads);
 
-      if (cluster >= 0 && cluster < numVertices)
+    for (int i = 0; i < numThreads; ++i)
+      faceLists[i] = vtkSmartPointer<vtkIdList>::New();
+
+#pragma omp parallel num_threads(numThreads) reduction(+:numMisclassifiedItems)
+    {
+#ifdef _OPENMP
+      const int thread = omp_get_thread_num();
+#else
+      const int thread = 0;
+#endif
+      double* threadQuadrics = &clustersQuadrics[thread * quadricsSize];
+      vtkIdList* faceList = faceLists[thread];
+
+#pragma omp for schedule(static)
+      for (int i = 0; i < numItems; ++i)
       {
-        if (clusteringType != 0)
-        {
-          remesherInput->GetVertexNeighbourFaces(i, faceList);
-          int numIds = static_cast<int>(faceList->GetNumberOfIds());
+        int cluster = clustering->GetValue(i);
 
-          for (int j = 0; j < numIds; ++j)
-            vtkQuadricTools::AddTriangleQuadric(clustersQuadrics.Elements[cluster], remesherInput, faceList->GetId(j), false);
+        if (cluster >= 0 && cluster < numVertices)
+        {
+          double* quadric = threadQuadrics + 9 * cluster;
+
+          if (clusteringType != 0)
+          {
+            remesherInput->GetVertexNeighbourFaces(i, faceList);
+            int numIds = static_cast<int>(faceList->GetNumberOfIds());
+
+            for (int j = 0; j < numIds; ++j)
+              vtkQuadricTools::AddTriangleQuadric(quadric, remesherInput, faceList->GetId(j), false);
+          }
+          else
+          {
+            vtkQuadricTools::AddTriangleQuadric(quadric, remesherInput, i, false);
+          }
         }
         else
         {
-          vtkQuadricTools::AddTriangleQuadric(clustersQuadrics.Elements[cluster], remesherInput, i, false);
+          ++numMisclassifiedItems;
         }
       }
-      else
-      {
-        ++numMisclassifiedItems;
-      }
     }
 
     if (numMisclassifiedItems != 0)
       std::cout << numMisclassifiedItems << " items with wrong cluster association" << std::endl;
 
     vtkSmartPointer<vtkSurface> remesherOutput = remesher->GetOutput();
-    double point[3];
+    std::vector<double> points(3 * static_cast<std::size_t>(numVertices));
 
+    // The points are only read here and written back serially as vtkSurface isn't safe for concurrent writes
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 256)
     for (int i = 0; i < numVertices; ++i)
     {
+      double* quadric = &clustersQuadrics[9 * static_cast<std::size_t>(i)];
+
+      for (int thread = 1; thread < numThreads; ++thread)
+      {
+        const double* threadQuadric = quadric + thread * quadricsSize;
+
+        for (int j = 0; j < 9; ++j)
+          quadric[j] += threadQuadric[j];
+      }
+
+      double* point = &points[3 * static_cast<std::size_t>(i)];
       remesherOutput->GetPoint(i, point);
-      vtkQuadricTools::ComputeRepresentativePoint(clustersQuadrics.Elements[i], point, optimizationLevel);
-      remesherOutput->SetPointCoordinates(i, point);
+      vtkQuadricTools::ComputeRepresentativePoint(quadric, point, optimizationLevel);
     }
 
+    for (int i = 0; i < numVertices; ++i)
+      remesherOutput->SetPointCoordinates(i, &points[3 * static_cast<std::size_t>(i)]);
+
+    quadricsClock.Stop();
+
     std::cout << "After quadrics post-processing:" << std::endl;
     remesherOutput->DisplayMeshProperties();
   }
 
+  normalsClock.Start();
+
   vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
 
   normals->SetInputData(remesher->GetOutput());
@@ -176,10 +213,29 @@ mitk::Surface::Pointer mitk::ACVD::Remesh(mitk::Surface::ConstPointer surface, u
 
   normals->Update();
 
+  normalsClock.Stop();
+
   Surface::Pointer remeshedSurface = Surface::New();
   remeshedSurface->SetVtkPolyData(normals->GetOutput());
 
-  MITK_INFO << "Finished remeshing";
+  totalClock.Stop();
+
+  RemeshTimings stageTimings;
+  stageTimings.Remeshing = remeshingClock.GetTotal();
+  stageTimings.QuadricsPostProcessing = quadricsClock.GetTotal();
+  stageTimings.Normals = normalsClock.GetTotal();
+  stageTimings.Total = totalClock.GetTotal();
+  stageTimings.NumberOfVertices = static_cast<int>(normals->GetOutput()->GetNumberOfPoints());
+
+  if (stageTimings.Total > 0.0)
+    stageTimings.VerticesPerSecond = stageTimings.NumberOfVertices / stageTimings.Total;
+
+  if (timings != nullptr)
+    *timings = stageTimings;
+
+  MITK_INFO << "Finished remeshing: " << stageTimings.NumberOfVertices << " vertices in " << stageTimings.Total << " s ("
+            << stageTimings.VerticesPerSecond << " vertices/s; remeshing " << stageTimings.Remeshing << " s, quadrics post-processing "
+            << stageTimings.QuadricsPostProcessing << " s, normals " << stageTimings.Normals << " s)";
 
   return remeshedSurface;
 }
@@ -204,6 +260,6 @@ mitk::ACVD::RemeshFilter::~RemeshFilter()
 
 void mitk::ACVD::RemeshFilter::GenerateData()
 {
-  Surface::Pointer output = Remesh(this->GetInput(), m_TimeStep, m_NumVertices, m_Gradation, m_Subsampling, m_EdgeSplitting, m_OptimizationLevel, m_ForceManifold, m_BoundaryFixing);
+  Surface::Pointer output = Remesh(this->GetInput(), m_TimeStep, m_NumVertices, m_Gradation, m_Subsampling, m_EdgeSplitting, m_OptimizationLevel, m_ForceManifold, m_BoundaryFixing, &m_Timings);
   this->SetNthOutput(0, output);
 }
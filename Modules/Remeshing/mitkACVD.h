@@ -25,6 +25,20 @@ namespace mitk
 {
   namespace ACVD
   {
+    /** \brief Wall clock times in seconds of the stages of mitk::ACVD::Remesh().
+     */
+    struct MITKREMESHING_EXPORT RemeshTimings
+    {
+      RemeshTimings();
+
+      double Remeshing;              ///< Clustering by vtkIsotropicDiscreteRemeshing, including preparation of the input mesh
+      double QuadricsPostProcessing; ///< Accumulation of the cluster quadrics and computation of the representative points
+      double Normals;                ///< Computation of the point normals
+      double Total;
+      int NumberOfVertices;          ///< Number of vertices of the remeshed surface
+      double VerticesPerSecond;      ///< NumberOfVertices divided by Total
+    };
+
     /** \brief Remesh a surface and store the result in a new surface.
      *
      * The %ACVD library is used for remeshing which is based on the paper "Approximated Centroidal Voronoi Diagrams for Uniform Polygonal Mesh Coarsening" by S. Valette, and J. M. Chassery.
@@ -47,9 +61,12 @@ namespace mitk
      * \param[in] edgeSplitting Recursively split edges that are longer than the average edge length times this parameter.
      * \param[in] optimizationLevel Minimize distance between input surface and remeshed surface.
      * \param[in] boundaryFixing Keep original surface boundaries by adding additional polygons.
+     * \param[out] timings Optional, receives the times of the remeshing stages.
      * \return Returns the remeshed surface or NULL if input surface is invalid.
+     *
+     * Remeshing and the quadrics post-processing use vtkMultiThreader::GetGlobalDefaultNumberOfThreads() threads.
      */
-    MITKREMESHING_EXPORT Surface::Pointer Remesh(Surface::ConstPointer surface, unsigned int t, int numVertices, double gradation, int subsampling = 10, double edgeSplitting = 0.0, int optimizationLevel = 1, bool forceManifold = false, bool boundaryFixing = false);
+    MITKREMESHING_EXPORT Surface::Pointer Remesh(Surface::ConstPointer surface, unsigned int t, int numVertices, double gradation, int subsampling = 10, double edgeSplitting = 0.0, int optimizationLevel = 1, bool forceManifold = false, bool boundaryFixing = false, RemeshTimings* timings = nullptr);
 
     /** \brief Encapsulates mitk::ACVD::Remesh function as filter.
      */
@@ -69,6 +86,9 @@ namespace mitk
       itkSetMacro(ForceManifold, bool);
       itkSetMacro(BoundaryFixing, bool);
 
+      /** \brief Returns the stage times of the last remeshing. */
+      const RemeshTimings& GetTimings() const { return m_Timings; }
+
     protected:
       void GenerateData() override;
 
@@ -84,6 +104,7 @@ namespace mitk
       int m_OptimizationLevel;
       bool m_ForceManifold;
       bool m_BoundaryFixing;
+      RemeshTimings m_Timings;
     };
   }
 }
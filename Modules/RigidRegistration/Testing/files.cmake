@@ -1,4 +1,5 @@
 set(MODULE_TESTS
+  mitkMetricFactoryTest.cpp
   # mitkRigidRegistrationPresetTest.cpp
   # mitkRigidRegistrationTestPresetTest.cpp
 )
\ No newline at end of file
@@ -0,0 +1,230 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include "mitkMetricFactory.h"
+#include "mitkRigidRegistrationPreset.h"
+#include "itkMultiThreadedNormalizedCorrelationImageToImageMetric.h"
+
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkNormalizedCorrelationImageToImageMetric.h>
+#include <itkTranslationTransform.h>
+
+#include <algorithm>
+#include <cmath>
+
+class mitkMetricFactoryTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMetricFactoryTestSuite);
+  MITK_TEST(ConfigureMetric_RandomSampling_SamplesEveryLevel);
+  MITK_TEST(ConfigureMetric_StratifiedSampling_OneVoxelPerCell);
+  MITK_TEST(ConfigureMetric_AllPixelsSampling_DropsPreviousSamples);
+  MITK_TEST(MultiThreadedNormalizedCorrelation_SameAsNormalizedCorrelation);
+  MITK_TEST(ConfigureMetric_StratifiedSamplingPreset_SamplesMetric);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef mitk::MetricFactory<float, 3> MetricFactoryType;
+  typedef MetricFactoryType::FixedImageType ImageType;
+  typedef MetricFactoryType::MetricType MetricType;
+
+  /** A smooth blob, so that the normalized correlation has a useful derivative */
+  static ImageType::Pointer CreateImage(unsigned int size, double centerX)
+  {
+    ImageType::Pointer image = ImageType::New();
+    ImageType::SizeType imageSize;
+    imageSize.Fill(size);
+    ImageType::RegionType region;
+    region.SetSize(imageSize);
+    image->SetRegions(region);
+    image->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<ImageType> it(image, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      const double dx = index[0] - centerX;
+      const double dy = index[1] - 0.5 * size;
+      const double dz = index[2] - 0.4 * size;
+      it.Set(static_cast<float>(100.0 * std::exp(-(dx * dx + dy * dy + dz * dz) / (0.1 * size * size)) + 0.5 * index[1]));
+    }
+    return image;
+  }
+
+  static MetricFactoryType::Pointer CreateMetricFactory(int sampling, double percentage)
+  {
+    mitk::MetricParameters::Pointer parameters = mitk::MetricParameters::New();
+    parameters->SetMetric(mitk::MetricParameters::NORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC);
+    parameters->SetUseMultiThreading(true);
+    parameters->SetSamplingStrategy(sampling);
+    parameters->SetSamplingPercentage(percentage);
+
+    MetricFactoryType::Pointer metricFactory = MetricFactoryType::New();
+    metricFactory->SetMetricParameters(parameters);
+    return metricFactory;
+  }
+
+  static bool IsClose(double expected, double value)
+  {
+    return std::abs(expected - value) <= 1e-6 * std::max(1.0, std::abs(expected));
+  }
+
+public:
+  void ConfigureMetric_RandomSampling_SamplesEveryLevel()
+  {
+    MetricFactoryType::Pointer metricFactory = CreateMetricFactory(mitk::MetricParameters::RANDOMSAMPLING, 0.1);
+    MetricType::Pointer metric = metricFactory->GetMetric();
+
+    // a coarse and a fine pyramid level
+    ImageType::Pointer coarseImage = CreateImage(8, 4.0);
+    metricFactory->ConfigureMetric(metric, coarseImage);
+    CPPUNIT_ASSERT_MESSAGE("Coarse level uses the selected voxels", metric->GetUseFixedImageIndexes() && !metric->GetUseAllPixels());
+    CPPUNIT_ASSERT_EQUAL(static_cast<itk::SizeValueType>(51), metric->GetNumberOfFixedImageSamples());
+
+    ImageType::Pointer fineImage = CreateImage(16, 8.0);
+    metricFactory->ConfigureMetric(metric, fineImage);
+    CPPUNIT_ASSERT_MESSAGE("Fine level uses the selected voxels", metric->GetUseFixedImageIndexes() && !metric->GetUseAllPixels());
+    CPPUNIT_ASSERT_EQUAL(static_cast<itk::SizeValueType>(409), metric->GetNumberOfFixedImageSamples());
+
+    // too small for a single sample, the voxels of the fine level must not be used here
+    ImageType::Pointer tinyImage = CreateImage(2, 1.0);
+    metricFactory->ConfigureMetric(metric, tinyImage);
+    CPPUNIT_ASSERT_MESSAGE("Level without a sample uses all voxels", !metric->GetUseFixedImageIndexes() && metric->GetUseAllPixels());
+  }
+
+  void ConfigureMetric_StratifiedSampling_OneVoxelPerCell()
+  {
+    MetricFactoryType::Pointer metricFactory = CreateMetricFactory(mitk::MetricParameters::STRATIFIEDSAMPLING, 0.125);
+    MetricType::Pointer metric = metricFactory->GetMetric();
+
+    // cells of 2x2x2 voxels
+    ImageType::Pointer image = CreateImage(16, 8.0);
+    metricFactory->ConfigureMetric(metric, image);
+    CPPUNIT_ASSERT_MESSAGE("Stratified sampling uses the selected voxels", metric->GetUseFixedImageIndexes() && !metric->GetUseAllPixels());
+    CPPUNIT_ASSERT_EQUAL(static_cast<itk::SizeValueType>(8 * 8 * 8), metric->GetNumberOfFixedImageSamples());
+  }
+
+  void ConfigureMetric_AllPixelsSampling_DropsPreviousSamples()
+  {
+    MetricFactoryType::Pointer randomFactory = CreateMetricFactory(mitk::MetricParameters::RANDOMSAMPLING, 0.1);
+    MetricType::Pointer metric = randomFactory->GetMetric();
+    ImageType::Pointer image = CreateImage(16, 8.0);
+    randomFactory->ConfigureMetric(metric, image);
+    CPPUNIT_ASSERT(metric->GetUseFixedImageIndexes());
+
+    MetricFactoryType::Pointer allPixelsFactory = CreateMetricFactory(mitk::MetricParameters::ALLPIXELSSAMPLING, 0.1);
+    allPixelsFactory->ConfigureMetric(metric, image);
+    CPPUNIT_ASSERT_MESSAGE("All pixels sampling drops the selected voxels", !metric->GetUseFixedImageIndexes() && metric->GetUseAllPixels());
+
+    randomFactory->ConfigureMetric(metric, image);
+    MetricFactoryType::Pointer fullPercentageFactory = CreateMetricFactory(mitk::MetricParameters::RANDOMSAMPLING, 1.0);
+    fullPercentageFactory->ConfigureMetric(metric, image);
+    CPPUNIT_ASSERT_MESSAGE("A percentage of 1 drops the selected voxels", !metric->GetUseFixedImageIndexes() && metric->GetUseAllPixels());
+  }
+
+  void ConfigureMetric_StratifiedSamplingPreset_SamplesMetric()
+  {
+    mitk::RigidRegistrationPreset preset;
+    CPPUNIT_ASSERT_MESSAGE("Default presets are loaded", preset.LoadPreset());
+    itk::Array<double> metricValues = preset.getMetricValues("Rigid3DMeanSquares_StratifiedSampling_LinearInterp");
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(mitk::MetricParameters::MEANSQUARESIMAGETOIMAGEMETRIC), metricValues[0]);
+
+    // like the registration view applies a loaded preset
+    mitk::MetricParameters::Pointer parameters = mitk::MetricParameters::New();
+    parameters->SetMetric(metricValues[0]);
+    parameters->SetEvaluationParameters(metricValues);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(mitk::MetricParameters::STRATIFIEDSAMPLING), parameters->GetSamplingStrategy());
+    CPPUNIT_ASSERT(parameters->GetUseMultiThreading());
+
+    MetricFactoryType::Pointer metricFactory = MetricFactoryType::New();
+    metricFactory->SetMetricParameters(parameters);
+    MetricType::Pointer metric = metricFactory->GetMetric();
+
+    // 5 percent, i.e. cells of about 2.7 voxels per edge
+    ImageType::Pointer image = CreateImage(16, 8.0);
+    metricFactory->ConfigureMetric(metric, image);
+    CPPUNIT_ASSERT_MESSAGE("The preset samples the metric", metric->GetUseFixedImageIndexes() && !metric->GetUseAllPixels());
+    CPPUNIT_ASSERT_EQUAL(static_cast<itk::SizeValueType>(6 * 6 * 6), metric->GetNumberOfFixedImageSamples());
+  }
+
+  void MultiThreadedNormalizedCorrelation_SameAsNormalizedCorrelation()
+  {
+    typedef itk::TranslationTransform<double, 3> TransformType;
+    typedef itk::LinearInterpolateImageFunction<ImageType, double> InterpolatorType;
+    typedef itk::NormalizedCorrelationImageToImageMetric<ImageType, ImageType> ReferenceMetricType;
+    typedef itk::MultiThreadedNormalizedCorrelationImageToImageMetric<ImageType, ImageType> MultiThreadedMetricType;
+
+    ImageType::Pointer fixedImage = CreateImage(20, 9.0);
+    ImageType::Pointer movingImage = CreateImage(20, 11.5);
+
+    for (int subtractMean = 0; subtractMean < 2; ++subtractMean)
+    {
+      ReferenceMetricType::Pointer referenceMetric = ReferenceMetricType::New();
+      MultiThreadedMetricType::Pointer multiThreadedMetric = MultiThreadedMetricType::New();
+      MetricType* metrics[2] = { referenceMetric.GetPointer(), multiThreadedMetric.GetPointer() };
+      referenceMetric->SetSubtractMean(subtractMean != 0);
+      multiThreadedMetric->SetSubtractMean(subtractMean != 0);
+      multiThreadedMetric->SetNumberOfThreads(4);
+      for (MetricType* metric : metrics)
+      {
+        metric->SetFixedImage(fixedImage);
+        metric->SetMovingImage(movingImage);
+        metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+        metric->UseAllPixelsOn();
+        metric->SetTransform(TransformType::New());
+        metric->SetInterpolator(InterpolatorType::New());
+        metric->Initialize();
+      }
+
+      const double translations[3][3] = { { 0.0, 0.0, 0.0 }, { 1.3, -0.7, 0.4 }, { 2.5, 0.2, -1.1 } };
+      for (const auto & translation : translations)
+      {
+        MetricType::ParametersType parameters(3);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+          parameters[i] = translation[i];
+        }
+
+        MetricType::MeasureType expectedValue = referenceMetric->GetValue(parameters);
+        MetricType::DerivativeType expectedDerivative;
+        referenceMetric->GetDerivative(parameters, expectedDerivative);
+
+        CPPUNIT_ASSERT_MESSAGE("Same value", IsClose(expectedValue, multiThreadedMetric->GetValue(parameters)));
+
+        MetricType::DerivativeType derivative;
+        multiThreadedMetric->GetDerivative(parameters, derivative);
+        CPPUNIT_ASSERT_EQUAL(expectedDerivative.GetSize(), derivative.GetSize());
+        for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+        {
+          CPPUNIT_ASSERT_MESSAGE("Same derivative", IsClose(expectedDerivative[i], derivative[i]));
+        }
+
+        MetricType::MeasureType value;
+        multiThreadedMetric->GetValueAndDerivative(parameters, value, derivative);
+        CPPUNIT_ASSERT_MESSAGE("Same value with the derivative", IsClose(expectedValue, value));
+        for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+        {
+          CPPUNIT_ASSERT_MESSAGE("Same derivative with the value", IsClose(expectedDerivative[i], derivative[i]));
+        }
+      }
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMetricFactory)
@@ -0,0 +1,112 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_H
+#define ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_H
+
+#include <itkImageToImageMetric.h>
+
+#include <vector>
+
+namespace itk
+{
+  /**
+  \brief Normalized correlation metric evaluated on the fixed image samples of itk::ImageToImageMetric.
+
+  Computes the same measure and derivative as itk::NormalizedCorrelationImageToImageMetric, but
+  uses the threaded sample processing of the superclass (like itk::MeanSquaresImageToImageMetric).
+  Therefore the metric is evaluated multi-threaded and respects the sampling settings (UseAllPixels,
+  NumberOfFixedImageSamples, SetFixedImageIndexes) of itk::ImageToImageMetric.
+
+  \ingroup RigidRegistration
+  */
+  template < class TFixedImage, class TMovingImage >
+  class MultiThreadedNormalizedCorrelationImageToImageMetric : public ImageToImageMetric< TFixedImage, TMovingImage >
+  {
+  public:
+    typedef MultiThreadedNormalizedCorrelationImageToImageMetric Self;
+    typedef ImageToImageMetric< TFixedImage, TMovingImage >      Superclass;
+    typedef SmartPointer< Self >                                 Pointer;
+    typedef SmartPointer< const Self >                           ConstPointer;
+
+    itkNewMacro(Self);
+    itkTypeMacro(MultiThreadedNormalizedCorrelationImageToImageMetric, ImageToImageMetric);
+
+    typedef typename Superclass::TransformType         TransformType;
+    typedef typename Superclass::TransformJacobianType TransformJacobianType;
+    typedef typename Superclass::MeasureType           MeasureType;
+    typedef typename Superclass::DerivativeType        DerivativeType;
+    typedef typename Superclass::ParametersType        ParametersType;
+    typedef typename Superclass::FixedImagePointType   FixedImagePointType;
+    typedef typename Superclass::MovingImagePointType  MovingImagePointType;
+    typedef typename Superclass::ImageDerivativesType  ImageDerivativesType;
+
+    itkStaticConstMacro(MovingImageDimension, unsigned int, TMovingImage::ImageDimension);
+
+    /** Subtract the mean of the fixed and moving samples before correlating them. */
+    itkSetMacro(SubtractMean, bool);
+    itkGetConstReferenceMacro(SubtractMean, bool);
+    itkBooleanMacro(SubtractMean);
+
+    virtual void Initialize() throw ( ExceptionObject ) override;
+
+    MeasureType GetValue(const ParametersType & parameters) const override;
+
+    void GetDerivative(const ParametersType & parameters, DerivativeType & derivative) const override;
+
+    void GetValueAndDerivative(const ParametersType & parameters, MeasureType & value, DerivativeType & derivative) const override;
+
+  protected:
+    MultiThreadedNormalizedCorrelationImageToImageMetric();
+    virtual ~MultiThreadedNormalizedCorrelationImageToImageMetric() {}
+
+    void PrintSelf(std::ostream & os, Indent indent) const override;
+
+    bool GetValueThreadProcessSample(ThreadIdType threadId, SizeValueType fixedImageSample,
+                                     const MovingImagePointType & mappedPoint, double movingImageValue) const override;
+
+    bool GetValueAndDerivativeThreadProcessSample(ThreadIdType threadId, SizeValueType fixedImageSample,
+                                                  const MovingImagePointType & mappedPoint, double movingImageValue,
+                                                  const ImageDerivativesType & movingImageGradientValue) const override;
+
+  private:
+    MultiThreadedNormalizedCorrelationImageToImageMetric(const Self &); // purposely not implemented
+    void operator=(const Self &);                                      // purposely not implemented
+
+    /** Sums of one thread, merged after all samples are processed. */
+    struct PerThreadType
+    {
+      double m_Sff;
+      double m_Smm;
+      double m_Sfm;
+      double m_Sf;
+      double m_Sm;
+      DerivativeType m_DerivativeF;
+      DerivativeType m_DerivativeM;
+      DerivativeType m_DerivativeM1;
+      TransformJacobianType m_Jacobian;
+    };
+
+    void ResetPerThread(bool withDerivative) const;
+
+    bool m_SubtractMean;
+    mutable std::vector< PerThreadType > m_PerThread;
+  };
+} // end namespace itk
+
+#include "itkMultiThreadedNormalizedCorrelationImageToImageMetric.txx"
+
+#endif // ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_H
@@ -0,0 +1,239 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_TXX
+#define ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_TXX
+
+#include "itkMultiThreadedNormalizedCorrelationImageToImageMetric.h"
+
+#include <cmath>
+
+namespace itk
+{
+  template < class TFixedImage, class TMovingImage >
+  MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::MultiThreadedNormalizedCorrelationImageToImageMetric()
+    : m_SubtractMean(false)
+  {
+    // like itk::NormalizedCorrelationImageToImageMetric every pixel is used unless sampling is requested
+    this->SetComputeGradient(true);
+    this->UseAllPixelsOn();
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  void MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::Initialize() throw ( ExceptionObject )
+  {
+    Superclass::Initialize();
+
+    m_PerThread.resize(this->m_NumberOfThreads);
+    for (ThreadIdType t = 0; t < this->m_NumberOfThreads; ++t)
+    {
+      m_PerThread[t].m_DerivativeF.SetSize(this->m_NumberOfParameters);
+      m_PerThread[t].m_DerivativeM.SetSize(this->m_NumberOfParameters);
+      m_PerThread[t].m_DerivativeM1.SetSize(this->m_NumberOfParameters);
+      m_PerThread[t].m_Jacobian.SetSize(MovingImageDimension, this->m_NumberOfParameters);
+    }
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  void MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::ResetPerThread(bool withDerivative) const
+  {
+    for (ThreadIdType t = 0; t < this->m_NumberOfThreads; ++t)
+    {
+      PerThreadType& sums = m_PerThread[t];
+      sums.m_Sff = sums.m_Smm = sums.m_Sfm = sums.m_Sf = sums.m_Sm = 0.0;
+      if (withDerivative)
+      {
+        sums.m_DerivativeF.Fill(0.0);
+        sums.m_DerivativeM.Fill(0.0);
+        sums.m_DerivativeM1.Fill(0.0);
+      }
+    }
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  bool MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::GetValueThreadProcessSample(ThreadIdType threadId, SizeValueType fixedImageSample,
+                                  const MovingImagePointType & /*mappedPoint*/, double movingImageValue) const
+  {
+    const double fixedImageValue = this->m_FixedImageSamples[fixedImageSample].value;
+    PerThreadType& sums = m_PerThread[threadId];
+    sums.m_Sff += fixedImageValue * fixedImageValue;
+    sums.m_Smm += movingImageValue * movingImageValue;
+    sums.m_Sfm += fixedImageValue * movingImageValue;
+    sums.m_Sf += fixedImageValue;
+    sums.m_Sm += movingImageValue;
+    return true;
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  bool MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::GetValueAndDerivativeThreadProcessSample(ThreadIdType threadId, SizeValueType fixedImageSample,
+                                               const MovingImagePointType & mappedPoint, double movingImageValue,
+                                               const ImageDerivativesType & movingImageGradientValue) const
+  {
+    this->GetValueThreadProcessSample(threadId, fixedImageSample, mappedPoint, movingImageValue);
+
+    const FixedImagePointType fixedImagePoint = this->m_FixedImageSamples[fixedImageSample].point;
+    const double fixedImageValue = this->m_FixedImageSamples[fixedImageSample].value;
+    PerThreadType& sums = m_PerThread[threadId];
+
+    // every thread but the first one works on its own copy of the transform
+    TransformType* transform = threadId > 0 ? this->m_ThreaderTransform[threadId - 1].GetPointer() : this->m_Transform.GetPointer();
+    transform->ComputeJacobianWithRespectToParameters(fixedImagePoint, sums.m_Jacobian);
+
+    for (unsigned int par = 0; par < this->m_NumberOfParameters; ++par)
+    {
+      double differential = 0.0;
+      for (unsigned int dim = 0; dim < MovingImageDimension; ++dim)
+      {
+        differential += sums.m_Jacobian(dim, par) * movingImageGradientValue[dim];
+      }
+      sums.m_DerivativeF[par] += fixedImageValue * differential;
+      sums.m_DerivativeM[par] += movingImageValue * differential;
+      sums.m_DerivativeM1[par] += differential;
+    }
+    return true;
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  typename MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::MeasureType
+    MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::GetValue(const ParametersType & parameters) const
+  {
+    if (!this->m_FixedImage)
+    {
+      itkExceptionMacro(<< "Fixed image has not been assigned");
+    }
+
+    this->ResetPerThread(false);
+    this->m_Transform->SetParameters(parameters);
+    this->GetValueMultiThreadedInitiate();
+
+    if (this->m_NumberOfPixelsCounted == 0)
+    {
+      itkExceptionMacro(<< "All the points mapped to outside of the moving image");
+    }
+
+    double sff = 0.0, smm = 0.0, sfm = 0.0, sf = 0.0, sm = 0.0;
+    for (ThreadIdType t = 0; t < this->m_NumberOfThreads; ++t)
+    {
+      sff += m_PerThread[t].m_Sff;
+      smm += m_PerThread[t].m_Smm;
+      sfm += m_PerThread[t].m_Sfm;
+      sf += m_PerThread[t].m_Sf;
+      sm += m_PerThread[t].m_Sm;
+    }
+
+    if (m_SubtractMean)
+    {
+      const double numberOfPixels = this->m_NumberOfPixelsCounted;
+      sff -= sf * sf / numberOfPixels;
+      smm -= sm * sm / numberOfPixels;
+      sfm -= sf * sm / numberOfPixels;
+    }
+
+    const double denom = -1.0 * std::sqrt(sff * smm);
+    return denom != 0.0 ? sfm / denom : NumericTraits< MeasureType >::Zero;
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  void MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::GetDerivative(const ParametersType & parameters, DerivativeType & derivative) const
+  {
+    MeasureType value;
+    this->GetValueAndDerivative(parameters, value, derivative);
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  void MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::GetValueAndDerivative(const ParametersType & parameters, MeasureType & value, DerivativeType & derivative) const
+  {
+    if (!this->m_FixedImage)
+    {
+      itkExceptionMacro(<< "Fixed image has not been assigned");
+    }
+
+    this->ResetPerThread(true);
+    this->m_Transform->SetParameters(parameters);
+    this->GetValueAndDerivativeMultiThreadedInitiate();
+
+    if (this->m_NumberOfPixelsCounted == 0)
+    {
+      itkExceptionMacro(<< "All the points mapped to outside of the moving image");
+    }
+
+    const unsigned int numberOfParameters = this->m_NumberOfParameters;
+    double sff = 0.0, smm = 0.0, sfm = 0.0, sf = 0.0, sm = 0.0;
+    DerivativeType derivativeF(numberOfParameters);
+    DerivativeType derivativeM(numberOfParameters);
+    DerivativeType derivativeM1(numberOfParameters);
+    derivativeF.Fill(0.0);
+    derivativeM.Fill(0.0);
+    derivativeM1.Fill(0.0);
+    for (ThreadIdType t = 0; t < this->m_NumberOfThreads; ++t)
+    {
+      const PerThreadType& sums = m_PerThread[t];
+      sff += sums.m_Sff;
+      smm += sums.m_Smm;
+      sfm += sums.m_Sfm;
+      sf += sums.m_Sf;
+      sm += sums.m_Sm;
+      derivativeF += sums.m_DerivativeF;
+      derivativeM += sums.m_DerivativeM;
+      derivativeM1 += sums.m_DerivativeM1;
+    }
+
+    if (m_SubtractMean)
+    {
+      const double numberOfPixels = this->m_NumberOfPixelsCounted;
+      sff -= sf * sf / numberOfPixels;
+      smm -= sm * sm / numberOfPixels;
+      sfm -= sf * sm / numberOfPixels;
+      for (unsigned int par = 0; par < numberOfParameters; ++par)
+      {
+        derivativeF[par] -= derivativeM1[par] * sf / numberOfPixels;
+        derivativeM[par] -= derivativeM1[par] * sm / numberOfPixels;
+      }
+    }
+
+    derivative = DerivativeType(numberOfParameters);
+    derivative.Fill(NumericTraits< typename DerivativeType::ValueType >::Zero);
+    value = NumericTraits< MeasureType >::Zero;
+
+    const double denom = -1.0 * std::sqrt(sff * smm);
+    if (denom != 0.0)
+    {
+      value = sfm / denom;
+      for (unsigned int par = 0; par < numberOfParameters; ++par)
+      {
+        derivative[par] = (derivativeF[par] - (sfm / smm) * derivativeM[par]) / denom;
+      }
+    }
+  }
+
+  template < class TFixedImage, class TMovingImage >
+  void MultiThreadedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>
+    ::PrintSelf(std::ostream & os, Indent indent) const
+  {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "SubtractMean: " << m_SubtractMean << std::endl;
+  }
+} // end namespace itk
+
+#endif // ITKMULTITHREADEDNORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC_TXX
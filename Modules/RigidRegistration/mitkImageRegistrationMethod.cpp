@@ -85,6 +85,11 @@ namespace mitk {
     m_Optimizer = optimizer;
   }
 
+  void ImageRegistrationMethod::SetMetricParameters(MetricParameters::Pointer metricParameters)
+  {
+    m_MetricParameters = metricParameters;
+  }
+
   void ImageRegistrationMethod::SetOptimizerScales(itk::Array<double> scales)
   {
     m_OptimizerScales = scales;
@@ -25,6 +25,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageAccessByItk.h"
 #include "mitkRigidRegistrationObserver.h"
 #include "mitkCommon.h"
+#include "mitkMetricParameters.h"
 
 #include "itkImageMaskSpatialObject.h"
 #include "mitkRigidRegistrationPreset.h"
@@ -74,6 +75,11 @@ namespace mitk
 
     void SetOptimizer(itk::Object::Pointer optimizer);
 
+    /**
+    \brief Optional metric parameters whose threading and sampling settings are applied to the metric (see MetricFactory::ConfigureMetric()).
+    */
+    void SetMetricParameters(MetricParameters::Pointer metricParameters);
+
   protected:
     ImageRegistrationMethod();
     virtual ~ImageRegistrationMethod();
@@ -93,6 +99,7 @@ namespace mitk
     itk::Object::Pointer m_Metric;
     itk::Object::Pointer m_Optimizer;
     itk::Array<double> m_OptimizerScales;
+    MetricParameters::Pointer m_MetricParameters;
   };
 }
 
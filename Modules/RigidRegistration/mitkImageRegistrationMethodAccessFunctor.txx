@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkLinearInterpolateImageFunction.h>
 
+#include "mitkMetricFactory.h"
+
 namespace mitk {
 
 template<typename TPixel, unsigned int VImageDimension>
@@ -75,6 +77,12 @@ void ImageRegistrationMethodAccessFunctor::AccessItkImage(const itk::Image<TPixe
     metric->SetMovingImageMask(movingImageMask);
   if(fixedImageMask.IsNotNull())
     metric->SetFixedImageMask(fixedImageMask);
+  if(method->m_MetricParameters.IsNotNull())
+  {
+    typename MetricFactory<TPixel, VImageDimension>::Pointer metricFactory = MetricFactory<TPixel, VImageDimension>::New();
+    metricFactory->SetMetricParameters(method->m_MetricParameters);
+    metricFactory->ConfigureMetric(metric, fixedImage);
+  }
   // the transform
   TransformPointer transform = dynamic_cast<TransformType*>(method->m_Transform.GetPointer());
   // the optimizer
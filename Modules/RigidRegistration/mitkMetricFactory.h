@@ -68,6 +68,18 @@ namespace mitk {
     */
     MetricPointer GetMetric( );
 
+    /**
+    \brief Applies the threading and sampling settings of the metric parameters to \a metric before it is evaluated on \a fixedImage.
+
+    Random and stratified sampling select a fraction of the voxels of \a fixedImage. Voxels outside of the fixed image mask
+    of \a metric are skipped, so the fraction refers to the masked region. Call this again whenever the fixed image changes,
+    e.g. for every level of a multi-resolution registration. If no voxel is selected for \a fixedImage, the voxels
+    selected for a previous level are dropped and the metric evaluates every voxel again. Only metrics evaluating the fixed image samples of
+    itk::ImageToImageMetric (mean squares, Mattes mutual information and the multi-threaded normalized correlation)
+    are multi-threaded and use the selected voxels, all other metrics keep evaluating every voxel.
+    */
+    void ConfigureMetric( MetricType* metric, FixedImageType* fixedImage );
+
     /**
     \brief Sets the instance to the metric parameters class which holds all parameters for the new metric.
     */
@@ -88,6 +100,11 @@ namespace mitk {
     MetricFactory();
     ~MetricFactory() {};
 
+    /**
+    \brief Lets \a metric evaluate all voxels again if a previous call of ConfigureMetric() selected fixed image voxels.
+    */
+    void ResetFixedImageIndexes( MetricType* metric );
+
     MetricParameters::Pointer m_MetricParameters;
   };
 
@@ -30,6 +30,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkNormalizedMutualInformationHistogramImageToImageMetric.h>
 #include <itkMatchCardinalityImageToImageMetric.h>
 #include <itkKappaStatisticImageToImageMetric.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include "itkMultiThreadedNormalizedCorrelationImageToImageMetric.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace mitk {
 
@@ -50,6 +55,12 @@ namespace mitk {
       MetricPointer->SetComputeGradient(m_MetricParameters->GetComputeGradient());
       return MetricPointer.GetPointer();
     }
+    else if (metric == MetricParameters::NORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC && m_MetricParameters->GetUseMultiThreading())
+    {
+      typename itk::MultiThreadedNormalizedCorrelationImageToImageMetric<FixedImageType, MovingImageType>::Pointer MetricPointer = itk::MultiThreadedNormalizedCorrelationImageToImageMetric<FixedImageType, MovingImageType>::New();
+      MetricPointer->SetComputeGradient(m_MetricParameters->GetComputeGradient());
+      return MetricPointer.GetPointer();
+    }
     else if (metric == MetricParameters::NORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC)
     {
       typename itk::NormalizedCorrelationImageToImageMetric<FixedImageType, MovingImageType>::Pointer MetricPointer = itk::NormalizedCorrelationImageToImageMetric<FixedImageType, MovingImageType>::New();
@@ -169,4 +180,109 @@ namespace mitk {
     }
     return NULL;
   }
+
+  template < class TPixelType, unsigned int VImageDimension >
+  void MetricFactory<TPixelType, VImageDimension>
+    ::ConfigureMetric( MetricType* metric, FixedImageType* fixedImage )
+  {
+    if (metric == nullptr || fixedImage == nullptr)
+    {
+      return;
+    }
+
+    if (m_MetricParameters->GetUseMultiThreading() && m_MetricParameters->GetNumberOfThreads() > 0)
+    {
+      metric->SetNumberOfThreads(m_MetricParameters->GetNumberOfThreads());
+    }
+
+    const int sampling = m_MetricParameters->GetSamplingStrategy();
+    const double percentage = m_MetricParameters->GetSamplingPercentage();
+    if (sampling == MetricParameters::ALLPIXELSSAMPLING || percentage <= 0.0 || percentage >= 1.0)
+    {
+      this->ResetFixedImageIndexes(metric);
+      return;
+    }
+
+    typedef typename FixedImageType::RegionType RegionType;
+    typedef typename FixedImageType::IndexType IndexType;
+    typedef typename FixedImageType::PointType PointType;
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+    const RegionType region = fixedImage->GetBufferedRegion();
+    const typename MetricType::FixedImageMaskType* mask = metric->GetFixedImageMask();
+    typename GeneratorType::Pointer generator = GeneratorType::New();
+    generator->Initialize( 76926294 );
+
+    typename MetricType::FixedImageIndexContainer indexes;
+    IndexType index;
+    PointType point;
+    if (sampling == MetricParameters::RANDOMSAMPLING)
+    {
+      const itk::SizeValueType numberOfCandidates = static_cast<itk::SizeValueType>(region.GetNumberOfPixels() * percentage);
+      indexes.reserve(numberOfCandidates);
+      for (itk::SizeValueType i = 0; i < numberOfCandidates; ++i)
+      {
+        for (unsigned int d = 0; d < VImageDimension; ++d)
+        {
+          index[d] = region.GetIndex(d) + generator->GetIntegerVariate(region.GetSize(d) - 1);
+        }
+        fixedImage->TransformIndexToPhysicalPoint(index, point);
+        if (mask == nullptr || mask->IsInside(point))
+        {
+          indexes.push_back(index);
+        }
+      }
+    }
+    else if (sampling == MetricParameters::STRATIFIEDSAMPLING)
+    {
+      // one random voxel from every cell of a regular grid, a cell holds about 1/percentage voxels
+      const double cellEdge = std::max(1.0, std::pow(1.0 / percentage, 1.0 / VImageDimension));
+      itk::SizeValueType cells[VImageDimension];
+      itk::SizeValueType numberOfCells = 1;
+      for (unsigned int d = 0; d < VImageDimension; ++d)
+      {
+        cells[d] = static_cast<itk::SizeValueType>(std::ceil(region.GetSize(d) / cellEdge));
+        numberOfCells *= cells[d];
+      }
+      indexes.reserve(numberOfCells);
+      for (itk::SizeValueType cell = 0; cell < numberOfCells; ++cell)
+      {
+        itk::SizeValueType rest = cell;
+        for (unsigned int d = 0; d < VImageDimension; ++d)
+        {
+          const itk::SizeValueType cellIndex = rest % cells[d];
+          rest /= cells[d];
+          const itk::SizeValueType begin = static_cast<itk::SizeValueType>(cellIndex * cellEdge);
+          const itk::SizeValueType end = std::min(static_cast<itk::SizeValueType>((cellIndex + 1) * cellEdge), static_cast<itk::SizeValueType>(region.GetSize(d)));
+          index[d] = region.GetIndex(d) + begin + generator->GetIntegerVariate(end - begin - 1);
+        }
+        fixedImage->TransformIndexToPhysicalPoint(index, point);
+        if (mask == nullptr || mask->IsInside(point))
+        {
+          indexes.push_back(index);
+        }
+      }
+    }
+
+    if (indexes.empty())
+    {
+      MITK_WARN << "No fixed image voxel was sampled, the metric evaluates all voxels.";
+      this->ResetFixedImageIndexes(metric);
+      return;
+    }
+    metric->SetUseAllPixels(false);
+    metric->SetFixedImageIndexes(indexes);
+  }
+
+  template < class TPixelType, unsigned int VImageDimension >
+  void MetricFactory<TPixelType, VImageDimension>
+    ::ResetFixedImageIndexes( MetricType* metric )
+  {
+    // the metric is configured once per pyramid level, drop the voxels selected for a previous level
+    if (metric->GetUseFixedImageIndexes())
+    {
+      metric->SetUseFixedImageIndexes(false);
+      metric->SetUseAllPixels(true);
+    }
+  }
 } // end namespace
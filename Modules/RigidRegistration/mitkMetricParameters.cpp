@@ -23,6 +23,10 @@ namespace mitk {
   MetricParameters::MetricParameters() :
     m_Metric(MEANSQUARESIMAGETOIMAGEMETRIC),
     m_ComputeGradient(true),
+    m_UseMultiThreading(false),
+    m_NumberOfThreads(0),
+    m_SamplingStrategy(ALLPIXELSSAMPLING),
+    m_SamplingPercentage(1.0),
     // for itk::KullbackLeiblerCompareHistogramImageToImageMetric
     m_NumberOfHistogramBinsKullbackLeiblerCompareHistogram(256),
     // for itk::CorrelationCoefficientHistogramImageToImageMetric
@@ -49,4 +53,16 @@ namespace mitk {
   {
 
   }
+
+  void MetricParameters::SetEvaluationParameters(const itk::Array<double>& metricValues)
+  {
+    // evaluation settings are stored behind the metric specific values
+    if (metricValues.size() > 23)
+    {
+      this->SetSamplingStrategy(metricValues[20]);
+      this->SetSamplingPercentage(metricValues[21] > 0 ? metricValues[21] : 1.0);
+      this->SetUseMultiThreading(metricValues[22]);
+      this->SetNumberOfThreads(metricValues[23]);
+    }
+  }
 } // namespace mitk
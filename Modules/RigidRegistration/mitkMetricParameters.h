@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define MITKMETRICPARAMETERS_H
 
 #include <itkObjectFactory.h>
+#include <itkArray.h>
 #include "MitkRigidRegistrationExports.h"
 #include "mitkCommon.h"
 
@@ -64,6 +65,18 @@ namespace mitk {
       KAPPASTATISTICIMAGETOIMAGEMETRIC = 12
     };
 
+    /**
+    \brief Unique integer value for every strategy used to select the fixed image voxels the metric is evaluated on.
+
+    ALLPIXELSSAMPLING leaves the sampling to the metric. RANDOMSAMPLING draws uniformly distributed voxels,
+    STRATIFIEDSAMPLING draws one random voxel from every cell of a regular grid. Both are restricted to the fixed image mask.
+    */
+    enum SamplingStrategyType {
+      ALLPIXELSSAMPLING = 0,
+      RANDOMSAMPLING = 1,
+      STRATIFIEDSAMPLING = 2
+    };
+
     /**
     \brief Sets the metric used for registration by its unique integer value.
     */
@@ -82,6 +95,51 @@ namespace mitk {
     */
     itkGetMacro( ComputeGradient, bool );
 
+    /**
+    \brief Sets whether the metric is evaluated multi-threaded. Normalized correlation is then computed by
+    itk::MultiThreadedNormalizedCorrelationImageToImageMetric.
+    */
+    itkSetMacro( UseMultiThreading, bool );
+    /**
+    \brief Returns whether the metric is evaluated multi-threaded.
+    */
+    itkGetMacro( UseMultiThreading, bool );
+
+    /**
+    \brief Sets the number of threads used for multi-threaded metric evaluation, 0 uses the ITK default.
+    */
+    itkSetMacro( NumberOfThreads, unsigned int );
+    /**
+    \brief Returns the number of threads used for multi-threaded metric evaluation.
+    */
+    itkGetMacro( NumberOfThreads, unsigned int );
+
+    /**
+    \brief Sets the sampling strategy by its unique integer value (see SamplingStrategyType).
+    */
+    itkSetMacro( SamplingStrategy, int );
+    /**
+    \brief Returns the sampling strategy by its unique integer value.
+    */
+    itkGetMacro( SamplingStrategy, int );
+
+    /**
+    \brief Sets the fraction (0, 1] of the fixed image voxels used by random or stratified sampling.
+    */
+    itkSetMacro( SamplingPercentage, double );
+    /**
+    \brief Returns the fraction of the fixed image voxels used by random or stratified sampling.
+    */
+    itkGetMacro( SamplingPercentage, double );
+
+    /**
+    \brief Sets the sampling and threading settings from the metric values of a preset (see RigidRegistrationPreset).
+
+    The values 20 to 23 hold the sampling strategy, the sampling percentage, the multi-threading flag and the number of threads.
+    Shorter arrays leave the settings unchanged.
+    */
+    void SetEvaluationParameters(const itk::Array<double>& metricValues);
+
     /**
     \brief for itk::KullbackLeiblerCompareHistogramImageToImageMetric
     */
@@ -238,6 +296,10 @@ namespace mitk {
 
     int m_Metric;
     bool m_ComputeGradient;
+    bool m_UseMultiThreading;
+    unsigned int m_NumberOfThreads;
+    int m_SamplingStrategy;
+    double m_SamplingPercentage;
     // for itk::KullbackLeiblerCompareHistogramImageToImageMetric
     unsigned int m_NumberOfHistogramBinsKullbackLeiblerCompareHistogram;
     // for itk::CorrelationCoefficientHistogramImageToImageMetric
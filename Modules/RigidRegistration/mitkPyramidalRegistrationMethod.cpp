@@ -120,6 +120,8 @@ namespace mitk {
     metricParameters->SetMetric(metricValues[0]);
     metricParameters->SetComputeGradient(metricValues[1]);
 
+    metricParameters->SetEvaluationParameters(metricValues);
+
     // Some things have to be checked for every metric individually
     if(metricValues[0] == mitk::MetricParameters::MUTUALINFORMATIONHISTOGRAMIMAGETOIMAGEMETRIC)
     {
@@ -216,6 +216,13 @@ void PyramidalRegistrationMethodAccessFunctor::AccessItkImage(const itk::Image<T
   command->m_Presets = method->m_Presets;
   command->m_UseMask = method->m_UseMask;
   command->m_BrainMask = method->m_BrainMask;
+  command->m_FixedImagePyramid = fixedImagePyramid.GetPointer();
+  // metric threading and sampling can differ between the levels, they are applied by the command at the start of each level
+  for(unsigned int level = 0; level < method->m_Presets.size(); level++)
+  {
+    command->m_LevelMetricParameters.push_back(level == 0 ? method->m_MetricParameters
+                                               : method->ParseMetricParameters(method->m_Preset->getMetricValues(method->m_Presets[level])));
+  }
 
   registration->AddObserver( itk::IterationEvent(), command );
   registration->SetSchedules(method->m_FixedSchedule, method->m_MovingSchedule);
@@ -44,12 +44,15 @@ namespace mitk {
     typedef itk::SingleValuedNonLinearOptimizer         OptimizerType;
     typedef OptimizerType *                             OptimizerPointer;
     typedef itk::ImageMaskSpatialObject< 3 >            MaskType;
+    typedef mitk::MetricFactory<float, 3>               MetricFactoryType;
 
 
     mitk::RigidRegistrationObserver::Pointer observer;
     bool m_UseMask;
     std::vector<std::string> m_Presets;
     MaskType::Pointer m_BrainMask;
+    itk::ProcessObject::Pointer m_FixedImagePyramid;
+    std::vector<mitk::MetricParameters::Pointer> m_LevelMetricParameters;
 
     void Execute(itk::Object * object, const itk::EventObject & event) override
     {
@@ -159,6 +162,17 @@ namespace mitk {
 
       }
 
+      // apply the metric threading and sampling of this level to the images of this level
+      if( !m_LevelMetricParameters.empty() && m_FixedImagePyramid.IsNotNull() )
+      {
+        unsigned int level = std::min<unsigned int>( registration->GetCurrentLevel(), m_LevelMetricParameters.size() - 1 );
+        MetricFactoryType::Pointer metFac = MetricFactoryType::New();
+        metFac->SetMetricParameters( m_LevelMetricParameters[level] );
+        itk::ProcessObject::DataObjectPointerArray levelImages = m_FixedImagePyramid->GetOutputs();
+        metFac->ConfigureMetric( registration->GetMetric(),
+          dynamic_cast<MetricFactoryType::FixedImageType*>( levelImages[registration->GetCurrentLevel()].GetPointer() ) );
+      }
+
       registration->Print(std::cout,0);
       std::cout << std::endl;
       std::cout << "METRIC" << std::endl;
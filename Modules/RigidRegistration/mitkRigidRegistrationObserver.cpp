@@ -17,13 +17,26 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkRigidRegistrationObserver.h"
 #include "mitkProgressBar.h"
 
-mitk::RigidRegistrationObserver::RigidRegistrationObserver() : m_OptimizerValue(0), m_StopOptimization(false)
+#include <itkProcessObject.h>
+
+mitk::RigidRegistrationObserver::RigidRegistrationObserver() : m_OptimizerValue(0), m_StopOptimization(false), m_Clock(itk::RealTimeClock::New()), m_IterationTime(0)
 {
+  m_IterationStartTime = m_Clock->GetTimeInSeconds();
 }
 
 void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::EventObject & event)
 {
-  if (typeid(event) == typeid(itk::IterationEvent))
+  if (typeid(event) == typeid(itk::StartEvent))
+  {
+    // registration methods start once, optimizers once per resolution level
+    if (dynamic_cast<itk::ProcessObject*>(caller) != nullptr)
+    {
+      m_OptimizerValues.clear();
+      m_IterationTimes.clear();
+    }
+    m_IterationStartTime = m_Clock->GetTimeInSeconds();
+  }
+  else if (typeid(event) == typeid(itk::IterationEvent))
   {
     OptimizerPointer optimizer = dynamic_cast<OptimizerPointer>(caller);
     ExhaustiveOptimizerPointer ExhaustiveOptimizer = dynamic_cast<ExhaustiveOptimizerPointer>(optimizer);
@@ -51,7 +64,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         //ExhaustiveOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (GradientDescentOptimizer != nullptr)
     {
@@ -65,7 +78,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         GradientDescentOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (QuaternionRigidTransformGradientDescentOptimizer != nullptr)
     {
@@ -79,7 +92,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         QuaternionRigidTransformGradientDescentOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (LBFGSBOptimizer != nullptr)
     {
@@ -93,7 +106,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         //LBFGSBOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (OnePlusOneEvolutionaryOptimizer != nullptr)
     {
@@ -107,7 +120,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         OnePlusOneEvolutionaryOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (PowellOptimizer != nullptr)
     {
@@ -121,7 +134,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         PowellOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (FRPROptimizer != nullptr)
     {
@@ -135,7 +148,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         FRPROptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (RegularStepGradientDescentOptimizer != nullptr)
     {
@@ -149,7 +162,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         RegularStepGradientDescentOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (VersorRigid3DTransformOptimizer != nullptr)
     {
@@ -163,7 +176,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         VersorRigid3DTransformOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (VersorTransformOptimizer != nullptr)
     {
@@ -177,7 +190,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         VersorTransformOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (AmoebaOptimizer != nullptr)
     {
@@ -190,7 +203,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         //AmoebaOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (ConjugateGradientOptimizer != nullptr)
     {
@@ -204,7 +217,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         //ConjugateGradientOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (LBFGSOptimizer != nullptr)
     {
@@ -217,7 +230,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
       /*MITK_INFO << LBFGSOptimizer->GetCurrentIteration() << "   ";
       MITK_INFO << LBFGSOptimizer->GetValue() << "   ";
       MITK_INFO << LBFGSOptimizer->GetInfinityNormOfProjectedGradient() << std::endl;*/
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
     else if (SPSAOptimizer != nullptr)
     {
@@ -231,7 +244,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         SPSAOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
   }
   else if (typeid(event) == typeid(itk::FunctionEvaluationIterationEvent))
@@ -249,7 +262,7 @@ void mitk::RigidRegistrationObserver::Execute(itk::Object *caller, const itk::Ev
         //AmoebaOptimizer->StopOptimization();
         m_StopOptimization = false;
       }
-      InvokeEvent(itk::ModifiedEvent());
+      IterationDone();
     }
   }
   mitk::ProgressBar::GetInstance()->AddStepsToDo(1);
@@ -280,6 +293,31 @@ itk::Array<double> mitk::RigidRegistrationObserver::GetCurrentTranslation()
   return m_Params;
 }
 
+void mitk::RigidRegistrationObserver::IterationDone()
+{
+  double now = m_Clock->GetTimeInSeconds();
+  m_IterationTime = now - m_IterationStartTime;
+  m_IterationStartTime = now;
+  m_OptimizerValues.push_back(m_OptimizerValue);
+  m_IterationTimes.push_back(m_IterationTime);
+  InvokeEvent(itk::ModifiedEvent());
+}
+
+double mitk::RigidRegistrationObserver::GetCurrentIterationTime()
+{
+  return m_IterationTime;
+}
+
+const std::vector<double>& mitk::RigidRegistrationObserver::GetOptimizerValues()
+{
+  return m_OptimizerValues;
+}
+
+const std::vector<double>& mitk::RigidRegistrationObserver::GetIterationTimes()
+{
+  return m_IterationTimes;
+}
+
 // Sets the stop optimization flag, which is used to call the StopOptimization() method of the optimizer.
 // Unfortunately it is not implemented for ExhaustiveOptimizer, LBFGSBOptimizer, AmoebaOptimizer, ConjugateGradientOptimizer and LBFGSOptimizer in ITK.
 void mitk::RigidRegistrationObserver::SetStopOptimization(bool stopOptimization)
@@ -35,8 +35,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkLBFGSOptimizer.h>
 #include <itkSPSAOptimizer.h>
 #include "itkCommand.h"
+#include <itkRealTimeClock.h>
 #include "mitkCommon.h"
 
+#include <vector>
+
 namespace mitk {
 
   /**
@@ -56,6 +59,9 @@ namespace mitk {
   * iteration step of the optimizer. Unfortunately this is not implemented for ExhaustiveOptimizer, LBFGSBOptimizer, AmoebaOptimizer,
   * ConjugateGradientOptimizer and LBFGSOptimizer in ITK.
   *
+  * For every iteration the optimizer value and the time since the previous iteration are recorded. The records are cleared
+  * when a registration method starts.
+  *
   * \author Daniel Stein
   */
   class MITKRIGIDREGISTRATION_EXPORT RigidRegistrationObserver : public itk::Command
@@ -160,13 +166,38 @@ namespace mitk {
       */
       void SetStopOptimization(bool stopOptimization);
 
+      /**
+      * \brief Returns the duration of the last iteration step in seconds.
+      */
+      double GetCurrentIterationTime();
+
+      /**
+      * \brief Returns the optimizer values of all iteration steps since the registration started.
+      */
+      const std::vector<double>& GetOptimizerValues();
+
+      /**
+      * \brief Returns the durations in seconds of all iteration steps since the registration started.
+      */
+      const std::vector<double>& GetIterationTimes();
+
     protected:
       RigidRegistrationObserver();
 
+      /**
+      * \brief Records value and duration of the finished iteration step and informs the listeners.
+      */
+      void IterationDone();
+
   private:
     double m_OptimizerValue;
     itk::Array<double> m_Params;
     bool m_StopOptimization;
+    itk::RealTimeClock::Pointer m_Clock;
+    double m_IterationStartTime;
+    double m_IterationTime;
+    std::vector<double> m_OptimizerValues;
+    std::vector<double> m_IterationTimes;
 
   };
 
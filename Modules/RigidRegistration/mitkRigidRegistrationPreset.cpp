@@ -506,6 +506,15 @@ namespace mitk {
     std::string computeGradient = ReadXMLStringAttribut( "COMPUTEGRADIENT", atts );
     double compGra = atof(computeGradient.c_str());
     metricValues[1] = compGra;
+    // evaluation settings shared by all metrics, stored behind the metric specific values
+    std::string sampling = ReadXMLStringAttribut( "SAMPLING", atts );
+    metricValues[20] = atof(sampling.c_str());
+    std::string samplingPercentage = ReadXMLStringAttribut( "SAMPLINGPERCENTAGE", atts );
+    metricValues[21] = atof(samplingPercentage.c_str());
+    std::string multiThreading = ReadXMLStringAttribut( "MULTITHREADING", atts );
+    metricValues[22] = atof(multiThreading.c_str());
+    std::string numberOfThreads = ReadXMLStringAttribut( "NUMBEROFTHREADS", atts );
+    metricValues[23] = atof(numberOfThreads.c_str());
     if (metric == mitk::MetricParameters::MEANSQUARESIMAGETOIMAGEMETRIC || metric == mitk::MetricParameters::NORMALIZEDCORRELATIONIMAGETOIMAGEMETRIC
         || metric == mitk::MetricParameters::GRADIENTDIFFERENCEIMAGETOIMAGEMETRIC || metric == mitk::MetricParameters::MATCHCARDINALITYIMAGETOIMAGEMETRIC
         || metric == mitk::MetricParameters::KAPPASTATISTICIMAGETOIMAGEMETRIC)
@@ -20,6 +20,48 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "ipSegmentation.h"
 
+#include <cstdlib>
+
+namespace
+{
+  // The distance transform is ported from ipMITKSegmentationInterpolate() (ipSegmentationInterpolate.c)
+  // and gives exactly the same results, but keeps the distance map of each slice.
+
+  const short MaxDistance = 2048;
+  const unsigned int MaskElements = 5;
+
+  short ChamferDistance(const short* const oldDistance, const short* maskDistance, const int* maskOffset)
+  {
+    short currentDistance = oldDistance[0];
+    if (std::abs(currentDistance) != 5)
+    {
+      if (currentDistance > 0)
+      {
+        for (unsigned int i = 0; i < MaskElements; ++i)
+        {
+          short newDistance = maskDistance[i] + oldDistance[maskOffset[i]];
+          if (newDistance < currentDistance)
+          {
+            currentDistance = newDistance;
+          }
+        }
+      }
+      else if (currentDistance < 0)
+      {
+        for (unsigned int i = 0; i < MaskElements; ++i)
+        {
+          short newDistance = oldDistance[maskOffset[i]] - maskDistance[i];
+          if (newDistance > currentDistance)
+          {
+            currentDistance = newDistance;
+          }
+        }
+      }
+    }
+    return currentDistance;
+  }
+}
+
 mitk::Image::Pointer
 mitk::ShapeBasedInterpolationAlgorithm::Interpolate(
                                Image::ConstPointer lowerSlice, unsigned int lowerSliceIndex,
@@ -30,46 +72,162 @@ mitk::ShapeBasedInterpolationAlgorithm::Interpolate(
                                unsigned int /*timeStep*/,
                                Image::ConstPointer /*referenceImage*/)
 {
-  // convert these slices to the ipSegmentation data type (into an ITK image)
-  itk::Image< ipMITKSegmentationTYPE, 2 >::Pointer correctPixelTypeLowerITKSlice;
-  CastToItkImage( lowerSlice, correctPixelTypeLowerITKSlice );
-  assert ( correctPixelTypeLowerITKSlice.IsNotNull() );
-
-  itk::Image< ipMITKSegmentationTYPE, 2 >::Pointer correctPixelTypeUpperITKSlice;
-  CastToItkImage( upperSlice, correctPixelTypeUpperITKSlice );
-  assert ( correctPixelTypeUpperITKSlice.IsNotNull() );
-
-  // correct direction info
-  itk::Image< ipMITKSegmentationTYPE, 2 >::DirectionType imageDirection;
-  imageDirection.SetIdentity();
-  correctPixelTypeLowerITKSlice->SetDirection(imageDirection);
-  correctPixelTypeUpperITKSlice->SetDirection(imageDirection);
-
-  // back-convert to MITK images to access a mitkIpPicDescriptor
-  Image::Pointer correctPixelTypeLowerMITKSlice = Image::New();
-  CastToMitkImage( correctPixelTypeLowerITKSlice, correctPixelTypeLowerMITKSlice );
-  mitkIpPicDescriptor* lowerPICSlice = mitkIpPicNew();
-  CastToIpPicDescriptor( correctPixelTypeLowerMITKSlice, lowerPICSlice);
-
-  Image::Pointer correctPixelTypeUpperMITKSlice = Image::New();
-  CastToMitkImage( correctPixelTypeUpperITKSlice, correctPixelTypeUpperMITKSlice );
-  mitkIpPicDescriptor* upperPICSlice = mitkIpPicNew();
-  CastToIpPicDescriptor( correctPixelTypeUpperMITKSlice, upperPICSlice);
+  DistanceMap lowerDistanceMap;
+  ComputeDistanceMap( lowerSlice, lowerDistanceMap );
+
+  DistanceMap upperDistanceMap;
+  ComputeDistanceMap( upperSlice, upperDistanceMap );
+
+  return Interpolate( lowerDistanceMap, lowerSliceIndex, upperDistanceMap, upperSliceIndex, requestedIndex, resultImage );
+}
+
+mitk::Image::Pointer
+mitk::ShapeBasedInterpolationAlgorithm::Interpolate(
+                               const DistanceMap& lowerDistanceMap, unsigned int lowerSliceIndex,
+                               const DistanceMap& upperDistanceMap, unsigned int upperSliceIndex,
+                               unsigned int requestedIndex,
+                               Image::Pointer resultImage)
+{
+  if ( lowerDistanceMap.IsEmpty() || upperDistanceMap.IsEmpty() ) return nullptr;
+  if ( lowerDistanceMap.Width != upperDistanceMap.Width || lowerDistanceMap.Height != upperDistanceMap.Height ) return nullptr;
 
   // calculate where the current slice is in comparison to the lower and upper neighboring slices
   float ratio = (float)(requestedIndex - lowerSliceIndex) / (float)(upperSliceIndex - lowerSliceIndex);
 
-  mitkIpPicDescriptor* ipPicResult = ipMITKSegmentationInterpolate( lowerPICSlice, upperPICSlice, ratio ); // magic
-  if (!ipPicResult) return nullptr;
+  std::vector<ipMITKSegmentationTYPE> result( lowerDistanceMap.Width * lowerDistanceMap.Height );
+  Interpolate( lowerDistanceMap, upperDistanceMap, ratio, &result[0] );
+
+  unsigned int dimensions[2] = { lowerDistanceMap.Width, lowerDistanceMap.Height };
 
   BaseGeometry::Pointer originalGeometry = resultImage->GetGeometry();
-  resultImage->Initialize( CastToImageDescriptor( ipPicResult ) );
-  // FIXME resultImage->SetPicSlice( ipPicResult );
-  resultImage->SetSlice( ipPicResult->data );
+  resultImage->Initialize( MakeScalarPixelType<ipMITKSegmentationTYPE>(), 2, dimensions );
+  resultImage->SetSlice( &result[0] );
   resultImage->SetGeometry( originalGeometry );
 
-  mitkIpPicFree( ipPicResult );
-
   return resultImage;
 }
 
+void mitk::ShapeBasedInterpolationAlgorithm::ComputeDistanceMap(Image::ConstPointer slice, DistanceMap& distanceMap)
+{
+  // convert the slice to the ipSegmentation data type (into an ITK image)
+  itk::Image< ipMITKSegmentationTYPE, 2 >::Pointer correctPixelTypeITKSlice;
+  CastToItkImage( slice, correctPixelTypeITKSlice );
+  assert ( correctPixelTypeITKSlice.IsNotNull() );
+
+  itk::Image< ipMITKSegmentationTYPE, 2 >::SizeType size = correctPixelTypeITKSlice->GetLargestPossibleRegion().GetSize();
+  ComputeDistanceMap( correctPixelTypeITKSlice->GetBufferPointer(), size[0], size[1], distanceMap );
+}
+
+void mitk::ShapeBasedInterpolationAlgorithm::ComputeDistanceMap(const unsigned char* mask, unsigned int width, unsigned int height, DistanceMap& distanceMap)
+{
+  // the legacy algorithm pads the slice by 2 background pixels and adds a frame of 1 pixel for the distance transform
+  const unsigned int paddedWidth = width + 4;
+  const unsigned int paddedHeight = height + 4;
+  const int mapWidth = static_cast<int>(paddedWidth + 2);
+  const int mapHeight = static_cast<int>(paddedHeight + 2);
+
+  distanceMap.Width = width;
+  distanceMap.Height = height;
+  distanceMap.Distances.assign( static_cast<std::size_t>(mapWidth) * mapHeight, -MaxDistance );
+
+  short* distances = &distanceMap.Distances[0];
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      if ( mask[x + y * width] > 0 )
+      {
+        distances[(x + 3) + (y + 3) * mapWidth] = MaxDistance;
+      }
+    }
+  }
+
+  // mark the border pixels of the segmentation, same scan order as the legacy code
+  short* dst = distances + (1 + mapWidth);
+  for (unsigned int y = 0; y < paddedHeight; ++y)
+  {
+    for (unsigned int x = 0; x < paddedWidth; ++x)
+    {
+      if ((dst[0] < dst[1]) || (dst[0] < dst[mapWidth]))
+      {
+        *dst = -5;
+      }
+      else if ((dst[0] > dst[1]) || (dst[0] > dst[mapWidth]))
+      {
+        *dst = 5;
+      }
+      ++dst;
+    }
+    dst += 2;
+  }
+  dst -= 2;
+  for (unsigned int y = 0; y < paddedHeight; ++y)
+  {
+    for (unsigned int x = 0; x < paddedWidth; ++x)
+    {
+      --dst;
+      if (std::abs(dst[0]) > 5)
+      {
+        if ((dst[0] < dst[-1]) || (dst[0] < dst[-mapWidth]))
+        {
+          *dst = -5;
+        }
+        else if ((dst[0] > dst[-1]) || (dst[0] > dst[-mapWidth]))
+        {
+          *dst = 5;
+        }
+      }
+    }
+  }
+
+  // chamfer distance transform, top-left to bottom-right and back, the frame is neglected
+  const short maskDistance[MaskElements] = { 0, 10, 14, 10, 14 };
+  const int maskX[MaskElements] = { 0, -1, +1,  0, -1 };
+  const int maskY[MaskElements] = { 0,  0, -1, -1, -1 };
+  int maskOffset[MaskElements];
+  for (unsigned int i = 0; i < MaskElements; ++i)
+  {
+    maskOffset[i] = maskX[i] + maskY[i] * mapWidth;
+  }
+
+  for (int y = 1; y <= mapHeight - 2; ++y)
+  {
+    short* pixel = distances + (1 + y * mapWidth);
+    for (int x = 1; x <= mapWidth - 2; ++x, ++pixel)
+    {
+      *pixel = ChamferDistance( pixel, maskDistance, maskOffset );
+    }
+  }
+
+  for (unsigned int i = 0; i < MaskElements; ++i)
+  {
+    maskOffset[i] = -maskOffset[i];
+  }
+
+  for (int y = mapHeight - 2; y >= 1; --y)
+  {
+    short* pixel = distances + ((mapWidth - 2) + y * mapWidth);
+    for (int x = mapWidth - 2; x >= 1; --x, --pixel)
+    {
+      *pixel = ChamferDistance( pixel, maskDistance, maskOffset );
+    }
+  }
+}
+
+void mitk::ShapeBasedInterpolationAlgorithm::Interpolate(const DistanceMap& lowerDistanceMap, const DistanceMap& upperDistanceMap, float ratio, unsigned char* result)
+{
+  const float weight[] = { 1.0f - ratio, ratio }; // weights of the interpolants
+  const unsigned int mapWidth = lowerDistanceMap.Width + 6;
+
+  for (unsigned int y = 0; y < lowerDistanceMap.Height; ++y)
+  {
+    const short* lower = &lowerDistanceMap.Distances[3 + (y + 3) * mapWidth];
+    const short* upper = &upperDistanceMap.Distances[3 + (y + 3) * mapWidth];
+    unsigned char* out = result + y * lowerDistanceMap.Width;
+
+    for (unsigned int x = 0; x < lowerDistanceMap.Width; ++x)
+    {
+      out[x] = ( weight[0] * lower[x] + weight[1] * upper[x] > 0 ? 1 : 0 );
+    }
+  }
+}
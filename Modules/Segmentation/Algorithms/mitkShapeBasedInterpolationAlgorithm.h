@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkLegacyAdaptors.h"
 #include <MitkSegmentationExports.h>
 
+#include <vector>
+
 namespace mitk
 {
 
@@ -33,6 +35,10 @@ namespace mitk
  * G.T. Herman, J. Zheng, C.A. Bucholtz: "Shape-based interpolation"
  * IEEE Computer Graphics & Applications, pp. 69-79,May 1992
  *
+ * The signed distance maps of the two neighboring slices are independent of each other,
+ * so they can be computed once by ComputeDistanceMap() and reused for every slice in between
+ * (see SegmentationInterpolationController).
+ *
  *  Last contributor:
  *  $Author:$
  */
@@ -51,6 +57,53 @@ class MITKSEGMENTATION_EXPORT ShapeBasedInterpolationAlgorithm : public Segmenta
                                Image::Pointer resultImage,
                                unsigned int timeStep,
                                Image::ConstPointer referenceImage) override;
+
+    /**
+     * \brief Signed chamfer distance map of a slice, positive inside the segmentation.
+     *
+     * The map covers the slice plus a border of three pixels on each side,
+     * i.e. it holds (Width + 6) x (Height + 6) values in row major order.
+     */
+    struct DistanceMap
+    {
+      DistanceMap() : Width(0), Height(0) {}
+
+      bool IsEmpty() const { return Distances.empty(); }
+
+      unsigned int Width;
+      unsigned int Height;
+      std::vector<short> Distances;
+    };
+
+    /**
+     * \brief Computes the distance map of a 2D slice, pixels greater than 0 are segmented.
+     */
+    static void ComputeDistanceMap(Image::ConstPointer slice, DistanceMap& distanceMap);
+
+    /**
+     * \brief Computes the distance map of a binary mask of width x height pixels in row major order (non-zero is segmented).
+     *
+     * Does not use any ITK or MITK objects and may be called from several threads at once.
+     */
+    static void ComputeDistanceMap(const unsigned char* mask, unsigned int width, unsigned int height, DistanceMap& distanceMap);
+
+    /**
+     * \brief Interpolates between two distance maps of equal size.
+     *
+     * \param ratio position of the requested slice, 0 at the lower and 1 at the upper slice
+     * \param result receives Width x Height values of 0 or 1 in row major order
+     *
+     * Like ComputeDistanceMap(const unsigned char*, ...) this may be called from several threads at once.
+     */
+    static void Interpolate(const DistanceMap& lowerDistanceMap, const DistanceMap& upperDistanceMap, float ratio, unsigned char* result);
+
+    /**
+     * \brief Interpolates between two precomputed distance maps, the result keeps the geometry of resultImage.
+     */
+    Image::Pointer Interpolate(const DistanceMap& lowerDistanceMap, unsigned int lowerSliceIndex,
+                               const DistanceMap& upperDistanceMap, unsigned int upperSliceIndex,
+                               unsigned int requestedIndex,
+                               Image::Pointer resultImage);
 };
 
 } // namespace
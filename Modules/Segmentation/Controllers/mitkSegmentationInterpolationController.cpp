@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageTimeSelector.h"
 #include <mitkExtractSliceFilter.h>
 #include "mitkImageReadAccessor.h"
+#include "mitkImageDataItem.h"
+#include "mitkImageVtkWriteAccessor.h"
+#include "mitkVtkImageOverwrite.h"
 //#include <mitkPlaneGeometry.h>
 
 #include "mitkShapeBasedInterpolationAlgorithm.h"
@@ -29,6 +32,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImage.h>
 #include <itkImageSliceConstIteratorWithIndex.h>
 
+#include <vtkSmartPointer.h>
+
 mitk::SegmentationInterpolationController::InterpolatorMapType mitk::SegmentationInterpolationController::s_InterpolatorForImage; // static member initialization
 
 mitk::SegmentationInterpolationController* mitk::SegmentationInterpolationController::InterpolatorForImage(const Image* image)
@@ -86,6 +91,7 @@ void mitk::SegmentationInterpolationController::SetSegmentationVolume( const Ima
 {
   // clear old information (remove all time steps
   m_SegmentationCountInSlice.clear();
+  m_DistanceMapCache.clear();
 
   // delete this from the list of interpolators
   auto iter = s_InterpolatorForImage.find( segmentation );
@@ -111,14 +117,17 @@ void mitk::SegmentationInterpolationController::SetSegmentationVolume( const Ima
   m_Segmentation = segmentation;
 
   m_SegmentationCountInSlice.resize( m_Segmentation->GetTimeSteps() );
+  m_DistanceMapCache.resize( m_Segmentation->GetTimeSteps() );
   for (unsigned int timeStep = 0; timeStep < m_Segmentation->GetTimeSteps(); ++timeStep)
   {
     m_SegmentationCountInSlice[timeStep].resize(3);
+    m_DistanceMapCache[timeStep].resize(3);
     for (unsigned int dim = 0; dim < 3; ++dim)
     {
       m_SegmentationCountInSlice[timeStep][dim].clear();
       m_SegmentationCountInSlice[timeStep][dim].resize( m_Segmentation->GetDimension(dim) );
       m_SegmentationCountInSlice[timeStep][dim].assign( m_Segmentation->GetDimension(dim), 0 );
+      m_DistanceMapCache[timeStep][dim].resize( m_Segmentation->GetDimension(dim) );
     }
   }
 
@@ -255,12 +264,20 @@ void mitk::SegmentationInterpolationController::ScanChangedSlice( const itk::Ima
       m_SegmentationCountInSlice[timeStep][dim0][u] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][dim0][u] + value );
       m_SegmentationCountInSlice[timeStep][dim1][v] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][dim1][v] + value );
       numberOfPixels += static_cast<int>( value );
+
+      if ( value != 0 )
+      {
+        // the slices crossing this pixel changed, too
+        InvalidateDistanceMap( timeStep, dim0, u );
+        InvalidateDistanceMap( timeStep, dim1, v );
+      }
     }
   }
 
   // flag for the dimension of the slice itself
   assert ( (signed) m_SegmentationCountInSlice[timeStep][sliceDimension][sliceIndex] + numberOfPixels >= 0 );
   m_SegmentationCountInSlice[timeStep][sliceDimension][sliceIndex] += numberOfPixels;
+  InvalidateDistanceMap( timeStep, sliceDimension, sliceIndex );
 
   //MITK_INFO << "scan t=" << timeStep << " from (0,0) to (" << dim0max << "," << dim1max << ") (" << pixelData << "-" << pixelData+dim0max*dim1max-1 <<  ") in slice " << sliceIndex << " found " << numberOfPixels << " pixels" << std::endl;
 }
@@ -276,6 +293,7 @@ void mitk::SegmentationInterpolationController::ScanChangedVolume( const itk::Im
   iter.SetSecondDirection(1);
 
   int numberOfPixels(0); // number of pixels in this slice that are not 0
+  bool sliceChanged(false);
 
   typename IteratorType::IndexType index;
   unsigned int x = 0;
@@ -305,6 +323,13 @@ void mitk::SegmentationInterpolationController::ScanChangedVolume( const itk::Im
 
         numberOfPixels += static_cast<int>( value );
 
+        if ( value != 0 )
+        {
+          InvalidateDistanceMap( timeStep, 0, x );
+          InvalidateDistanceMap( timeStep, 1, y );
+          sliceChanged = true;
+        }
+
         ++iter;
       }
       iter.NextLine();
@@ -313,6 +338,12 @@ void mitk::SegmentationInterpolationController::ScanChangedVolume( const itk::Im
     m_SegmentationCountInSlice[timeStep][2][z] += numberOfPixels;
     numberOfPixels = 0;
 
+    if ( sliceChanged )
+    {
+      InvalidateDistanceMap( timeStep, 2, z );
+      sliceChanged = false;
+    }
+
     iter.NextSlice();
   }
 }
@@ -443,91 +474,196 @@ mitk::Image::Pointer mitk::SegmentationInterpolationController::Interpolate( uns
   // ok, we have found two neighboring slices with segmentations (and we made sure that the current slice does NOT contain anything
   //MITK_INFO << "Interpolate in timestep " << timeStep << ", dimension " << sliceDimension << ": estimate slice " << sliceIndex << " from slices " << lowerBound << " and " << upperBound << std::endl;
 
-  mitk::Image::Pointer lowerMITKSlice;
-  mitk::Image::Pointer upperMITKSlice;
   mitk::Image::Pointer resultImage;
 
   try
   {
-    //Setting up the ExtractSliceFilter
-    mitk::ExtractSliceFilter::Pointer extractor = ExtractSliceFilter::New();
-    extractor->SetInput(m_Segmentation);
-    extractor->SetTimeStep(timeStep);
-    extractor->SetResliceTransformByGeometry( m_Segmentation->GetTimeGeometry()->GetGeometryForTimeStep( timeStep ) );
-    extractor->SetVtkOutputRequest(false);
-
-    //Reslicing the current plane
-    extractor->SetWorldGeometry(currentPlane);
-    extractor->Modified();
-    extractor->Update();
-    resultImage = extractor->GetOutput();
-    resultImage->DisconnectPipeline();
-
-    //Creating PlaneGeometry for lower slice
-    mitk::PlaneGeometry::Pointer reslicePlane = currentPlane->Clone();
-
-    //Transforming the current origin so that it matches the lower slice
-    mitk::Point3D origin = currentPlane->GetOrigin();
-    m_Segmentation->GetSlicedGeometry(timeStep)->WorldToIndex(origin, origin);
-    origin[sliceDimension] = lowerBound;
-    m_Segmentation->GetSlicedGeometry(timeStep)->IndexToWorld(origin, origin);
-    reslicePlane->SetOrigin(origin);
-
-    //Extract the lower slice
-    extractor = ExtractSliceFilter::New();
-    extractor->SetInput(m_Segmentation);
-    extractor->SetTimeStep(timeStep);
-    extractor->SetResliceTransformByGeometry(m_Segmentation->GetTimeGeometry()->GetGeometryForTimeStep(timeStep));
-    extractor->SetVtkOutputRequest(false);
-
-    extractor->SetWorldGeometry(reslicePlane);
-    extractor->Modified();
-    extractor->Update();
-    lowerMITKSlice = extractor->GetOutput();
-    lowerMITKSlice->DisconnectPipeline();
-
-    //Transforming the current origin so that it matches the upper slice
-    m_Segmentation->GetSlicedGeometry(timeStep)->WorldToIndex(origin, origin);
-    origin[sliceDimension] = upperBound;
-    m_Segmentation->GetSlicedGeometry(timeStep)->IndexToWorld(origin, origin);
-    reslicePlane->SetOrigin(origin);
-
-    //Extract the upper slice
-    extractor = ExtractSliceFilter::New();
-    extractor->SetInput(m_Segmentation);
-    extractor->SetTimeStep(timeStep);
-    extractor->SetResliceTransformByGeometry(m_Segmentation->GetTimeGeometry()->GetGeometryForTimeStep(timeStep));
-    extractor->SetVtkOutputRequest(false);
-
-    extractor->SetWorldGeometry(reslicePlane);
-    extractor->Modified();
-    extractor->Update();
-    upperMITKSlice = extractor->GetOutput();
-    upperMITKSlice->DisconnectPipeline();
-
-    if ( lowerMITKSlice.IsNull() || upperMITKSlice.IsNull() ) return nullptr;
+    //Reslicing the current plane, only its geometry is used for the result
+    resultImage = ExtractSlice( currentPlane, timeStep );
+
+    // the distance maps of the neighboring slices are cached, so they are extracted only once while scrolling through a gap
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& lowerDistanceMap =
+      GetDistanceMap( MovePlaneToSlice( currentPlane, sliceDimension, lowerBound, timeStep ), sliceDimension, lowerBound, timeStep );
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& upperDistanceMap =
+      GetDistanceMap( MovePlaneToSlice( currentPlane, sliceDimension, upperBound, timeStep ), sliceDimension, upperBound, timeStep );
+
+    // interpolation algorithm gets some inputs
+    //   two segmentations (as distance maps of the segmented slices)
+    //   position of the two slices (sliceIndices)
+    // the shape-based interpolation does not consider the original patient image (m_ReferenceImage)
+    mitk::ShapeBasedInterpolationAlgorithm::Pointer algorithm = mitk::ShapeBasedInterpolationAlgorithm::New();
+    return algorithm->Interpolate( lowerDistanceMap, lowerBound,
+                                   upperDistanceMap, upperBound,
+                                   sliceIndex,
+                                   resultImage );
   }
   catch(const std::exception &e)
   {
     MITK_ERROR<<"Error in 2D interpolation: "<<e.what();
     return nullptr;
   }
+}
+
+unsigned int mitk::SegmentationInterpolationController::InterpolateAllSlices( unsigned int sliceDimension, const mitk::PlaneGeometry* plane, unsigned int timeStep, Image* target )
+{
+  if ( m_Segmentation.IsNull() || !plane || !target ) return 0;
+  if ( timeStep >= m_SegmentationCountInSlice.size() ) return 0;
+  if ( sliceDimension > 2 ) return 0;
+
+  const DirtyVectorType& segmentationCount = m_SegmentationCountInSlice[timeStep][sliceDimension];
+
+  std::vector<unsigned int> segmentedSlices;
+  for (unsigned int sliceIndex = 0; sliceIndex < segmentationCount.size(); ++sliceIndex)
+  {
+    if ( segmentationCount[sliceIndex] > 0 )
+    {
+      segmentedSlices.push_back( sliceIndex );
+    }
+  }
 
-  // interpolation algorithm gets some inputs
-  //   two segmentations (guaranteed to be of the same data type, but no special data type guaranteed)
-  //   orientation (sliceDimension) of the segmentations
-  //   position of the two slices (sliceIndices)
-  //   one volume image (original patient image)
-  //
-  // interpolation algorithm can use e.g. itk::ImageSliceConstIteratorWithIndex to
-  //   inspect the original patient image at appropriate positions
-
-  mitk::SegmentationInterpolationAlgorithm::Pointer algorithm = mitk::ShapeBasedInterpolationAlgorithm::New().GetPointer();
-  return algorithm->Interpolate( lowerMITKSlice.GetPointer(), lowerBound,
-                                 upperMITKSlice.GetPointer(), upperBound,
-                                 sliceIndex,
-                                 sliceDimension,
-                                 resultImage,
-                                 timeStep,
-                                 m_ReferenceImage );
+  // every empty slice between two neighboring segmented slices (a gap) is interpolated
+  std::vector<unsigned int> sliceIndices;
+  std::vector<unsigned int> gapIndices; // index of the lower segmented slice in segmentedSlices
+  std::vector<const ShapeBasedInterpolationAlgorithm::DistanceMap*> distanceMaps( segmentedSlices.size(), nullptr );
+
+  try
+  {
+    for (unsigned int gap = 0; gap + 1 < segmentedSlices.size(); ++gap)
+    {
+      if ( segmentedSlices[gap + 1] - segmentedSlices[gap] < 2 ) continue;
+
+      // slice extraction is not thread-safe, so all distance maps are collected before interpolating
+      for (unsigned int bound = gap; bound <= gap + 1; ++bound)
+      {
+        if ( !distanceMaps[bound] )
+        {
+          distanceMaps[bound] = &GetDistanceMap( MovePlaneToSlice( plane, sliceDimension, segmentedSlices[bound], timeStep ),
+                                                 sliceDimension, segmentedSlices[bound], timeStep );
+        }
+      }
+
+      for (unsigned int sliceIndex = segmentedSlices[gap] + 1; sliceIndex < segmentedSlices[gap + 1]; ++sliceIndex)
+      {
+        sliceIndices.push_back( sliceIndex );
+        gapIndices.push_back( gap );
+      }
+    }
+  }
+  catch(const std::exception &e)
+  {
+    MITK_ERROR<<"Error in 2D interpolation: "<<e.what();
+    return 0;
+  }
+
+  // the slices are independent of each other
+  const int numberOfSlices = static_cast<int>( sliceIndices.size() );
+  std::vector< std::vector<unsigned char> > interpolations( numberOfSlices );
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < numberOfSlices; ++i)
+  {
+    const unsigned int gap = gapIndices[i];
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& lowerDistanceMap = *distanceMaps[gap];
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& upperDistanceMap = *distanceMaps[gap + 1];
+
+    if ( lowerDistanceMap.IsEmpty() || upperDistanceMap.IsEmpty() ) continue;
+    if ( lowerDistanceMap.Width != upperDistanceMap.Width || lowerDistanceMap.Height != upperDistanceMap.Height ) continue;
+
+    const unsigned int lowerBound = segmentedSlices[gap];
+    const unsigned int upperBound = segmentedSlices[gap + 1];
+    float ratio = (float)(sliceIndices[i] - lowerBound) / (float)(upperBound - lowerBound);
+
+    interpolations[i].resize( lowerDistanceMap.Width * lowerDistanceMap.Height );
+    ShapeBasedInterpolationAlgorithm::Interpolate( lowerDistanceMap, upperDistanceMap, ratio, interpolations[i].data() );
+  }
+
+  // write back with the same reslicing the slices were extracted with
+  unsigned int numberOfInterpolatedSlices(0);
+  for (int i = 0; i < numberOfSlices; ++i)
+  {
+    if ( interpolations[i].empty() ) continue;
+
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& lowerDistanceMap = *distanceMaps[gapIndices[i]];
+    unsigned int dimensions[2] = { lowerDistanceMap.Width, lowerDistanceMap.Height };
+
+    Image::Pointer interpolation = Image::New();
+    interpolation->Initialize( MakeScalarPixelType<unsigned char>(), 2, dimensions );
+    interpolation->SetSlice( interpolations[i].data() );
+
+    vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
+    reslice->SetInputSlice( interpolation->GetSliceData()->GetVtkImageAccessor(interpolation)->GetVtkImageData() );
+    reslice->SetOverwriteMode(true);
+    reslice->Modified();
+
+    mitk::ExtractSliceFilter::Pointer sliceWriter = mitk::ExtractSliceFilter::New(reslice);
+    sliceWriter->SetInput( target );
+    sliceWriter->SetTimeStep( 0 );
+    sliceWriter->SetWorldGeometry( MovePlaneToSlice( plane, sliceDimension, sliceIndices[i], timeStep ) );
+    sliceWriter->SetVtkOutputRequest(true);
+    sliceWriter->SetResliceTransformByGeometry( target->GetTimeGeometry()->GetGeometryForTimeStep( 0 ) );
+    sliceWriter->Modified();
+    sliceWriter->Update();
+
+    ++numberOfInterpolatedSlices;
+  }
+
+  return numberOfInterpolatedSlices;
+}
+
+mitk::Image::Pointer mitk::SegmentationInterpolationController::ExtractSlice( const PlaneGeometry* plane, unsigned int timeStep )
+{
+  mitk::ExtractSliceFilter::Pointer extractor = ExtractSliceFilter::New();
+  extractor->SetInput(m_Segmentation);
+  extractor->SetTimeStep(timeStep);
+  extractor->SetResliceTransformByGeometry( m_Segmentation->GetTimeGeometry()->GetGeometryForTimeStep( timeStep ) );
+  extractor->SetVtkOutputRequest(false);
+
+  extractor->SetWorldGeometry(plane);
+  extractor->Modified();
+  extractor->Update();
+
+  Image::Pointer slice = extractor->GetOutput();
+  slice->DisconnectPipeline();
+  return slice;
+}
+
+mitk::PlaneGeometry::Pointer mitk::SegmentationInterpolationController::MovePlaneToSlice( const PlaneGeometry* plane, unsigned int sliceDimension, unsigned int sliceIndex, unsigned int timeStep )
+{
+  mitk::PlaneGeometry::Pointer reslicePlane = plane->Clone();
+
+  //Transforming the origin so that it matches the slice
+  mitk::Point3D origin = plane->GetOrigin();
+  m_Segmentation->GetSlicedGeometry(timeStep)->WorldToIndex(origin, origin);
+  origin[sliceDimension] = sliceIndex;
+  m_Segmentation->GetSlicedGeometry(timeStep)->IndexToWorld(origin, origin);
+  reslicePlane->SetOrigin(origin);
+
+  return reslicePlane;
+}
+
+const mitk::ShapeBasedInterpolationAlgorithm::DistanceMap& mitk::SegmentationInterpolationController::GetDistanceMap( const PlaneGeometry* plane, unsigned int sliceDimension, unsigned int sliceIndex, unsigned int timeStep )
+{
+  CachedDistanceMap& cached = m_DistanceMapCache[timeStep][sliceDimension][sliceIndex];
+
+  if ( cached.distanceMap.IsEmpty() || cached.plane.IsNull() || !mitk::Equal( *cached.plane, *plane, mitk::eps, false ) )
+  {
+    Image::Pointer slice = ExtractSlice( plane, timeStep );
+    ShapeBasedInterpolationAlgorithm::ComputeDistanceMap( slice.GetPointer(), cached.distanceMap );
+    cached.plane = plane;
+  }
+
+  return cached.distanceMap;
+}
+
+void mitk::SegmentationInterpolationController::InvalidateDistanceMap( unsigned int timeStep, unsigned int sliceDimension, unsigned int sliceIndex )
+{
+  if ( timeStep >= m_DistanceMapCache.size() ) return;
+  if ( sliceIndex >= m_DistanceMapCache[timeStep][sliceDimension].size() ) return;
+
+  CachedDistanceMap& cached = m_DistanceMapCache[timeStep][sliceDimension][sliceIndex];
+  if ( !cached.distanceMap.IsEmpty() )
+  {
+    cached.distanceMap = ShapeBasedInterpolationAlgorithm::DistanceMap();
+    cached.plane = nullptr;
+  }
 }
@@ -20,6 +20,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkCommon.h"
 #include <MitkSegmentationExports.h>
 #include "mitkImage.h"
+#include "mitkPlaneGeometry.h"
+#include "mitkShapeBasedInterpolationAlgorithm.h"
 
 #include <itkImage.h>
 #include <itkObjectFactory.h>
@@ -61,6 +63,11 @@ class Image;
 
   \image html slice_based_segmentation_interpolator.png
 
+  The interpolation is calculated from the distance maps of the two neighboring segmented slices. These distance maps
+  are cached per slice (in m_DistanceMapCache, which has the same layout as m_SegmentationCountInSlice), so scrolling
+  through the slices of a gap only extracts the slice to be interpolated. SetChangedSlice() and SetChangedVolume()
+  drop the cached maps of all slices touched by the difference image, a scan of the whole volume drops all of them.
+
   $Author$
 */
 class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::Object
@@ -136,6 +143,25 @@ class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::
     */
     Image::Pointer Interpolate( unsigned int sliceDimension, unsigned int sliceIndex, const mitk::PlaneGeometry* currentPlane, unsigned int timeStep );
 
+    /**
+      \brief Interpolates every empty slice between two segmented slices of one dimension and writes the results into a volume.
+
+      The distance maps of the segmented slices are taken from the cache or computed once, then all slices are
+      interpolated in parallel. The interpolated slices are written into \a target with the same reslicing as
+      they were extracted with, so the result is the same as calling Interpolate() for every slice.
+
+      \param sliceDimension Number of the dimension which is constant for all pixels of the meant slices.
+
+      \param plane Any plane of the slices in sliceDimension, e.g. the current plane of a render window. It is moved to every slice.
+
+      \param timeStep Which time step to use
+
+      \param target 3D image with the extent of the segmentation (e.g. a difference image for undo), the interpolations are written into it.
+
+      \return The number of interpolated slices
+    */
+    unsigned int InterpolateAllSlices( unsigned int sliceDimension, const mitk::PlaneGeometry* plane, unsigned int timeStep, Image* target );
+
     void OnImageModified(const itk::EventObject&);
 
     /**
@@ -169,6 +195,17 @@ class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::
     typedef std::vector< std::vector<DirtyVectorType> > TimeResolvedDirtyVectorType;
     typedef std::map< const Image*, SegmentationInterpolationController* > InterpolatorMapType;
 
+    /**
+      \brief Distance map of a segmented slice together with the plane the slice was extracted with.
+    */
+    struct CachedDistanceMap
+    {
+      PlaneGeometry::ConstPointer plane;
+      ShapeBasedInterpolationAlgorithm::DistanceMap distanceMap;
+    };
+
+    typedef std::vector< std::vector< std::vector<CachedDistanceMap> > > TimeResolvedDistanceMapCacheType;
+
     SegmentationInterpolationController();// purposely hidden
     virtual ~SegmentationInterpolationController();
 
@@ -184,6 +221,17 @@ class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::
 
     void PrintStatus();
 
+    /// extracts the slice of the segmentation that is cut by plane
+    Image::Pointer ExtractSlice( const PlaneGeometry* plane, unsigned int timeStep );
+
+    /// returns the distance map of a segmented slice, from the cache if it was computed for the same plane before
+    const ShapeBasedInterpolationAlgorithm::DistanceMap& GetDistanceMap( const PlaneGeometry* plane, unsigned int sliceDimension, unsigned int sliceIndex, unsigned int timeStep );
+
+    /// a copy of plane, moved to the slice sliceIndex of dimension sliceDimension
+    PlaneGeometry::Pointer MovePlaneToSlice( const PlaneGeometry* plane, unsigned int sliceDimension, unsigned int sliceIndex, unsigned int timeStep );
+
+    void InvalidateDistanceMap( unsigned int timeStep, unsigned int sliceDimension, unsigned int sliceIndex );
+
     /**
       An array of flags. One for each dimension of the image. A flag is set, when a slice in a certain dimension
       has at least one pixel that is not 0 (which would mean that it has to be considered by the interpolation algorithm).
@@ -194,6 +242,11 @@ class MITKSEGMENTATION_EXPORT SegmentationInterpolationController : public itk::
     */
     TimeResolvedDirtyVectorType m_SegmentationCountInSlice;
 
+    /**
+      Cached distance maps of segmented slices, m_DistanceMapCache[timeStep][sliceDimension][sliceIndex].
+    */
+    TimeResolvedDistanceMapCacheType m_DistanceMapCache;
+
     static InterpolatorMapType s_InterpolatorForImage;
 
     Image::ConstPointer m_Segmentation;
@@ -15,12 +15,20 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkSegmentationInterpolationController.h"
+#include "mitkShapeBasedInterpolationAlgorithm.h"
+#include "mitkExtractSliceFilter.h"
 #include "mitkCoreObjectFactory.h"
 #include "mitkStandardFileLocations.h"
-#include "mitkDataNodeFactory.h"
 #include "ipSegmentation.h"
 #include "mitkCompareImageSliceTestHelper.h"
 
+#include <mitkIOUtil.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 class mitkSegmentationInterpolationTestClass
 {
   public:
@@ -41,9 +49,16 @@ class mitkSegmentationInterpolationTestClass
           && CreateTwoSlices(0)
           && TestInterpolation(0)
           && DeleteInterpolator()
+          && CompareDistanceMapInterpolationToLegacyInterpolation()
+          && CreateNewInterpolator()
+          && CompareInterpolateAllSlicesToInterpolate()
           && CreateNewInterpolator()
-          && LoadTestImages(filename1, filename2)
-          && CompareInterpolationsToDefinedReference();
+          && TestChangedSliceInvalidatesDistanceMap()
+          && DeleteInterpolator()
+          && ( filename1.empty() || filename2.empty() || // the reference images are optional
+               ( CreateNewInterpolator()
+                 && LoadTestImages(filename1, filename2)
+                 && CompareInterpolationsToDefinedReference() ) );
     }
 
   protected:
@@ -56,8 +71,15 @@ class mitkSegmentationInterpolationTestClass
     bool DeleteInterpolator();
     bool LoadTestImages(std::string filename1, std::string filename2);
     bool CompareInterpolationsToDefinedReference();
+    bool CompareDistanceMapInterpolationToLegacyInterpolation();
+    bool CompareInterpolateAllSlicesToInterpolate();
+    bool TestChangedSliceInvalidatesDistanceMap();
 
     mitk::Image::Pointer LoadImage(const std::string& filename);
+    mitk::PlaneGeometry::Pointer CreatePlane(const mitk::Image* image, int slicedim, unsigned int slice);
+    mitk::Image::Pointer CreateAxialSegmentation();
+    void FillRandomSlice(mitk::Image* image, unsigned int slice);
+    static bool SameSlices(mitk::Image* slice1, mitk::Image* slice2);
 
     mitk::SegmentationInterpolationController::Pointer m_Interpolator;
     mitk::Image::Pointer m_Image;
@@ -173,7 +195,7 @@ bool mitkSegmentationInterpolationTestClass::CreateTwoSlices(int slicedim)
 bool mitkSegmentationInterpolationTestClass::TestInterpolation(int slicedim)
 {
   int slice = 1;
-  mitk::Image::Pointer interpolated = m_Interpolator->Interpolate( slicedim, slice, 0 ); // interpolate second slice axial
+  mitk::Image::Pointer interpolated = m_Interpolator->Interpolate( slicedim, slice, CreatePlane( m_Image, slicedim, slice ), 0 ); // interpolate second slice
   if (interpolated.IsNull())
   {
     std::cerr << "  (EE) Interpolation did not return anything for slicedim == " << slicedim << " (although it should)." << std::endl;
@@ -253,34 +275,102 @@ bool mitkSegmentationInterpolationTestClass::LoadTestImages(std::string filename
 mitk::Image::Pointer mitkSegmentationInterpolationTestClass::LoadImage(const std::string& filename)
 {
   mitk::Image::Pointer image = NULL;
-  mitk::DataNodeFactory::Pointer factory = mitk::DataNodeFactory::New();
   try
   {
-    factory->SetFileName( filename );
-    factory->Update();
-
-    if(factory->GetNumberOfOutputs()<1)
-    {
-      std::cerr<<"File " << filename << " could not be loaded [FAILED]"<<std::endl;
-      return NULL;
-    }
-    mitk::DataNode::Pointer node = factory->GetOutput( 0 );
-    image = dynamic_cast<mitk::Image*>(node->GetData());
-    if(image.IsNull())
-    {
-      std::cout<<"File " << filename << " is not an image! [FAILED]"<<std::endl;
-      return NULL;
-    }
+    image = mitk::IOUtil::LoadImage( filename );
   }
-  catch ( itk::ExceptionObject & ex )
+  catch ( const mitk::Exception& ex )
   {
-    std::cerr << "Exception: " << ex << "[FAILED]" << std::endl;
+    std::cerr << "File " << filename << " could not be loaded: " << ex.GetDescription() << " [FAILED]" << std::endl;
     return NULL;
   }
 
   return image;
 }
 
+/**
+ * A standard plane through the voxel centers of the given slice, sagittal for slicedim 0, frontal for 1 and axial for 2.
+*/
+mitk::PlaneGeometry::Pointer mitkSegmentationInterpolationTestClass::CreatePlane(const mitk::Image* image, int slicedim, unsigned int slice)
+{
+  mitk::PlaneGeometry::PlaneOrientation orientation;
+  switch (slicedim)
+  {
+    case 0:
+      orientation = mitk::PlaneGeometry::Sagittal;
+      break;
+    case 1:
+      orientation = mitk::PlaneGeometry::Frontal;
+      break;
+    case 2:
+    default:
+      orientation = mitk::PlaneGeometry::Axial;
+      break;
+  }
+
+  mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+  plane->InitializeStandardPlane( image->GetGeometry(), orientation, 0, true, false );
+
+  // the standard plane lies on the voxel border, move it to the slice like the interpolation controller does
+  mitk::Point3D origin = plane->GetOrigin();
+  image->GetGeometry()->WorldToIndex( origin, origin );
+  origin[slicedim] = slice;
+  image->GetGeometry()->IndexToWorld( origin, origin );
+  plane->SetOrigin( origin );
+
+  return plane;
+}
+
+/**
+ * An empty unsigned char segmentation like the ones of the segmentation tools.
+*/
+mitk::Image::Pointer mitkSegmentationInterpolationTestClass::CreateAxialSegmentation()
+{
+  unsigned int dimensions[3] = { 15, 20, 12 };
+
+  mitk::Image::Pointer segmentation = mitk::Image::New();
+  segmentation->Initialize( mitk::MakeScalarPixelType<unsigned char>(), 3, dimensions );
+  std::memset( segmentation->GetData(), 0, dimensions[0] * dimensions[1] * dimensions[2] );
+
+  return segmentation;
+}
+
+/**
+ * Segments a random blob in an axial slice, i.e. a rectangle with randomly added and removed pixels.
+*/
+void mitkSegmentationInterpolationTestClass::FillRandomSlice(mitk::Image* image, unsigned int slice)
+{
+  const unsigned int width = image->GetDimension(0);
+  const unsigned int height = image->GetDimension(1);
+  unsigned char* p = static_cast<unsigned char*>(image->GetData()) + slice * width * height;
+
+  const unsigned int left = 1 + std::rand() % (width / 2);
+  const unsigned int top = 1 + std::rand() % (height / 2);
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      const bool inside = x >= left && x < width - 2 && y >= top && y < height - 2;
+      p[y * width + x] = ( inside != (std::rand() % 8 == 0) ) ? 1 : 0;
+    }
+  }
+}
+
+bool mitkSegmentationInterpolationTestClass::SameSlices(mitk::Image* slice1, mitk::Image* slice2)
+{
+  if ( !slice1 || !slice2 ) return false;
+
+  itk::Image< ipMITKSegmentationTYPE, 2 >::Pointer itkSlice1;
+  mitk::CastToItkImage( slice1, itkSlice1 );
+  itk::Image< ipMITKSegmentationTYPE, 2 >::Pointer itkSlice2;
+  mitk::CastToItkImage( slice2, itkSlice2 );
+
+  if ( itkSlice1->GetLargestPossibleRegion().GetSize() != itkSlice2->GetLargestPossibleRegion().GetSize() ) return false;
+
+  const unsigned int size = itkSlice1->GetLargestPossibleRegion().GetNumberOfPixels();
+  return std::equal( itkSlice1->GetBufferPointer(), itkSlice1->GetBufferPointer() + size, itkSlice2->GetBufferPointer() );
+}
+
 bool mitkSegmentationInterpolationTestClass::CompareInterpolationsToDefinedReference()
 {
   std::cout << "  (II) Setting segmentation volume... " << std::flush;
@@ -297,7 +387,7 @@ bool mitkSegmentationInterpolationTestClass::CompareInterpolationsToDefinedRefer
 
     std::cout << slice << " " << std::flush;
 
-    mitk::Image::Pointer interpolation = m_Interpolator->Interpolate( 2, slice, 0 );
+    mitk::Image::Pointer interpolation = m_Interpolator->Interpolate( 2, slice, CreatePlane( m_ManualSlices, 2, slice ), 0 );
 
     if ( interpolation.IsNull() )
     {
@@ -318,18 +408,222 @@ bool mitkSegmentationInterpolationTestClass::CompareInterpolationsToDefinedRefer
   return true;
 }
 
+/**
+ * Compares the interpolation between precomputed distance maps to ipMITKSegmentationInterpolate() on random masks.
+*/
+bool mitkSegmentationInterpolationTestClass::CompareDistanceMapInterpolationToLegacyInterpolation()
+{
+  std::cout << "  (II) Comparing distance map interpolation to ipMITKSegmentationInterpolate... " << std::flush;
+
+  std::srand( 4711 );
+  const float ratios[] = { 0.25f, 1.0f / 3.0f, 0.5f, 0.8f };
+
+  for (unsigned int test = 0; test < 20; ++test)
+  {
+    const unsigned int width = 5 + std::rand() % 30;
+    const unsigned int height = 5 + std::rand() % 30;
+
+    mitkIpPicDescriptor* pics[2];
+    mitk::ShapeBasedInterpolationAlgorithm::DistanceMap distanceMaps[2];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      pics[i] = mitkIpPicNew();
+      pics[i]->type = ipMITKSegmentationTYPE_ID;
+      pics[i]->bpe = ipMITKSegmentationBPE;
+      pics[i]->dim = 2;
+      pics[i]->n[0] = width;
+      pics[i]->n[1] = height;
+      pics[i]->data = malloc( _mitkIpPicSize( pics[i] ) );
+
+      // sparse, dense and noisy masks
+      const int density = 1 + std::rand() % 7;
+      ipMITKSegmentationTYPE* mask = static_cast<ipMITKSegmentationTYPE*>( pics[i]->data );
+      for (unsigned int j = 0; j < width * height; ++j)
+      {
+        mask[j] = ( std::rand() % 8 < density ) ? 1 : 0;
+      }
+
+      mitk::ShapeBasedInterpolationAlgorithm::ComputeDistanceMap( mask, width, height, distanceMaps[i] );
+    }
+
+    bool same = true;
+    std::vector<ipMITKSegmentationTYPE> result( width * height );
+    for (const float ratio : ratios)
+    {
+      mitk::ShapeBasedInterpolationAlgorithm::Interpolate( distanceMaps[0], distanceMaps[1], ratio, &result[0] );
+
+      mitkIpPicDescriptor* legacyResult = ipMITKSegmentationInterpolate( pics[0], pics[1], ratio );
+      same = same && legacyResult && std::equal( result.begin(), result.end(), static_cast<ipMITKSegmentationTYPE*>( legacyResult->data ) );
+      if (legacyResult) mitkIpPicFree( legacyResult );
+    }
+
+    mitkIpPicFree( pics[0] );
+    mitkIpPicFree( pics[1] );
+
+    if (!same)
+    {
+      std::cerr << std::endl << "  (EE) Interpolation of random " << width << "x" << height << " masks differs from ipMITKSegmentationInterpolate." << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "OK" << std::endl;
+  return true;
+}
+
+/**
+ * Checks that InterpolateAllSlices writes the same slices as calling Interpolate for every slice.
+*/
+bool mitkSegmentationInterpolationTestClass::CompareInterpolateAllSlicesToInterpolate()
+{
+  std::cout << "  (II) Comparing InterpolateAllSlices to Interpolate... " << std::flush;
+
+  std::srand( 42 );
+  mitk::Image::Pointer segmentation = CreateAxialSegmentation();
+  const unsigned int segmentedSlices[] = { 1, 2, 6, 10 };
+  for (const unsigned int slice : segmentedSlices)
+  {
+    FillRandomSlice( segmentation, slice );
+  }
+  m_Interpolator->SetSegmentationVolume( segmentation );
+
+  // interpolate some slices before, so that part of the distance maps are cached
+  m_Interpolator->Interpolate( 2, 4, CreatePlane( segmentation, 2, 4 ), 0 );
+
+  mitk::Image::Pointer target = mitk::Image::New();
+  target->Initialize( segmentation );
+  std::memset( target->GetData(), 0, segmentation->GetDimension(0) * segmentation->GetDimension(1) * segmentation->GetDimension(2) );
+
+  unsigned int numberOfSlices = m_Interpolator->InterpolateAllSlices( 2, CreatePlane( segmentation, 2, 0 ), 0, target );
+  if ( numberOfSlices != 3 + 3 )
+  {
+    std::cerr << std::endl << "  (EE) InterpolateAllSlices interpolated " << numberOfSlices << " instead of 6 slices." << std::endl;
+    return false;
+  }
+
+  for (unsigned int slice = 0; slice < segmentation->GetDimension(2); ++slice)
+  {
+    mitk::PlaneGeometry::Pointer plane = CreatePlane( segmentation, 2, slice );
+
+    mitk::ExtractSliceFilter::Pointer extractor = mitk::ExtractSliceFilter::New();
+    extractor->SetInput( target );
+    extractor->SetTimeStep( 0 );
+    extractor->SetWorldGeometry( plane );
+    extractor->SetResliceTransformByGeometry( target->GetTimeGeometry()->GetGeometryForTimeStep( 0 ) );
+    extractor->Update();
+    mitk::Image::Pointer writtenSlice = extractor->GetOutput();
+
+    mitk::Image::Pointer interpolation = m_Interpolator->Interpolate( 2, slice, plane, 0 );
+    if ( interpolation.IsNull() )
+    {
+      // not in a gap, nothing may be written into this slice
+      const unsigned int size = segmentation->GetDimension(0) * segmentation->GetDimension(1);
+      const ipMITKSegmentationTYPE* p = static_cast<ipMITKSegmentationTYPE*>( target->GetData() ) + slice * size;
+      if ( static_cast<unsigned int>( std::count( p, p + size, 0 ) ) != size )
+      {
+        std::cerr << std::endl << "  (EE) InterpolateAllSlices wrote into slice " << slice << ", which is not in a gap." << std::endl;
+        return false;
+      }
+    }
+    else if ( !SameSlices( interpolation, writtenSlice ) )
+    {
+      std::cerr << std::endl << "  (EE) InterpolateAllSlices differs from Interpolate in slice " << slice << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "OK" << std::endl;
+  return true;
+}
+
+/**
+ * Checks that SetChangedSlice drops the cached distance map of the changed slice.
+*/
+bool mitkSegmentationInterpolationTestClass::TestChangedSliceInvalidatesDistanceMap()
+{
+  std::cout << "  (II) Testing that SetChangedSlice invalidates the cached distance map... " << std::flush;
+
+  std::srand( 815 );
+  mitk::Image::Pointer segmentation = CreateAxialSegmentation();
+  FillRandomSlice( segmentation, 2 );
+  FillRandomSlice( segmentation, 6 );
+  m_Interpolator->SetSegmentationVolume( segmentation );
+
+  mitk::PlaneGeometry::Pointer plane = CreatePlane( segmentation, 2, 4 );
+  mitk::Image::Pointer interpolationBefore = m_Interpolator->Interpolate( 2, 4, plane, 0 ); // caches the maps of slices 2 and 6
+
+  // draw something else into slice 6 and report the difference like the segmentation tools do
+  const unsigned int width = segmentation->GetDimension(0);
+  const unsigned int height = segmentation->GetDimension(1);
+  unsigned char* slice6 = static_cast<unsigned char*>( segmentation->GetData() ) + 6 * width * height;
+  std::vector<unsigned char> oldSlice6( slice6, slice6 + width * height );
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      slice6[y * width + x] = ( x < 5 && y < 5 ) ? 1 : 0;
+    }
+  }
+
+  unsigned int diffDimensions[2] = { width, height };
+  mitk::Image::Pointer diff = mitk::Image::New();
+  diff->Initialize( mitk::MakeScalarPixelType<int>(), 2, diffDimensions );
+  int* d = static_cast<int*>( diff->GetData() );
+  for (unsigned int i = 0; i < width * height; ++i)
+  {
+    d[i] = static_cast<int>( slice6[i] ) - static_cast<int>( oldSlice6[i] );
+  }
+  m_Interpolator->SetChangedSlice( diff, 2, 6, 0 );
+
+  mitk::Image::Pointer interpolationAfter = m_Interpolator->Interpolate( 2, 4, plane, 0 );
+
+  // a new controller has nothing cached
+  mitk::SegmentationInterpolationController::Pointer freshInterpolator = mitk::SegmentationInterpolationController::New();
+  freshInterpolator->SetSegmentationVolume( segmentation );
+  mitk::Image::Pointer expectedInterpolation = freshInterpolator->Interpolate( 2, 4, plane, 0 );
+
+  if ( interpolationBefore.IsNull() || interpolationAfter.IsNull() || expectedInterpolation.IsNull() )
+  {
+    std::cerr << std::endl << "  (EE) Interpolation did not return anything for slice 4." << std::endl;
+    return false;
+  }
+
+  if ( SameSlices( interpolationBefore, expectedInterpolation ) )
+  {
+    std::cerr << std::endl << "  (EE) Changing slice 6 does not change the interpolation, the test is meaningless." << std::endl;
+    return false;
+  }
+
+  if ( !SameSlices( interpolationAfter, expectedInterpolation ) )
+  {
+    std::cerr << std::endl << "  (EE) Interpolation after SetChangedSlice still uses the old distance map." << std::endl;
+    return false;
+  }
+
+  std::cout << "OK" << std::endl;
+  return true;
+}
+
 /// ctest entry point
 int mitkSegmentationInterpolationTest(int argc, char* argv[])
 {
 // one big variable to tell if anything went wrong
 //  std::cout << "Creating CoreObjectFactory" << std::endl;
 //  itk::ObjectFactoryBase::RegisterFactory(mitk::CoreObjectFactory::New());
+  // the comparison to reference images needs their file names
+  std::string filename1;
+  std::string filename2;
   if (argc < 3)
   {
-    std::cerr << " (EE) Missing arguments for testing" << std::endl;
+    std::cout << " (II) No reference images given, skipping the comparison to reference interpolations" << std::endl;
+  }
+  else
+  {
+    filename1 = argv[1];
+    filename2 = argv[2];
   }
   mitkSegmentationInterpolationTestClass test;
-  if ( test.Test(argv[1], argv[2]) )
+  if ( test.Test(filename1, filename2) )
   {
     std::cout << "[PASSED]" << std::endl;
     return EXIT_SUCCESS;
@@ -682,44 +682,10 @@ void QmitkSlicesInterpolator::AcceptAllInterpolations(mitk::SliceNavigationContr
     unsigned int zslices = m_Segmentation->GetDimension( sliceDimension );
     mitk::ProgressBar::GetInstance()->AddStepsToDo(zslices);
 
-    mitk::Point3D origin = reslicePlane->GetOrigin();
-    unsigned int totalChangedSlices(0);
+    // all slices are interpolated at once and written into the diff image (we don't check if interpolation is necessary/sensible - but m_Interpolator does)
+    unsigned int totalChangedSlices = m_Interpolator->InterpolateAllSlices( sliceDimension, reslicePlane, timeStep, diffImage );
 
-    for (unsigned int sliceIndex = 0; sliceIndex < zslices; ++sliceIndex)
-    {
-      // Transforming the current origin of the reslice plane
-      // so that it matches the one of the next slice
-      m_Segmentation->GetSlicedGeometry()->WorldToIndex(origin, origin);
-      origin[sliceDimension] = sliceIndex;
-      m_Segmentation->GetSlicedGeometry()->IndexToWorld(origin, origin);
-      reslicePlane->SetOrigin(origin);
-      //Set the slice as 'input'
-      mitk::Image::Pointer interpolation = m_Interpolator->Interpolate( sliceDimension, sliceIndex, reslicePlane, timeStep );
-
-      if (interpolation.IsNotNull()) // we don't check if interpolation is necessary/sensible - but m_Interpolator does
-      {
-        //Setting up the reslicing pipeline which allows us to write the interpolation results back into
-        //the image volume
-        vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
-
-        //set overwrite mode to true to write back to the image volume
-        reslice->SetInputSlice(interpolation->GetSliceData()->GetVtkImageAccessor(interpolation)->GetVtkImageData());
-        reslice->SetOverwriteMode(true);
-        reslice->Modified();
-
-        mitk::ExtractSliceFilter::Pointer diffslicewriter =  mitk::ExtractSliceFilter::New(reslice);
-        diffslicewriter->SetInput( diffImage );
-        diffslicewriter->SetTimeStep( 0 );
-        diffslicewriter->SetWorldGeometry(reslicePlane);
-        diffslicewriter->SetVtkOutputRequest(true);
-        diffslicewriter->SetResliceTransformByGeometry( diffImage->GetTimeGeometry()->GetGeometryForTimeStep( 0 ) );
-
-        diffslicewriter->Modified();
-        diffslicewriter->Update();
-        ++totalChangedSlices;
-      }
-      mitk::ProgressBar::GetInstance()->Progress();
-    }
+    mitk::ProgressBar::GetInstance()->Progress(zslices);
     mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 
     if (totalChangedSlices > 0)
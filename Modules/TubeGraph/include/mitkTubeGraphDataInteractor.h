@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDataInteractor.h>
 
 #include "mitkTubeGraph.h"
+#include "mitkTubeGraphPicker.h"
 #include "mitkTubeGraphProperty.h"
 
 namespace mitk
@@ -115,6 +116,7 @@ namespace mitk
 
     TubeGraph::Pointer             m_TubeGraph;
     TubeGraphProperty::Pointer     m_TubeGraphProperty;
+    TubeGraphPicker                m_TubeGraphPicker;
     TubeGraph::TubeDescriptorType  m_LastPickedTube;
     TubeGraph::TubeDescriptorType  m_SecondLastPickedTube;
     ActivationMode                 m_ActivationMode;
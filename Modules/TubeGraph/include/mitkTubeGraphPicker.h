@@ -27,6 +27,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 namespace mitk
 {
+  /**
+  * Picks the tube of a tube graph at a world position. The tube elements are
+  * kept in a bounding volume hierarchy, which is built on the first pick and
+  * rebuilt only if the tube graph has been modified.
+  */
   class MITKTUBEGRAPH_EXPORT TubeGraphPicker
   {
   public:
@@ -44,9 +49,42 @@ namespace mitk
 
   protected:
 
+    /** A tube element with the tube it belongs to. */
+    struct PickableElement
+    {
+      TubeGraph::TubeDescriptorType m_Tube;
+      TubeElement* m_Element;
+      Point3D m_Position;
+      float m_Radius;
+      /** position in the order of the edges and their elements, decides between equally near elements */
+      unsigned int m_Order;
+    };
+
+    /**
+    * A node of the bounding volume hierarchy. The left child directly follows
+    * its parent, leaves reference a range of m_Elements.
+    */
+    struct BoundingVolumeNode
+    {
+      double m_Bounds[6];
+      unsigned int m_FirstElement;
+      unsigned int m_NumberOfElements;
+      unsigned int m_RightChild;
+    };
+
+    /**
+    * Collects the elements of all tubes and sorts them into the hierarchy.
+    */
+    void BuildBoundingVolumeHierarchy();
+    void BuildBoundingVolumeNode(unsigned int firstElement, unsigned int numberOfElements);
+
     Point3D m_WorldPosition;
     TubeGraph::Pointer m_TubeGraph;
     TubeGraphProperty::Pointer m_TubeGraphProperty;
+
+    std::vector<PickableElement> m_Elements;
+    std::vector<BoundingVolumeNode> m_Nodes;
+    itk::TimeStamp m_BuildTime;
   };
 
 } // namespace
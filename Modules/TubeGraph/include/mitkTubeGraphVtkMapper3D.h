@@ -28,6 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkActor.h>
 #include <vtkAppendPolyData.h>
 #include <vtkAssembly.h>
+#include <vtkImplicitFunction.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 
@@ -74,36 +75,80 @@ namespace mitk
     * with each other on an furcation. So you get end-caps and connecting
     * pieces from the spheres. Clipping the tubes with each other avoids
     * structures within the general view.
+    *
+    * The geometry of every tube and furcation is kept in the local storage.
+    * Only tubes whose centerline changed and furcations whose position or
+    * diameter changed are generated new; clipping is repeated only around them.
     */
     virtual void GenerateTubeGraphData(mitk::BaseRenderer* renderer);
 
     /**
     * Render only the visual information like color or visibility new.
+    * Only the actor properties are changed, the geometry stays untouched.
     */
     virtual void RenderTubeGraphPropertyInformation(mitk::BaseRenderer* renderer);
 
+  private:
+
+    /** Geometry of a single tube, generated new only if its centerline changes. */
+    struct TubeBlock
+    {
+      /** x, y, z and radius of all points of the centerline incl. source and target vertex */
+      std::vector<double> m_Centerline;
+      /** the tube around the centerline before clipping */
+      vtkSmartPointer<vtkPolyData> m_Tube;
+      vtkSmartPointer<vtkActor> m_Actor;
+    };
+
+    /** Geometry of a single furcation, generated new only if its position or diameter changes. */
+    struct FurcationBlock
+    {
+      /** x, y, z and radius of the vertex */
+      std::vector<double> m_Sphere;
+      /** the sphere before clipping */
+      vtkSmartPointer<vtkPolyData> m_SpherePolyData;
+      vtkSmartPointer<vtkActor> m_Actor;
+      /** the truncated cylinders of all tubes of this furcation, used to clip the sphere and the other tubes */
+      std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkImplicitFunction> > m_ClipFunctions;
+    };
 
     /**
-    * Converts a single tube into a vtkPolyData. Each point of the
-    * tube surface is labeled with the tube id.
+    * Converts a centerline into a tube by using the vtkTubeFilter.
     */
-    void GeneratePolyDataForTube(TubeGraphEdge& edge, const TubeGraph::Pointer& graph, const TubeGraphProperty::Pointer& graphProperty, mitk::BaseRenderer* renderer);
-    void GeneratePolyDataForFurcation(TubeGraphVertex& vertex, const TubeGraph::Pointer& graph, mitk::BaseRenderer* renderer);
-    void ClipPolyData(TubeGraphVertex& vertex, const TubeGraph::Pointer& graph, const TubeGraphProperty::Pointer& graphProperty, mitk::BaseRenderer* renderer);
-  private:
+    void GeneratePolyDataForTube(TubeBlock& block, mitk::BaseRenderer* renderer);
+    void GeneratePolyDataForFurcation(FurcationBlock& block, mitk::BaseRenderer* renderer);
+
+    /**
+    * Generates for all tubes of the vertex a cylinder truncated at the vertex.
+    */
+    void GenerateClipFunctions(VertexDescriptorType vertexDesc, const std::vector<EdgeDescriptorType>& edgesOfVertex, FurcationBlock& block, const TubeGraph::Pointer& graph);
+
+    /**
+    * Clips a tube with the cylinders of all other tubes at its source and target vertex.
+    */
+    void ClipTube(const TubeGraph::TubeDescriptorType& tube, TubeBlock& block, mitk::BaseRenderer* renderer);
+
+    /**
+    * Clips a sphere with the cylinders of all tubes of its vertex.
+    */
+    void ClipFurcation(FurcationBlock& block);
+
     bool ClipStructures();
 
     class LocalStorage : public mitk::Mapper::BaseLocalStorage
     {
     public:
       vtkSmartPointer<vtkAssembly> m_vtkTubeGraphAssembly;
-      std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkActor> > m_vtkTubesActorMap;
-      std::map<TubeGraph::VertexDescriptorType, vtkSmartPointer<vtkActor> > m_vtkSpheresActorMap;
+      std::map<TubeGraph::TubeDescriptorType, TubeBlock> m_TubeBlocks;
+      std::map<TubeGraph::VertexDescriptorType, FurcationBlock> m_FurcationBlocks;
+
+      bool m_StructuresClipped;
 
       itk::TimeStamp m_lastGenerateDataTime;
       itk::TimeStamp m_lastRenderDataTime;
 
       LocalStorage()
+        : m_StructuresClipped(false)
       {
         m_vtkTubeGraphAssembly = vtkSmartPointer<vtkAssembly>::New();
       }
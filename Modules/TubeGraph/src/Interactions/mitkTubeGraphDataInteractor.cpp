@@ -20,8 +20,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkInteractionPositionEvent.h>
 #include <mitkStatusBar.h>
 
-#include "mitkTubeGraphPicker.h"
-
 #include <vtkCamera.h>
 #include <vtkInteractorStyle.h>
 #include <vtkPointData.h>
@@ -71,13 +69,13 @@ void mitk::TubeGraphDataInteractor::DataNodeChanged()
 bool mitk::TubeGraphDataInteractor::CheckOverTube(const InteractionEvent* interactionEvent)
 {
   const InteractionPositionEvent* positionEvent = dynamic_cast<const InteractionPositionEvent*>(interactionEvent);
-  if(positionEvent == NULL)
+  if(positionEvent == NULL || m_TubeGraph.IsNull())
     return false;
 
-  TubeGraphPicker* picker = new mitk::TubeGraphPicker();
-  picker->SetTubeGraph(m_TubeGraph);
+  // the picker keeps its search structure as long as the tube graph is not modified
+  m_TubeGraphPicker.SetTubeGraph(m_TubeGraph);
 
-  TubeGraph::TubeDescriptorType tubeDescriptor = picker->GetPickedTube(positionEvent->GetPositionInWorld()).first;
+  TubeGraph::TubeDescriptorType tubeDescriptor = m_TubeGraphPicker.GetPickedTube(positionEvent->GetPositionInWorld()).first;
 
   if(tubeDescriptor != TubeGraph::ErrorId )
   {
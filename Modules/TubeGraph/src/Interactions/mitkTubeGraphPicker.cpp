@@ -16,6 +16,18 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkTubeGraphPicker.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace
+{
+  // an element can be picked, if the position is less than this distance away from its surface
+  const mitk::ScalarType PickingTolerance = 1.0;
+
+  const unsigned int MaximumNumberOfElementsPerLeaf = 8;
+}
+
 mitk::TubeGraphPicker::TubeGraphPicker()
 {
   m_WorldPosition.Fill( 0.0 );
@@ -27,10 +39,102 @@ mitk::TubeGraphPicker::~TubeGraphPicker()
 
 void mitk::TubeGraphPicker::SetTubeGraph (const mitk::TubeGraph* tubeGraph)
 {
+  if (m_TubeGraph.GetPointer() != tubeGraph)
+  {
+    m_Elements.clear();
+    m_Nodes.clear();
+  }
   m_TubeGraph = const_cast< mitk::TubeGraph* >( tubeGraph );
   m_TubeGraphProperty = dynamic_cast< TubeGraphProperty* >(m_TubeGraph->GetProperty( "Tube Graph.Visualization Information" ).GetPointer());
 }
 
+void mitk::TubeGraphPicker::BuildBoundingVolumeHierarchy()
+{
+  m_Elements.clear();
+  m_Nodes.clear();
+
+  //collect the elements of all edges in the order of the edges
+  const TubeGraph::GraphType& graph = m_TubeGraph->GetGraph();
+  TubeGraph::EdgeIteratorType itEdges, edgesEnd;
+  for (boost::tie(itEdges, edgesEnd) = boost::edges(graph); itEdges != edgesEnd; ++itEdges)
+  {
+    TubeGraph::TubeDescriptorType tube(boost::source(*itEdges, graph), boost::target(*itEdges, graph));
+    TubeGraphEdge edge = m_TubeGraph->GetEdge(*itEdges);
+    for (unsigned int index = 0; index < edge.GetNumberOfElements(); index++)
+    {
+      PickableElement pickableElement;
+      pickableElement.m_Tube = tube;
+      pickableElement.m_Element = edge.GetTubeElement(index);
+      pickableElement.m_Position = pickableElement.m_Element->GetCoordinates();
+      if (dynamic_cast<mitk::CircularProfileTubeElement* >(pickableElement.m_Element))
+        pickableElement.m_Radius = ((dynamic_cast< mitk::CircularProfileTubeElement* >(pickableElement.m_Element))->GetDiameter())/2;
+      else
+        pickableElement.m_Radius = 0;
+      pickableElement.m_Order = m_Elements.size();
+      m_Elements.push_back(pickableElement);
+    }
+  }
+
+  if (!m_Elements.empty())
+  {
+    m_Nodes.reserve(2 * m_Elements.size() / MaximumNumberOfElementsPerLeaf + 1);
+    this->BuildBoundingVolumeNode(0, m_Elements.size());
+  }
+  m_BuildTime.Modified();
+}
+
+void mitk::TubeGraphPicker::BuildBoundingVolumeNode(unsigned int firstElement, unsigned int numberOfElements)
+{
+  const unsigned int nodeIndex = m_Nodes.size();
+  m_Nodes.push_back(BoundingVolumeNode());
+
+  //the node bounds enclose the picking region of each element; the positions decide the split
+  double bounds[6];
+  double positionBounds[6];
+  for (unsigned int dim = 0; dim < 3; ++dim)
+  {
+    bounds[2 * dim] = positionBounds[2 * dim] = std::numeric_limits<double>::max();
+    bounds[2 * dim + 1] = positionBounds[2 * dim + 1] = -std::numeric_limits<double>::max();
+  }
+  for (unsigned int index = firstElement; index < firstElement + numberOfElements; ++index)
+  {
+    const PickableElement& element = m_Elements[index];
+    const double extent = element.m_Radius + PickingTolerance;
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      bounds[2 * dim] = std::min(bounds[2 * dim], element.m_Position[dim] - extent);
+      bounds[2 * dim + 1] = std::max(bounds[2 * dim + 1], element.m_Position[dim] + extent);
+      positionBounds[2 * dim] = std::min(positionBounds[2 * dim], element.m_Position[dim]);
+      positionBounds[2 * dim + 1] = std::max(positionBounds[2 * dim + 1], element.m_Position[dim]);
+    }
+  }
+  std::copy(bounds, bounds + 6, m_Nodes[nodeIndex].m_Bounds);
+  m_Nodes[nodeIndex].m_FirstElement = firstElement;
+  m_Nodes[nodeIndex].m_RightChild = 0;
+
+  if (numberOfElements <= MaximumNumberOfElementsPerLeaf)
+  {
+    m_Nodes[nodeIndex].m_NumberOfElements = numberOfElements;
+    return;
+  }
+  m_Nodes[nodeIndex].m_NumberOfElements = 0;
+
+  //split at the median of the longest axis
+  unsigned int splitAxis = 0;
+  for (unsigned int dim = 1; dim < 3; ++dim)
+  {
+    if (positionBounds[2 * dim + 1] - positionBounds[2 * dim] > positionBounds[2 * splitAxis + 1] - positionBounds[2 * splitAxis])
+      splitAxis = dim;
+  }
+  const unsigned int numberOfLeftElements = numberOfElements / 2;
+  std::nth_element(m_Elements.begin() + firstElement, m_Elements.begin() + firstElement + numberOfLeftElements, m_Elements.begin() + firstElement + numberOfElements,
+    [splitAxis](const PickableElement& left, const PickableElement& right) { return left.m_Position[splitAxis] < right.m_Position[splitAxis]; });
+
+  this->BuildBoundingVolumeNode(firstElement, numberOfLeftElements);
+  m_Nodes[nodeIndex].m_RightChild = m_Nodes.size();
+  this->BuildBoundingVolumeNode(firstElement + numberOfLeftElements, numberOfElements - numberOfLeftElements);
+}
+
 /**
 * Implements the picking process
 */
@@ -44,44 +148,66 @@ std::pair<mitk::TubeGraph::TubeDescriptorType, mitk::TubeElement*> mitk::TubeGra
   }
   m_WorldPosition = pickedPosition;
 
-  Point3D currentPosition;
+  if (m_Nodes.empty() || m_TubeGraph->GetMTime() > m_BuildTime)
+  {
+    this->BuildBoundingVolumeHierarchy();
+  }
+
   ScalarType closestDistance = itk::NumericTraits<ScalarType>::max();
   ScalarType currentDistance = itk::NumericTraits<ScalarType>::max();
-  float currentRadius = 0;
+  unsigned int closestOrder = 0;
 
-  TubeGraph::TubeDescriptorType currentTubeId (TubeGraph::ErrorId);
   TubeGraph::TubeDescriptorType tubeId (TubeGraph::ErrorId);
-  TubeElement* tubeElement;
+  TubeElement* tubeElement = nullptr;
 
+  std::map<TubeGraph::TubeDescriptorType, bool> visibleTubes;
 
-  //iterate over all edges and find the edge, which element is near by the clicked point
-  std::vector<mitk::TubeGraphEdge> allEdges = m_TubeGraph->GetVectorOfAllEdges();
-  for(auto edge = allEdges.begin(); edge != allEdges.end(); ++edge)
+  //descend only into the nodes whose bounds contain the clicked point; the element nearest to it is picked
+  std::vector<unsigned int> nodesToVisit;
+  if (!m_Nodes.empty())
+    nodesToVisit.push_back(0);
+  while (!nodesToVisit.empty())
   {
-    std::pair<mitk::TubeGraphVertex, mitk::TubeGraphVertex> soureTargetPair = m_TubeGraph->GetVerticesOfAnEdge(m_TubeGraph->GetEdgeDescriptor(*edge));
+    const unsigned int nodeIndex = nodesToVisit.back();
+    nodesToVisit.pop_back();
+    const BoundingVolumeNode& node = m_Nodes[nodeIndex];
+
+    if (m_WorldPosition[0] < node.m_Bounds[0] || m_WorldPosition[0] > node.m_Bounds[1]
+      || m_WorldPosition[1] < node.m_Bounds[2] || m_WorldPosition[1] > node.m_Bounds[3]
+      || m_WorldPosition[2] < node.m_Bounds[4] || m_WorldPosition[2] > node.m_Bounds[5])
+      continue;
 
-    currentTubeId = TubeGraph::TubeDescriptorType(m_TubeGraph->GetVertexDescriptor(soureTargetPair.first),m_TubeGraph->GetVertexDescriptor(soureTargetPair.second));
-    //check if the tube is visible, if not pass this tube. User can not choose a tube, which he can't see
-    if (m_TubeGraphProperty->IsTubeVisible(currentTubeId))
+    if (node.m_NumberOfElements == 0)
     {
-      std::vector<mitk::TubeElement*> allElements = edge->GetElementVector();
-      for(unsigned int index =0; index < edge->GetNumberOfElements(); index++)
+      nodesToVisit.push_back(node.m_RightChild);
+      nodesToVisit.push_back(nodeIndex + 1);
+      continue;
+    }
+
+    for (unsigned int index = node.m_FirstElement; index < node.m_FirstElement + node.m_NumberOfElements; ++index)
+    {
+      const PickableElement& element = m_Elements[index];
+
+      // calculate point->point distance
+      currentDistance = m_WorldPosition.EuclideanDistanceTo( element.m_Position );
+      if ( ( currentDistance - element.m_Radius ) >= PickingTolerance || currentDistance > closestDistance
+        || ( currentDistance == closestDistance && element.m_Order > closestOrder ) )
+        continue;
+
+      //check if the tube is visible, if not pass this tube. User can not choose a tube, which he can't see
+      std::map<TubeGraph::TubeDescriptorType, bool>::iterator itVisible = visibleTubes.find(element.m_Tube);
+      if (itVisible == visibleTubes.end())
       {
-        currentPosition = allElements[index]->GetCoordinates();
-        if (dynamic_cast<mitk::CircularProfileTubeElement* >(allElements[index]))
-          currentRadius = ((dynamic_cast< mitk::CircularProfileTubeElement* >(allElements[index]))->GetDiameter())/2;
-        else
-          currentRadius = 0;
-
-        // calculate point->point distance
-        currentDistance = m_WorldPosition.EuclideanDistanceTo( currentPosition );
-        if ( currentDistance < closestDistance && ( currentDistance - currentRadius ) < 1.0 )
-        {
-          closestDistance = currentDistance;
-          tubeId = currentTubeId;
-          tubeElement = allElements[index];
-        }
+        const bool isVisible = m_TubeGraphProperty.IsNull() || m_TubeGraphProperty->IsTubeVisible(element.m_Tube);
+        itVisible = visibleTubes.insert(std::make_pair(element.m_Tube, isVisible)).first;
       }
+      if (!itVisible->second)
+        continue;
+
+      closestDistance = currentDistance;
+      closestOrder = element.m_Order;
+      tubeId = element.m_Tube;
+      tubeElement = element.m_Element;
     }
   }
   std::pair<mitk::TubeGraph::TubeDescriptorType, mitk::TubeElement*> pickedTubeWithElement(tubeId, tubeElement);
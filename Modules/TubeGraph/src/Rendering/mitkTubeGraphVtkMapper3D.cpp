@@ -37,6 +37,57 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkTubeFilter.h>
 #include <vtkUnsignedIntArray.h>
 
+#include <set>
+
+namespace
+{
+  /**
+  * Appends position and radius of a tube element to a centerline. Elements
+  * without a circular profile keep the diameter of the previous element.
+  */
+  void AppendCenterlinePoint(const mitk::TubeElement* element, float& diameter, std::vector<double>& centerline)
+  {
+    const mitk::CircularProfileTubeElement* circularElement = dynamic_cast<const mitk::CircularProfileTubeElement*>(element);
+    if (circularElement != nullptr)
+      diameter = circularElement->GetDiameter();
+
+    const mitk::Point3D& coordinates = element->GetCoordinates();
+    centerline.push_back(coordinates[0]);
+    centerline.push_back(coordinates[1]);
+    centerline.push_back(coordinates[2]);
+    centerline.push_back(diameter / 2.0f);
+  }
+
+  /**
+  * Sets the poly data clipped with all given functions as input of the actor's mapper.
+  * The clip functions are combined, so the poly data is clipped only once.
+  */
+  void SetClippedInput(vtkActor* actor, vtkPolyData* polyData, const std::vector<vtkImplicitFunction*>& clipFunctions)
+  {
+    vtkPolyDataMapper* mapper = static_cast<vtkPolyDataMapper*>(actor->GetMapper());
+    if (clipFunctions.empty())
+    {
+      mapper->SetInputData(polyData);
+      return;
+    }
+
+    // the clipper keeps everything outside of all truncated cylinders
+    vtkSmartPointer<vtkImplicitBoolean> clipFunction = vtkSmartPointer<vtkImplicitBoolean>::New();
+    clipFunction->SetOperationTypeToUnion();
+    for (std::vector<vtkImplicitFunction*>::const_iterator itFunction = clipFunctions.begin(); itFunction != clipFunctions.end(); ++itFunction)
+    {
+      clipFunction->AddFunction(*itFunction);
+    }
+
+    vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
+    clipper->SetInputData(polyData);
+    clipper->SetClipFunction(clipFunction);
+    clipper->Update();
+
+    mapper->SetInputConnection(clipper->GetOutputPort());
+  }
+}
+
 mitk::TubeGraphVtkMapper3D::TubeGraphVtkMapper3D()
 {
 }
@@ -57,7 +108,6 @@ vtkProp* mitk::TubeGraphVtkMapper3D::GetVtkProp(mitk::BaseRenderer *renderer)
 
 void mitk::TubeGraphVtkMapper3D::GenerateDataForRenderer(mitk::BaseRenderer* renderer)
 {
-  bool renderTubeGraph(false);
   LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
 
 
@@ -70,55 +120,17 @@ void mitk::TubeGraphVtkMapper3D::GenerateDataForRenderer(mitk::BaseRenderer* ren
     itkWarningMacro(<< "Input of tube graph mapper is NULL!");
     return;
   }
-  //Check if the tube graph has changed; if the data has changed, generate the spheres and tubes new;
-  if(tubeGraph->GetMTime() > ls->m_lastGenerateDataTime)
+  //Check if the tube graph has changed; if the data has changed, generate the modified spheres and tubes new;
+  if(tubeGraph->GetMTime() > ls->m_lastGenerateDataTime || this->ClipStructures() != ls->m_StructuresClipped)
   {
     this->GenerateTubeGraphData(renderer);
-    renderTubeGraph = true;
-  }
-  else
-  {
-    //Check if the tube graph property has changed; if the property has changed, render the visualization information new;
-    if (tubeGraphProperty->GetMTime() > ls->m_lastRenderDataTime)
-    {
-      this->RenderTubeGraphPropertyInformation(renderer);
-      renderTubeGraph = true;
-    }
   }
 
-  if (renderTubeGraph)
+  //Check if the tube graph property or the geometry has changed; if so, render the visualization information new;
+  if (tubeGraphProperty->GetMTime() > ls->m_lastRenderDataTime
+    || ls->m_lastGenerateDataTime.GetMTime() > ls->m_lastRenderDataTime.GetMTime())
   {
-    std::vector<TubeGraph::VertexDescriptorType> alreadyRenderedVertexList;
-    //don't render the sphere which is the root of the graph; so add it to the list before;
-    //TODO check both spheres
-    TubeGraph::VertexDescriptorType root = tubeGraph->GetRootVertex();
-    alreadyRenderedVertexList.push_back(root);
-
-
-    for (std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkActor> >::iterator itTubes = ls->m_vtkTubesActorMap.begin(); itTubes != ls->m_vtkTubesActorMap.end(); itTubes++ )
-    {
-      if(tubeGraphProperty->IsTubeVisible(itTubes->first))
-      {
-        //add tube actor to assembly
-        ls->m_vtkTubeGraphAssembly->AddPart(itTubes->second);
-
-        //render the clipped spheres as end-cups of a tube and connections between tubes
-        if(std::find(alreadyRenderedVertexList.begin(), alreadyRenderedVertexList.end(), itTubes->first.first)== alreadyRenderedVertexList.end())
-        {
-          std::map<TubeGraph::VertexDescriptorType, vtkSmartPointer<vtkActor> >::iterator itSourceSphere = ls->m_vtkSpheresActorMap.find(itTubes->first.first);
-          if(itSourceSphere != ls->m_vtkSpheresActorMap.end())
-            ls->m_vtkTubeGraphAssembly->AddPart(itSourceSphere->second);
-          alreadyRenderedVertexList.push_back(itSourceSphere->first);
-        }
-        if(std::find(alreadyRenderedVertexList.begin(), alreadyRenderedVertexList.end(), itTubes->first.second)== alreadyRenderedVertexList.end())
-        {
-          std::map<TubeGraph::VertexDescriptorType, vtkSmartPointer<vtkActor> >::iterator itTargetSphere = ls->m_vtkSpheresActorMap.find(itTubes->first.second);
-          if(itTargetSphere != ls->m_vtkSpheresActorMap.end())
-            ls->m_vtkTubeGraphAssembly->AddPart(itTargetSphere->second);
-          alreadyRenderedVertexList.push_back(itTargetSphere->first);
-        }
-      }
-    }
+    this->RenderTubeGraphPropertyInformation(renderer);
   }
 
   //// Opacity TODO
@@ -142,168 +154,224 @@ void mitk::TubeGraphVtkMapper3D::RenderTubeGraphPropertyInformation(mitk::BaseRe
     return;
   }
 
-  std::vector<TubeGraphVertex> allVertices = tubeGraph->GetVectorOfAllVertices();
-  for(std::vector<TubeGraphVertex>::iterator vertex = allVertices.begin(); vertex != allVertices.end(); ++vertex)
+  //the color of a sphere is the mean color of all visible tubes of the vertex
+  const std::size_t numberOfVertices = boost::num_vertices(tubeGraph->GetGraph());
+  std::vector<double> sphereColors(3 * numberOfVertices, 0.0);
+  std::vector<unsigned int> numberOfVisibleEdges(numberOfVertices, 0);
+
+  //only the actor properties are changed; the tube geometry stays untouched
+  for (std::map<TubeGraph::TubeDescriptorType, TubeBlock>::iterator itTubes = ls->m_TubeBlocks.begin(); itTubes != ls->m_TubeBlocks.end(); ++itTubes)
   {
-    TubeGraph::VertexDescriptorType vertexDesc = tubeGraph->GetVertexDescriptor(*vertex);
+    const TubeGraph::TubeDescriptorType& tube = itTubes->first;
+    const bool isVisible = tubeGraphProperty->IsTubeVisible(tube);
+    itTubes->second.m_Actor->SetVisibility(isVisible);
+    if (!isVisible)
+      continue;
 
-    double sphereColorR = 0;
-    double sphereColorG = 0;
-    double sphereColorB = 0;
+    mitk::Color tubeColor = tubeGraphProperty->GetColorOfTube(tube);
+    itTubes->second.m_Actor->GetProperty()->SetColor(tubeColor[0] / 255.0, tubeColor[1] / 255.0, tubeColor[2] / 255.0);
 
-    int numberOfVisibleEdges = 0;
-    std::vector<TubeGraphEdge> allEdgesOfVertex = tubeGraph->GetAllEdgesOfAVertex(vertexDesc);
-    for(std::vector<TubeGraphEdge>::iterator edge = allEdgesOfVertex.begin(); edge != allEdgesOfVertex.end(); ++edge)
+    VertexDescriptorType vertices[2] = { tube.first, tube.second };
+    for (unsigned int i = 0; i < 2; ++i)
     {
-      // get edge descriptor
-      EdgeDescriptorType edgeDesc = tubeGraph->GetEdgeDescriptor(*edge);
+      if (vertices[i] >= numberOfVertices || (i == 1 && vertices[1] == vertices[0]))
+        continue;
+      sphereColors[3 * vertices[i]] += tubeColor[0];
+      sphereColors[3 * vertices[i] + 1] += tubeColor[1];
+      sphereColors[3 * vertices[i] + 2] += tubeColor[2];
+      ++numberOfVisibleEdges[vertices[i]];
+    }
+  }
 
-      // get source and target vertex descriptor
-      std::pair<TubeGraphVertex, TubeGraphVertex> soureTargetPair = tubeGraph->GetVerticesOfAnEdge(edgeDesc);
-      TubeGraphVertex source = soureTargetPair.first;
-      TubeGraphVertex target = soureTargetPair.second;
+  //don't render the sphere which is the root of the graph
+  //TODO check both spheres
+  const VertexDescriptorType root = tubeGraph->GetRootVertex();
+  for (std::map<TubeGraph::VertexDescriptorType, FurcationBlock>::iterator itSpheres = ls->m_FurcationBlocks.begin(); itSpheres != ls->m_FurcationBlocks.end(); ++itSpheres)
+  {
+    const VertexDescriptorType vertexDesc = itSpheres->first;
+    const bool isVisible = vertexDesc < numberOfVertices && vertexDesc != root && numberOfVisibleEdges[vertexDesc] > 0;
+    itSpheres->second.m_Actor->SetVisibility(isVisible);
+    if (!isVisible)
+      continue;
+
+    const double normalization = 255.0 * numberOfVisibleEdges[vertexDesc];
+    itSpheres->second.m_Actor->GetProperty()->SetColor(sphereColors[3 * vertexDesc] / normalization,
+                                                       sphereColors[3 * vertexDesc + 1] / normalization,
+                                                       sphereColors[3 * vertexDesc + 2] / normalization);
+  }
+  ls->m_lastRenderDataTime.Modified();
+}
 
-      // build tube descriptor [sourceId,targetId]
-      TubeGraph::TubeDescriptorType tube;
-      tube.first = tubeGraph->GetVertexDescriptor(source);
-      tube.second = tubeGraph->GetVertexDescriptor(target);
+void mitk::TubeGraphVtkMapper3D::GenerateTubeGraphData(mitk::BaseRenderer* renderer)
+{
+  LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
 
-      if(tubeGraphProperty->IsTubeVisible(tube))
-      {
-        mitk::Color tubeColor = tubeGraphProperty->GetColorOfTube(tube);
+  TubeGraph::Pointer tubeGraph = const_cast<mitk::TubeGraph*>(this->GetInput());
+  const TubeGraph::GraphType& graph = tubeGraph->GetGraph();
 
-        vtkSmartPointer<vtkDataArray> scalars = ls->m_vtkTubesActorMap[tube]->GetMapper()->GetInput()->GetPointData()->GetScalars();
-        double color[3];
-        scalars->GetTuple(0, color);
+  const bool clipStructures = this->ClipStructures();
+  const bool clippingChanged = clipStructures != ls->m_StructuresClipped;
 
-        if (color[0] != tubeColor[0] || color[1] != tubeColor[1] || color[2] != tubeColor[2])
-        {
-          int numberOfPoints = scalars->GetSize();
+  std::set<VertexDescriptorType> modifiedVertices;
+  std::set<TubeGraph::TubeDescriptorType> modifiedTubes;
 
-          vtkSmartPointer<vtkUnsignedCharArray> colorScalars = vtkSmartPointer<vtkUnsignedCharArray>::New();
-          colorScalars->SetName("colorScalars");
-          colorScalars->SetNumberOfComponents(3);
-          colorScalars->SetNumberOfTuples(numberOfPoints);
-          for (int i = 0; i < numberOfPoints; i++)
-          {
-            scalars->InsertTuple3(i, tubeColor[0], tubeColor[1], tubeColor[2]);
-          }
-          ls->m_vtkTubesActorMap[tube]->GetMapper()->GetInput()->GetPointData()->SetActiveScalars( "colorScalars" );
-        }
+  //Generate all vertices as spheres; only new spheres and spheres with another position or diameter are generated
+  const VertexDescriptorType numberOfVertices = boost::num_vertices(graph);
+  for (VertexDescriptorType vertexDesc = 0; vertexDesc < numberOfVertices; ++vertexDesc)
+  {
+    std::vector<double> sphere;
+    float diameter = 2;
+    AppendCenterlinePoint(tubeGraph->GetVertex(vertexDesc).GetTubeElement(), diameter, sphere);
 
-        sphereColorR += tubeColor[0];
-        sphereColorG += tubeColor[1];
-        sphereColorB += tubeColor[2];
-        numberOfVisibleEdges++;
-      }
+    FurcationBlock& block = ls->m_FurcationBlocks[vertexDesc];
+    if (block.m_Actor == nullptr || block.m_Sphere != sphere)
+    {
+      block.m_Sphere.swap(sphere);
+      this->GeneratePolyDataForFurcation(block, renderer);
+      modifiedVertices.insert(vertexDesc);
     }
-    if(numberOfVisibleEdges > 0)
+    else if (clippingChanged)
     {
-      sphereColorR /= 255 * numberOfVisibleEdges;
-      sphereColorG /= 255 * numberOfVisibleEdges;
-      sphereColorB /= 255 * numberOfVisibleEdges;
+      modifiedVertices.insert(vertexDesc);
     }
-
-    ls->m_vtkSpheresActorMap[vertexDesc]->GetProperty()->SetColor(sphereColorR,sphereColorG, sphereColorB);
   }
-  ls->m_lastRenderDataTime.Modified();
-}
 
-void mitk::TubeGraphVtkMapper3D::GenerateTubeGraphData(mitk::BaseRenderer* renderer)
-{
-  MITK_INFO<< "Render tube graph!";
-  LocalStorage *ls = m_LSH.GetLocalStorage(renderer);
+  //vertex descriptors are indices, so the spheres of removed vertices are at the end
+  std::map<TubeGraph::VertexDescriptorType, FurcationBlock>::iterator firstRemovedSphere = ls->m_FurcationBlocks.lower_bound(numberOfVertices);
+  for (std::map<TubeGraph::VertexDescriptorType, FurcationBlock>::iterator itSpheres = firstRemovedSphere; itSpheres != ls->m_FurcationBlocks.end(); ++itSpheres)
+  {
+    ls->m_vtkTubeGraphAssembly->RemovePart(itSpheres->second.m_Actor);
+  }
+  ls->m_FurcationBlocks.erase(firstRemovedSphere, ls->m_FurcationBlocks.end());
 
-  ls->m_vtkTubesActorMap.clear();
-  ls->m_vtkSpheresActorMap.clear();
+  //render all edges as tubular structures using the vtkTubeFilter; only tubes with another centerline are generated
+  std::vector< std::vector<EdgeDescriptorType> > edgesOfVertices(numberOfVertices);
+  std::set<TubeGraph::TubeDescriptorType> currentTubes;
+  TubeGraph::EdgeIteratorType itEdges, edgesEnd;
+  for (boost::tie(itEdges, edgesEnd) = boost::edges(graph); itEdges != edgesEnd; ++itEdges)
+  {
+    // build tube descriptor [sourceId,targetId]
+    TubeGraph::TubeDescriptorType tube(boost::source(*itEdges, graph), boost::target(*itEdges, graph));
+    currentTubes.insert(tube);
+    edgesOfVertices[tube.first].push_back(*itEdges);
+    if (tube.second != tube.first)
+      edgesOfVertices[tube.second].push_back(*itEdges);
+
+    // the source node, the elements along the edge and the target node
+    std::vector<double> centerline;
+    float diameter = 2;
+    TubeGraphEdge edge = tubeGraph->GetEdge(*itEdges);
+    centerline.reserve(4 * (edge.GetNumberOfElements() + 2));
+    AppendCenterlinePoint(tubeGraph->GetVertex(tube.first).GetTubeElement(), diameter, centerline);
+    for (unsigned int index = 0; index < edge.GetNumberOfElements(); ++index)
+    {
+      AppendCenterlinePoint(edge.GetTubeElement(index), diameter, centerline);
+    }
+    AppendCenterlinePoint(tubeGraph->GetVertex(tube.second).GetTubeElement(), diameter, centerline);
 
-  TubeGraph::Pointer tubeGraph = const_cast<mitk::TubeGraph*>(this->GetInput());
-  TubeGraphProperty::Pointer tubeGraphProperty = dynamic_cast<TubeGraphProperty*>(tubeGraph->GetProperty("Tube Graph.Visualization Information").GetPointer());
-  if (tubeGraphProperty.IsNull())
-    MITK_INFO << "No tube graph property!! So no special render information...";
+    TubeBlock& block = ls->m_TubeBlocks[tube];
+    if (block.m_Actor == nullptr || block.m_Centerline != centerline)
+    {
+      block.m_Centerline.swap(centerline);
+      this->GeneratePolyDataForTube(block, renderer);
+      modifiedTubes.insert(tube);
+      modifiedVertices.insert(tube.first);
+      modifiedVertices.insert(tube.second);
+    }
+  }
 
-  //render all edges as tubular structures using the vtkTubeFilter
-  std::vector<TubeGraphEdge> allEdges = tubeGraph->GetVectorOfAllEdges();
-  for(std::vector<TubeGraphEdge>::iterator edge = allEdges.begin(); edge != allEdges.end(); ++edge)
+  //remove the tubes of removed edges; the furcations of these tubes have to be clipped new
+  for (std::map<TubeGraph::TubeDescriptorType, TubeBlock>::iterator itTubes = ls->m_TubeBlocks.begin(); itTubes != ls->m_TubeBlocks.end();)
   {
-    this->GeneratePolyDataForTube(*edge, tubeGraph, tubeGraphProperty, renderer);
+    if (currentTubes.find(itTubes->first) == currentTubes.end())
+    {
+      ls->m_vtkTubeGraphAssembly->RemovePart(itTubes->second.m_Actor);
+      modifiedVertices.insert(itTubes->first.first);
+      modifiedVertices.insert(itTubes->first.second);
+      itTubes = ls->m_TubeBlocks.erase(itTubes);
+    }
+    else
+    {
+      ++itTubes;
+    }
   }
 
-  //Generate all vertices as spheres
-  std::vector<TubeGraphVertex> allVertices = tubeGraph->GetVectorOfAllVertices();
-  for(std::vector<TubeGraphVertex>::iterator vertex = allVertices.begin(); vertex != allVertices.end(); ++vertex)
+  if (clipStructures)
   {
-    this->GeneratePolyDataForFurcation(*vertex, tubeGraph, renderer);
-    if (this->ClipStructures())
+    //the cylinders of a furcation depend on all tubes of the vertex, so all these tubes have to be clipped new
+    std::set<TubeGraph::TubeDescriptorType> tubesToClip(modifiedTubes);
+    for (std::set<VertexDescriptorType>::iterator itVertex = modifiedVertices.begin(); itVertex != modifiedVertices.end(); ++itVertex)
     {
-      this->ClipPolyData(*vertex, tubeGraph, tubeGraphProperty, renderer);
+      if (*itVertex >= numberOfVertices)
+        continue;
+
+      this->GenerateClipFunctions(*itVertex, edgesOfVertices[*itVertex], ls->m_FurcationBlocks[*itVertex], tubeGraph);
+      for (std::vector<EdgeDescriptorType>::iterator itEdge = edgesOfVertices[*itVertex].begin(); itEdge != edgesOfVertices[*itVertex].end(); ++itEdge)
+      {
+        tubesToClip.insert(TubeGraph::TubeDescriptorType(boost::source(*itEdge, graph), boost::target(*itEdge, graph)));
+      }
     }
 
-    ls->m_lastGenerateDataTime.Modified();
+    for (std::set<TubeGraph::TubeDescriptorType>::iterator itTube = tubesToClip.begin(); itTube != tubesToClip.end(); ++itTube)
+    {
+      this->ClipTube(*itTube, ls->m_TubeBlocks[*itTube], renderer);
+    }
+    for (std::set<VertexDescriptorType>::iterator itVertex = modifiedVertices.begin(); itVertex != modifiedVertices.end(); ++itVertex)
+    {
+      if (*itVertex < numberOfVertices)
+        this->ClipFurcation(ls->m_FurcationBlocks[*itVertex]);
+    }
   }
+  else if (clippingChanged)
+  {
+    //show all structures unclipped again
+    for (std::map<TubeGraph::TubeDescriptorType, TubeBlock>::iterator itTubes = ls->m_TubeBlocks.begin(); itTubes != ls->m_TubeBlocks.end(); ++itTubes)
+    {
+      SetClippedInput(itTubes->second.m_Actor, itTubes->second.m_Tube, std::vector<vtkImplicitFunction*>());
+    }
+    for (std::map<TubeGraph::VertexDescriptorType, FurcationBlock>::iterator itSpheres = ls->m_FurcationBlocks.begin(); itSpheres != ls->m_FurcationBlocks.end(); ++itSpheres)
+    {
+      itSpheres->second.m_ClipFunctions.clear();
+      SetClippedInput(itSpheres->second.m_Actor, itSpheres->second.m_SpherePolyData, std::vector<vtkImplicitFunction*>());
+    }
+  }
+
+  MITK_DEBUG << "Generated " << modifiedTubes.size() << " of " << ls->m_TubeBlocks.size() << " tubes new.";
+
+  ls->m_StructuresClipped = clipStructures;
+  ls->m_lastGenerateDataTime.Modified();
 }
 
-void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForFurcation(mitk::TubeGraphVertex& vertex, const mitk::TubeGraph::Pointer& graph, mitk::BaseRenderer* renderer)
+void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForFurcation(FurcationBlock& block, mitk::BaseRenderer* renderer)
 {
   LocalStorage *ls = this->m_LSH.GetLocalStorage(renderer);
 
-  mitk::Point3D coordinates;
-  float diameter = 2;
-
-  coordinates = (vertex.GetTubeElement())->GetCoordinates();
-  if (dynamic_cast<const mitk::CircularProfileTubeElement* >(vertex.GetTubeElement()))
-  {
-    diameter = (dynamic_cast<const mitk::CircularProfileTubeElement* >(vertex.GetTubeElement()))->GetDiameter();
-  }
   vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-  sphereSource->SetCenter(coordinates[0], coordinates[1], coordinates[2]);
-  sphereSource->SetRadius(diameter / 2.0f);
+  sphereSource->SetCenter(block.m_Sphere[0], block.m_Sphere[1], block.m_Sphere[2]);
+  sphereSource->SetRadius(block.m_Sphere[3]);
   sphereSource->SetThetaResolution(12);
   sphereSource->SetPhiResolution(12);
   sphereSource->Update();
+  block.m_SpherePolyData = sphereSource->GetOutput();
 
-  // generate a actor with a mapper for the sphere
-  vtkSmartPointer<vtkPolyDataMapper> sphereMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  vtkSmartPointer<vtkActor> sphereActor = vtkSmartPointer<vtkActor>::New();
-
-  sphereMapper->SetInputConnection(sphereSource->GetOutputPort());
-  sphereActor->SetMapper(sphereMapper);
-
-  ls->m_vtkSpheresActorMap.insert(std::make_pair(graph->GetVertexDescriptor(vertex), sphereActor));
+  // generate a actor with a mapper for the sphere; the actor is reused, if the sphere is generated new
+  if (block.m_Actor == nullptr)
+  {
+    vtkSmartPointer<vtkPolyDataMapper> sphereMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    block.m_Actor = vtkSmartPointer<vtkActor>::New();
+    block.m_Actor->SetMapper(sphereMapper);
+    ls->m_vtkTubeGraphAssembly->AddPart(block.m_Actor);
+  }
+  block.m_ClipFunctions.clear();
+  SetClippedInput(block.m_Actor, block.m_SpherePolyData, std::vector<vtkImplicitFunction*>());
 }
 
-void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForTube(mitk::TubeGraphEdge& edge, const mitk::TubeGraph::Pointer& graph, const mitk::TubeGraphProperty::Pointer& graphProperty, mitk::BaseRenderer* renderer)
+void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForTube(TubeBlock& block, mitk::BaseRenderer* renderer)
 {
   LocalStorage *ls = this->m_LSH.GetLocalStorage(renderer);
 
-  // get edge descriptor
-  EdgeDescriptorType edgeDesc = graph->GetEdgeDescriptor(edge);
-
-  // get source and target vertex descriptor
-  std::pair<TubeGraphVertex, TubeGraphVertex> soureTargetPair = graph->GetVerticesOfAnEdge(edgeDesc);
-  TubeGraphVertex source = soureTargetPair.first;
-  TubeGraphVertex target = soureTargetPair.second;
-
-  // build tube descriptor [sourceId,targetId]
-  TubeGraph::TubeDescriptorType tube;
-  tube.first = graph->GetVertexDescriptor(source);
-  tube.second = graph->GetVertexDescriptor(target);
-
-
-  Color color;
-  if(graphProperty.IsNotNull())
-  {
-    color = graphProperty->GetColorOfTube(tube);
-  }
-  else
-  {
-    color[0] = 150;
-    color[1] = 150;
-    color[2] = 150;
-  }
-
-  // add 2 points for the source and target vertices.
-  unsigned int numberOfPoints = edge.GetNumberOfElements() + 2;
+  const std::vector<double>& centerline = block.m_Centerline;
+  const vtkIdType numberOfPoints = centerline.size() / 4;
 
   // Initialize the required data-structures for building
   // an appropriate input to the tube filter
@@ -313,65 +381,20 @@ void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForTube(mitk::TubeGraphEdge& ed
   vtkSmartPointer<vtkFloatArray> radii = vtkSmartPointer<vtkFloatArray>::New();
   radii->SetName("radii");
   radii->SetNumberOfComponents(1);
+  radii->SetNumberOfTuples(numberOfPoints);
 
   vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
-
-  vtkSmartPointer<vtkUnsignedCharArray> colorScalars = vtkSmartPointer<vtkUnsignedCharArray>::New();
-  colorScalars->SetName("colorScalars");
-  colorScalars->SetNumberOfComponents(3);
-
-  // resize the data-arrays
-  radii->SetNumberOfTuples(numberOfPoints);
-  colorScalars->SetNumberOfTuples(numberOfPoints);
   lines->InsertNextCell(numberOfPoints);
 
   // Add the positions of the source node, the elements along the edge and
   // the target node as lines to a cell. This cell is used as input
   // for a Tube Filter
-  mitk::Point3D coordinates;
-  float diameter = 2;
-  unsigned int id = 0;
-
-  //Source Node
-  coordinates = (source.GetTubeElement())->GetCoordinates();
-  if (dynamic_cast<const mitk::CircularProfileTubeElement* >(source.GetTubeElement()))
-  {
-    diameter = (dynamic_cast<const mitk::CircularProfileTubeElement* >(source.GetTubeElement()))->GetDiameter();
-  }
-  points->InsertPoint(id, coordinates[0], coordinates[1], coordinates[2]);
-  radii->InsertTuple1(id, diameter / 2.0f);
-
-  colorScalars->InsertTuple3(id, color[0], color[1], color[2]);
-  lines->InsertCellPoint(id);
-  ++id;
-
-  //Iterate along the edge
-  std::vector<mitk::TubeElement*> allElements = edge.GetElementVector();
-  for(unsigned int index =0; index < edge.GetNumberOfElements(); index++)
+  for (vtkIdType id = 0; id < numberOfPoints; ++id)
   {
-    coordinates = allElements[index]->GetCoordinates();
-    if (dynamic_cast<mitk::CircularProfileTubeElement* >(allElements[index]))
-    {
-      diameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(allElements[index]))->GetDiameter();
-    }
-    points->InsertPoint(id, coordinates[0], coordinates[1], coordinates[2]);
-    radii->InsertTuple1(id, diameter / 2.0f);
-    colorScalars->InsertTuple3(id, color[0], color[1], color[2]);
+    points->SetPoint(id, centerline[4 * id], centerline[4 * id + 1], centerline[4 * id + 2]);
+    radii->SetTuple1(id, centerline[4 * id + 3]);
     lines->InsertCellPoint(id);
-    ++id;
-  }
-
-  //Target Node
-  coordinates = (target.GetTubeElement())->GetCoordinates();
-  if (dynamic_cast<const mitk::CircularProfileTubeElement* >(target.GetTubeElement()))
-  {
-    diameter = (dynamic_cast<const mitk::CircularProfileTubeElement* >(target.GetTubeElement()))->GetDiameter();
   }
-  points->InsertPoint(id, coordinates[0], coordinates[1], coordinates[2]);
-  radii->InsertTuple1(id, diameter / 2.0f);
-  colorScalars->InsertTuple3(id, color[0], color[1], color[2]);
-  lines->InsertCellPoint(id);
-  ++id;
 
   // Initialize poly data from the point set and the cell array
   // (representing topology)
@@ -379,7 +402,6 @@ void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForTube(mitk::TubeGraphEdge& ed
   polyData->SetPoints( points );
   polyData->SetLines( lines );
   polyData->GetPointData()->AddArray( radii );
-  polyData->GetPointData()->AddArray( colorScalars );
   polyData->GetPointData()->SetActiveScalars( radii->GetName() );
 
   // Generate a tube  for all lines in the polydata object
@@ -399,51 +421,73 @@ void mitk::TubeGraphVtkMapper3D::GeneratePolyDataForTube(mitk::TubeGraphEdge& ed
   tubeFilter->SidesShareVerticesOn( );
   tubeFilter->CappingOff();
   tubeFilter->Update();
+  block.m_Tube = tubeFilter->GetOutput();
 
-  tubeFilter->GetOutput()->GetPointData()->SetActiveScalars( "colorScalars" );
+  // generate a actor with a mapper for the tube; the color is set as actor property,
+  // so changing it does not touch the geometry
+  if (block.m_Actor == nullptr)
+  {
+    vtkSmartPointer<vtkPolyDataMapper> tubeMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    tubeMapper->ScalarVisibilityOff();
+    block.m_Actor = vtkSmartPointer<vtkActor>::New();
+    block.m_Actor->SetMapper(tubeMapper);
+    ls->m_vtkTubeGraphAssembly->AddPart(block.m_Actor);
+  }
+  SetClippedInput(block.m_Actor, block.m_Tube, std::vector<vtkImplicitFunction*>());
+}
 
-  // generate a actor with a mapper for the
-  vtkSmartPointer<vtkPolyDataMapper> tubeMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  vtkSmartPointer<vtkActor> tubeActor = vtkSmartPointer<vtkActor>::New();
+void mitk::TubeGraphVtkMapper3D::ClipTube(const TubeGraph::TubeDescriptorType& tube, TubeBlock& block, mitk::BaseRenderer* renderer)
+{
+  LocalStorage *ls = this->m_LSH.GetLocalStorage(renderer);
 
-  tubeMapper->SetInputConnection(tubeFilter->GetOutputPort());
-  tubeActor->SetMapper(tubeMapper);
-  tubeActor->GetProperty()->SetColor(color[0], color[1], color[2]);
+  //clip with the cylinders of all other tubes at the source and the target vertex
+  std::vector<vtkImplicitFunction*> clipFunctions;
+  VertexDescriptorType vertices[2] = { tube.first, tube.second };
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    if (i == 1 && vertices[1] == vertices[0])
+      continue;
 
-  ls->m_vtkTubesActorMap.insert(std::pair<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkActor> >(tube, tubeActor) );
+    std::map<TubeGraph::VertexDescriptorType, FurcationBlock>::iterator itSphere = ls->m_FurcationBlocks.find(vertices[i]);
+    if (itSphere == ls->m_FurcationBlocks.end())
+      continue;
+
+    std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkImplicitFunction> >& cylinders = itSphere->second.m_ClipFunctions;
+    for (std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkImplicitFunction> >::iterator itCylinder = cylinders.begin(); itCylinder != cylinders.end(); ++itCylinder)
+    {
+      if (itCylinder->first != tube)
+        clipFunctions.push_back(itCylinder->second);
+    }
+  }
+  SetClippedInput(block.m_Actor, block.m_Tube, clipFunctions);
 }
 
-void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, const mitk::TubeGraph::Pointer& graph,const mitk::TubeGraphProperty::Pointer& graphProperty, mitk::BaseRenderer* renderer)
+void mitk::TubeGraphVtkMapper3D::ClipFurcation(FurcationBlock& block)
 {
-  LocalStorage *ls = this->m_LSH.GetLocalStorage(renderer);
-
-  mitk::Point3D centerVertex = vertex.GetTubeElement()->GetCoordinates();
-  float diameter = 2;
-  if (dynamic_cast<const mitk::CircularProfileTubeElement* >(vertex.GetTubeElement()))
+  std::vector<vtkImplicitFunction*> clipFunctions;
+  for (std::map<TubeGraph::TubeDescriptorType, vtkSmartPointer<vtkImplicitFunction> >::iterator itCylinder = block.m_ClipFunctions.begin(); itCylinder != block.m_ClipFunctions.end(); ++itCylinder)
   {
-    diameter = (dynamic_cast<const mitk::CircularProfileTubeElement* >(vertex.GetTubeElement()))->GetDiameter();
+    clipFunctions.push_back(itCylinder->second);
   }
+  SetClippedInput(block.m_Actor, block.m_SpherePolyData, clipFunctions);
+}
 
-  TubeGraph::VertexDescriptorType vertexDesc = graph->GetVertexDescriptor(vertex);
+void mitk::TubeGraphVtkMapper3D::GenerateClipFunctions(VertexDescriptorType vertexDesc, const std::vector<EdgeDescriptorType>& edgesOfVertex, FurcationBlock& block, const mitk::TubeGraph::Pointer& graph)
+{
+  const TubeGraph::GraphType& boostGraph = graph->GetGraph();
+
+  mitk::Point3D centerVertex;
+  mitk::FillVector3D(centerVertex, block.m_Sphere[0], block.m_Sphere[1], block.m_Sphere[2]);
+  const float diameter = 2 * block.m_Sphere[3];
 
-  std::map<TubeGraph::TubeDescriptorType , vtkSmartPointer<vtkImplicitBoolean> > cylinderForClipping;
+  block.m_ClipFunctions.clear();
 
   //generate for all edges/tubes cylinders. With this structure you can clip the sphere and the other tubes, so that no fragments are shown in the tube.
-  std::vector<TubeGraphEdge> allEdgesOfVertex = graph->GetAllEdgesOfAVertex(vertexDesc);
-  for(std::vector<TubeGraphEdge>::iterator edge = allEdgesOfVertex.begin(); edge != allEdgesOfVertex.end(); ++edge)
+  for(std::vector<EdgeDescriptorType>::const_iterator itEdge = edgesOfVertex.begin(); itEdge != edgesOfVertex.end(); ++itEdge)
   {
-    // get edge descriptor
-    EdgeDescriptorType edgeDesc = graph->GetEdgeDescriptor(*edge);
-
-    // get source and target vertex descriptor
-    std::pair<TubeGraphVertex, TubeGraphVertex> soureTargetPair = graph->GetVerticesOfAnEdge(edgeDesc);
-    TubeGraphVertex source = soureTargetPair.first;
-    TubeGraphVertex target = soureTargetPair.second;
-
     // build tube descriptor [sourceId,targetId]
-    TubeGraph::TubeDescriptorType tube;
-    tube.first = graph->GetVertexDescriptor(source);
-    tube.second = graph->GetVertexDescriptor(target);
+    TubeGraph::TubeDescriptorType tube(boost::source(*itEdge, boostGraph), boost::target(*itEdge, boostGraph));
+    TubeGraphEdge edge = graph->GetEdge(*itEdge);
 
     //get reference point in the tube for the direction
     mitk::Point3D edgeDirectionPoint;
@@ -451,25 +495,25 @@ void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, con
     double cylinderDiameter = diameter;
     float radius = diameter/2;
     //if the vertex is the source vertex of the edge get the first element of elementVector; otherwise get the last element.
-    if(source == vertex)
+    if(tube.first == vertexDesc)
     {
       //if the edge has no element get the other vertex
-      if ((*edge).GetNumberOfElements() != 0)
+      if (edge.GetNumberOfElements() != 0)
       {
         double lastDistance = 0, distance = 0;
 
         unsigned int index = 0;
         //Get the first element behind the radius of the sphere
-        for (; index < (*edge).GetNumberOfElements(); index ++)
+        for (; index < edge.GetNumberOfElements(); index ++)
         {
-          mitk::Vector3D diffVec = (*edge).GetTubeElement(index)->GetCoordinates() - centerVertex;
+          mitk::Vector3D diffVec = edge.GetTubeElement(index)->GetCoordinates() - centerVertex;
           distance = std::sqrt(pow(diffVec[0],2) + pow(diffVec[1],2) + pow(diffVec[2],2));
           if (distance > radius)
             break;
           lastDistance = distance;
         }
         //if the last element is not inside the sphere
-        if(index < (*edge).GetNumberOfElements())
+        if(index < edge.GetNumberOfElements())
         {
           double withinSphereDiameter = diameter, outsideSphereDiameter = diameter, interpolationValue = 0.5;
 
@@ -477,27 +521,27 @@ void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, con
           //if first element is outside of the sphere use sphere diameter and the element diameter for interpolation
           if(index == 0)
           {
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(0)))
-              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(0)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(0)))
+              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(0)))->GetDiameter();
           }
           else
           {
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index-1)))
-              withinSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index-1)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index-1)))
+              withinSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index-1)))->GetDiameter();
 
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index)))
-              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index)))
+              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index)))->GetDiameter();
           }
           // interpolate the diameter for clipping
           cylinderDiameter = (1 - interpolationValue) * withinSphereDiameter + interpolationValue * outsideSphereDiameter;
         }
         //Get the reference point, so the direction of the tube can be calculated
-        edgeDirectionPoint = (*edge).GetTubeElement(0)->GetCoordinates();
+        edgeDirectionPoint = edge.GetTubeElement(0)->GetCoordinates();
       }
       else
       {
         //Get the reference point, so the direction of the tube can be calculated
-        edgeDirectionPoint = target.GetTubeElement()->GetCoordinates();
+        edgeDirectionPoint = graph->GetVertex(tube.second).GetTubeElement()->GetCoordinates();
       }
     }
 
@@ -505,14 +549,14 @@ void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, con
     else
     {
       //if the edge has no element, get the other vertex
-      if ((*edge).GetNumberOfElements() != 0)
+      if (edge.GetNumberOfElements() != 0)
       {
         double lastDistance = 0, distance = 0;
         //Get the first element behind the radius of the sphere; now backwards through the element list
-        unsigned int index = (*edge).GetNumberOfElements()-1;
+        int index = edge.GetNumberOfElements()-1;
         for (; index >= 0; index --)
         {
-          mitk::Vector3D diffVec = (*edge).GetTubeElement(index)->GetCoordinates() - centerVertex;
+          mitk::Vector3D diffVec = edge.GetTubeElement(index)->GetCoordinates() - centerVertex;
           distance = std::sqrt(pow(diffVec[0],2) + pow(diffVec[1],2) + pow(diffVec[2],2));
           if (distance > radius)
             break;
@@ -525,30 +569,30 @@ void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, con
 
           interpolationValue = (radius-lastDistance) / (distance-lastDistance);
 
-          if(index == (*edge).GetNumberOfElements()-1)
+          if(index == static_cast<int>(edge.GetNumberOfElements())-1)
           {
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement((*edge).GetNumberOfElements()-1)))
-              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement((*edge).GetNumberOfElements()-1)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(edge.GetNumberOfElements()-1)))
+              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(edge.GetNumberOfElements()-1)))->GetDiameter();
           }
           else
           {
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index+1)))
-              withinSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index+1)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index+1)))
+              withinSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index+1)))->GetDiameter();
 
-            if (dynamic_cast<mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index)))
-              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >((*edge).GetTubeElement(index)))->GetDiameter();
+            if (dynamic_cast<mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index)))
+              outsideSphereDiameter = (dynamic_cast< mitk::CircularProfileTubeElement* >(edge.GetTubeElement(index)))->GetDiameter();
           }
           // interpolate the diameter for clipping
           cylinderDiameter = (1 - interpolationValue) * withinSphereDiameter + interpolationValue * outsideSphereDiameter;
         }
 
         //Get the reference point, so the direction of the tube can be calculated
-        edgeDirectionPoint = (*edge).GetTubeElement((*edge).GetNumberOfElements()-1)->GetCoordinates();
+        edgeDirectionPoint = edge.GetTubeElement(edge.GetNumberOfElements()-1)->GetCoordinates();
       }
       else
       {
         //Get the reference point, so the direction of the tube can be calculated
-        edgeDirectionPoint = source.GetTubeElement()->GetCoordinates();
+        edgeDirectionPoint = graph->GetVertex(tube.first).GetTubeElement()->GetCoordinates();
       }
     }
 
@@ -616,92 +660,8 @@ void mitk::TubeGraphVtkMapper3D::ClipPolyData(mitk::TubeGraphVertex& vertex, con
     cutCylinder->AddFunction(cylinder);
     cutCylinder->AddFunction(plane);
 
-
-    cylinderForClipping.insert(std::pair<TubeGraph::TubeDescriptorType , vtkSmartPointer<vtkImplicitBoolean> >(tube , cutCylinder));
-
-    //// Sample the function
-    //vtkSmartPointer<vtkSampleFunction> sample = vtkSmartPointer<vtkSampleFunction>::New();
-    //sample->SetSampleDimensions(100,100,100);
-    //sample->SetImplicitFunction(cutCylinder);
-    ////double value = 200.0;
-    //double xmin = centerVertex[0]-(2*diameter), xmax = centerVertex[0]+(2*diameter),
-    //  ymin =  centerVertex[1]-(2*diameter), ymax = centerVertex[1]+(2*diameter),
-    //  zmin =  centerVertex[2]-(2*diameter), zmax = centerVertex[2]+(2*diameter);
-    //sample->SetModelBounds(xmin, xmax, ymin, ymax, zmin, zmax);
-
-    //vtkSmartPointer<vtkContourFilter> contour =vtkSmartPointer<vtkContourFilter>::New();
-    //contour->SetInputConnection(sample->GetOutputPort());
-    //contour->SetValue( 0, 0.25);
-
-    //vtkSmartPointer<vtkPolyDataMapper> impMapper =  vtkSmartPointer<vtkPolyDataMapper>::New();
-    //impMapper->SetInputConnection (contour->GetOutputPort());
-    //impMapper->ScalarVisibilityOff();
-    //vtkSmartPointer<vtkActor> impActor = vtkSmartPointer<vtkActor>::New();
-    //impActor->SetMapper(impMapper);
-
-    //ls->m_vtkTubeGraphAssembly->AddPart(impActor);
-  }
-
-  double sphereColorR = 0;
-  double sphereColorG = 0;
-  double sphereColorB = 0;
-
-  for (std::map<TubeGraph::TubeDescriptorType ,vtkSmartPointer<vtkImplicitBoolean> >::iterator itClipStructure = cylinderForClipping.begin(); itClipStructure != cylinderForClipping.end(); itClipStructure++)
-  {
-    vtkSmartPointer<vtkPolyDataMapper> sphereMapper = dynamic_cast<vtkPolyDataMapper*>(ls->m_vtkSpheresActorMap[vertexDesc]->GetMapper());
-
-    if(sphereMapper != NULL)
-    {
-      //first clip the sphere with the cylinder
-      vtkSmartPointer<vtkClipPolyData> clipperSphere = vtkSmartPointer<vtkClipPolyData>::New();
-      clipperSphere->SetInputData(sphereMapper->GetInput());
-      clipperSphere->SetClipFunction(itClipStructure->second);
-      clipperSphere->GenerateClippedOutputOn();
-      clipperSphere->Update();
-
-      sphereMapper->SetInputConnection(clipperSphere->GetOutputPort()) ;
-      sphereMapper->Update();
-    }
-
-    mitk::Color tubeColor = graphProperty->GetColorOfTube(itClipStructure->first);
-    sphereColorR += tubeColor[0];
-    sphereColorG += tubeColor[1];
-    sphereColorB += tubeColor[2];
-
-    //than clip with all other tubes
-    for (std::map<TubeGraph::TubeDescriptorType , vtkSmartPointer<vtkImplicitBoolean> >::iterator itTobBeClipped = cylinderForClipping.begin(); itTobBeClipped != cylinderForClipping.end(); itTobBeClipped++)
-    {
-      TubeGraph::TubeDescriptorType toBeClippedTube = itTobBeClipped->first;
-
-      if (itClipStructure->first != toBeClippedTube)
-      {
-
-        vtkSmartPointer<vtkPolyDataMapper> tubeMapper = dynamic_cast<vtkPolyDataMapper*>(ls->m_vtkTubesActorMap[toBeClippedTube]->GetMapper());
-
-        if (tubeMapper != NULL)
-        {
-          //first clip the sphere with the cylinder
-          vtkSmartPointer<vtkClipPolyData> clipperTube = vtkSmartPointer<vtkClipPolyData>::New();
-          tubeMapper->Update();
-          clipperTube->SetInputData(tubeMapper->GetInput());
-          clipperTube->SetClipFunction(itClipStructure->second);
-          clipperTube->GenerateClippedOutputOn();
-          clipperTube->Update();
-
-          tubeMapper->SetInputConnection(clipperTube->GetOutputPort()) ;
-          tubeMapper->Update();
-        }
-      }
-    }
+    block.m_ClipFunctions[tube] = cutCylinder;
   }
-  if(cylinderForClipping.size() != 0)
-  {
-    sphereColorR /= 255 * cylinderForClipping.size();
-    sphereColorG /= 255 * cylinderForClipping.size();
-    sphereColorB /= 255 * cylinderForClipping.size();
-  }
-
-  ls->m_vtkSpheresActorMap[vertexDesc]->GetProperty()->SetColor(sphereColorR,sphereColorG, sphereColorB);
 }
 
 bool mitk::TubeGraphVtkMapper3D::ClipStructures()
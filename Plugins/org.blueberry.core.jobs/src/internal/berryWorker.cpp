@@ -38,6 +38,8 @@ Worker::JobRunnable::JobRunnable(Worker* currentWorker) :
 
 void Worker::JobRunnable::run()
 {
+  // the pool may drop an idle worker before its thread has returned
+  Worker::Pointer sptr_keepAlive(ptr_currentWorker);
   ptr_currentWorker->setPriority(PRIO_NORMAL);
   try
   {
@@ -22,15 +22,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <Poco/Timestamp.h>
 #include <Poco/Timespan.h>
 
-#include <math.h>
+#include <algorithm>
 
 namespace berry
 {
 
 WorkerPool::WorkerPool(JobManager* myJobManager) :
-  m_ptrManager(myJobManager), m_numThreads(0), m_sleepingThreads(0), m_threads(
-      10), m_busyThreads(0)
-// m_isDaemon(false),
+  m_ptrManager(myJobManager), m_numThreads(0), m_sleepingThreads(0),
+  m_searchingThreads(0), m_pendingWakeUps(0), m_busyThreads(0)
 {
 }
 
@@ -41,16 +40,14 @@ const int WorkerPool::MIN_THREADS = 1;
 void WorkerPool::Shutdown()
 {
   Poco::ScopedLock<Poco::Mutex> LockMe(m_mutexOne);
-  for(int i = 0; i<= m_numThreads; i++)
-    {
-      notify();
-    }
+  m_jobAvailable.broadcast();
 }
 
 void WorkerPool::Add(Worker::Pointer worker)
 {
   Poco::Mutex::ScopedLock lock(m_mutexOne);
   m_threads.push_back(worker);
+  ++m_numThreads;
 }
 
 void WorkerPool::DecrementBusyThreads()
@@ -80,7 +77,9 @@ bool WorkerPool::Remove(Worker::Pointer worker)
   auto end = std::remove(m_threads.begin(),
       m_threads.end(), worker);
   bool removed = end != m_threads.end();
-  m_threads.erase(end);
+  m_threads.erase(end, m_threads.end());
+  if (removed)
+    --m_numThreads;
 
   return removed;
 }
@@ -94,63 +93,72 @@ void WorkerPool::EndWorker(Worker::Pointer sptr_worker)
 void WorkerPool::Sleep(long duration)
 {
   Poco::ScopedLock<Poco::Mutex> lock(m_mutexOne);
+  //a job was queued since our last look at the queue
+  if (m_pendingWakeUps > 0)
+  {
+    --m_pendingWakeUps;
+    return;
+  }
+
   m_sleepingThreads++;
+  m_searchingThreads--;
   m_busyThreads--;
 
-  try
-  {
-    wait(duration);
-    throw FinallyThrowException();
-  } catch (FinallyThrowException&)
-  {
-    m_sleepingThreads--;
-    m_busyThreads++;
-  } catch (...)
-  {
-    m_sleepingThreads--;
-    m_busyThreads++;
-  }
+  //releases the lock while waiting, so JobQueued() is never blocked by a sleeping worker
+  m_jobAvailable.tryWait(m_mutexOne, duration);
+
+  m_sleepingThreads--;
+  m_searchingThreads++;
+  m_busyThreads++;
+}
+
+long WorkerPool::GetSleepDuration(Poco::Timestamp::TimeDiff sleepHint)
+{
+  // clamp before rounding up; T_INFINITE + 999 would overflow
+  if (sleepHint >= Poco::Timestamp::TimeDiff(BEST_BEFORE) * 1000)
+    return BEST_BEFORE;
+  return long((sleepHint + 999) / 1000);
 }
 
 InternalJob::Pointer WorkerPool::StartJob(Worker* worker)
 {
-  // if we're above capacity, kill the thread
+  // the job manager must not be called while holding our lock, it calls JobQueued() under its own lock
+  if (!m_ptrManager->IsActive())
+  {
+    //  must remove the worker immediately to prevent all threads from expiring
+    Worker::Pointer sptr_worker(worker);
+    EndWorker(sptr_worker);
+    return InternalJob::Pointer(nullptr);
+  }
   {
     Poco::Mutex::ScopedLock lockOne(m_mutexOne);
-    if (!m_ptrManager->IsActive())
-    {
-      //  must remove the worker immediately to prevent all threads from expiring
-      Worker::Pointer sptr_worker(worker);
-      EndWorker(sptr_worker);
-      return InternalJob::Pointer(nullptr);
-    }
     //set the thread to be busy now in case of reentrant scheduling
     IncrementBusyThreads();
+    ++m_searchingThreads;
   }
   Job::Pointer ptr_job(nullptr);
   try
   {
     ptr_job = m_ptrManager->StartJob();
-    //spin until a job is found or until we have been idle for too long
+    //wait until a job is found or until we have been idle for too long
     Poco::Timestamp idleStart;
     while (m_ptrManager->IsActive() && ptr_job == 0)
     {
-      long tmpSleepTime = long(m_ptrManager->SleepHint());
-      if (tmpSleepTime > 0)
-        Sleep(std::min(tmpSleepTime, BEST_BEFORE));
+      //the hint is the time in microseconds until the next sleeping job is due
+      Poco::Timestamp::TimeDiff tmpSleepHint = m_ptrManager->SleepHint();
+      if (tmpSleepHint > 0)
+        Sleep(GetSleepDuration(tmpSleepHint));
       ptr_job = m_ptrManager->StartJob();
       //if we were already idle, and there are still no new jobs, then the thread can expire
+      if (ptr_job == 0 && idleStart.isElapsed(Poco::Timestamp::TimeDiff(BEST_BEFORE) * 1000))
       {
         Poco::Mutex::ScopedLock lockOne(m_mutexOne);
-        Poco::Timestamp tmpCurrentTime;
-        long long tmpTime = tmpCurrentTime - idleStart;
-        if (ptr_job == 0 && (tmpTime > BEST_BEFORE) && (m_numThreads
-            - m_busyThreads) > MIN_THREADS)
+        if ((m_numThreads - m_busyThreads) > MIN_THREADS)
         {
           //must remove the worker immediately to prevent all threads from expiring
           Worker::Pointer sptr_worker(worker);
           EndWorker(sptr_worker);
-          return InternalJob::Pointer(nullptr);
+          break;
         }
       }
     }
@@ -162,20 +170,23 @@ InternalJob::Pointer WorkerPool::StartJob(Worker* worker)
       // //that this thread waited to get this rule
       //  manager.getLockManager().addLockThread(Thread.currentThread(), job.getRule());
       //        }
-      //see if we need to wake another worker
-      if (m_ptrManager->SleepHint() <= 0)
-        JobQueued();
     }
-    throw FinallyThrowException();
-  } catch (FinallyThrowException&)
+  }
+  catch (...)
+  {
+    ptr_job = nullptr;
+  }
+
   {
+    Poco::Mutex::ScopedLock lockOne(m_mutexOne);
+    --m_searchingThreads;
     //decrement busy thread count if we're not running a job
     if (ptr_job == 0)
       DecrementBusyThreads();
-  } catch (...)
-  {
-    DecrementBusyThreads();
   }
+  //see if we need to wake another worker
+  if (ptr_job != 0 && m_ptrManager->SleepHint() <= 0)
+    JobQueued();
   return ptr_job;
 }
 
@@ -186,7 +197,13 @@ void WorkerPool::JobQueued()
   //if there is a sleeping thread, wake it up
   if (m_sleepingThreads > 0)
   {
-    notify();
+    m_jobAvailable.signal();
+    return;
+  }
+  //a searching thread will look at the queue again instead of going to sleep
+  if (m_searchingThreads > m_pendingWakeUps)
+  {
+    ++m_pendingWakeUps;
     return;
   }
   //create a thread if all threads are busy
@@ -27,7 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <Poco/ScopedLock.h>
 #include <Poco/Exception.h>
 #include <Poco/Mutex.h>
-#include <Poco/SynchronizedObject.h>
+#include <Poco/Condition.h>
 
 
 namespace berry
@@ -35,7 +35,16 @@ namespace berry
 
 struct JobManager;
 
-class BERRY_JOBS WorkerPool: public Object, public Poco::SynchronizedObject
+/**
+ * Maintains the pool of worker threads which run the jobs of the JobManager.
+ *
+ * Idle workers block on a condition variable until a job is queued or the
+ * next sleeping job is due; they never hold the pool lock while waiting.
+ * Workers are created on demand when all workers are busy and retire after
+ * being idle for BEST_BEFORE milliseconds, as long as more than MIN_THREADS
+ * workers are idle.
+ */
+class BERRY_JOBS WorkerPool: public Object
 {
 
   friend struct JobManager;
@@ -63,6 +72,13 @@ public:
    */
   InternalJob::Pointer StartJob(Worker* worker);
 
+  /**
+   * Returns how long (in milliseconds) an idle worker waits for a job, given the
+   * JobManager's sleep hint in microseconds. Rounds up, and waits at most
+   * BEST_BEFORE, also if no job is pending at all (InternalJob::T_INFINITE).
+   */
+  static long GetSleepDuration(Poco::Timestamp::TimeDiff sleepHint);
+
 protected:
 
 
@@ -91,10 +107,11 @@ private:
   bool Remove(Worker::Pointer worker);
 
   /**
-   * Sleep for the given duration or until woken.
+   * Sleep for the given duration (in milliseconds) or until woken.
    */
   void Sleep(long duration);
 
+  /** idle time in milliseconds after which a surplus worker retires */
   static const long BEST_BEFORE;
   /**
    * There will always be at least MIN_THREADS workers in the pool.
@@ -102,20 +119,20 @@ private:
   static const int MIN_THREADS;
 
   /**
-   * Mutex (mutual exclusion) is a synchronization mechanism used to control access to a shared resource in
-   * a concurrent (multithreaded) scenario.
+   * Guards all members below. Never held while calling into the JobManager.
    */
-
   Poco::Mutex m_mutexOne;
-  //
-  //   /**
-  //   * Records whether new worker threads should be daemon threads.
-  //   */
-  //
-  //  bool m_isDaemon;
-  //
+
+  /**
+   * Signalled when a job is queued or the pool shuts down.
+   */
+  Poco::Condition m_jobAvailable;
+
   JobManager* m_ptrManager;
-  //
+
+  /**
+   * The number of workers in m_threads
+   */
   int m_numThreads;
 
   /**
@@ -124,20 +141,27 @@ private:
   int m_sleepingThreads;
 
   /**
-   * The living set of workers in this pool.
+   * The number of threads that are looking for a job without sleeping
    */
-  std::vector<Worker::Pointer> m_threads;
+  int m_searchingThreads;
 
   /**
-   * The number of workers in the threads array
+   * Wake-ups which were signalled while no worker was sleeping but some
+   * were searching. The next worker going to sleep consumes one instead of
+   * waiting, so a job queued between a worker's unsuccessful
+   * JobManager::StartJob() and its Sleep() is not delayed.
    */
-  int m_busyThreads;
+  int m_pendingWakeUps;
 
   /**
-   * The default context class loader to use when creating worker threads.
+   * The living set of workers in this pool.
    */
+  std::vector<Worker::Pointer> m_threads;
 
-  // const ClassLoader defaultContextLoader;
+  /**
+   * The number of workers currently running or looking for a job
+   */
+  int m_busyThreads;
 
 };
 
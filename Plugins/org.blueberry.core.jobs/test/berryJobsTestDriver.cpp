@@ -0,0 +1,37 @@
+/*===================================================================
+
+BlueBerry Platform
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include <internal/berryJobManager.h>
+
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+
+#include <cstdlib>
+
+/**
+ * Runs the registered tests, or the test (suite) given as first argument.
+ * The job manager is used without a running platform.
+ */
+int main(int argc, char* argv[])
+{
+  CppUnit::TextUi::TestRunner runner;
+  runner.addTest(CppUnit::TestFactoryRegistry::getRegistry().makeTest());
+  const bool wasSuccessful = runner.run(argc > 1 ? argv[1] : "");
+
+  berry::JobManager::Shutdown();
+  return wasSuccessful ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,269 @@
+/*===================================================================
+
+BlueBerry Platform
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include <berryJob.h>
+#include <berryStatus.h>
+
+#include <internal/berryJobManager.h>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Event.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+  const int LATENCY_RUNS = 20;
+  const int THROUGHPUT_JOBS = 5000;
+  // time to let the workers go to sleep before a job is scheduled into the idle pool
+  const long IDLE_TIME = 50;
+  const long POLLING_SLEEP = 100;
+
+  /** Records when it ran and signals the run. */
+  struct Signal
+  {
+    Signal() : m_RunCounter(nullptr) {}
+
+    void Run()
+    {
+      m_RunTime.update();
+      if (m_RunCounter != nullptr)
+        ++(*m_RunCounter);
+      m_Done.set();
+    }
+
+    Poco::Event m_Done;
+    Poco::Timestamp m_RunTime;
+    Poco::AtomicCounter* m_RunCounter;
+  };
+
+  class SignalJob : public berry::Job
+  {
+  public:
+
+    berryObjectMacro(SignalJob);
+
+    SignalJob(Signal* signal)
+      : Job("SignalJob"), m_Signal(signal)
+    {
+    }
+
+    berry::IStatus::Pointer Run(berry::IProgressMonitor::Pointer /*monitor*/) override
+    {
+      m_Signal->Run();
+      return berry::Status::OK_STATUS(BERRY_STATUS_LOC);
+    }
+
+  private:
+
+    Signal* m_Signal;
+  };
+
+  /** Schedules the signals as jobs of the JobManager, i.e. runs them in the worker pool. */
+  class JobManagerScheduler
+  {
+  public:
+
+    void Schedule(Signal* signal)
+    {
+      m_Jobs.push_back(SignalJob::Pointer(new SignalJob(signal)));
+      m_Jobs.back()->Schedule();
+    }
+
+    void Clear()
+    {
+      m_Jobs.clear();
+    }
+
+  private:
+
+    std::vector<SignalJob::Pointer> m_Jobs;
+  };
+
+  /** Single worker that waits for jobs like the previous WorkerPool. */
+  class PollingPool : public Poco::Runnable
+  {
+  public:
+
+    PollingPool()
+      : m_Running(true)
+    {
+      m_Thread.start(*this);
+    }
+
+    ~PollingPool()
+    {
+      {
+        Poco::Mutex::ScopedLock lock(m_QueueMutex);
+        m_Running = false;
+      }
+      m_Thread.join();
+    }
+
+    /** previous WorkerPool::JobQueued() */
+    void Schedule(Signal* signal)
+    {
+      {
+        Poco::Mutex::ScopedLock lock(m_QueueMutex);
+        m_Queue.push_back(signal);
+      }
+      Poco::Mutex::ScopedLock lock(m_PoolMutex);
+      m_WakeUp.set();
+    }
+
+    void Clear()
+    {
+    }
+
+    void run() override
+    {
+      while (true)
+      {
+        Signal* signal = nullptr;
+        {
+          Poco::Mutex::ScopedLock lock(m_QueueMutex);
+          if (!m_Running && m_Queue.empty())
+            return;
+          if (!m_Queue.empty())
+          {
+            signal = m_Queue.front();
+            m_Queue.pop_front();
+          }
+        }
+
+        if (signal != nullptr)
+        {
+          signal->Run();
+        }
+        else
+        {
+          // previous WorkerPool::Sleep(): waits while holding the pool lock
+          Poco::Mutex::ScopedLock lock(m_PoolMutex);
+          m_WakeUp.tryWait(POLLING_SLEEP);
+        }
+      }
+    }
+
+  private:
+
+    Poco::Thread m_Thread;
+    Poco::Mutex m_PoolMutex;
+    Poco::Event m_WakeUp;
+    Poco::Mutex m_QueueMutex;
+    std::deque<Signal*> m_Queue;
+    bool m_Running;
+  };
+
+  struct BenchmarkResult
+  {
+    double MedianLatency; // milliseconds
+    double Throughput;    // jobs per second
+  };
+
+  template <typename Scheduler>
+  BenchmarkResult RunBenchmark(Scheduler& scheduler)
+  {
+    BenchmarkResult result;
+
+    std::vector<double> latencies;
+    for (int i = 0; i < LATENCY_RUNS; ++i)
+    {
+      Poco::Thread::sleep(IDLE_TIME);
+      Signal signal;
+      Poco::Timestamp scheduled;
+      scheduler.Schedule(&signal);
+      signal.m_Done.wait();
+      latencies.push_back((signal.m_RunTime - scheduled) / 1000.0);
+    }
+    scheduler.Clear();
+    std::sort(latencies.begin(), latencies.end());
+    result.MedianLatency = latencies[latencies.size() / 2];
+
+    Poco::AtomicCounter runCounter;
+    std::vector<Signal> signals(THROUGHPUT_JOBS);
+    Poco::Timestamp start;
+    for (auto& signal : signals)
+    {
+      signal.m_RunCounter = &runCounter;
+      scheduler.Schedule(&signal);
+    }
+    for (auto& signal : signals)
+    {
+      signal.m_Done.wait();
+    }
+    const Poco::Timestamp::TimeDiff elapsed = std::max<Poco::Timestamp::TimeDiff>(start.elapsed(), 1);
+    scheduler.Clear();
+    result.Throughput = runCounter.value() * 1000000.0 / elapsed;
+
+    return result;
+  }
+
+  void PrintResult(const char* name, const BenchmarkResult& result)
+  {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::setw(24) << std::fixed << std::setprecision(3) << result.MedianLatency
+              << std::setw(24) << std::setprecision(0) << result.Throughput << std::endl;
+  }
+}
+
+/**
+ * Compares the worker pool with the polling pool it replaced:
+ *  - wake-up latency: time from scheduling a job into an idle pool until it runs,
+ *  - throughput: number of short jobs run per second when they are scheduled at once.
+ *
+ * The previous pool could not be kept next to the current one, PollingPool reproduces
+ * its waiting scheme with a single worker: an idle worker slept while holding the pool
+ * lock, so JobQueued() could only wake it after the sleep timed out. The previous pool
+ * slept up to a minute, the reference only POLLING_SLEEP milliseconds, so its latency
+ * is a lower bound. The current pool is measured through the JobManager, including the
+ * overhead of job states and scheduling rules.
+ */
+int main(int /*argc*/, char* /*argv*/[])
+{
+  BenchmarkResult pollingResult;
+  {
+    PollingPool pollingPool;
+    pollingResult = RunBenchmark(pollingPool);
+  }
+
+  JobManagerScheduler jobManagerScheduler;
+  const BenchmarkResult result = RunBenchmark(jobManagerScheduler);
+  berry::JobManager::Shutdown();
+
+  std::cout << std::left << std::setw(16) << "pool"
+            << std::right << std::setw(24) << "wake-up latency [ms]"
+            << std::setw(24) << "throughput [jobs/s]" << std::endl;
+  PrintResult("polling", pollingResult);
+  PrintResult("WorkerPool", result);
+
+  // the throughput depends on the machine, only the wake-up must not regress
+  if (result.MedianLatency >= pollingResult.MedianLatency)
+  {
+    std::cout << "WorkerPool wakes up slower than the polling pool" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
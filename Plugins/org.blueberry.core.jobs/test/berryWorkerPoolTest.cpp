@@ -0,0 +1,169 @@
+/*===================================================================
+
+BlueBerry Platform
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include <berryJob.h>
+#include <berryStatus.h>
+
+#include <internal/berryInternalJob.h>
+#include <internal/berryWorkerPool.h>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Event.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+
+#include <vector>
+
+namespace berry
+{
+
+  namespace
+  {
+    // how long a test waits for a job before it fails; far below the idle time of a worker
+    const long JOB_TIMEOUT = 5000;
+
+    /** Records when it ran and signals every run. */
+    class SignalJob : public Job
+    {
+    public:
+
+      berryObjectMacro(SignalJob);
+
+      SignalJob(Poco::AtomicCounter* runCounter = nullptr)
+        : Job("SignalJob"), m_RunCounter(runCounter)
+      {
+      }
+
+      IStatus::Pointer Run(IProgressMonitor::Pointer /*monitor*/) override
+      {
+        m_RunTime.update();
+        if (m_RunCounter != nullptr)
+          ++(*m_RunCounter);
+        m_Done.set();
+        return Status::OK_STATUS(BERRY_STATUS_LOC);
+      }
+
+      Poco::Event m_Done;
+      Poco::Timestamp m_RunTime;
+
+    private:
+
+      Poco::AtomicCounter* m_RunCounter;
+    };
+  }
+
+  /**
+   * Tests how the worker pool puts idle workers to sleep and wakes them
+   * when jobs are scheduled.
+   */
+  class WorkerPoolTest : public CppUnit::TestFixture
+  {
+    CPPUNIT_TEST_SUITE(WorkerPoolTest);
+    CPPUNIT_TEST(TestSleepDuration);
+    CPPUNIT_TEST(TestWakeUpIdleWorker);
+    CPPUNIT_TEST(TestWakeUpForDelayedJob);
+    CPPUNIT_TEST(TestManyShortJobs);
+    CPPUNIT_TEST_SUITE_END();
+
+  public:
+
+    /**
+     * Checks the conversion of the job manager's sleep hint into a wait time,
+     * including the hint for "no job pending".
+     */
+    void TestSleepDuration();
+
+    /**
+     * Checks that a job scheduled while all workers wait is run immediately.
+     */
+    void TestWakeUpIdleWorker();
+
+    /**
+     * Checks that a delayed job is run when its delay has elapsed.
+     */
+    void TestWakeUpForDelayedJob();
+
+    /**
+     * Checks that no wake-up is lost when many short jobs are scheduled at once.
+     */
+    void TestManyShortJobs();
+  };
+
+  CPPUNIT_TEST_SUITE_REGISTRATION(WorkerPoolTest);
+
+  void WorkerPoolTest::TestSleepDuration()
+  {
+    const long bestBefore = WorkerPool::GetSleepDuration(InternalJob::T_INFINITE);
+    CPPUNIT_ASSERT(bestBefore > 0);
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(InternalJob::T_INFINITE - 1) == bestBefore);
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(Poco::Timestamp::TimeDiff(bestBefore) * 1000) == bestBefore);
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(Poco::Timestamp::TimeDiff(bestBefore) * 1000 - 1) == bestBefore);
+    // microseconds are rounded up to milliseconds, so a worker never wakes before the job is due
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(1) == 1);
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(1000) == 1);
+    CPPUNIT_ASSERT(WorkerPool::GetSleepDuration(1001) == 2);
+  }
+
+  void WorkerPoolTest::TestWakeUpIdleWorker()
+  {
+    // make sure a worker exists and is idle afterwards
+    SignalJob::Pointer firstJob(new SignalJob());
+    firstJob->Schedule();
+    CPPUNIT_ASSERT(firstJob->m_Done.tryWait(JOB_TIMEOUT));
+    Poco::Thread::sleep(200);
+
+    Poco::Timestamp scheduled;
+    SignalJob::Pointer job(new SignalJob());
+    job->Schedule();
+    CPPUNIT_ASSERT(job->m_Done.tryWait(JOB_TIMEOUT));
+    CPPUNIT_ASSERT(job->m_RunTime - scheduled < Poco::Timestamp::TimeDiff(JOB_TIMEOUT) * 1000);
+  }
+
+  void WorkerPoolTest::TestWakeUpForDelayedJob()
+  {
+    const long delay = 300;
+
+    Poco::Timestamp scheduled;
+    SignalJob::Pointer job(new SignalJob());
+    job->Schedule(delay);
+    CPPUNIT_ASSERT(!job->m_Done.tryWait(delay / 2));
+    CPPUNIT_ASSERT(job->m_Done.tryWait(JOB_TIMEOUT));
+    CPPUNIT_ASSERT(job->m_RunTime - scheduled >= Poco::Timestamp::TimeDiff(delay / 2) * 1000);
+  }
+
+  void WorkerPoolTest::TestManyShortJobs()
+  {
+    const int numberOfJobs = 200;
+
+    Poco::AtomicCounter runCounter;
+    std::vector<SignalJob::Pointer> jobs;
+    for (int i = 0; i < numberOfJobs; ++i)
+    {
+      jobs.push_back(SignalJob::Pointer(new SignalJob(&runCounter)));
+      jobs.back()->Schedule();
+    }
+    for (int i = 0; i < numberOfJobs; ++i)
+    {
+      CPPUNIT_ASSERT(jobs[i]->m_Done.tryWait(JOB_TIMEOUT));
+    }
+    CPPUNIT_ASSERT(runCounter.value() == numberOfJobs);
+  }
+
+}
@@ -308,6 +308,11 @@ void QmitkRigidRegistrationSelectorView::CalculateTransformation(unsigned int ti
 
     dynamic_cast<QmitkRigidRegistrationMetricsGUIBase*>(m_Controls.m_MetricWidgetStack->currentWidget())->SetMovingImage(dynamic_cast<mitk::Image*>(m_MovingNode->GetData()));
     registration->SetMetric(dynamic_cast<QmitkRigidRegistrationMetricsGUIBase*>(m_Controls.m_MetricWidgetStack->currentWidget())->GetMetric());
+    // the metric widgets have no sampling and threading settings, use the ones of the loaded preset as long as its metric is selected
+    if (m_MetricParameters.IsNotNull() && m_MetricParameters->GetMetric() == m_Controls.m_MetricBox->currentIndex())
+    {
+      registration->SetMetricParameters(m_MetricParameters);
+    }
 
     registration->SetOptimizer(dynamic_cast<QmitkRigidRegistrationOptimizerGUIBase*>(m_Controls.m_OptimizerWidgetStack->currentWidget())->GetOptimizer());
 
@@ -587,6 +592,9 @@ void QmitkRigidRegistrationSelectorView::DoLoadRigidRegistrationPreset(std::stri
     metricValuesForGUI[i-1] = metricValues[i];
   }
   dynamic_cast<QmitkRigidRegistrationMetricsGUIBase*>(m_Controls.m_MetricWidgetStack->currentWidget())->SetMetricParameters(metricValuesForGUI);
+  m_MetricParameters = mitk::MetricParameters::New();
+  m_MetricParameters->SetMetric((int)metricValues[0]);
+  m_MetricParameters->SetEvaluationParameters(metricValues);
 
   itk::Array<double> optimizerValues;
   optimizerValues = m_Preset->getOptimizerValues(presetName);
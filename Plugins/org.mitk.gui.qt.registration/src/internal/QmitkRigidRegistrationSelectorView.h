@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDataNode.h"
 #include "mitkDataStorage.h"
+#include "mitkMetricParameters.h"
 #include "ui_QmitkRigidRegistrationSelector.h"
 #include "qobject.h"
 #include <org_mitk_gui_qt_registration_Export.h>
@@ -98,6 +99,7 @@ protected:
   int m_MovingDimension;
   bool m_StopOptimization;
   mitk::RigidRegistrationPreset* m_Preset;
+  mitk::MetricParameters::Pointer m_MetricParameters; ///< sampling and threading settings of the loaded preset
   mitk::BaseGeometry::TransformType::Pointer m_GeometryItkPhysicalToWorldTransform;
   mitk::BaseGeometry::TransformType::Pointer m_GeometryWorldToItkPhysicalTransform;
   mitk::BaseGeometry* m_MovingGeometry;